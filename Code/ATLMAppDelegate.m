@@ -31,13 +31,19 @@
 #import "ATLMConstants.h"
 #import "ATLMAuthenticationProvider.h"
 #import "ATLMApplicationViewController.h"
+#import "ATLMConversationRollupIndex.h"
+#import "ATLMAccountManager.h"
+#import "ATLMPersistenceManager.h"
+#import "ATLMHangDetector.h"
 
 static NSString *const ATLMLayerAppID = nil;
 static NSString *const ATLMLayerApplicationIDUserDefaultsKey = @"com.layer.Atlas-Messenger.appID";
 
-@interface ATLMAppDelegate () <ATLMApplicationControllerDelegate, ATLMLayerControllerDelegate>
+@interface ATLMAppDelegate () <ATLMApplicationControllerDelegate, ATLMLayerControllerDelegate, ATLMAccountManagerDelegate>
 
 @property (nonnull, nonatomic) ATLMLayerController *layerController;
+@property (nullable, nonatomic) ATLMAccountManager *accountManager;
+@property (nullable, nonatomic) NSData *remoteNotificationDeviceToken;
 @property (nonnull, nonatomic) ATLMApplicationViewController *applicationViewController;
 
 @end
@@ -49,6 +55,7 @@ static NSString *const ATLMLayerApplicationIDUserDefaultsKey = @"com.layer.Atlas
 - (BOOL)application:(UIApplication *)application didFinishLaunchingWithOptions:(NSDictionary *)launchOptions
 {
     [SVProgressHUD setMinimumDismissTimeInterval:3.0f];
+    [self startHangDetector];
     
     // Create the view controller that will also be the root view controller of the app.
     self.applicationViewController = [ATLMApplicationViewController new];
@@ -60,10 +67,6 @@ static NSString *const ATLMLayerApplicationIDUserDefaultsKey = @"com.layer.Atlas
     if (appID) {
         [self initializeLayerWithAppID:appID];
     }
-    
-    // Push Notifications follow authentication state
-    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(registerForRemoteNotifications) name:LYRClientDidAuthenticateNotification object:nil];
-    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(unregisterForRemoteNotifications) name:LYRClientDidDeauthenticateNotification object:nil];
 
     // Put the view controller on screen.
     self.window = [UIWindow new];
@@ -73,20 +76,47 @@ static NSString *const ATLMLayerApplicationIDUserDefaultsKey = @"com.layer.Atlas
     return YES;
 }
 
+- (void)startHangDetector
+{
+    if (ATLMIsRunningTests()) {
+        return;
+    }
+    __weak typeof(self) weakSelf = self;
+    [ATLMHangDetector sharedDetector].activeControllerProvider = ^NSString *{
+        UIViewController *controller = weakSelf.window.rootViewController;
+        while (controller.presentedViewController) {
+            controller = controller.presentedViewController;
+        }
+        if ([controller isKindOfClass:[UINavigationController class]]) {
+            controller = [(UINavigationController *)controller topViewController];
+        }
+        return controller ? NSStringFromClass([controller class]) : nil;
+    };
+    [[ATLMHangDetector sharedDetector] start];
+}
+
 - (void)initializeLayerWithAppID:(nonnull NSURL *)appID
 {
     NSParameterAssert(appID);
-    ATLMAuthenticationProvider *authenticationProvider = [ATLMAuthenticationProvider providerWithBaseURL:ATLMRailsBaseURL(ATLMEnvironmentProduction) layerAppID:appID];
     
     // Configure the Layer Client options.
     LYRClientOptions *clientOptions = [LYRClientOptions new];
     clientOptions.synchronizationPolicy = LYRClientSynchronizationPolicyPartialHistory;
+    // Deeper history is synchronized per conversation by the layer controller's planner.
     clientOptions.partialHistoryMessageCount = 20;
     
-    // Create the application controller.
-    self.layerController = [ATLMLayerController applicationControllerWithLayerAppID:appID clientOptions:clientOptions authenticationProvider:authenticationProvider];
-    self.layerController.delegate = self;    
+    // Create the application controller of the last active account.
+    NSString *accountsPath = [ATLMApplicationDataDirectory() stringByAppendingPathComponent:@"Accounts.plist"];
+    self.accountManager = [ATLMAccountManager managerWithPersistencePath:accountsPath layerControllerFactory:^ATLMLayerController *(NSString *accountIdentifier) {
+        // Each account refreshes its identity token with the credentials it was registered with.
+        ATLMPersistenceManager *persistenceManager = accountIdentifier ? [ATLMPersistenceManager persistenceManagerWithDirectory:ATLMAccountDataDirectory(accountIdentifier)] : [ATLMPersistenceManager defaultManager];
+        ATLMAuthenticationProvider *authenticationProvider = [ATLMAuthenticationProvider providerWithBaseURL:ATLMRailsBaseURL(ATLMEnvironmentProduction) layerAppID:appID persistenceManager:persistenceManager];
+        return [ATLMLayerController applicationControllerWithLayerAppID:appID clientOptions:clientOptions authenticationProvider:authenticationProvider accountIdentifier:accountIdentifier];
+    }];
+    self.accountManager.delegate = self;
+    self.layerController = self.accountManager.activeLayerController;
     
+    self.applicationViewController.accountManager = self.accountManager;
     self.applicationViewController.layerController = self.layerController;
     
     // Persist the appID for subsequent launches
@@ -98,10 +128,39 @@ static NSString *const ATLMLayerApplicationIDUserDefaultsKey = @"com.layer.Atlas
     [self initializeLayerWithAppID:appID];
 }
 
+#pragma mark - ATLMAccountManagerDelegate
+
+- (void)accountManager:(nonnull ATLMAccountManager *)accountManager switchToLayerController:(nonnull ATLMLayerController *)layerController completion:(nonnull void (^)(void))completion
+{
+    self.layerController = layerController;
+    if (self.remoteNotificationDeviceToken && layerController.layerClient.authenticatedUser) {
+        // A client authenticated while another account was active never got the token.
+        [self.layerController updateRemoteNotificationDeviceToken:self.remoteNotificationDeviceToken];
+    }
+    [self.applicationViewController switchToLayerController:layerController completion:completion];
+}
+
+- (void)setLayerController:(ATLMLayerController *)layerController
+{
+    if (_layerController) {
+        _layerController.delegate = nil;
+        [[NSNotificationCenter defaultCenter] removeObserver:self name:LYRClientDidAuthenticateNotification object:_layerController.layerClient];
+        [[NSNotificationCenter defaultCenter] removeObserver:self name:LYRClientDidDeauthenticateNotification object:_layerController.layerClient];
+    }
+    _layerController = layerController;
+    if (layerController) {
+        layerController.delegate = self;
+        // Push Notifications follow the authentication state of the active account.
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(registerForRemoteNotifications) name:LYRClientDidAuthenticateNotification object:layerController.layerClient];
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(unregisterForRemoteNotifications) name:LYRClientDidDeauthenticateNotification object:layerController.layerClient];
+    }
+}
+
 - (void)applicationWillResignActive:(UIApplication *)application
 {
-    NSUInteger countOfUnreadMessages = [self.layerController countOfUnreadMessages];
-    [application setApplicationIconBadgeNumber:countOfUnreadMessages];
+    // Served from the rollups instead of counting unread messages in the store;
+    // like the count it replaces, it includes muted conversations.
+    [application setApplicationIconBadgeNumber:self.layerController.conversationRollupIndex.totalUnreadCount];
 }
 
 - (void)application:(UIApplication *)application didFailToRegisterForRemoteNotificationsWithError:(NSError *)error
@@ -111,12 +170,15 @@ static NSString *const ATLMLayerApplicationIDUserDefaultsKey = @"com.layer.Atlas
 
 - (void)application:(UIApplication *)application didRegisterForRemoteNotificationsWithDeviceToken:(NSData *)deviceToken
 {
+    self.remoteNotificationDeviceToken = deviceToken;
     [self.layerController updateRemoteNotificationDeviceToken:deviceToken];
 }
 
 - (void)application:(UIApplication *)application didReceiveRemoteNotification:(NSDictionary *)userInfo fetchCompletionHandler:(void (^)(UIBackgroundFetchResult))completionHandler
 {
-    [self.layerController handleRemoteNotification:userInfo responseInfo:nil completion:^(BOOL success, NSError * _Nullable error) {
+    // Inactive accounts keep their clients authenticated, so the push may be for one of them.
+    ATLMLayerController *layerController = [self.accountManager layerControllerForRemoteNotification:userInfo] ?: self.layerController;
+    [layerController handleRemoteNotification:userInfo responseInfo:nil completion:^(BOOL success, NSError * _Nullable error) {
         if (success) {
             completionHandler(UIBackgroundFetchResultNewData);
         } else {
@@ -132,7 +194,8 @@ static NSString *const ATLMLayerApplicationIDUserDefaultsKey = @"com.layer.Atlas
         // Bail out, if the action identifier is not meant for us.
         return;
     }
-    [self.layerController handleRemoteNotification:userInfo responseInfo:responseInfo completion:^(BOOL success, NSError * _Nullable error) {
+    ATLMLayerController *layerController = [self.accountManager layerControllerForRemoteNotification:userInfo] ?: self.layerController;
+    [layerController handleRemoteNotification:userInfo responseInfo:responseInfo completion:^(BOOL success, NSError * _Nullable error) {
         if (success) {
             completionHandler(UIBackgroundFetchResultNewData);
         } else {
@@ -166,6 +229,15 @@ static NSString *const ATLMLayerApplicationIDUserDefaultsKey = @"com.layer.Atlas
 
 #pragma mark - ATLMLayerControllerDelegate
 
+- (void)layerController:(ATLMLayerController *)applicationController didFinishHandlingRemoteNotificationForConversation:(LYRConversation *)conversation message:(LYRMessage *)message
+{
+    // Only the active account's conversations can be navigated to.
+    if (applicationController != self.layerController) {
+        return;
+    }
+    [self.applicationViewController layerController:applicationController didFinishHandlingRemoteNotificationForConversation:conversation message:message];
+}
+
 - (void)layerController:(ATLMLayerController *)applicationController didFailWithError:(NSError *)error
 {
     NSLog(@"Application controller=%@ has hit an error=%@", applicationController, error);
@@ -21,6 +21,8 @@
 #import <Foundation/Foundation.h>
 #import "ATLMAuthenticating.h"
 
+@class ATLMPersistenceManager;
+
 /*
  @abstract A key whose value should be the first name of an authenticating user.
  */
@@ -42,4 +44,11 @@ extern NSString * _Nonnull const ATLMLastNameKey;
  */
 + (nonnull instancetype)providerWithBaseURL:(nonnull NSURL *)baseURL layerAppID:(nonnull NSURL *)layerAppID;
 
+/**
+ @abstract Creates a provider keeping the credentials of the authenticated user in the persistence manager.
+ @param persistenceManager The persistence manager of the account; `providerWithBaseURL:layerAppID:`
+   uses the default manager.
+ */
++ (nonnull instancetype)providerWithBaseURL:(nonnull NSURL *)baseURL layerAppID:(nonnull NSURL *)layerAppID persistenceManager:(nonnull ATLMPersistenceManager *)persistenceManager;
+
 @end
@@ -22,6 +22,7 @@
 #import "ATLMAuthenticationProvider.h"
 #import "ATLMHTTPResponseSerializer.h"
 #import "ATLMConstants.h"
+#import "ATLMPersistenceManager.h"
 
 NSString *const ATLMFirstNameKey = @"ATLMFirstNameKey";
 NSString *const ATLMLastNameKey = @"ATLMLastNameKey";
@@ -33,21 +34,28 @@ static NSString *const ATLMAtlasIdentityTokenKey = @"identity_token";
 @property (nonatomic) NSURL *baseURL;
 @property (nonatomic) NSURLSession *URLSession;
 @property (nonatomic, copy) NSURL *layerAppID;
+@property (nonatomic) ATLMPersistenceManager *persistenceManager;
 @end
 
 @implementation ATLMAuthenticationProvider
 
 + (nonnull instancetype)providerWithBaseURL:(nonnull NSURL *)baseURL layerAppID:(NSURL *)layerAppID
 {
-    return  [[self alloc] initWithBaseURL:baseURL layerAppID:layerAppID];
+    return  [[self alloc] initWithBaseURL:baseURL layerAppID:layerAppID persistenceManager:[ATLMPersistenceManager defaultManager]];
 }
 
-- (id)initWithBaseURL:(nonnull NSURL *)baseURL layerAppID:(NSURL *)layerAppID;
++ (nonnull instancetype)providerWithBaseURL:(nonnull NSURL *)baseURL layerAppID:(nonnull NSURL *)layerAppID persistenceManager:(nonnull ATLMPersistenceManager *)persistenceManager
+{
+    return  [[self alloc] initWithBaseURL:baseURL layerAppID:layerAppID persistenceManager:persistenceManager];
+}
+
+- (id)initWithBaseURL:(nonnull NSURL *)baseURL layerAppID:(NSURL *)layerAppID persistenceManager:(ATLMPersistenceManager *)persistenceManager
 {
     self = [super init];
     if (self) {
         _baseURL = baseURL;
         _layerAppID = layerAppID;
+        _persistenceManager = persistenceManager;
                 
         NSURLSessionConfiguration *configuration = [NSURLSessionConfiguration ephemeralSessionConfiguration];
         configuration.HTTPAdditionalHeaders = @{ @"Accept": @"application/json",
@@ -87,13 +95,13 @@ static NSString *const ATLMAtlasIdentityTokenKey = @"identity_token";
         NSDictionary *userDetails;
         BOOL success = [ATLMHTTPResponseSerializer responseObject:&userDetails withData:data response:(NSHTTPURLResponse *)response error:&serializationError];
         if (success) {
+            NSString *identityToken = userDetails[ATLMAtlasIdentityTokenKey];
+            // Written behind by the persistence manager, off the session's delegate queue.
+            [self persistCredentials:credentials identityToken:identityToken];
             dispatch_async(dispatch_get_main_queue(), ^{
                 NSLog(@"User JSON: %@", userDetails);
-                NSString *identityToken = userDetails[ATLMAtlasIdentityTokenKey];
                 completion(identityToken, nil);
             });
-            [[NSUserDefaults standardUserDefaults] setValue:credentials forKey:ATLMCredentialsKey];
-            [[NSUserDefaults standardUserDefaults] synchronize];
         } else {
             dispatch_async(dispatch_get_main_queue(), ^{
                 completion(nil, serializationError);
@@ -104,10 +112,39 @@ static NSString *const ATLMAtlasIdentityTokenKey = @"identity_token";
 
 - (void)refreshAuthenticationWithNonce:(NSString *)nonce completion:(void (^)(NSString *identityToken, NSError *error))completion
 {
-    NSDictionary *credentails = [[NSUserDefaults standardUserDefaults] objectForKey:ATLMCredentialsKey];
+    NSDictionary *credentails = [self persistedCredentials];
     [self authenticateWithCredentials:credentails nonce:nonce completion:^(NSString * _Nonnull identityToken, NSError * _Nonnull error) {
         completion(identityToken, error);
     }];
 }
 
+#pragma mark - Credentials
+
+- (void)persistCredentials:(NSDictionary *)credentials identityToken:(NSString *)identityToken
+{
+    if (!identityToken) {
+        return;
+    }
+    ATLMUser *user = [ATLMUser new];
+    user.firstName = credentials[ATLMFirstNameKey];
+    user.lastName = credentials[ATLMLastNameKey];
+    NSError *error;
+    if (![self.persistenceManager persistSession:[ATLMSession sessionWithAuthenticationToken:identityToken user:user] error:&error]) {
+        NSLog(@"Failed to persist the session with error: %@", error);
+    }
+}
+
+- (NSDictionary *)persistedCredentials
+{
+    ATLMUser *user = [self.persistenceManager persistedSessionWithError:nil].user;
+    if (!user) {
+        // Sessions authenticated before the persistence manager kept their credentials in the user defaults.
+        return [[NSUserDefaults standardUserDefaults] objectForKey:ATLMCredentialsKey];
+    }
+    NSMutableDictionary *credentials = [NSMutableDictionary dictionaryWithCapacity:2];
+    credentials[ATLMFirstNameKey] = user.firstName;
+    credentials[ATLMLastNameKey] = user.lastName;
+    return credentials;
+}
+
 @end
@@ -0,0 +1,165 @@
+//
+//  ATLMAccountManager.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+@class ATLMAccountManager;
+@class ATLMLayerController;
+
+/**
+ @abstract The identifier of the account whose data lives where the
+   application kept it before it had accounts.
+ */
+extern NSString *_Nonnull const ATLMDefaultAccountIdentifier;
+
+/**
+ @abstract An account the application has been used with.
+ */
+@interface ATLMAccount : NSObject
+
+@property (nonnull, nonatomic, readonly) NSString *identifier;
+
+/**
+ @abstract The user ID the account was last authenticated as or `nil` if it never was.
+ */
+@property (nullable, nonatomic, readonly) NSString *userID;
+@property (nullable, nonatomic, readonly) NSString *displayName;
+@property (nonnull, nonatomic, readonly) NSDate *lastActiveDate;
+
+@end
+
+/**
+ @abstract The `ATLMAccountManagerDelegate` protocol is adopted by the object
+   owning the user interface, usually the application delegate.
+ */
+@protocol ATLMAccountManagerDelegate <NSObject>
+
+/**
+ @abstract Asks the receiver to rebuild the user interface around the layer controller of another account.
+ @param accountManager The `ATLMAccountManager` instance performing the invocation.
+ @param layerController The layer controller of the account switched to.
+ @param completion Must be called once the user interface shows the account; ends the timing of the switch.
+ */
+- (void)accountManager:(nonnull ATLMAccountManager *)accountManager switchToLayerController:(nonnull ATLMLayerController *)layerController completion:(nonnull void (^)(void))completion;
+
+@end
+
+/**
+ @abstract The `ATLMAccountManager` keeps the layer controllers of the most
+   recently used accounts alive, so switching between them doesn't require
+   logging out and synchronizing again.
+ @discussion Each account has a layer controller of its own, created by the
+   factory with the account identifier, which keeps its client and the
+   application's caches for it apart from the other accounts'. Up to
+   `capacity` controllers are kept authenticated and connected; switching to
+   one of them only hands it to the delegate to rebuild the interface. The
+   least recently used controller beyond `capacity` is released, and
+   switching back to it creates a new one, which restores its session from
+   the store.
+
+   The accounts are listed in a property list at the persistence path, along
+   with the user each was last authenticated as. All methods must be called
+   on the main thread.
+ */
+@interface ATLMAccountManager : NSObject
+
+/**
+ @abstract Creates an account manager.
+ @param path The path of the account list or `nil` to not persist it.
+ @param factory Creates the layer controller of an account; called with `nil`
+   for `ATLMDefaultAccountIdentifier`.
+ @return A new `ATLMAccountManager` instance.
+ */
++ (nonnull instancetype)managerWithPersistencePath:(nullable NSString *)path layerControllerFactory:(nonnull ATLMLayerController *_Nonnull (^)(NSString *_Nullable accountIdentifier))factory;
+
+@property (nullable, nonatomic, weak) id<ATLMAccountManagerDelegate> delegate;
+
+/**
+ @abstract The number of layer controllers kept alive, including the active one. Defaults to 3.
+ */
+@property (nonatomic) NSUInteger capacity;
+
+///-----------------
+/// @name Accounts
+///-----------------
+
+/**
+ @abstract The accounts, most recently active first.
+ */
+@property (nonnull, nonatomic, readonly) NSArray<ATLMAccount *> *accounts;
+
+@property (nonnull, nonatomic, readonly) ATLMAccount *activeAccount;
+
+/**
+ @abstract The layer controller of the active account, created on first access.
+ */
+@property (nonnull, nonatomic, readonly) ATLMLayerController *activeLayerController;
+
+/**
+ @abstract Returns `YES` if the layer controller of the account is alive.
+ */
+- (BOOL)hasWarmLayerControllerForAccount:(nonnull ATLMAccount *)account;
+
+/**
+ @abstract Returns the layer controller the push was sent to.
+ @discussion Warm clients stay authenticated and registered for pushes, so a
+   push may be for an inactive account. It's matched by the conversation it
+   references; pushes for conversations no warm client has yet go to the
+   active account.
+ */
+- (nonnull ATLMLayerController *)layerControllerForRemoteNotification:(nonnull NSDictionary *)userInfo;
+
+///------------------
+/// @name Switching
+///------------------
+
+/**
+ @abstract Makes the account active and asks the delegate to show it.
+ */
+- (void)switchToAccount:(nonnull ATLMAccount *)account;
+
+/**
+ @abstract Switches to a new account, listed once the switch starts; the
+   interface then asks for credentials.
+ */
+- (void)switchToNewAccount;
+
+@property (nonatomic, readonly, getter=isSwitching) BOOL switching;
+
+///--------------
+/// @name Metrics
+///--------------
+
+/**
+ @abstract The number of switches to an account whose layer controller was alive.
+ */
+@property (nonatomic, readonly) NSUInteger countOfWarmSwitches;
+
+/**
+ @abstract The number of switches which had to create a layer controller.
+ */
+@property (nonatomic, readonly) NSUInteger countOfColdSwitches;
+
+/**
+ @abstract The time from the start of the last switch to the delegate completing it.
+ */
+@property (nonatomic, readonly) NSTimeInterval lastSwitchDuration;
+
+@end
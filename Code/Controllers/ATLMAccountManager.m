@@ -0,0 +1,310 @@
+//
+//  ATLMAccountManager.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMAccountManager.h"
+#import <LayerKit/LayerKit.h>
+#import "ATLMLayerController.h"
+#import "ATLMInstrumentation.h"
+#import "ATLMRemoteNotificationCoalescer.h"
+
+NSString *const ATLMDefaultAccountIdentifier = @"default";
+
+static const NSUInteger ATLMAccountManagerDefaultCapacity = 3;
+static NSString *const ATLMAccountIdentifierKey = @"identifier";
+static NSString *const ATLMAccountUserIDKey = @"userID";
+static NSString *const ATLMAccountDisplayNameKey = @"displayName";
+static NSString *const ATLMAccountLastActiveDateKey = @"lastActiveDate";
+
+@interface ATLMAccount ()
+
+@property (nonnull, nonatomic, readwrite) NSString *identifier;
+@property (nullable, nonatomic, readwrite) NSString *userID;
+@property (nullable, nonatomic, readwrite) NSString *displayName;
+@property (nonnull, nonatomic, readwrite) NSDate *lastActiveDate;
+
+@end
+
+@implementation ATLMAccount
+
++ (instancetype)accountWithIdentifier:(NSString *)identifier
+{
+    ATLMAccount *account = [self new];
+    account.identifier = identifier;
+    account.lastActiveDate = [NSDate date];
+    return account;
+}
+
++ (instancetype)accountWithDictionary:(NSDictionary *)dictionary
+{
+    NSString *identifier = dictionary[ATLMAccountIdentifierKey];
+    if (![identifier isKindOfClass:[NSString class]]) {
+        return nil;
+    }
+    ATLMAccount *account = [self accountWithIdentifier:identifier];
+    account.userID = dictionary[ATLMAccountUserIDKey];
+    account.displayName = dictionary[ATLMAccountDisplayNameKey];
+    account.lastActiveDate = dictionary[ATLMAccountLastActiveDateKey] ?: [NSDate distantPast];
+    return account;
+}
+
+- (NSDictionary *)dictionaryRepresentation
+{
+    NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:4];
+    dictionary[ATLMAccountIdentifierKey] = self.identifier;
+    dictionary[ATLMAccountUserIDKey] = self.userID;
+    dictionary[ATLMAccountDisplayNameKey] = self.displayName;
+    dictionary[ATLMAccountLastActiveDateKey] = self.lastActiveDate;
+    return dictionary;
+}
+
+@end
+
+@interface ATLMAccountManager ()
+
+@property (nullable, nonatomic, copy) NSString *persistencePath;
+@property (nonnull, nonatomic, copy) ATLMLayerController *(^layerControllerFactory)(NSString *accountIdentifier);
+@property (nonnull, nonatomic) NSMutableArray<ATLMAccount *> *mutableAccounts;
+@property (nonnull, nonatomic) NSMutableDictionary<NSString *, ATLMLayerController *> *layerControllersByAccountIdentifier;
+@property (nonnull, nonatomic) NSMutableArray<NSString *> *warmAccountIdentifiers;  // Most recently used first.
+@property (nonatomic, readwrite, getter=isSwitching) BOOL switching;
+@property (nonatomic, readwrite) NSUInteger countOfWarmSwitches;
+@property (nonatomic, readwrite) NSUInteger countOfColdSwitches;
+@property (nonatomic, readwrite) NSTimeInterval lastSwitchDuration;
+
+@end
+
+@implementation ATLMAccountManager
+
++ (instancetype)managerWithPersistencePath:(NSString *)path layerControllerFactory:(ATLMLayerController *(^)(NSString *))factory
+{
+    return [[self alloc] initWithPersistencePath:path layerControllerFactory:factory];
+}
+
+- (id)initWithPersistencePath:(NSString *)path layerControllerFactory:(ATLMLayerController *(^)(NSString *))factory
+{
+    NSParameterAssert(factory);
+    self = [super init];
+    if (self) {
+        _persistencePath = [path copy];
+        _layerControllerFactory = [factory copy];
+        _capacity = ATLMAccountManagerDefaultCapacity;
+        _mutableAccounts = [NSMutableArray new];
+        _layerControllersByAccountIdentifier = [NSMutableDictionary new];
+        _warmAccountIdentifiers = [NSMutableArray new];
+        [self restoreAccounts];
+        if (_mutableAccounts.count == 0) {
+            [_mutableAccounts addObject:[ATLMAccount accountWithIdentifier:ATLMDefaultAccountIdentifier]];
+        }
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use managerWithPersistencePath:layerControllerFactory:" userInfo:nil];
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+#pragma mark - Accounts
+
+- (NSArray *)accounts
+{
+    return [self.mutableAccounts copy];
+}
+
+- (ATLMAccount *)activeAccount
+{
+    return self.mutableAccounts.firstObject;
+}
+
+- (ATLMLayerController *)activeLayerController
+{
+    return [self layerControllerForAccount:self.activeAccount created:NULL];
+}
+
+- (BOOL)hasWarmLayerControllerForAccount:(ATLMAccount *)account
+{
+    return self.layerControllersByAccountIdentifier[account.identifier] != nil;
+}
+
+- (void)setCapacity:(NSUInteger)capacity
+{
+    _capacity = MAX(capacity, 1);
+    [self releaseLayerControllersBeyondCapacity];
+}
+
+#pragma mark - Switching
+
+- (void)switchToAccount:(ATLMAccount *)account
+{
+    NSParameterAssert(account);
+    if (self.isSwitching || account == self.activeAccount) {
+        return;
+    }
+    self.switching = YES;
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    BOOL created = NO;
+    ATLMLayerController *layerController = [self layerControllerForAccount:account created:&created];
+    if (created) {
+        self.countOfColdSwitches += 1;
+    } else {
+        self.countOfWarmSwitches += 1;
+    }
+    account.lastActiveDate = [NSDate date];
+    [self.mutableAccounts removeObject:account];
+    [self.mutableAccounts insertObject:account atIndex:0];
+    [self persistAccounts];
+
+    __weak typeof(self) weakSelf = self;
+    void (^completion)(void) = ^{
+        weakSelf.lastSwitchDuration = CFAbsoluteTimeGetCurrent() - start;
+        ATLMInstrumentationRecordDuration(ATLMMetricAccountSwitch, weakSelf.lastSwitchDuration);
+        weakSelf.switching = NO;
+    };
+    if (self.delegate) {
+        [self.delegate accountManager:self switchToLayerController:layerController completion:completion];
+    } else {
+        completion();
+    }
+}
+
+- (void)switchToNewAccount
+{
+    if (self.isSwitching) {
+        return;
+    }
+    // The switch lists the account; it isn't persisted before.
+    [self switchToAccount:[ATLMAccount accountWithIdentifier:[NSUUID UUID].UUIDString]];
+}
+
+#pragma mark - Layer Controllers
+
+- (ATLMLayerController *)layerControllerForAccount:(ATLMAccount *)account created:(BOOL *)created
+{
+    ATLMLayerController *layerController = self.layerControllersByAccountIdentifier[account.identifier];
+    if (!layerController) {
+        NSString *accountIdentifier = [account.identifier isEqualToString:ATLMDefaultAccountIdentifier] ? nil : account.identifier;
+        layerController = self.layerControllerFactory(accountIdentifier);
+        self.layerControllersByAccountIdentifier[account.identifier] = layerController;
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(layerClientDidAuthenticate:) name:LYRClientDidAuthenticateNotification object:layerController.layerClient];
+        [self recordAuthenticatedUserOfLayerController:layerController forAccount:account];
+        if (created) {
+            *created = YES;
+        }
+    }
+    [self.warmAccountIdentifiers removeObject:account.identifier];
+    [self.warmAccountIdentifiers insertObject:account.identifier atIndex:0];
+    [self releaseLayerControllersBeyondCapacity];
+    return layerController;
+}
+
+- (void)releaseLayerControllersBeyondCapacity
+{
+    // The active account is the most recently used, so it's never released.
+    while (self.warmAccountIdentifiers.count > self.capacity) {
+        NSString *accountIdentifier = self.warmAccountIdentifiers.lastObject;
+        ATLMLayerController *layerController = self.layerControllersByAccountIdentifier[accountIdentifier];
+        [[NSNotificationCenter defaultCenter] removeObserver:self name:LYRClientDidAuthenticateNotification object:layerController.layerClient];
+        [self.layerControllersByAccountIdentifier removeObjectForKey:accountIdentifier];
+        [self.warmAccountIdentifiers removeLastObject];
+    }
+}
+
+- (ATLMLayerController *)layerControllerForRemoteNotification:(NSDictionary *)userInfo
+{
+    NSURL *conversationIdentifier = ATLMConversationIdentifierFromRemoteNotification(userInfo);
+    if (conversationIdentifier) {
+        for (NSString *accountIdentifier in self.warmAccountIdentifiers) {
+            ATLMLayerController *layerController = self.layerControllersByAccountIdentifier[accountIdentifier];
+            if (layerController.layerClient.authenticatedUser && [layerController existingConversationForIdentifier:conversationIdentifier]) {
+                return layerController;
+            }
+        }
+    }
+    return self.activeLayerController;
+}
+
+- (void)layerClientDidAuthenticate:(NSNotification *)notification
+{
+    [self.layerControllersByAccountIdentifier enumerateKeysAndObjectsUsingBlock:^(NSString *accountIdentifier, ATLMLayerController *layerController, BOOL *stop) {
+        if (layerController.layerClient != notification.object) {
+            return;
+        }
+        [self recordAuthenticatedUserOfLayerController:layerController forAccount:[self accountWithIdentifier:accountIdentifier]];
+        *stop = YES;
+    }];
+}
+
+- (void)recordAuthenticatedUserOfLayerController:(ATLMLayerController *)layerController forAccount:(ATLMAccount *)account
+{
+    LYRIdentity *authenticatedUser = layerController.layerClient.authenticatedUser;
+    if (!account || !authenticatedUser) {
+        return;
+    }
+    if ([account.userID isEqualToString:authenticatedUser.userID] && [account.displayName isEqualToString:authenticatedUser.displayName]) {
+        return;
+    }
+    account.userID = authenticatedUser.userID;
+    account.displayName = authenticatedUser.displayName;
+    [self persistAccounts];
+}
+
+- (ATLMAccount *)accountWithIdentifier:(NSString *)identifier
+{
+    for (ATLMAccount *account in self.mutableAccounts) {
+        if ([account.identifier isEqualToString:identifier]) {
+            return account;
+        }
+    }
+    return nil;
+}
+
+#pragma mark - Persistence
+
+- (void)restoreAccounts
+{
+    if (!self.persistencePath) {
+        return;
+    }
+    NSArray *dictionaries = [NSArray arrayWithContentsOfFile:self.persistencePath];
+    for (NSDictionary *dictionary in dictionaries) {
+        ATLMAccount *account = [ATLMAccount accountWithDictionary:dictionary];
+        if (account) {
+            [self.mutableAccounts addObject:account];
+        }
+    }
+}
+
+- (void)persistAccounts
+{
+    if (!self.persistencePath) {
+        return;
+    }
+    NSArray *dictionaries = [self.mutableAccounts valueForKey:@"dictionaryRepresentation"];
+    if (![dictionaries writeToFile:self.persistencePath atomically:YES]) {
+        NSLog(@"Failed to persist the accounts to %@", self.persistencePath);
+    }
+}
+
+@end
@@ -10,6 +10,8 @@
 #import "ATLMLayerController.h"
 
 @class ATLMApplicationViewController;
+@class ATLMConnectionManager;
+@class ATLMAccountManager;
 
 @protocol ATLMApplicationControllerDelegate <NSObject>
 
@@ -40,4 +42,22 @@
  */
 @property (nonnull, nonatomic) ATLMLayerController *layerController;
 
+/**
+ @abstract Keeps the layer controller's client connected and measures its connections.
+ */
+@property (nullable, nonatomic, readonly) ATLMConnectionManager *connectionManager;
+
+/**
+ @abstract The accounts the user can switch between from the settings.
+ */
+@property (nullable, nonatomic) ATLMAccountManager *accountManager;
+
+/**
+ @abstract Tears down the interface of the current layer controller and
+   presents the one for the state of the supplied controller.
+ @param layerController The layer controller of the account switched to.
+ @param completion A block called once the interface has been rebuilt.
+ */
+- (void)switchToLayerController:(nonnull ATLMLayerController *)layerController completion:(nullable void (^)(void))completion;
+
 @end
@@ -14,6 +14,8 @@
 #import "ATLMConversationViewController.h"
 #import "ATLMUtilities.h"
 #import "ATLMNavigationController.h"
+#import "ATLMConnectionManager.h"
+#import "ATLMAccountManager.h"
 
 ///-------------------------
 /// @name Application States
@@ -41,16 +43,16 @@ typedef NS_ENUM(NSUInteger, ATLMApplicationState) {
     ATLMApplicationStateAuthenticated           = 3
 };
 
-static NSString *const ATLMPushNotificationSoundName = @"layerbell.caf";
 static void *ATLMApplicationViewControllerObservationContext = &ATLMApplicationViewControllerObservationContext;
 
-@interface ATLMApplicationViewController () <ATLMQRScannerControllerDelegate, ATLMRegistrationViewControllerDelegate, ATLMConversationListViewControllerPresentationDelegate>
+@interface ATLMApplicationViewController () <ATLMQRScannerControllerDelegate, ATLMRegistrationViewControllerDelegate, ATLMConversationListViewControllerPresentationDelegate, ATLMConnectionManagerDelegate>
 
 @property (assign, nonatomic, readwrite) ATLMApplicationState state;
 @property (nullable, nonatomic) ATLMSplashView *splashView;
 @property (nullable, nonatomic) ATLMQRScannerController *QRCodeScannerController;
-@property (nullable, nonatomic) UINavigationController *registrationNavigationController;
+@property (nullable, nonatomic) ATLMNavigationController *registrationNavigationController;
 @property (nullable, nonatomic) ATLMConversationListViewController *conversationListViewController;
+@property (nullable, nonatomic, readwrite) ATLMConnectionManager *connectionManager;
 
 @end
 
@@ -136,7 +138,7 @@ static void *ATLMApplicationViewControllerObservationContext = &ATLMApplicationV
 - (void)presentRegistrationNavigationController
 {
     if (!self.registrationNavigationController) {
-        self.registrationNavigationController = [[UINavigationController alloc] init];
+        self.registrationNavigationController = [[ATLMNavigationController alloc] init];
         self.registrationNavigationController.navigationBarHidden = YES;
         if (!self.childViewControllers.count) {
             // Only if there's no child view controller being presented on top.
@@ -173,7 +175,9 @@ static void *ATLMApplicationViewControllerObservationContext = &ATLMApplicationV
     
     self.conversationListViewController = [ATLMConversationListViewController conversationListViewControllerWithLayerController:self.layerController];
     self.conversationListViewController.presentationDelegate = self;
-    UINavigationController *navigationController = [[UINavigationController alloc] initWithRootViewController:self.conversationListViewController];
+    self.conversationListViewController.accountManager = self.accountManager;
+    // Defers scheduled UI work while conversations are pushed and popped.
+    ATLMNavigationController *navigationController = [[ATLMNavigationController alloc] initWithRootViewController:self.conversationListViewController];
     [self presentViewController:navigationController animated:YES completion:nil];
 }
 
@@ -243,28 +247,8 @@ static void *ATLMApplicationViewControllerObservationContext = &ATLMApplicationV
 
 #pragma mark - ATLMLayerControllerDelegate implementation
 
-- (void)applicationController:(ATLMLayerController *)applicationController didFinishHandlingRemoteNotificationForConversation:(LYRConversation *)conversation message:(LYRMessage *)message responseText:(nullable NSString *)responseText
+- (void)layerController:(ATLMLayerController *)applicationController didFinishHandlingRemoteNotificationForConversation:(LYRConversation *)conversation message:(LYRMessage *)message
 {
-    if (responseText.length) {
-        // Handle the inline message reply.
-        if (!conversation) {
-            NSLog(@"Failed to complete inline reply: unable to find Conversation referenced by remote notification.");
-            return;
-        }
-        LYRMessagePart *messagePart = [LYRMessagePart messagePartWithText:responseText];
-        NSString *fullName = self.layerController.layerClient.authenticatedUser.displayName;
-        NSString *pushText = [NSString stringWithFormat:@"%@: %@", fullName, responseText];
-        LYRMessage *message = ATLMessageForParts(self.layerController.layerClient, @[ messagePart ], pushText, ATLMPushNotificationSoundName);
-        if (message) {
-            NSError *error = nil;
-            BOOL success = [conversation sendMessage:message error:&error];
-            if (!success) {
-                NSLog(@"Failed to send inline reply: %@", [error localizedDescription]);
-            }
-        }
-        return;
-    }
-    
     // Navigate to the conversation, after the remote notification's been handled.
     BOOL userTappedRemoteNotification = [UIApplication sharedApplication].applicationState == UIApplicationStateInactive;
     if (userTappedRemoteNotification && conversation) {
@@ -280,23 +264,19 @@ static void *ATLMApplicationViewControllerObservationContext = &ATLMApplicationV
         return;
     }
     
+    if (_layerController) {
+        [[NSNotificationCenter defaultCenter] removeObserver:self name:LYRClientDidAuthenticateNotification object:_layerController.layerClient];
+        [[NSNotificationCenter defaultCenter] removeObserver:self name:LYRClientDidDeauthenticateNotification object:_layerController.layerClient];
+    }
     _layerController = layerController;
     if (layerController) {
-        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(handleLayerClientWillAttemptToConnectNotification:) name:LYRClientWillAttemptToConnectNotification object:layerController.layerClient];
-        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(handleLayerClientDidConnectNotification:) name:LYRClientDidConnectNotification object:layerController.layerClient];
-        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(handleLayerClientDidDisconnectNotification:) name:LYRClientDidDisconnectNotification object:layerController.layerClient];
-        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(handleLayerClientDidLoseConnectionNotification:) name:LYRClientDidLoseConnectionNotification object:layerController.layerClient];
         [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(handleLayerClientDidAuthenticateNotification:) name:LYRClientDidAuthenticateNotification object:layerController.layerClient];
         [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(handleLayerClientDidDeauthenticateNotification:) name:LYRClientDidDeauthenticateNotification object:layerController.layerClient];
         
         // Connect the client
-        [layerController.layerClient connectWithCompletion:^(BOOL success, NSError * _Nullable error) {
-            if (success) {
-                NSLog(@"Connected to Layer");
-            } else {
-                NSLog(@"Failed connection to Layer: %@", error);
-            }
-        }];
+        self.connectionManager = [ATLMConnectionManager managerWithClient:layerController.layerClient];
+        self.connectionManager.delegate = self;
+        [self.connectionManager connect];
         
         if (self.state != ATLMApplicationStateIndeterminate) {
             self.state = [self determineInitialApplicationState];
@@ -304,36 +284,43 @@ static void *ATLMApplicationViewControllerObservationContext = &ATLMApplicationV
     }
 }
 
-- (void)handleLayerClientWillAttemptToConnectNotification:(NSNotification *)notification
+- (void)switchToLayerController:(ATLMLayerController *)layerController completion:(void (^)(void))completion
 {
-    unsigned long attemptNumber = [notification.userInfo[@"attemptNumber"] unsignedLongValue];
-    unsigned long attemptLimit = [notification.userInfo[@"attemptLimit"] unsignedLongValue];
-    NSTimeInterval delayInterval = [notification.userInfo[@"delayInterval"] floatValue];
-    // Show HUD with message
-    if (attemptNumber == 1) {
-        [SVProgressHUD showWithStatus:@"Connecting to Layer"];
+    void (^rebuildInterface)(void) = ^{
+        self.conversationListViewController = nil;
+        self.registrationNavigationController = nil;
+        // Setting the controller presents the interface for its state.
+        self.layerController = layerController;
+        if (completion) {
+            completion();
+        }
+    };
+    if (self.presentedViewController) {
+        [self dismissViewControllerAnimated:NO completion:rebuildInterface];
     } else {
-        [SVProgressHUD showWithStatus:[NSString stringWithFormat:@"Connecting to Layer in %lus (%lu of %lu)", (unsigned long)ceil(delayInterval), attemptNumber, attemptLimit]];
+        rebuildInterface();
     }
 }
 
-- (void)handleLayerClientDidConnectNotification:(NSNotification *)notification
-{
-    // Show HUD with message
-    [SVProgressHUD showSuccessWithStatus:@"Connected to Layer"];
-}
+#pragma mark - ATLMConnectionManagerDelegate
 
-- (void)handleLayerClientDidDisconnectNotification:(NSNotification *)notification
+- (void)connectionManager:(ATLMConnectionManager *)connectionManager didChangePresentedStatus:(ATLMConnectionStatus)status
 {
     // Show HUD with message
-    [SVProgressHUD showWithStatus:@"Disconnected from Layer"];
+    switch (status) {
+        case ATLMConnectionStatusConnecting:
+            [SVProgressHUD showWithStatus:@"Connecting to Layer"];
+            break;
+        case ATLMConnectionStatusDisconnected:
+            [SVProgressHUD showErrorWithStatus:@"Lost connection from Layer"];
+            break;
+        case ATLMConnectionStatusConnected:
+            [SVProgressHUD showSuccessWithStatus:@"Connected to Layer"];
+            break;
+    }
 }
 
-- (void)handleLayerClientDidLoseConnectionNotification:(NSNotification *)notification
-{
-    // Show HUD with message
-    [SVProgressHUD showErrorWithStatus:@"Lost connection from Layer"];
-}
+#pragma mark - Authentication Notification Handlers
 
 - (void)handleLayerClientDidAuthenticateNotification:(NSNotification *)notification
 {
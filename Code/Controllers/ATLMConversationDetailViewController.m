@@ -25,6 +25,9 @@
 #import <SVProgressHUD/SVProgressHUD.h>
 #import "ATLMParticipantTableViewController.h"
 #import "LYRIdentity+ATLParticipant.h"
+#import "ATLMCollectionDiff.h"
+#import "ATLMConversationEventBus.h"
+#import "ATLMHangDetector.h"
 
 typedef NS_ENUM(NSInteger, ATLMConversationDetailTableSection) {
     ATLMConversationDetailTableSectionMetadata,
@@ -45,6 +48,7 @@ typedef NS_ENUM(NSInteger, ATLMActionSheetTag) {
 @property (nonatomic) NSMutableArray *participants;
 @property (nonatomic) NSIndexPath *indexPathToRemove;
 @property (nonatomic) CLLocationManager *locationManager;
+@property (nonatomic) NSArray *conversationEventSubscriptions;
 
 @end
 
@@ -99,7 +103,7 @@ static NSString *const ATLMBlockIconName = @"AtlasResource.bundle/block";
     self.participants = [self filteredParticipants];
     
     [self configureAppearance];
-    [self registerNotificationObservers];
+    [self subscribeToConversationEvents];
 }
 
 - (void)dealloc
@@ -107,6 +111,16 @@ static NSString *const ATLMBlockIconName = @"AtlasResource.bundle/block";
     [[NSNotificationCenter defaultCenter] removeObserver:self];
 }
 
+#pragma mark - Accessors
+
+- (void)setConversation:(LYRConversation *)conversation
+{
+    _conversation = conversation;
+    if (self.isViewLoaded) {
+        [self subscribeToConversationEvents];
+    }
+}
+
 #pragma mark - UITableViewDataSource
 
 - (NSInteger)numberOfSectionsInTableView:(UITableView *)tableView
@@ -315,7 +329,9 @@ static NSString *const ATLMBlockIconName = @"AtlasResource.bundle/block";
     LYRQuery *query = [LYRQuery queryWithQueryableClass:[LYRIdentity class]];
     query.predicate = [LYRPredicate predicateWithProperty:@"userID" predicateOperator:LYRPredicateOperatorIsNotIn value:[self.conversation.participants valueForKey:@"userID"]];
     NSError *error;
+    [[ATLMHangDetector sharedDetector] beginOperation:@"participants.picker"];
     NSOrderedSet *identities = [self.layerController.layerClient executeQuery:query error:&error];
+    [[ATLMHangDetector sharedDetector] endOperation:@"participants.picker"];
     
     ATLMParticipantTableViewController  *controller = [ATLMParticipantTableViewController participantTableViewControllerWithParticipants:identities.set sortType:ATLParticipantPickerSortTypeFirstName];
     controller.delegate = self;
@@ -341,34 +357,22 @@ static NSString *const ATLMBlockIconName = @"AtlasResource.bundle/block";
 - (void)blockParticipantAtIndexPath:(NSIndexPath *)indexPath
 {
     id<ATLParticipant>participant = [self.participants objectAtIndex:indexPath.row];
-    LYRPolicy *policy =  [self blockedParticipantAtIndexPath:indexPath];
-    if (policy) {
-        NSError *error;
-        [self.layerController.layerClient removePolicies:[NSSet setWithObject:policy] error:&error];
-        if (error) {
+    NSError *error;
+    if ([self.layerController isUserBlocked:[participant userID]]) {
+        if (![self.layerController unblockUserWithID:[participant userID] error:&error]) {
             ATLMAlertWithError(error);
             return;
         }
     } else {
-        [self blockParticipantWithIdentifier:[participant userID]];
+        if (![self.layerController blockUserWithID:[participant userID] error:&error]) {
+            ATLMAlertWithError(error);
+            return;
+        }
+        [SVProgressHUD showSuccessWithStatus:@"Participant Blocked"];
     }
     [self.tableView reloadRowsAtIndexPaths:@[indexPath] withRowAnimation:UITableViewRowAnimationAutomatic];
 }
 
-- (void)blockParticipantWithIdentifier:(NSString *)identitifer
-{
-    LYRPolicy *blockPolicy = [LYRPolicy policyWithType:LYRPolicyTypeBlock];
-    blockPolicy.sentByUserID = identitifer;
-    
-    NSError *error;
-    [self.layerController.layerClient addPolicies:[NSSet setWithObject:blockPolicy] error:&error];
-    if (error) {
-        ATLMAlertWithError(error);
-        return;
-    }
-    [SVProgressHUD showSuccessWithStatus:@"Participant Blocked"];
-}
-
 - (void)shareLocation
 {
     [self.detailDelegate conversationDetailViewControllerDidSelectShareLocation:self];
@@ -412,14 +416,13 @@ static NSString *const ATLMBlockIconName = @"AtlasResource.bundle/block";
 {
     [self.navigationController dismissViewControllerAnimated:YES completion:nil];
     
-    [self.participants addObject:participant];
     NSError *error;
     BOOL success = [self.conversation addParticipants:[NSSet setWithObject:participant.userID] error:&error];
     if (!success) {
         ATLMAlertWithError(error);
         return;
     }
-    [self.tableView reloadData];
+    [self reloadParticipants];
 }
 
 - (void)participantTableViewController:(ATLParticipantTableViewController *)participantTableViewController didSearchWithString:(NSString *)searchText completion:(void (^)(NSSet *))completion
@@ -450,15 +453,8 @@ static NSString *const ATLMBlockIconName = @"AtlasResource.bundle/block";
 
 - (LYRPolicy *)blockedParticipantAtIndexPath:(NSIndexPath *)indexPath
 {
-    NSOrderedSet *policies = self.layerController.layerClient.policies;
     id<ATLParticipant>participant = self.participants[indexPath.row];
-    NSPredicate *policyPredicate = [NSPredicate predicateWithFormat:@"SELF.sentByUserID = %@", [participant userID]];
-    NSOrderedSet *filteredPolicies = [policies filteredOrderedSetUsingPredicate:policyPredicate];
-    if (filteredPolicies.count) {
-        return filteredPolicies.firstObject;
-    } else {
-        return nil;
-    }
+    return [self.layerController blockPolicyForUserID:[participant userID]];
 }
 
 #pragma mark - UITextFieldDelegate
@@ -484,12 +480,8 @@ static NSString *const ATLMBlockIconName = @"AtlasResource.bundle/block";
 
 #pragma mark - Notification Handlers
 
-- (void)conversationMetadataDidChange:(NSNotification *)notification
+- (void)conversationMetadataDidChange
 {
-    if (!self.conversation) return;
-    if (!notification.object) return;
-    if (![notification.object isEqual:self.conversation]) return;
-    
     NSIndexPath *nameIndexPath = [NSIndexPath indexPathForRow:0 inSection:ATLMConversationDetailTableSectionMetadata];
     ATLMInputTableViewCell *nameCell = (ATLMInputTableViewCell *)[self.tableView cellForRowAtIndexPath:nameIndexPath];
     if (!nameCell) return;
@@ -498,51 +490,36 @@ static NSString *const ATLMBlockIconName = @"AtlasResource.bundle/block";
     [self configureConversationNameCell:nameCell];
 }
 
-- (void)conversationParticipantsDidChange:(NSNotification *)notification
-{
-    if (!self.conversation) return;
-    if (!notification.object) return;
-    if (![notification.object isEqual:self.conversation]) return;
-    
-    [self.tableView beginUpdates];
-    
-    NSSet *existingParticipants = [NSSet setWithArray:self.participants];
-    
-    NSMutableArray *deletedIndexPaths = [NSMutableArray new];
-    NSMutableIndexSet *deletedIndexSet = [NSMutableIndexSet new];
-    NSMutableSet *deletedParticipants = [existingParticipants mutableCopy];
-    [deletedParticipants minusSet:self.conversation.participants];
-    for (LYRIdentity *deletedIdentity in deletedParticipants) {
-        NSUInteger row = [self.participants indexOfObject:deletedIdentity];
-        [deletedIndexSet addIndex:row];
-        NSIndexPath *indexPath = [NSIndexPath indexPathForRow:row inSection:ATLMConversationDetailTableSectionParticipants];
-        [deletedIndexPaths addObject:indexPath];
-    }
-    [self.participants removeObjectsAtIndexes:deletedIndexSet];
-    [self.tableView deleteRowsAtIndexPaths:deletedIndexPaths withRowAnimation:UITableViewRowAnimationAutomatic];
-    
-    NSMutableArray *insertedIndexPaths = [NSMutableArray new];
-    NSMutableSet *insertedParticipants = [self.conversation.participants mutableCopy];
-    [insertedParticipants removeObject:self.layerController.layerClient.authenticatedUser];
-    [insertedParticipants minusSet:existingParticipants];
-    for (LYRIdentity *identity in insertedParticipants) {
-        [self.participants addObject:identity];
-        NSIndexPath *indexPath = [NSIndexPath indexPathForRow:self.participants.count - 1 inSection:ATLMConversationDetailTableSectionParticipants];
-        [insertedIndexPaths addObject:indexPath];
-    }
-    [self.tableView insertRowsAtIndexPaths:insertedIndexPaths withRowAnimation:UITableViewRowAnimationAutomatic];
-    [self.tableView endUpdates];
-}
-
 #pragma mark - Helpers
 
 - (NSMutableArray *)filteredParticipants
 {
-    NSMutableArray *participants = [[self.conversation.participants allObjects] mutableCopy];
-    [participants removeObject:self.layerController.layerClient.authenticatedUser];
+    NSSet *conversationParticipants = self.conversation.participants;
+    LYRIdentity *authenticatedUser = self.layerController.layerClient.authenticatedUser;
+    NSMutableArray *participants = [NSMutableArray arrayWithCapacity:conversationParticipants.count];
+    for (LYRIdentity *identity in conversationParticipants) {
+        if (![identity isEqual:authenticatedUser]) {
+            [participants addObject:identity];
+        }
+    }
+    // A stable order keeps the diffs between participant changes minimal.
+    [participants sortUsingComparator:^NSComparisonResult(LYRIdentity *identity, LYRIdentity *otherIdentity) {
+        NSComparisonResult result = [identity.displayName ?: @"" localizedCaseInsensitiveCompare:otherIdentity.displayName ?: @""];
+        return result != NSOrderedSame ? result : [identity.userID compare:otherIdentity.userID];
+    }];
     return participants;
 }
 
+- (void)reloadParticipants
+{
+    NSMutableArray *participants = [self filteredParticipants];
+    ATLMCollectionDiff *diff = [ATLMCollectionDiff diffFromObjects:self.participants toObjects:participants keyBlock:^id<NSCopying>(LYRIdentity *identity) {
+        return identity.userID;
+    }];
+    self.participants = participants;
+    [diff applyToTableView:self.tableView section:ATLMConversationDetailTableSectionParticipants withRowAnimation:UITableViewRowAnimationAutomatic];
+}
+
 - (void)configureAppearance
 {
     [[ATLParticipantTableViewCell appearanceWhenContainedIn:[self class], nil] setTitleColor:[UIColor blackColor]];
@@ -551,10 +528,23 @@ static NSString *const ATLMBlockIconName = @"AtlasResource.bundle/block";
     [[ATLAvatarImageView appearanceWhenContainedIn:[ATLParticipantTableViewCell class], nil] setAvatarImageViewDiameter:32];
 }
 
-- (void)registerNotificationObservers
+- (void)subscribeToConversationEvents
 {
-    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(conversationMetadataDidChange:) name:ATLMConversationMetadataDidChangeNotification object:nil];
-    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(conversationParticipantsDidChange:) name:ATLMConversationParticipantsDidChangeNotification object:nil];
+    ATLMConversationEventBus *bus = self.layerController.conversationEventBus;
+    for (id subscription in self.conversationEventSubscriptions) {
+        [bus unsubscribe:subscription];
+    }
+    self.conversationEventSubscriptions = nil;
+    NSURL *conversationIdentifier = self.conversation.identifier;
+    if (!conversationIdentifier) return;
+    
+    id metadataSubscription = [bus subscribeObserver:self toEventKind:ATLMConversationEventKindMetadataDidChange conversationIdentifier:conversationIdentifier queue:nil handler:^(ATLMConversationDetailViewController *viewController, ATLMConversationEvent *event) {
+        [viewController conversationMetadataDidChange];
+    }];
+    id participantsSubscription = [bus subscribeObserver:self toEventKind:ATLMConversationEventKindParticipantsDidChange conversationIdentifier:conversationIdentifier queue:nil handler:^(ATLMConversationDetailViewController *viewController, ATLMConversationEvent *event) {
+        [viewController reloadParticipants];
+    }];
+    self.conversationEventSubscriptions = @[ metadataSubscription, participantsSubscription ];
 }
 
 @end
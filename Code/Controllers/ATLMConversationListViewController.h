@@ -24,6 +24,8 @@
 
 NS_ASSUME_NONNULL_BEGIN
 @class ATLConversationListViewController;
+@class ATLMAccountManager;
+@class ATLMAvatarImagePipeline;
 
 /**
  @abstract The delegate is notified when the `ATLMConversationListViewController`
@@ -60,6 +62,17 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic) ATLMLayerController *layerController;
 
+/**
+ @abstract The accounts offered when the user taps "Switch Account" in the settings.
+ */
+@property (nullable, nonatomic) ATLMAccountManager *accountManager;
+
+/**
+ @abstract The pipeline the avatars of the conversations are fetched through.
+   Defaults to the shared pipeline.
+ */
+@property (nonatomic) ATLMAvatarImagePipeline *avatarImagePipeline;
+
 /**
  @abstract Determines if the view controller should display an `Info` item as
    the left bar button item of the navigation controller.
@@ -24,9 +24,50 @@
 #import "ATLMConversationDetailViewController.h"
 #import "ATLMNavigationController.h"
 #import "LYRIdentity+ATLParticipant.h"
+#import "ATLMInstrumentation.h"
+#import "ATLMMessageSearchIndex.h"
+#import "ATLMConversationRollupIndex.h"
+#import "ATLMUIWorkScheduler.h"
+#import "ATLMConversationEventBus.h"
+#import "ATLMAccountManager.h"
+#import "ATLMAvatarImagePipeline.h"
+
+static const NSUInteger ATLMMessageSearchConversationLimit = 20;
+static const CGFloat ATLMConversationListAvatarDiameter = 48.0f;
+static const NSInteger ATLMConversationListAvatarPrefetchRowCount = 10;
+
+/**
+ @abstract Presents an identity with the image of the avatar pipeline, which
+   keeps Atlas from downloading and decoding the image in the cell.
+ */
+@interface ATLMConversationAvatarItem : NSObject <ATLAvatarItem>
+
+@property (nonatomic) LYRIdentity *identity;
+@property (nullable, nonatomic) UIImage *avatarImage;
+
+@end
+
+@implementation ATLMConversationAvatarItem
+
+- (NSURL *)avatarImageURL
+{
+    return nil;
+}
+
+- (NSString *)avatarInitials
+{
+    return self.identity.avatarInitials;
+}
+
+@end
 
 @interface ATLMConversationListViewController () <ATLConversationListViewControllerDelegate, ATLConversationListViewControllerDataSource, ATLMSettingsViewControllerDelegate, UIActionSheetDelegate>
 
+@property (nullable, nonatomic) NSArray<ATLMAccount *> *switchableAccounts;
+@property (nullable, nonatomic) NSIndexPath *avatarPrefetchEdgeIndexPath;
+@property (nonatomic) CGFloat avatarPrefetchContentOffset;
+@property (nonnull, nonatomic) NSOrderedSet<NSURL *> *prefetchedAvatarImageURLs;
+
 @end
 
 @implementation ATLMConversationListViewController
@@ -47,6 +88,8 @@ NSString *const ATLMComposeButtonAccessibilityLabel = @"Compose Button";
     self = [self initWithLayerClient:layerController.layerClient];
     if (self)  {
         _layerController = layerController;
+        _avatarImagePipeline = [ATLMAvatarImagePipeline sharedPipeline];
+        _prefetchedAvatarImageURLs = [NSOrderedSet orderedSet];
     }
     return self;
 }
@@ -61,6 +104,8 @@ NSString *const ATLMComposeButtonAccessibilityLabel = @"Compose Button";
     self.delegate = self;
     self.dataSource = self;
     self.allowsEditing = YES;
+    self.displaysAvatarItem = YES;
+    [[ATLAvatarImageView appearanceWhenContainedIn:[ATLConversationTableViewCell class], nil] setAvatarImageViewDiameter:ATLMConversationListAvatarDiameter];
     
     // Left navigation item
     UIButton* infoButton= [UIButton buttonWithType:UIButtonTypeInfoLight];
@@ -74,12 +119,24 @@ NSString *const ATLMComposeButtonAccessibilityLabel = @"Compose Button";
     composeButton.accessibilityLabel = ATLMComposeButtonAccessibilityLabel;
     [self.navigationItem setRightBarButtonItem:composeButton];
     
-    [self registerNotificationObservers];
+    [self subscribeToConversationEvents];
+
+    // The client may have restored its session without authenticating again.
+    if (!self.layerController.conversationRollupIndex.count) {
+        [self.layerController reloadConversationRollups];
+    }
+}
+
+- (void)viewDidAppear:(BOOL)animated
+{
+    [super viewDidAppear:animated];
+    [self prefetchAvatarsOfUpcomingRows];
 }
 
 - (void)dealloc
 {
     [[NSNotificationCenter defaultCenter] removeObserver:self];
+    [self.avatarImagePipeline cancelPrefetchingImagesForURLs:self.prefetchedAvatarImageURLs.array diameter:ATLMConversationListAvatarDiameter];
 }
 
 #pragma mark - ATLConversationListViewControllerDelegate
@@ -115,16 +172,57 @@ NSString *const ATLMComposeButtonAccessibilityLabel = @"Compose Button";
 {
     LYRQuery *query = [LYRQuery queryWithQueryableClass:[LYRIdentity class]];
     query.predicate = [LYRPredicate predicateWithProperty:@"displayName" predicateOperator:LYRPredicateOperatorLike value:[NSString stringWithFormat:@"%%%@%%", searchText]];
+    NSSet *messageParticipants = [self participantsOfConversationsWithMessagesMatchingText:searchText];
     [self.layerClient executeQuery:query completion:^(NSOrderedSet<id<ATLParticipant>> * _Nullable resultSet, NSError * _Nullable error) {
+        NSMutableSet *participants = [NSMutableSet setWithSet:messageParticipants];
         if (resultSet) {
-            completion(resultSet.set);
-        } else {
-            completion([NSSet set]);
+            [participants unionSet:resultSet.set];
         }
+        completion(participants);
     }];
 }
 
+/**
+ Atlas Messenger - Atlas searches conversations by participant, so conversations with messages matching the text are surfaced through their participants.
+ */
+- (NSSet *)participantsOfConversationsWithMessagesMatchingText:(NSString *)searchText
+{
+    NSMutableSet *participants = [NSMutableSet new];
+    for (ATLMConversationSearchHit *hit in [self.layerController.messageSearchIndex conversationHitsForQuery:searchText limit:ATLMMessageSearchConversationLimit]) {
+        LYRConversation *conversation = [self.layerController existingConversationForIdentifier:hit.conversationIdentifier];
+        [participants unionSet:conversation.participants ?: [NSSet set]];
+    }
+    if (self.layerClient.authenticatedUser) {
+        [participants removeObject:self.layerClient.authenticatedUser];
+    }
+    return participants;
+}
+
+/**
+ Atlas Messenger - Atlas would download and decode avatar images in each cell, so the images come from the avatar pipeline instead, which reloads the cell once a missing one is ready.
+ */
 - (id<ATLAvatarItem>)conversationListViewController:(ATLConversationListViewController *)conversationListViewController avatarItemForConversation:(LYRConversation *)conversation
+{
+    LYRIdentity *identity = [self avatarIdentityForConversation:conversation];
+    NSURL *avatarImageURL = identity.avatarImageURL;
+    if (!avatarImageURL) {
+        return identity;
+    }
+    ATLMConversationAvatarItem *avatarItem = [ATLMConversationAvatarItem new];
+    avatarItem.identity = identity;
+    avatarItem.avatarImage = [self.avatarImagePipeline cachedImageForURL:avatarImageURL diameter:ATLMConversationListAvatarDiameter];
+    if (!avatarItem.avatarImage) {
+        __weak typeof(self) weakSelf = self;
+        [self.avatarImagePipeline fetchImageForURL:avatarImageURL diameter:ATLMConversationListAvatarDiameter completion:^(UIImage *image, NSError *error) {
+            if (image && weakSelf.isViewLoaded && weakSelf.view.window) {
+                [weakSelf reloadCellForConversation:conversation];
+            }
+        }];
+    }
+    return avatarItem;
+}
+
+- (LYRIdentity *)avatarIdentityForConversation:(LYRConversation *)conversation
 {
     NSMutableSet *participants = conversation.participants.mutableCopy;
     [participants removeObject:self.layerClient.authenticatedUser];
@@ -137,6 +235,14 @@ NSString *const ATLMComposeButtonAccessibilityLabel = @"Compose Button";
  Atlas - Returns a label that is used to represent the conversation. Atlas Messenger puts the name representing the `lastMessage.sentByUserID` property first in the string.
  */
 - (NSString *)conversationListViewController:(ATLConversationListViewController *)conversationListViewController titleForConversation:(LYRConversation *)conversation
+{
+    uint64_t start = ATLMInstrumentationBegin(ATLMMetricConversationTitle);
+    NSString *title = [self displayTitleForConversation:conversation];
+    ATLMInstrumentationEnd(ATLMMetricConversationTitle, start);
+    return title;
+}
+
+- (NSString *)displayTitleForConversation:(LYRConversation *)conversation
 {
     // If we have a Conversation name in metadata, return it.
     NSString *conversationTitle = conversation.metadata[ATLMConversationMetadataNameKey];
@@ -167,6 +273,65 @@ NSString *const ATLMComposeButtonAccessibilityLabel = @"Compose Button";
     return firstNamesString;
 }
 
+#pragma mark - Avatar Prefetching
+
+- (void)scrollViewDidScroll:(UIScrollView *)scrollView
+{
+    if ([ATLConversationListViewController instancesRespondToSelector:@selector(scrollViewDidScroll:)]) {
+        [super scrollViewDidScroll:scrollView];
+    }
+    if (scrollView == self.tableView) {
+        [self prefetchAvatarsOfUpcomingRows];
+    }
+}
+
+/**
+ Atlas Messenger - Prefetches the avatars of the rows past the edge of the screen the list scrolls towards. Runs only when a row crosses that edge, not on every frame of the scroll.
+ */
+- (void)prefetchAvatarsOfUpcomingRows
+{
+    NSArray *visibleIndexPaths = self.tableView.indexPathsForVisibleRows;
+    if (!visibleIndexPaths.count || !self.queryController) {
+        return;
+    }
+    CGFloat contentOffset = self.tableView.contentOffset.y;
+    BOOL scrollingDown = contentOffset >= self.avatarPrefetchContentOffset;
+    self.avatarPrefetchContentOffset = contentOffset;
+    NSIndexPath *edgeIndexPath = scrollingDown ? visibleIndexPaths.lastObject : visibleIndexPaths.firstObject;
+    if ([edgeIndexPath isEqual:self.avatarPrefetchEdgeIndexPath]) {
+        return;
+    }
+    self.avatarPrefetchEdgeIndexPath = edgeIndexPath;
+
+    NSInteger rowCount = (NSInteger)[self.queryController numberOfObjectsInSection:edgeIndexPath.section];
+    NSMutableArray *conversations = [NSMutableArray arrayWithCapacity:ATLMConversationListAvatarPrefetchRowCount];
+    for (NSInteger step = 1; step <= ATLMConversationListAvatarPrefetchRowCount; step++) {
+        NSInteger row = scrollingDown ? edgeIndexPath.row + step : edgeIndexPath.row - step;
+        if (row < 0 || row >= rowCount) {
+            break;
+        }
+        [conversations addObject:[self.queryController objectAtIndexPath:[NSIndexPath indexPathForRow:row inSection:edgeIndexPath.section]]];
+    }
+    [self prefetchAvatarsForConversations:conversations];
+}
+
+- (void)prefetchAvatarsForConversations:(NSArray<LYRConversation *> *)conversations
+{
+    NSMutableOrderedSet *avatarImageURLs = [NSMutableOrderedSet orderedSetWithCapacity:conversations.count];
+    for (LYRConversation *conversation in conversations) {
+        NSURL *avatarImageURL = [self avatarIdentityForConversation:conversation].avatarImageURL;
+        if (avatarImageURL) {
+            [avatarImageURLs addObject:avatarImageURL];
+        }
+    }
+    // Only the prefetches of rows scrolled past are cancelled; the rows on screen wait for their fetches.
+    NSMutableOrderedSet *passedAvatarImageURLs = [self.prefetchedAvatarImageURLs mutableCopy];
+    [passedAvatarImageURLs minusOrderedSet:avatarImageURLs];
+    [self.avatarImagePipeline cancelPrefetchingImagesForURLs:passedAvatarImageURLs.array diameter:ATLMConversationListAvatarDiameter];
+    [self.avatarImagePipeline prefetchImagesForURLs:avatarImageURLs.array diameter:ATLMConversationListAvatarDiameter];
+    self.prefetchedAvatarImageURLs = avatarImageURLs;
+}
+
 #pragma mark - Conversation Selection
 
 // The following method handles presenting the correct `ATLMConversationViewController`, regardeless of the current state of the navigation stack.
@@ -214,7 +379,20 @@ NSString *const ATLMComposeButtonAccessibilityLabel = @"Compose Button";
 
 - (void)switchUserTappedInSettingsViewController:(ATLMSettingsViewController *)settingsViewController
 {
-    // Nothing to do. 
+    if (!self.accountManager || self.accountManager.isSwitching) {
+        return;
+    }
+    NSMutableArray *switchableAccounts = [self.accountManager.accounts mutableCopy];
+    [switchableAccounts removeObject:self.accountManager.activeAccount];
+    self.switchableAccounts = switchableAccounts;
+
+    UIActionSheet *actionSheet = [[UIActionSheet alloc] initWithTitle:@"Switch Account" delegate:self cancelButtonTitle:nil destructiveButtonTitle:nil otherButtonTitles:nil];
+    for (ATLMAccount *account in switchableAccounts) {
+        [actionSheet addButtonWithTitle:account.displayName ?: account.userID ?: @"Signed Out Account"];
+    }
+    [actionSheet addButtonWithTitle:@"Add Account"];
+    actionSheet.cancelButtonIndex = [actionSheet addButtonWithTitle:@"Cancel"];
+    [actionSheet showInView:settingsViewController.view];
 }
 
 - (void)logoutTappedInSettingsViewController:(ATLMSettingsViewController *)settingsViewController
@@ -246,21 +424,38 @@ NSString *const ATLMComposeButtonAccessibilityLabel = @"Compose Button";
     [settingsViewController dismissViewControllerAnimated:YES completion:nil];
 }
 
-#pragma mark - Notification Handlers
+#pragma mark - UIActionSheetDelegate
 
-- (void)conversationDeleted:(NSNotification *)notification
+- (void)actionSheet:(UIActionSheet *)actionSheet clickedButtonAtIndex:(NSInteger)buttonIndex
 {
-    if (self.ATLM_navigationController.isAnimating) {
-        [self.ATLM_navigationController notifyWhenCompletionEndsUsingBlock:^{
-            [self conversationDeleted:notification];
-        }];
+    NSArray *switchableAccounts = self.switchableAccounts;
+    self.switchableAccounts = nil;
+    if (buttonIndex == actionSheet.cancelButtonIndex) {
         return;
     }
-    
+    // The interface of this account is torn down by the switch.
+    if ((NSUInteger)buttonIndex < switchableAccounts.count) {
+        [self.accountManager switchToAccount:switchableAccounts[buttonIndex]];
+    } else {
+        [self.accountManager switchToNewAccount];
+    }
+}
+
+#pragma mark - Conversation Event Handlers
+
+- (void)conversationDeleted:(LYRConversation *)deletedConversation
+{
+    __weak typeof(self) weakSelf = self;
+    [[ATLMUIWorkScheduler sharedScheduler] scheduleWorkWithPriority:ATLMUIWorkPriorityHigh coalescingKey:@[ @"conversation-deleted", deletedConversation.identifier ] block:^{
+        [weakSelf handleDeletionOfConversation:deletedConversation];
+    }];
+}
+
+- (void)handleDeletionOfConversation:(LYRConversation *)deletedConversation
+{
     ATLMConversationViewController *conversationViewController = [self existingConversationViewController];
     if (!conversationViewController) return;
     
-    LYRConversation *deletedConversation = notification.object;
     if (![conversationViewController.conversation isEqual:deletedConversation]) return;
     conversationViewController = nil;
     [self.navigationController popToViewController:self animated:YES];
@@ -273,18 +468,19 @@ NSString *const ATLMComposeButtonAccessibilityLabel = @"Compose Button";
     [alertView show];
 }
 
-- (void)conversationParticipantsDidChange:(NSNotification *)notification
+- (void)conversationParticipantsDidChange:(LYRConversation *)conversation
+{
+    // Participants may change several times in a row; only the latest state matters.
+    __weak typeof(self) weakSelf = self;
+    [[ATLMUIWorkScheduler sharedScheduler] scheduleWorkWithPriority:ATLMUIWorkPriorityHigh coalescingKey:@[ @"conversation-participants", conversation.identifier ] block:^{
+        [weakSelf handleParticipantChangeOfConversation:conversation];
+    }];
+}
+
+- (void)handleParticipantChangeOfConversation:(LYRConversation *)conversation
 {
-    if (self.ATLM_navigationController.isAnimating) {
-        [self.ATLM_navigationController notifyWhenCompletionEndsUsingBlock:^{
-            [self conversationParticipantsDidChange:notification];
-        }];
-        return;
-    }
-    
     NSString *authenticatedUserID = self.layerClient.authenticatedUser.userID;
     if (!authenticatedUserID) return;
-    LYRConversation *conversation = notification.object;
     if ([[conversation.participants valueForKeyPath:@"userID"] containsObject:authenticatedUserID]) return;
     
     ATLMConversationViewController *conversationViewController = [self existingConversationViewController];
@@ -319,10 +515,16 @@ NSString *const ATLMComposeButtonAccessibilityLabel = @"Compose Button";
     return nextViewController;
 }
 
-- (void)registerNotificationObservers
+- (void)subscribeToConversationEvents
 {
-    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(conversationDeleted:) name:ATLMConversationDeletedNotification object:nil];
-    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(conversationParticipantsDidChange:) name:ATLMConversationParticipantsDidChangeNotification object:nil];
+    // The conversation on screen may be any of them, so these follow every conversation.
+    ATLMConversationEventBus *bus = self.layerController.conversationEventBus;
+    [bus subscribeObserver:self toEventKind:ATLMConversationEventKindDeleted conversationIdentifier:nil queue:nil handler:^(ATLMConversationListViewController *viewController, ATLMConversationEvent *event) {
+        [viewController conversationDeleted:event.conversation];
+    }];
+    [bus subscribeObserver:self toEventKind:ATLMConversationEventKindParticipantsDidChange conversationIdentifier:nil queue:nil handler:^(ATLMConversationListViewController *viewController, ATLMConversationEvent *event) {
+        [viewController conversationParticipantsDidChange:event.conversation];
+    }];
 }
 
 @end
@@ -26,6 +26,17 @@
 #import "ATLMUtilities.h"
 #import "ATLMParticipantTableViewController.h"
 #import "LYRIdentity+ATLParticipant.h"
+#import "ATLMMessageLayoutCache.h"
+#import "ATLMMediaTranscoder.h"
+#import "ATLMOutbox.h"
+#import "ATLMMessagePartIndex.h"
+#import "ATLMInstrumentation.h"
+#import "ATLMMemoryAccountant.h"
+#import "ATLMHangDetector.h"
+#import "ATLMConversationEventBus.h"
+
+// Half the planner's default backfill threshold, so backfills still start in time.
+static const NSUInteger ATLMViewedDepthReportingInterval = 5;
 
 static NSDateFormatter *ATLMShortTimeFormatter()
 {
@@ -126,8 +137,89 @@ static ATLMDateProximity ATLMProximityToDate(NSDate *date)
     return ATLMDateProximityOther;
 }
 
+static NSAttributedString *ATLMAttributedStringForDate(NSDate *date)
+{
+    NSDateFormatter *dateFormatter;
+    ATLMDateProximity dateProximity = ATLMProximityToDate(date);
+    switch (dateProximity) {
+        case ATLMDateProximityToday:
+        case ATLMDateProximityYesterday:
+            dateFormatter = ATLMRelativeDateFormatter();
+            break;
+        case ATLMDateProximityWeek:
+            dateFormatter = ATLMDayOfWeekDateFormatter();
+            break;
+        case ATLMDateProximityYear:
+            dateFormatter = ATLMThisYearDateFormatter();
+            break;
+        case ATLMDateProximityOther:
+            dateFormatter = ATLMDefaultDateFormatter();
+            break;
+    }
+
+    NSString *dateString = [dateFormatter stringFromDate:date];
+    NSString *timeString = [ATLMShortTimeFormatter() stringFromDate:date];
+    
+    NSMutableAttributedString *dateAttributedString = [[NSMutableAttributedString alloc] initWithString:[NSString stringWithFormat:@"%@ %@", dateString, timeString]];
+    [dateAttributedString addAttribute:NSForegroundColorAttributeName value:[UIColor grayColor] range:NSMakeRange(0, dateAttributedString.length)];
+    [dateAttributedString addAttribute:NSFontAttributeName value:[UIFont systemFontOfSize:11] range:NSMakeRange(0, dateAttributedString.length)];
+    [dateAttributedString addAttribute:NSFontAttributeName value:[UIFont boldSystemFontOfSize:11] range:NSMakeRange(0, dateString.length)];
+    return dateAttributedString;
+}
+
+typedef NS_OPTIONS(NSUInteger, ATLMRecipientStatusFlag) {
+    ATLMRecipientStatusFlagPending      = 1 << 0,
+    ATLMRecipientStatusFlagSent         = 1 << 1,
+    ATLMRecipientStatusFlagDelivered    = 1 << 2,
+};
+
+/**
+ @abstract Returns the recipient status string from the summary of the other recipients' statuses.
+ @param recipientCount The number of recipients other than the authenticated user.
+ @param readCount The number of those recipients who read the message.
+ @param statusFlags The `ATLMRecipientStatusFlag` values of the statuses present.
+ @param lastStatus The status of the last enumerated recipient, used for one-on-one conversations.
+ */
+static NSString *ATLMRecipientStatusString(NSUInteger recipientCount, NSUInteger readCount, NSUInteger statusFlags, LYRRecipientStatus lastStatus)
+{
+    if (recipientCount > 1) {
+        if (readCount) {
+            NSString *participantString = readCount > 1 ? @"Participants" : @"Participant";
+            return [NSString stringWithFormat:@"Read by %lu %@", (unsigned long)readCount, participantString];
+        } else if (statusFlags & ATLMRecipientStatusFlagPending) {
+            return @"Pending";
+        } else if (statusFlags & ATLMRecipientStatusFlagDelivered) {
+            return @"Delivered";
+        } else if (statusFlags & ATLMRecipientStatusFlagSent) {
+            return @"Sent";
+        }
+        return @"";
+    }
+    if (recipientCount == 0) {
+        return @"";
+    }
+    switch (lastStatus) {
+        case LYRRecipientStatusInvalid:
+            return @"Not Sent";
+        case LYRRecipientStatusPending:
+            return @"Pending";
+        case LYRRecipientStatusSent:
+            return @"Sent";
+        case LYRRecipientStatusDelivered:
+            return @"Delivered";
+        case LYRRecipientStatusRead:
+            return @"Read";
+    }
+    return @"";
+}
+
 @interface ATLMConversationViewController () <ATLMConversationDetailViewControllerDelegate, ATLParticipantTableViewControllerDelegate>
 
+@property (nullable, nonatomic) ATLMMessageLayoutCache *messageLayoutCache;
+@property (nonatomic) CGFloat lastLayoutWidth;
+@property (nonatomic) NSUInteger lastReportedViewedDepth;
+@property (nullable, nonatomic) id metadataSubscription;
+
 @end
 
 @implementation ATLMConversationViewController
@@ -179,6 +271,19 @@ NSString *const ATLMDetailsButtonLabel = @"Details";
     if (![self isMovingFromParentViewController]) {
         [self.view resignFirstResponder];
     }
+    [self.messageLayoutCache persist];
+}
+
+- (void)viewDidLayoutSubviews
+{
+    [super viewDidLayoutSubviews];
+    // Only a width change affects the cell heights; the heights for a width
+    // seen before come straight from the message layout cache.
+    CGFloat width = CGRectGetWidth(self.collectionView.bounds);
+    if (self.lastLayoutWidth && width != self.lastLayoutWidth) {
+        [self.collectionView.collectionViewLayout invalidateLayout];
+    }
+    self.lastLayoutWidth = width;
 }
 
 - (void)dealloc
@@ -192,6 +297,28 @@ NSString *const ATLMDetailsButtonLabel = @"Details";
 {
     [super setConversation:conversation];
     [self configureTitle];
+
+    NSString *conversationIdentifier = conversation.identifier.absoluteString;
+    if (![self.messageLayoutCache.identifier isEqualToString:conversationIdentifier]) {
+        [self.messageLayoutCache persist];
+        if (self.messageLayoutCache) {
+            [[ATLMMemoryAccountant sharedAccountant] unregisterConsumer:self.messageLayoutCache];
+        }
+        self.messageLayoutCache = conversationIdentifier ? [ATLMMessageLayoutCache layoutCacheWithIdentifier:conversationIdentifier directory:[ATLMMessageLayoutCache defaultDirectory]] : nil;
+        if (self.messageLayoutCache) {
+            [[ATLMMemoryAccountant sharedAccountant] registerConsumer:self.messageLayoutCache];
+        }
+        [self.messageLayoutCache loadWithCompletion:nil];
+        self.lastReportedViewedDepth = 0;
+        [self.layerController.conversationEventBus unsubscribe:self.metadataSubscription];
+        self.metadataSubscription = nil;
+        if (conversation) {
+            [self.layerController didOpenConversation:conversation];
+            self.metadataSubscription = [self.layerController.conversationEventBus subscribeObserver:self toEventKind:ATLMConversationEventKindMetadataDidChange conversationIdentifier:conversation.identifier queue:nil handler:^(ATLMConversationViewController *viewController, ATLMConversationEvent *event) {
+                [viewController configureTitle];
+            }];
+        }
+    }
 }
 
 #pragma mark - ATLConversationViewControllerDelegate
@@ -205,11 +332,14 @@ NSString *const ATLMDetailsButtonLabel = @"Details";
 }
 
 /**
- Atlas - Informs the delegate that a message failed to send. Atlas messeneger display an alert view to inform the user of the failure.
+ Atlas - Informs the delegate that a message failed to send. Atlas Messenger queues the message in the outbox, which retries it once connected, and only displays an alert view if the message can't be queued.
  */
 - (void)conversationViewController:(ATLConversationViewController *)viewController didFailSendingMessage:(LYRMessage *)message error:(NSError *)error;
 {
     NSLog(@"Message Send Failed with Error: %@", error);
+    if (message.conversation && [self.layerController enqueueMessageWithParts:message.parts pushText:nil conversation:message.conversation]) {
+        return;
+    }
     UIAlertView *alertView = [[UIAlertView alloc] initWithTitle:@"Messaging Error"
                                                         message:error.localizedDescription
                                                        delegate:nil
@@ -218,45 +348,130 @@ NSString *const ATLMDetailsButtonLabel = @"Details";
     [alertView show];
 }
 
+/**
+ Atlas - Returns the height of the cell displaying the message. Atlas Messenger serves the heights from a cache keyed by message identifier, content hash and width class, so that relayouts don't remeasure every loaded message.
+ */
+- (CGFloat)conversationViewController:(ATLConversationViewController *)viewController heightForMessage:(LYRMessage *)message withCellWidth:(CGFloat)cellWidth
+{
+    CGFloat (^calculation)(void) = ^CGFloat{
+        return [ATLMessageCollectionViewCell cellHeightForMessage:message inView:self.view];
+    };
+    if (!self.messageLayoutCache) {
+        return calculation();
+    }
+    return [self.messageLayoutCache heightForMessageIdentifier:message.identifier.absoluteString contentHash:ATLMMessageContentHash(message) width:cellWidth calculation:calculation];
+}
+
+/**
+ Atlas - Returns the messages to send for the content of the input toolbar. When images or videos are attached to an existing conversation, Atlas Messenger transcodes them in the background, queues all attachments in the outbox once they are ready and returns an empty set so nothing is sent synchronously. Otherwise it returns `nil` and Atlas builds the messages itself.
+ */
+- (NSOrderedSet *)conversationViewController:(ATLConversationViewController *)viewController messagesForMediaAttachments:(NSArray *)mediaAttachments
+{
+    LYRConversation *conversation = self.conversation.identifier ? [self.layerController existingConversationForIdentifier:self.conversation.identifier] : nil;
+    if (!conversation) {
+        return nil;
+    }
+    BOOL hasTranscodableMedia = NO;
+    for (ATLMediaAttachment *attachment in mediaAttachments) {
+        if ([self shouldTranscodeMediaAttachment:attachment]) {
+            hasTranscodableMedia = YES;
+            break;
+        }
+    }
+    if (!hasTranscodableMedia) {
+        return nil;
+    }
+    [self enqueueMediaAttachments:mediaAttachments conversation:conversation];
+    return [NSOrderedSet orderedSet];
+}
+
 /**
  Atlas - Informs the delegate that a message was selected. Atlas messenger presents an `ATLImageViewController` if the message contains an image.
  */
 - (void)conversationViewController:(ATLConversationViewController *)viewController didSelectMessage:(LYRMessage *)message
 {
-    LYRMessagePart *messagePart = ATLMessagePartForMIMEType(message, ATLMIMETypeImageJPEG);
-    if (messagePart) {
+    ATLMMessagePartIndex *partIndex = [ATLMMessagePartIndex indexForMessage:message];
+    if (partIndex.renderableMediaPart) {
         [self presentMediaViewControllerWithMessage:message];
         return;
     }
-    messagePart = ATLMessagePartForMIMEType(message, ATLMIMETypeImagePNG);
-    if (messagePart) {
-        [self presentMediaViewControllerWithMessage:message];
+    if ([partIndex containsMIMEType:ATLMIMETypeLocation]) {
+        [self presentLocationViewControllerWithMessage:message];
         return;
     }
-    messagePart = ATLMessagePartForMIMEType(message, ATLMIMETypeImageGIF);
-    if (messagePart) {
-        [self presentMediaViewControllerWithMessage:message];
-        return;
+}
+
+- (BOOL)shouldTranscodeMediaAttachment:(ATLMediaAttachment *)attachment
+{
+    return (attachment.mediaType == ATLMediaAttachmentTypeImage || attachment.mediaType == ATLMediaAttachmentTypeVideo) && attachment.mediaInputStream && [ATLMMediaTranscoder canTranscodeMIMEType:attachment.mediaMIMEType];
+}
+
+- (void)enqueueMediaAttachments:(NSArray *)mediaAttachments conversation:(LYRConversation *)conversation
+{
+    // Media is transcoded in parallel; the messages are queued in their original order once all of it is ready.
+    NSMutableArray *messageContents = [NSMutableArray arrayWithCapacity:mediaAttachments.count];
+    dispatch_group_t group = dispatch_group_create();
+    for (ATLMediaAttachment *attachment in mediaAttachments) {
+        NSUInteger index = messageContents.count;
+        if (![self shouldTranscodeMediaAttachment:attachment]) {
+            [messageContents addObject:ATLMessagePartsWithMediaAttachment(attachment)];
+            continue;
+        }
+        [messageContents addObject:[NSNull null]];
+        dispatch_group_enter(group);
+        [self.layerController.mediaTranscoder transcodeMediaWithMIMEType:attachment.mediaMIMEType inputStream:attachment.mediaInputStream fallingBackToOriginalWithCompletion:^(ATLMTranscodedMedia *media, NSError *error) {
+            if (media.isTranscoded) {
+                messageContents[index] = media;
+            } else if (media) {
+                // Sent as attached, with the attachment's own preview and size parts.
+                NSLog(@"Failed to transcode media attachment, sending it as is: %@", error);
+                messageContents[index] = [self messagePartsWithUntranscodedMedia:media attachment:attachment];
+            } else {
+                NSLog(@"Failed to read media attachment with error: %@", error);
+            }
+            dispatch_group_leave(group);
+        }];
     }
-    messagePart = ATLMessagePartForMIMEType(message, ATLMIMETypeVideoMP4);
-    if (messagePart) {
-        [self presentMediaViewControllerWithMessage:message];
-        return;
+    dispatch_group_notify(group, dispatch_get_main_queue(), ^{
+        BOOL failed = NO;
+        for (id contents in messageContents) {
+            if ([contents isKindOfClass:[ATLMTranscodedMedia class]]) {
+                ATLMTranscodedMedia *media = contents;
+                [self.layerController.outbox enqueueMessageWithMIMETypes:media.MIMETypes partData:media.partData pushText:nil conversationIdentifier:conversation.identifier];
+            } else if ([contents isKindOfClass:[NSArray class]]) {
+                failed |= ![self.layerController enqueueMessageWithParts:contents pushText:nil conversation:conversation];
+            } else {
+                failed = YES;
+            }
+        }
+        if (failed) {
+            UIAlertView *alertView = [[UIAlertView alloc] initWithTitle:@"Messaging Error"
+                                                                message:@"Some of the attachments could not be sent."
+                                                               delegate:nil
+                                                      cancelButtonTitle:@"OK"
+                                                      otherButtonTitles:nil];
+            [alertView show];
+        }
+    });
+}
+
+- (NSArray *)messagePartsWithUntranscodedMedia:(ATLMTranscodedMedia *)media attachment:(ATLMediaAttachment *)attachment
+{
+    NSMutableArray *parts = [NSMutableArray arrayWithCapacity:3];
+    [parts addObject:[LYRMessagePart messagePartWithMIMEType:media.MIMETypes.firstObject data:media.partData.firstObject]];
+    if (attachment.thumbnailInputStream) {
+        [parts addObject:[LYRMessagePart messagePartWithMIMEType:attachment.thumbnailMIMEType stream:attachment.thumbnailInputStream]];
     }
-    
-    messagePart = ATLMessagePartForMIMEType(message, ATLMIMETypeLocation);
-    if (messagePart) {
-        [self presentLocationViewControllerWithMessage:message];
-        return;
+    if (attachment.metadataInputStream) {
+        [parts addObject:[LYRMessagePart messagePartWithMIMEType:attachment.metadataMIMEType stream:attachment.metadataInputStream]];
     }
+    return parts;
 }
 
 - (void)presentLocationViewControllerWithMessage:(LYRMessage *)message
 {
     ATLMLocationViewController *locationViewController = [[ATLMLocationViewController alloc] initWithMessage:message];
     [self showViewController:locationViewController sender:self];
-    
-    locationViewController.mapView.scrollEnabled = NO;
 }
 
 - (void)presentMediaViewControllerWithMessage:(LYRMessage *)message
@@ -299,32 +514,15 @@ NSString *const ATLMDetailsButtonLabel = @"Details";
  */
 - (NSAttributedString *)conversationViewController:(ATLConversationViewController *)conversationViewController attributedStringForDisplayOfDate:(NSDate *)date
 {
-    NSDateFormatter *dateFormatter;
-    ATLMDateProximity dateProximity = ATLMProximityToDate(date);
-    switch (dateProximity) {
-        case ATLMDateProximityToday:
-        case ATLMDateProximityYesterday:
-            dateFormatter = ATLMRelativeDateFormatter();
-            break;
-        case ATLMDateProximityWeek:
-            dateFormatter = ATLMDayOfWeekDateFormatter();
-            break;
-        case ATLMDateProximityYear:
-            dateFormatter = ATLMThisYearDateFormatter();
-            break;
-        case ATLMDateProximityOther:
-            dateFormatter = ATLMDefaultDateFormatter();
-            break;
+    if (!self.messageLayoutCache) {
+        return ATLMAttributedStringForDate(date);
     }
-
-    NSString *dateString = [dateFormatter stringFromDate:date];
-    NSString *timeString = [ATLMShortTimeFormatter() stringFromDate:date];
-    
-    NSMutableAttributedString *dateAttributedString = [[NSMutableAttributedString alloc] initWithString:[NSString stringWithFormat:@"%@ %@", dateString, timeString]];
-    [dateAttributedString addAttribute:NSForegroundColorAttributeName value:[UIColor grayColor] range:NSMakeRange(0, dateAttributedString.length)];
-    [dateAttributedString addAttribute:NSFontAttributeName value:[UIFont systemFontOfSize:11] range:NSMakeRange(0, dateAttributedString.length)];
-    [dateAttributedString addAttribute:NSFontAttributeName value:[UIFont boldSystemFontOfSize:11] range:NSMakeRange(0, dateString.length)];
-    return dateAttributedString;
+    // The string only depends on the minute of the date and on the current day.
+    NSUInteger today = [[NSCalendar currentCalendar] ordinalityOfUnit:NSCalendarUnitDay inUnit:NSCalendarUnitEra forDate:[NSDate date]];
+    NSString *key = [NSString stringWithFormat:@"date:%lld:%lu", (long long)floor(date.timeIntervalSince1970 / 60.0), (unsigned long)today];
+    return [self.messageLayoutCache attributedStringForKey:key generator:^NSAttributedString *{
+        return ATLMAttributedStringForDate(date);
+    }];
 }
 
 /**
@@ -332,72 +530,44 @@ NSString *const ATLMDetailsButtonLabel = @"Details";
  */
 - (NSAttributedString *)conversationViewController:(ATLConversationViewController *)conversationViewController attributedStringForDisplayOfRecipientStatus:(NSDictionary *)recipientStatus
 {
-    NSMutableDictionary *mutableRecipientStatus = [recipientStatus mutableCopy];
-    if ([mutableRecipientStatus valueForKey:self.layerClient.authenticatedUser.userID]) {
-        [mutableRecipientStatus removeObjectForKey:self.layerClient.authenticatedUser.userID];
-    }
-    
-    NSString *statusString = [NSString new];
-    if (mutableRecipientStatus.count > 1) {
-        __block NSUInteger readCount = 0;
-        __block BOOL delivered = NO;
-        __block BOOL sent = NO;
-        __block BOOL pending = NO;
-        [mutableRecipientStatus enumerateKeysAndObjectsUsingBlock:^(NSString *userID, NSNumber *statusNumber, BOOL *stop) {
-            LYRRecipientStatus status = statusNumber.integerValue;
-            switch (status) {
-                case LYRRecipientStatusInvalid:
-                    break;
-                case LYRRecipientStatusPending:
-                    pending = YES;
-                    break;
-                case LYRRecipientStatusSent:
-                    sent = YES;
-                    break;
-                case LYRRecipientStatusDelivered:
-                    delivered = YES;
-                    break;
-                case LYRRecipientStatusRead:
-                    readCount += 1;
-                    break;
-            }
-        }];
-        if (readCount) {
-            NSString *participantString = readCount > 1 ? @"Participants" : @"Participant";
-            statusString = [NSString stringWithFormat:@"Read by %lu %@", (unsigned long)readCount, participantString];
-        } else if (pending) {
-            statusString = @"Pending";
-        }else if (delivered) {
-            statusString = @"Delivered";
-        } else if (sent) {
-            statusString = @"Sent";
+    // Reduce the statuses to the few inputs the string depends on in a
+    // single pass, and only build the string when that summary is new.
+    NSString *authenticatedUserID = self.layerClient.authenticatedUser.userID;
+    NSUInteger recipientCount = 0;
+    NSUInteger readCount = 0;
+    NSUInteger statusFlags = 0;
+    LYRRecipientStatus lastStatus = LYRRecipientStatusInvalid;
+    for (NSString *userID in recipientStatus) {
+        if ([userID isEqualToString:authenticatedUserID]) {
+            continue;
         }
-    } else {
-        __block NSString *blockStatusString = [NSString new];
-        [mutableRecipientStatus enumerateKeysAndObjectsUsingBlock:^(NSString *userID, NSNumber *statusNumber, BOOL *stop) {
-            if ([userID isEqualToString:self.layerClient.authenticatedUser.userID]) return;
-            LYRRecipientStatus status = statusNumber.integerValue;
-            switch (status) {
-                case LYRRecipientStatusInvalid:
-                    blockStatusString = @"Not Sent";
-                    break;
-                case LYRRecipientStatusPending:
-                    blockStatusString = @"Pending";
-                    break;
-                case LYRRecipientStatusSent:
-                    blockStatusString = @"Sent";
-                    break;
-                case LYRRecipientStatusDelivered:
-                    blockStatusString = @"Delivered";
-                    break;
-                case LYRRecipientStatusRead:
-                    blockStatusString = @"Read";
-                    break;
-            }
-        }];
-        statusString = blockStatusString;
+        LYRRecipientStatus status = [recipientStatus[userID] integerValue];
+        recipientCount += 1;
+        lastStatus = status;
+        switch (status) {
+            case LYRRecipientStatusInvalid:
+                break;
+            case LYRRecipientStatusPending:
+                statusFlags |= ATLMRecipientStatusFlagPending;
+                break;
+            case LYRRecipientStatusSent:
+                statusFlags |= ATLMRecipientStatusFlagSent;
+                break;
+            case LYRRecipientStatusDelivered:
+                statusFlags |= ATLMRecipientStatusFlagDelivered;
+                break;
+            case LYRRecipientStatusRead:
+                readCount += 1;
+                break;
+        }
+    }
+    NSString *statusString = ATLMRecipientStatusString(recipientCount, readCount, statusFlags, lastStatus);
+    if (!self.messageLayoutCache) {
+        return [[NSAttributedString alloc] initWithString:statusString attributes:@{NSFontAttributeName : [UIFont boldSystemFontOfSize:11]}];
     }
-    return [[NSAttributedString alloc] initWithString:statusString attributes:@{NSFontAttributeName : [UIFont boldSystemFontOfSize:11]}];
+    return [self.messageLayoutCache attributedStringForKey:[@"status:" stringByAppendingString:statusString] generator:^NSAttributedString *{
+        return [[NSAttributedString alloc] initWithString:statusString attributes:@{NSFontAttributeName : [UIFont boldSystemFontOfSize:11]}];
+    }];
 }
 
 #pragma mark - ATLAddressBarControllerDelegate
@@ -414,13 +584,15 @@ NSString *const ATLMDetailsButtonLabel = @"Details";
     }
     
     NSError *error;
+    [[ATLMHangDetector sharedDetector] beginOperation:@"participants.add-contacts"];
     NSOrderedSet *identities = [self.layerClient executeQuery:query error:&error];
+    [[ATLMHangDetector sharedDetector] endOperation:@"participants.add-contacts"];
     if (error) {
         ATLMAlertWithError(error);
     }
     
     ATLMParticipantTableViewController *controller = [ATLMParticipantTableViewController participantTableViewControllerWithParticipants:identities.set sortType:ATLParticipantPickerSortTypeFirstName];
-    controller.blockedParticipantIdentifiers = [self.layerClient.policies valueForKey:@"sentByUserID"];
+    controller.blockedParticipantIdentifiers = self.layerController.blockedUserIDs;
     controller.delegate = self;
     controller.allowsMultipleSelection = NO;
     
@@ -527,21 +699,11 @@ NSString *const ATLMDetailsButtonLabel = @"Details";
     [self.navigationController pushViewController:detailViewController animated:YES];
 }
 
-#pragma mark - Notification Handlers
-
-- (void)conversationMetadataDidChange:(NSNotification *)notification
-{
-    if (!self.conversation) return;
-    if (!notification.object) return;
-    if (![notification.object isEqual:self.conversation]) return;
-
-    [self configureTitle];
-}
-
 #pragma mark - Helpers
 
 - (void)configureTitle
 {
+    uint64_t start = ATLMInstrumentationBegin(ATLMMetricConversationTitle);
     if ([self.conversation.metadata valueForKey:ATLMConversationMetadataNameKey]) {
         NSString *conversationTitle = [self.conversation.metadata valueForKey:ATLMConversationMetadataNameKey];
         if (conversationTitle.length) {
@@ -551,6 +713,7 @@ NSString *const ATLMDetailsButtonLabel = @"Details";
         }    } else {
         self.title = [self defaultTitle];
     }
+    ATLMInstrumentationEnd(ATLMMetricConversationTitle, start);
 }
 
 - (NSString *)defaultTitle
@@ -609,15 +772,54 @@ NSString *const ATLMDetailsButtonLabel = @"Details";
 - (void)registerNotificationObservers
 {
     [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(userDidTapLink:) name:ATLUserDidTapLinkNotification object:nil];
-    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(conversationMetadataDidChange:) name:ATLMConversationMetadataDidChangeNotification object:nil];
     [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(deviceOrientationDidChange:) name:UIDeviceOrientationDidChangeNotification object:nil];
+    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(layerClientObjectsDidChange:) name:LYRClientObjectsDidChangeNotification object:self.layerClient];
+}
+
+#pragma mark - Scrolling
+
+- (void)scrollViewDidScroll:(UIScrollView *)scrollView
+{
+    if ([ATLConversationViewController instancesRespondToSelector:@selector(scrollViewDidScroll:)]) {
+        [super scrollViewDidScroll:scrollView];
+    }
+    if (!self.conversation || scrollView != self.collectionView) {
+        return;
+    }
+    // Each message has its own section. Only the deepest point matters to the
+    // planner, so report it every few messages as the user scrolls further up.
+    CGPoint topPoint = CGPointMake(CGRectGetMidX(scrollView.bounds), CGRectGetMinY(scrollView.bounds) + scrollView.contentInset.top);
+    NSIndexPath *topIndexPath = [self.collectionView indexPathForItemAtPoint:topPoint];
+    if (!topIndexPath) {
+        return;
+    }
+    NSInteger numberOfSections = [self.collectionView numberOfSections];
+    NSUInteger viewedDepth = (NSUInteger)MAX(0, numberOfSections - topIndexPath.section);
+    if (viewedDepth < self.lastReportedViewedDepth + ATLMViewedDepthReportingInterval) {
+        return;
+    }
+    self.lastReportedViewedDepth = viewedDepth;
+    [self.layerController didScrollConversation:self.conversation toViewedDepth:viewedDepth];
 }
 
 #pragma mark - Device Orientation
 
 - (void)deviceOrientationDidChange:(NSNotification *)notification
 {
-    [self.collectionView.collectionViewLayout invalidateLayout];
+    // Face up/down changes don't affect the cell widths, so the layout is
+    // invalidated in `viewDidLayoutSubviews` once the width actually changed.
+    [self.view setNeedsLayout];
+}
+
+#pragma mark - Layer Object Changes
+
+- (void)layerClientObjectsDidChange:(NSNotification *)notification
+{
+    for (LYRObjectChange *change in notification.userInfo[LYRClientObjectChangesUserInfoKey]) {
+        if (change.type == LYRObjectChangeTypeDelete && [change.object isKindOfClass:[LYRMessage class]]) {
+            [self.messageLayoutCache invalidateMessageIdentifier:[change.object identifier].absoluteString];
+        }
+    }
 }
 
 @end
@@ -32,9 +32,17 @@ extern NSString *_Nonnull const ATLMLayerControllerErrorDomain;
 typedef NS_ENUM(NSUInteger, ATLMLayerControllerError) {
     ATLMLayerControllerErrorAppIDAlreadySet                  = 1, // Layer appID already set on the application controller.
     ATLMLayerControllerErrorFailedHandlingRemoteNotification = 2, // Underlying Layer client failed to handle the remote notification.
+    ATLMLayerControllerErrorFailedSendingInlineReply         = 3, // Inline reply could not be sent yet and remains queued.
+    ATLMLayerControllerErrorFailedSendingQueuedMessage       = 4, // Message queued in the outbox could not be sent.
 };
 
 @class ATLMLayerController;
+@class ATLMSynchronizationPlanner;
+@class ATLMOutbox;
+@class ATLMMediaTranscoder;
+@class ATLMMessageSearchIndex;
+@class ATLMConversationRollupIndex;
+@class ATLMConversationEventBus;
 
 /**
  @abstract The `ATLMLayerControllerDelegate` notifies the receiver about
@@ -51,8 +59,10 @@ typedef NS_ENUM(NSUInteger, ATLMLayerControllerError) {
  @param applicationController The `ATLMLayerController` instance performing the invocation.
  @param conversation The `LYRConversation` instance associated with the remote notification.
  @param conversation The `LYRMessage` instance associated with the remote notification.
+ @discussion Inline replies are sent by the application controller itself and
+   are not passed to the receiver.
  */
-- (void)layerController:(nonnull ATLMLayerController *)applicationController didFinishHandlingRemoteNotificationForConversation:(nullable LYRConversation *)conversation message:(nullable LYRMessage *)message responseText:(nullable NSString *)responseText;
+- (void)layerController:(nonnull ATLMLayerController *)applicationController didFinishHandlingRemoteNotificationForConversation:(nullable LYRConversation *)conversation message:(nullable LYRMessage *)message;
 
 /**
  @abstract Notifies the receiver the application controller has hit an error.
@@ -87,6 +97,22 @@ typedef NS_ENUM(NSUInteger, ATLMLayerControllerError) {
  */
 + (nonnull instancetype)applicationControllerWithLayerAppID:(nonnull NSURL *)layerAppID clientOptions:(nullable LYRClientOptions *)clientOptions authenticationProvider:(nonnull id<ATLMAuthenticating>)authenticationProvider;
 
+/**
+ @abstract Creates the `ATLMLayerController` instance of one of several accounts.
+ @param accountIdentifier The identifier of the account or `nil` for the
+   account whose data lives directly in the application data directory.
+ @discussion The inline replies, outbox journal, synchronization plan,
+   conversation preferences and search index of an account are kept in a
+   directory of its own, so the controllers of different accounts can live
+   side by side.
+ */
++ (nonnull instancetype)applicationControllerWithLayerAppID:(nonnull NSURL *)layerAppID clientOptions:(nullable LYRClientOptions *)clientOptions authenticationProvider:(nonnull id<ATLMAuthenticating>)authenticationProvider accountIdentifier:(nullable NSString *)accountIdentifier;
+
+/**
+ @abstract The identifier of the account the controller was created for.
+ */
+@property (nullable, nonatomic, readonly, copy) NSString *accountIdentifier;
+
 /**
  @abstract Authenticates the application by performing the Layer authentication handshake.
  @param credentials An `NSDictionary` containing authetication credentials. 
@@ -114,6 +140,12 @@ typedef NS_ENUM(NSUInteger, ATLMLayerControllerError) {
    no matter if the underlying client handled the remote notification
    successfully, hit an error, or if the remote notification was not meant
    for the underlying `layerClient`.
+ @discussion Remote notifications are coalesced: the ones arriving within a
+   short window are handled by a single synchronization and their completion
+   handlers are called together, at the latest when the background fetch time
+   budget runs out. An inline reply in `responseInfo` is persisted and sent to
+   the conversation referenced by the payload right away, in parallel with the
+   synchronization; the `completionHandler` reports whether it has been sent.
  */
 - (void)handleRemoteNotification:(nonnull NSDictionary *)userInfo responseInfo:(nullable NSDictionary *)responseInfo completion:(nonnull void (^)(BOOL success, NSError *_Nullable error))completionHandler;
 
@@ -172,4 +204,149 @@ typedef NS_ENUM(NSUInteger, ATLMLayerControllerError) {
  */
 - (nullable LYRConversation *)existingConversationForParticipants:(nonnull NSSet *)participants;
 
+///-------------------
+/// @name Sending
+///-------------------
+
+/**
+ @abstract Journals outgoing messages until they have been handed over to the client.
+ @discussion The outbox is flushed in batches whenever the client connects and
+   retries failed sends per conversation with a backoff.
+ */
+@property (nonnull, nonatomic, readonly) ATLMOutbox *outbox;
+
+/**
+ @abstract Queues a message with the supplied parts for sending through the outbox.
+ @discussion Parts backed by a stream instead of data are copied to the
+   outbox's part files before the message is sent. Entries aren't attempted
+   while no user is authenticated.
+ @param parts The message parts.
+ @param pushText The push notification text or `nil` to derive it from the parts.
+ @param conversation The conversation to send the message to.
+ @return The identifier of the outbox entry or `nil` if a part has neither data nor a stream.
+ */
+- (nullable NSString *)enqueueMessageWithParts:(nonnull NSArray<LYRMessagePart *> *)parts pushText:(nullable NSString *)pushText conversation:(nonnull LYRConversation *)conversation;
+
+/**
+ @abstract Downscales and re-encodes outgoing images and videos before they are queued in the outbox.
+ */
+@property (nonnull, nonatomic, readonly) ATLMMediaTranscoder *mediaTranscoder;
+
+///--------------------------------
+/// @name Synchronization Planning
+///--------------------------------
+
+/**
+ @abstract Decides how much message history is synchronized per conversation.
+ @discussion The client synchronizes the `partialHistoryMessageCount` of its
+   options for every conversation, which is the planner's minimum depth;
+   deeper history is requested from the planner after each synchronization and
+   while the user scrolls up.
+ */
+@property (nonnull, nonatomic, readonly) ATLMSynchronizationPlanner *synchronizationPlanner;
+
+/**
+ @abstract Records that the user opened the conversation and synchronizes the
+   history the planner expects the user to read.
+ */
+- (void)didOpenConversation:(nonnull LYRConversation *)conversation;
+
+/**
+ @abstract Records how far back the user has scrolled and requests older
+   messages once the user is close to the oldest synchronized message.
+ @param conversation The conversation being scrolled.
+ @param viewedDepth The number of messages from the newest one up to the oldest one on screen.
+ */
+- (void)didScrollConversation:(nonnull LYRConversation *)conversation toViewedDepth:(NSUInteger)viewedDepth;
+
+/**
+ @abstract Synchronizes deeper history for the most recently active
+   conversations, as far as the planner asks for it.
+ @discussion The conversations are queried asynchronously; calls made while
+   a query is running result in one more pass once it completes.
+ */
+- (void)applySynchronizationPlan;
+
+///---------------
+/// @name Searching
+///---------------
+
+/**
+ @abstract The full-text index over the text of messages, kept up to date from the client's object changes.
+ @discussion Only messages created after the index has been set up are indexed.
+ */
+@property (nonnull, nonatomic, readonly) ATLMMessageSearchIndex *messageSearchIndex;
+
+///----------------------------
+/// @name Conversation Rollups
+///----------------------------
+
+/**
+ @abstract The last activity, unread count and local preferences of every
+   conversation, sorted for the conversation list and kept up to date from the
+   client's object changes.
+ */
+@property (nonnull, nonatomic, readonly) ATLMConversationRollupIndex *conversationRollupIndex;
+
+/**
+ @abstract Rebuilds the conversation rollups; called once the client has authenticated.
+ @discussion The conversations are queried in pages of 100, newest first,
+   which the client runs in the background. Each page is published to the
+   index as it arrives.
+ */
+- (void)reloadConversationRollups;
+
+///----------------------------
+/// @name Conversation Events
+///----------------------------
+
+/**
+ @abstract Delivers the metadata, participant and deletion changes of
+   conversations to the controllers subscribed to them.
+ @discussion The changes are still posted as notifications as well, for
+   observers interested in every conversation.
+ */
+@property (nonnull, nonatomic, readonly) ATLMConversationEventBus *conversationEventBus;
+
+///---------------------
+/// @name Blocking Users
+///---------------------
+
+/**
+ @abstract Returns the block policy for the user in constant time.
+ @param userID The identifier of the user.
+ @return The `LYRPolicy` blocking the user or `nil` if the user isn't blocked.
+ @discussion The answer comes from an index keyed by `sentByUserID` which is
+   updated by `blockUserWithID:error:` and `unblockUserWithID:error:`. It is
+   rebuilt on the next lookup after the client reports a policy change or
+   finishes a synchronization.
+ */
+- (nullable LYRPolicy *)blockPolicyForUserID:(nonnull NSString *)userID;
+
+/**
+ @abstract Returns `YES` if the user with the supplied identifier is blocked.
+ */
+- (BOOL)isUserBlocked:(nonnull NSString *)userID;
+
+/**
+ @abstract The identifiers of all blocked users.
+ */
+@property (nonnull, nonatomic, readonly) NSSet<NSString *> *blockedUserIDs;
+
+/**
+ @abstract Adds a block policy for the user and updates the blocked user index.
+ @param userID The identifier of the user to block.
+ @param error A reference to an error object describing the failure.
+ @return `YES` if the user is blocked.
+ */
+- (BOOL)blockUserWithID:(nonnull NSString *)userID error:(NSError *_Nullable *_Nullable)error;
+
+/**
+ @abstract Removes the block policy for the user and updates the blocked user index.
+ @param userID The identifier of the user to unblock.
+ @param error A reference to an error object describing the failure.
+ @return `YES` if the user is no longer blocked.
+ */
+- (BOOL)unblockUserWithID:(nonnull NSString *)userID error:(NSError *_Nullable *_Nullable)error;
+
 @end
@@ -23,17 +23,48 @@
 #import "ATLMErrors.h"
 #import "ATLMConstants.h"
 #import "ATLMessagingUtilities.h"
+#import "ATLMRemoteNotificationCoalescer.h"
+#import "ATLMInlineReplyQueue.h"
+#import "ATLMSynchronizationPlanner.h"
+#import "ATLMOutbox.h"
+#import "ATLMMediaTranscoder.h"
+#import "ATLMMessageSearchIndex.h"
+#import "ATLMConversationRollupIndex.h"
+#import "ATLMConversationEventBus.h"
+#import "ATLMUtilities.h"
+#import "ATLMInstrumentation.h"
+#import "ATLMHangDetector.h"
 
 NSString *const ATLMConversationMetadataDidChangeNotification = @"LSConversationMetadataDidChangeNotification";
 NSString *const ATLMConversationParticipantsDidChangeNotification = @"LSConversationParticipantsDidChangeNotification";
 NSString *const ATLMConversationDeletedNotification = @"LSConversationDeletedNotification";
 NSString *const ATLMLayerControllerErrorDomain = @"ATLMLayerControllerErrorDomain";
+static NSString *const ATLMPushNotificationSoundName = @"layerbell.caf";
+static const NSUInteger ATLMSynchronizationPlanConversationLimit = 50;
+static const NSUInteger ATLMConversationRollupPageSize = 100;
 
-@interface ATLMLayerController ()
+@interface ATLMLayerController () <ATLMInlineReplyQueueDelegate, ATLMOutboxTransport>
 
 @property (nonnull, nonatomic, readwrite) id<ATLMAuthenticating> authenticationProvider;
 @property (nullable, nonatomic, readwrite) LYRClient *layerClient;
 @property (nonatomic, readwrite, copy) LYRClientOptions *layerClientOptions;
+@property (nonnull, nonatomic) ATLMRemoteNotificationCoalescer *remoteNotificationCoalescer;
+@property (nonnull, nonatomic) ATLMInlineReplyQueue *inlineReplyQueue;
+@property (nonnull, nonatomic, readwrite) ATLMSynchronizationPlanner *synchronizationPlanner;
+@property (nonnull, nonatomic, readwrite) ATLMOutbox *outbox;
+@property (nonnull, nonatomic, readwrite) ATLMMediaTranscoder *mediaTranscoder;
+@property (nonnull, nonatomic, readwrite) ATLMMessageSearchIndex *messageSearchIndex;
+@property (nonnull, nonatomic, readwrite) ATLMConversationRollupIndex *conversationRollupIndex;
+@property (nonnull, nonatomic, readwrite) ATLMConversationEventBus *conversationEventBus;
+@property (nullable, nonatomic, readwrite, copy) NSString *accountIdentifier;
+@property (nonnull, nonatomic) NSMutableDictionary *synchronizedDepthsByConversationIdentifier;
+@property (nonnull, nonatomic) NSMutableDictionary *blockPoliciesByUserID;
+@property (nullable, nonatomic) NSSet *blockedUserIDsSnapshot;
+@property (nonatomic, getter=isBlockPolicyIndexValid) BOOL blockPolicyIndexValid;
+@property (nonatomic) NSUInteger conversationRollupReloadGeneration;
+@property (nonatomic, getter=isReloadingConversationRollups) BOOL reloadingConversationRollups;
+@property (nonatomic, getter=isApplyingSynchronizationPlan) BOOL applyingSynchronizationPlan;
+@property (nonatomic) BOOL needsSynchronizationPlan;
 
 @end
 
@@ -41,16 +72,58 @@ NSString *const ATLMLayerControllerErrorDomain = @"ATLMLayerControllerErrorDomai
 
 + (nonnull instancetype)applicationControllerWithLayerAppID:(nonnull NSURL *)layerAppID clientOptions:(nullable LYRClientOptions *)clientOptions authenticationProvider:(nonnull id<ATLMAuthenticating>)authenticationProvider
 {
-    return [[self alloc] initWithLayerAppID:layerAppID clientOptions:clientOptions authenticationProvider:authenticationProvider];
+    return [[self alloc] initWithLayerAppID:layerAppID clientOptions:clientOptions authenticationProvider:authenticationProvider accountIdentifier:nil];
 }
 
-- (id)initWithLayerAppID:(nonnull NSURL *)layerAppID clientOptions:(nullable LYRClientOptions *)clientOptions authenticationProvider:(nonnull id<ATLMAuthenticating>)authenticationProvider
++ (nonnull instancetype)applicationControllerWithLayerAppID:(nonnull NSURL *)layerAppID clientOptions:(nullable LYRClientOptions *)clientOptions authenticationProvider:(nonnull id<ATLMAuthenticating>)authenticationProvider accountIdentifier:(nullable NSString *)accountIdentifier
+{
+    return [[self alloc] initWithLayerAppID:layerAppID clientOptions:clientOptions authenticationProvider:authenticationProvider accountIdentifier:accountIdentifier];
+}
+
+- (id)initWithLayerAppID:(nonnull NSURL *)layerAppID clientOptions:(nullable LYRClientOptions *)clientOptions authenticationProvider:(nonnull id<ATLMAuthenticating>)authenticationProvider accountIdentifier:(nullable NSString *)accountIdentifier
 {
     self = [super init];
     if (self) {
+        _accountIdentifier = [accountIdentifier copy];
         _layerClient = [LYRClient clientWithAppID:layerAppID delegate:self options:clientOptions];
         _layerClient.autodownloadMIMETypes = [NSSet setWithObjects:ATLMIMETypeImageJPEGPreview, ATLMIMETypeTextPlain, nil];
         _authenticationProvider = authenticationProvider;
+
+        __weak typeof(self) weakSelf = self;
+        _remoteNotificationCoalescer = [ATLMRemoteNotificationCoalescer coalescerWithSynchronizationBlock:^BOOL(NSDictionary *userInfo, ATLMRemoteNotificationCompletion completion) {
+            return [weakSelf.layerClient synchronizeWithRemoteNotification:userInfo completion:^(LYRConversation * _Nullable conversation, LYRMessage * _Nullable message, NSError * _Nullable error) {
+                // Notify the delegate once per synchronization, not once per coalesced push.
+                if (conversation || message) {
+                    [weakSelf notifyDelegateOfRemoteNotificationForConversation:conversation message:message];
+                }
+                completion(conversation, message, error);
+            }];
+        }];
+        NSString *dataDirectory = ATLMAccountDataDirectory(accountIdentifier);
+        NSString *inlineReplyPath = [dataDirectory stringByAppendingPathComponent:@"InlineReplies.plist"];
+        _inlineReplyQueue = [ATLMInlineReplyQueue queueWithPersistencePath:inlineReplyPath delegate:self];
+        NSString *outboxPath = [dataDirectory stringByAppendingPathComponent:@"Outbox.journal"];
+        _outbox = [ATLMOutbox outboxWithJournalPath:outboxPath transport:self];
+        _mediaTranscoder = [ATLMMediaTranscoder transcoder];
+        NSString *synchronizationPlanPath = [dataDirectory stringByAppendingPathComponent:@"SynchronizationPlan.plist"];
+        _synchronizationPlanner = [ATLMSynchronizationPlanner plannerWithPersistencePath:synchronizationPlanPath];
+        // The planner deepens the history the client synchronizes anyway.
+        _synchronizationPlanner.minimumDepth = MAX(_synchronizationPlanner.minimumDepth, clientOptions.partialHistoryMessageCount);
+        NSString *searchIndexDirectory = [ATLMMessageSearchIndex defaultDirectory];
+        if (accountIdentifier) {
+            searchIndexDirectory = [searchIndexDirectory stringByAppendingPathComponent:accountIdentifier];
+        }
+        _messageSearchIndex = [ATLMMessageSearchIndex indexWithDirectory:searchIndexDirectory];
+        NSString *conversationPreferencesPath = [dataDirectory stringByAppendingPathComponent:@"ConversationPreferences.plist"];
+        _conversationRollupIndex = [ATLMConversationRollupIndex indexWithPersistencePath:conversationPreferencesPath];
+        _conversationEventBus = [ATLMConversationEventBus bus];
+        _synchronizedDepthsByConversationIdentifier = [NSMutableDictionary new];
+        _blockPoliciesByUserID = [NSMutableDictionary new];
+
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didReceiveLayerClientWillBeginSynchronizationNotification:) name:LYRClientWillBeginSynchronizationNotification object:_layerClient];
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didReceiveLayerClientDidFinishSynchronizationNotification:) name:LYRClientDidFinishSynchronizationNotification object:_layerClient];
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didReceiveLayerClientDidConnectNotification:) name:LYRClientDidConnectNotification object:_layerClient];
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didReceiveLayerClientDidDisconnectNotification:) name:LYRClientDidDisconnectNotification object:_layerClient];
     }
     return self;
 }
@@ -62,21 +135,30 @@ NSString *const ATLMLayerControllerErrorDomain = @"ATLMLayerControllerErrorDomai
 
 - (void)authenticateWithCredentials:(NSDictionary *)credentials completion:(void (^)(LYRSession *session, NSError *error))completion
 {
+    // Timed from the nonce request to the identity token being accepted.
+    uint64_t start = ATLMInstrumentationBegin(ATLMMetricAuthenticationRoundTrip);
+    void (^instrumentedCompletion)(LYRSession *, NSError *) = ^(LYRSession *session, NSError *error) {
+        ATLMInstrumentationEnd(ATLMMetricAuthenticationRoundTrip, start);
+        if (!session) {
+            ATLMInstrumentationCount(ATLMMetricAuthenticationFailures);
+        }
+        completion(session, error);
+    };
     [self.layerClient requestAuthenticationNonceWithCompletion:^(NSString * _Nullable nonce, NSError * _Nullable error) {
         if (!nonce) {
-            completion(nil, error);
+            instrumentedCompletion(nil, error);
             return;
         }
         [self.authenticationProvider authenticateWithCredentials:credentials nonce:nonce completion:^(NSString * _Nonnull identityToken, NSError * _Nonnull error) {
             if (!identityToken) {
-                completion(nil, error);
+                instrumentedCompletion(nil, error);
                 return;
             }
             [self.layerClient authenticateWithIdentityToken:identityToken completion:^(LYRIdentity * _Nullable authenticatedUser, NSError * _Nullable error) {
                 if (authenticatedUser) {
-                    completion(self.layerClient.currentSession, nil);
+                    instrumentedCompletion(self.layerClient.currentSession, nil);
                 } else {
-                    completion(nil, error);
+                    instrumentedCompletion(nil, error);
                 }
             }];
         }];
@@ -96,29 +178,118 @@ NSString *const ATLMLayerControllerErrorDomain = @"ATLMLayerControllerErrorDomai
 
 - (void)handleRemoteNotification:(NSDictionary *)userInfo responseInfo:(nullable NSDictionary *)responseInfo completion:(void (^)(BOOL success, NSError *_Nullable error))completionHandler
 {
+    // Send the inline reply (if any) straight to the conversation referenced
+    // by the payload; it doesn't need to wait for the synchronization. The
+    // background task keeps the application running until the client has it.
+    NSString *replyIdentifier;
+    __block UIBackgroundTaskIdentifier replyTask = UIBackgroundTaskInvalid;
+    NSString *responseText = responseInfo[UIUserNotificationActionResponseTypedTextKey];
+    NSURL *conversationIdentifier = ATLMConversationIdentifierFromRemoteNotification(userInfo);
+    if (responseText.length && conversationIdentifier) {
+        UIApplication *application = [UIApplication sharedApplication];
+        replyTask = [application beginBackgroundTaskWithName:@"com.layer.Atlas-Messenger.inline-reply" expirationHandler:^{
+            [application endBackgroundTask:replyTask];
+            replyTask = UIBackgroundTaskInvalid;
+        }];
+        replyIdentifier = [self.inlineReplyQueue enqueueReplyText:responseText conversationIdentifier:conversationIdentifier];
+    } else if (responseInfo) {
+        NSLog(@"Failed to complete inline reply: unable to find Conversation referenced by remote notification.");
+    }
+
+    // Pushes are coalesced, so a burst of them results in a single
+    // synchronization and a single wake up of the application.
     __weak typeof(self) weakSelf = self;
-    BOOL success = [self.layerClient synchronizeWithRemoteNotification:userInfo completion:^(LYRConversation * _Nullable conversation, LYRMessage * _Nullable message, NSError * _Nullable error) {
-        if (conversation || message) {
-            // Notify the delegate the remote notification has been handled.
-            if ([weakSelf.delegate respondsToSelector:@selector(layerController:didFinishHandlingRemoteNotificationForConversation:message:responseText:)]) {
-                // Extract the response text from the responseInfo dictionary (if available).
-                NSString *responseText = responseInfo[UIUserNotificationActionResponseTypedTextKey];
-                [weakSelf.delegate layerController:weakSelf didFinishHandlingRemoteNotificationForConversation:conversation message:message responseText:responseText];
+    [self.remoteNotificationCoalescer enqueueRemoteNotification:userInfo completion:^(LYRConversation * _Nullable conversation, LYRMessage * _Nullable message, NSError * _Nullable error) {
+        if (replyIdentifier) {
+            // The conversation may have only become available with this synchronization.
+            [weakSelf.inlineReplyQueue sendPendingReplies];
+            BOOL replyPending = [weakSelf.inlineReplyQueue containsReplyWithIdentifier:replyIdentifier];
+            if (replyTask != UIBackgroundTaskInvalid) {
+                [[UIApplication sharedApplication] endBackgroundTask:replyTask];
+                replyTask = UIBackgroundTaskInvalid;
             }
-            completionHandler(YES, nil);
-        } else {
-            if (error) {
-                // In case the client hit an error during the synchronization process.
-                completionHandler(NO, error);
-            } else {
-                // In case the client didn't receive any conversations or messages.
-                completionHandler(YES, nil);
+            if (replyPending) {
+                NSMutableDictionary *errorInfo = [NSMutableDictionary dictionaryWithObject:@"The inline reply could not be sent yet, it will be retried later." forKey:NSLocalizedDescriptionKey];
+                errorInfo[NSUnderlyingErrorKey] = error;
+                NSError *replyError = [NSError errorWithDomain:ATLMLayerControllerErrorDomain code:ATLMLayerControllerErrorFailedSendingInlineReply userInfo:errorInfo];
+                completionHandler(NO, replyError);
+                return;
             }
         }
+        if (!conversation && !message && error) {
+            completionHandler(NO, error);
+        } else {
+            completionHandler(YES, nil);
+        }
     }];
-    if (!success) {
-        completionHandler(YES, nil);
+}
+
+- (void)notifyDelegateOfRemoteNotificationForConversation:(LYRConversation *)conversation message:(LYRMessage *)message
+{
+    // Notify the delegate the remote notification has been handled.
+    if ([self.delegate respondsToSelector:@selector(layerController:didFinishHandlingRemoteNotificationForConversation:message:)]) {
+        [self.delegate layerController:self didFinishHandlingRemoteNotificationForConversation:conversation message:message];
+    }
+}
+
+#pragma mark - ATLMInlineReplyQueueDelegate implementation
+
+- (BOOL)inlineReplyQueue:(ATLMInlineReplyQueue *)inlineReplyQueue sendReplyText:(NSString *)text toConversationWithIdentifier:(NSURL *)conversationIdentifier error:(NSError **)error
+{
+    LYRConversation *conversation = self.layerClient.authenticatedUser ? [self existingConversationForIdentifier:conversationIdentifier] : nil;
+    if (!conversation) {
+        if (error) {
+            *error = [NSError errorWithDomain:ATLMLayerControllerErrorDomain code:ATLMLayerControllerErrorFailedSendingInlineReply userInfo:@{ NSLocalizedDescriptionKey: @"Unable to find the Conversation referenced by the remote notification." }];
+        }
+        return NO;
+    }
+    // Handed to the client directly rather than through the outbox, so the
+    // reply only counts as sent once the client has it.
+    NSArray *messageParts = @[ [LYRMessagePart messagePartWithText:text] ];
+    LYRMessage *message = ATLMessageForParts(self.layerClient, messageParts, [self pushTextForMessageParts:messageParts], ATLMPushNotificationSoundName);
+    if (!message) {
+        if (error) {
+            *error = [NSError errorWithDomain:ATLMLayerControllerErrorDomain code:ATLMLayerControllerErrorFailedSendingInlineReply userInfo:@{ NSLocalizedDescriptionKey: @"Unable to create the inline reply message." }];
+        }
+        return NO;
+    }
+    return [conversation sendMessage:message error:error];
+}
+
+#pragma mark - ATLMOutboxTransport implementation
+
+- (BOOL)outbox:(ATLMOutbox *)outbox sendEntry:(ATLMOutboxEntry *)entry error:(NSError **)error
+{
+    LYRConversation *conversation = self.layerClient.authenticatedUser ? [self existingConversationForIdentifier:entry.conversationIdentifier] : nil;
+    if (!conversation) {
+        if (error) {
+            *error = [NSError errorWithDomain:ATLMLayerControllerErrorDomain code:ATLMLayerControllerErrorFailedSendingQueuedMessage userInfo:@{ NSLocalizedDescriptionKey: @"Unable to find the Conversation of the queued message." }];
+        }
+        return NO;
+    }
+    NSMutableArray *messageParts = [NSMutableArray arrayWithCapacity:entry.MIMETypes.count];
+    [entry.MIMETypes enumerateObjectsUsingBlock:^(NSString *MIMEType, NSUInteger index, BOOL *stop) {
+        [messageParts addObject:[LYRMessagePart messagePartWithMIMEType:MIMEType data:entry.partData[index]]];
+    }];
+    NSString *pushText = entry.pushText ?: [self pushTextForMessageParts:messageParts];
+    LYRMessage *message = ATLMessageForParts(self.layerClient, messageParts, pushText, ATLMPushNotificationSoundName);
+    if (!message) {
+        return NO;
     }
+    return [conversation sendMessage:message error:error];
+}
+
+- (BOOL)outboxCanSendEntries:(ATLMOutbox *)outbox
+{
+    // Entries restored at launch wait for the session instead of using up their attempts.
+    return self.layerClient.authenticatedUser != nil;
+}
+
+- (void)outbox:(ATLMOutbox *)outbox didDiscardEntry:(ATLMOutboxEntry *)entry error:(NSError *)error
+{
+    NSMutableDictionary *errorInfo = [NSMutableDictionary dictionaryWithObject:@"A queued message could not be sent and has been discarded." forKey:NSLocalizedDescriptionKey];
+    errorInfo[NSUnderlyingErrorKey] = error;
+    [self notifyDelegateOfError:[NSError errorWithDomain:ATLMLayerControllerErrorDomain code:ATLMLayerControllerErrorFailedSendingQueuedMessage userInfo:errorInfo]];
 }
 
 #pragma mark - LYRClientDelegate implementation
@@ -143,29 +314,63 @@ NSString *const ATLMLayerControllerErrorDomain = @"ATLMLayerControllerErrorDomai
 - (void)layerClient:(LYRClient *)client didAuthenticateAsUserID:(NSString *)userID
 {
     NSLog(@"Layer Client did authenticate as userID=%@", userID);
+    // Send the replies left over from a previous run of the application.
+    [self.inlineReplyQueue sendPendingReplies];
+    [self.outbox flush];
+    [self applySynchronizationPlan];
+    [self reloadConversationRollups];
 }
 
 - (void)layerClientDidDeauthenticate:(LYRClient *)client
 {
     NSLog(@"Layer Client did deauthenticate");
+    // Replies, messages and search results of the user who logged out must not outlive the session.
+    [self.inlineReplyQueue removeAllReplies];
+    [self.outbox removeAllEntries];
+    [self.messageSearchIndex removeAll];
+    [self invalidateBlockPolicyIndex];
+    [self.synchronizedDepthsByConversationIdentifier removeAllObjects];
+    // Pages still loading belong to the user who logged out.
+    self.conversationRollupReloadGeneration += 1;
+    self.reloadingConversationRollups = NO;
+    self.conversationRollupIndex.authenticatedUserID = nil;
+    [self.conversationRollupIndex reloadWithConversations:@[]];
 }
 
 - (void)layerClient:(LYRClient *)client objectsDidChange:(NSArray *)changes
 {
+    uint64_t start = ATLMInstrumentationBegin(ATLMMetricChangeDispatch);
+    ATLMInstrumentationRecord(ATLMMetricChangeBatchSize, changes.count);
+    [self.messageSearchIndex applyChanges:changes];
+    [self.conversationRollupIndex applyChanges:changes];
     for (LYRObjectChange *change in changes) {
+        if ([change.object isKindOfClass:[LYRPolicy class]]) {
+            [self invalidateBlockPolicyIndex];
+            continue;
+        }
+        if ([change.object isKindOfClass:[LYRMessage class]]) {
+            [self recordLocalMessageChange:change];
+            continue;
+        }
         if (![change.object isKindOfClass:[LYRConversation class]]) {
             continue;
         }
         if (change.type == LYRObjectChangeTypeUpdate && [change.property isEqualToString:@"metadata"]) {
+            [self.conversationEventBus postEventOfKind:ATLMConversationEventKindMetadataDidChange conversation:change.object];
             [[NSNotificationCenter defaultCenter] postNotificationName:ATLMConversationMetadataDidChangeNotification object:change.object];
         }
         if (change.type == LYRObjectChangeTypeUpdate && [change.property isEqualToString:@"participants"]) {
+            [self.conversationEventBus postEventOfKind:ATLMConversationEventKindParticipantsDidChange conversation:change.object];
             [[NSNotificationCenter defaultCenter] postNotificationName:ATLMConversationParticipantsDidChangeNotification object:change.object];
         }
         if (change.type == LYRObjectChangeTypeDelete) {
+            [self.synchronizationPlanner removeConversationWithIdentifier:[change.object identifier]];
+            [self.synchronizedDepthsByConversationIdentifier removeObjectForKey:[change.object identifier]];
+            [self.conversationEventBus postEventOfKind:ATLMConversationEventKindDeleted conversation:change.object];
             [[NSNotificationCenter defaultCenter] postNotificationName:ATLMConversationDeletedNotification object:change.object];
         }
     }
+    ATLMInstrumentationEnd(ATLMMetricChangeDispatch, start);
 }
 
 - (void)layerClient:(LYRClient *)client didFailOperationWithError:(NSError *)error
@@ -185,25 +390,109 @@ NSString *const ATLMLayerControllerErrorDomain = @"ATLMLayerControllerErrorDomai
     }
 }
 
+- (void)reloadConversationRollups
+{
+    if (!self.layerClient.authenticatedUser || self.isReloadingConversationRollups) {
+        return;
+    }
+    self.conversationRollupIndex.authenticatedUserID = self.layerClient.authenticatedUser.userID;
+    self.reloadingConversationRollups = YES;
+    self.conversationRollupReloadGeneration += 1;
+    [self loadConversationRollupsCreatedBefore:nil loadedIdentifiers:nil generation:self.conversationRollupReloadGeneration];
+}
+
+/**
+ @abstract Loads a page of conversations created at or before `date`.
+ @param loadedIdentifiers The identifiers of the conversations created at `date` which are already loaded.
+ */
+- (void)loadConversationRollupsCreatedBefore:(NSDate *)date loadedIdentifiers:(NSSet *)loadedIdentifiers generation:(NSUInteger)generation
+{
+    // Pages are keyed by creation date rather than offset, so conversations
+    // created or deleted during the reload don't shift the pages. Conversations
+    // created at the same time as the last one of a page are asked for again
+    // and skipped, so ties at a page boundary aren't lost.
+    LYRQuery *query = [LYRQuery queryWithQueryableClass:[LYRConversation class]];
+    if (date) {
+        query.predicate = [LYRPredicate predicateWithProperty:@"createdAt" predicateOperator:LYRPredicateOperatorIsLessThanOrEqualTo value:date];
+    }
+    query.sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"createdAt" ascending:NO] ];
+    query.limit = ATLMConversationRollupPageSize + loadedIdentifiers.count;
+    uint64_t start = ATLMInstrumentationBegin(ATLMMetricQueryExecution);
+    [self.layerClient executeQuery:query completion:^(NSOrderedSet *conversations, NSError *error) {
+        ATLMInstrumentationEnd(ATLMMetricQueryExecution, start);
+        if (generation != self.conversationRollupReloadGeneration) {
+            return;
+        }
+        if (!conversations) {
+            NSLog(@"Failed to load conversation rollups with error: %@", error);
+            self.reloadingConversationRollups = NO;
+            return;
+        }
+        NSMutableOrderedSet *newConversations = [conversations mutableCopy];
+        for (LYRConversation *conversation in conversations) {
+            if ([loadedIdentifiers containsObject:conversation.identifier]) {
+                [newConversations removeObject:conversation];
+            }
+        }
+        if (!date) {
+            [self.conversationRollupIndex reloadWithConversations:newConversations];
+        } else if (newConversations.count) {
+            [self.conversationRollupIndex updateConversations:newConversations];
+        }
+        if (conversations.count < query.limit) {
+            self.reloadingConversationRollups = NO;
+            return;
+        }
+        NSDate *lastDate = [conversations.lastObject createdAt];
+        NSMutableSet *lastDateIdentifiers = [lastDate isEqualToDate:date] ? [loadedIdentifiers mutableCopy] : [NSMutableSet new];
+        for (LYRConversation *conversation in newConversations) {
+            if ([conversation.createdAt isEqualToDate:lastDate]) {
+                [lastDateIdentifiers addObject:conversation.identifier];
+            }
+        }
+        [self loadConversationRollupsCreatedBefore:lastDate loadedIdentifiers:lastDateIdentifiers generation:generation];
+    }];
+}
+
 - (NSUInteger)countOfUnreadMessages
 {
     LYRQuery *query = [LYRQuery queryWithQueryableClass:[LYRMessage class]];
     LYRPredicate *unreadPred =[LYRPredicate predicateWithProperty:@"isUnread" predicateOperator:LYRPredicateOperatorIsEqualTo value:@(YES)];
     LYRPredicate *userPred = [LYRPredicate predicateWithProperty:@"sender.userID" predicateOperator:LYRPredicateOperatorIsNotEqualTo value:self.layerClient.authenticatedUser.userID];
     query.predicate = [LYRCompoundPredicate compoundPredicateWithType:LYRCompoundPredicateTypeAnd subpredicates:@[unreadPred, userPred]];
-    return [self.layerClient countForQuery:query error:nil];
+    return [self countForQuery:query];
 }
 
 - (NSUInteger)countOfMessages
 {
     LYRQuery *query = [LYRQuery queryWithQueryableClass:[LYRMessage class]];
-    return [self.layerClient countForQuery:query error:nil];
+    return [self countForQuery:query];
 }
 
 - (NSUInteger)countOfConversations
 {
     LYRQuery *query = [LYRQuery queryWithQueryableClass:[LYRConversation class]];
-    return [self.layerClient countForQuery:query error:nil];
+    return [self countForQuery:query];
+}
+
+- (NSOrderedSet *)executeQuery:(LYRQuery *)query
+{
+    uint64_t start = ATLMInstrumentationBegin(ATLMMetricQueryExecution);
+    [[ATLMHangDetector sharedDetector] beginOperation:ATLMMetricQueryExecution];
+    NSOrderedSet *result = [self.layerClient executeQuery:query error:nil];
+    [[ATLMHangDetector sharedDetector] endOperation:ATLMMetricQueryExecution];
+    ATLMInstrumentationEnd(ATLMMetricQueryExecution, start);
+    return result;
+}
+
+- (NSUInteger)countForQuery:(LYRQuery *)query
+{
+    uint64_t start = ATLMInstrumentationBegin(ATLMMetricQueryCount);
+    [[ATLMHangDetector sharedDetector] beginOperation:ATLMMetricQueryCount];
+    NSUInteger count = [self.layerClient countForQuery:query error:nil];
+    [[ATLMHangDetector sharedDetector] endOperation:ATLMMetricQueryCount];
+    ATLMInstrumentationEnd(ATLMMetricQueryCount, start);
+    return count;
 }
 
 - (LYRMessage *)messageForIdentifier:(NSURL *)identifier
@@ -211,7 +500,7 @@ NSString *const ATLMLayerControllerErrorDomain = @"ATLMLayerControllerErrorDomai
     LYRQuery *query = [LYRQuery queryWithQueryableClass:[LYRMessage class]];
     query.predicate = [LYRPredicate predicateWithProperty:@"identifier" predicateOperator:LYRPredicateOperatorIsEqualTo value:identifier];
     query.limit = 1;
-    return [self.layerClient executeQuery:query error:nil].firstObject;
+    return [self executeQuery:query].firstObject;
 }
 
 - (LYRConversation *)existingConversationForIdentifier:(NSURL *)identifier
@@ -219,7 +508,7 @@ NSString *const ATLMLayerControllerErrorDomain = @"ATLMLayerControllerErrorDomai
     LYRQuery *query = [LYRQuery queryWithQueryableClass:[LYRConversation class]];
     query.predicate = [LYRPredicate predicateWithProperty:@"identifier" predicateOperator:LYRPredicateOperatorIsEqualTo value:identifier];
     query.limit = 1;
-    return [self.layerClient executeQuery:query error:nil].firstObject;
+    return [self executeQuery:query].firstObject;
 }
 
 - (LYRConversation *)existingConversationForParticipants:(NSSet *)participants
@@ -227,7 +516,7 @@ NSString *const ATLMLayerControllerErrorDomain = @"ATLMLayerControllerErrorDomai
     LYRQuery *query = [LYRQuery queryWithQueryableClass:[LYRConversation class]];
     query.predicate = [LYRPredicate predicateWithProperty:@"participants" predicateOperator:LYRPredicateOperatorIsEqualTo value:participants];
     query.limit = 1;
-    return [self.layerClient executeQuery:query error:nil].firstObject;
+    return [self executeQuery:query].firstObject;
 }
 
 #pragma mark - Notification Handlers
@@ -240,6 +529,253 @@ NSString *const ATLMLayerControllerErrorDomain = @"ATLMLayerControllerErrorDomai
 - (void)didReceiveLayerClientDidFinishSynchronizationNotification:(NSNotification *)notification
 {
     [UIApplication sharedApplication].networkActivityIndicatorVisible = NO;
+    // Policies changed on other devices arrive with a synchronization.
+    [self invalidateBlockPolicyIndex];
+    [self applySynchronizationPlan];
+}
+
+- (void)didReceiveLayerClientDidConnectNotification:(NSNotification *)notification
+{
+    self.outbox.connected = YES;
+}
+
+- (void)didReceiveLayerClientDidDisconnectNotification:(NSNotification *)notification
+{
+    self.outbox.connected = NO;
+}
+
+#pragma mark - Sending
+
+- (NSString *)enqueueMessageWithParts:(NSArray *)parts pushText:(NSString *)pushText conversation:(LYRConversation *)conversation
+{
+    NSMutableArray *MIMETypes = [NSMutableArray arrayWithCapacity:parts.count];
+    NSMutableArray *partData = [NSMutableArray arrayWithCapacity:parts.count];
+    for (LYRMessagePart *part in parts) {
+        [MIMETypes addObject:part.MIMEType];
+        if (part.data) {
+            [partData addObject:part.data];
+        }
+    }
+    if (partData.count == parts.count) {
+        return [self.outbox enqueueMessageWithMIMETypes:MIMETypes partData:partData pushText:pushText conversationIdentifier:conversation.identifier];
+    }
+    // Stream backed parts, such as media, are copied to the outbox's part files first.
+    NSMutableArray *partStreams = [NSMutableArray arrayWithCapacity:parts.count];
+    for (LYRMessagePart *part in parts) {
+        NSInputStream *partStream = part.data ? [NSInputStream inputStreamWithData:part.data] : part.inputStream;
+        if (!partStream) {
+            return nil;
+        }
+        [partStreams addObject:partStream];
+    }
+    return [self.outbox enqueueMessageWithMIMETypes:MIMETypes partStreams:partStreams pushText:pushText conversationIdentifier:conversation.identifier];
+}
+
+- (NSString *)pushTextForMessageParts:(NSArray *)messageParts
+{
+    NSString *fullName = self.layerClient.authenticatedUser.displayName;
+    for (LYRMessagePart *part in messageParts) {
+        if ([part.MIMEType isEqualToString:ATLMIMETypeTextPlain]) {
+            NSString *text = [[NSString alloc] initWithData:part.data encoding:NSUTF8StringEncoding];
+            return [NSString stringWithFormat:@"%@: %@", fullName, text];
+        }
+    }
+    return [NSString stringWithFormat:@"%@ sent you a message.", fullName];
+}
+
+#pragma mark - Synchronization Planning
+
+- (void)didOpenConversation:(LYRConversation *)conversation
+{
+    [self.synchronizationPlanner recordOpenOfConversationWithIdentifier:conversation.identifier date:[NSDate date]];
+    [self.synchronizationPlanner persist];
+    [self synchronizeConversationIfNeeded:conversation];
+}
+
+- (void)didScrollConversation:(LYRConversation *)conversation toViewedDepth:(NSUInteger)viewedDepth
+{
+    NSUInteger synchronizedDepth = [self synchronizedDepthOfConversation:conversation];
+    if (synchronizedDepth >= conversation.totalNumberOfMessages) {
+        [self.synchronizationPlanner recordViewedDepth:viewedDepth forConversationWithIdentifier:conversation.identifier];
+        return;
+    }
+    NSUInteger backfillCount = [self.synchronizationPlanner backfillCountForConversationWithIdentifier:conversation.identifier viewedDepth:viewedDepth synchronizedDepth:synchronizedDepth];
+    if (backfillCount == 0) {
+        return;
+    }
+    NSError *error;
+    BOOL success = [conversation synchronizeMoreMessages:backfillCount error:&error];
+    if (!success) {
+        NSLog(@"Failed to synchronize older messages with error %@", error);
+        [self.synchronizationPlanner recordFailedSynchronizationForConversationWithIdentifier:conversation.identifier];
+    }
+}
+
+- (void)applySynchronizationPlan
+{
+    if (!self.layerClient.authenticatedUser) {
+        return;
+    }
+    // Synchronizations finishing while the query runs are folded into a single pass after it.
+    if (self.isApplyingSynchronizationPlan) {
+        self.needsSynchronizationPlan = YES;
+        return;
+    }
+    self.applyingSynchronizationPlan = YES;
+    // Conversations further down the list stay at the minimum depth until opened.
+    LYRQuery *query = [LYRQuery queryWithQueryableClass:[LYRConversation class]];
+    query.sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"lastMessage.receivedAt" ascending:NO] ];
+    query.limit = ATLMSynchronizationPlanConversationLimit;
+    [self.layerClient executeQuery:query completion:^(NSOrderedSet *conversations, NSError *error) {
+        self.applyingSynchronizationPlan = NO;
+        if (!conversations) {
+            NSLog(@"Failed to query the conversations to synchronize with error: %@", error);
+        }
+        for (LYRConversation *conversation in conversations) {
+            [self synchronizeConversationIfNeeded:conversation];
+        }
+        if (self.needsSynchronizationPlan) {
+            self.needsSynchronizationPlan = NO;
+            [self applySynchronizationPlan];
+        }
+    }];
+}
+
+- (void)synchronizeConversationIfNeeded:(LYRConversation *)conversation
+{
+    NSUInteger synchronizedDepth = [self synchronizedDepthOfConversation:conversation];
+    if (synchronizedDepth >= conversation.totalNumberOfMessages) {
+        return;
+    }
+    NSUInteger messageCount = [self.synchronizationPlanner messageCountToSynchronizeForConversationWithIdentifier:conversation.identifier lastMessageDate:conversation.lastMessage.receivedAt unreadCount:conversation.totalNumberOfUnreadMessages synchronizedDepth:synchronizedDepth date:[NSDate date]];
+    if (messageCount == 0) {
+        return;
+    }
+    NSError *error;
+    BOOL success = [conversation synchronizeMoreMessages:messageCount error:&error];
+    if (!success) {
+        NSLog(@"Failed to synchronize %lu more messages with error %@", (unsigned long)messageCount, error);
+        [self.synchronizationPlanner recordFailedSynchronizationForConversationWithIdentifier:conversation.identifier];
+    }
+}
+
+- (NSUInteger)synchronizedDepthOfConversation:(LYRConversation *)conversation
+{
+    // Counted once per conversation, then kept up to date from the object changes.
+    NSNumber *synchronizedDepth = self.synchronizedDepthsByConversationIdentifier[conversation.identifier];
+    if (!synchronizedDepth) {
+        LYRQuery *query = [LYRQuery queryWithQueryableClass:[LYRMessage class]];
+        query.predicate = [LYRPredicate predicateWithProperty:@"conversation" predicateOperator:LYRPredicateOperatorIsEqualTo value:conversation];
+        synchronizedDepth = @([self countForQuery:query]);
+        self.synchronizedDepthsByConversationIdentifier[conversation.identifier] = synchronizedDepth;
+    }
+    return synchronizedDepth.unsignedIntegerValue;
+}
+
+- (void)recordLocalMessageChange:(LYRObjectChange *)change
+{
+    LYRMessage *message = change.object;
+    NSURL *conversationIdentifier = message.conversation.identifier;
+    NSNumber *synchronizedDepth = conversationIdentifier ? self.synchronizedDepthsByConversationIdentifier[conversationIdentifier] : nil;
+    if (change.type == LYRObjectChangeTypeCreate) {
+        if (synchronizedDepth) {
+            self.synchronizedDepthsByConversationIdentifier[conversationIdentifier] = @(synchronizedDepth.unsignedIntegerValue + 1);
+        }
+        [self recordSynchronizedMessage:message];
+    } else if (change.type == LYRObjectChangeTypeDelete && synchronizedDepth.unsignedIntegerValue > 0) {
+        self.synchronizedDepthsByConversationIdentifier[conversationIdentifier] = @(synchronizedDepth.unsignedIntegerValue - 1);
+    }
+}
+
+- (void)recordSynchronizedMessage:(LYRMessage *)message
+{
+    // Messages sent from this device didn't come through synchronization.
+    if ([message.sender.userID isEqualToString:self.layerClient.authenticatedUser.userID] && !message.isSent) {
+        return;
+    }
+    unsigned long long byteCount = 0;
+    for (LYRMessagePart *part in message.parts) {
+        byteCount += part.size;
+    }
+    [self.synchronizationPlanner recordSynchronizedMessageCount:1 byteCount:byteCount forConversationWithIdentifier:message.conversation.identifier];
+}
+
+#pragma mark - Blocking Users
+
+- (LYRPolicy *)blockPolicyForUserID:(NSString *)userID
+{
+    [self revalidateBlockPolicyIndexIfNeeded];
+    return self.blockPoliciesByUserID[userID];
+}
+
+- (BOOL)isUserBlocked:(NSString *)userID
+{
+    return [self blockPolicyForUserID:userID] != nil;
+}
+
+- (NSSet *)blockedUserIDs
+{
+    [self revalidateBlockPolicyIndexIfNeeded];
+    if (!self.blockedUserIDsSnapshot) {
+        self.blockedUserIDsSnapshot = [NSSet setWithArray:self.blockPoliciesByUserID.allKeys];
+    }
+    return self.blockedUserIDsSnapshot;
+}
+
+- (BOOL)blockUserWithID:(NSString *)userID error:(NSError **)error
+{
+    if ([self isUserBlocked:userID]) {
+        return YES;
+    }
+    LYRPolicy *blockPolicy = [LYRPolicy policyWithType:LYRPolicyTypeBlock];
+    blockPolicy.sentByUserID = userID;
+    BOOL success = [self.layerClient addPolicies:[NSSet setWithObject:blockPolicy] error:error];
+    if (success) {
+        self.blockPoliciesByUserID[userID] = blockPolicy;
+        [self didUpdateBlockPolicyIndex];
+    }
+    return success;
+}
+
+- (BOOL)unblockUserWithID:(NSString *)userID error:(NSError **)error
+{
+    LYRPolicy *blockPolicy = [self blockPolicyForUserID:userID];
+    if (!blockPolicy) {
+        return YES;
+    }
+    BOOL success = [self.layerClient removePolicies:[NSSet setWithObject:blockPolicy] error:error];
+    if (success) {
+        [self.blockPoliciesByUserID removeObjectForKey:userID];
+        [self didUpdateBlockPolicyIndex];
+    }
+    return success;
+}
+
+- (void)didUpdateBlockPolicyIndex
+{
+    self.blockPolicyIndexValid = YES;
+    self.blockedUserIDsSnapshot = nil;
+}
+
+- (void)invalidateBlockPolicyIndex
+{
+    self.blockPolicyIndexValid = NO;
+}
+
+- (void)revalidateBlockPolicyIndexIfNeeded
+{
+    // The index stays valid until the client reports a policy change or
+    // finishes a synchronization, so lookups in between never scan the list.
+    if (self.isBlockPolicyIndexValid) {
+        return;
+    }
+    [self.blockPoliciesByUserID removeAllObjects];
+    for (LYRPolicy *policy in self.layerClient.policies) {
+        if (policy.type == LYRPolicyTypeBlock && policy.sentByUserID) {
+            self.blockPoliciesByUserID[policy.sentByUserID] = policy;
+        }
+    }
+    [self didUpdateBlockPolicyIndex];
 }
 
 @end
@@ -30,7 +30,8 @@
  @abstract The 'MKMapView' the 'ATLMLocationViewController' wraps.
  @discussion Note that the mapView is initialized with its parent's frame size, 
  and that 'ATLMLocationViewController' does not take ownership of its delegate.
- You can safely modify this mapView as you see fit.
+ You can safely modify this mapView as you see fit. Until the user touches the
+ map, a static snapshot is shown instead and the mapView is `nil`.
  */
 @property (nonatomic, readonly) MKMapView *mapView;
 
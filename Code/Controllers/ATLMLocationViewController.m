@@ -21,11 +21,18 @@
 #import "ATLMLocationViewController.h"
 #import <MapKit/MapKit.h>
 #import <Atlas/Atlas.h>
+#import "ATLMMessagePartDecoder.h"
+#import "ATLMMessagePartIndex.h"
+#import "ATLMLocationSnapshotRenderer.h"
+
+static const NSUInteger ATLMLocationViewControllerZoomLevel = 16;
 
 @interface ATLMLocationViewController ()
 
 @property (nonatomic) LYRMessage *message;
 @property (nonatomic) MKMapView *mapView;
+@property (nonatomic) UIImageView *snapshotView;
+@property (nonatomic) CGSize snapshotSize;
 
 @end
 
@@ -47,14 +54,13 @@
 
 - (instancetype)initWithMessage:(LYRMessage *)message
 {
-    // TODO: Consider making a LYRMessage category to more easily pull out
-    // models from their MIME Types. Example: .location, .mp4, .gif, etc.
-    LYRMessagePart *messagePart = message.parts.firstObject;
-    NSDictionary *dictionary = [NSJSONSerialization JSONObjectWithData:messagePart.data
-                                                               options:NSJSONReadingAllowFragments
-                                                                 error:nil];
-    double lat = [dictionary[ATLLocationLatitudeKey] doubleValue];
-    double lon = [dictionary[ATLLocationLongitudeKey] doubleValue];
+    LYRMessagePart *messagePart = [[ATLMMessagePartIndex indexForMessage:message] partForMIMEType:ATLMIMETypeLocation];
+    ATLMLocationPayload location = { 0, 0 };
+    if (messagePart) {
+        [[ATLMMessagePartDecoder sharedDecoder] getLocation:&location forMessagePart:messagePart];
+    }
+    double lat = location.latitude;
+    double lon = location.longitude;
     
     CLLocationCoordinate2D coordinate = CLLocationCoordinate2DMake(lat, lon);
     
@@ -71,13 +77,15 @@
     [super viewDidLoad];
     self.view.backgroundColor = [UIColor whiteColor];
     
-    // Map View
-    self.mapView = [[MKMapView alloc] initWithFrame:self.view.bounds];
-    self.mapView.autoresizingMask = UIViewAutoresizingFlexibleHeight | UIViewAutoresizingFlexibleWidth;
-    [self.view addSubview:self.mapView];
-    
-    [self setPinAtCoordinate:self.coordinate];
-    [self zoomAtCoordinate:self.coordinate delta:0.005];
+    // Snapshot View, standing in for the map until the user interacts with it
+    self.snapshotView = [[UIImageView alloc] initWithFrame:self.view.bounds];
+    self.snapshotView.autoresizingMask = UIViewAutoresizingFlexibleHeight | UIViewAutoresizingFlexibleWidth;
+    self.snapshotView.contentMode = UIViewContentModeCenter;
+    self.snapshotView.userInteractionEnabled = YES;
+    [self.snapshotView addGestureRecognizer:[[UITapGestureRecognizer alloc] initWithTarget:self action:@selector(loadMapView)]];
+    [self.snapshotView addGestureRecognizer:[[UIPanGestureRecognizer alloc] initWithTarget:self action:@selector(loadMapView)]];
+    [self.snapshotView addGestureRecognizer:[[UIPinchGestureRecognizer alloc] initWithTarget:self action:@selector(loadMapView)]];
+    [self.view addSubview:self.snapshotView];
     
     // Navigation Items
     // Only show the done button if this viewController is the root
@@ -93,6 +101,58 @@
     self.navigationItem.rightBarButtonItem = mapsButtonItem;
 }
 
+- (void)viewDidLayoutSubviews
+{
+    [super viewDidLayoutSubviews];
+    [self renderSnapshotIfNeeded];
+}
+
+#pragma mark - Snapshot
+
+- (void)renderSnapshotIfNeeded
+{
+    CGSize size = self.view.bounds.size;
+    if (self.mapView || size.width < 1 || size.height < 1 || CGSizeEqualToSize(size, self.snapshotSize)) {
+        return;
+    }
+    self.snapshotSize = size;
+    __weak typeof(self) weakSelf = self;
+    [[ATLMLocationSnapshotRenderer sharedRenderer] renderSnapshotForCoordinate:self.coordinate zoomLevel:ATLMLocationViewControllerZoomLevel size:size completion:^(UIImage *image, NSError *error) {
+        if (!image) {
+            // Without a snapshot, the map has to be shown live.
+            NSLog(@"Failed to render the location snapshot with error: %@", error);
+            [weakSelf loadMapView];
+            return;
+        }
+        // The view may have been resized while rendering.
+        if (CGSizeEqualToSize(weakSelf.snapshotSize, size)) {
+            weakSelf.snapshotView.image = image;
+        }
+    }];
+}
+
+#pragma mark - Map View
+
+- (void)loadMapView
+{
+    if (self.mapView) {
+        return;
+    }
+    self.mapView = [[MKMapView alloc] initWithFrame:self.view.bounds];
+    self.mapView.autoresizingMask = UIViewAutoresizingFlexibleHeight | UIViewAutoresizingFlexibleWidth;
+    [self.mapView setRegion:ATLMLocationSnapshotRegion(self.coordinate, ATLMLocationViewControllerZoomLevel, self.view.bounds.size) animated:NO];
+    [self setPinAtCoordinate:self.coordinate];
+    [self.view insertSubview:self.mapView belowSubview:self.snapshotView];
+
+    UIImageView *snapshotView = self.snapshotView;
+    self.snapshotView = nil;
+    [UIView animateWithDuration:0.2 animations:^{
+        snapshotView.alpha = 0;
+    } completion:^(BOOL finished) {
+        [snapshotView removeFromSuperview];
+    }];
+}
+
 - (void)setPinAtCoordinate:(CLLocationCoordinate2D)coordinate
 {
     MKPointAnnotation *annotation = [[MKPointAnnotation alloc] init];
@@ -100,16 +160,6 @@
     [self.mapView addAnnotation:annotation];
 }
 
-- (void)zoomAtCoordinate:(CLLocationCoordinate2D)coordinate delta:(CLLocationDegrees)delta
-{
-    MKCoordinateRegion mapRegion;
-    mapRegion.center = coordinate;
-    mapRegion.span.latitudeDelta = delta;
-    mapRegion.span.longitudeDelta = delta;
-    
-    [self.mapView setRegion:mapRegion animated: YES];
-}
-
 - (void)openMaps:(id)sender
 {
     MKPlacemark *placeMark = [[MKPlacemark alloc] initWithCoordinate:self.coordinate];
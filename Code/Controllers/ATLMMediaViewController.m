@@ -23,12 +23,21 @@
 #import <Atlas/Atlas.h>
 #import <AVFoundation/AVFoundation.h>
 #import <Atlas/ATLUIImageHelper.h>
+#import "ATLMMessagePartDecoder.h"
+#import "ATLMMessagePartIndex.h"
+#import "ATLMInstrumentation.h"
+#import "ATLMMemoryAccountant.h"
+#import "ATLMHangDetector.h"
+#import "ATLMProgressChannel.h"
 
 static NSTimeInterval const ATLMMediaViewControllerAnimationDuration = 0.75f;
 static NSTimeInterval const ATLMMediaViewControllerProgressBarHeight = 2.00f;
 static NSString *ATLMMediaViewControllerSymLinkedMediaTempPath = @"com.layer.atlas/media/";
 
-@interface ATLMMediaViewController () <UIScrollViewDelegate, LYRProgressDelegate>
+// The movie player's buffers are not observable; account for a typical amount.
+static const NSUInteger ATLMMediaViewControllerMoviePlayerFootprint = 16 * 1024 * 1024;
+
+@interface ATLMMediaViewController () <UIScrollViewDelegate, ATLMMemoryConsumer>
 
 @property (nonatomic) LYRMessage *message;
 @property (nonatomic) UIImage *lowResImage;
@@ -44,6 +53,8 @@ static NSString *ATLMMediaViewControllerSymLinkedMediaTempPath = @"com.layer.atl
 @property (nonatomic) BOOL zoomingEnabled;
 @property (nonatomic) BOOL viewControllerConfigured;
 @property (nonatomic) LYRMessagePart *observedMessagePart;
+@property (nonatomic) ATLMProgressSlot *downloadProgressSlot;
+@property (nonatomic) ATLMMessagePartIndex *partIndex;
 
 @end
 
@@ -54,6 +65,7 @@ static NSString *ATLMMediaViewControllerSymLinkedMediaTempPath = @"com.layer.atl
     self = [super initWithNibName:nil bundle:nil];
     if (self) {
         _message = message;
+        _partIndex = [ATLMMessagePartIndex indexForMessage:message];
     }
     return self;
 }
@@ -65,6 +77,9 @@ static NSString *ATLMMediaViewControllerSymLinkedMediaTempPath = @"com.layer.atl
     if (self.observedMessagePart) {
         [self.observedMessagePart removeObserver:self forKeyPath:@"transferStatus"];
     }
+    if (self.downloadProgressSlot) {
+        [[ATLMProgressChannel sharedChannel] removeSlot:self.downloadProgressSlot];
+    }
 }
 
 - (void)viewDidLoad
@@ -109,10 +124,10 @@ static NSString *ATLMMediaViewControllerSymLinkedMediaTempPath = @"com.layer.atl
         self.navigationItem.leftBarButtonItem = doneButtonItem;
     }
     
-    if (ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageJPEG) || ATLMessagePartForMIMEType(self.message, ATLMIMETypeImagePNG) || ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageGIF)) {
+    if ([self.partIndex partForMIMEType:ATLMIMETypeImageJPEG] || [self.partIndex partForMIMEType:ATLMIMETypeImagePNG] || [self.partIndex partForMIMEType:ATLMIMETypeImageGIF]) {
         self.title = @"Image";
         self.zoomingEnabled = YES;
-    } else if (ATLMessagePartForMIMEType(self.message, ATLMIMETypeVideoMP4)) {
+    } else if ([self.partIndex partForMIMEType:ATLMIMETypeVideoMP4]) {
         self.title = @"Video";
         self.zoomingEnabled = NO;
         NSArray *paths = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES);
@@ -128,6 +143,7 @@ static NSString *ATLMMediaViewControllerSymLinkedMediaTempPath = @"com.layer.atl
     self.scrollView.panGestureRecognizer.enabled = self.zoomingEnabled;
     
     self.viewControllerConfigured = NO;
+    [[ATLMMemoryAccountant sharedAccountant] registerConsumer:self];
 }
 
 - (void)viewWillAppear:(BOOL)animated
@@ -155,6 +171,17 @@ static NSString *ATLMMediaViewControllerSymLinkedMediaTempPath = @"com.layer.atl
     [self.progressView removeFromSuperview];
 }
 
+- (void)viewDidDisappear:(BOOL)animated
+{
+    [super viewDidDisappear:animated];
+    if (self.isMovingFromParentViewController || self.isBeingDismissed || self.navigationController.isBeingDismissed) {
+        // The controller is going away; don't wait for it to be deallocated to free the media.
+        [self releaseMemory];
+    }
+    // Now offscreen, the media can be reclaimed when the budget is exceeded.
+    [self reportMemoryFootprint];
+}
+
 - (void)viewDidLayoutSubviews
 {
     [super viewDidLayoutSubviews];
@@ -210,16 +237,7 @@ static NSString *ATLMMediaViewControllerSymLinkedMediaTempPath = @"com.layer.atl
 
 - (void)share:(id)sender
 {
-    LYRMessagePart *fullResMediaMessagePart;
-    if (ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageGIF)) {
-        fullResMediaMessagePart = ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageGIF);
-    } else if (ATLMessagePartForMIMEType(self.message, ATLMIMETypeImagePNG)) {
-        fullResMediaMessagePart = ATLMessagePartForMIMEType(self.message, ATLMIMETypeImagePNG);
-    } else if (ATLMessagePartForMIMEType(self.message, ATLMIMETypeVideoMP4)) {
-        fullResMediaMessagePart = ATLMessagePartForMIMEType(self.message, ATLMIMETypeVideoMP4);
-    } else if (ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageJPEG)) {
-        fullResMediaMessagePart = ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageJPEG);
-    }
+    LYRMessagePart *fullResMediaMessagePart = self.partIndex.renderableMediaPart;
     UIActivityViewController *activityViewController = [[UIActivityViewController alloc] initWithActivityItems:@[fullResMediaMessagePart.fileURL] applicationActivities:nil];
     [self presentViewController:activityViewController animated:YES completion:nil];
 }
@@ -236,57 +254,108 @@ static NSString *ATLMMediaViewControllerSymLinkedMediaTempPath = @"com.layer.atl
     if (self.moviePlayerController) {
         [self.moviePlayerController pause];
     }
+    [self reportMemoryFootprint];
     [self.navigationController dismissViewControllerAnimated:YES completion:nil];
 }
 
+#pragma mark - ATLMMemoryConsumer
+
+- (NSUInteger)memoryFootprint
+{
+    NSUInteger footprint = ATLMMemoryFootprintOfImage(self.lowResImage) + ATLMMemoryFootprintOfImage(self.fullResImage);
+    if (self.moviePlayerController) {
+        footprint += ATLMMediaViewControllerMoviePlayerFootprint;
+    }
+    return footprint;
+}
+
+- (NSString *)memoryCategory
+{
+    return ATLMMemoryCategoryImages;
+}
+
+- (ATLMMemoryPriority)memoryPriority
+{
+    return (self.isViewLoaded && self.view.window) ? ATLMMemoryPriorityVisible : ATLMMemoryPriorityOffscreen;
+}
+
+- (NSUInteger)releaseMemory
+{
+    NSUInteger footprint = self.memoryFootprint;
+    if (self.memoryPriority != ATLMMemoryPriorityVisible) {
+        // On screen, fall back to the preview rather than going blank.
+        self.lowResImage = nil;
+        self.lowResImageView.image = nil;
+    }
+    self.fullResImage = nil;
+    self.fullResImageView.image = nil;
+    self.fullResImageView.alpha = 0.0f;
+    if (self.moviePlayerController) {
+        [self.moviePlayerController stop];
+        [self.moviePlayerController.view removeFromSuperview];
+        [[NSNotificationCenter defaultCenter] removeObserver:self name:MPMoviePlayerLoadStateDidChangeNotification object:nil];
+        [[NSNotificationCenter defaultCenter] removeObserver:self name:MPMoviePlayerWillEnterFullscreenNotification object:nil];
+        [[NSNotificationCenter defaultCenter] removeObserver:self name:MPMoviePlayerWillExitFullscreenNotification object:nil];
+        self.moviePlayerController = nil;
+    }
+    // Decode the media again the next time the view appears.
+    self.viewControllerConfigured = NO;
+    return footprint - self.memoryFootprint;
+}
+
+- (void)reportMemoryFootprint
+{
+    [[ATLMMemoryAccountant sharedAccountant] consumerDidChangeFootprint:self];
+}
+
 #pragma mark - Helpers
 
 - (void)loadLowResMedia
 {
-    if (ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageGIFPreview) || ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageGIF)) {
+    if ([self.partIndex partForMIMEType:ATLMIMETypeImageGIFPreview] || [self.partIndex partForMIMEType:ATLMIMETypeImageGIF]) {
         [self loadLowResGIFs];
-    } else if (ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageJPEGPreview) && !ATLMessagePartForMIMEType(self.message, ATLMIMETypeVideoMP4)) {
+    } else if ([self.partIndex partForMIMEType:ATLMIMETypeImageJPEGPreview] && ![self.partIndex partForMIMEType:ATLMIMETypeVideoMP4]) {
         [self loadLowResImages];
-    } else if (ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageJPEGPreview) && ATLMessagePartForMIMEType(self.message, ATLMIMETypeVideoMP4)) {
+    } else if ([self.partIndex partForMIMEType:ATLMIMETypeImageJPEGPreview] && [self.partIndex partForMIMEType:ATLMIMETypeVideoMP4]) {
         [self loadLowResImages];
     }
 }
 
 - (void)loadFullResMedia
 {
-    if (ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageGIF)) {
-        [self downloadFullResMediaForMIMEType:ATLMIMETypeImageGIF];
-    } else if (ATLMessagePartForMIMEType(self.message, ATLMIMETypeImagePNG)) {
-        [self downloadFullResMediaForMIMEType:ATLMIMETypeImagePNG];
-    } else if (ATLMessagePartForMIMEType(self.message, ATLMIMETypeVideoMP4)) {
-        [self downloadFullResMediaForMIMEType:ATLMIMETypeVideoMP4];
-    } else if (ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageJPEG)) {
-        [self downloadFullResMediaForMIMEType:ATLMIMETypeImageJPEG];
+    LYRMessagePart *fullResMediaMessagePart = self.partIndex.renderableMediaPart;
+    if (fullResMediaMessagePart) {
+        [self downloadFullResMediaForMIMEType:fullResMediaMessagePart.MIMEType];
     }
 }
 
 - (void)loadLowResImages
 {
-    LYRMessagePart *lowResImagePart = ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageJPEGPreview);
-    LYRMessagePart *imageInfoPart = ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageSize);
+    LYRMessagePart *lowResImagePart = [self.partIndex partForMIMEType:ATLMIMETypeImageJPEGPreview];
+    LYRMessagePart *imageInfoPart = [self.partIndex partForMIMEType:ATLMIMETypeImageSize];
     if (!lowResImagePart) {
         // Default back to image/jpeg MIMEType
-        lowResImagePart = ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageJPEG);
+        lowResImagePart = [self.partIndex partForMIMEType:ATLMIMETypeImageJPEG];
     }
     
     // Retrieve low-res image from message part
     if (!(lowResImagePart.transferStatus == LYRContentTransferReadyForDownload || lowResImagePart.transferStatus == LYRContentTransferDownloading)) {
+        uint64_t start = ATLMInstrumentationBegin(ATLMMetricMediaDecode);
+        [[ATLMHangDetector sharedDetector] beginOperation:ATLMMetricMediaDecode];
         if (lowResImagePart.fileURL) {
             self.lowResImage = [UIImage imageWithContentsOfFile:lowResImagePart.fileURL.path];
         } else {
             self.lowResImage = [UIImage imageWithData:lowResImagePart.data];
         }
+        [[ATLMHangDetector sharedDetector] endOperation:ATLMMetricMediaDecode];
+        ATLMInstrumentationEnd(ATLMMetricMediaDecode, start);
         self.lowResImageView.image = self.lowResImage;
     }
     
     // Set the size of the canvas.
-    if (imageInfoPart) {
-        self.fullResImageSize = ATLImageSizeForJSONData(imageInfoPart.data);
+    ATLMImageSizePayload imageSize;
+    if (imageInfoPart && [[ATLMMessagePartDecoder sharedDecoder] getImageSize:&imageSize forMessagePart:imageInfoPart]) {
+        self.fullResImageSize = imageSize.size;
     } else {
         if (self.lowResImage) {
             self.fullResImageSize = self.lowResImage.size;
@@ -299,15 +368,16 @@ static NSString *ATLMMediaViewControllerSymLinkedMediaTempPath = @"com.layer.atl
     self.mediaViewFrame = CGRectMake(0, 0, self.fullResImageSize.width, self.fullResImageSize.height);
     self.lowResImageView.frame = self.mediaViewFrame;
     [self viewDidLayoutSubviews];
+    [self reportMemoryFootprint];
 }
 
 - (void)loadLowResGIFs
 {
-    LYRMessagePart *lowResImagePart = ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageGIFPreview);
-    LYRMessagePart *imageInfoPart = ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageSize);
+    LYRMessagePart *lowResImagePart = [self.partIndex partForMIMEType:ATLMIMETypeImageGIFPreview];
+    LYRMessagePart *imageInfoPart = [self.partIndex partForMIMEType:ATLMIMETypeImageSize];
     
     if (!lowResImagePart) {
-        lowResImagePart = ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageGIF);
+        lowResImagePart = [self.partIndex partForMIMEType:ATLMIMETypeImageGIF];
     }
     
     // Retrieve low-res gif from message part
@@ -321,8 +391,9 @@ static NSString *ATLMMediaViewControllerSymLinkedMediaTempPath = @"com.layer.atl
     }
     
     // Set the size of the canvas.
-    if (imageInfoPart) {
-        self.fullResImageSize = ATLImageSizeForJSONData(imageInfoPart.data);
+    ATLMImageSizePayload imageSize;
+    if (imageInfoPart && [[ATLMMessagePartDecoder sharedDecoder] getImageSize:&imageSize forMessagePart:imageInfoPart]) {
+        self.fullResImageSize = imageSize.size;
     } else {
         if (self.lowResImage) {
             self.fullResImageSize = self.lowResImage.size;
@@ -335,22 +406,27 @@ static NSString *ATLMMediaViewControllerSymLinkedMediaTempPath = @"com.layer.atl
     self.mediaViewFrame = CGRectMake(0, 0, self.fullResImageSize.width, self.fullResImageSize.height);
     self.lowResImageView.frame = self.mediaViewFrame;
     [self viewDidLayoutSubviews];
+    [self reportMemoryFootprint];
 }
 
 - (void)loadFullResImage
 {
-    LYRMessagePart *fullResImagePart = ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageJPEG);
+    LYRMessagePart *fullResImagePart = [self.partIndex partForMIMEType:ATLMIMETypeImageJPEG];
     if (!fullResImagePart) {
-        fullResImagePart = ATLMessagePartForMIMEType(self.message, ATLMIMETypeImagePNG);
+        fullResImagePart = [self.partIndex partForMIMEType:ATLMIMETypeImagePNG];
     }
     
     // Retrieve hi-res image from message part
     if (!(fullResImagePart.transferStatus == LYRContentTransferReadyForDownload || fullResImagePart.transferStatus == LYRContentTransferDownloading)) {
+        uint64_t start = ATLMInstrumentationBegin(ATLMMetricMediaDecode);
+        [[ATLMHangDetector sharedDetector] beginOperation:ATLMMetricMediaDecode];
         if (fullResImagePart.fileURL) {
             self.fullResImage = [UIImage imageWithContentsOfFile:fullResImagePart.fileURL.path];
         } else {
             self.fullResImage = [UIImage imageWithData:fullResImagePart.data];
         }
+        [[ATLMHangDetector sharedDetector] endOperation:ATLMMetricMediaDecode];
+        ATLMInstrumentationEnd(ATLMMetricMediaDecode, start);
         
         self.fullResImageView.image = self.fullResImage;
         
@@ -372,11 +448,12 @@ static NSString *ATLMMediaViewControllerSymLinkedMediaTempPath = @"com.layer.atl
         self.navigationItem.rightBarButtonItem.enabled = YES;
     }];
     [self viewDidLayoutSubviews];
+    [self reportMemoryFootprint];
 }
 
 - (void)loadFullResGIFs
 {
-    LYRMessagePart *fullResImagePart = ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageGIF);
+    LYRMessagePart *fullResImagePart = [self.partIndex partForMIMEType:ATLMIMETypeImageGIF];
     
     // Retrieve hi-res gif from message part
     if (!(fullResImagePart.transferStatus == LYRContentTransferReadyForDownload || fullResImagePart.transferStatus == LYRContentTransferDownloading)) {
@@ -406,11 +483,12 @@ static NSString *ATLMMediaViewControllerSymLinkedMediaTempPath = @"com.layer.atl
         self.navigationItem.rightBarButtonItem.enabled = YES;
     }];
     [self viewDidLayoutSubviews];
+    [self reportMemoryFootprint];
 }
 
 - (void)loadFullResVideo
 {
-    LYRMessagePart *fullResVideoPart = ATLMessagePartForMIMEType(self.message, ATLMIMETypeVideoMP4);
+    LYRMessagePart *fullResVideoPart = [self.partIndex partForMIMEType:ATLMIMETypeVideoMP4];
     
     // Retrieve hi-res image from message part
     if (!(fullResVideoPart.transferStatus == LYRContentTransferReadyForDownload || fullResVideoPart.transferStatus == LYRContentTransferDownloading)) {
@@ -435,6 +513,7 @@ static NSString *ATLMMediaViewControllerSymLinkedMediaTempPath = @"com.layer.atl
     }
 
     [self viewDidLayoutSubviews];
+    [self reportMemoryFootprint];
 }
 
 - (void)moviePlayerStateDidChange:(NSNotification *)notification
@@ -465,16 +544,27 @@ static NSString *ATLMMediaViewControllerSymLinkedMediaTempPath = @"com.layer.atl
 
 - (void)downloadFullResMediaForMIMEType:(NSString *)MIMEType
 {
-    LYRMessagePart *fullResMedia = ATLMessagePartForMIMEType(self.message, MIMEType);
+    LYRMessagePart *fullResMedia = [self.partIndex partForMIMEType:MIMEType];
     
     if (fullResMedia && (fullResMedia.transferStatus == LYRContentTransferReadyForDownload || fullResMedia.transferStatus == LYRContentTransferDownloading)) {
+        if (self.observedMessagePart == fullResMedia) {
+            // Still downloading since before the media was released; the observer loads it.
+            return;
+        }
         NSError *error;
         LYRProgress *downloadProgress = [fullResMedia downloadContent:&error];
         if (!downloadProgress) {
             NSLog(@"problem downloading full resolution photo with %@", error);
             return;
         }
-        downloadProgress.delegate = self;
+        __weak typeof(self) weakSelf = self;
+        self.downloadProgressSlot = [[ATLMProgressChannel sharedChannel] slotObservingProgress:downloadProgress handler:^(double fractionCompleted, BOOL finished) {
+            [weakSelf.progressView setProgress:fractionCompleted animated:YES];
+            if (finished) {
+                weakSelf.downloadProgressSlot = nil;
+                [weakSelf fullResMediaDidDownload];
+            }
+        }];
         [fullResMedia addObserver:self forKeyPath:@"transferStatus" options:NSKeyValueObservingOptionNew context:nil];
         self.observedMessagePart = fullResMedia;
         if ([@[ATLMIMETypeImageJPEG, ATLMIMETypeImagePNG, ATLMIMETypeImageGIF] containsObject:MIMEType]) {
@@ -559,34 +649,33 @@ static NSString *ATLMMediaViewControllerSymLinkedMediaTempPath = @"com.layer.atl
     }
 }
 
-#pragma mark - LYRProgress Delegate Implementation
-
-- (void)progressDidChange:(LYRProgress *)progress
+- (void)fullResMediaDidDownload
 {
-    // Queue UI updates onto the main thread, since LYRProgress performs
-    // delegate callbacks from a background thread.
-    dispatch_async(dispatch_get_main_queue(), ^{
-        [self.progressView setProgress:progress.fractionCompleted animated:YES];
-    });
+    if (!self.isViewLoaded || !self.view.window) {
+        // Finished off screen, possibly after the media was released; decode it the next time the view appears.
+        self.viewControllerConfigured = NO;
+        return;
+    }
+    if ([self.partIndex partForMIMEType:ATLMIMETypeImageGIF]) {
+        self.title = @"GIF Downloaded";
+    } else if ([self.partIndex partForMIMEType:ATLMIMETypeVideoMP4]) {
+        self.title = @"Video Downloaded";
+    } else if ([self.partIndex partForMIMEType:ATLMIMETypeImageJPEG] || [self.partIndex partForMIMEType:ATLMIMETypeImagePNG]) {
+        self.title = @"Image Downloaded";
+    } else {
+        self.title = @"Downloaded";
+    }
+    [self loadFullResMedia];
 }
 
 #pragma mark - LYRMessagePart.transferStatus KVO notifications
 
 - (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(LYRMessagePart *)messagePart change:(NSDictionary *)change context:(void *)context
 {
+    // Progress and completion both travel through the progress channel, which
+    // delivers them on the next frame instead of hopping to the main queue here.
     if (messagePart.transferStatus == LYRContentTransferComplete) {
-        dispatch_async(dispatch_get_main_queue(), ^{
-            if (ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageGIF)) {
-                self.title = @"GIF Downloaded";
-            } else if (ATLMessagePartForMIMEType(self.message, ATLMIMETypeVideoMP4)) {
-                self.title = @"Video Downloaded";
-            } else if (ATLMessagePartForMIMEType(self.message, ATLMIMETypeImageJPEG) || ATLMessagePartForMIMEType(self.message, ATLMIMETypeImagePNG)) {
-                self.title = @"Image Downloaded";
-            } else {
-                self.title = @"Downloaded";
-            }
-            [self loadFullResMedia];
-        });
+        [self.downloadProgressSlot finish];
     }
 }
 
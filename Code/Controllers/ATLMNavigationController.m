@@ -19,10 +19,10 @@
 //
 
 #import "ATLMNavigationController.h"
+#import "ATLMUIWorkScheduler.h"
 
 @interface ATLMNavigationController () <UINavigationControllerDelegate>
 
-@property (nonatomic) NSMutableArray *animationCompletionHandlers;
 @property (nonatomic, getter=isAnimating) BOOL animating;
 
 @end
@@ -34,11 +34,26 @@
     self = [super initWithNibName:nibNameOrNil bundle:nibBundleOrNil];
     if (self) {
         self.delegate = self;
-        _animationCompletionHandlers = [NSMutableArray new];
     }
     return self;
 }
 
+- (instancetype)initWithRootViewController:(UIViewController *)rootViewController
+{
+    // Not every version of UIKit routes this through the designated initializer.
+    self = [super initWithRootViewController:rootViewController];
+    if (self) {
+        self.delegate = self;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    // Popped or dismissed mid transition, didShowViewController: never comes.
+    if (_animating) [[ATLMUIWorkScheduler sharedScheduler] endDeferringForReason:ATLMUIWorkDeferralReasonNavigationTransition];
+}
+
 - (void)setDelegate:(id<UINavigationControllerDelegate>)delegate
 {
     if (delegate != self) [NSException raise:NSInternalInconsistencyException format:@"LSNavigationController must act as its own delegate."];
@@ -54,7 +69,20 @@
         return;
     }
 
-    [self.animationCompletionHandlers addObject:[handler copy]];
+    // Handlers run a few per frame once the transition has finished instead of all at once.
+    [[ATLMUIWorkScheduler sharedScheduler] scheduleWorkWithPriority:ATLMUIWorkPriorityHigh coalescingKey:nil block:handler];
+}
+
+- (void)setAnimating:(BOOL)animating
+{
+    if (animating == _animating) return;
+
+    _animating = animating;
+    if (animating) {
+        [[ATLMUIWorkScheduler sharedScheduler] beginDeferringForReason:ATLMUIWorkDeferralReasonNavigationTransition];
+    } else {
+        [[ATLMUIWorkScheduler sharedScheduler] endDeferringForReason:ATLMUIWorkDeferralReasonNavigationTransition];
+    }
 }
 
 #pragma mark - UINavigationControllerDelegate
@@ -67,25 +95,12 @@
     [[self transitionCoordinator] animateAlongsideTransition:nil completion:^(id<UIViewControllerTransitionCoordinatorContext> context) {
         if (![context isCancelled]) return;
         self.animating = NO;
-        [self notifyAnimationCompletionHandlers];
     }];
 }
 
 - (void)navigationController:(UINavigationController *)navigationController didShowViewController:(UIViewController *)viewController animated:(BOOL)animated
 {
     self.animating = NO;
-    [self notifyAnimationCompletionHandlers];
-}
-
-#pragma mark - Helpers
-
-- (void)notifyAnimationCompletionHandlers
-{
-    while (!self.isAnimating && self.animationCompletionHandlers.count > 0) {
-        void (^handler)() = self.animationCompletionHandlers.firstObject;
-        [self.animationCompletionHandlers removeObjectAtIndex:0];
-        handler();
-    }
 }
 
 @end
@@ -25,9 +25,12 @@
 #import "ATLMCenterTextTableViewCell.h"
 #import "ATLMStyleValue1TableViewCell.h"
 #import "ATLLogoView.h"
+#import "ATLMInstrumentation.h"
+#import "ATLMHangDetector.h"
 
 typedef NS_ENUM(NSInteger, ATLMSettingsTableSection) {
     ATLMSettingsTableSectionInfo,
+    ATLMSettingsTableSectionDiagnostics,
     ATLMSettingsTableSectionLegal,
     ATLMSettingsTableSectionLogout,
     ATLMSettingsTableSectionCount,
@@ -40,6 +43,12 @@ typedef NS_ENUM(NSInteger, ATLMInfoTableRow) {
     ATLMInfoTableRowCount,
 };
 
+typedef NS_ENUM(NSInteger, ATLMLogoutTableRow) {
+    ATLMLogoutTableRowSwitchAccount,
+    ATLMLogoutTableRowLogOut,
+    ATLMLogoutTableRowCount,
+};
+
 typedef NS_ENUM(NSInteger, ATLMLegalTableRow) {
     ATLMLegalTableRowAttribution,
     ATLMLegalTableRowTerms,
@@ -51,6 +60,9 @@ typedef NS_ENUM(NSInteger, ATLMLegalTableRow) {
 
 @property (nonatomic) ATLMSettingsHeaderView *headerView;
 @property (nonatomic) ATLLogoView *logoView;
+@property (nonatomic) NSArray<NSString *> *histogramNames;
+@property (nonatomic) NSArray<NSString *> *counterNames;
+@property (nonatomic) NSDictionary *metricsSnapshot;
 
 @end
 
@@ -146,6 +158,12 @@ NSString *const ATLMConnecting = @"Connecting";
     [self registerNotificationObservers];
 }
 
+- (void)viewWillAppear:(BOOL)animated
+{
+    [super viewWillAppear:animated];
+    [self reloadMetrics];
+}
+
 - (void)dealloc
 {
     [[NSNotificationCenter defaultCenter] removeObserver:self];
@@ -164,11 +182,15 @@ NSString *const ATLMConnecting = @"Connecting";
         case ATLMSettingsTableSectionInfo:
             return ATLMInfoTableRowCount;
             
+        case ATLMSettingsTableSectionDiagnostics:
+            // One row per metric, followed by the export row.
+            return self.histogramNames.count + self.counterNames.count + 1;
+            
         case ATLMSettingsTableSectionLegal:
             return ATLMLegalTableRowCount;
             
         case ATLMSettingsTableSectionLogout:
-            return 1;
+            return ATLMLogoutTableRowCount;
     }
     return 0;
 }
@@ -201,6 +223,9 @@ NSString *const ATLMConnecting = @"Connecting";
             return cell;
         }
             
+        case ATLMSettingsTableSectionDiagnostics:
+            return [self diagnosticsCellForIndexPath:indexPath];
+            
         case ATLMSettingsTableSectionLegal: {
             UITableViewCell *cell = [self defaultCellForIndexPath:indexPath];
             switch (indexPath.row) {
@@ -220,8 +245,13 @@ NSString *const ATLMConnecting = @"Connecting";
             
         case ATLMSettingsTableSectionLogout: {
             ATLMCenterTextTableViewCell *centerCell = [self.tableView dequeueReusableCellWithIdentifier:ATLMCenterTextCellIdentifier forIndexPath:indexPath];
-            centerCell.centerTextLabel.text = @"Log Out";
-            centerCell.centerTextLabel.textColor = ATLRedColor();
+            if (indexPath.row == ATLMLogoutTableRowSwitchAccount) {
+                centerCell.centerTextLabel.text = @"Switch Account";
+                centerCell.centerTextLabel.textColor = ATLBlueColor();
+            } else {
+                centerCell.centerTextLabel.text = @"Log Out";
+                centerCell.centerTextLabel.textColor = ATLRedColor();
+            }
             return centerCell;
         }
 
@@ -237,6 +267,9 @@ NSString *const ATLMConnecting = @"Connecting";
         case ATLMSettingsTableSectionInfo:
             return @"Info";
 
+        case ATLMSettingsTableSectionDiagnostics:
+            return @"Diagnostics";
+
         case ATLMSettingsTableSectionLegal:
             return @"Legal";
 
@@ -275,17 +308,57 @@ NSString *const ATLMConnecting = @"Connecting";
     return cell;
 }
 
+- (UITableViewCell *)diagnosticsCellForIndexPath:(NSIndexPath *)indexPath
+{
+    NSUInteger row = indexPath.row;
+    if (row == self.histogramNames.count + self.counterNames.count) {
+        ATLMCenterTextTableViewCell *centerCell = [self.tableView dequeueReusableCellWithIdentifier:ATLMCenterTextCellIdentifier forIndexPath:indexPath];
+        centerCell.centerTextLabel.text = @"Export Metrics";
+        centerCell.centerTextLabel.textColor = ATLBlueColor();
+        return centerCell;
+    }
+    UITableViewCell *cell = [self defaultCellForIndexPath:indexPath];
+    cell.detailTextLabel.font = [UIFont systemFontOfSize:12];
+    if (row < self.histogramNames.count) {
+        NSString *name = self.histogramNames[row];
+        NSDictionary *histogram = self.metricsSnapshot[@"histograms"][name];
+        BOOL interval = [histogram[ATLMMetricUnitKey] isEqualToString:@"us"];
+        NSString *format = interval ? @"p50 %.2f  p95 %.2f  p99 %.2f ms (%@)" : @"p50 %.0f  p95 %.0f  p99 %.0f (%@)";
+        double scale = interval ? 1000.0 : 1.0; // Intervals are recorded in microseconds.
+        cell.textLabel.text = name;
+        cell.detailTextLabel.text = [NSString stringWithFormat:format,
+                                     [histogram[ATLMMetricP50Key] doubleValue] / scale,
+                                     [histogram[ATLMMetricP95Key] doubleValue] / scale,
+                                     [histogram[ATLMMetricP99Key] doubleValue] / scale,
+                                     histogram[ATLMMetricCountKey]];
+    } else {
+        NSString *name = self.counterNames[row - self.histogramNames.count];
+        cell.textLabel.text = name;
+        cell.detailTextLabel.text = [self.metricsSnapshot[@"counters"][name] stringValue];
+    }
+    return cell;
+}
+
 #pragma mark - UITableViewDelegate
 
 - (void)tableView:(UITableView *)tableView didSelectRowAtIndexPath:(NSIndexPath *)indexPath
 {
     switch (indexPath.section) {
         case ATLMSettingsTableSectionLogout:
-            [self logOut];
+            if (indexPath.row == ATLMLogoutTableRowSwitchAccount) {
+                [self.settingsDelegate switchUserTappedInSettingsViewController:self];
+            } else {
+                [self logOut];
+            }
             break;
         case ATLMSettingsTableSectionLegal:
             [self legalRowTapped:indexPath.row];
             break;
+        case ATLMSettingsTableSectionDiagnostics:
+            if ((NSUInteger)indexPath.row == self.histogramNames.count + self.counterNames.count) {
+                [self exportMetrics];
+            }
+            break;
         default:
             break;
     }
@@ -322,6 +395,33 @@ NSString *const ATLMConnecting = @"Connecting";
     }
 }
 
+- (void)exportMetrics
+{
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"AtlasMessengerMetrics.json"];
+    NSError *error;
+    if (![[[ATLMInstrumentation sharedInstrumentation] JSONSnapshot] writeToFile:path options:NSDataWritingAtomic error:&error]) {
+        [SVProgressHUD showErrorWithStatus:error.localizedDescription];
+        return;
+    }
+    NSString *hangsPath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"AtlasMessengerHangs.json"];
+    if (![[[ATLMHangDetector sharedDetector] JSONSnapshot] writeToFile:hangsPath options:NSDataWritingAtomic error:&error]) {
+        [SVProgressHUD showErrorWithStatus:error.localizedDescription];
+        return;
+    }
+    UIActivityViewController *activityViewController = [[UIActivityViewController alloc] initWithActivityItems:@[ [NSURL fileURLWithPath:path], [NSURL fileURLWithPath:hangsPath] ] applicationActivities:nil];
+    [self presentViewController:activityViewController animated:YES completion:nil];
+}
+
+#pragma mark - Diagnostics
+
+- (void)reloadMetrics
+{
+    self.metricsSnapshot = [[ATLMInstrumentation sharedInstrumentation] snapshot];
+    self.histogramNames = [[self.metricsSnapshot[@"histograms"] allKeys] sortedArrayUsingSelector:@selector(compare:)];
+    self.counterNames = [[self.metricsSnapshot[@"counters"] allKeys] sortedArrayUsingSelector:@selector(compare:)];
+    [self.tableView reloadData];
+}
+
 # pragma mark - Layer Connection State Monitoring
 
 - (void)registerNotificationObservers
@@ -0,0 +1,150 @@
+//
+//  ATLMAvatarImagePipeline.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <UIKit/UIKit.h>
+#import "ATLMMemoryAccountant.h"
+
+@class ATLMDiskLRUCache;
+
+/**
+ @abstract Decodes image data into a circular, fully decoded image of the
+   supplied diameter, filling the circle with the center of the image.
+ @param data The data of an image in any format ImageIO reads.
+ @param diameter The diameter of the image in points.
+ @param scale The scale of the screen the image is displayed on.
+ @return The image or `nil` if the data is not an image.
+ */
+extern UIImage *_Nullable ATLMAvatarImageRoundedFromData(NSData *_Nonnull data, CGFloat diameter, CGFloat scale);
+
+typedef void (^ATLMAvatarImageCompletion)(UIImage *_Nullable image, NSError *_Nullable error);
+
+/**
+ @abstract The `ATLMAvatarImagePipeline` fetches avatar images, rounds them
+   at the size they are displayed at and caches the result.
+ @discussion Images are keyed by URL and diameter. A lookup goes through a
+   memory tier, which keeps the most recently used images up to
+   `memoryByteLimit`, then a disk tier keeping the rounded images as PNG
+   files, then the network. Requests for a URL whose download is in flight
+   join it rather than downloading it again, whatever their diameter, and
+   requests for an image being decoded join the decode.
+
+   Decoding, rounding and the disk tier run on a background queue, so the
+   main thread only ever sets the decoded bitmaps. Table views prefetch the
+   avatars of the rows about to scroll in with `prefetchImagesForURLs:diameter:`
+   and cancel those of the rows they scrolled past, whose downloads are
+   cancelled unless something else waits for them.
+
+   As an `ATLMMemoryConsumer` the pipeline reports the memory tier to the
+   shared accountant; releasing memory empties it. All methods must be called
+   on the main thread and completions are called on the main thread.
+ */
+@interface ATLMAvatarImagePipeline : NSObject <ATLMMemoryConsumer>
+
+/**
+ @abstract The pipeline shared by the application, downloading with the
+   shared session and keeping up to 20 MB of images in `defaultDirectory`.
+ */
++ (nonnull instancetype)sharedPipeline;
+
+/**
+ @abstract Creates a pipeline.
+ @param session The session images are downloaded with.
+ @param diskCache The disk tier or `nil` to keep images in memory only.
+ @return A new `ATLMAvatarImagePipeline` instance.
+ */
++ (nonnull instancetype)pipelineWithSession:(nonnull NSURLSession *)session diskCache:(nullable ATLMDiskLRUCache *)diskCache;
+
+/**
+ @abstract The directory in the application's caches directory used by default.
+ */
++ (nonnull NSString *)defaultDirectory;
+
+@property (nonnull, nonatomic, readonly) NSURLSession *session;
+@property (nullable, nonatomic, readonly) ATLMDiskLRUCache *diskCache;
+
+/**
+ @abstract The size of the decoded bitmaps kept in memory. Defaults to 8 MB.
+ */
+@property (nonatomic) NSUInteger memoryByteLimit;
+
+/**
+ @abstract The scale images are rendered at. Defaults to the main screen's.
+ */
+@property (nonatomic) CGFloat scale;
+
+///-----------------
+/// @name Fetching
+///-----------------
+
+/**
+ @abstract Returns the image if it is in the memory tier.
+ @discussion Cheap enough to call while configuring a cell.
+ */
+- (nullable UIImage *)cachedImageForURL:(nonnull NSURL *)URL diameter:(CGFloat)diameter;
+
+/**
+ @abstract Fetches an image through the tiers.
+ @discussion The completion is called right away for images in the memory tier.
+ */
+- (void)fetchImageForURL:(nonnull NSURL *)URL diameter:(CGFloat)diameter completion:(nonnull ATLMAvatarImageCompletion)completion;
+
+/**
+ @abstract Fetches the images not in the memory tier yet at a low priority.
+ */
+- (void)prefetchImagesForURLs:(nonnull NSArray<NSURL *> *)URLs diameter:(CGFloat)diameter;
+
+/**
+ @abstract Cancels the downloads of prefetched images no completion waits for.
+ */
+- (void)cancelPrefetchingImagesForURLs:(nonnull NSArray<NSURL *> *)URLs diameter:(CGFloat)diameter;
+
+/**
+ @abstract Empties the memory and disk tiers.
+ */
+- (void)removeAllImages;
+
+///--------------
+/// @name Metrics
+///--------------
+
+/**
+ @abstract The number of `cachedImageForURL:diameter:` lookups answered by the memory tier.
+ @discussion `fetchImageForURL:diameter:completion:` checks the memory tier
+   without counting.
+ */
+@property (nonatomic, readonly) NSUInteger countOfMemoryHits;
+@property (nonatomic, readonly) NSUInteger countOfMemoryMisses;
+
+/**
+ @abstract The ratio of memory hits to lookups; 0 before the first lookup.
+ */
+@property (nonatomic, readonly) double memoryHitRate;
+
+@property (nonatomic, readonly) NSUInteger countOfDiskHits;
+@property (nonatomic, readonly) NSUInteger countOfDownloads;
+@property (nonatomic, readonly) NSUInteger countOfCancelledDownloads;
+@property (nonatomic, readonly) NSUInteger countOfDecodes;
+
+/**
+ @abstract The number of requests which joined a download or a decode in flight.
+ */
+@property (nonatomic, readonly) NSUInteger countOfCoalescedRequests;
+
+@end
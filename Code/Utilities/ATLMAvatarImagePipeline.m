@@ -0,0 +1,488 @@
+//
+//  ATLMAvatarImagePipeline.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMAvatarImagePipeline.h"
+#import <ImageIO/ImageIO.h>
+#import <MobileCoreServices/MobileCoreServices.h>
+#import "ATLMDiskLRUCache.h"
+#import "ATLMErrors.h"
+#import "ATLMInstrumentation.h"
+
+static const NSUInteger ATLMAvatarImagePipelineDefaultMemoryByteLimit = 8 * 1024 * 1024;
+static const NSUInteger ATLMAvatarImagePipelineDefaultDiskByteLimit = 20 * 1024 * 1024;
+
+UIImage *ATLMAvatarImageRoundedFromData(NSData *data, CGFloat diameter, CGFloat scale)
+{
+    size_t pixelDiameter = (size_t)MAX(lround(diameter * scale), 1);
+    CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef)data, NULL);
+    if (!source) {
+        return nil;
+    }
+    NSDictionary *properties = (__bridge_transfer NSDictionary *)CGImageSourceCopyPropertiesAtIndex(source, 0, NULL);
+    double width = [properties[(__bridge NSString *)kCGImagePropertyPixelWidth] doubleValue];
+    double height = [properties[(__bridge NSString *)kCGImagePropertyPixelHeight] doubleValue];
+    if (width <= 0 || height <= 0) {
+        CFRelease(source);
+        return nil;
+    }
+    // Downsample while decoding, keeping the shorter side large enough to cover the circle.
+    double maximumPixelSize = ceil(pixelDiameter * MAX(width, height) / MIN(width, height));
+    NSDictionary *options = @{ (__bridge NSString *)kCGImageSourceCreateThumbnailFromImageAlways: @YES,
+                               (__bridge NSString *)kCGImageSourceCreateThumbnailWithTransform: @YES,
+                               (__bridge NSString *)kCGImageSourceThumbnailMaxPixelSize: @(maximumPixelSize) };
+    CGImageRef thumbnail = CGImageSourceCreateThumbnailAtIndex(source, 0, (__bridge CFDictionaryRef)options);
+    CFRelease(source);
+    if (!thumbnail) {
+        return nil;
+    }
+
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(NULL, pixelDiameter, pixelDiameter, 8, 0, colorSpace, kCGBitmapByteOrder32Host | (CGBitmapInfo)kCGImageAlphaPremultipliedFirst);
+    CGColorSpaceRelease(colorSpace);
+    if (!context) {
+        CGImageRelease(thumbnail);
+        return nil;
+    }
+    CGContextAddEllipseInRect(context, CGRectMake(0, 0, pixelDiameter, pixelDiameter));
+    CGContextClip(context);
+    CGContextSetInterpolationQuality(context, kCGInterpolationHigh);
+    double thumbnailWidth = CGImageGetWidth(thumbnail);
+    double thumbnailHeight = CGImageGetHeight(thumbnail);
+    double fillScale = pixelDiameter / MIN(thumbnailWidth, thumbnailHeight);
+    CGRect imageRect = CGRectMake((pixelDiameter - thumbnailWidth * fillScale) / 2, (pixelDiameter - thumbnailHeight * fillScale) / 2, thumbnailWidth * fillScale, thumbnailHeight * fillScale);
+    CGContextDrawImage(context, imageRect, thumbnail);
+    CGImageRelease(thumbnail);
+    CGImageRef roundedImage = CGBitmapContextCreateImage(context);
+    CGContextRelease(context);
+    if (!roundedImage) {
+        return nil;
+    }
+    UIImage *image = [UIImage imageWithCGImage:roundedImage scale:scale orientation:UIImageOrientationUp];
+    CGImageRelease(roundedImage);
+    return image;
+}
+
+/**
+ @abstract Decodes an image the disk tier stored, so it isn't decoded lazily on the main thread.
+ */
+static UIImage *ATLMAvatarImageDecodedFromData(NSData *data, CGFloat scale)
+{
+    CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef)data, NULL);
+    if (!source) {
+        return nil;
+    }
+    NSDictionary *options = @{ (__bridge NSString *)kCGImageSourceShouldCacheImmediately: @YES };
+    CGImageRef decodedImage = CGImageSourceCreateImageAtIndex(source, 0, (__bridge CFDictionaryRef)options);
+    CFRelease(source);
+    if (!decodedImage) {
+        return nil;
+    }
+    UIImage *image = [UIImage imageWithCGImage:decodedImage scale:scale orientation:UIImageOrientationUp];
+    CGImageRelease(decodedImage);
+    return image;
+}
+
+static NSData *ATLMAvatarImagePNGData(UIImage *image)
+{
+    NSMutableData *data = [NSMutableData data];
+    CGImageDestinationRef destination = CGImageDestinationCreateWithData((__bridge CFMutableDataRef)data, kUTTypePNG, 1, NULL);
+    if (!destination) {
+        return nil;
+    }
+    CGImageDestinationAddImage(destination, image.CGImage, NULL);
+    BOOL finalized = CGImageDestinationFinalize(destination);
+    CFRelease(destination);
+    return finalized ? data : nil;
+}
+
+static dispatch_queue_t ATLMAvatarImagePipelineDecodeQueue()
+{
+    static dispatch_queue_t queue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        queue = dispatch_queue_create("com.layer.Atlas-Messenger.avatar-decode", DISPATCH_QUEUE_SERIAL);
+        dispatch_set_target_queue(queue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+    });
+    return queue;
+}
+
+/**
+ @abstract An image of a URL and a diameter on its way through the tiers.
+ */
+@interface ATLMAvatarImageRequest : NSObject
+
+@property (nonatomic) NSString *key;
+@property (nonatomic) NSURL *URL;
+@property (nonatomic) CGFloat diameter;
+@property (nonatomic) NSMutableArray<ATLMAvatarImageCompletion> *completions;
+
+@end
+
+@implementation ATLMAvatarImageRequest
+
+@end
+
+/**
+ @abstract A download of a URL shared by the requests of every diameter.
+ */
+@interface ATLMAvatarImageDownload : NSObject
+
+@property (nonatomic) NSURL *URL;
+@property (nonatomic) NSURLSessionDataTask *task;
+@property (nonatomic) NSMutableArray<ATLMAvatarImageRequest *> *requests;
+@property (nonatomic) CFAbsoluteTime startTime;
+
+@end
+
+@implementation ATLMAvatarImageDownload
+
+@end
+
+@interface ATLMAvatarImagePipeline ()
+
+@property (nonnull, nonatomic, readwrite) NSURLSession *session;
+@property (nullable, nonatomic, readwrite) ATLMDiskLRUCache *diskCache;
+@property (nonatomic) NSMutableDictionary<NSString *, UIImage *> *imagesByKey;
+@property (nonatomic) NSMutableOrderedSet<NSString *> *imageKeys;  // Least recently used first.
+@property (nonatomic) NSUInteger memoryFootprint;
+@property (nonatomic) NSMutableDictionary<NSString *, ATLMAvatarImageRequest *> *requestsByKey;
+@property (nonatomic) NSMutableDictionary<NSURL *, ATLMAvatarImageDownload *> *downloadsByURL;
+@property (nonatomic, readwrite) NSUInteger countOfMemoryHits;
+@property (nonatomic, readwrite) NSUInteger countOfMemoryMisses;
+@property (nonatomic, readwrite) NSUInteger countOfDiskHits;
+@property (nonatomic, readwrite) NSUInteger countOfDownloads;
+@property (nonatomic, readwrite) NSUInteger countOfCancelledDownloads;
+@property (nonatomic, readwrite) NSUInteger countOfDecodes;
+@property (nonatomic, readwrite) NSUInteger countOfCoalescedRequests;
+
+@end
+
+@implementation ATLMAvatarImagePipeline
+
++ (instancetype)sharedPipeline
+{
+    static ATLMAvatarImagePipeline *sharedPipeline;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        ATLMDiskLRUCache *diskCache = [ATLMDiskLRUCache cacheWithDirectory:[self defaultDirectory] byteLimit:ATLMAvatarImagePipelineDefaultDiskByteLimit];
+        sharedPipeline = [self pipelineWithSession:[NSURLSession sharedSession] diskCache:diskCache];
+        [[ATLMMemoryAccountant sharedAccountant] registerConsumer:sharedPipeline];
+    });
+    return sharedPipeline;
+}
+
++ (instancetype)pipelineWithSession:(NSURLSession *)session diskCache:(ATLMDiskLRUCache *)diskCache
+{
+    return [[self alloc] initWithSession:session diskCache:diskCache];
+}
+
++ (NSString *)defaultDirectory
+{
+    NSString *cachesDirectory = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES).firstObject;
+    return [cachesDirectory stringByAppendingPathComponent:@"Avatars"];
+}
+
+- (id)initWithSession:(NSURLSession *)session diskCache:(ATLMDiskLRUCache *)diskCache
+{
+    NSParameterAssert(session);
+    self = [super init];
+    if (self) {
+        _session = session;
+        _diskCache = diskCache;
+        _memoryByteLimit = ATLMAvatarImagePipelineDefaultMemoryByteLimit;
+        _scale = [UIScreen mainScreen].scale;
+        _imagesByKey = [NSMutableDictionary new];
+        _imageKeys = [NSMutableOrderedSet new];
+        _requestsByKey = [NSMutableDictionary new];
+        _downloadsByURL = [NSMutableDictionary new];
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use pipelineWithSession:diskCache:" userInfo:nil];
+}
+
+#pragma mark - Fetching
+
+- (UIImage *)cachedImageForURL:(NSURL *)URL diameter:(CGFloat)diameter
+{
+    UIImage *image = [self memoryImageForKey:[self keyForURL:URL diameter:diameter]];
+    if (image) {
+        self.countOfMemoryHits += 1;
+    } else {
+        self.countOfMemoryMisses += 1;
+        ATLMInstrumentationCount(ATLMMetricAvatarMemoryMisses);
+    }
+    return image;
+}
+
+- (void)fetchImageForURL:(NSURL *)URL diameter:(CGFloat)diameter completion:(ATLMAvatarImageCompletion)completion
+{
+    NSParameterAssert(completion);
+    // Callers look the image up with cachedImageForURL:diameter: first, which
+    // counts the lookup already.
+    UIImage *image = [self memoryImageForKey:[self keyForURL:URL diameter:diameter]];
+    if (image) {
+        completion(image, nil);
+        return;
+    }
+    ATLMAvatarImageRequest *request = self.requestsByKey[[self keyForURL:URL diameter:diameter]];
+    if (request) {
+        self.countOfCoalescedRequests += 1;
+    } else {
+        request = [self startRequestForURL:URL diameter:diameter];
+    }
+    [request.completions addObject:[completion copy]];
+    // Someone is waiting for it now, so it goes ahead of the prefetches.
+    self.downloadsByURL[URL].task.priority = NSURLSessionTaskPriorityHigh;
+}
+
+- (void)prefetchImagesForURLs:(NSArray<NSURL *> *)URLs diameter:(CGFloat)diameter
+{
+    for (NSURL *URL in URLs) {
+        NSString *key = [self keyForURL:URL diameter:diameter];
+        if (self.imagesByKey[key] || self.requestsByKey[key]) {
+            continue;
+        }
+        [self startRequestForURL:URL diameter:diameter];
+    }
+}
+
+- (void)cancelPrefetchingImagesForURLs:(NSArray<NSURL *> *)URLs diameter:(CGFloat)diameter
+{
+    for (NSURL *URL in URLs) {
+        NSString *key = [self keyForURL:URL diameter:diameter];
+        ATLMAvatarImageRequest *request = self.requestsByKey[key];
+        ATLMAvatarImageDownload *download = self.downloadsByURL[URL];
+        // Requests reading the disk tier or decoding are cheap enough to let finish.
+        if (!request || request.completions.count || ![download.requests containsObject:request]) {
+            continue;
+        }
+        [download.requests removeObject:request];
+        [self.requestsByKey removeObjectForKey:key];
+        if (download.requests.count == 0) {
+            [download.task cancel];
+            [self.downloadsByURL removeObjectForKey:URL];
+            self.countOfCancelledDownloads += 1;
+        }
+    }
+}
+
+- (void)removeAllImages
+{
+    [self releaseMemory];
+    ATLMDiskLRUCache *diskCache = self.diskCache;
+    dispatch_async(ATLMAvatarImagePipelineDecodeQueue(), ^{
+        [diskCache removeAllData];
+    });
+}
+
+#pragma mark - Requests
+
+- (NSString *)keyForURL:(NSURL *)URL diameter:(CGFloat)diameter
+{
+    return [NSString stringWithFormat:@"%@#%ld", URL.absoluteString, lround(diameter * self.scale)];
+}
+
+- (ATLMAvatarImageRequest *)startRequestForURL:(NSURL *)URL diameter:(CGFloat)diameter
+{
+    ATLMAvatarImageRequest *request = [ATLMAvatarImageRequest new];
+    request.key = [self keyForURL:URL diameter:diameter];
+    request.URL = URL;
+    request.diameter = diameter;
+    request.completions = [NSMutableArray new];
+    self.requestsByKey[request.key] = request;
+
+    ATLMDiskLRUCache *diskCache = self.diskCache;
+    if (!diskCache) {
+        [self downloadImageForRequest:request];
+        return request;
+    }
+    CGFloat scale = self.scale;
+    dispatch_async(ATLMAvatarImagePipelineDecodeQueue(), ^{
+        NSData *data = [diskCache dataForKey:request.key];
+        UIImage *image = data ? ATLMAvatarImageDecodedFromData(data, scale) : nil;
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (image) {
+                self.countOfDiskHits += 1;
+                [self finishRequest:request image:image error:nil];
+            } else {
+                [self downloadImageForRequest:request];
+            }
+        });
+    });
+    return request;
+}
+
+- (void)downloadImageForRequest:(ATLMAvatarImageRequest *)request
+{
+    if (self.requestsByKey[request.key] != request) {
+        return;
+    }
+    NSURLSessionTaskPriority priority = request.completions.count ? NSURLSessionTaskPriorityHigh : NSURLSessionTaskPriorityLow;
+    ATLMAvatarImageDownload *download = self.downloadsByURL[request.URL];
+    if (download) {
+        [download.requests addObject:request];
+        download.task.priority = MAX(download.task.priority, priority);
+        self.countOfCoalescedRequests += 1;
+        return;
+    }
+    download = [ATLMAvatarImageDownload new];
+    download.URL = request.URL;
+    download.requests = [NSMutableArray arrayWithObject:request];
+    download.startTime = CFAbsoluteTimeGetCurrent();
+    __weak typeof(self) weakSelf = self;
+    download.task = [self.session dataTaskWithURL:request.URL completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [weakSelf download:download didFinishWithData:data response:response error:error];
+        });
+    }];
+    download.task.priority = priority;
+    self.downloadsByURL[request.URL] = download;
+    self.countOfDownloads += 1;
+    [download.task resume];
+}
+
+- (void)download:(ATLMAvatarImageDownload *)download didFinishWithData:(NSData *)data response:(NSURLResponse *)response error:(NSError *)error
+{
+    if (self.downloadsByURL[download.URL] == download) {
+        [self.downloadsByURL removeObjectForKey:download.URL];
+    }
+    if (!error) {
+        ATLMInstrumentationRecordDuration(ATLMMetricAvatarDownload, CFAbsoluteTimeGetCurrent() - download.startTime);
+    }
+    if (!error && [response isKindOfClass:[NSHTTPURLResponse class]] && ((NSHTTPURLResponse *)response).statusCode >= 400) {
+        error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorBadServerResponse userInfo:@{ NSURLErrorFailingURLErrorKey: download.URL }];
+    }
+    NSArray *requests = [download.requests copy];
+    if (error || !data.length) {
+        for (ATLMAvatarImageRequest *request in requests) {
+            [self finishRequest:request image:nil error:error];
+        }
+        return;
+    }
+    ATLMDiskLRUCache *diskCache = self.diskCache;
+    CGFloat scale = self.scale;
+    for (ATLMAvatarImageRequest *request in requests) {
+        dispatch_async(ATLMAvatarImagePipelineDecodeQueue(), ^{
+            CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+            UIImage *image = ATLMAvatarImageRoundedFromData(data, request.diameter, scale);
+            ATLMInstrumentationRecordDuration(ATLMMetricAvatarDecode, CFAbsoluteTimeGetCurrent() - start);
+            NSData *PNGData = image && diskCache ? ATLMAvatarImagePNGData(image) : nil;
+            if (PNGData) {
+                [diskCache setData:PNGData forKey:request.key];
+            }
+            dispatch_async(dispatch_get_main_queue(), ^{
+                self.countOfDecodes += 1;
+                NSError *decodingError = image ? nil : [NSError errorWithDomain:ATLMErrorDomain code:ATLMAvatarImageDecodingFailed userInfo:@{ NSLocalizedDescriptionKey: @"Failed to decode the avatar image." }];
+                [self finishRequest:request image:image error:decodingError];
+            });
+        });
+    }
+}
+
+- (void)finishRequest:(ATLMAvatarImageRequest *)request image:(UIImage *)image error:(NSError *)error
+{
+    if (self.requestsByKey[request.key] == request) {
+        [self.requestsByKey removeObjectForKey:request.key];
+    }
+    if (image) {
+        [self storeImage:image forKey:request.key];
+    }
+    for (ATLMAvatarImageCompletion completion in request.completions) {
+        completion(image, error);
+    }
+}
+
+#pragma mark - Memory Tier
+
+- (UIImage *)memoryImageForKey:(NSString *)key
+{
+    UIImage *image = self.imagesByKey[key];
+    if (image) {
+        [self.imageKeys removeObject:key];
+        [self.imageKeys addObject:key];
+    }
+    return image;
+}
+
+- (void)storeImage:(UIImage *)image forKey:(NSString *)key
+{
+    [self removeImageForKey:key];
+    self.imagesByKey[key] = image;
+    [self.imageKeys addObject:key];
+    self.memoryFootprint += ATLMMemoryFootprintOfImage(image);
+    while (self.memoryFootprint > self.memoryByteLimit && self.imageKeys.count > 1) {
+        [self removeImageForKey:self.imageKeys.firstObject];
+    }
+    [[ATLMMemoryAccountant sharedAccountant] consumerDidChangeFootprint:self];
+}
+
+- (void)removeImageForKey:(NSString *)key
+{
+    UIImage *image = self.imagesByKey[key];
+    if (!image) {
+        return;
+    }
+    [self.imagesByKey removeObjectForKey:key];
+    [self.imageKeys removeObject:key];
+    self.memoryFootprint -= MIN(ATLMMemoryFootprintOfImage(image), self.memoryFootprint);
+}
+
+- (void)setMemoryByteLimit:(NSUInteger)memoryByteLimit
+{
+    _memoryByteLimit = memoryByteLimit;
+    while (self.memoryFootprint > memoryByteLimit && self.imageKeys.count) {
+        [self removeImageForKey:self.imageKeys.firstObject];
+    }
+}
+
+#pragma mark - ATLMMemoryConsumer
+
+- (NSString *)memoryCategory
+{
+    return ATLMMemoryCategoryImages;
+}
+
+- (ATLMMemoryPriority)memoryPriority
+{
+    return ATLMMemoryPriorityDiscardable;
+}
+
+- (NSUInteger)releaseMemory
+{
+    NSUInteger footprint = self.memoryFootprint;
+    [self.imagesByKey removeAllObjects];
+    [self.imageKeys removeAllObjects];
+    self.memoryFootprint = 0;
+    return footprint;
+}
+
+#pragma mark - Metrics
+
+- (double)memoryHitRate
+{
+    NSUInteger lookups = self.countOfMemoryHits + self.countOfMemoryMisses;
+    return lookups ? (double)self.countOfMemoryHits / lookups : 0;
+}
+
+@end
@@ -0,0 +1,102 @@
+//
+//  ATLMCollectionDiff.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <UIKit/UIKit.h>
+
+/**
+ @abstract Returns the stable identifier of an object in a diffed collection.
+ */
+typedef id<NSCopying> _Nonnull (^ATLMCollectionDiffKeyBlock)(id _Nonnull object);
+
+/**
+ @abstract A single move reported by `ATLMCollectionDiff`.
+ */
+@interface ATLMCollectionMove : NSObject
+
+/**
+ @abstract The index of the object in the old collection.
+ */
+@property (nonatomic, readonly) NSUInteger fromIndex;
+
+/**
+ @abstract The index of the object in the new collection.
+ */
+@property (nonatomic, readonly) NSUInteger toIndex;
+
+@end
+
+/**
+ @abstract The `ATLMCollectionDiff` computes the changes between two ordered
+   collections whose objects are identified by a stable key.
+ @discussion The diff uses Heckel's algorithm to match the objects by their key
+   in linear time and reports only the matched objects outside the longest
+   increasing subsequence as moves, which is the minimal set of moves. The
+   indexes follow the `UITableView` batch update conventions: deletions, moves'
+   `fromIndex` and updates refer to the old collection, insertions and moves'
+   `toIndex` refer to the new one.
+ */
+@interface ATLMCollectionDiff : NSObject
+
+/**
+ @abstract Computes the diff between two collections.
+ @param oldObjects The collection currently displayed.
+ @param newObjects The collection to display.
+ @param keyBlock A block returning the stable identifier of an object.
+ @return An `ATLMCollectionDiff` instance describing the changes.
+ @discussion Objects matched by key but not equal according to `isEqual:` are
+   reported as updates, or as a deletion plus an insertion if they also moved.
+ */
++ (nonnull instancetype)diffFromObjects:(nonnull NSArray *)oldObjects toObjects:(nonnull NSArray *)newObjects keyBlock:(nonnull ATLMCollectionDiffKeyBlock)keyBlock;
+
+/**
+ @abstract The indexes of the objects removed from the old collection.
+ */
+@property (nonnull, nonatomic, readonly) NSIndexSet *deletedIndexes;
+
+/**
+ @abstract The indexes of the objects inserted into the new collection.
+ */
+@property (nonnull, nonatomic, readonly) NSIndexSet *insertedIndexes;
+
+/**
+ @abstract The indexes of the objects in the old collection whose content changed.
+ */
+@property (nonnull, nonatomic, readonly) NSIndexSet *updatedIndexes;
+
+/**
+ @abstract The `ATLMCollectionMove` instances describing the moved objects.
+ */
+@property (nonnull, nonatomic, readonly) NSArray<ATLMCollectionMove *> *moves;
+
+/**
+ @abstract `YES` if the collections differ.
+ */
+@property (nonatomic, readonly) BOOL hasChanges;
+
+/**
+ @abstract Applies the changes to a section of the table view in a single batch update.
+ @param tableView The table view displaying the old collection.
+ @param section The section displaying the collection; its rows must start at index zero.
+ @param animation The animation used for inserted, deleted and updated rows.
+ @discussion The data source must already be backed by the new collection.
+ */
+- (void)applyToTableView:(nonnull UITableView *)tableView section:(NSInteger)section withRowAnimation:(UITableViewRowAnimation)animation;
+
+@end
@@ -0,0 +1,234 @@
+//
+//  ATLMCollectionDiff.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMCollectionDiff.h"
+
+@interface ATLMCollectionMove ()
+
+@property (nonatomic, readwrite) NSUInteger fromIndex;
+@property (nonatomic, readwrite) NSUInteger toIndex;
+
+@end
+
+@implementation ATLMCollectionMove
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@:%p %lu -> %lu>", [self class], self, (unsigned long)self.fromIndex, (unsigned long)self.toIndex];
+}
+
+@end
+
+/**
+ @abstract Marks the entries of `sequence` that form its longest strictly
+   increasing subsequence, skipping the entries equal to `NSNotFound`.
+ @discussion Patience sorting, O(n log n).
+ */
+static void ATLMMarkLongestIncreasingSubsequence(const NSUInteger *sequence, NSUInteger count, BOOL *marks)
+{
+    NSUInteger *tails = malloc(sizeof(NSUInteger) * (count + 1));
+    NSUInteger *predecessors = malloc(sizeof(NSUInteger) * (count + 1));
+    NSUInteger length = 0;
+    for (NSUInteger index = 0; index < count; index++) {
+        if (sequence[index] == NSNotFound) {
+            continue;
+        }
+        // Binary search for the first tail not smaller than the current value.
+        NSUInteger low = 0;
+        NSUInteger high = length;
+        while (low < high) {
+            NSUInteger middle = (low + high) / 2;
+            if (sequence[tails[middle]] < sequence[index]) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        predecessors[index] = low > 0 ? tails[low - 1] : NSNotFound;
+        tails[low] = index;
+        if (low == length) {
+            length += 1;
+        }
+    }
+    NSUInteger index = length > 0 ? tails[length - 1] : NSNotFound;
+    while (index != NSNotFound) {
+        marks[index] = YES;
+        index = predecessors[index];
+    }
+    free(tails);
+    free(predecessors);
+}
+
+static NSArray *ATLMIndexPathsForIndexes(NSIndexSet *indexes, NSInteger section)
+{
+    NSMutableArray *indexPaths = [NSMutableArray arrayWithCapacity:indexes.count];
+    [indexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        [indexPaths addObject:[NSIndexPath indexPathForRow:index inSection:section]];
+    }];
+    return indexPaths;
+}
+
+@interface ATLMCollectionDiff ()
+
+@property (nonnull, nonatomic, readwrite) NSIndexSet *deletedIndexes;
+@property (nonnull, nonatomic, readwrite) NSIndexSet *insertedIndexes;
+@property (nonnull, nonatomic, readwrite) NSIndexSet *updatedIndexes;
+@property (nonnull, nonatomic, readwrite) NSArray<ATLMCollectionMove *> *moves;
+
+@end
+
+@implementation ATLMCollectionDiff
+
++ (instancetype)diffFromObjects:(NSArray *)oldObjects toObjects:(NSArray *)newObjects keyBlock:(ATLMCollectionDiffKeyBlock)keyBlock
+{
+    return [[self alloc] initWithObjects:oldObjects toObjects:newObjects keyBlock:keyBlock];
+}
+
+- (id)initWithObjects:(NSArray *)oldObjects toObjects:(NSArray *)newObjects keyBlock:(ATLMCollectionDiffKeyBlock)keyBlock
+{
+    NSParameterAssert(oldObjects);
+    NSParameterAssert(newObjects);
+    NSParameterAssert(keyBlock);
+    self = [super init];
+    if (self) {
+        [self computeDiffFromObjects:oldObjects toObjects:newObjects keyBlock:keyBlock];
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use diffFromObjects:toObjects:keyBlock:" userInfo:nil];
+}
+
+- (void)computeDiffFromObjects:(NSArray *)oldObjects toObjects:(NSArray *)newObjects keyBlock:(ATLMCollectionDiffKeyBlock)keyBlock
+{
+    NSUInteger oldCount = oldObjects.count;
+    NSUInteger newCount = newObjects.count;
+
+    // Pass 1: symbol table of the old indexes by key. Duplicate keys are
+    // matched in order of appearance.
+    NSMutableDictionary *oldIndexesByKey = [NSMutableDictionary dictionaryWithCapacity:oldCount];
+    NSUInteger oldIndex = 0;
+    for (id object in oldObjects) {
+        id<NSCopying> key = keyBlock(object);
+        id entry = oldIndexesByKey[key];
+        if (!entry) {
+            oldIndexesByKey[key] = @(oldIndex);
+        } else if ([entry isKindOfClass:[NSNumber class]]) {
+            oldIndexesByKey[key] = [NSMutableArray arrayWithObjects:entry, @(oldIndex), nil];
+        } else {
+            [entry addObject:@(oldIndex)];
+        }
+        oldIndex++;
+    }
+
+    // Pass 2: match the new objects against the symbol table.
+    NSUInteger *newToOld = malloc(sizeof(NSUInteger) * MAX(newCount, 1));
+    BOOL *oldMatched = calloc(MAX(oldCount, 1), sizeof(BOOL));
+    NSUInteger newIndex = 0;
+    for (id object in newObjects) {
+        id<NSCopying> key = keyBlock(object);
+        id entry = oldIndexesByKey[key];
+        NSUInteger matchedIndex = NSNotFound;
+        if ([entry isKindOfClass:[NSNumber class]]) {
+            matchedIndex = [entry unsignedIntegerValue];
+            [oldIndexesByKey removeObjectForKey:key];
+        } else if (entry) {
+            matchedIndex = [[entry firstObject] unsignedIntegerValue];
+            [entry removeObjectAtIndex:0];
+            if ([entry count] == 0) {
+                [oldIndexesByKey removeObjectForKey:key];
+            }
+        }
+        newToOld[newIndex] = matchedIndex;
+        if (matchedIndex != NSNotFound) {
+            oldMatched[matchedIndex] = YES;
+        }
+        newIndex++;
+    }
+
+    // Pass 3: the matches forming the longest increasing run of old indexes
+    // stay in place, everything else matched has to move.
+    BOOL *stable = calloc(MAX(newCount, 1), sizeof(BOOL));
+    ATLMMarkLongestIncreasingSubsequence(newToOld, newCount, stable);
+
+    NSMutableIndexSet *deletedIndexes = [NSMutableIndexSet new];
+    NSMutableIndexSet *insertedIndexes = [NSMutableIndexSet new];
+    NSMutableIndexSet *updatedIndexes = [NSMutableIndexSet new];
+    NSMutableArray *moves = [NSMutableArray new];
+    for (NSUInteger index = 0; index < oldCount; index++) {
+        if (!oldMatched[index]) {
+            [deletedIndexes addIndex:index];
+        }
+    }
+    for (NSUInteger index = 0; index < newCount; index++) {
+        NSUInteger matchedIndex = newToOld[index];
+        if (matchedIndex == NSNotFound) {
+            [insertedIndexes addIndex:index];
+            continue;
+        }
+        BOOL changed = ![oldObjects[matchedIndex] isEqual:newObjects[index]];
+        if (stable[index]) {
+            if (changed) {
+                [updatedIndexes addIndex:matchedIndex];
+            }
+        } else if (changed) {
+            // A row can't be moved and reloaded in the same batch.
+            [deletedIndexes addIndex:matchedIndex];
+            [insertedIndexes addIndex:index];
+        } else {
+            ATLMCollectionMove *move = [ATLMCollectionMove new];
+            move.fromIndex = matchedIndex;
+            move.toIndex = index;
+            [moves addObject:move];
+        }
+    }
+    free(newToOld);
+    free(oldMatched);
+    free(stable);
+
+    self.deletedIndexes = deletedIndexes;
+    self.insertedIndexes = insertedIndexes;
+    self.updatedIndexes = updatedIndexes;
+    self.moves = moves;
+}
+
+- (BOOL)hasChanges
+{
+    return self.deletedIndexes.count || self.insertedIndexes.count || self.updatedIndexes.count || self.moves.count;
+}
+
+- (void)applyToTableView:(UITableView *)tableView section:(NSInteger)section withRowAnimation:(UITableViewRowAnimation)animation
+{
+    if (!self.hasChanges) {
+        return;
+    }
+    [tableView beginUpdates];
+    [tableView deleteRowsAtIndexPaths:ATLMIndexPathsForIndexes(self.deletedIndexes, section) withRowAnimation:animation];
+    [tableView insertRowsAtIndexPaths:ATLMIndexPathsForIndexes(self.insertedIndexes, section) withRowAnimation:animation];
+    [tableView reloadRowsAtIndexPaths:ATLMIndexPathsForIndexes(self.updatedIndexes, section) withRowAnimation:animation];
+    for (ATLMCollectionMove *move in self.moves) {
+        [tableView moveRowAtIndexPath:[NSIndexPath indexPathForRow:move.fromIndex inSection:section] toIndexPath:[NSIndexPath indexPathForRow:move.toIndex inSection:section]];
+    }
+    [tableView endUpdates];
+}
+
+@end
@@ -0,0 +1,181 @@
+//
+//  ATLMConnectionManager.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import <LayerKit/LayerKit.h>
+
+@class ATLMConnectionManager;
+
+typedef NS_ENUM(NSUInteger, ATLMConnectionStatus) {
+    ATLMConnectionStatusDisconnected    = 0,
+    ATLMConnectionStatusConnecting      = 1,
+    ATLMConnectionStatusConnected       = 2,
+};
+
+/**
+ @abstract The connection surface of `LYRClient` the manager drives.
+ @discussion The client posts `LYRClientWillAttemptToConnectNotification`,
+   `LYRClientDidConnectNotification`, `LYRClientDidDisconnectNotification`,
+   `LYRClientDidLoseConnectionNotification` and
+   `LYRClientDidFinishSynchronizationNotification` with itself as the object.
+ */
+@protocol ATLMConnecting <NSObject>
+
+@property (nonatomic, readonly) BOOL isConnected;
+@property (nonatomic, readonly) BOOL isConnecting;
+
+- (void)connectWithCompletion:(nullable void (^)(BOOL success, NSError *_Nullable error))completion;
+
+@end
+
+@interface LYRClient (ATLMConnecting) <ATLMConnecting>
+
+@end
+
+/**
+ @abstract The `ATLMConnectionManagerDelegate` protocol is adopted by the object
+   presenting the state of the connection to the user.
+ */
+@protocol ATLMConnectionManagerDelegate <NSObject>
+
+/**
+ @abstract Notifies the receiver the status worth presenting has changed.
+ @param connectionManager The `ATLMConnectionManager` instance performing the invocation.
+ @param status The status, which has lasted for `statusPresentationDelay`.
+ */
+- (void)connectionManager:(nonnull ATLMConnectionManager *)connectionManager didChangePresentedStatus:(ATLMConnectionStatus)status;
+
+@end
+
+/**
+ @abstract The `ATLMConnectionManager` keeps the client connected and
+   measures how long that takes.
+ @discussion The client retries a connection a few times on its own. Once it
+   gives up, or once an established connection is lost, the manager connects
+   again with an exponential backoff. The backoff is skipped when the
+   application enters the foreground or the network becomes reachable, since
+   those are the moments a connection is most likely to succeed.
+
+   Status changes are presented only once they have lasted for
+   `statusPresentationDelay`, so a connection that drops and comes back
+   within it, or a client retrying several times in a row, doesn't flash a
+   HUD each time. A connection is presented only after an outage has been.
+
+   Each connection records the time from the start of the outage to the
+   connection, the number of attempts it took, the time spent disconnected
+   and the time from connecting to the end of the first synchronization, in
+   the properties below and in the shared `ATLMInstrumentation`. All methods
+   must be called on the main thread.
+ */
+@interface ATLMConnectionManager : NSObject
+
+/**
+ @abstract Creates a manager of the client's connection.
+ @param client The client to connect, usually an `LYRClient`.
+ @return A new `ATLMConnectionManager` instance.
+ */
++ (nonnull instancetype)managerWithClient:(nonnull id<ATLMConnecting>)client;
+
+@property (nonnull, nonatomic, readonly) id<ATLMConnecting> client;
+
+@property (nullable, nonatomic, weak) id<ATLMConnectionManagerDelegate> delegate;
+
+/**
+ @abstract The delay before the first reconnect after a failure. Defaults to 1 second.
+ */
+@property (nonatomic) NSTimeInterval initialRetryInterval;
+
+/**
+ @abstract The longest delay between reconnects. Defaults to 60 seconds.
+ */
+@property (nonatomic) NSTimeInterval maximumRetryInterval;
+
+/**
+ @abstract The time a status has to last before it is presented. Defaults to 2 seconds.
+ */
+@property (nonatomic) NSTimeInterval statusPresentationDelay;
+
+///-----------------
+/// @name Connecting
+///-----------------
+
+/**
+ @abstract Connects the client unless it is connected or connecting already.
+ */
+- (void)connect;
+
+/**
+ @abstract Cancels a scheduled reconnect, resets the backoff and connects.
+ @discussion Called when the application enters the foreground and when the
+   network becomes reachable. Does nothing until `connect` has been called.
+ */
+- (void)reconnectImmediately;
+
+@property (nonatomic, readonly) ATLMConnectionStatus status;
+
+/**
+ @abstract The status last passed to the delegate. Starts as connected, so nothing is presented for a quick first connection.
+ */
+@property (nonatomic, readonly) ATLMConnectionStatus presentedStatus;
+
+/**
+ @abstract Whether the network was reachable when last checked.
+ */
+@property (nonatomic, readonly, getter=isNetworkReachable) BOOL networkReachable;
+
+///--------------
+/// @name Metrics
+///--------------
+
+@property (nonatomic, readonly) NSUInteger countOfConnectionAttempts;
+@property (nonatomic, readonly) NSUInteger countOfConnections;
+@property (nonatomic, readonly) NSUInteger countOfConnectionLosses;
+
+/**
+ @abstract The number of reconnects scheduled with a backoff.
+ */
+@property (nonatomic, readonly) NSUInteger countOfScheduledReconnects;
+
+/**
+ @abstract The number of times the delegate was told about a status change.
+ */
+@property (nonatomic, readonly) NSUInteger countOfPresentedStatusChanges;
+
+/**
+ @abstract The time from the start of the last outage, or of the first connect, to the last connection.
+ */
+@property (nonatomic, readonly) NSTimeInterval lastTimeToConnect;
+
+/**
+ @abstract The number of attempts the last connection took.
+ */
+@property (nonatomic, readonly) NSUInteger lastConnectionAttemptCount;
+
+/**
+ @abstract The time from the last connection to the end of the first synchronization after it.
+ */
+@property (nonatomic, readonly) NSTimeInterval lastTimeToFirstSynchronization;
+
+/**
+ @abstract The time spent disconnected after losing connections, excluding the outage in progress.
+ */
+@property (nonatomic, readonly) NSTimeInterval totalTimeDisconnected;
+
+@end
@@ -0,0 +1,371 @@
+//
+//  ATLMConnectionManager.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMConnectionManager.h"
+#import <UIKit/UIKit.h>
+#import <SystemConfiguration/SystemConfiguration.h>
+#import <netinet/in.h>
+#import "ATLMInstrumentation.h"
+
+static const NSTimeInterval ATLMConnectionManagerDefaultInitialRetryInterval = 1;
+static const NSTimeInterval ATLMConnectionManagerDefaultMaximumRetryInterval = 60;
+static const NSTimeInterval ATLMConnectionManagerDefaultStatusPresentationDelay = 2;
+
+@interface ATLMConnectionManager ()
+
+@property (nonatomic, readwrite) ATLMConnectionStatus status;
+@property (nonatomic, readwrite) ATLMConnectionStatus presentedStatus;
+@property (nonatomic, readwrite, getter=isNetworkReachable) BOOL networkReachable;
+@property (nonatomic, readwrite) NSUInteger countOfConnectionAttempts;
+@property (nonatomic, readwrite) NSUInteger countOfConnections;
+@property (nonatomic, readwrite) NSUInteger countOfConnectionLosses;
+@property (nonatomic, readwrite) NSUInteger countOfScheduledReconnects;
+@property (nonatomic, readwrite) NSUInteger countOfPresentedStatusChanges;
+@property (nonatomic, readwrite) NSTimeInterval lastTimeToConnect;
+@property (nonatomic, readwrite) NSUInteger lastConnectionAttemptCount;
+@property (nonatomic, readwrite) NSTimeInterval lastTimeToFirstSynchronization;
+@property (nonatomic, readwrite) NSTimeInterval totalTimeDisconnected;
+@property (nonatomic, getter=isStarted) BOOL started;
+@property (nonatomic, getter=isConnectInFlight) BOOL connectInFlight;
+@property (nonatomic) NSUInteger retryCount;
+@property (nonatomic) NSUInteger retryGeneration;
+@property (nonatomic) NSUInteger presentationGeneration;
+@property (nonatomic, getter=isPresentationScheduled) BOOL presentationScheduled;
+@property (nonatomic) CFAbsoluteTime outageStartTime;       // 0 while connected.
+@property (nonatomic) NSUInteger outageAttemptCount;
+@property (nonatomic) CFAbsoluteTime disconnectionTime;     // 0 unless a connection has ended.
+@property (nonatomic) CFAbsoluteTime connectionTime;
+@property (nonatomic, getter=isAwaitingFirstSynchronization) BOOL awaitingFirstSynchronization;
+@property (nonatomic) SCNetworkReachabilityFlags reachabilityFlags;
+
+- (void)networkReachabilityDidChangeWithFlags:(SCNetworkReachabilityFlags)flags;
+
+@end
+
+/**
+ @abstract The info of the reachability callback: retained by the reachability,
+   it references the connection manager weakly, so a callback already in
+   flight when the manager goes away finds `nil`.
+ */
+@interface ATLMConnectionManagerReachabilityInfo : NSObject
+
+@property (nonatomic, weak) ATLMConnectionManager *connectionManager;
+
+@end
+
+@implementation ATLMConnectionManagerReachabilityInfo
+
+@end
+
+static void ATLMConnectionManagerReachabilityCallback(SCNetworkReachabilityRef target, SCNetworkReachabilityFlags flags, void *info)
+{
+    ATLMConnectionManagerReachabilityInfo *reachabilityInfo = (__bridge ATLMConnectionManagerReachabilityInfo *)info;
+    [reachabilityInfo.connectionManager networkReachabilityDidChangeWithFlags:flags];
+}
+
+static BOOL ATLMNetworkReachabilityFlagsAreReachable(SCNetworkReachabilityFlags flags)
+{
+    return (flags & kSCNetworkReachabilityFlagsReachable) && !(flags & kSCNetworkReachabilityFlagsConnectionRequired);
+}
+
+@implementation ATLMConnectionManager
+{
+    SCNetworkReachabilityRef _reachability;
+}
+
++ (instancetype)managerWithClient:(id<ATLMConnecting>)client
+{
+    return [[self alloc] initWithClient:client];
+}
+
+- (id)initWithClient:(id<ATLMConnecting>)client
+{
+    NSParameterAssert(client);
+    self = [super init];
+    if (self) {
+        _client = client;
+        _initialRetryInterval = ATLMConnectionManagerDefaultInitialRetryInterval;
+        _maximumRetryInterval = ATLMConnectionManagerDefaultMaximumRetryInterval;
+        _statusPresentationDelay = ATLMConnectionManagerDefaultStatusPresentationDelay;
+        _status = client.isConnected ? ATLMConnectionStatusConnected : ATLMConnectionStatusDisconnected;
+        _presentedStatus = ATLMConnectionStatusConnected;
+        _networkReachable = YES;
+
+        NSNotificationCenter *notificationCenter = [NSNotificationCenter defaultCenter];
+        [notificationCenter addObserver:self selector:@selector(clientWillAttemptToConnect:) name:LYRClientWillAttemptToConnectNotification object:client];
+        [notificationCenter addObserver:self selector:@selector(clientDidConnect:) name:LYRClientDidConnectNotification object:client];
+        [notificationCenter addObserver:self selector:@selector(clientDidDisconnect:) name:LYRClientDidDisconnectNotification object:client];
+        [notificationCenter addObserver:self selector:@selector(clientDidLoseConnection:) name:LYRClientDidLoseConnectionNotification object:client];
+        [notificationCenter addObserver:self selector:@selector(clientDidFinishSynchronization:) name:LYRClientDidFinishSynchronizationNotification object:client];
+        [notificationCenter addObserver:self selector:@selector(applicationWillEnterForeground:) name:UIApplicationWillEnterForegroundNotification object:nil];
+        [self startMonitoringReachability];
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use managerWithClient:" userInfo:nil];
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    if (_reachability) {
+        SCNetworkReachabilitySetDispatchQueue(_reachability, NULL);
+        CFRelease(_reachability);
+    }
+}
+
+#pragma mark - Connecting
+
+- (void)connect
+{
+    self.started = YES;
+    if (self.client.isConnected || self.client.isConnecting || self.isConnectInFlight) {
+        return;
+    }
+    // Supersedes a scheduled reconnect.
+    self.retryGeneration += 1;
+    if (!self.outageStartTime) {
+        self.outageStartTime = CFAbsoluteTimeGetCurrent();
+    }
+    self.connectInFlight = YES;
+    self.status = ATLMConnectionStatusConnecting;
+    __weak typeof(self) weakSelf = self;
+    [self.client connectWithCompletion:^(BOOL success, NSError *error) {
+        weakSelf.connectInFlight = NO;
+        if (success) {
+            [weakSelf didConnect];
+        } else {
+            NSLog(@"Failed connection to Layer: %@", error);
+            [weakSelf didFailToConnect];
+        }
+    }];
+}
+
+- (void)reconnectImmediately
+{
+    if (!self.isStarted) {
+        return;
+    }
+    self.retryCount = 0;
+    [self connect];
+}
+
+- (void)didConnect
+{
+    if (self.status == ATLMConnectionStatusConnected) {
+        return;
+    }
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    if (self.outageStartTime) {
+        self.lastTimeToConnect = now - self.outageStartTime;
+        ATLMInstrumentationRecordDuration(ATLMMetricConnectionTimeToConnect, self.lastTimeToConnect);
+    }
+    self.lastConnectionAttemptCount = MAX(self.outageAttemptCount, 1);
+    ATLMInstrumentationRecord(ATLMMetricConnectionAttempts, self.lastConnectionAttemptCount);
+    if (self.disconnectionTime) {
+        NSTimeInterval timeDisconnected = now - self.disconnectionTime;
+        self.totalTimeDisconnected += timeDisconnected;
+        ATLMInstrumentationRecordDuration(ATLMMetricConnectionTimeDisconnected, timeDisconnected);
+        self.disconnectionTime = 0;
+    }
+    self.outageStartTime = 0;
+    self.outageAttemptCount = 0;
+    self.retryCount = 0;
+    self.retryGeneration += 1;
+    self.countOfConnections += 1;
+    self.connectionTime = now;
+    self.awaitingFirstSynchronization = YES;
+    self.status = ATLMConnectionStatusConnected;
+}
+
+- (void)didFailToConnect
+{
+    if (self.status == ATLMConnectionStatusConnected) {
+        return;
+    }
+    self.status = ATLMConnectionStatusDisconnected;
+    [self scheduleReconnect];
+}
+
+- (void)didEndConnectionByLosingIt:(BOOL)lost
+{
+    if (self.status != ATLMConnectionStatusConnected) {
+        return;
+    }
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    self.disconnectionTime = now;
+    self.outageStartTime = now;
+    self.awaitingFirstSynchronization = NO;
+    self.status = ATLMConnectionStatusDisconnected;
+    if (lost) {
+        self.countOfConnectionLosses += 1;
+        ATLMInstrumentationCount(ATLMMetricConnectionLosses);
+        [self scheduleReconnect];
+    }
+}
+
+- (void)scheduleReconnect
+{
+    // An unreachable network is waited out; reachability reconnects right away once it's back.
+    if (!self.isNetworkReachable) {
+        return;
+    }
+    self.retryCount += 1;
+    NSTimeInterval interval = MIN(self.maximumRetryInterval, self.initialRetryInterval * pow(2, self.retryCount - 1));
+    // Jitter keeps a fleet of clients from reconnecting in lockstep after an outage of the service.
+    interval *= 0.8 + 0.4 * ((double)arc4random_uniform(1000) / 1000);
+    self.countOfScheduledReconnects += 1;
+    NSUInteger generation = ++self.retryGeneration;
+    __weak typeof(self) weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(interval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        if (weakSelf.retryGeneration == generation) {
+            [weakSelf connect];
+        }
+    });
+}
+
+#pragma mark - Presenting the Status
+
+- (void)setStatus:(ATLMConnectionStatus)status
+{
+    if (_status == status) {
+        return;
+    }
+    _status = status;
+    BOOL outagePresented = self.presentedStatus != ATLMConnectionStatusConnected;
+    if (status == ATLMConnectionStatusConnected) {
+        self.presentationGeneration += 1;
+        self.presentationScheduled = NO;
+        if (outagePresented) {
+            [self presentStatus];
+        }
+        return;
+    }
+    // Retries alternate between connecting and disconnected; once the outage shows, only its end is presented.
+    if (outagePresented || self.isPresentationScheduled) {
+        return;
+    }
+    self.presentationScheduled = YES;
+    NSUInteger generation = ++self.presentationGeneration;
+    __weak typeof(self) weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.statusPresentationDelay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        if (weakSelf.presentationGeneration == generation) {
+            weakSelf.presentationScheduled = NO;
+            [weakSelf presentStatus];
+        }
+    });
+}
+
+- (void)presentStatus
+{
+    if (self.presentedStatus == self.status) {
+        return;
+    }
+    self.presentedStatus = self.status;
+    self.countOfPresentedStatusChanges += 1;
+    [self.delegate connectionManager:self didChangePresentedStatus:self.status];
+}
+
+#pragma mark - Notification Handlers
+
+- (void)clientWillAttemptToConnect:(NSNotification *)notification
+{
+    self.countOfConnectionAttempts += 1;
+    self.outageAttemptCount += 1;
+    if (!self.outageStartTime) {
+        self.outageStartTime = CFAbsoluteTimeGetCurrent();
+    }
+    if (self.status != ATLMConnectionStatusConnected) {
+        self.status = ATLMConnectionStatusConnecting;
+    }
+}
+
+- (void)clientDidConnect:(NSNotification *)notification
+{
+    [self didConnect];
+}
+
+- (void)clientDidDisconnect:(NSNotification *)notification
+{
+    [self didEndConnectionByLosingIt:NO];
+}
+
+- (void)clientDidLoseConnection:(NSNotification *)notification
+{
+    [self didEndConnectionByLosingIt:YES];
+}
+
+- (void)clientDidFinishSynchronization:(NSNotification *)notification
+{
+    if (!self.isAwaitingFirstSynchronization) {
+        return;
+    }
+    self.awaitingFirstSynchronization = NO;
+    self.lastTimeToFirstSynchronization = CFAbsoluteTimeGetCurrent() - self.connectionTime;
+    ATLMInstrumentationRecordDuration(ATLMMetricConnectionTimeToFirstSynchronization, self.lastTimeToFirstSynchronization);
+}
+
+- (void)applicationWillEnterForeground:(NSNotification *)notification
+{
+    [self reconnectImmediately];
+}
+
+#pragma mark - Reachability
+
+- (void)startMonitoringReachability
+{
+    struct sockaddr_in address;
+    bzero(&address, sizeof(address));
+    address.sin_len = sizeof(address);
+    address.sin_family = AF_INET;
+    _reachability = SCNetworkReachabilityCreateWithAddress(kCFAllocatorDefault, (const struct sockaddr *)&address);
+    if (!_reachability) {
+        return;
+    }
+    ATLMConnectionManagerReachabilityInfo *reachabilityInfo = [ATLMConnectionManagerReachabilityInfo new];
+    reachabilityInfo.connectionManager = self;
+    // The reachability retains the info for as long as it may call back.
+    SCNetworkReachabilityContext context = { 0, (__bridge void *)reachabilityInfo, CFRetain, CFRelease, NULL };
+    SCNetworkReachabilitySetCallback(_reachability, ATLMConnectionManagerReachabilityCallback, &context);
+    SCNetworkReachabilitySetDispatchQueue(_reachability, dispatch_get_main_queue());
+    SCNetworkReachabilityFlags flags;
+    if (SCNetworkReachabilityGetFlags(_reachability, &flags)) {
+        self.reachabilityFlags = flags;
+        self.networkReachable = ATLMNetworkReachabilityFlagsAreReachable(flags);
+    }
+}
+
+- (void)networkReachabilityDidChangeWithFlags:(SCNetworkReachabilityFlags)flags
+{
+    if (flags == self.reachabilityFlags) {
+        return;
+    }
+    self.reachabilityFlags = flags;
+    self.networkReachable = ATLMNetworkReachabilityFlagsAreReachable(flags);
+    // Switching networks, from Wi-Fi to cellular say, may have dropped the connection too.
+    if (self.isNetworkReachable) {
+        [self reconnectImmediately];
+    }
+}
+
+@end
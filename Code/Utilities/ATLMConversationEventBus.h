@@ -0,0 +1,111 @@
+//
+//  ATLMConversationEventBus.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+@class LYRConversation;
+
+/**
+ @abstract The changes of a conversation the bus delivers.
+ */
+typedef NS_ENUM(NSUInteger, ATLMConversationEventKind) {
+    ATLMConversationEventKindMetadataDidChange      = 0,
+    ATLMConversationEventKindParticipantsDidChange  = 1,
+    ATLMConversationEventKindDeleted                = 2,
+};
+
+/**
+ @abstract A change of a conversation, as delivered to subscribers.
+ */
+@interface ATLMConversationEvent : NSObject
+
+@property (nonatomic, readonly) ATLMConversationEventKind kind;
+@property (nonnull, nonatomic, readonly) LYRConversation *conversation;
+
+@end
+
+/**
+ @abstract The `ATLMConversationEventBus` delivers conversation changes to
+   the subscribers of the changed conversation only.
+ @discussion Unlike a notification observed for any object, which wakes every
+   observer for every change and leaves each to compare the conversation, a
+   subscription is keyed by the event kind and the conversation identifier.
+   Posting an event looks up the subscriptions of its key and those for any
+   conversation of its kind, so its cost grows with the subscribers who care
+   rather than with all of them.
+
+   Subscriptions hold their observer weakly and are removed once it is
+   deallocated; the handler receives the observer so it doesn't need to
+   capture it. Each subscription delivers on its own queue, or synchronously
+   on the posting thread without one. The bus may be used from any thread.
+ */
+@interface ATLMConversationEventBus : NSObject
+
+/**
+ @abstract Creates a bus.
+ */
++ (nonnull instancetype)bus;
+
+///--------------------
+/// @name Subscribing
+///--------------------
+
+/**
+ @abstract Subscribes the observer to the events of a kind.
+ @param observer The object interested in the events; held weakly.
+ @param kind The kind of the events.
+ @param conversationIdentifier The identifier of the conversation or `nil` for events of any conversation.
+ @param queue The queue the handler is called on or `nil` to call it synchronously on the posting thread.
+ @param handler Called with the observer and the event, unless the observer has been deallocated.
+ @return An opaque subscription to pass to `unsubscribe:`.
+ */
+- (nonnull id)subscribeObserver:(nonnull id)observer
+                    toEventKind:(ATLMConversationEventKind)kind
+         conversationIdentifier:(nullable NSURL *)conversationIdentifier
+                          queue:(nullable dispatch_queue_t)queue
+                        handler:(nonnull void (^)(id _Nonnull observer, ATLMConversationEvent *_Nonnull event))handler;
+
+/**
+ @abstract Removes the subscription; events posted to its queue and not yet delivered are dropped.
+ */
+- (void)unsubscribe:(nullable id)subscription;
+
+///----------------
+/// @name Posting
+///----------------
+
+/**
+ @abstract Delivers an event to the subscribers of the conversation and of any conversation.
+ */
+- (void)postEventOfKind:(ATLMConversationEventKind)kind conversation:(nonnull LYRConversation *)conversation;
+
+///--------------
+/// @name Metrics
+///--------------
+
+@property (nonatomic, readonly) NSUInteger countOfSubscriptions;
+@property (nonatomic, readonly) NSUInteger countOfPostedEvents;
+
+/**
+ @abstract The number of handler calls.
+ */
+@property (nonatomic, readonly) NSUInteger countOfDeliveries;
+
+@end
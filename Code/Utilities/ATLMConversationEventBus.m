@@ -0,0 +1,251 @@
+//
+//  ATLMConversationEventBus.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMConversationEventBus.h"
+#import <LayerKit/LayerKit.h>
+#import <objc/runtime.h>
+#import <pthread.h>
+
+static const NSUInteger ATLMConversationEventKindCount = ATLMConversationEventKindDeleted + 1;
+
+typedef void (^ATLMConversationEventHandler)(id observer, ATLMConversationEvent *event);
+
+@interface ATLMConversationEvent ()
+
+@property (nonatomic, readwrite) ATLMConversationEventKind kind;
+@property (nonnull, nonatomic, readwrite) LYRConversation *conversation;
+
+@end
+
+@implementation ATLMConversationEvent
+
+@end
+
+@interface ATLMConversationEventSubscription : NSObject
+
+@property (nullable, nonatomic, weak) id observer;
+@property (nonatomic) ATLMConversationEventKind kind;
+@property (nonnull, nonatomic) id key;
+@property (nullable, nonatomic) dispatch_queue_t queue;
+@property (nonnull, nonatomic, copy) ATLMConversationEventHandler handler;
+@property (atomic, getter=isCancelled) BOOL cancelled;
+
+@end
+
+@implementation ATLMConversationEventSubscription
+
+@end
+
+/**
+ @abstract Associated with the observer of a subscription, so that the
+   subscription is removed when the observer is deallocated.
+ */
+@interface ATLMConversationEventSubscriptionReaper : NSObject
+
+@property (nullable, nonatomic, weak) ATLMConversationEventBus *bus;
+@property (nullable, nonatomic, weak) ATLMConversationEventSubscription *subscription;
+
+@end
+
+@implementation ATLMConversationEventSubscriptionReaper
+
+- (void)dealloc
+{
+    [_bus unsubscribe:_subscription];
+}
+
+@end
+
+@interface ATLMConversationEventBus ()
+
+// One dictionary per event kind, of the subscriptions by conversation identifier; `NSNull` for any conversation.
+@property (nonnull, nonatomic) NSArray *subscriptionsByKeyByKind;
+
+@end
+
+@implementation ATLMConversationEventBus
+{
+    pthread_mutex_t _lock;
+}
+
++ (instancetype)bus
+{
+    return [[self alloc] init];
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self) {
+        NSMutableArray *subscriptionsByKeyByKind = [NSMutableArray arrayWithCapacity:ATLMConversationEventKindCount];
+        for (NSUInteger kind = 0; kind < ATLMConversationEventKindCount; kind++) {
+            [subscriptionsByKeyByKind addObject:[NSMutableDictionary new]];
+        }
+        _subscriptionsByKeyByKind = subscriptionsByKeyByKind;
+        pthread_mutex_init(&_lock, NULL);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+#pragma mark - Subscribing
+
+- (id)subscribeObserver:(id)observer toEventKind:(ATLMConversationEventKind)kind conversationIdentifier:(NSURL *)conversationIdentifier queue:(dispatch_queue_t)queue handler:(void (^)(id, ATLMConversationEvent *))handler
+{
+    NSParameterAssert(observer);
+    NSParameterAssert(kind < ATLMConversationEventKindCount);
+    NSParameterAssert(handler);
+    ATLMConversationEventSubscription *subscription = [ATLMConversationEventSubscription new];
+    subscription.observer = observer;
+    subscription.kind = kind;
+    subscription.key = conversationIdentifier ?: [NSNull null];
+    subscription.queue = queue;
+    subscription.handler = handler;
+
+    pthread_mutex_lock(&_lock);
+    NSMutableDictionary *subscriptionsByKey = self.subscriptionsByKeyByKind[kind];
+    NSMutableArray *subscriptions = subscriptionsByKey[subscription.key];
+    if (!subscriptions) {
+        subscriptions = [NSMutableArray new];
+        subscriptionsByKey[subscription.key] = subscriptions;
+    }
+    [subscriptions addObject:subscription];
+    _countOfSubscriptions += 1;
+    pthread_mutex_unlock(&_lock);
+
+    // The subscription's address is unique for as long as the association is set.
+    ATLMConversationEventSubscriptionReaper *reaper = [ATLMConversationEventSubscriptionReaper new];
+    reaper.bus = self;
+    reaper.subscription = subscription;
+    objc_setAssociatedObject(observer, (__bridge const void *)subscription, reaper, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    return subscription;
+}
+
+- (void)unsubscribe:(id)subscription
+{
+    if (!subscription) {
+        return;
+    }
+    NSAssert([subscription isKindOfClass:[ATLMConversationEventSubscription class]], @"Not a subscription of the bus: %@", subscription);
+    ATLMConversationEventSubscription *eventSubscription = subscription;
+    pthread_mutex_lock(&_lock);
+    if (eventSubscription.isCancelled) {
+        pthread_mutex_unlock(&_lock);
+        return;
+    }
+    NSMutableDictionary *subscriptionsByKey = self.subscriptionsByKeyByKind[eventSubscription.kind];
+    NSMutableArray *subscriptions = subscriptionsByKey[eventSubscription.key];
+    [subscriptions removeObjectIdenticalTo:eventSubscription];
+    if (subscriptions.count == 0) {
+        [subscriptionsByKey removeObjectForKey:eventSubscription.key];
+    }
+    eventSubscription.cancelled = YES;
+    _countOfSubscriptions -= 1;
+    pthread_mutex_unlock(&_lock);
+
+    // Releasing the reaper calls back into this method, which returns early
+    // now the subscription is cancelled; hence outside the lock.
+    id observer = eventSubscription.observer;
+    if (observer) {
+        objc_setAssociatedObject(observer, (__bridge const void *)eventSubscription, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    }
+}
+
+#pragma mark - Posting
+
+- (void)postEventOfKind:(ATLMConversationEventKind)kind conversation:(LYRConversation *)conversation
+{
+    NSParameterAssert(kind < ATLMConversationEventKindCount);
+    NSParameterAssert(conversation);
+    NSMutableArray *subscriptions = [NSMutableArray new];
+    pthread_mutex_lock(&_lock);
+    _countOfPostedEvents += 1;
+    NSMutableDictionary *subscriptionsByKey = self.subscriptionsByKeyByKind[kind];
+    if (conversation.identifier) {
+        [self collectSubscriptionsForKey:conversation.identifier inSubscriptionsByKey:subscriptionsByKey intoArray:subscriptions];
+    }
+    [self collectSubscriptionsForKey:[NSNull null] inSubscriptionsByKey:subscriptionsByKey intoArray:subscriptions];
+    pthread_mutex_unlock(&_lock);
+    if (subscriptions.count == 0) {
+        return;
+    }
+
+    ATLMConversationEvent *event = [ATLMConversationEvent new];
+    event.kind = kind;
+    event.conversation = conversation;
+    for (ATLMConversationEventSubscription *subscription in subscriptions) {
+        if (!subscription.queue) {
+            [self deliverEvent:event toSubscription:subscription];
+            continue;
+        }
+        dispatch_async(subscription.queue, ^{
+            [self deliverEvent:event toSubscription:subscription];
+        });
+    }
+}
+
+/**
+ @abstract Adds the live subscriptions of the key to the array and drops
+   those whose observer is gone but whose reaper hasn't run yet.
+ @discussion Must be called with the lock held.
+ */
+- (void)collectSubscriptionsForKey:(id)key inSubscriptionsByKey:(NSMutableDictionary *)subscriptionsByKey intoArray:(NSMutableArray *)collectedSubscriptions
+{
+    NSMutableArray *subscriptions = subscriptionsByKey[key];
+    if (!subscriptions) {
+        return;
+    }
+    for (NSUInteger index = subscriptions.count; index > 0; index--) {
+        ATLMConversationEventSubscription *subscription = subscriptions[index - 1];
+        if (subscription.observer) {
+            continue;
+        }
+        subscription.cancelled = YES;
+        [subscriptions removeObjectAtIndex:index - 1];
+        _countOfSubscriptions -= 1;
+    }
+    if (subscriptions.count == 0) {
+        [subscriptionsByKey removeObjectForKey:key];
+        return;
+    }
+    [collectedSubscriptions addObjectsFromArray:subscriptions];
+}
+
+- (void)deliverEvent:(ATLMConversationEvent *)event toSubscription:(ATLMConversationEventSubscription *)subscription
+{
+    // An earlier handler may have unsubscribed it or released its observer.
+    if (subscription.isCancelled) {
+        return;
+    }
+    id observer = subscription.observer;
+    if (!observer) {
+        return;
+    }
+    pthread_mutex_lock(&_lock);
+    _countOfDeliveries += 1;
+    pthread_mutex_unlock(&_lock);
+    subscription.handler(observer, event);
+}
+
+@end
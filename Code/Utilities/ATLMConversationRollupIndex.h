@@ -0,0 +1,159 @@
+//
+//  ATLMConversationRollupIndex.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+@class LYRConversation;
+@class LYRObjectChange;
+
+/**
+ @abstract Posted once a batch of updates changed the rollups. The object is the index.
+ */
+extern NSString *_Nonnull const ATLMConversationRollupIndexDidChangeNotification;
+
+/**
+ @abstract The orders the conversation list can be presented in. Ties are
+   broken by the most recent activity.
+ */
+typedef NS_ENUM(NSUInteger, ATLMConversationSortOrder) {
+    ATLMConversationSortOrderRecent         = 0, // Most recent activity first.
+    ATLMConversationSortOrderPinnedFirst    = 1, // Pinned conversations first.
+    ATLMConversationSortOrderUnreadFirst    = 2, // Pinned, then unread conversations which aren't muted first.
+    ATLMConversationSortOrderTitle          = 3, // Alphabetically by title.
+};
+
+/**
+ @abstract What the conversation list shows about a conversation.
+ */
+@interface ATLMConversationRollup : NSObject
+
+@property (nonnull, nonatomic, readonly) NSURL *conversationIdentifier;
+
+/**
+ @abstract The time of the last message or, without messages, the creation of the conversation.
+ */
+@property (nonnull, nonatomic, readonly) NSDate *lastActivityDate;
+
+@property (nonatomic, readonly) NSUInteger unreadCount;
+@property (nonatomic, readonly, getter=isPinned) BOOL pinned;
+@property (nonatomic, readonly, getter=isMuted) BOOL muted;
+
+/**
+ @abstract The title folded for sorting: the conversation name or the names of the other participants.
+ */
+@property (nonnull, nonatomic, readonly) NSString *titleKey;
+
+@end
+
+/**
+ @abstract The `ATLMConversationRollupIndex` keeps a rollup of every
+   conversation and the conversations sorted in each `ATLMConversationSortOrder`.
+ @discussion The index is loaded once with `reloadWithConversations:` and
+   then kept up to date from the client's object changes. Each update moves a
+   conversation within every order in O(log n) time, and rows are looked up
+   by position and positions by conversation in O(log n) time, so the list
+   can be re-sorted and paged through without querying the client.
+
+   Pinned and muted are local preferences, persisted separately. All methods
+   must be called on the main thread.
+ */
+@interface ATLMConversationRollupIndex : NSObject
+
+/**
+ @abstract Creates an index restoring the pinned and muted conversations persisted at `path`.
+ @param path The path of the file the preferences are persisted to or `nil` to keep them in memory only.
+ */
++ (nonnull instancetype)indexWithPersistencePath:(nullable NSString *)path;
+
+/**
+ @abstract The user whose name is left out of titles.
+ */
+@property (nullable, nonatomic, copy) NSString *authenticatedUserID;
+
+///----------------
+/// @name Updating
+///----------------
+
+/**
+ @abstract Replaces the content of the index with the supplied conversations.
+ */
+- (void)reloadWithConversations:(nonnull id<NSFastEnumeration>)conversations;
+
+/**
+ @abstract Inserts or refreshes the rollups of a batch of conversations, such as a page of a reload.
+ */
+- (void)updateConversations:(nonnull id<NSFastEnumeration>)conversations;
+
+/**
+ @abstract Inserts or refreshes the rollup of a conversation.
+ */
+- (void)updateConversation:(nonnull LYRConversation *)conversation;
+
+/**
+ @abstract Inserts or refreshes a rollup from its values.
+ */
+- (void)updateConversationWithIdentifier:(nonnull NSURL *)conversationIdentifier lastActivityDate:(nonnull NSDate *)lastActivityDate unreadCount:(NSUInteger)unreadCount title:(nonnull NSString *)title;
+
+- (void)removeConversationWithIdentifier:(nonnull NSURL *)conversationIdentifier;
+
+/**
+ @abstract Applies a batch of changes from `layerClient:objectsDidChange:`.
+ @discussion Each conversation touched by the batch, directly or through its
+   messages, is refreshed once.
+ */
+- (void)applyChanges:(nonnull NSArray<LYRObjectChange *> *)changes;
+
+- (void)setPinned:(BOOL)pinned forConversationWithIdentifier:(nonnull NSURL *)conversationIdentifier;
+- (void)setMuted:(BOOL)muted forConversationWithIdentifier:(nonnull NSURL *)conversationIdentifier;
+
+///-----------------
+/// @name Accessing
+///-----------------
+
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ @abstract The number of unread messages in conversations which aren't muted.
+ */
+@property (nonatomic, readonly) NSUInteger unreadCount;
+
+/**
+ @abstract The number of unread messages in all conversations, muted or not.
+ */
+@property (nonatomic, readonly) NSUInteger totalUnreadCount;
+
+- (nullable ATLMConversationRollup *)rollupForConversationWithIdentifier:(nonnull NSURL *)conversationIdentifier;
+
+/**
+ @abstract Returns the conversation at a row of the list sorted in the supplied order.
+ */
+- (nonnull NSURL *)conversationIdentifierAtIndex:(NSUInteger)index sortOrder:(ATLMConversationSortOrder)sortOrder;
+
+/**
+ @return The row of the conversation or `NSNotFound` if it isn't in the index.
+ */
+- (NSUInteger)indexOfConversationWithIdentifier:(nonnull NSURL *)conversationIdentifier sortOrder:(ATLMConversationSortOrder)sortOrder;
+
+/**
+ @abstract Returns the conversations of a range of rows in the supplied order.
+ */
+- (nonnull NSArray<NSURL *> *)conversationIdentifiersInRange:(NSRange)range sortOrder:(ATLMConversationSortOrder)sortOrder;
+
+@end
@@ -0,0 +1,570 @@
+//
+//  ATLMConversationRollupIndex.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMConversationRollupIndex.h"
+#import <LayerKit/LayerKit.h>
+#import "ATLMConversationDetailViewController.h"
+
+NSString *const ATLMConversationRollupIndexDidChangeNotification = @"ATLMConversationRollupIndexDidChangeNotification";
+
+static NSString *const ATLMConversationRollupIndexPinnedKey = @"pinned";
+static NSString *const ATLMConversationRollupIndexMutedKey = @"muted";
+static const NSUInteger ATLMConversationSortOrderCount = ATLMConversationSortOrderTitle + 1;
+
+#pragma mark - Sorted Trees
+
+/**
+ @abstract The fields a conversation is sorted by, copied into each tree node.
+ @discussion `titleKey` is owned by the rollup, which keeps it alive until the
+   node is removed. `ordinal` is unique and makes every key distinct.
+ */
+typedef struct {
+    double lastActivity;
+    uint64_t ordinal;
+    CFStringRef titleKey;
+    BOOL pinned;
+    BOOL unread;
+} ATLMRollupKey;
+
+/**
+ @abstract A node of a treap augmented with subtree sizes, which gives
+   positions in O(log n) expected time.
+ */
+typedef struct ATLMRollupNode {
+    struct ATLMRollupNode *left;
+    struct ATLMRollupNode *right;
+    uint32_t priority;
+    uint32_t size;
+    ATLMRollupKey key;
+    const void *conversationIdentifier;
+} ATLMRollupNode;
+
+static int ATLMRollupCompareKeys(ATLMConversationSortOrder sortOrder, const ATLMRollupKey *key, const ATLMRollupKey *otherKey)
+{
+    if (sortOrder == ATLMConversationSortOrderPinnedFirst || sortOrder == ATLMConversationSortOrderUnreadFirst) {
+        if (key->pinned != otherKey->pinned) {
+            return key->pinned ? -1 : 1;
+        }
+    }
+    if (sortOrder == ATLMConversationSortOrderUnreadFirst && key->unread != otherKey->unread) {
+        return key->unread ? -1 : 1;
+    }
+    if (sortOrder == ATLMConversationSortOrderTitle) {
+        CFComparisonResult result = CFStringCompare(key->titleKey, otherKey->titleKey, 0);
+        if (result != kCFCompareEqualTo) {
+            return (int)result;
+        }
+    }
+    if (key->lastActivity != otherKey->lastActivity) {
+        return key->lastActivity > otherKey->lastActivity ? -1 : 1;
+    }
+    if (key->ordinal != otherKey->ordinal) {
+        return key->ordinal < otherKey->ordinal ? -1 : 1;
+    }
+    return 0;
+}
+
+static uint32_t ATLMRollupNodeSize(ATLMRollupNode *node)
+{
+    return node ? node->size : 0;
+}
+
+static void ATLMRollupNodeUpdateSize(ATLMRollupNode *node)
+{
+    node->size = 1 + ATLMRollupNodeSize(node->left) + ATLMRollupNodeSize(node->right);
+}
+
+/**
+ @abstract Splits a tree into the nodes sorted before the key and the others.
+ */
+static void ATLMRollupSplit(ATLMConversationSortOrder sortOrder, ATLMRollupNode *node, const ATLMRollupKey *key, ATLMRollupNode **left, ATLMRollupNode **right)
+{
+    if (!node) {
+        *left = NULL;
+        *right = NULL;
+        return;
+    }
+    if (ATLMRollupCompareKeys(sortOrder, &node->key, key) < 0) {
+        ATLMRollupSplit(sortOrder, node->right, key, &node->right, right);
+        *left = node;
+    } else {
+        ATLMRollupSplit(sortOrder, node->left, key, left, &node->left);
+        *right = node;
+    }
+    ATLMRollupNodeUpdateSize(node);
+}
+
+/**
+ @abstract Joins two trees whose nodes are all sorted before those of the second.
+ */
+static ATLMRollupNode *ATLMRollupMerge(ATLMRollupNode *left, ATLMRollupNode *right)
+{
+    if (!left || !right) {
+        return left ?: right;
+    }
+    if (left->priority > right->priority) {
+        left->right = ATLMRollupMerge(left->right, right);
+        ATLMRollupNodeUpdateSize(left);
+        return left;
+    }
+    right->left = ATLMRollupMerge(left, right->left);
+    ATLMRollupNodeUpdateSize(right);
+    return right;
+}
+
+static ATLMRollupNode *ATLMRollupInsert(ATLMConversationSortOrder sortOrder, ATLMRollupNode *root, ATLMRollupNode *node)
+{
+    ATLMRollupNode *left;
+    ATLMRollupNode *right;
+    ATLMRollupSplit(sortOrder, root, &node->key, &left, &right);
+    return ATLMRollupMerge(ATLMRollupMerge(left, node), right);
+}
+
+static ATLMRollupNode *ATLMRollupRemove(ATLMConversationSortOrder sortOrder, ATLMRollupNode *node, const ATLMRollupKey *key)
+{
+    if (!node) {
+        return NULL;
+    }
+    int result = ATLMRollupCompareKeys(sortOrder, key, &node->key);
+    if (result == 0) {
+        ATLMRollupNode *replacement = ATLMRollupMerge(node->left, node->right);
+        free(node);
+        return replacement;
+    }
+    if (result < 0) {
+        node->left = ATLMRollupRemove(sortOrder, node->left, key);
+    } else {
+        node->right = ATLMRollupRemove(sortOrder, node->right, key);
+    }
+    ATLMRollupNodeUpdateSize(node);
+    return node;
+}
+
+static NSUInteger ATLMRollupIndexOfKey(ATLMConversationSortOrder sortOrder, ATLMRollupNode *node, const ATLMRollupKey *key)
+{
+    NSUInteger index = 0;
+    while (node) {
+        int result = ATLMRollupCompareKeys(sortOrder, key, &node->key);
+        if (result == 0) {
+            return index + ATLMRollupNodeSize(node->left);
+        }
+        if (result < 0) {
+            node = node->left;
+        } else {
+            index += ATLMRollupNodeSize(node->left) + 1;
+            node = node->right;
+        }
+    }
+    return NSNotFound;
+}
+
+static ATLMRollupNode *ATLMRollupNodeAtIndex(ATLMRollupNode *node, NSUInteger index)
+{
+    while (node) {
+        NSUInteger leftSize = ATLMRollupNodeSize(node->left);
+        if (index == leftSize) {
+            return node;
+        }
+        if (index < leftSize) {
+            node = node->left;
+        } else {
+            index -= leftSize + 1;
+            node = node->right;
+        }
+    }
+    return NULL;
+}
+
+static void ATLMRollupFree(ATLMRollupNode *node)
+{
+    if (!node) {
+        return;
+    }
+    ATLMRollupFree(node->left);
+    ATLMRollupFree(node->right);
+    free(node);
+}
+
+#pragma mark - Rollups
+
+@interface ATLMConversationRollup ()
+
+@property (nonnull, nonatomic, readwrite) NSURL *conversationIdentifier;
+@property (nonnull, nonatomic, readwrite) NSDate *lastActivityDate;
+@property (nonatomic, readwrite) NSUInteger unreadCount;
+@property (nonatomic, readwrite, getter=isPinned) BOOL pinned;
+@property (nonatomic, readwrite, getter=isMuted) BOOL muted;
+@property (nonnull, nonatomic, readwrite) NSString *titleKey;
+@property (nonatomic) uint64_t ordinal;
+@property (nonatomic, readonly) ATLMRollupKey key;
+@property (nonatomic, readonly) NSUInteger unmutedUnreadCount;
+
+@end
+
+@implementation ATLMConversationRollup
+
+- (ATLMRollupKey)key
+{
+    return (ATLMRollupKey){ self.lastActivityDate.timeIntervalSinceReferenceDate, self.ordinal, (__bridge CFStringRef)self.titleKey, self.pinned, self.unreadCount > 0 && !self.muted };
+}
+
+- (NSUInteger)unmutedUnreadCount
+{
+    return self.muted ? 0 : self.unreadCount;
+}
+
+@end
+
+#pragma mark - Index
+
+@interface ATLMConversationRollupIndex ()
+
+@property (nullable, nonatomic) NSString *persistencePath;
+@property (nonnull, nonatomic) NSMutableDictionary *rollupsByConversationIdentifier;
+@property (nonnull, nonatomic) NSMutableSet *pinnedConversationIdentifiers;
+@property (nonnull, nonatomic) NSMutableSet *mutedConversationIdentifiers;
+@property (nonatomic, readwrite) NSUInteger unreadCount;
+@property (nonatomic, readwrite) NSUInteger totalUnreadCount;
+@property (nonatomic) uint64_t nextOrdinal;
+
+@end
+
+@implementation ATLMConversationRollupIndex
+{
+    ATLMRollupNode *_roots[ATLMConversationSortOrderCount];
+}
+
++ (instancetype)indexWithPersistencePath:(NSString *)path
+{
+    return [[self alloc] initWithPersistencePath:path];
+}
+
+- (id)initWithPersistencePath:(NSString *)path
+{
+    self = [super init];
+    if (self) {
+        _persistencePath = [path copy];
+        _rollupsByConversationIdentifier = [NSMutableDictionary new];
+        _pinnedConversationIdentifiers = [NSMutableSet new];
+        _mutedConversationIdentifiers = [NSMutableSet new];
+        if (path) {
+            NSDictionary *preferences = [NSDictionary dictionaryWithContentsOfFile:path];
+            for (NSString *identifier in preferences[ATLMConversationRollupIndexPinnedKey]) {
+                [_pinnedConversationIdentifiers addObject:[NSURL URLWithString:identifier]];
+            }
+            for (NSString *identifier in preferences[ATLMConversationRollupIndexMutedKey]) {
+                [_mutedConversationIdentifiers addObject:[NSURL URLWithString:identifier]];
+            }
+        }
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use indexWithPersistencePath:" userInfo:nil];
+}
+
+- (void)dealloc
+{
+    [self removeAllNodes];
+}
+
+#pragma mark - Updating
+
+- (void)reloadWithConversations:(id<NSFastEnumeration>)conversations
+{
+    [self removeAllNodes];
+    [self.rollupsByConversationIdentifier removeAllObjects];
+    self.unreadCount = 0;
+    self.totalUnreadCount = 0;
+    for (LYRConversation *conversation in conversations) {
+        [self refreshConversation:conversation];
+    }
+    [self postDidChangeNotification];
+}
+
+- (void)updateConversations:(id<NSFastEnumeration>)conversations
+{
+    for (LYRConversation *conversation in conversations) {
+        [self refreshConversation:conversation];
+    }
+    [self postDidChangeNotification];
+}
+
+- (void)updateConversation:(LYRConversation *)conversation
+{
+    [self refreshConversation:conversation];
+    [self postDidChangeNotification];
+}
+
+- (void)updateConversationWithIdentifier:(NSURL *)conversationIdentifier lastActivityDate:(NSDate *)lastActivityDate unreadCount:(NSUInteger)unreadCount title:(NSString *)title
+{
+    [self refreshConversationWithIdentifier:conversationIdentifier lastActivityDate:lastActivityDate unreadCount:unreadCount title:title];
+    [self postDidChangeNotification];
+}
+
+- (void)removeConversationWithIdentifier:(NSURL *)conversationIdentifier
+{
+    if ([self removeRollupWithIdentifier:conversationIdentifier]) {
+        [self postDidChangeNotification];
+    }
+}
+
+- (void)applyChanges:(NSArray *)changes
+{
+    NSMutableOrderedSet *conversations = [NSMutableOrderedSet new];
+    NSMutableSet *deletedConversationIdentifiers = [NSMutableSet new];
+    for (LYRObjectChange *change in changes) {
+        if ([change.object isKindOfClass:[LYRConversation class]]) {
+            LYRConversation *conversation = change.object;
+            if (change.type == LYRObjectChangeTypeDelete) {
+                [deletedConversationIdentifiers addObject:conversation.identifier];
+            } else {
+                [conversations addObject:conversation];
+            }
+        } else if ([change.object isKindOfClass:[LYRMessage class]]) {
+            // New, read and deleted messages move the last activity and unread count.
+            LYRConversation *conversation = [change.object conversation];
+            if (conversation) {
+                [conversations addObject:conversation];
+            }
+        }
+    }
+    BOOL changed = NO;
+    for (NSURL *conversationIdentifier in deletedConversationIdentifiers) {
+        changed |= [self removeRollupWithIdentifier:conversationIdentifier];
+    }
+    for (LYRConversation *conversation in conversations) {
+        if (conversation.identifier && ![deletedConversationIdentifiers containsObject:conversation.identifier] && !conversation.isDeleted) {
+            [self refreshConversation:conversation];
+            changed = YES;
+        }
+    }
+    if (changed) {
+        [self postDidChangeNotification];
+    }
+}
+
+- (void)setPinned:(BOOL)pinned forConversationWithIdentifier:(NSURL *)conversationIdentifier
+{
+    if (pinned == [self.pinnedConversationIdentifiers containsObject:conversationIdentifier]) {
+        return;
+    }
+    if (pinned) {
+        [self.pinnedConversationIdentifiers addObject:conversationIdentifier];
+    } else {
+        [self.pinnedConversationIdentifiers removeObject:conversationIdentifier];
+    }
+    if (self.rollupsByConversationIdentifier[conversationIdentifier]) {
+        [self updateRollupWithIdentifier:conversationIdentifier usingBlock:^(ATLMConversationRollup *rollup) {
+            rollup.pinned = pinned;
+        }];
+    }
+    [self persist];
+    [self postDidChangeNotification];
+}
+
+- (void)setMuted:(BOOL)muted forConversationWithIdentifier:(NSURL *)conversationIdentifier
+{
+    if (muted == [self.mutedConversationIdentifiers containsObject:conversationIdentifier]) {
+        return;
+    }
+    if (muted) {
+        [self.mutedConversationIdentifiers addObject:conversationIdentifier];
+    } else {
+        [self.mutedConversationIdentifiers removeObject:conversationIdentifier];
+    }
+    if (self.rollupsByConversationIdentifier[conversationIdentifier]) {
+        [self updateRollupWithIdentifier:conversationIdentifier usingBlock:^(ATLMConversationRollup *rollup) {
+            rollup.muted = muted;
+        }];
+    }
+    [self persist];
+    [self postDidChangeNotification];
+}
+
+#pragma mark - Accessing
+
+- (NSUInteger)count
+{
+    return self.rollupsByConversationIdentifier.count;
+}
+
+- (ATLMConversationRollup *)rollupForConversationWithIdentifier:(NSURL *)conversationIdentifier
+{
+    return self.rollupsByConversationIdentifier[conversationIdentifier];
+}
+
+- (NSURL *)conversationIdentifierAtIndex:(NSUInteger)index sortOrder:(ATLMConversationSortOrder)sortOrder
+{
+    NSParameterAssert(sortOrder < ATLMConversationSortOrderCount);
+    ATLMRollupNode *node = ATLMRollupNodeAtIndex(_roots[sortOrder], index);
+    if (!node) {
+        @throw [NSException exceptionWithName:NSRangeException reason:[NSString stringWithFormat:@"Index %lu beyond bounds [0 .. %lu]", (unsigned long)index, (unsigned long)self.count] userInfo:nil];
+    }
+    return (__bridge NSURL *)node->conversationIdentifier;
+}
+
+- (NSUInteger)indexOfConversationWithIdentifier:(NSURL *)conversationIdentifier sortOrder:(ATLMConversationSortOrder)sortOrder
+{
+    NSParameterAssert(sortOrder < ATLMConversationSortOrderCount);
+    ATLMConversationRollup *rollup = self.rollupsByConversationIdentifier[conversationIdentifier];
+    if (!rollup) {
+        return NSNotFound;
+    }
+    ATLMRollupKey key = rollup.key;
+    return ATLMRollupIndexOfKey(sortOrder, _roots[sortOrder], &key);
+}
+
+- (NSArray *)conversationIdentifiersInRange:(NSRange)range sortOrder:(ATLMConversationSortOrder)sortOrder
+{
+    NSParameterAssert(sortOrder < ATLMConversationSortOrderCount);
+    NSUInteger end = MIN(NSMaxRange(range), self.count);
+    NSMutableArray *conversationIdentifiers = [NSMutableArray arrayWithCapacity:end > range.location ? end - range.location : 0];
+    for (NSUInteger index = range.location; index < end; index++) {
+        [conversationIdentifiers addObject:(__bridge NSURL *)ATLMRollupNodeAtIndex(_roots[sortOrder], index)->conversationIdentifier];
+    }
+    return conversationIdentifiers;
+}
+
+#pragma mark - Helpers
+
+- (void)refreshConversation:(LYRConversation *)conversation
+{
+    NSDate *lastActivityDate = conversation.lastMessage.receivedAt ?: conversation.lastMessage.sentAt ?: conversation.createdAt ?: [NSDate distantPast];
+    [self refreshConversationWithIdentifier:conversation.identifier lastActivityDate:lastActivityDate unreadCount:conversation.totalNumberOfUnreadMessages title:[self titleForConversation:conversation]];
+}
+
+- (NSString *)titleForConversation:(LYRConversation *)conversation
+{
+    NSString *conversationName = conversation.metadata[ATLMConversationMetadataNameKey];
+    if (conversationName.length) {
+        return conversationName;
+    }
+    NSMutableArray *names = [NSMutableArray arrayWithCapacity:conversation.participants.count];
+    for (LYRIdentity *participant in conversation.participants) {
+        if (participant.displayName && ![participant.userID isEqualToString:self.authenticatedUserID]) {
+            [names addObject:participant.displayName];
+        }
+    }
+    [names sortUsingSelector:@selector(localizedCaseInsensitiveCompare:)];
+    return [names componentsJoinedByString:@", "];
+}
+
+- (void)refreshConversationWithIdentifier:(NSURL *)conversationIdentifier lastActivityDate:(NSDate *)lastActivityDate unreadCount:(NSUInteger)unreadCount title:(NSString *)title
+{
+    NSString *titleKey = [title stringByFoldingWithOptions:NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch | NSWidthInsensitiveSearch locale:nil];
+    ATLMConversationRollup *rollup = self.rollupsByConversationIdentifier[conversationIdentifier];
+    if (rollup && [rollup.lastActivityDate isEqualToDate:lastActivityDate] && rollup.unreadCount == unreadCount && [rollup.titleKey isEqualToString:titleKey]) {
+        return;
+    }
+    [self updateRollupWithIdentifier:conversationIdentifier usingBlock:^(ATLMConversationRollup *rollup) {
+        rollup.lastActivityDate = lastActivityDate;
+        rollup.unreadCount = unreadCount;
+        rollup.titleKey = titleKey;
+    }];
+}
+
+/**
+ @abstract Takes the rollup out of every tree, lets the block change it and puts it back, creating it if needed.
+ */
+- (void)updateRollupWithIdentifier:(NSURL *)conversationIdentifier usingBlock:(void (^)(ATLMConversationRollup *rollup))block
+{
+    ATLMConversationRollup *rollup = self.rollupsByConversationIdentifier[conversationIdentifier];
+    if (rollup) {
+        [self detachRollup:rollup];
+    } else {
+        rollup = [ATLMConversationRollup new];
+        rollup.conversationIdentifier = conversationIdentifier;
+        rollup.lastActivityDate = [NSDate distantPast];
+        rollup.titleKey = @"";
+        rollup.ordinal = self.nextOrdinal++;
+        rollup.pinned = [self.pinnedConversationIdentifiers containsObject:conversationIdentifier];
+        rollup.muted = [self.mutedConversationIdentifiers containsObject:conversationIdentifier];
+        self.rollupsByConversationIdentifier[conversationIdentifier] = rollup;
+    }
+    block(rollup);
+    [self attachRollup:rollup];
+}
+
+- (BOOL)removeRollupWithIdentifier:(NSURL *)conversationIdentifier
+{
+    ATLMConversationRollup *rollup = self.rollupsByConversationIdentifier[conversationIdentifier];
+    if (!rollup) {
+        return NO;
+    }
+    [self detachRollup:rollup];
+    [self.rollupsByConversationIdentifier removeObjectForKey:conversationIdentifier];
+    return YES;
+}
+
+- (void)attachRollup:(ATLMConversationRollup *)rollup
+{
+    ATLMRollupKey key = rollup.key;
+    for (NSUInteger sortOrder = 0; sortOrder < ATLMConversationSortOrderCount; sortOrder++) {
+        ATLMRollupNode *node = calloc(1, sizeof(ATLMRollupNode));
+        node->priority = arc4random();
+        node->size = 1;
+        node->key = key;
+        node->conversationIdentifier = (__bridge const void *)rollup.conversationIdentifier;
+        _roots[sortOrder] = ATLMRollupInsert(sortOrder, _roots[sortOrder], node);
+    }
+    self.unreadCount += rollup.unmutedUnreadCount;
+    self.totalUnreadCount += rollup.unreadCount;
+}
+
+- (void)detachRollup:(ATLMConversationRollup *)rollup
+{
+    ATLMRollupKey key = rollup.key;
+    for (NSUInteger sortOrder = 0; sortOrder < ATLMConversationSortOrderCount; sortOrder++) {
+        _roots[sortOrder] = ATLMRollupRemove(sortOrder, _roots[sortOrder], &key);
+    }
+    self.unreadCount -= rollup.unmutedUnreadCount;
+    self.totalUnreadCount -= rollup.unreadCount;
+}
+
+- (void)removeAllNodes
+{
+    for (NSUInteger sortOrder = 0; sortOrder < ATLMConversationSortOrderCount; sortOrder++) {
+        ATLMRollupFree(_roots[sortOrder]);
+        _roots[sortOrder] = NULL;
+    }
+}
+
+- (void)postDidChangeNotification
+{
+    [[NSNotificationCenter defaultCenter] postNotificationName:ATLMConversationRollupIndexDidChangeNotification object:self];
+}
+
+- (void)persist
+{
+    if (!self.persistencePath) {
+        return;
+    }
+    NSDictionary *preferences = @{ ATLMConversationRollupIndexPinnedKey: [self.pinnedConversationIdentifiers.allObjects valueForKey:@"absoluteString"],
+                                   ATLMConversationRollupIndexMutedKey: [self.mutedConversationIdentifiers.allObjects valueForKey:@"absoluteString"] };
+    BOOL success = [preferences writeToFile:self.persistencePath atomically:YES];
+    if (!success) {
+        NSLog(@"Failed to persist conversation preferences to %@", self.persistencePath);
+    }
+}
+
+@end
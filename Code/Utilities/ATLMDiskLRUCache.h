@@ -0,0 +1,78 @@
+//
+//  ATLMDiskLRUCache.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ @abstract The `ATLMDiskLRUCache` keeps data in files of a directory up to a
+   byte limit, evicting the least recently used entries beyond it.
+ @discussion Keys are hashed into file names. The recency of the entries is
+   kept in memory and recorded in the modification dates of their files, which
+   a cache opening the directory again orders its entries by. All methods are
+   thread safe; since they read and write files, they shouldn't be called on
+   the main thread.
+ */
+@interface ATLMDiskLRUCache : NSObject
+
+/**
+ @abstract Creates a cache over the files of a directory, which is created if needed.
+ @param directory The directory the cache owns.
+ @param byteLimit The total size of the files kept.
+ @return A new `ATLMDiskLRUCache` instance.
+ */
++ (nonnull instancetype)cacheWithDirectory:(nonnull NSString *)directory byteLimit:(NSUInteger)byteLimit;
+
+@property (nonnull, nonatomic, readonly) NSString *directory;
+
+/**
+ @abstract The total size of the files kept. Lowering it evicts entries right away.
+ */
+@property (nonatomic) NSUInteger byteLimit;
+
+/**
+ @abstract Returns the data stored for a key and marks it as the most recently used.
+ */
+- (nullable NSData *)dataForKey:(nonnull NSString *)key;
+
+/**
+ @abstract Stores data for a key, replacing any previous data, and evicts
+   the least recently used entries beyond the byte limit.
+ @discussion Data larger than the byte limit is not stored.
+ */
+- (void)setData:(nonnull NSData *)data forKey:(nonnull NSString *)key;
+
+- (void)removeDataForKey:(nonnull NSString *)key;
+- (void)removeAllData;
+
+///--------------
+/// @name Metrics
+///--------------
+
+@property (nonatomic, readonly) NSUInteger count;
+@property (nonatomic, readonly) NSUInteger totalBytes;
+@property (nonatomic, readonly) NSUInteger countOfHits;
+@property (nonatomic, readonly) NSUInteger countOfMisses;
+
+/**
+ @abstract The number of entries removed to stay within the byte limit.
+ */
+@property (nonatomic, readonly) NSUInteger countOfEvictions;
+
+@end
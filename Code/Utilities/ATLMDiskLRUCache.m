@@ -0,0 +1,243 @@
+//
+//  ATLMDiskLRUCache.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMDiskLRUCache.h"
+#import <CommonCrypto/CommonDigest.h>
+#import <pthread.h>
+#import <sys/time.h>
+
+static NSString *ATLMDiskLRUCacheFileName(NSString *key)
+{
+    NSData *keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+    unsigned char digest[CC_SHA1_DIGEST_LENGTH];
+    CC_SHA1(keyData.bytes, (CC_LONG)keyData.length, digest);
+    NSMutableString *fileName = [NSMutableString stringWithCapacity:CC_SHA1_DIGEST_LENGTH * 2];
+    for (NSUInteger index = 0; index < CC_SHA1_DIGEST_LENGTH; index++) {
+        [fileName appendFormat:@"%02x", digest[index]];
+    }
+    return fileName;
+}
+
+@interface ATLMDiskLRUCache ()
+
+@property (nonnull, nonatomic, readwrite) NSString *directory;
+@property (nonnull, nonatomic) NSMutableDictionary<NSString *, NSNumber *> *sizesByFileName;
+@property (nonnull, nonatomic) NSMutableOrderedSet<NSString *> *fileNames;  // Least recently used first.
+
+@end
+
+@implementation ATLMDiskLRUCache
+{
+    pthread_mutex_t _lock;
+    NSUInteger _totalBytes;
+    NSUInteger _countOfHits;
+    NSUInteger _countOfMisses;
+    NSUInteger _countOfEvictions;
+}
+
++ (instancetype)cacheWithDirectory:(NSString *)directory byteLimit:(NSUInteger)byteLimit
+{
+    return [[self alloc] initWithDirectory:directory byteLimit:byteLimit];
+}
+
+- (id)initWithDirectory:(NSString *)directory byteLimit:(NSUInteger)byteLimit
+{
+    NSParameterAssert(directory);
+    self = [super init];
+    if (self) {
+        pthread_mutex_init(&_lock, NULL);
+        _directory = [directory copy];
+        _byteLimit = byteLimit;
+        _sizesByFileName = [NSMutableDictionary new];
+        _fileNames = [NSMutableOrderedSet new];
+        [self loadEntries];
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use cacheWithDirectory:byteLimit:" userInfo:nil];
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+- (void)loadEntries
+{
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSError *error;
+    if (![fileManager createDirectoryAtPath:self.directory withIntermediateDirectories:YES attributes:nil error:&error]) {
+        NSLog(@"Failed to create the cache directory %@: %@", self.directory, error);
+        return;
+    }
+    NSURL *directoryURL = [NSURL fileURLWithPath:self.directory isDirectory:YES];
+    NSArray *keys = @[ NSURLContentModificationDateKey, NSURLFileSizeKey ];
+    NSArray *fileURLs = [fileManager contentsOfDirectoryAtURL:directoryURL includingPropertiesForKeys:keys options:NSDirectoryEnumerationSkipsHiddenFiles error:nil];
+    NSMutableDictionary *datesByFileName = [NSMutableDictionary dictionaryWithCapacity:fileURLs.count];
+    for (NSURL *fileURL in fileURLs) {
+        NSDictionary *values = [fileURL resourceValuesForKeys:keys error:nil];
+        NSString *fileName = fileURL.lastPathComponent;
+        datesByFileName[fileName] = values[NSURLContentModificationDateKey] ?: [NSDate distantPast];
+        self.sizesByFileName[fileName] = values[NSURLFileSizeKey] ?: @0;
+        _totalBytes += [values[NSURLFileSizeKey] unsignedIntegerValue];
+    }
+    [self.fileNames addObjectsFromArray:[datesByFileName keysSortedByValueUsingSelector:@selector(compare:)]];
+    [self evictEntriesBeyondByteLimit];
+}
+
+#pragma mark - Data
+
+- (NSData *)dataForKey:(NSString *)key
+{
+    NSString *fileName = ATLMDiskLRUCacheFileName(key);
+    NSString *path = [self.directory stringByAppendingPathComponent:fileName];
+    pthread_mutex_lock(&_lock);
+    NSData *data = self.sizesByFileName[fileName] ? [NSData dataWithContentsOfFile:path] : nil;
+    if (data) {
+        _countOfHits += 1;
+        [self.fileNames removeObject:fileName];
+        [self.fileNames addObject:fileName];
+        // Records the use for the next time the directory is opened.
+        utimes(path.fileSystemRepresentation, NULL);
+    } else {
+        _countOfMisses += 1;
+        [self removeEntryWithFileName:fileName];
+    }
+    pthread_mutex_unlock(&_lock);
+    return data;
+}
+
+- (void)setData:(NSData *)data forKey:(NSString *)key
+{
+    NSString *fileName = ATLMDiskLRUCacheFileName(key);
+    NSString *path = [self.directory stringByAppendingPathComponent:fileName];
+    pthread_mutex_lock(&_lock);
+    [self removeEntryWithFileName:fileName];
+    if (data.length <= self.byteLimit) {
+        NSError *error;
+        if ([data writeToFile:path options:NSDataWritingAtomic error:&error]) {
+            self.sizesByFileName[fileName] = @(data.length);
+            [self.fileNames addObject:fileName];
+            _totalBytes += data.length;
+            [self evictEntriesBeyondByteLimit];
+        } else {
+            NSLog(@"Failed to write the cache entry %@: %@", path, error);
+        }
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+- (void)removeDataForKey:(NSString *)key
+{
+    pthread_mutex_lock(&_lock);
+    [self removeEntryWithFileName:ATLMDiskLRUCacheFileName(key)];
+    pthread_mutex_unlock(&_lock);
+}
+
+- (void)removeAllData
+{
+    pthread_mutex_lock(&_lock);
+    for (NSString *fileName in self.fileNames) {
+        [[NSFileManager defaultManager] removeItemAtPath:[self.directory stringByAppendingPathComponent:fileName] error:nil];
+    }
+    [self.fileNames removeAllObjects];
+    [self.sizesByFileName removeAllObjects];
+    _totalBytes = 0;
+    pthread_mutex_unlock(&_lock);
+}
+
+- (void)setByteLimit:(NSUInteger)byteLimit
+{
+    pthread_mutex_lock(&_lock);
+    _byteLimit = byteLimit;
+    [self evictEntriesBeyondByteLimit];
+    pthread_mutex_unlock(&_lock);
+}
+
+#pragma mark - Entries
+
+// Must be called with the lock held.
+- (void)removeEntryWithFileName:(NSString *)fileName
+{
+    NSNumber *size = self.sizesByFileName[fileName];
+    if (!size) {
+        return;
+    }
+    [[NSFileManager defaultManager] removeItemAtPath:[self.directory stringByAppendingPathComponent:fileName] error:nil];
+    [self.sizesByFileName removeObjectForKey:fileName];
+    [self.fileNames removeObject:fileName];
+    _totalBytes -= MIN(size.unsignedIntegerValue, _totalBytes);
+}
+
+// Must be called with the lock held.
+- (void)evictEntriesBeyondByteLimit
+{
+    while (_totalBytes > _byteLimit && self.fileNames.count) {
+        [self removeEntryWithFileName:self.fileNames.firstObject];
+        _countOfEvictions += 1;
+    }
+}
+
+#pragma mark - Metrics
+
+- (NSUInteger)count
+{
+    pthread_mutex_lock(&_lock);
+    NSUInteger count = self.fileNames.count;
+    pthread_mutex_unlock(&_lock);
+    return count;
+}
+
+- (NSUInteger)totalBytes
+{
+    pthread_mutex_lock(&_lock);
+    NSUInteger totalBytes = _totalBytes;
+    pthread_mutex_unlock(&_lock);
+    return totalBytes;
+}
+
+- (NSUInteger)countOfHits
+{
+    pthread_mutex_lock(&_lock);
+    NSUInteger countOfHits = _countOfHits;
+    pthread_mutex_unlock(&_lock);
+    return countOfHits;
+}
+
+- (NSUInteger)countOfMisses
+{
+    pthread_mutex_lock(&_lock);
+    NSUInteger countOfMisses = _countOfMisses;
+    pthread_mutex_unlock(&_lock);
+    return countOfMisses;
+}
+
+- (NSUInteger)countOfEvictions
+{
+    pthread_mutex_lock(&_lock);
+    NSUInteger countOfEvictions = _countOfEvictions;
+    pthread_mutex_unlock(&_lock);
+    return countOfEvictions;
+}
+
+@end
@@ -37,4 +37,21 @@ typedef NS_ENUM(NSUInteger, ATLMAuthenticationError) {
     ATLMInvalidAppID                                  = 7009,
     ATLMInvalidIdentityToken                          = 7010,
     ATLMDeviceTypeNotSupported                       = 7011,
+
+    /* Remote Notification Errors */
+    ATLMRemoteNotificationBackgroundTimeExpired       = 7012,
+
+    /* Media Errors */
+    ATLMMediaTranscodingFailed                        = 7013,
+    ATLMMediaTypeNotSupported                         = 7014,
+
+    /* Search Errors */
+    ATLMInvalidSearchSegment                          = 7015,
+
+    /* Persistence Errors */
+    ATLMPersistenceEncodingFailed                     = 7016,
+    ATLMPersistenceDecodingFailed                     = 7017,
+
+    /* Avatar Errors */
+    ATLMAvatarImageDecodingFailed                     = 7018,
 };
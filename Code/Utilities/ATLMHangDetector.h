@@ -0,0 +1,152 @@
+//
+//  ATLMHangDetector.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ @abstract A stall of the main thread longer than the detector's threshold.
+ */
+@interface ATLMHang : NSObject
+
+@property (nonnull, nonatomic, readonly) NSDate *startDate;
+
+/**
+ @abstract The time from the ping the main thread stalled on to its answer.
+ */
+@property (nonatomic, readonly) NSTimeInterval duration;
+
+/**
+ @abstract The innermost operation begun on the main thread when the stall was detected.
+ */
+@property (nullable, nonatomic, readonly) NSString *operationTag;
+
+/**
+ @abstract The controller active when the main thread last answered a ping before the stall.
+ */
+@property (nullable, nonatomic, readonly) NSString *controllerName;
+
+/**
+ @abstract The symbolicated stacks of the main thread sampled during the stall, innermost frame first.
+ */
+@property (nonnull, nonatomic, readonly) NSArray<NSArray<NSString *> *> *stackSamples;
+
+- (nonnull NSDictionary *)dictionaryRepresentation;
+
+@end
+
+/**
+ @abstract The `ATLMHangDetector` watches the main thread for stalls.
+ @discussion A watchdog thread pings the main queue every `sampleInterval`.
+   Once a ping has gone unanswered for `threshold`, the detector samples the
+   stack of the main thread every `sampleInterval`, up to
+   `maximumSampleCount` times, by briefly suspending it from the watchdog
+   thread and following its frame pointers. When the ping is answered, the
+   stall is recorded as an `ATLMHang`, with the innermost operation tag and
+   the active controller, in a ring buffer of the last `capacity` hangs, and
+   its duration in the shared `ATLMInstrumentation`.
+
+   Operations are tagged by bracketing them with `beginOperation:` and
+   `endOperation:` on the main thread. The active controller is the name the
+   `activeControllerProvider` returns, called on the main thread whenever it
+   answers a ping.
+ */
+@interface ATLMHangDetector : NSObject
+
+/**
+ @abstract The detector watching the application's main thread.
+ */
++ (nonnull instancetype)sharedDetector;
+
+/**
+ @abstract Creates a standalone detector.
+ */
++ (nonnull instancetype)detector;
+
+/**
+ @abstract The time a ping has to go unanswered to count as a hang. Defaults to 0.25 seconds.
+ */
+@property (atomic) NSTimeInterval threshold;
+
+/**
+ @abstract The time between pings and between stack samples. Defaults to 0.05 seconds.
+ */
+@property (atomic) NSTimeInterval sampleInterval;
+
+/**
+ @abstract The number of stacks sampled per hang at most. Defaults to 5.
+ */
+@property (atomic) NSUInteger maximumSampleCount;
+
+/**
+ @abstract The number of hangs kept. Defaults to 32.
+ */
+@property (nonatomic) NSUInteger capacity;
+
+/**
+ @abstract Returns the name of the controller on screen; called on the main thread.
+ */
+@property (nullable, atomic, copy) NSString *_Nullable (^activeControllerProvider)(void);
+
+///----------------
+/// @name Watching
+///----------------
+
+- (void)start;
+- (void)stop;
+
+@property (nonatomic, readonly, getter=isRunning) BOOL running;
+
+///-------------------------
+/// @name Tagging Operations
+///-------------------------
+
+/**
+ @abstract Tags the work done on the main thread until the matching `endOperation:`.
+ @discussion Calls made off the main thread are ignored, so code running on
+   any thread can be tagged.
+ */
+- (void)beginOperation:(nonnull NSString *)tag;
+- (void)endOperation:(nonnull NSString *)tag;
+
+///---------------
+/// @name Hangs
+///---------------
+
+/**
+ @abstract The recorded hangs still in the ring buffer, oldest first.
+ */
+@property (nonnull, nonatomic, readonly) NSArray<ATLMHang *> *hangs;
+
+/**
+ @abstract The number of hangs detected, including the ones dropped from the ring buffer.
+ */
+@property (nonatomic, readonly) NSUInteger countOfHangs;
+
+/**
+ @abstract Returns `hangs` serialized as JSON, for export.
+ */
+- (nonnull NSData *)JSONSnapshot;
+
+/**
+ @abstract Clears the recorded hangs.
+ */
+- (void)reset;
+
+@end
@@ -0,0 +1,449 @@
+//
+//  ATLMHangDetector.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMHangDetector.h"
+#import <pthread.h>
+#import <execinfo.h>
+#import <mach/mach.h>
+#import "ATLMInstrumentation.h"
+#if __has_feature(ptrauth_calls)
+#import <ptrauth.h>
+#endif
+
+static const NSTimeInterval ATLMHangDetectorDefaultThreshold = 0.25;
+static const NSTimeInterval ATLMHangDetectorDefaultSampleInterval = 0.05;
+static const NSUInteger ATLMHangDetectorDefaultMaximumSampleCount = 5;
+static const NSUInteger ATLMHangDetectorDefaultCapacity = 32;
+
+#pragma mark - Stack Sampling
+
+#define ATLMHangDetectorMaximumFrameCount 128
+
+/**
+ @abstract The frame record pushed by a function's prologue, which the frame pointer points to.
+ */
+typedef struct ATLMStackFrame {
+    const struct ATLMStackFrame *previous;
+    uintptr_t returnAddress;
+} ATLMStackFrame;
+
+static uintptr_t ATLMStripReturnAddress(uintptr_t address)
+{
+#if __has_feature(ptrauth_calls)
+    return (uintptr_t)ptrauth_strip((void *)address, ptrauth_key_return_address);
+#else
+    return address;
+#endif
+}
+
+/**
+ @abstract Reads the program counter, link register and frame pointer of a suspended thread.
+ @discussion The link register is only meaningful on ARM, where a leaf
+   function returns through it without pushing a frame record; it's 0 elsewhere.
+ */
+static BOOL ATLMGetThreadRegisters(thread_t thread, uintptr_t *pc, uintptr_t *lr, uintptr_t *fp)
+{
+#if defined(__arm64__)
+    arm_thread_state64_t state;
+    mach_msg_type_number_t count = ARM_THREAD_STATE64_COUNT;
+    if (thread_get_state(thread, ARM_THREAD_STATE64, (thread_state_t)&state, &count) != KERN_SUCCESS) {
+        return NO;
+    }
+#ifdef arm_thread_state64_get_pc
+    *pc = (uintptr_t)arm_thread_state64_get_pc(state);
+    *lr = (uintptr_t)arm_thread_state64_get_lr(state);
+    *fp = (uintptr_t)arm_thread_state64_get_fp(state);
+#else
+    *pc = (uintptr_t)state.__pc;
+    *lr = (uintptr_t)state.__lr;
+    *fp = (uintptr_t)state.__fp;
+#endif
+#elif defined(__arm__)
+    arm_thread_state_t state;
+    mach_msg_type_number_t count = ARM_THREAD_STATE_COUNT;
+    if (thread_get_state(thread, ARM_THREAD_STATE, (thread_state_t)&state, &count) != KERN_SUCCESS) {
+        return NO;
+    }
+    *pc = state.__pc;
+    *lr = state.__lr;
+    *fp = state.__r[7];
+#elif defined(__x86_64__)
+    x86_thread_state64_t state;
+    mach_msg_type_number_t count = x86_THREAD_STATE64_COUNT;
+    if (thread_get_state(thread, x86_THREAD_STATE64, (thread_state_t)&state, &count) != KERN_SUCCESS) {
+        return NO;
+    }
+    *pc = (uintptr_t)state.__rip;
+    *lr = 0;
+    *fp = (uintptr_t)state.__rbp;
+#elif defined(__i386__)
+    x86_thread_state32_t state;
+    mach_msg_type_number_t count = x86_THREAD_STATE32_COUNT;
+    if (thread_get_state(thread, x86_THREAD_STATE32, (thread_state_t)&state, &count) != KERN_SUCCESS) {
+        return NO;
+    }
+    *pc = state.__eip;
+    *lr = 0;
+    *fp = state.__ebp;
+#else
+    return NO;
+#endif
+    return YES;
+}
+
+/**
+ @abstract Collects the return addresses of a suspended thread by following its frame pointers.
+ @discussion The thread may hold any lock, including the allocator's, so
+   nothing here allocates; the stack is read with `vm_read_overwrite`, which
+   fails instead of faulting on a corrupt frame pointer.
+ */
+static int ATLMWalkThreadStack(thread_t thread, void **frames, int maximumFrameCount)
+{
+    uintptr_t pc, lr, fp;
+    if (!ATLMGetThreadRegisters(thread, &pc, &lr, &fp)) {
+        return 0;
+    }
+    int frameCount = 0;
+    frames[frameCount++] = (void *)ATLMStripReturnAddress(pc);
+    if (lr) {
+        frames[frameCount++] = (void *)ATLMStripReturnAddress(lr);
+    }
+    while (fp && frameCount < maximumFrameCount) {
+        if (fp % sizeof(uintptr_t) != 0) {
+            break;
+        }
+        ATLMStackFrame frame;
+        vm_size_t readSize = 0;
+        if (vm_read_overwrite(mach_task_self(), (vm_address_t)fp, sizeof(frame), (vm_address_t)&frame, &readSize) != KERN_SUCCESS || readSize != sizeof(frame)) {
+            break;
+        }
+        if (!frame.returnAddress) {
+            break;
+        }
+        void *returnAddress = (void *)ATLMStripReturnAddress(frame.returnAddress);
+        // Outside of a leaf function, the link register holds the first return address too.
+        if (returnAddress != frames[frameCount - 1]) {
+            frames[frameCount++] = returnAddress;
+        }
+        // The stack grows down, so the callers' frames lie above.
+        if ((uintptr_t)frame.previous <= fp) {
+            break;
+        }
+        fp = (uintptr_t)frame.previous;
+    }
+    return frameCount;
+}
+
+/**
+ @abstract Returns the symbolicated stack of the main thread or `nil` if it couldn't be sampled.
+ @discussion The main thread is only suspended while its frames are walked;
+   they are symbolicated once it runs again.
+ */
+static NSArray<NSString *> *ATLMSampleMainThreadStack(void)
+{
+    static thread_t mainThread;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        mainThread = pthread_mach_thread_np(pthread_main_thread_np());
+    });
+    if (pthread_main_np()) {
+        return nil;
+    }
+    void *frames[ATLMHangDetectorMaximumFrameCount];
+    if (thread_suspend(mainThread) != KERN_SUCCESS) {
+        return nil;
+    }
+    int frameCount = ATLMWalkThreadStack(mainThread, frames, ATLMHangDetectorMaximumFrameCount);
+    thread_resume(mainThread);
+    if (frameCount == 0) {
+        return nil;
+    }
+    char **symbols = backtrace_symbols(frames, frameCount);
+    if (!symbols) {
+        return nil;
+    }
+    NSMutableArray *stack = [NSMutableArray arrayWithCapacity:frameCount];
+    for (int index = 0; index < frameCount; index++) {
+        [stack addObject:@(symbols[index])];
+    }
+    free(symbols);
+    return stack;
+}
+
+#pragma mark - Hangs
+
+@interface ATLMHang ()
+
+@property (nonnull, nonatomic, readwrite) NSDate *startDate;
+@property (nonatomic, readwrite) NSTimeInterval duration;
+@property (nullable, nonatomic, readwrite) NSString *operationTag;
+@property (nullable, nonatomic, readwrite) NSString *controllerName;
+@property (nonnull, nonatomic, readwrite) NSArray<NSArray<NSString *> *> *stackSamples;
+
+@end
+
+@implementation ATLMHang
+
+- (NSDictionary *)dictionaryRepresentation
+{
+    NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:5];
+    dictionary[@"start"] = @(self.startDate.timeIntervalSince1970);
+    dictionary[@"duration"] = @(self.duration);
+    dictionary[@"operation"] = self.operationTag;
+    dictionary[@"controller"] = self.controllerName;
+    dictionary[@"stacks"] = self.stackSamples;
+    return dictionary;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@:%p duration=%.3fs operation=%@ controller=%@ samples=%lu>", [self class], self, self.duration, self.operationTag, self.controllerName, (unsigned long)self.stackSamples.count];
+}
+
+@end
+
+#pragma mark - Detector
+
+@interface ATLMHangDetector () {
+    pthread_mutex_t _lock;
+}
+
+@property (nullable, nonatomic) NSThread *watchdogThread;
+@property (nonnull, nonatomic) NSMutableArray<NSString *> *operationTags;
+@property (nullable, nonatomic) NSString *lastControllerName;
+@property (nonnull, nonatomic) NSMutableArray<ATLMHang *> *ringBuffer;
+@property (nonatomic) NSUInteger ringBufferStart;
+@property (nonatomic, readwrite) NSUInteger countOfHangs;
+
+@end
+
+@implementation ATLMHangDetector
+
++ (instancetype)sharedDetector
+{
+    static ATLMHangDetector *sharedDetector;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedDetector = [self detector];
+    });
+    return sharedDetector;
+}
+
++ (instancetype)detector
+{
+    return [[self alloc] init];
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self) {
+        pthread_mutex_init(&_lock, NULL);
+        _threshold = ATLMHangDetectorDefaultThreshold;
+        _sampleInterval = ATLMHangDetectorDefaultSampleInterval;
+        _maximumSampleCount = ATLMHangDetectorDefaultMaximumSampleCount;
+        _capacity = ATLMHangDetectorDefaultCapacity;
+        _operationTags = [NSMutableArray new];
+        _ringBuffer = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+#pragma mark - Watching
+
+- (void)start
+{
+    NSAssert([NSThread isMainThread], @"The hang detector must be started on the main thread");
+    if (self.watchdogThread) {
+        return;
+    }
+    self.lastControllerName = self.activeControllerProvider ? self.activeControllerProvider() : nil;
+    // The thread retains the detector until it's stopped.
+    self.watchdogThread = [[NSThread alloc] initWithTarget:self selector:@selector(watchMainThread) object:nil];
+    self.watchdogThread.name = @"com.layer.Atlas-Messenger.hang-detector";
+    self.watchdogThread.qualityOfService = NSQualityOfServiceUserInteractive;
+    [self.watchdogThread start];
+}
+
+- (void)stop
+{
+    NSAssert([NSThread isMainThread], @"The hang detector must be stopped on the main thread");
+    [self.watchdogThread cancel];
+    self.watchdogThread = nil;
+}
+
+- (BOOL)isRunning
+{
+    return self.watchdogThread != nil;
+}
+
+- (void)watchMainThread
+{
+    NSThread *thread = [NSThread currentThread];
+    while (!thread.isCancelled) {
+        @autoreleasepool {
+            [self pingMainThreadFromThread:thread];
+            [NSThread sleepForTimeInterval:self.sampleInterval];
+        }
+    }
+}
+
+- (void)pingMainThreadFromThread:(NSThread *)thread
+{
+    dispatch_semaphore_t answered = dispatch_semaphore_create(0);
+    CFAbsoluteTime pingTime = CFAbsoluteTimeGetCurrent();
+    dispatch_async(dispatch_get_main_queue(), ^{
+        NSString *(^activeControllerProvider)(void) = self.activeControllerProvider;
+        if (activeControllerProvider) {
+            NSString *controllerName = activeControllerProvider();
+            pthread_mutex_lock(&self->_lock);
+            self.lastControllerName = controllerName;
+            pthread_mutex_unlock(&self->_lock);
+        }
+        dispatch_semaphore_signal(answered);
+    });
+
+    NSMutableArray *stackSamples;
+    NSString *operationTag;
+    NSString *controllerName;
+    while (dispatch_semaphore_wait(answered, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.sampleInterval * NSEC_PER_SEC))) != 0) {
+        if (thread.isCancelled) {
+            return;
+        }
+        if (CFAbsoluteTimeGetCurrent() - pingTime < self.threshold) {
+            continue;
+        }
+        if (!stackSamples) {
+            // The main thread is stuck inside whatever it had begun, so the tags can't change under us.
+            stackSamples = [NSMutableArray new];
+            pthread_mutex_lock(&_lock);
+            operationTag = self.operationTags.lastObject;
+            controllerName = self.lastControllerName;
+            pthread_mutex_unlock(&_lock);
+        }
+        if (stackSamples.count < self.maximumSampleCount) {
+            NSArray *stack = ATLMSampleMainThreadStack();
+            if (stack) {
+                [stackSamples addObject:stack];
+            }
+        }
+    }
+    if (!stackSamples) {
+        return;
+    }
+
+    ATLMHang *hang = [ATLMHang new];
+    hang.duration = CFAbsoluteTimeGetCurrent() - pingTime;
+    hang.startDate = [NSDate dateWithTimeIntervalSinceReferenceDate:pingTime];
+    hang.operationTag = operationTag;
+    hang.controllerName = controllerName;
+    hang.stackSamples = stackSamples;
+    [self recordHang:hang];
+}
+
+#pragma mark - Tagging Operations
+
+- (void)beginOperation:(NSString *)tag
+{
+    NSParameterAssert(tag);
+    if (![NSThread isMainThread]) {
+        return;
+    }
+    pthread_mutex_lock(&_lock);
+    [self.operationTags addObject:tag];
+    pthread_mutex_unlock(&_lock);
+}
+
+- (void)endOperation:(NSString *)tag
+{
+    NSParameterAssert(tag);
+    if (![NSThread isMainThread]) {
+        return;
+    }
+    pthread_mutex_lock(&_lock);
+    NSUInteger index = [self.operationTags indexOfObjectWithOptions:NSEnumerationReverse passingTest:^BOOL(NSString *operationTag, NSUInteger index, BOOL *stop) {
+        return [operationTag isEqualToString:tag];
+    }];
+    if (index != NSNotFound) {
+        [self.operationTags removeObjectAtIndex:index];
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+#pragma mark - Hangs
+
+- (void)recordHang:(ATLMHang *)hang
+{
+    ATLMInstrumentationRecordDuration(ATLMMetricMainThreadHang, hang.duration);
+    pthread_mutex_lock(&_lock);
+    self.countOfHangs += 1;
+    if (self.ringBuffer.count < MAX(self.capacity, 1)) {
+        [self.ringBuffer addObject:hang];
+    } else {
+        // Overwrites the oldest hang.
+        self.ringBuffer[self.ringBufferStart] = hang;
+        self.ringBufferStart = (self.ringBufferStart + 1) % self.ringBuffer.count;
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+- (void)setCapacity:(NSUInteger)capacity
+{
+    NSArray *hangs = self.hangs;
+    pthread_mutex_lock(&_lock);
+    _capacity = capacity;
+    NSUInteger keptCount = MIN(hangs.count, MAX(capacity, 1));
+    [self.ringBuffer setArray:[hangs subarrayWithRange:NSMakeRange(hangs.count - keptCount, keptCount)]];
+    self.ringBufferStart = 0;
+    pthread_mutex_unlock(&_lock);
+}
+
+- (NSArray<ATLMHang *> *)hangs
+{
+    pthread_mutex_lock(&_lock);
+    NSArray *newest = [self.ringBuffer subarrayWithRange:NSMakeRange(0, self.ringBufferStart)];
+    NSArray *oldest = [self.ringBuffer subarrayWithRange:NSMakeRange(self.ringBufferStart, self.ringBuffer.count - self.ringBufferStart)];
+    pthread_mutex_unlock(&_lock);
+    return [oldest arrayByAddingObjectsFromArray:newest];
+}
+
+- (NSData *)JSONSnapshot
+{
+    NSDictionary *snapshot = @{ @"timestamp": @([NSDate date].timeIntervalSince1970),
+                                @"count": @(self.countOfHangs),
+                                @"hangs": [self.hangs valueForKey:@"dictionaryRepresentation"] };
+    return [NSJSONSerialization dataWithJSONObject:snapshot options:NSJSONWritingPrettyPrinted error:nil];
+}
+
+- (void)reset
+{
+    pthread_mutex_lock(&_lock);
+    [self.ringBuffer removeAllObjects];
+    self.ringBufferStart = 0;
+    self.countOfHangs = 0;
+    pthread_mutex_unlock(&_lock);
+}
+
+@end
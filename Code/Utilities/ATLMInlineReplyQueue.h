@@ -0,0 +1,131 @@
+//
+//  ATLMInlineReplyQueue.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+@class ATLMInlineReplyQueue;
+
+/**
+ @abstract The `ATLMInlineReplyQueueDelegate` performs the actual sending of
+   the queued replies and gets notified when they have been handed off.
+ */
+@protocol ATLMInlineReplyQueueDelegate <NSObject>
+
+/**
+ @abstract Asks the receiver to send the reply text to the conversation.
+ @param inlineReplyQueue The `ATLMInlineReplyQueue` instance performing the invocation.
+ @param text The text the user entered in the notification center.
+ @param conversationIdentifier The identifier of the conversation the remote notification was sent for.
+ @param error A reference to an error object describing the failure.
+ @return `YES` if the reply was handed over for delivery, `NO` if it should be retried later.
+ */
+- (BOOL)inlineReplyQueue:(nonnull ATLMInlineReplyQueue *)inlineReplyQueue sendReplyText:(nonnull NSString *)text toConversationWithIdentifier:(nonnull NSURL *)conversationIdentifier error:(NSError *_Nullable *_Nullable)error;
+
+@optional
+
+/**
+ @abstract Notifies the receiver that a reply has been handed over for delivery.
+ @param inlineReplyQueue The `ATLMInlineReplyQueue` instance performing the invocation.
+ @param replyIdentifier The identifier returned when the reply was enqueued.
+ @param latency The time between enqueuing the reply and the delegate accepting
+   it, including any time the application spent suspended. It does not include
+   the time it takes the message to reach the server.
+ */
+- (void)inlineReplyQueue:(nonnull ATLMInlineReplyQueue *)inlineReplyQueue didHandOffReplyWithIdentifier:(nonnull NSString *)replyIdentifier handOffLatency:(NSTimeInterval)latency;
+
+@end
+
+/**
+ @abstract The `ATLMInlineReplyQueue` sends inline replies straight to the
+   conversation identified in the remote notification payload, without waiting
+   for a synchronization to complete.
+ @discussion Enqueued replies are written to disk before the first send attempt
+   and removed once the delegate accepts them, so a reply entered right before
+   the application gets suspended is sent on the next attempt. All methods must
+   be called on the main thread.
+ */
+@interface ATLMInlineReplyQueue : NSObject
+
+/**
+ @abstract Creates a queue persisting its pending replies at the supplied path.
+ @param path The path of the property list the pending replies are stored in.
+   Replies persisted by a previous instance are loaded from it.
+ @param delegate The receiver sending the replies.
+ @return A new `ATLMInlineReplyQueue` instance.
+ */
++ (nonnull instancetype)queueWithPersistencePath:(nonnull NSString *)path delegate:(nonnull id<ATLMInlineReplyQueueDelegate>)delegate;
+
+/**
+ @abstract The receiver sending the replies.
+ */
+@property (nullable, nonatomic, weak, readonly) id<ATLMInlineReplyQueueDelegate> delegate;
+
+/**
+ @abstract Replies older than this are discarded instead of being sent. Defaults to one day.
+ */
+@property (nonatomic) NSTimeInterval maximumReplyAge;
+
+/**
+ @abstract Persists the reply and immediately attempts to send it.
+ @param text The text the user entered in the notification center.
+ @param conversationIdentifier The identifier of the conversation to reply to.
+ @return An identifier for the reply which can be passed to `containsReplyWithIdentifier:`.
+ */
+- (nonnull NSString *)enqueueReplyText:(nonnull NSString *)text conversationIdentifier:(nonnull NSURL *)conversationIdentifier;
+
+/**
+ @abstract Attempts to send all pending replies in the order they were enqueued.
+ @return The number of replies still pending after the attempt.
+ */
+- (NSUInteger)sendPendingReplies;
+
+/**
+ @abstract Discards all pending replies, including the persisted ones.
+ @discussion Called when the user the replies were entered for logs out, so
+   that they don't get sent from the next user's session.
+ */
+- (void)removeAllReplies;
+
+/**
+ @abstract Returns `YES` if the reply has not been sent yet.
+ */
+- (BOOL)containsReplyWithIdentifier:(nonnull NSString *)replyIdentifier;
+
+/**
+ @abstract The number of replies waiting to be sent.
+ */
+@property (nonatomic, readonly) NSUInteger countOfPendingReplies;
+
+/**
+ @abstract The number of replies handed over for delivery by the receiver.
+ */
+@property (nonatomic, readonly) NSUInteger countOfSentReplies;
+
+/**
+ @abstract The time it took to hand over the most recent reply for delivery.
+ */
+@property (nonatomic, readonly) NSTimeInterval lastReplyHandOffLatency;
+
+/**
+ @abstract The average time it took to hand over a reply for delivery.
+ */
+@property (nonatomic, readonly) NSTimeInterval averageReplyHandOffLatency;
+
+@end
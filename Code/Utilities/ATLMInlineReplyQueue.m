@@ -0,0 +1,173 @@
+//
+//  ATLMInlineReplyQueue.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMInlineReplyQueue.h"
+
+static NSString *const ATLMInlineReplyIdentifierKey = @"identifier";
+static NSString *const ATLMInlineReplyTextKey = @"text";
+static NSString *const ATLMInlineReplyConversationIdentifierKey = @"conversation_identifier";
+static NSString *const ATLMInlineReplyEnqueuedAtKey = @"enqueued_at";
+static const NSTimeInterval ATLMInlineReplyDefaultMaximumAge = 24 * 60 * 60;
+
+@interface ATLMInlineReplyQueue ()
+
+@property (nonatomic, copy) NSString *persistencePath;
+@property (nullable, nonatomic, weak, readwrite) id<ATLMInlineReplyQueueDelegate> delegate;
+@property (nonatomic) NSMutableArray *pendingReplies;
+@property (nonatomic, readwrite) NSUInteger countOfSentReplies;
+@property (nonatomic, readwrite) NSTimeInterval lastReplyHandOffLatency;
+@property (nonatomic) NSTimeInterval cumulativeReplyHandOffLatency;
+
+@end
+
+@implementation ATLMInlineReplyQueue
+
++ (instancetype)queueWithPersistencePath:(NSString *)path delegate:(id<ATLMInlineReplyQueueDelegate>)delegate
+{
+    return [[self alloc] initWithPersistencePath:path delegate:delegate];
+}
+
+- (id)initWithPersistencePath:(NSString *)path delegate:(id<ATLMInlineReplyQueueDelegate>)delegate
+{
+    NSParameterAssert(path);
+    NSParameterAssert(delegate);
+    self = [super init];
+    if (self) {
+        _persistencePath = [path copy];
+        _delegate = delegate;
+        _maximumReplyAge = ATLMInlineReplyDefaultMaximumAge;
+        _pendingReplies = [NSMutableArray arrayWithContentsOfFile:path] ?: [NSMutableArray new];
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use queueWithPersistencePath:delegate:" userInfo:nil];
+}
+
+#pragma mark - Public API
+
+- (NSString *)enqueueReplyText:(NSString *)text conversationIdentifier:(NSURL *)conversationIdentifier
+{
+    NSParameterAssert(text);
+    NSParameterAssert(conversationIdentifier);
+    NSString *replyIdentifier = [NSUUID UUID].UUIDString;
+    NSDictionary *reply = @{ ATLMInlineReplyIdentifierKey: replyIdentifier,
+                             ATLMInlineReplyTextKey: text,
+                             ATLMInlineReplyConversationIdentifierKey: conversationIdentifier.absoluteString,
+                             ATLMInlineReplyEnqueuedAtKey: [NSDate date] };
+    [self.pendingReplies addObject:reply];
+    // Persist before the first attempt; the app may get suspended at any point from now on.
+    [self persist];
+    [self sendPendingReplies];
+    return replyIdentifier;
+}
+
+- (NSUInteger)sendPendingReplies
+{
+    if (self.pendingReplies.count == 0) {
+        return 0;
+    }
+    NSMutableIndexSet *completedIndexes = [NSMutableIndexSet new];
+    NSMutableSet *blockedConversations = [NSMutableSet new];
+    [self.pendingReplies enumerateObjectsUsingBlock:^(NSDictionary *reply, NSUInteger index, BOOL *stop) {
+        NSString *conversationIdentifierString = reply[ATLMInlineReplyConversationIdentifierKey];
+        NSTimeInterval age = -[reply[ATLMInlineReplyEnqueuedAtKey] timeIntervalSinceNow];
+        if (age > self.maximumReplyAge) {
+            NSLog(@"Discarding inline reply enqueued %.0f seconds ago", age);
+            [completedIndexes addIndex:index];
+            return;
+        }
+        // Keep the replies to the same conversation in order.
+        if ([blockedConversations containsObject:conversationIdentifierString]) {
+            return;
+        }
+        NSError *error;
+        BOOL success = [self.delegate inlineReplyQueue:self sendReplyText:reply[ATLMInlineReplyTextKey] toConversationWithIdentifier:[NSURL URLWithString:conversationIdentifierString] error:&error];
+        if (!success) {
+            NSLog(@"Failed to send inline reply, will retry: %@", error);
+            [blockedConversations addObject:conversationIdentifierString];
+            return;
+        }
+        [completedIndexes addIndex:index];
+        [self recordHandedOffReply:reply handOffLatency:age];
+    }];
+    if (completedIndexes.count) {
+        [self.pendingReplies removeObjectsAtIndexes:completedIndexes];
+        [self persist];
+    }
+    return self.pendingReplies.count;
+}
+
+- (void)removeAllReplies
+{
+    [self.pendingReplies removeAllObjects];
+    [self persist];
+}
+
+- (BOOL)containsReplyWithIdentifier:(NSString *)replyIdentifier
+{
+    for (NSDictionary *reply in self.pendingReplies) {
+        if ([reply[ATLMInlineReplyIdentifierKey] isEqualToString:replyIdentifier]) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+- (NSUInteger)countOfPendingReplies
+{
+    return self.pendingReplies.count;
+}
+
+- (NSTimeInterval)averageReplyHandOffLatency
+{
+    if (self.countOfSentReplies == 0) {
+        return 0;
+    }
+    return self.cumulativeReplyHandOffLatency / self.countOfSentReplies;
+}
+
+#pragma mark - Helpers
+
+- (void)recordHandedOffReply:(NSDictionary *)reply handOffLatency:(NSTimeInterval)latency
+{
+    self.countOfSentReplies += 1;
+    self.lastReplyHandOffLatency = latency;
+    self.cumulativeReplyHandOffLatency += latency;
+    if ([self.delegate respondsToSelector:@selector(inlineReplyQueue:didHandOffReplyWithIdentifier:handOffLatency:)]) {
+        [self.delegate inlineReplyQueue:self didHandOffReplyWithIdentifier:reply[ATLMInlineReplyIdentifierKey] handOffLatency:latency];
+    }
+}
+
+- (void)persist
+{
+    if (self.pendingReplies.count == 0) {
+        [[NSFileManager defaultManager] removeItemAtPath:self.persistencePath error:nil];
+        return;
+    }
+    BOOL success = [self.pendingReplies writeToFile:self.persistencePath atomically:YES];
+    if (!success) {
+        NSLog(@"Failed to persist pending inline replies to %@", self.persistencePath);
+    }
+}
+
+@end
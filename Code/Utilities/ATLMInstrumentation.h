@@ -0,0 +1,160 @@
+//
+//  ATLMInstrumentation.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ @abstract Set `ATLM_INSTRUMENTATION_ENABLED=0` in the preprocessor macros to
+   compile the instrumentation macros below out of the application.
+ */
+#ifndef ATLM_INSTRUMENTATION_ENABLED
+#define ATLM_INSTRUMENTATION_ENABLED 1
+#endif
+
+///------------------
+/// @name Metric Names
+///------------------
+
+extern NSString *_Nonnull const ATLMMetricQueryExecution;
+extern NSString *_Nonnull const ATLMMetricQueryCount;
+extern NSString *_Nonnull const ATLMMetricChangeDispatch;
+extern NSString *_Nonnull const ATLMMetricChangeBatchSize;
+extern NSString *_Nonnull const ATLMMetricAuthenticationRoundTrip;
+extern NSString *_Nonnull const ATLMMetricAuthenticationFailures;
+extern NSString *_Nonnull const ATLMMetricMediaDecode;
+extern NSString *_Nonnull const ATLMMetricMediaTranscode;
+extern NSString *_Nonnull const ATLMMetricConversationTitle;
+extern NSString *_Nonnull const ATLMMetricMemoryFootprint;
+extern NSString *_Nonnull const ATLMMetricMemoryEvictions;
+extern NSString *_Nonnull const ATLMMetricConnectionTimeToConnect;
+extern NSString *_Nonnull const ATLMMetricConnectionAttempts;
+extern NSString *_Nonnull const ATLMMetricConnectionTimeDisconnected;
+extern NSString *_Nonnull const ATLMMetricConnectionTimeToFirstSynchronization;
+extern NSString *_Nonnull const ATLMMetricConnectionLosses;
+extern NSString *_Nonnull const ATLMMetricAccountSwitch;
+extern NSString *_Nonnull const ATLMMetricMainThreadHang;
+extern NSString *_Nonnull const ATLMMetricAvatarDownload;
+extern NSString *_Nonnull const ATLMMetricAvatarDecode;
+extern NSString *_Nonnull const ATLMMetricAvatarMemoryMisses;
+extern NSString *_Nonnull const ATLMMetricLocationSnapshot;
+
+/**
+ @abstract The keys of the dictionary describing a histogram in `snapshot`.
+ */
+extern NSString *_Nonnull const ATLMMetricCountKey;
+extern NSString *_Nonnull const ATLMMetricMeanKey;
+extern NSString *_Nonnull const ATLMMetricP50Key;
+extern NSString *_Nonnull const ATLMMetricP95Key;
+extern NSString *_Nonnull const ATLMMetricP99Key;
+extern NSString *_Nonnull const ATLMMetricMaxKey;
+extern NSString *_Nonnull const ATLMMetricUnitKey;
+
+/**
+ @abstract The `ATLMInstrumentation` aggregates named counters, histograms and
+   interval timers.
+ @discussion Histograms keep log-linear buckets with eight buckets per power of
+   two, so recording a value takes a lock and an increment and percentiles are
+   accurate to about 6%. Intervals are recorded in microseconds and are also
+   emitted as signposts where the OS supports them, so they show up in the
+   Points of Interest instrument. All methods are thread safe.
+
+   Hot paths should use the `ATLMInstrumentation…` macros, which cost nothing
+   when `ATLM_INSTRUMENTATION_ENABLED` is 0.
+ */
+@interface ATLMInstrumentation : NSObject
+
+/**
+ @abstract The instrumentation shared by the application.
+ */
++ (nonnull instancetype)sharedInstrumentation;
+
+/**
+ @abstract Creates a standalone instrumentation.
+ */
++ (nonnull instancetype)instrumentation;
+
+/**
+ @abstract When `NO`, nothing is recorded. Defaults to `YES`.
+ */
+@property (atomic, getter=isEnabled) BOOL enabled;
+
+/**
+ @abstract Adds `delta` to the named counter.
+ */
+- (void)incrementCounter:(nonnull NSString *)name by:(NSInteger)delta;
+
+/**
+ @abstract Records a value in the named histogram.
+ */
+- (void)recordValue:(double)value forHistogram:(nonnull NSString *)name;
+
+/**
+ @abstract Records a duration in the named interval histogram.
+ */
+- (void)recordDuration:(NSTimeInterval)duration forInterval:(nonnull NSString *)name;
+
+/**
+ @abstract Starts timing the named interval.
+ @return A timestamp to pass to `endInterval:start:`.
+ */
+- (uint64_t)beginInterval:(nonnull NSString *)name;
+
+/**
+ @abstract Stops timing the named interval and records its duration.
+ */
+- (void)endInterval:(nonnull NSString *)name start:(uint64_t)start;
+
+/**
+ @abstract Returns the current value of the named counter.
+ */
+- (NSInteger)valueOfCounter:(nonnull NSString *)name;
+
+/**
+ @abstract Returns the aggregates of all metrics.
+ @discussion The dictionary has a `counters` dictionary of numbers and a
+   `histograms` dictionary of dictionaries with the `ATLMMetric…Key` keys.
+ */
+- (nonnull NSDictionary *)snapshot;
+
+/**
+ @abstract Returns `snapshot` serialized as JSON, for export.
+ */
+- (nonnull NSData *)JSONSnapshot;
+
+/**
+ @abstract Clears all metrics.
+ */
+- (void)reset;
+
+@end
+
+#if ATLM_INSTRUMENTATION_ENABLED
+#define ATLMInstrumentationCount(name) [[ATLMInstrumentation sharedInstrumentation] incrementCounter:(name) by:1]
+#define ATLMInstrumentationRecord(name, value) [[ATLMInstrumentation sharedInstrumentation] recordValue:(value) forHistogram:(name)]
+#define ATLMInstrumentationRecordDuration(name, duration) [[ATLMInstrumentation sharedInstrumentation] recordDuration:(duration) forInterval:(name)]
+#define ATLMInstrumentationBegin(name) [[ATLMInstrumentation sharedInstrumentation] beginInterval:(name)]
+#define ATLMInstrumentationEnd(name, start) [[ATLMInstrumentation sharedInstrumentation] endInterval:(name) start:(start)]
+#else
+#define ATLMInstrumentationCount(name) ((void)0)
+#define ATLMInstrumentationRecord(name, value) ((void)0)
+#define ATLMInstrumentationRecordDuration(name, duration) ((void)0)
+#define ATLMInstrumentationBegin(name) ((uint64_t)0)
+#define ATLMInstrumentationEnd(name, start) ((void)(start))
+#endif
@@ -0,0 +1,317 @@
+//
+//  ATLMInstrumentation.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMInstrumentation.h"
+#import <mach/mach_time.h>
+#import <pthread.h>
+#if __has_include(<sys/kdebug_signpost.h>)
+#import <sys/kdebug_signpost.h>
+#define ATLM_SIGNPOSTS_AVAILABLE 1
+#endif
+
+NSString *const ATLMMetricQueryExecution = @"query.execute";
+NSString *const ATLMMetricQueryCount = @"query.count";
+NSString *const ATLMMetricChangeDispatch = @"changes.dispatch";
+NSString *const ATLMMetricChangeBatchSize = @"changes.batch";
+NSString *const ATLMMetricAuthenticationRoundTrip = @"auth.roundtrip";
+NSString *const ATLMMetricAuthenticationFailures = @"auth.failures";
+NSString *const ATLMMetricMediaDecode = @"media.decode";
+NSString *const ATLMMetricMediaTranscode = @"media.transcode";
+NSString *const ATLMMetricConversationTitle = @"conversation.title";
+NSString *const ATLMMetricMemoryFootprint = @"memory.footprint";
+NSString *const ATLMMetricMemoryEvictions = @"memory.evictions";
+NSString *const ATLMMetricConnectionTimeToConnect = @"connection.connect";
+NSString *const ATLMMetricConnectionAttempts = @"connection.attempts";
+NSString *const ATLMMetricConnectionTimeDisconnected = @"connection.disconnected";
+NSString *const ATLMMetricConnectionTimeToFirstSynchronization = @"connection.firstsync";
+NSString *const ATLMMetricConnectionLosses = @"connection.losses";
+NSString *const ATLMMetricAccountSwitch = @"account.switch";
+NSString *const ATLMMetricMainThreadHang = @"mainthread.hang";
+NSString *const ATLMMetricAvatarDownload = @"avatar.download";
+NSString *const ATLMMetricAvatarDecode = @"avatar.decode";
+NSString *const ATLMMetricAvatarMemoryMisses = @"avatar.misses";
+NSString *const ATLMMetricLocationSnapshot = @"location.snapshot";
+
+NSString *const ATLMMetricCountKey = @"count";
+NSString *const ATLMMetricMeanKey = @"mean";
+NSString *const ATLMMetricP50Key = @"p50";
+NSString *const ATLMMetricP95Key = @"p95";
+NSString *const ATLMMetricP99Key = @"p99";
+NSString *const ATLMMetricMaxKey = @"max";
+NSString *const ATLMMetricUnitKey = @"unit";
+
+static const int ATLMHistogramSubBucketCount = 8;
+static const int ATLMHistogramMaximumExponent = 48;
+static const int ATLMHistogramBucketCount = 1 + ATLMHistogramMaximumExponent * ATLMHistogramSubBucketCount;
+
+/**
+ @abstract Maps a value to its bucket: bucket 0 holds values below 1, then
+   each power of two is split into `ATLMHistogramSubBucketCount` buckets.
+ */
+static int ATLMHistogramBucketForValue(double value)
+{
+    if (!(value >= 1)) {
+        return 0;
+    }
+    int exponent;
+    double mantissa = frexp(value, &exponent); // value = mantissa * 2^exponent, mantissa in [0.5, 1)
+    if (exponent > ATLMHistogramMaximumExponent) {
+        return ATLMHistogramBucketCount - 1;
+    }
+    int subBucket = (int)((mantissa - 0.5) * 2 * ATLMHistogramSubBucketCount);
+    return 1 + (exponent - 1) * ATLMHistogramSubBucketCount + subBucket;
+}
+
+static double ATLMHistogramMidpointOfBucket(int bucket)
+{
+    if (bucket == 0) {
+        return 0.5;
+    }
+    int exponent = (bucket - 1) / ATLMHistogramSubBucketCount + 1;
+    int subBucket = (bucket - 1) % ATLMHistogramSubBucketCount;
+    return ldexp(0.5 + (subBucket + 0.5) / (2 * ATLMHistogramSubBucketCount), exponent);
+}
+
+static double ATLMMicrosecondsFromMachTime(uint64_t machTime)
+{
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    return (double)machTime * timebase.numer / timebase.denom / 1000.0;
+}
+
+@interface ATLMHistogram : NSObject {
+@public
+    uint32_t _buckets[ATLMHistogramBucketCount];
+    uint64_t _count;
+    double _sum;
+    double _max;
+}
+
+@property (nonatomic) BOOL interval;
+@property (nonatomic) uint32_t signpostCode;
+
+@end
+
+@implementation ATLMHistogram
+
+- (double)valueAtPercentile:(double)percentile
+{
+    uint64_t rank = MAX(1, (uint64_t)ceil(percentile * _count));
+    uint64_t cumulativeCount = 0;
+    for (int bucket = 0; bucket < ATLMHistogramBucketCount; bucket++) {
+        cumulativeCount += _buckets[bucket];
+        if (cumulativeCount >= rank) {
+            return MIN(ATLMHistogramMidpointOfBucket(bucket), _max);
+        }
+    }
+    return _max;
+}
+
+- (NSDictionary *)summary
+{
+    return @{ ATLMMetricCountKey: @(_count),
+              ATLMMetricMeanKey: @(_count ? _sum / _count : 0),
+              ATLMMetricP50Key: @([self valueAtPercentile:0.50]),
+              ATLMMetricP95Key: @([self valueAtPercentile:0.95]),
+              ATLMMetricP99Key: @([self valueAtPercentile:0.99]),
+              ATLMMetricMaxKey: @(_max),
+              ATLMMetricUnitKey: self.interval ? @"us" : @"" };
+}
+
+@end
+
+@interface ATLMInstrumentation () {
+    pthread_mutex_t _lock;
+}
+
+@property (nonnull, nonatomic) NSMutableDictionary<NSString *, NSNumber *> *counters;
+@property (nonnull, nonatomic) NSMutableDictionary<NSString *, ATLMHistogram *> *histograms;
+
+@end
+
+@implementation ATLMInstrumentation
+
++ (instancetype)sharedInstrumentation
+{
+    static ATLMInstrumentation *sharedInstrumentation;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedInstrumentation = [self instrumentation];
+    });
+    return sharedInstrumentation;
+}
+
++ (instancetype)instrumentation
+{
+    return [[self alloc] init];
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self) {
+        pthread_mutex_init(&_lock, NULL);
+        _counters = [NSMutableDictionary new];
+        _histograms = [NSMutableDictionary new];
+        _enabled = YES;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+#pragma mark - Recording
+
+- (void)incrementCounter:(NSString *)name by:(NSInteger)delta
+{
+    if (!self.enabled) {
+        return;
+    }
+    pthread_mutex_lock(&_lock);
+    self.counters[name] = @(self.counters[name].integerValue + delta);
+    pthread_mutex_unlock(&_lock);
+}
+
+- (void)recordValue:(double)value forHistogram:(NSString *)name
+{
+    if (!self.enabled) {
+        return;
+    }
+    pthread_mutex_lock(&_lock);
+    [self recordValue:value inHistogram:[self histogramNamed:name interval:NO]];
+    pthread_mutex_unlock(&_lock);
+}
+
+- (void)recordDuration:(NSTimeInterval)duration forInterval:(NSString *)name
+{
+    if (!self.enabled) {
+        return;
+    }
+    pthread_mutex_lock(&_lock);
+    [self recordValue:duration * 1e6 inHistogram:[self histogramNamed:name interval:YES]];
+    pthread_mutex_unlock(&_lock);
+}
+
+- (uint64_t)beginInterval:(NSString *)name
+{
+    if (!self.enabled) {
+        return 0;
+    }
+#if ATLM_SIGNPOSTS_AVAILABLE
+    if (&kdebug_signpost_start != NULL) {
+        pthread_mutex_lock(&_lock);
+        uint32_t code = [self histogramNamed:name interval:YES].signpostCode;
+        pthread_mutex_unlock(&_lock);
+        kdebug_signpost_start(code, 0, 0, 0, 0);
+    }
+#endif
+    return mach_absolute_time();
+}
+
+- (void)endInterval:(NSString *)name start:(uint64_t)start
+{
+    if (!self.enabled || start == 0) {
+        return;
+    }
+    double microseconds = ATLMMicrosecondsFromMachTime(mach_absolute_time() - start);
+    pthread_mutex_lock(&_lock);
+    ATLMHistogram *histogram = [self histogramNamed:name interval:YES];
+    [self recordValue:microseconds inHistogram:histogram];
+    uint32_t code = histogram.signpostCode;
+    pthread_mutex_unlock(&_lock);
+#if ATLM_SIGNPOSTS_AVAILABLE
+    if (&kdebug_signpost_end != NULL) {
+        kdebug_signpost_end(code, 0, 0, 0, 0);
+    }
+#else
+    (void)code;
+#endif
+}
+
+#pragma mark - Reading
+
+- (NSInteger)valueOfCounter:(NSString *)name
+{
+    pthread_mutex_lock(&_lock);
+    NSInteger value = self.counters[name].integerValue;
+    pthread_mutex_unlock(&_lock);
+    return value;
+}
+
+- (NSDictionary *)snapshot
+{
+    pthread_mutex_lock(&_lock);
+    NSDictionary *counters = [self.counters copy];
+    NSMutableDictionary *histograms = [NSMutableDictionary dictionaryWithCapacity:self.histograms.count];
+    [self.histograms enumerateKeysAndObjectsUsingBlock:^(NSString *name, ATLMHistogram *histogram, BOOL *stop) {
+        if (histogram->_count) {
+            histograms[name] = [histogram summary];
+        }
+    }];
+    pthread_mutex_unlock(&_lock);
+    return @{ @"counters": counters, @"histograms": histograms };
+}
+
+- (NSData *)JSONSnapshot
+{
+    NSMutableDictionary *snapshot = [[self snapshot] mutableCopy];
+    snapshot[@"timestamp"] = @([NSDate date].timeIntervalSince1970);
+    return [NSJSONSerialization dataWithJSONObject:snapshot options:NSJSONWritingPrettyPrinted error:nil];
+}
+
+- (void)reset
+{
+    pthread_mutex_lock(&_lock);
+    [self.counters removeAllObjects];
+    [self.histograms removeAllObjects];
+    pthread_mutex_unlock(&_lock);
+}
+
+#pragma mark - Helpers
+
+/**
+ @abstract Returns the named histogram, creating it if needed. Must be called with the lock held.
+ */
+- (ATLMHistogram *)histogramNamed:(NSString *)name interval:(BOOL)interval
+{
+    ATLMHistogram *histogram = self.histograms[name];
+    if (!histogram) {
+        histogram = [ATLMHistogram new];
+        histogram.interval = interval;
+        histogram.signpostCode = (uint32_t)self.histograms.count;
+        self.histograms[name] = histogram;
+    }
+    return histogram;
+}
+
+- (void)recordValue:(double)value inHistogram:(ATLMHistogram *)histogram
+{
+    histogram->_buckets[ATLMHistogramBucketForValue(value)] += 1;
+    histogram->_count += 1;
+    histogram->_sum += value;
+    histogram->_max = MAX(histogram->_max, value);
+}
+
+@end
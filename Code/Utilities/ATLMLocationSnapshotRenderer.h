@@ -0,0 +1,105 @@
+//
+//  ATLMLocationSnapshotRenderer.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <UIKit/UIKit.h>
+#import <MapKit/MapKit.h>
+
+@class ATLMDiskLRUCache;
+
+/**
+ @abstract Returns the region shown by a map of the supplied size centered on
+   a coordinate at a zoom level, where level 0 shows the whole world in 256 points.
+ */
+extern MKCoordinateRegion ATLMLocationSnapshotRegion(CLLocationCoordinate2D coordinate, NSUInteger zoomLevel, CGSize size);
+
+/**
+ @abstract Returns the key a snapshot is cached under.
+ @discussion The coordinate is rounded to the size of a pixel at the zoom
+   level, so every coordinate a snapshot would look the same for shares it.
+ */
+extern NSString *_Nonnull ATLMLocationSnapshotKey(CLLocationCoordinate2D coordinate, NSUInteger zoomLevel, CGSize size, CGFloat scale);
+
+/**
+ @abstract Renders the map of the options, calling the completion on any queue.
+ */
+typedef void (^ATLMLocationSnapshotBlock)(MKMapSnapshotOptions *_Nonnull options, void (^_Nonnull completion)(UIImage *_Nullable image, NSError *_Nullable error));
+
+/**
+ @abstract The `ATLMLocationSnapshotRenderer` renders static pictures of
+   locations, so the application needs a live `MKMapView` only once the user
+   interacts with a map.
+ @discussion Snapshots are rendered with `MKMapSnapshotter` around the
+   coordinate rounded by `ATLMLocationSnapshotKey()`. A pin is drawn in the
+   center and the result is stored as a JPEG in the disk cache, whose least
+   recently used snapshots are evicted first. Rendering, drawing and disk
+   access happen on a background queue, and requests for a snapshot being
+   rendered join it. Nothing is kept in memory beyond the requests in flight.
+   All methods must be called on the main thread and completions are called
+   on the main thread.
+ */
+@interface ATLMLocationSnapshotRenderer : NSObject
+
+/**
+ @abstract The renderer shared by the application, keeping up to 10 MB of snapshots in `defaultDirectory`.
+ */
++ (nonnull instancetype)sharedRenderer;
+
+/**
+ @abstract Creates a renderer.
+ @param diskCache The cache snapshots are stored in.
+ @param snapshotBlock Renders the maps, or `nil` to use `MKMapSnapshotter`.
+ @return A new `ATLMLocationSnapshotRenderer` instance.
+ */
++ (nonnull instancetype)rendererWithDiskCache:(nonnull ATLMDiskLRUCache *)diskCache snapshotBlock:(nullable ATLMLocationSnapshotBlock)snapshotBlock;
+
+/**
+ @abstract The directory in the application's caches directory used by default.
+ */
++ (nonnull NSString *)defaultDirectory;
+
+@property (nonnull, nonatomic, readonly) ATLMDiskLRUCache *diskCache;
+
+/**
+ @abstract The scale snapshots are rendered at. Defaults to the main screen's.
+ */
+@property (nonatomic) CGFloat scale;
+
+/**
+ @abstract Fetches the snapshot of a location from the disk cache, rendering it on a miss.
+ @param coordinate The coordinate of the pin.
+ @param zoomLevel The zoom level of the map.
+ @param size The size of the snapshot in points, rounded up to whole points.
+ @param completion Called with the snapshot or the error of the snapshotter.
+ */
+- (void)renderSnapshotForCoordinate:(CLLocationCoordinate2D)coordinate zoomLevel:(NSUInteger)zoomLevel size:(CGSize)size completion:(nonnull void (^)(UIImage *_Nullable image, NSError *_Nullable error))completion;
+
+///--------------
+/// @name Metrics
+///--------------
+
+@property (nonatomic, readonly) NSUInteger countOfRenders;
+@property (nonatomic, readonly) NSUInteger countOfDiskHits;
+
+/**
+ @abstract The number of requests which joined a snapshot in flight.
+ */
+@property (nonatomic, readonly) NSUInteger countOfCoalescedRequests;
+
+@end
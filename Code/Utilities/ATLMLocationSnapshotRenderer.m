@@ -0,0 +1,240 @@
+//
+//  ATLMLocationSnapshotRenderer.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMLocationSnapshotRenderer.h"
+#import <ImageIO/ImageIO.h>
+#import <MobileCoreServices/MobileCoreServices.h>
+#import "ATLMDiskLRUCache.h"
+#import "ATLMInstrumentation.h"
+
+static const double ATLMLocationSnapshotTileSize = 256;
+static const NSUInteger ATLMLocationSnapshotRendererDefaultDiskByteLimit = 10 * 1024 * 1024;
+static const CGFloat ATLMLocationSnapshotJPEGQuality = 0.8;
+static const CGFloat ATLMLocationSnapshotPinDiameter = 14;
+
+MKCoordinateRegion ATLMLocationSnapshotRegion(CLLocationCoordinate2D coordinate, NSUInteger zoomLevel, CGSize size)
+{
+    CLLocationDegrees degreesPerPoint = 360.0 / (ATLMLocationSnapshotTileSize * pow(2, zoomLevel));
+    // The Mercator projection stretches latitudes by 1 / cos(latitude).
+    CLLocationDegrees latitudeDelta = size.height * degreesPerPoint * cos(coordinate.latitude * M_PI / 180);
+    CLLocationDegrees longitudeDelta = size.width * degreesPerPoint;
+    return MKCoordinateRegionMake(coordinate, MKCoordinateSpanMake(MIN(latitudeDelta, 180), MIN(longitudeDelta, 360)));
+}
+
+static CLLocationCoordinate2D ATLMLocationSnapshotRoundedCoordinate(CLLocationCoordinate2D coordinate, NSUInteger zoomLevel, CGFloat scale)
+{
+    double longitudeStep = 360.0 / (ATLMLocationSnapshotTileSize * pow(2, zoomLevel) * MAX(scale, 1));
+    // Taken at the whole degree, so nearby coordinates round with the same step.
+    double latitudeStep = longitudeStep * MAX(cos(round(coordinate.latitude) * M_PI / 180), 0.01);
+    return CLLocationCoordinate2DMake(round(coordinate.latitude / latitudeStep) * latitudeStep, round(coordinate.longitude / longitudeStep) * longitudeStep);
+}
+
+NSString *ATLMLocationSnapshotKey(CLLocationCoordinate2D coordinate, NSUInteger zoomLevel, CGSize size, CGFloat scale)
+{
+    CLLocationCoordinate2D roundedCoordinate = ATLMLocationSnapshotRoundedCoordinate(coordinate, zoomLevel, scale);
+    return [NSString stringWithFormat:@"%.7f,%.7f@%lu/%.0fx%.0f@%.0fx", roundedCoordinate.latitude, roundedCoordinate.longitude, (unsigned long)zoomLevel, ceil(size.width), ceil(size.height), scale];
+}
+
+/**
+ @abstract Draws the pin in the center of the map, which is the coordinate
+   give or take the rounding of less than a pixel.
+ */
+static UIImage *ATLMLocationSnapshotImageWithPin(UIImage *mapImage)
+{
+    UIGraphicsBeginImageContextWithOptions(mapImage.size, YES, mapImage.scale);
+    [mapImage drawAtPoint:CGPointZero];
+    CGContextRef context = UIGraphicsGetCurrentContext();
+    CGRect pinRect = CGRectMake((mapImage.size.width - ATLMLocationSnapshotPinDiameter) / 2, (mapImage.size.height - ATLMLocationSnapshotPinDiameter) / 2, ATLMLocationSnapshotPinDiameter, ATLMLocationSnapshotPinDiameter);
+    CGContextSetShadowWithColor(context, CGSizeMake(0, 1), 2, [UIColor colorWithWhite:0 alpha:0.4].CGColor);
+    CGContextSetFillColorWithColor(context, [UIColor whiteColor].CGColor);
+    CGContextFillEllipseInRect(context, pinRect);
+    CGContextSetShadowWithColor(context, CGSizeZero, 0, NULL);
+    CGContextSetFillColorWithColor(context, [UIColor colorWithRed:1.0 green:0.23 blue:0.19 alpha:1.0].CGColor);
+    CGContextFillEllipseInRect(context, CGRectInset(pinRect, 2.5, 2.5));
+    UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+    return image;
+}
+
+static NSData *ATLMLocationSnapshotJPEGData(UIImage *image)
+{
+    NSMutableData *data = [NSMutableData data];
+    CGImageDestinationRef destination = CGImageDestinationCreateWithData((__bridge CFMutableDataRef)data, kUTTypeJPEG, 1, NULL);
+    if (!destination) {
+        return nil;
+    }
+    CGImageDestinationAddImage(destination, image.CGImage, (__bridge CFDictionaryRef)@{ (__bridge NSString *)kCGImageDestinationLossyCompressionQuality: @(ATLMLocationSnapshotJPEGQuality) });
+    BOOL finalized = CGImageDestinationFinalize(destination);
+    CFRelease(destination);
+    return finalized ? data : nil;
+}
+
+static UIImage *ATLMLocationSnapshotDecodedImage(NSData *data, CGFloat scale)
+{
+    CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef)data, NULL);
+    if (!source) {
+        return nil;
+    }
+    NSDictionary *options = @{ (__bridge NSString *)kCGImageSourceShouldCacheImmediately: @YES };
+    CGImageRef decodedImage = CGImageSourceCreateImageAtIndex(source, 0, (__bridge CFDictionaryRef)options);
+    CFRelease(source);
+    if (!decodedImage) {
+        return nil;
+    }
+    UIImage *image = [UIImage imageWithCGImage:decodedImage scale:scale orientation:UIImageOrientationUp];
+    CGImageRelease(decodedImage);
+    return image;
+}
+
+static dispatch_queue_t ATLMLocationSnapshotRendererQueue()
+{
+    static dispatch_queue_t queue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        queue = dispatch_queue_create("com.layer.Atlas-Messenger.location-snapshot", DISPATCH_QUEUE_SERIAL);
+    });
+    return queue;
+}
+
+@interface ATLMLocationSnapshotRenderer ()
+
+@property (nonnull, nonatomic, readwrite) ATLMDiskLRUCache *diskCache;
+@property (nonnull, nonatomic, copy) ATLMLocationSnapshotBlock snapshotBlock;
+@property (nonnull, nonatomic) NSMutableDictionary<NSString *, NSMutableArray *> *completionsByKey;
+@property (nonatomic, readwrite) NSUInteger countOfRenders;
+@property (nonatomic, readwrite) NSUInteger countOfDiskHits;
+@property (nonatomic, readwrite) NSUInteger countOfCoalescedRequests;
+
+@end
+
+@implementation ATLMLocationSnapshotRenderer
+
++ (instancetype)sharedRenderer
+{
+    static ATLMLocationSnapshotRenderer *sharedRenderer;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        ATLMDiskLRUCache *diskCache = [ATLMDiskLRUCache cacheWithDirectory:[self defaultDirectory] byteLimit:ATLMLocationSnapshotRendererDefaultDiskByteLimit];
+        sharedRenderer = [self rendererWithDiskCache:diskCache snapshotBlock:nil];
+    });
+    return sharedRenderer;
+}
+
++ (instancetype)rendererWithDiskCache:(ATLMDiskLRUCache *)diskCache snapshotBlock:(ATLMLocationSnapshotBlock)snapshotBlock
+{
+    return [[self alloc] initWithDiskCache:diskCache snapshotBlock:snapshotBlock];
+}
+
++ (NSString *)defaultDirectory
+{
+    NSString *cachesDirectory = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES).firstObject;
+    return [cachesDirectory stringByAppendingPathComponent:@"LocationSnapshots"];
+}
+
++ (ATLMLocationSnapshotBlock)mapSnapshotterBlock
+{
+    return ^(MKMapSnapshotOptions *options, void (^completion)(UIImage *, NSError *)) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            MKMapSnapshotter *snapshotter = [[MKMapSnapshotter alloc] initWithOptions:options];
+            [snapshotter startWithQueue:ATLMLocationSnapshotRendererQueue() completionHandler:^(MKMapSnapshot *snapshot, NSError *error) {
+                completion(snapshot.image, error);
+            }];
+        });
+    };
+}
+
+- (id)initWithDiskCache:(ATLMDiskLRUCache *)diskCache snapshotBlock:(ATLMLocationSnapshotBlock)snapshotBlock
+{
+    NSParameterAssert(diskCache);
+    self = [super init];
+    if (self) {
+        _diskCache = diskCache;
+        _snapshotBlock = [snapshotBlock ?: [[self class] mapSnapshotterBlock] copy];
+        _scale = [UIScreen mainScreen].scale;
+        _completionsByKey = [NSMutableDictionary new];
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use rendererWithDiskCache:snapshotBlock:" userInfo:nil];
+}
+
+#pragma mark - Rendering
+
+- (void)renderSnapshotForCoordinate:(CLLocationCoordinate2D)coordinate zoomLevel:(NSUInteger)zoomLevel size:(CGSize)size completion:(void (^)(UIImage *, NSError *))completion
+{
+    NSParameterAssert(completion);
+    CGFloat scale = self.scale;
+    NSString *key = ATLMLocationSnapshotKey(coordinate, zoomLevel, size, scale);
+    NSMutableArray *completions = self.completionsByKey[key];
+    if (completions) {
+        [completions addObject:[completion copy]];
+        self.countOfCoalescedRequests += 1;
+        return;
+    }
+    self.completionsByKey[key] = [NSMutableArray arrayWithObject:[completion copy]];
+
+    ATLMDiskLRUCache *diskCache = self.diskCache;
+    ATLMLocationSnapshotBlock snapshotBlock = self.snapshotBlock;
+    MKCoordinateRegion region = ATLMLocationSnapshotRegion(ATLMLocationSnapshotRoundedCoordinate(coordinate, zoomLevel, scale), zoomLevel, size);
+    dispatch_async(ATLMLocationSnapshotRendererQueue(), ^{
+        NSData *data = [diskCache dataForKey:key];
+        UIImage *cachedImage = data ? ATLMLocationSnapshotDecodedImage(data, scale) : nil;
+        if (cachedImage) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                self.countOfDiskHits += 1;
+                [self finishSnapshotForKey:key image:cachedImage error:nil];
+            });
+            return;
+        }
+        MKMapSnapshotOptions *options = [MKMapSnapshotOptions new];
+        options.region = region;
+        options.size = CGSizeMake(ceil(size.width), ceil(size.height));
+        options.scale = scale;
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        snapshotBlock(options, ^(UIImage *mapImage, NSError *error) {
+            dispatch_async(ATLMLocationSnapshotRendererQueue(), ^{
+                UIImage *image = mapImage ? ATLMLocationSnapshotImageWithPin(mapImage) : nil;
+                NSData *JPEGData = image ? ATLMLocationSnapshotJPEGData(image) : nil;
+                if (JPEGData) {
+                    [diskCache setData:JPEGData forKey:key];
+                }
+                ATLMInstrumentationRecordDuration(ATLMMetricLocationSnapshot, CFAbsoluteTimeGetCurrent() - start);
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    self.countOfRenders += 1;
+                    [self finishSnapshotForKey:key image:image error:error];
+                });
+            });
+        });
+    });
+}
+
+- (void)finishSnapshotForKey:(NSString *)key image:(UIImage *)image error:(NSError *)error
+{
+    NSArray *completions = self.completionsByKey[key];
+    [self.completionsByKey removeObjectForKey:key];
+    for (void (^completion)(UIImage *, NSError *) in completions) {
+        completion(image, error);
+    }
+}
+
+@end
@@ -0,0 +1,185 @@
+//
+//  ATLMMediaTranscoder.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <UIKit/UIKit.h>
+
+/**
+ @abstract The message parts produced by the `ATLMMediaTranscoder` for one
+   media item, along with what it took to produce them.
+ */
+@interface ATLMTranscodedMedia : NSObject
+
+/**
+ @abstract The MIME types of the parts: the media itself, `ATLMIMETypeImageJPEGPreview` and `ATLMIMETypeImageSize`.
+ */
+@property (nonnull, nonatomic, readonly) NSArray<NSString *> *MIMETypes;
+
+/**
+ @abstract The contents of the parts, in the order of `MIMETypes`.
+ */
+@property (nonnull, nonatomic, readonly) NSArray<NSData *> *partData;
+
+/**
+ @abstract `NO` if the transcoder fell back to the media as read, which is then the only part.
+ */
+@property (nonatomic, readonly, getter=isTranscoded) BOOL transcoded;
+
+/**
+ @abstract The size of the media in pixels, as displayed.
+ */
+@property (nonatomic, readonly) CGSize pixelSize;
+
+/**
+ @abstract The size of the media as handed to the transcoder.
+ */
+@property (nonatomic, readonly) unsigned long long originalByteCount;
+
+/**
+ @abstract The size of the transcoded media part.
+ */
+@property (nonatomic, readonly) unsigned long long byteCount;
+
+/**
+ @abstract The time spent decoding and encoding.
+ */
+@property (nonatomic, readonly) NSTimeInterval encodeDuration;
+
+@end
+
+typedef void(^ATLMMediaTranscoderCompletion)(ATLMTranscodedMedia *_Nullable media, NSError *_Nullable error);
+
+/**
+ @abstract The `ATLMMediaTranscoder` prepares outgoing images and videos on
+   background queues before they are sent.
+ @discussion Images are decoded once, downscaled to `maximumPixelSize` while
+   decoding and re-encoded as JPEG at the highest quality fitting
+   `imageByteBudget`; the preview and size parts are produced from the same
+   decoded image. Videos are re-encoded to H.264 at no more than
+   `videoBitRateCeiling`, unless they already are below it. Up to one item per
+   core is transcoded at a time. Completion handlers are called on the main
+   thread.
+ */
+@interface ATLMMediaTranscoder : NSObject
+
+/**
+ @abstract Creates a transcoder with the default settings.
+ */
++ (nonnull instancetype)transcoder;
+
+/**
+ @abstract The longest side of transcoded images in pixels. Defaults to 2048.
+ */
+@property (nonatomic) CGFloat maximumPixelSize;
+
+/**
+ @abstract The longest side of previews in pixels. Defaults to 512.
+ */
+@property (nonatomic) CGFloat previewPixelSize;
+
+/**
+ @abstract The JPEG quality tried first. Defaults to 0.75.
+ */
+@property (nonatomic) CGFloat JPEGQuality;
+
+/**
+ @abstract The lowest JPEG quality used to meet `imageByteBudget`. Defaults to 0.45.
+ */
+@property (nonatomic) CGFloat minimumJPEGQuality;
+
+/**
+ @abstract The size transcoded images should fit in. Defaults to 600 KB.
+ */
+@property (nonatomic) NSUInteger imageByteBudget;
+
+/**
+ @abstract The highest average video bit rate in bits per second. Defaults to 1.5 Mbps.
+ */
+@property (nonatomic) NSUInteger videoBitRateCeiling;
+
+/**
+ @abstract The longest side of transcoded videos in pixels. Defaults to 1280.
+ */
+@property (nonatomic) CGFloat maximumVideoPixelSize;
+
+/**
+ @abstract The maximum number of items transcoded in parallel. Defaults to the number of active cores.
+ */
+@property (nonatomic) NSUInteger maximumConcurrentTranscodeCount;
+
+/**
+ @abstract Transcodes encoded image data.
+ */
+- (void)transcodeImageData:(nonnull NSData *)imageData completion:(nonnull ATLMMediaTranscoderCompletion)completion;
+
+/**
+ @abstract Transcodes the video file at `fileURL`.
+ */
+- (void)transcodeVideoAtURL:(nonnull NSURL *)fileURL completion:(nonnull ATLMMediaTranscoderCompletion)completion;
+
+/**
+ @abstract Reads the media from `inputStream` on a background queue and transcodes it.
+ @param MIMEType The MIME type of the media; images and `ATLMIMETypeVideoMP4` are supported.
+ @param inputStream An unopened stream providing the media.
+ @param completion The block called with the result.
+ */
+- (void)transcodeMediaWithMIMEType:(nonnull NSString *)MIMEType inputStream:(nonnull NSInputStream *)inputStream completion:(nonnull ATLMMediaTranscoderCompletion)completion;
+
+/**
+ @abstract Reads the media from `inputStream` on a background queue and transcodes it, falling back to the media as read.
+ @discussion When the media can't be transcoded, the completion is called with
+   an untranscoded `ATLMTranscodedMedia` holding the media as read, along with
+   the error that prevented transcoding. The media is `nil` only if it couldn't
+   be read.
+ @param MIMEType The MIME type of the media.
+ @param inputStream An unopened stream providing the media.
+ @param completion The block called with the result.
+ */
+- (void)transcodeMediaWithMIMEType:(nonnull NSString *)MIMEType inputStream:(nonnull NSInputStream *)inputStream fallingBackToOriginalWithCompletion:(nonnull ATLMMediaTranscoderCompletion)completion;
+
+/**
+ @abstract Returns `YES` if media of the supplied type can be transcoded.
+ */
++ (BOOL)canTranscodeMIMEType:(nonnull NSString *)MIMEType;
+
+/**
+ @abstract Returns the MIME type of the media part transcoded from media of the supplied type.
+ */
++ (nonnull NSString *)MIMETypeOfTranscodedMediaWithMIMEType:(nonnull NSString *)MIMEType;
+
+///-----------------
+/// @name Metrics
+///-----------------
+
+/**
+ @abstract The number of items transcoded.
+ */
+@property (nonatomic, readonly) NSUInteger countOfTranscodedItems;
+
+/**
+ @abstract The bytes saved over sending the media unchanged.
+ */
+@property (nonatomic, readonly) long long countOfBytesSaved;
+
+/**
+ @abstract The total time spent transcoding.
+ */
+@property (nonatomic, readonly) NSTimeInterval totalEncodeDuration;
+
+@end
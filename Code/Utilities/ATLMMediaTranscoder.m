@@ -0,0 +1,493 @@
+//
+//  ATLMMediaTranscoder.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMMediaTranscoder.h"
+#import <AVFoundation/AVFoundation.h>
+#import <ImageIO/ImageIO.h>
+#import <MobileCoreServices/MobileCoreServices.h>
+#import "ATLMessagingUtilities.h"
+#import "ATLMErrors.h"
+#import "ATLMInstrumentation.h"
+
+static const CGFloat ATLMMediaTranscoderDefaultMaximumPixelSize = 2048;
+static const CGFloat ATLMMediaTranscoderDefaultPreviewPixelSize = 512;
+static const CGFloat ATLMMediaTranscoderDefaultJPEGQuality = 0.75;
+static const CGFloat ATLMMediaTranscoderDefaultMinimumJPEGQuality = 0.45;
+static const CGFloat ATLMMediaTranscoderJPEGQualityStep = 0.1;
+static const CGFloat ATLMMediaTranscoderPreviewJPEGQuality = 0.5;
+static const NSUInteger ATLMMediaTranscoderDefaultImageByteBudget = 600 * 1024;
+static const NSUInteger ATLMMediaTranscoderDefaultVideoBitRateCeiling = 1500000;
+static const CGFloat ATLMMediaTranscoderDefaultMaximumVideoPixelSize = 1280;
+static const NSUInteger ATLMMediaTranscoderAudioBitRate = 64000;
+
+static NSError *ATLMMediaTranscoderError(NSInteger code, NSString *description)
+{
+    return [NSError errorWithDomain:ATLMErrorDomain code:code userInfo:@{ NSLocalizedDescriptionKey: description }];
+}
+
+static NSData *ATLMJPEGDataForImage(CGImageRef image, CGFloat quality)
+{
+    NSMutableData *data = [NSMutableData new];
+    CGImageDestinationRef destination = CGImageDestinationCreateWithData((__bridge CFMutableDataRef)data, kUTTypeJPEG, 1, NULL);
+    if (!destination) {
+        return nil;
+    }
+    CGImageDestinationAddImage(destination, image, (__bridge CFDictionaryRef)@{ (__bridge NSString *)kCGImageDestinationLossyCompressionQuality: @(quality) });
+    BOOL success = CGImageDestinationFinalize(destination);
+    CFRelease(destination);
+    return success ? data : nil;
+}
+
+/**
+ @abstract Downscales an already decoded image so that its longest side is at most `maximumPixelSize`.
+ */
+static CGImageRef ATLMCreateScaledImage(CGImageRef image, CGFloat maximumPixelSize) CF_RETURNS_RETAINED;
+static CGImageRef ATLMCreateScaledImage(CGImageRef image, CGFloat maximumPixelSize)
+{
+    size_t width = CGImageGetWidth(image);
+    size_t height = CGImageGetHeight(image);
+    CGFloat scale = MIN(1.0, maximumPixelSize / MAX(width, height));
+    size_t scaledWidth = MAX(1, (size_t)round(width * scale));
+    size_t scaledHeight = MAX(1, (size_t)round(height * scale));
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(NULL, scaledWidth, scaledHeight, 8, 0, colorSpace, (CGBitmapInfo)kCGImageAlphaNoneSkipLast);
+    CGColorSpaceRelease(colorSpace);
+    if (!context) {
+        return NULL;
+    }
+    CGContextSetInterpolationQuality(context, kCGInterpolationMedium);
+    CGContextDrawImage(context, CGRectMake(0, 0, scaledWidth, scaledHeight), image);
+    CGImageRef scaledImage = CGBitmapContextCreateImage(context);
+    CGContextRelease(context);
+    return scaledImage;
+}
+
+static NSData *ATLMImageSizeJSONData(CGSize size)
+{
+    NSDictionary *imageSize = @{ @"width": @(size.width), @"height": @(size.height), @"orientation": @(UIImageOrientationUp) };
+    return [NSJSONSerialization dataWithJSONObject:imageSize options:0 error:nil];
+}
+
+@interface ATLMTranscodedMedia ()
+
+@property (nonnull, nonatomic, readwrite) NSArray<NSString *> *MIMETypes;
+@property (nonnull, nonatomic, readwrite) NSArray<NSData *> *partData;
+@property (nonatomic, readwrite, getter=isTranscoded) BOOL transcoded;
+@property (nonatomic, readwrite) CGSize pixelSize;
+@property (nonatomic, readwrite) unsigned long long originalByteCount;
+@property (nonatomic, readwrite) unsigned long long byteCount;
+@property (nonatomic, readwrite) NSTimeInterval encodeDuration;
+
+@end
+
+@implementation ATLMTranscodedMedia
+
+@end
+
+@interface ATLMMediaTranscoder ()
+
+@property (nonnull, nonatomic) NSOperationQueue *transcodeQueue;
+@property (nonatomic, readwrite) NSUInteger countOfTranscodedItems;
+@property (nonatomic, readwrite) long long countOfBytesSaved;
+@property (nonatomic, readwrite) NSTimeInterval totalEncodeDuration;
+
+@end
+
+@implementation ATLMMediaTranscoder
+
++ (instancetype)transcoder
+{
+    return [[self alloc] init];
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self) {
+        _maximumPixelSize = ATLMMediaTranscoderDefaultMaximumPixelSize;
+        _previewPixelSize = ATLMMediaTranscoderDefaultPreviewPixelSize;
+        _JPEGQuality = ATLMMediaTranscoderDefaultJPEGQuality;
+        _minimumJPEGQuality = ATLMMediaTranscoderDefaultMinimumJPEGQuality;
+        _imageByteBudget = ATLMMediaTranscoderDefaultImageByteBudget;
+        _videoBitRateCeiling = ATLMMediaTranscoderDefaultVideoBitRateCeiling;
+        _maximumVideoPixelSize = ATLMMediaTranscoderDefaultMaximumVideoPixelSize;
+        _transcodeQueue = [NSOperationQueue new];
+        _transcodeQueue.name = @"com.layer.Atlas-Messenger.media-transcoder";
+        _transcodeQueue.qualityOfService = NSQualityOfServiceUserInitiated;
+        self.maximumConcurrentTranscodeCount = [NSProcessInfo processInfo].activeProcessorCount;
+    }
+    return self;
+}
+
+- (void)setMaximumConcurrentTranscodeCount:(NSUInteger)maximumConcurrentTranscodeCount
+{
+    _maximumConcurrentTranscodeCount = MAX(1, maximumConcurrentTranscodeCount);
+    self.transcodeQueue.maxConcurrentOperationCount = _maximumConcurrentTranscodeCount;
+}
+
++ (BOOL)canTranscodeMIMEType:(NSString *)MIMEType
+{
+    return [MIMEType isEqualToString:ATLMIMETypeImageJPEG] || [MIMEType isEqualToString:ATLMIMETypeImagePNG] || [MIMEType isEqualToString:ATLMIMETypeVideoMP4];
+}
+
++ (NSString *)MIMETypeOfTranscodedMediaWithMIMEType:(NSString *)MIMEType
+{
+    // Images are always re-encoded as JPEG.
+    return [MIMEType isEqualToString:ATLMIMETypeVideoMP4] ? ATLMIMETypeVideoMP4 : ATLMIMETypeImageJPEG;
+}
+
+#pragma mark - Public API
+
+- (void)transcodeImageData:(NSData *)imageData completion:(ATLMMediaTranscoderCompletion)completion
+{
+    NSParameterAssert(imageData);
+    NSParameterAssert(completion);
+    [self.transcodeQueue addOperationWithBlock:^{
+        NSError *error;
+        ATLMTranscodedMedia *media = [self mediaByTranscodingImageData:imageData error:&error];
+        [self completeWithMedia:media error:error completion:completion];
+    }];
+}
+
+- (void)transcodeVideoAtURL:(NSURL *)fileURL completion:(ATLMMediaTranscoderCompletion)completion
+{
+    NSParameterAssert(fileURL);
+    NSParameterAssert(completion);
+    [self.transcodeQueue addOperationWithBlock:^{
+        NSError *error;
+        ATLMTranscodedMedia *media = [self mediaByTranscodingVideoAtURL:fileURL error:&error];
+        [self completeWithMedia:media error:error completion:completion];
+    }];
+}
+
+- (void)transcodeMediaWithMIMEType:(NSString *)MIMEType inputStream:(NSInputStream *)inputStream completion:(ATLMMediaTranscoderCompletion)completion
+{
+    [self transcodeMediaWithMIMEType:MIMEType inputStream:inputStream fallingBackToOriginal:NO completion:completion];
+}
+
+- (void)transcodeMediaWithMIMEType:(NSString *)MIMEType inputStream:(NSInputStream *)inputStream fallingBackToOriginalWithCompletion:(ATLMMediaTranscoderCompletion)completion
+{
+    [self transcodeMediaWithMIMEType:MIMEType inputStream:inputStream fallingBackToOriginal:YES completion:completion];
+}
+
+- (void)transcodeMediaWithMIMEType:(NSString *)MIMEType inputStream:(NSInputStream *)inputStream fallingBackToOriginal:(BOOL)fallingBackToOriginal completion:(ATLMMediaTranscoderCompletion)completion
+{
+    NSParameterAssert(MIMEType);
+    NSParameterAssert(inputStream);
+    NSParameterAssert(completion);
+    BOOL canTranscode = [[self class] canTranscodeMIMEType:MIMEType];
+    if (!canTranscode && !fallingBackToOriginal) {
+        NSError *error = ATLMMediaTranscoderError(ATLMMediaTypeNotSupported, [NSString stringWithFormat:@"Media of type %@ can't be transcoded.", MIMEType]);
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(nil, error);
+        });
+        return;
+    }
+    [self.transcodeQueue addOperationWithBlock:^{
+        NSError *error;
+        ATLMTranscodedMedia *media;
+        NSData *originalData;
+        if (!canTranscode) {
+            originalData = [self dataFromInputStream:inputStream];
+            error = ATLMMediaTranscoderError(ATLMMediaTypeNotSupported, [NSString stringWithFormat:@"Media of type %@ can't be transcoded.", MIMEType]);
+        } else if ([MIMEType isEqualToString:ATLMIMETypeVideoMP4]) {
+            NSURL *fileURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID].UUIDString stringByAppendingPathExtension:@"mp4"]]];
+            if ([self writeInputStream:inputStream toURL:fileURL]) {
+                media = [self mediaByTranscodingVideoAtURL:fileURL error:&error];
+                if (!media && fallingBackToOriginal) {
+                    // Mapped before the file is removed; the mapping outlives it.
+                    originalData = [NSData dataWithContentsOfURL:fileURL options:NSDataReadingMappedIfSafe error:nil];
+                }
+            } else {
+                error = ATLMMediaTranscoderError(ATLMMediaTranscodingFailed, @"Failed to read the video.");
+            }
+            [[NSFileManager defaultManager] removeItemAtURL:fileURL error:nil];
+        } else {
+            NSData *imageData = [self dataFromInputStream:inputStream];
+            if (imageData.length) {
+                media = [self mediaByTranscodingImageData:imageData error:&error];
+                originalData = imageData;
+            } else {
+                error = ATLMMediaTranscoderError(ATLMMediaTranscodingFailed, @"Failed to read the image.");
+            }
+        }
+        if (!media && fallingBackToOriginal && originalData.length) {
+            media = [ATLMTranscodedMedia new];
+            media.MIMETypes = @[ MIMEType ];
+            media.partData = @[ originalData ];
+            media.originalByteCount = originalData.length;
+            media.byteCount = originalData.length;
+        }
+        [self completeWithMedia:media error:error completion:completion];
+    }];
+}
+
+#pragma mark - Images
+
+- (ATLMTranscodedMedia *)mediaByTranscodingImageData:(NSData *)imageData error:(NSError **)error
+{
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef)imageData, NULL);
+    if (!source) {
+        if (error) *error = ATLMMediaTranscoderError(ATLMMediaTranscodingFailed, @"Failed to read the image.");
+        return nil;
+    }
+    // The only decode: downscaled while decoding, with the EXIF orientation applied.
+    NSDictionary *options = @{ (__bridge NSString *)kCGImageSourceCreateThumbnailFromImageAlways: @YES,
+                               (__bridge NSString *)kCGImageSourceCreateThumbnailWithTransform: @YES,
+                               (__bridge NSString *)kCGImageSourceShouldCacheImmediately: @YES,
+                               (__bridge NSString *)kCGImageSourceThumbnailMaxPixelSize: @(self.maximumPixelSize) };
+    CGImageRef image = CGImageSourceCreateThumbnailAtIndex(source, 0, (__bridge CFDictionaryRef)options);
+    NSString *sourceType = (__bridge NSString *)CGImageSourceGetType(source);
+    NSDictionary *sourceProperties = (__bridge_transfer NSDictionary *)CGImageSourceCopyPropertiesAtIndex(source, 0, NULL);
+    CFRelease(source);
+    if (!image) {
+        if (error) *error = ATLMMediaTranscoderError(ATLMMediaTranscodingFailed, @"Failed to decode the image.");
+        return nil;
+    }
+    CGSize pixelSize = CGSizeMake(CGImageGetWidth(image), CGImageGetHeight(image));
+
+    NSData *JPEGData;
+    for (CGFloat quality = self.JPEGQuality; quality >= self.minimumJPEGQuality - FLT_EPSILON; quality -= ATLMMediaTranscoderJPEGQualityStep) {
+        JPEGData = ATLMJPEGDataForImage(image, quality);
+        if (JPEGData.length <= self.imageByteBudget) {
+            break;
+        }
+    }
+    // A small JPEG can grow when re-encoded; keep it if it needed no downscaling.
+    BOOL sourceFits = [sourceProperties[(__bridge NSString *)kCGImagePropertyPixelWidth] doubleValue] <= self.maximumPixelSize && [sourceProperties[(__bridge NSString *)kCGImagePropertyPixelHeight] doubleValue] <= self.maximumPixelSize;
+    BOOL sourceIsUpright = [sourceProperties[(__bridge NSString *)kCGImagePropertyOrientation] integerValue] <= 1;
+    if ([sourceType isEqualToString:(__bridge NSString *)kUTTypeJPEG] && sourceFits && sourceIsUpright && imageData.length <= JPEGData.length) {
+        JPEGData = imageData;
+    }
+
+    CGImageRef previewImage = ATLMCreateScaledImage(image, self.previewPixelSize);
+    NSData *previewData = previewImage ? ATLMJPEGDataForImage(previewImage, ATLMMediaTranscoderPreviewJPEGQuality) : nil;
+    if (previewImage) CGImageRelease(previewImage);
+    CGImageRelease(image);
+    if (!JPEGData || !previewData) {
+        if (error) *error = ATLMMediaTranscoderError(ATLMMediaTranscodingFailed, @"Failed to encode the image.");
+        return nil;
+    }
+
+    ATLMTranscodedMedia *media = [ATLMTranscodedMedia new];
+    media.transcoded = YES;
+    media.MIMETypes = @[ ATLMIMETypeImageJPEG, ATLMIMETypeImageJPEGPreview, ATLMIMETypeImageSize ];
+    media.partData = @[ JPEGData, previewData, ATLMImageSizeJSONData(pixelSize) ];
+    media.pixelSize = pixelSize;
+    media.originalByteCount = imageData.length;
+    media.byteCount = JPEGData.length;
+    media.encodeDuration = CFAbsoluteTimeGetCurrent() - startTime;
+    return media;
+}
+
+#pragma mark - Videos
+
+- (ATLMTranscodedMedia *)mediaByTranscodingVideoAtURL:(NSURL *)fileURL error:(NSError **)error
+{
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    AVURLAsset *asset = [AVURLAsset URLAssetWithURL:fileURL options:@{ AVURLAssetPreferPreciseDurationAndTimingKey: @YES }];
+    AVAssetTrack *videoTrack = [asset tracksWithMediaType:AVMediaTypeVideo].firstObject;
+    if (!videoTrack) {
+        if (error) *error = ATLMMediaTranscoderError(ATLMMediaTranscodingFailed, @"The video has no video track.");
+        return nil;
+    }
+    NSNumber *fileSize;
+    [fileURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:nil];
+
+    CGSize naturalSize = videoTrack.naturalSize;
+    CGFloat scale = MIN(1.0, self.maximumVideoPixelSize / MAX(naturalSize.width, naturalSize.height));
+    // H.264 wants even dimensions.
+    CGSize encodedSize = CGSizeMake(2 * round(naturalSize.width * scale / 2), 2 * round(naturalSize.height * scale / 2));
+    BOOL withinCeiling = videoTrack.estimatedDataRate <= self.videoBitRateCeiling && scale == 1.0;
+
+    NSURL *outputURL = fileURL;
+    if (!withinCeiling) {
+        outputURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID].UUIDString stringByAppendingPathExtension:@"mp4"]]];
+        if (![self encodeVideoAsset:asset videoTrack:videoTrack size:encodedSize toURL:outputURL error:error]) {
+            [[NSFileManager defaultManager] removeItemAtURL:outputURL error:nil];
+            return nil;
+        }
+    }
+    NSData *videoData = [NSData dataWithContentsOfURL:outputURL options:NSDataReadingMappedIfSafe error:error];
+    if (outputURL != fileURL) {
+        [[NSFileManager defaultManager] removeItemAtURL:outputURL error:nil];
+    }
+    if (!videoData) {
+        return nil;
+    }
+
+    // Preview and size from the first frame, as displayed.
+    AVAssetImageGenerator *imageGenerator = [AVAssetImageGenerator assetImageGeneratorWithAsset:asset];
+    imageGenerator.appliesPreferredTrackTransform = YES;
+    imageGenerator.maximumSize = CGSizeMake(self.previewPixelSize, self.previewPixelSize);
+    CGImageRef previewImage = [imageGenerator copyCGImageAtTime:kCMTimeZero actualTime:NULL error:error];
+    if (!previewImage) {
+        return nil;
+    }
+    NSData *previewData = ATLMJPEGDataForImage(previewImage, ATLMMediaTranscoderPreviewJPEGQuality);
+    CGImageRelease(previewImage);
+    CGSize outputSize = withinCeiling ? naturalSize : encodedSize;
+    CGRect displayRect = CGRectApplyAffineTransform(CGRectMake(0, 0, outputSize.width, outputSize.height), videoTrack.preferredTransform);
+    CGSize pixelSize = CGSizeMake(fabs(displayRect.size.width), fabs(displayRect.size.height));
+
+    ATLMTranscodedMedia *media = [ATLMTranscodedMedia new];
+    media.transcoded = YES;
+    media.MIMETypes = @[ ATLMIMETypeVideoMP4, ATLMIMETypeImageJPEGPreview, ATLMIMETypeImageSize ];
+    media.partData = @[ videoData, previewData ?: [NSData data], ATLMImageSizeJSONData(pixelSize) ];
+    media.pixelSize = pixelSize;
+    media.originalByteCount = fileSize.unsignedLongLongValue;
+    media.byteCount = videoData.length;
+    media.encodeDuration = CFAbsoluteTimeGetCurrent() - startTime;
+    return media;
+}
+
+- (BOOL)encodeVideoAsset:(AVAsset *)asset videoTrack:(AVAssetTrack *)videoTrack size:(CGSize)size toURL:(NSURL *)outputURL error:(NSError **)error
+{
+    AVAssetReader *reader = [AVAssetReader assetReaderWithAsset:asset error:error];
+    AVAssetWriter *writer = [AVAssetWriter assetWriterWithURL:outputURL fileType:AVFileTypeMPEG4 error:error];
+    if (!reader || !writer) {
+        return NO;
+    }
+    writer.shouldOptimizeForNetworkUse = YES;
+
+    NSMutableArray *outputs = [NSMutableArray new];
+    NSMutableArray *inputs = [NSMutableArray new];
+    AVAssetReaderTrackOutput *videoOutput = [AVAssetReaderTrackOutput assetReaderTrackOutputWithTrack:videoTrack outputSettings:@{ (__bridge NSString *)kCVPixelBufferPixelFormatTypeKey: @(kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange) }];
+    NSDictionary *videoSettings = @{ AVVideoCodecKey: AVVideoCodecH264,
+                                     AVVideoWidthKey: @(size.width),
+                                     AVVideoHeightKey: @(size.height),
+                                     AVVideoCompressionPropertiesKey: @{ AVVideoAverageBitRateKey: @(self.videoBitRateCeiling),
+                                                                         AVVideoProfileLevelKey: AVVideoProfileLevelH264HighAutoLevel } };
+    AVAssetWriterInput *videoInput = [AVAssetWriterInput assetWriterInputWithMediaType:AVMediaTypeVideo outputSettings:videoSettings];
+    videoInput.transform = videoTrack.preferredTransform;
+    [outputs addObject:videoOutput];
+    [inputs addObject:videoInput];
+
+    AVAssetTrack *audioTrack = [asset tracksWithMediaType:AVMediaTypeAudio].firstObject;
+    if (audioTrack) {
+        AVAssetReaderTrackOutput *audioOutput = [AVAssetReaderTrackOutput assetReaderTrackOutputWithTrack:audioTrack outputSettings:@{ AVFormatIDKey: @(kAudioFormatLinearPCM) }];
+        NSDictionary *audioSettings = @{ AVFormatIDKey: @(kAudioFormatMPEG4AAC),
+                                         AVNumberOfChannelsKey: @2,
+                                         AVSampleRateKey: @44100,
+                                         AVEncoderBitRateKey: @(ATLMMediaTranscoderAudioBitRate) };
+        [outputs addObject:audioOutput];
+        [inputs addObject:[AVAssetWriterInput assetWriterInputWithMediaType:AVMediaTypeAudio outputSettings:audioSettings]];
+    }
+    for (NSUInteger index = 0; index < outputs.count; index++) {
+        if (![reader canAddOutput:outputs[index]] || ![writer canAddInput:inputs[index]]) {
+            if (error) *error = ATLMMediaTranscoderError(ATLMMediaTranscodingFailed, @"Failed to configure the video encoder.");
+            return NO;
+        }
+        [reader addOutput:outputs[index]];
+        [writer addInput:inputs[index]];
+    }
+    if (![reader startReading] || ![writer startWriting]) {
+        if (error) *error = reader.error ?: writer.error;
+        return NO;
+    }
+    [writer startSessionAtSourceTime:kCMTimeZero];
+
+    // Pump every track on its own queue; this operation waits for all of them.
+    dispatch_group_t group = dispatch_group_create();
+    for (NSUInteger index = 0; index < outputs.count; index++) {
+        AVAssetReaderOutput *output = outputs[index];
+        AVAssetWriterInput *input = inputs[index];
+        dispatch_group_enter(group);
+        dispatch_queue_t queue = dispatch_queue_create("com.layer.Atlas-Messenger.media-transcoder.track", DISPATCH_QUEUE_SERIAL);
+        __block BOOL finished = NO;
+        [input requestMediaDataWhenReadyOnQueue:queue usingBlock:^{
+            while (!finished && input.isReadyForMoreMediaData) {
+                CMSampleBufferRef sampleBuffer = [output copyNextSampleBuffer];
+                BOOL appended = sampleBuffer && [input appendSampleBuffer:sampleBuffer];
+                if (sampleBuffer) CFRelease(sampleBuffer);
+                if (!appended) {
+                    finished = YES;
+                    [input markAsFinished];
+                    dispatch_group_leave(group);
+                }
+            }
+        }];
+    }
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+
+    if (reader.status == AVAssetReaderStatusFailed) {
+        [writer cancelWriting];
+        if (error) *error = reader.error;
+        return NO;
+    }
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    [writer finishWritingWithCompletionHandler:^{
+        dispatch_semaphore_signal(semaphore);
+    }];
+    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+    if (writer.status != AVAssetWriterStatusCompleted) {
+        if (error) *error = writer.error;
+        return NO;
+    }
+    return YES;
+}
+
+#pragma mark - Helpers
+
+- (void)completeWithMedia:(ATLMTranscodedMedia *)media error:(NSError *)error completion:(ATLMMediaTranscoderCompletion)completion
+{
+    dispatch_async(dispatch_get_main_queue(), ^{
+        if (media.isTranscoded) {
+            self.countOfTranscodedItems += 1;
+            self.countOfBytesSaved += (long long)media.originalByteCount - (long long)media.byteCount;
+            self.totalEncodeDuration += media.encodeDuration;
+            ATLMInstrumentationRecordDuration(ATLMMetricMediaTranscode, media.encodeDuration);
+        }
+        completion(media, error);
+    });
+}
+
+- (NSData *)dataFromInputStream:(NSInputStream *)inputStream
+{
+    NSMutableData *data = [NSMutableData new];
+    uint8_t buffer[64 * 1024];
+    [inputStream open];
+    NSInteger length;
+    while ((length = [inputStream read:buffer maxLength:sizeof(buffer)]) > 0) {
+        [data appendBytes:buffer length:length];
+    }
+    [inputStream close];
+    return length < 0 ? nil : data;
+}
+
+- (BOOL)writeInputStream:(NSInputStream *)inputStream toURL:(NSURL *)fileURL
+{
+    if (![[NSFileManager defaultManager] createFileAtPath:fileURL.path contents:nil attributes:nil]) {
+        return NO;
+    }
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingToURL:fileURL error:nil];
+    uint8_t buffer[64 * 1024];
+    [inputStream open];
+    NSInteger length;
+    while ((length = [inputStream read:buffer maxLength:sizeof(buffer)]) > 0) {
+        [fileHandle writeData:[NSData dataWithBytesNoCopy:buffer length:length freeWhenDone:NO]];
+    }
+    [inputStream close];
+    [fileHandle closeFile];
+    return length == 0;
+}
+
+@end
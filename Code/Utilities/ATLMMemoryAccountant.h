@@ -0,0 +1,149 @@
+//
+//  ATLMMemoryAccountant.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <UIKit/UIKit.h>
+
+/**
+ @abstract The categories memory is accounted and budgeted in.
+ */
+extern NSString *_Nonnull const ATLMMemoryCategoryImages;
+extern NSString *_Nonnull const ATLMMemoryCategoryCaches;
+
+/**
+ @abstract Returns the number of bytes the decoded bitmap of an image takes,
+   summed over the frames of an animated image.
+ */
+extern NSUInteger ATLMMemoryFootprintOfImage(UIImage *_Nullable image);
+
+/**
+ @abstract The order memory is reclaimed in: lower priorities first.
+ */
+typedef NS_ENUM(NSInteger, ATLMMemoryPriority) {
+    ATLMMemoryPriorityDiscardable = 0, // Caches whose content can be recomputed.
+    ATLMMemoryPriorityOffscreen   = 1, // Content of screens which are not visible.
+    ATLMMemoryPriorityVisible     = 2, // Content on screen, only reclaimed on a memory warning.
+};
+
+/**
+ @abstract An object holding memory the `ATLMMemoryAccountant` keeps track of.
+ */
+@protocol ATLMMemoryConsumer <NSObject>
+
+/**
+ @abstract The number of bytes the receiver currently holds.
+ */
+@property (nonatomic, readonly) NSUInteger memoryFootprint;
+
+/**
+ @abstract One of the `ATLMMemoryCategory…` constants.
+ */
+@property (nonnull, nonatomic, readonly) NSString *memoryCategory;
+
+@property (nonatomic, readonly) ATLMMemoryPriority memoryPriority;
+
+/**
+ @abstract Releases whatever the receiver can restore later on.
+ @return The number of bytes released.
+ */
+- (NSUInteger)releaseMemory;
+
+@end
+
+/**
+ @abstract The `ATLMMemoryAccountant` keeps track of the memory held by its
+   consumers and enforces a budget per category and a total budget.
+ @discussion Consumers report changes of their footprint with
+   `consumerDidChangeFootprint:`. When a budget is exceeded, consumers are
+   asked to release memory in priority order, the least recently changed
+   first, until the footprint fits again; visible consumers are left alone.
+   On a memory warning every consumer is asked to release memory. Consumers
+   are referenced weakly. All methods must be called on the main thread.
+ */
+@interface ATLMMemoryAccountant : NSObject
+
+/**
+ @abstract The accountant shared by the application, which reacts to memory warnings.
+ */
++ (nonnull instancetype)sharedAccountant;
+
+/**
+ @abstract Creates a standalone accountant which does not observe memory warnings.
+ */
++ (nonnull instancetype)accountant;
+
+///----------------------
+/// @name Consumers
+///----------------------
+
+- (void)registerConsumer:(nonnull id<ATLMMemoryConsumer>)consumer;
+- (void)unregisterConsumer:(nonnull id<ATLMMemoryConsumer>)consumer;
+
+/**
+ @abstract Records the consumer's footprint and enforces the budgets.
+   Does nothing for consumers which are not registered.
+ */
+- (void)consumerDidChangeFootprint:(nonnull id<ATLMMemoryConsumer>)consumer;
+
+/**
+ @abstract Asks every consumer to release memory, visible ones last.
+ */
+- (void)handleMemoryWarning;
+
+///-------------
+/// @name Budgets
+///-------------
+
+/**
+ @abstract Sets the budget of a category; 0 removes it.
+ @discussion Defaults to 64 MB for images and 8 MB for caches.
+ */
+- (void)setBudget:(NSUInteger)bytes forCategory:(nonnull NSString *)category;
+- (NSUInteger)budgetForCategory:(nonnull NSString *)category;
+
+/**
+ @abstract The budget across all categories, 0 for none. Defaults to 96 MB.
+ */
+@property (nonatomic) NSUInteger totalBudget;
+
+///---------------
+/// @name Reporting
+///---------------
+
+@property (nonatomic, readonly) NSUInteger footprint;
+- (NSUInteger)footprintForCategory:(nonnull NSString *)category;
+
+/**
+ @abstract The largest footprint since creation or `resetHighWaterMarks`.
+ */
+@property (nonatomic, readonly) NSUInteger highWaterMark;
+- (NSUInteger)highWaterMarkForCategory:(nonnull NSString *)category;
+- (void)resetHighWaterMarks;
+
+/**
+ @abstract The number of times a consumer was asked to release memory.
+ */
+@property (nonatomic, readonly) NSUInteger countOfEvictions;
+
+/**
+ @abstract Returns the footprints, budgets and high-water marks per category, in bytes.
+ */
+- (nonnull NSDictionary *)report;
+
+@end
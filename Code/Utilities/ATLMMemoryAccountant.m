@@ -0,0 +1,289 @@
+//
+//  ATLMMemoryAccountant.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMMemoryAccountant.h"
+#import "ATLMInstrumentation.h"
+
+NSString *const ATLMMemoryCategoryImages = @"images";
+NSString *const ATLMMemoryCategoryCaches = @"caches";
+
+static const NSUInteger ATLMMemoryAccountantDefaultImageBudget = 64 * 1024 * 1024;
+static const NSUInteger ATLMMemoryAccountantDefaultCacheBudget = 8 * 1024 * 1024;
+static const NSUInteger ATLMMemoryAccountantDefaultTotalBudget = 96 * 1024 * 1024;
+
+NSUInteger ATLMMemoryFootprintOfImage(UIImage *image)
+{
+    if (image.images.count) {
+        NSUInteger footprint = 0;
+        for (UIImage *frame in image.images) {
+            footprint += ATLMMemoryFootprintOfImage(frame);
+        }
+        return footprint;
+    }
+    CGImageRef imageRef = image.CGImage;
+    return imageRef ? CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef) : 0;
+}
+
+@interface ATLMMemoryRecord : NSObject
+
+@property (nonatomic) NSUInteger footprint;
+@property (nonatomic) NSString *category;
+@property (nonatomic) NSUInteger sequence;
+
+@end
+
+@implementation ATLMMemoryRecord
+
+@end
+
+@interface ATLMMemoryAccountant ()
+
+@property (nonnull, nonatomic) NSMapTable *recordsByConsumer;
+@property (nonnull, nonatomic) NSMutableDictionary *budgetsByCategory;
+@property (nonnull, nonatomic) NSMutableDictionary *highWaterMarksByCategory;
+@property (nonatomic, readwrite) NSUInteger highWaterMark;
+@property (nonatomic, readwrite) NSUInteger countOfEvictions;
+@property (nonatomic) NSUInteger sequence;
+@property (nonatomic, getter=isEnforcing) BOOL enforcing;
+
+@end
+
+@implementation ATLMMemoryAccountant
+
++ (instancetype)sharedAccountant
+{
+    static ATLMMemoryAccountant *sharedAccountant;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedAccountant = [self accountant];
+        [[NSNotificationCenter defaultCenter] addObserver:sharedAccountant selector:@selector(handleMemoryWarning) name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+    });
+    return sharedAccountant;
+}
+
++ (instancetype)accountant
+{
+    return [[self alloc] init];
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self) {
+        _recordsByConsumer = [NSMapTable weakToStrongObjectsMapTable];
+        _budgetsByCategory = [@{ ATLMMemoryCategoryImages: @(ATLMMemoryAccountantDefaultImageBudget),
+                                 ATLMMemoryCategoryCaches: @(ATLMMemoryAccountantDefaultCacheBudget) } mutableCopy];
+        _highWaterMarksByCategory = [NSMutableDictionary new];
+        _totalBudget = ATLMMemoryAccountantDefaultTotalBudget;
+    }
+    return self;
+}
+
+#pragma mark - Consumers
+
+- (void)registerConsumer:(id<ATLMMemoryConsumer>)consumer
+{
+    if ([self.recordsByConsumer objectForKey:consumer]) {
+        return;
+    }
+    ATLMMemoryRecord *record = [ATLMMemoryRecord new];
+    record.category = consumer.memoryCategory;
+    [self.recordsByConsumer setObject:record forKey:consumer];
+    [self consumerDidChangeFootprint:consumer];
+}
+
+- (void)unregisterConsumer:(id<ATLMMemoryConsumer>)consumer
+{
+    [self.recordsByConsumer removeObjectForKey:consumer];
+}
+
+- (void)consumerDidChangeFootprint:(id<ATLMMemoryConsumer>)consumer
+{
+    ATLMMemoryRecord *record = [self.recordsByConsumer objectForKey:consumer];
+    if (!record) {
+        return;
+    }
+    record.footprint = consumer.memoryFootprint;
+    record.sequence = ++self.sequence;
+    [self updateHighWaterMarks];
+    [self enforceBudgets];
+}
+
+- (void)handleMemoryWarning
+{
+    NSArray *consumers = [self consumersInEvictionOrderForCategory:nil includingVisible:YES];
+    for (id<ATLMMemoryConsumer> consumer in consumers) {
+        [self evictConsumer:consumer];
+    }
+}
+
+#pragma mark - Budgets
+
+- (void)setBudget:(NSUInteger)bytes forCategory:(NSString *)category
+{
+    self.budgetsByCategory[category] = bytes ? @(bytes) : nil;
+    [self enforceBudgets];
+}
+
+- (NSUInteger)budgetForCategory:(NSString *)category
+{
+    return [self.budgetsByCategory[category] unsignedIntegerValue];
+}
+
+- (void)setTotalBudget:(NSUInteger)totalBudget
+{
+    _totalBudget = totalBudget;
+    [self enforceBudgets];
+}
+
+- (void)enforceBudgets
+{
+    // Releasing memory makes consumers report their new footprint, which must not recurse.
+    if (self.isEnforcing) {
+        return;
+    }
+    self.enforcing = YES;
+    for (NSString *category in self.budgetsByCategory.allKeys) {
+        NSUInteger budget = [self budgetForCategory:category];
+        NSArray *consumers = [self consumersInEvictionOrderForCategory:category includingVisible:NO];
+        for (id<ATLMMemoryConsumer> consumer in consumers) {
+            if ([self footprintForCategory:category] <= budget) {
+                break;
+            }
+            [self evictConsumer:consumer];
+        }
+    }
+    if (self.totalBudget) {
+        NSArray *consumers = [self consumersInEvictionOrderForCategory:nil includingVisible:NO];
+        for (id<ATLMMemoryConsumer> consumer in consumers) {
+            if (self.footprint <= self.totalBudget) {
+                break;
+            }
+            [self evictConsumer:consumer];
+        }
+    }
+    self.enforcing = NO;
+}
+
+- (NSArray *)consumersInEvictionOrderForCategory:(NSString *)category includingVisible:(BOOL)includingVisible
+{
+    NSMutableArray *consumers = [NSMutableArray new];
+    for (id<ATLMMemoryConsumer> consumer in self.recordsByConsumer.keyEnumerator.allObjects) {
+        ATLMMemoryRecord *record = [self.recordsByConsumer objectForKey:consumer];
+        if (!record.footprint || (category && ![record.category isEqualToString:category])) {
+            continue;
+        }
+        if (!includingVisible && consumer.memoryPriority >= ATLMMemoryPriorityVisible) {
+            continue;
+        }
+        [consumers addObject:consumer];
+    }
+    [consumers sortUsingComparator:^NSComparisonResult(id<ATLMMemoryConsumer> consumer, id<ATLMMemoryConsumer> otherConsumer) {
+        if (consumer.memoryPriority != otherConsumer.memoryPriority) {
+            return consumer.memoryPriority < otherConsumer.memoryPriority ? NSOrderedAscending : NSOrderedDescending;
+        }
+        NSUInteger sequence = [[self.recordsByConsumer objectForKey:consumer] sequence];
+        NSUInteger otherSequence = [[self.recordsByConsumer objectForKey:otherConsumer] sequence];
+        return sequence < otherSequence ? NSOrderedAscending : (sequence > otherSequence ? NSOrderedDescending : NSOrderedSame);
+    }];
+    return consumers;
+}
+
+- (void)evictConsumer:(id<ATLMMemoryConsumer>)consumer
+{
+    [consumer releaseMemory];
+    ATLMMemoryRecord *record = [self.recordsByConsumer objectForKey:consumer];
+    record.footprint = consumer.memoryFootprint;
+    self.countOfEvictions += 1;
+    ATLMInstrumentationCount(ATLMMetricMemoryEvictions);
+}
+
+#pragma mark - Reporting
+
+- (NSUInteger)footprint
+{
+    return [self sumOfFootprintsInCategory:nil];
+}
+
+- (NSUInteger)footprintForCategory:(NSString *)category
+{
+    return [self sumOfFootprintsInCategory:category];
+}
+
+- (NSUInteger)sumOfFootprintsInCategory:(NSString *)category
+{
+    NSUInteger footprint = 0;
+    for (id<ATLMMemoryConsumer> consumer in self.recordsByConsumer.keyEnumerator.allObjects) {
+        ATLMMemoryRecord *record = [self.recordsByConsumer objectForKey:consumer];
+        if (!category || [record.category isEqualToString:category]) {
+            footprint += record.footprint;
+        }
+    }
+    return footprint;
+}
+
+- (NSUInteger)highWaterMarkForCategory:(NSString *)category
+{
+    return [self.highWaterMarksByCategory[category] unsignedIntegerValue];
+}
+
+- (void)resetHighWaterMarks
+{
+    [self.highWaterMarksByCategory removeAllObjects];
+    self.highWaterMark = 0;
+    [self updateHighWaterMarks];
+}
+
+- (void)updateHighWaterMarks
+{
+    NSMutableDictionary *footprintsByCategory = [NSMutableDictionary new];
+    NSUInteger footprint = 0;
+    for (id<ATLMMemoryConsumer> consumer in self.recordsByConsumer.keyEnumerator.allObjects) {
+        ATLMMemoryRecord *record = [self.recordsByConsumer objectForKey:consumer];
+        footprintsByCategory[record.category] = @([footprintsByCategory[record.category] unsignedIntegerValue] + record.footprint);
+        footprint += record.footprint;
+    }
+    [footprintsByCategory enumerateKeysAndObjectsUsingBlock:^(NSString *category, NSNumber *categoryFootprint, BOOL *stop) {
+        if (categoryFootprint.unsignedIntegerValue > [self highWaterMarkForCategory:category]) {
+            self.highWaterMarksByCategory[category] = categoryFootprint;
+        }
+    }];
+    self.highWaterMark = MAX(self.highWaterMark, footprint);
+    ATLMInstrumentationRecord(ATLMMetricMemoryFootprint, footprint / 1024.0);
+}
+
+- (NSDictionary *)report
+{
+    NSMutableSet *categories = [NSMutableSet setWithArray:self.budgetsByCategory.allKeys];
+    [categories addObjectsFromArray:self.highWaterMarksByCategory.allKeys];
+    NSMutableDictionary *categoryReports = [NSMutableDictionary new];
+    for (NSString *category in categories) {
+        categoryReports[category] = @{ @"footprint": @([self footprintForCategory:category]),
+                                       @"budget": @([self budgetForCategory:category]),
+                                       @"highWaterMark": @([self highWaterMarkForCategory:category]) };
+    }
+    return @{ @"footprint": @(self.footprint),
+              @"budget": @(self.totalBudget),
+              @"highWaterMark": @(self.highWaterMark),
+              @"evictions": @(self.countOfEvictions),
+              @"categories": categoryReports };
+}
+
+@end
@@ -0,0 +1,122 @@
+//
+//  ATLMMessageLayoutCache.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <UIKit/UIKit.h>
+#import "ATLMMemoryAccountant.h"
+
+@class LYRMessage;
+
+/**
+ @abstract Returns a hash over the message parts' MIME types and sizes, which
+   are the inputs affecting the height of a message cell.
+ */
+extern NSUInteger ATLMMessageContentHash(LYRMessage *_Nonnull message);
+
+/**
+ @abstract Returns the width class for a cell width; widths within the same
+   class share their cached heights.
+ */
+extern NSInteger ATLMMessageLayoutWidthClass(CGFloat width);
+
+/**
+ @abstract The `ATLMMessageLayoutCache` caches message cell heights of a single
+   conversation, keyed by message identifier, content hash and width class,
+   for the current preferred content size category.
+ @discussion The collection view flow layout asks for the size of every loaded
+   message whenever the layout is invalidated, so without a cache each rotation
+   recomputes the text layout of the whole loaded history. Heights are kept for
+   every width class seen, which makes rotating back and forth free, and are
+   persisted to the caches directory for the most recently viewed conversations.
+   Text sizes follow the preferred content size category, so a change of it
+   persists and drops all heights and strings; each category is persisted
+   separately.
+   Loading and persisting happen on a background queue; all other methods must
+   be called on the main thread. As an `ATLMMemoryConsumer` the cache estimates
+   its footprint from its number of entries and reports it to the shared
+   accountant in 64 KB steps; releasing memory persists and empties it.
+ */
+@interface ATLMMessageLayoutCache : NSObject <ATLMMemoryConsumer>
+
+/**
+ @abstract Creates a layout cache for a conversation.
+ @param identifier A string uniquely identifying the conversation.
+ @param directory The directory the cache is persisted in or `nil` to keep it in memory only.
+ @return A new `ATLMMessageLayoutCache` instance.
+ */
++ (nonnull instancetype)layoutCacheWithIdentifier:(nonnull NSString *)identifier directory:(nullable NSString *)directory;
+
+/**
+ @abstract The directory in the application's caches directory used by default.
+ */
++ (nonnull NSString *)defaultDirectory;
+
+/**
+ @abstract The identifier passed in on creation.
+ */
+@property (nonnull, nonatomic, readonly) NSString *identifier;
+
+/**
+ @abstract The maximum number of conversations whose caches are kept on disk. Defaults to 20.
+ */
+@property (nonatomic) NSUInteger maximumPersistedCacheCount;
+
+/**
+ @abstract Returns the cached height, computing and caching it on a miss.
+ @param messageIdentifier The identifier of the message.
+ @param contentHash The value returned by `ATLMMessageContentHash()` for the message.
+ @param width The width of the cell.
+ @param calculation A block computing the height on a cache miss.
+ */
+- (CGFloat)heightForMessageIdentifier:(nonnull NSString *)messageIdentifier contentHash:(NSUInteger)contentHash width:(CGFloat)width calculation:(nonnull CGFloat (^)(void))calculation;
+
+/**
+ @abstract Drops all cached heights of a message.
+ */
+- (void)invalidateMessageIdentifier:(nonnull NSString *)messageIdentifier;
+
+/**
+ @abstract Returns a cached attributed string, generating and caching it on a miss.
+ @discussion Used for the date and recipient status strings, whose keys must
+   capture every input affecting the string.
+ */
+- (nonnull NSAttributedString *)attributedStringForKey:(nonnull NSString *)key generator:(nonnull NSAttributedString *_Nonnull (^)(void))generator;
+
+/**
+ @abstract Loads the persisted heights on a background queue and merges them
+   into the receiver on the main thread before calling `completion`.
+ */
+- (void)loadWithCompletion:(nullable void (^)(void))completion;
+
+/**
+ @abstract Writes the cached heights to disk on a background queue.
+ */
+- (void)persist;
+
+/**
+ @abstract The number of lookups served from the cache.
+ */
+@property (nonatomic, readonly) NSUInteger countOfHits;
+
+/**
+ @abstract The number of lookups which had to compute the height.
+ */
+@property (nonatomic, readonly) NSUInteger countOfMisses;
+
+@end
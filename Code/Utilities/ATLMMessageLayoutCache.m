@@ -0,0 +1,339 @@
+//
+//  ATLMMessageLayoutCache.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMMessageLayoutCache.h"
+#import <LayerKit/LayerKit.h>
+
+static const NSUInteger ATLMMessageLayoutCacheDefaultMaximumPersistedCacheCount = 20;
+
+// Rough costs of an entry with a couple of width classes and of a short
+// attributed string, used to estimate the footprint without walking the cache.
+static const NSUInteger ATLMMessageLayoutCacheEntryCost = 192;
+static const NSUInteger ATLMMessageLayoutCacheAttributedStringCost = 256;
+static const NSUInteger ATLMMessageLayoutCacheFootprintReportingStep = 64 * 1024;
+
+NSUInteger ATLMMessageContentHash(LYRMessage *message)
+{
+    NSUInteger hash = message.parts.count;
+    for (LYRMessagePart *part in message.parts) {
+        hash = hash * 31 + part.MIMEType.hash;
+        hash = hash * 31 + (NSUInteger)part.size;
+    }
+    return hash;
+}
+
+NSInteger ATLMMessageLayoutWidthClass(CGFloat width)
+{
+    return (NSInteger)floor(width);
+}
+
+static NSString *const ATLMMessageLayoutContentHashKey = @"content_hash";
+static NSString *const ATLMMessageLayoutHeightsKey = @"heights";
+
+static dispatch_queue_t ATLMMessageLayoutCacheIOQueue()
+{
+    static dispatch_queue_t queue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        queue = dispatch_queue_create("com.layer.Atlas-Messenger.message-layout-cache", DISPATCH_QUEUE_SERIAL);
+    });
+    return queue;
+}
+
+@interface ATLMMessageLayoutEntry : NSObject
+
+@property (nonatomic) NSUInteger contentHash;
+@property (nonatomic) NSMutableDictionary *heightsByWidthClass;
+
+@end
+
+@implementation ATLMMessageLayoutEntry
+
+@end
+
+@interface ATLMMessageLayoutCache () <NSCacheDelegate>
+
+@property (nonnull, nonatomic, readwrite) NSString *identifier;
+@property (nullable, nonatomic) NSString *directory;
+@property (nonnull, nonatomic) NSString *contentSizeCategory;
+@property (nonatomic) NSMutableDictionary *entriesByMessageIdentifier;
+@property (nonatomic) NSCache *attributedStrings;
+@property (nonatomic) NSUInteger attributedStringCount;
+@property (nonatomic) NSUInteger reportedFootprint;
+@property (nonatomic, getter=isDirty) BOOL dirty;
+@property (nonatomic, readwrite) NSUInteger countOfHits;
+@property (nonatomic, readwrite) NSUInteger countOfMisses;
+
+@end
+
+@implementation ATLMMessageLayoutCache
+
++ (instancetype)layoutCacheWithIdentifier:(NSString *)identifier directory:(NSString *)directory
+{
+    return [[self alloc] initWithIdentifier:identifier directory:directory];
+}
+
++ (NSString *)defaultDirectory
+{
+    NSString *cachesDirectory = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES).firstObject;
+    return [cachesDirectory stringByAppendingPathComponent:@"MessageLayouts"];
+}
+
+- (id)initWithIdentifier:(NSString *)identifier directory:(NSString *)directory
+{
+    NSParameterAssert(identifier);
+    self = [super init];
+    if (self) {
+        _identifier = [identifier copy];
+        _directory = [directory copy];
+        _maximumPersistedCacheCount = ATLMMessageLayoutCacheDefaultMaximumPersistedCacheCount;
+        _entriesByMessageIdentifier = [NSMutableDictionary new];
+        _attributedStrings = [NSCache new];
+        _attributedStrings.countLimit = 500;
+        _attributedStrings.delegate = self;
+        _contentSizeCategory = [UIApplication sharedApplication].preferredContentSizeCategory;
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(contentSizeCategoryDidChange:) name:UIContentSizeCategoryDidChangeNotification object:nil];
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use layoutCacheWithIdentifier:directory:" userInfo:nil];
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+#pragma mark - Heights
+
+- (CGFloat)heightForMessageIdentifier:(NSString *)messageIdentifier contentHash:(NSUInteger)contentHash width:(CGFloat)width calculation:(CGFloat (^)(void))calculation
+{
+    NSNumber *widthClass = @(ATLMMessageLayoutWidthClass(width));
+    ATLMMessageLayoutEntry *entry = self.entriesByMessageIdentifier[messageIdentifier];
+    if (entry.contentHash != contentHash) {
+        // New message or changed content; the heights for every width are stale.
+        entry = nil;
+    }
+    NSNumber *height = entry.heightsByWidthClass[widthClass];
+    if (height) {
+        self.countOfHits += 1;
+        return height.doubleValue;
+    }
+    self.countOfMisses += 1;
+    CGFloat calculatedHeight = calculation();
+    if (!entry) {
+        entry = [ATLMMessageLayoutEntry new];
+        entry.contentHash = contentHash;
+        entry.heightsByWidthClass = [NSMutableDictionary new];
+        self.entriesByMessageIdentifier[messageIdentifier] = entry;
+        [self footprintDidChange];
+    }
+    entry.heightsByWidthClass[widthClass] = @(calculatedHeight);
+    self.dirty = YES;
+    return calculatedHeight;
+}
+
+- (void)invalidateMessageIdentifier:(NSString *)messageIdentifier
+{
+    if (self.entriesByMessageIdentifier[messageIdentifier]) {
+        [self.entriesByMessageIdentifier removeObjectForKey:messageIdentifier];
+        self.dirty = YES;
+    }
+}
+
+- (void)contentSizeCategoryDidChange:(NSNotification *)notification
+{
+    NSString *contentSizeCategory = [UIApplication sharedApplication].preferredContentSizeCategory;
+    if ([contentSizeCategory isEqualToString:self.contentSizeCategory]) {
+        return;
+    }
+    // Kept for the previous category, which the user may well switch back to.
+    [self persist];
+    self.contentSizeCategory = contentSizeCategory;
+    [self.entriesByMessageIdentifier removeAllObjects];
+    [self.attributedStrings removeAllObjects];
+    self.attributedStringCount = 0;
+    [self footprintDidChange];
+}
+
+#pragma mark - Attributed Strings
+
+- (NSAttributedString *)attributedStringForKey:(NSString *)key generator:(NSAttributedString *(^)(void))generator
+{
+    NSAttributedString *attributedString = [self.attributedStrings objectForKey:key];
+    if (!attributedString) {
+        attributedString = generator();
+        [self.attributedStrings setObject:attributedString forKey:key];
+        self.attributedStringCount += 1;
+        [self footprintDidChange];
+    }
+    return attributedString;
+}
+
+- (void)cache:(NSCache *)cache willEvictObject:(id)object
+{
+    if (self.attributedStringCount) {
+        self.attributedStringCount -= 1;
+    }
+}
+
+#pragma mark - ATLMMemoryConsumer
+
+- (NSUInteger)memoryFootprint
+{
+    return self.entriesByMessageIdentifier.count * ATLMMessageLayoutCacheEntryCost + self.attributedStringCount * ATLMMessageLayoutCacheAttributedStringCost;
+}
+
+- (NSString *)memoryCategory
+{
+    return ATLMMemoryCategoryCaches;
+}
+
+- (ATLMMemoryPriority)memoryPriority
+{
+    return ATLMMemoryPriorityDiscardable;
+}
+
+- (NSUInteger)releaseMemory
+{
+    NSUInteger footprint = self.memoryFootprint;
+    [self persist];
+    [self.entriesByMessageIdentifier removeAllObjects];
+    [self.attributedStrings removeAllObjects];
+    self.attributedStringCount = 0;
+    self.reportedFootprint = 0;
+    return footprint;
+}
+
+- (void)footprintDidChange
+{
+    NSUInteger footprint = self.memoryFootprint;
+    NSUInteger delta = footprint > self.reportedFootprint ? footprint - self.reportedFootprint : self.reportedFootprint - footprint;
+    if (delta < ATLMMessageLayoutCacheFootprintReportingStep) {
+        return;
+    }
+    self.reportedFootprint = footprint;
+    [[ATLMMemoryAccountant sharedAccountant] consumerDidChangeFootprint:self];
+}
+
+#pragma mark - Persistence
+
+- (NSString *)persistencePath
+{
+    if (!self.directory) {
+        return nil;
+    }
+    // Conversation identifiers are URLs; keep only the characters safe for a file name.
+    NSCharacterSet *unsafeCharacters = [[NSCharacterSet alphanumericCharacterSet] invertedSet];
+    NSString *name = [NSString stringWithFormat:@"%@-%@", self.identifier, self.contentSizeCategory];
+    NSString *fileName = [[name componentsSeparatedByCharactersInSet:unsafeCharacters] componentsJoinedByString:@"_"];
+    return [[self.directory stringByAppendingPathComponent:fileName] stringByAppendingPathExtension:@"plist"];
+}
+
+- (void)loadWithCompletion:(void (^)(void))completion
+{
+    NSString *path = [self persistencePath];
+    if (!path) {
+        if (completion) completion();
+        return;
+    }
+    NSString *contentSizeCategory = self.contentSizeCategory;
+    __weak typeof(self) weakSelf = self;
+    dispatch_async(ATLMMessageLayoutCacheIOQueue(), ^{
+        NSDictionary *persistedHeights = [NSDictionary dictionaryWithContentsOfFile:path];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            // Heights of a category changed from in the meantime no longer apply.
+            if ([weakSelf.contentSizeCategory isEqualToString:contentSizeCategory]) {
+                [weakSelf mergePersistedHeights:persistedHeights];
+            }
+            if (completion) completion();
+        });
+    });
+}
+
+- (void)mergePersistedHeights:(NSDictionary *)persistedHeights
+{
+    [persistedHeights enumerateKeysAndObjectsUsingBlock:^(NSString *messageIdentifier, NSDictionary *persistedEntry, BOOL *stop) {
+        if (self.entriesByMessageIdentifier[messageIdentifier]) {
+            // Heights computed in the meantime win.
+            return;
+        }
+        ATLMMessageLayoutEntry *entry = [ATLMMessageLayoutEntry new];
+        entry.contentHash = (NSUInteger)[persistedEntry[ATLMMessageLayoutContentHashKey] longLongValue];
+        entry.heightsByWidthClass = [NSMutableDictionary new];
+        [persistedEntry[ATLMMessageLayoutHeightsKey] enumerateKeysAndObjectsUsingBlock:^(NSString *widthClass, NSNumber *height, BOOL *stop) {
+            entry.heightsByWidthClass[@(widthClass.integerValue)] = height;
+        }];
+        self.entriesByMessageIdentifier[messageIdentifier] = entry;
+    }];
+    [self footprintDidChange];
+}
+
+- (void)persist
+{
+    NSString *path = [self persistencePath];
+    if (!path || !self.isDirty) {
+        return;
+    }
+    self.dirty = NO;
+    // Property lists only take string keys.
+    NSMutableDictionary *snapshot = [NSMutableDictionary dictionaryWithCapacity:self.entriesByMessageIdentifier.count];
+    [self.entriesByMessageIdentifier enumerateKeysAndObjectsUsingBlock:^(NSString *messageIdentifier, ATLMMessageLayoutEntry *entry, BOOL *stop) {
+        NSMutableDictionary *heights = [NSMutableDictionary dictionaryWithCapacity:entry.heightsByWidthClass.count];
+        [entry.heightsByWidthClass enumerateKeysAndObjectsUsingBlock:^(NSNumber *widthClass, NSNumber *height, BOOL *stop) {
+            heights[widthClass.stringValue] = height;
+        }];
+        snapshot[messageIdentifier] = @{ ATLMMessageLayoutContentHashKey: @((long long)entry.contentHash), ATLMMessageLayoutHeightsKey: heights };
+    }];
+    NSString *directory = self.directory;
+    NSUInteger maximumPersistedCacheCount = self.maximumPersistedCacheCount;
+    dispatch_async(ATLMMessageLayoutCacheIOQueue(), ^{
+        NSFileManager *fileManager = [NSFileManager defaultManager];
+        [fileManager createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil];
+        if (![snapshot writeToFile:path atomically:YES]) {
+            NSLog(@"Failed to persist message layout cache to %@", path);
+            return;
+        }
+        [[self class] pruneDirectory:directory keepingMostRecent:maximumPersistedCacheCount];
+    });
+}
+
++ (void)pruneDirectory:(NSString *)directory keepingMostRecent:(NSUInteger)count
+{
+    NSURL *directoryURL = [NSURL fileURLWithPath:directory isDirectory:YES];
+    NSArray *fileURLs = [[NSFileManager defaultManager] contentsOfDirectoryAtURL:directoryURL includingPropertiesForKeys:@[ NSURLContentModificationDateKey ] options:NSDirectoryEnumerationSkipsHiddenFiles error:nil];
+    if (fileURLs.count <= count) {
+        return;
+    }
+    NSArray *sortedFileURLs = [fileURLs sortedArrayUsingComparator:^NSComparisonResult(NSURL *URL, NSURL *otherURL) {
+        NSDate *date, *otherDate;
+        [URL getResourceValue:&date forKey:NSURLContentModificationDateKey error:nil];
+        [otherURL getResourceValue:&otherDate forKey:NSURLContentModificationDateKey error:nil];
+        return [otherDate compare:date];
+    }];
+    for (NSURL *fileURL in [sortedFileURLs subarrayWithRange:NSMakeRange(count, sortedFileURLs.count - count)]) {
+        [[NSFileManager defaultManager] removeItemAtURL:fileURL error:nil];
+    }
+}
+
+@end
@@ -0,0 +1,123 @@
+//
+//  ATLMMessagePartDecoder.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <UIKit/UIKit.h>
+
+@class LYRMessagePart;
+
+/**
+ @abstract The payload of an `ATLMIMETypeLocation` message part.
+ */
+typedef struct {
+    double latitude;
+    double longitude;
+} ATLMLocationPayload;
+
+/**
+ @abstract The payload of an `ATLMIMETypeImageSize` message part.
+ */
+typedef struct {
+    CGSize size;
+    NSInteger orientation;
+} ATLMImageSizePayload;
+
+/**
+ @abstract Decodes the data of a message part into a value.
+ @return The decoded value or `nil` if the data is malformed.
+ */
+typedef id _Nullable (^ATLMMessagePartDecoderBlock)(NSData *_Nonnull data);
+
+/**
+ @abstract Parses a flat JSON object whose values of interest are numbers.
+ @discussion Handles the fixed shape payloads Atlas sends without going through
+   `NSJSONSerialization`. Keys not in `keys` are skipped; keys missing from the
+   object leave their value untouched.
+ @param data The JSON data.
+ @param keys The keys to extract.
+ @param values On return, the values of the keys found, in the order of `keys`.
+ @param keyCount The number of keys.
+ @return `NO` if the data is not a flat object the parser understands.
+ */
+extern BOOL ATLMParseFlatJSONNumbers(NSData *_Nonnull data, const char *_Nonnull const *_Nonnull keys, double *_Nonnull values, size_t keyCount);
+
+/**
+ @abstract The `ATLMMessagePartDecoder` decodes small structured message parts
+   once and serves the decoded values from memory afterwards.
+ @discussion Decoders are registered per MIME type; values are memoized by
+   message part identifier and MIME type. Location and image size parts are
+   decoded by a hand-written parser, falling back to `NSJSONSerialization` for
+   payloads it doesn't understand. All methods are thread safe.
+ */
+@interface ATLMMessagePartDecoder : NSObject
+
+/**
+ @abstract The decoder shared by the application, with the location and image size decoders registered.
+ */
++ (nonnull instancetype)sharedDecoder;
+
+/**
+ @abstract Creates a decoder with the location and image size decoders registered.
+ */
++ (nonnull instancetype)decoder;
+
+/**
+ @abstract Registers the block decoding parts of the supplied MIME type, replacing any previous one.
+ */
+- (void)registerDecoderForMIMEType:(nonnull NSString *)MIMEType block:(nonnull ATLMMessagePartDecoderBlock)block;
+
+/**
+ @abstract Returns the decoded value of a message part.
+ @return The value or `nil` if no decoder is registered for the part's MIME
+   type, its data is not available or malformed.
+ */
+- (nullable id)decodedValueForMessagePart:(nonnull LYRMessagePart *)messagePart;
+
+/**
+ @abstract Decodes an `ATLMIMETypeLocation` part.
+ @return `YES` if `location` has been set.
+ */
+- (BOOL)getLocation:(nonnull ATLMLocationPayload *)location forMessagePart:(nonnull LYRMessagePart *)messagePart;
+
+/**
+ @abstract Decodes an `ATLMIMETypeImageSize` part.
+ @return `YES` if `imageSize` has been set.
+ */
+- (BOOL)getImageSize:(nonnull ATLMImageSizePayload *)imageSize forMessagePart:(nonnull LYRMessagePart *)messagePart;
+
+/**
+ @abstract Evicts all memoized values.
+ */
+- (void)removeAllValues;
+
+///-----------------
+/// @name Metrics
+///-----------------
+
+/**
+ @abstract The number of parts decoded.
+ */
+@property (nonatomic, readonly) NSUInteger countOfDecodes;
+
+/**
+ @abstract The number of values served from memory.
+ */
+@property (nonatomic, readonly) NSUInteger countOfHits;
+
+@end
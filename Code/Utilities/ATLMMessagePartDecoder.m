@@ -0,0 +1,284 @@
+//
+//  ATLMMessagePartDecoder.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMMessagePartDecoder.h"
+#import <LayerKit/LayerKit.h>
+#import <xlocale.h>
+#import "ATLMessagingUtilities.h"
+
+static const NSUInteger ATLMMessagePartDecoderCountLimit = 2000;
+static const size_t ATLMMaximumNumberLength = 63;
+
+static const char *ATLMSkipWhitespace(const char *bytes, const char *end)
+{
+    while (bytes < end && (*bytes == ' ' || *bytes == '\t' || *bytes == '\n' || *bytes == '\r')) {
+        bytes++;
+    }
+    return bytes;
+}
+
+BOOL ATLMParseFlatJSONNumbers(NSData *data, const char *const *keys, double *values, size_t keyCount)
+{
+    const char *bytes = data.bytes;
+    const char *end = bytes + data.length;
+    bytes = ATLMSkipWhitespace(bytes, end);
+    if (bytes == end || *bytes++ != '{') {
+        return NO;
+    }
+    bytes = ATLMSkipWhitespace(bytes, end);
+    if (bytes < end && *bytes == '}') {
+        return ATLMSkipWhitespace(bytes + 1, end) == end;
+    }
+    while (bytes < end) {
+        // Key; escaped keys are left to NSJSONSerialization.
+        if (*bytes++ != '"') {
+            return NO;
+        }
+        const char *key = bytes;
+        while (bytes < end && *bytes != '"') {
+            if (*bytes == '\\') {
+                return NO;
+            }
+            bytes++;
+        }
+        if (bytes == end) {
+            return NO;
+        }
+        size_t keyLength = bytes - key;
+        NSInteger keyIndex = -1;
+        for (size_t index = 0; index < keyCount; index++) {
+            if (strlen(keys[index]) == keyLength && memcmp(keys[index], key, keyLength) == 0) {
+                keyIndex = index;
+                break;
+            }
+        }
+        bytes = ATLMSkipWhitespace(bytes + 1, end);
+        if (bytes == end || *bytes++ != ':') {
+            return NO;
+        }
+        bytes = ATLMSkipWhitespace(bytes, end);
+        if (bytes == end) {
+            return NO;
+        }
+
+        // Value; only numbers are extracted, other scalars are skipped.
+        if (*bytes == '-' || (*bytes >= '0' && *bytes <= '9')) {
+            const char *number = bytes;
+            while (bytes < end && ((*bytes >= '0' && *bytes <= '9') || *bytes == '-' || *bytes == '+' || *bytes == '.' || *bytes == 'e' || *bytes == 'E')) {
+                bytes++;
+            }
+            size_t numberLength = bytes - number;
+            if (numberLength > ATLMMaximumNumberLength) {
+                return NO;
+            }
+            char buffer[ATLMMaximumNumberLength + 1];
+            memcpy(buffer, number, numberLength);
+            buffer[numberLength] = '\0';
+            char *numberEnd;
+            double value = strtod_l(buffer, &numberEnd, NULL);
+            if (numberEnd != buffer + numberLength) {
+                return NO;
+            }
+            if (keyIndex >= 0) {
+                values[keyIndex] = value;
+            }
+        } else if (keyIndex >= 0) {
+            return NO;
+        } else if (*bytes == '"') {
+            bytes++;
+            while (bytes < end && *bytes != '"') {
+                bytes += (*bytes == '\\') ? 2 : 1;
+            }
+            if (bytes >= end) {
+                return NO;
+            }
+            bytes++;
+        } else if (end - bytes >= 4 && (memcmp(bytes, "true", 4) == 0 || memcmp(bytes, "null", 4) == 0)) {
+            bytes += 4;
+        } else if (end - bytes >= 5 && memcmp(bytes, "false", 5) == 0) {
+            bytes += 5;
+        } else {
+            return NO;
+        }
+
+        bytes = ATLMSkipWhitespace(bytes, end);
+        if (bytes == end) {
+            return NO;
+        }
+        if (*bytes == '}') {
+            return ATLMSkipWhitespace(bytes + 1, end) == end;
+        }
+        if (*bytes++ != ',') {
+            return NO;
+        }
+        bytes = ATLMSkipWhitespace(bytes, end);
+    }
+    return NO;
+}
+
+/**
+ @abstract Extracts numbers from a flat JSON object, falling back to `NSJSONSerialization`.
+ */
+static BOOL ATLMDecodeJSONNumbers(NSData *data, const char *const *keys, double *values, size_t keyCount)
+{
+    if (ATLMParseFlatJSONNumbers(data, keys, values, keyCount)) {
+        return YES;
+    }
+    NSDictionary *dictionary = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+    if (![dictionary isKindOfClass:[NSDictionary class]]) {
+        return NO;
+    }
+    for (size_t index = 0; index < keyCount; index++) {
+        id value = dictionary[@(keys[index])];
+        if ([value respondsToSelector:@selector(doubleValue)]) {
+            values[index] = [value doubleValue];
+        }
+    }
+    return YES;
+}
+
+@interface ATLMMessagePartDecoder ()
+
+@property (nonnull, nonatomic) NSMutableDictionary<NSString *, ATLMMessagePartDecoderBlock> *decodersByMIMEType;
+@property (nonnull, nonatomic) NSCache *valueCache;
+@property (nonatomic, readwrite) NSUInteger countOfDecodes;
+@property (nonatomic, readwrite) NSUInteger countOfHits;
+
+@end
+
+@implementation ATLMMessagePartDecoder
+
++ (instancetype)sharedDecoder
+{
+    static ATLMMessagePartDecoder *sharedDecoder;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedDecoder = [self decoder];
+    });
+    return sharedDecoder;
+}
+
++ (instancetype)decoder
+{
+    return [[self alloc] init];
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self) {
+        _decodersByMIMEType = [NSMutableDictionary new];
+        _valueCache = [NSCache new];
+        _valueCache.countLimit = ATLMMessagePartDecoderCountLimit;
+
+        [self registerDecoderForMIMEType:ATLMIMETypeLocation block:^id(NSData *data) {
+            const char *const keys[] = { ATLLocationLatitudeKey.UTF8String, ATLLocationLongitudeKey.UTF8String };
+            double values[] = { 0, 0 };
+            if (!ATLMDecodeJSONNumbers(data, keys, values, 2)) {
+                return nil;
+            }
+            ATLMLocationPayload location = { values[0], values[1] };
+            return [NSValue valueWithBytes:&location objCType:@encode(ATLMLocationPayload)];
+        }];
+        [self registerDecoderForMIMEType:ATLMIMETypeImageSize block:^id(NSData *data) {
+            static const char *const keys[] = { "width", "height", "orientation" };
+            double values[] = { 0, 0, 0 };
+            if (!ATLMDecodeJSONNumbers(data, keys, values, 3)) {
+                return nil;
+            }
+            ATLMImageSizePayload imageSize = { CGSizeMake(values[0], values[1]), (NSInteger)values[2] };
+            return [NSValue valueWithBytes:&imageSize objCType:@encode(ATLMImageSizePayload)];
+        }];
+    }
+    return self;
+}
+
+- (void)registerDecoderForMIMEType:(NSString *)MIMEType block:(ATLMMessagePartDecoderBlock)block
+{
+    @synchronized(self) {
+        self.decodersByMIMEType[MIMEType] = [block copy];
+    }
+    [self.valueCache removeAllObjects];
+}
+
+- (id)decodedValueForMessagePart:(LYRMessagePart *)messagePart
+{
+    NSString *MIMEType = messagePart.MIMEType;
+    NSString *key = messagePart.identifier ? [NSString stringWithFormat:@"%@|%@", messagePart.identifier.absoluteString, MIMEType] : nil;
+    id value = key ? [self.valueCache objectForKey:key] : nil;
+    if (value) {
+        @synchronized(self) {
+            self.countOfHits += 1;
+        }
+        return value == [NSNull null] ? nil : value;
+    }
+
+    ATLMMessagePartDecoderBlock decoder;
+    @synchronized(self) {
+        decoder = self.decodersByMIMEType[MIMEType];
+    }
+    NSData *data = messagePart.data;
+    if (!decoder || !data) {
+        // Content that hasn't been downloaded yet will be decoded once it is.
+        return nil;
+    }
+    value = decoder(data);
+    @synchronized(self) {
+        self.countOfDecodes += 1;
+    }
+    if (key) {
+        // Malformed parts are remembered too, so they're not parsed again.
+        [self.valueCache setObject:value ?: [NSNull null] forKey:key];
+    }
+    return value;
+}
+
+- (BOOL)getLocation:(ATLMLocationPayload *)location forMessagePart:(LYRMessagePart *)messagePart
+{
+    if (![messagePart.MIMEType isEqualToString:ATLMIMETypeLocation]) {
+        return NO;
+    }
+    NSValue *value = [self decodedValueForMessagePart:messagePart];
+    if (![value isKindOfClass:[NSValue class]] || strcmp(value.objCType, @encode(ATLMLocationPayload)) != 0) {
+        return NO;
+    }
+    [value getValue:location];
+    return YES;
+}
+
+- (BOOL)getImageSize:(ATLMImageSizePayload *)imageSize forMessagePart:(LYRMessagePart *)messagePart
+{
+    if (![messagePart.MIMEType isEqualToString:ATLMIMETypeImageSize]) {
+        return NO;
+    }
+    NSValue *value = [self decodedValueForMessagePart:messagePart];
+    if (![value isKindOfClass:[NSValue class]] || strcmp(value.objCType, @encode(ATLMImageSizePayload)) != 0) {
+        return NO;
+    }
+    [value getValue:imageSize];
+    return YES;
+}
+
+- (void)removeAllValues
+{
+    [self.valueCache removeAllObjects];
+}
+
+@end
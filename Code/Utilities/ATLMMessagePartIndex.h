@@ -0,0 +1,66 @@
+//
+//  ATLMMessagePartIndex.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+@class LYRMessage;
+@class LYRMessagePart;
+
+/**
+ @abstract The `ATLMMessagePartIndex` maps the MIME types of a message's parts
+   to the parts, built in a single pass over `message.parts`.
+ @discussion The MIME types Atlas knows about are interned to slots of a fixed
+   table, so looking them up doesn't compare strings. Indexes are cached per
+   message identifier; message parts don't change once a message is created.
+ */
+@interface ATLMMessagePartIndex : NSObject
+
+/**
+ @abstract Returns the index of a message, building it on first use.
+ */
++ (nonnull instancetype)indexForMessage:(nonnull LYRMessage *)message;
+
+/**
+ @abstract Evicts all cached indexes.
+ */
++ (void)removeAllIndexes;
+
+/**
+ @abstract The number of parts the index was built from.
+ */
+@property (nonatomic, readonly) NSUInteger partCount;
+
+/**
+ @abstract Returns the first part of the supplied MIME type or `nil`.
+ */
+- (nullable LYRMessagePart *)partForMIMEType:(nonnull NSString *)MIMEType;
+
+/**
+ @abstract Returns `YES` if the message has a part of the supplied MIME type.
+ */
+- (BOOL)containsMIMEType:(nonnull NSString *)MIMEType;
+
+/**
+ @abstract The full resolution media part to present, in order of preference:
+   GIF, PNG, MP4 video and JPEG. `nil` if the message has no media.
+ */
+@property (nullable, nonatomic, readonly) LYRMessagePart *renderableMediaPart;
+
+@end
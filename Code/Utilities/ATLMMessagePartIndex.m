@@ -0,0 +1,178 @@
+//
+//  ATLMMessagePartIndex.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMMessagePartIndex.h"
+#import <LayerKit/LayerKit.h>
+#import "ATLMessagingUtilities.h"
+
+static const NSUInteger ATLMMessagePartIndexCountLimit = 200;
+
+typedef NS_ENUM(NSInteger, ATLMPartSlot) {
+    ATLMPartSlotNone = -1,
+    ATLMPartSlotTextPlain,
+    ATLMPartSlotImageJPEG,
+    ATLMPartSlotImageJPEGPreview,
+    ATLMPartSlotImagePNG,
+    ATLMPartSlotImageGIF,
+    ATLMPartSlotImageGIFPreview,
+    ATLMPartSlotImageSize,
+    ATLMPartSlotVideoMP4,
+    ATLMPartSlotLocation,
+    ATLMPartSlotCount
+};
+
+static NSString *ATLMMIMETypeForSlot(ATLMPartSlot slot)
+{
+    switch (slot) {
+        case ATLMPartSlotTextPlain: return ATLMIMETypeTextPlain;
+        case ATLMPartSlotImageJPEG: return ATLMIMETypeImageJPEG;
+        case ATLMPartSlotImageJPEGPreview: return ATLMIMETypeImageJPEGPreview;
+        case ATLMPartSlotImagePNG: return ATLMIMETypeImagePNG;
+        case ATLMPartSlotImageGIF: return ATLMIMETypeImageGIF;
+        case ATLMPartSlotImageGIFPreview: return ATLMIMETypeImageGIFPreview;
+        case ATLMPartSlotImageSize: return ATLMIMETypeImageSize;
+        case ATLMPartSlotVideoMP4: return ATLMIMETypeVideoMP4;
+        case ATLMPartSlotLocation: return ATLMIMETypeLocation;
+        default: return nil;
+    }
+}
+
+/**
+ @abstract Interns a MIME type to its slot in the fixed table.
+ @discussion Atlas' own constants are matched by pointer; strings coming from
+   the client take a single hash lookup.
+ */
+static ATLMPartSlot ATLMSlotForMIMEType(NSString *MIMEType)
+{
+    static NSString *constants[ATLMPartSlotCount];
+    static NSDictionary *slotsByMIMEType;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSMutableDictionary *slots = [NSMutableDictionary new];
+        for (ATLMPartSlot slot = 0; slot < ATLMPartSlotCount; slot++) {
+            constants[slot] = ATLMMIMETypeForSlot(slot);
+            slots[constants[slot]] = @(slot);
+        }
+        slotsByMIMEType = slots;
+    });
+    for (ATLMPartSlot slot = 0; slot < ATLMPartSlotCount; slot++) {
+        if (constants[slot] == MIMEType) {
+            return slot;
+        }
+    }
+    NSNumber *slot = MIMEType ? slotsByMIMEType[MIMEType] : nil;
+    return slot ? slot.integerValue : ATLMPartSlotNone;
+}
+
+@interface ATLMMessagePartIndex () {
+    __strong LYRMessagePart *_partsBySlot[ATLMPartSlotCount];
+}
+
+@property (nullable, nonatomic) NSDictionary<NSString *, LYRMessagePart *> *otherPartsByMIMEType;
+@property (nonatomic, readwrite) NSUInteger partCount;
+
+@end
+
+@implementation ATLMMessagePartIndex
+
++ (NSCache *)indexCache
+{
+    static NSCache *indexCache;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        indexCache = [NSCache new];
+        indexCache.countLimit = ATLMMessagePartIndexCountLimit;
+    });
+    return indexCache;
+}
+
++ (instancetype)indexForMessage:(LYRMessage *)message
+{
+    NSURL *identifier = message.identifier;
+    ATLMMessagePartIndex *index = identifier ? [[self indexCache] objectForKey:identifier] : nil;
+    if (!index) {
+        index = [[self alloc] initWithParts:message.parts];
+        if (identifier) {
+            [[self indexCache] setObject:index forKey:identifier];
+        }
+    }
+    return index;
+}
+
++ (void)removeAllIndexes
+{
+    [[self indexCache] removeAllObjects];
+}
+
+- (instancetype)initWithParts:(NSArray *)parts
+{
+    self = [super init];
+    if (self) {
+        NSMutableDictionary *otherPartsByMIMEType;
+        for (LYRMessagePart *part in parts) {
+            ATLMPartSlot slot = ATLMSlotForMIMEType(part.MIMEType);
+            if (slot != ATLMPartSlotNone) {
+                if (!_partsBySlot[slot]) {
+                    _partsBySlot[slot] = part;
+                }
+            } else if (part.MIMEType && !otherPartsByMIMEType[part.MIMEType]) {
+                if (!otherPartsByMIMEType) {
+                    otherPartsByMIMEType = [NSMutableDictionary new];
+                }
+                otherPartsByMIMEType[part.MIMEType] = part;
+            }
+        }
+        _otherPartsByMIMEType = otherPartsByMIMEType;
+        _partCount = parts.count;
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use indexForMessage:" userInfo:nil];
+}
+
+- (LYRMessagePart *)partForMIMEType:(NSString *)MIMEType
+{
+    ATLMPartSlot slot = ATLMSlotForMIMEType(MIMEType);
+    if (slot != ATLMPartSlotNone) {
+        return _partsBySlot[slot];
+    }
+    return self.otherPartsByMIMEType[MIMEType];
+}
+
+- (BOOL)containsMIMEType:(NSString *)MIMEType
+{
+    return [self partForMIMEType:MIMEType] != nil;
+}
+
+- (LYRMessagePart *)renderableMediaPart
+{
+    static const ATLMPartSlot priority[] = { ATLMPartSlotImageGIF, ATLMPartSlotImagePNG, ATLMPartSlotVideoMP4, ATLMPartSlotImageJPEG };
+    for (size_t index = 0; index < sizeof(priority) / sizeof(priority[0]); index++) {
+        if (_partsBySlot[priority[index]]) {
+            return _partsBySlot[priority[index]];
+        }
+    }
+    return nil;
+}
+
+@end
@@ -0,0 +1,179 @@
+//
+//  ATLMMessageSearchIndex.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+@class LYRMessage;
+@class LYRObjectChange;
+
+/**
+ @abstract Splits text into search tokens.
+ @discussion The text is normalized with compatibility composition (NFKC) and
+   folded to be case, diacritic and width insensitive, then split at word
+   boundaries, which also segments languages written without spaces.
+ */
+extern NSArray<NSString *> *_Nonnull ATLMSearchTokensForText(NSString *_Nonnull text);
+
+/**
+ @abstract A message matching a query.
+ */
+@interface ATLMMessageSearchHit : NSObject
+
+@property (nonnull, nonatomic, readonly) NSURL *messageIdentifier;
+@property (nonnull, nonatomic, readonly) NSURL *conversationIdentifier;
+@property (nonnull, nonatomic, readonly) NSDate *date;
+@property (nonatomic, readonly) double score;
+
+@end
+
+/**
+ @abstract A conversation with messages matching a query.
+ */
+@interface ATLMConversationSearchHit : NSObject
+
+@property (nonnull, nonatomic, readonly) NSURL *conversationIdentifier;
+@property (nonatomic, readonly) double score;
+
+/**
+ @abstract The matching messages of the conversation, best first.
+ */
+@property (nonnull, nonatomic, readonly) NSArray<ATLMMessageSearchHit *> *messageHits;
+
+@end
+
+/**
+ @abstract The `ATLMMessageSearchIndex` is a local inverted index over the
+   `text/plain` parts of messages.
+ @discussion New messages go into an in-memory buffer, which is written out
+   as an immutable, memory-mapped segment (see `ATLMSearchSegmentBuilder`)
+   once it holds `flushThreshold` messages, when the application enters the
+   background or on `flush`. Segments of similar size are merged on a
+   background queue once `mergeFactor` of them pile up, which also drops
+   deleted messages. Deletions are recorded as tombstones, stamped with a
+   generation so they only hide copies indexed before them.
+
+   Queries match messages containing every token of the query, the last
+   one as a prefix so results appear while typing, and are ranked with
+   BM25, most recent first among equal scores. Messages in the buffer when
+   the application is terminated are not persisted. All methods must be
+   called on the main thread.
+ */
+@interface ATLMMessageSearchIndex : NSObject
+
+/**
+ @abstract Creates an index persisted in a directory, loading the segments found there.
+ */
++ (nonnull instancetype)indexWithDirectory:(nonnull NSString *)directory;
+
+/**
+ @abstract The directory in the application's caches directory used by default.
+ */
++ (nonnull NSString *)defaultDirectory;
+
+@property (nonnull, nonatomic, readonly) NSString *directory;
+
+/**
+ @abstract The number of buffered messages triggering a flush. Defaults to 10000.
+ */
+@property (nonatomic) NSUInteger flushThreshold;
+
+/**
+ @abstract The number of segments of similar size triggering a merge. Defaults to 8.
+ */
+@property (nonatomic) NSUInteger mergeFactor;
+
+///----------------
+/// @name Indexing
+///----------------
+
+/**
+ @abstract Indexes a new message.
+ @discussion To re-index a message after it has been flushed, remove it first.
+ */
+- (void)indexMessageWithIdentifier:(nonnull NSURL *)messageIdentifier conversationIdentifier:(nonnull NSURL *)conversationIdentifier text:(nonnull NSString *)text date:(nonnull NSDate *)date;
+
+/**
+ @abstract Indexes the `text/plain` parts of a message; messages without text are ignored.
+ */
+- (void)indexMessage:(nonnull LYRMessage *)message;
+
+- (void)removeMessageWithIdentifier:(nonnull NSURL *)messageIdentifier;
+- (void)removeMessagesInConversationWithIdentifier:(nonnull NSURL *)conversationIdentifier;
+
+/**
+ @abstract Removes every indexed message, along with the segments on disk.
+ @discussion Called when the user logs out, so the next user can't search their messages.
+ */
+- (void)removeAll;
+
+/**
+ @abstract Applies a batch of changes from `layerClient:objectsDidChange:`.
+ */
+- (void)applyChanges:(nonnull NSArray<LYRObjectChange *> *)changes;
+
+/**
+ @abstract Writes the buffered messages to a new segment on a background queue.
+ */
+- (void)flush;
+
+/**
+ @abstract Merges all segments into one on a background queue.
+ @param completion Called on the main thread once the merge has been installed.
+ */
+- (void)mergeAllSegmentsWithCompletion:(nullable void (^)(void))completion;
+
+/**
+ @abstract Calls `completion` on the main thread once pending flushes and merges are installed.
+ */
+- (void)waitForBackgroundWorkWithCompletion:(nonnull void (^)(void))completion;
+
+///----------------
+/// @name Searching
+///----------------
+
+/**
+ @abstract Returns the best matching messages.
+ */
+- (nonnull NSArray<ATLMMessageSearchHit *> *)messageHitsForQuery:(nonnull NSString *)query limit:(NSUInteger)limit;
+
+/**
+ @abstract Returns the conversations with the best matching messages.
+ @discussion Conversations are ranked by their best message, with a bonus for
+   further matching messages, among the best `limit * 20` message hits.
+ */
+- (nonnull NSArray<ATLMConversationSearchHit *> *)conversationHitsForQuery:(nonnull NSString *)query limit:(NSUInteger)limit;
+
+///---------------
+/// @name Metrics
+///---------------
+
+/**
+ @abstract The number of indexed messages, including deleted ones not merged away yet.
+ */
+@property (nonatomic, readonly) NSUInteger countOfDocuments;
+
+@property (nonatomic, readonly) NSUInteger countOfSegments;
+
+/**
+ @abstract The size of the segment files in bytes.
+ */
+@property (nonatomic, readonly) NSUInteger byteCount;
+
+@end
@@ -0,0 +1,996 @@
+//
+//  ATLMMessageSearchIndex.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMMessageSearchIndex.h"
+#import <UIKit/UIKit.h>
+#import <LayerKit/LayerKit.h>
+#import <Atlas/Atlas.h>
+#import "ATLMSearchSegment.h"
+
+static const NSUInteger ATLMMessageSearchIndexDefaultFlushThreshold = 10000;
+static const NSUInteger ATLMMessageSearchIndexDefaultMergeFactor = 8;
+static const NSUInteger ATLMMessageSearchMaximumTokenLength = 64;
+static const NSUInteger ATLMMessageSearchMinimumPrefixLength = 2;
+static const NSUInteger ATLMMessageSearchConversationHitFanOut = 20;
+static const double ATLMMessageSearchBM25K1 = 1.2;
+static const double ATLMMessageSearchBM25B = 0.75;
+
+static NSString *const ATLMMessageSearchManifestFileName = @"manifest.plist";
+static NSString *const ATLMMessageSearchSegmentExtension = @"atls";
+static NSString *const ATLMMessageSearchManifestGenerationKey = @"generation";
+static NSString *const ATLMMessageSearchManifestSegmentsKey = @"segments";
+static NSString *const ATLMMessageSearchManifestFileKey = @"file";
+static NSString *const ATLMMessageSearchManifestMessageTombstonesKey = @"message_tombstones";
+static NSString *const ATLMMessageSearchManifestConversationTombstonesKey = @"conversation_tombstones";
+
+NSArray<NSString *> *ATLMSearchTokensForText(NSString *text)
+{
+    NSString *normalizedText = [text.precomposedStringWithCompatibilityMapping stringByFoldingWithOptions:NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch | NSWidthInsensitiveSearch locale:nil];
+    NSMutableArray *tokens = [NSMutableArray new];
+    if (!normalizedText.length) {
+        return tokens;
+    }
+    CFStringTokenizerRef tokenizer = CFStringTokenizerCreate(NULL, (__bridge CFStringRef)normalizedText, CFRangeMake(0, normalizedText.length), kCFStringTokenizerUnitWord, NULL);
+    NSCharacterSet *alphanumerics = [NSCharacterSet alphanumericCharacterSet];
+    while (CFStringTokenizerAdvanceToNextToken(tokenizer) != kCFStringTokenizerTokenNone) {
+        CFRange range = CFStringTokenizerGetCurrentTokenRange(tokenizer);
+        NSString *token = [normalizedText substringWithRange:NSMakeRange(range.location, MIN((NSUInteger)range.length, ATLMMessageSearchMaximumTokenLength))];
+        if ([token rangeOfCharacterFromSet:alphanumerics].location == NSNotFound) {
+            continue;
+        }
+        [tokens addObject:token];
+    }
+    CFRelease(tokenizer);
+    return tokens;
+}
+
+static dispatch_queue_t ATLMMessageSearchIndexQueue()
+{
+    static dispatch_queue_t queue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        queue = dispatch_queue_create("com.layer.Atlas-Messenger.message-search-index", DISPATCH_QUEUE_SERIAL);
+    });
+    return queue;
+}
+
+#pragma mark - Hits
+
+@interface ATLMMessageSearchHit ()
+
+@property (nonnull, nonatomic, readwrite) NSURL *messageIdentifier;
+@property (nonnull, nonatomic, readwrite) NSURL *conversationIdentifier;
+@property (nonnull, nonatomic, readwrite) NSDate *date;
+@property (nonatomic, readwrite) double score;
+
+@end
+
+@implementation ATLMMessageSearchHit
+
+@end
+
+@interface ATLMConversationSearchHit ()
+
+@property (nonnull, nonatomic, readwrite) NSURL *conversationIdentifier;
+@property (nonatomic, readwrite) double score;
+@property (nonnull, nonatomic, readwrite) NSArray *messageHits;
+
+@end
+
+@implementation ATLMConversationSearchHit
+
+@end
+
+#pragma mark - Sources
+
+/**
+ @abstract What queries need from segments and buffers alike.
+ */
+@protocol ATLMSearchSource <NSObject>
+
+@property (nonatomic, readonly) uint64_t generation;
+@property (nonatomic, readonly) uint32_t documentCount;
+@property (nonatomic, readonly) uint64_t totalTokenCount;
+
+- (NSString *)messageIdentifierOfDocument:(uint32_t)document;
+- (NSString *)conversationIdentifierOfDocument:(uint32_t)document;
+- (NSTimeInterval)dateOfDocument:(uint32_t)document;
+- (uint32_t)tokenCountOfDocument:(uint32_t)document;
+- (NSData *)postingsForToken:(NSString *)token prefix:(BOOL)prefix;
+
+/**
+ @abstract Deletions recorded in the source itself, as opposed to tombstones.
+ */
+- (BOOL)isDocumentDeleted:(uint32_t)document;
+
+@end
+
+@interface ATLMSearchSegment (ATLMSearchSource) <ATLMSearchSource>
+
+@end
+
+@implementation ATLMSearchSegment (ATLMSearchSource)
+
+- (NSData *)postingsForToken:(NSString *)token prefix:(BOOL)prefix
+{
+    NSData *bytes = [token dataUsingEncoding:NSUTF8StringEncoding];
+    return [self postingsForTermBytes:bytes.bytes length:bytes.length prefix:prefix];
+}
+
+- (BOOL)isDocumentDeleted:(uint32_t)document
+{
+    return NO;
+}
+
+@end
+
+@interface ATLMSearchBufferDocument : NSObject
+
+@property (nonatomic) NSString *messageIdentifier;
+@property (nonatomic) NSString *conversationIdentifier;
+@property (nonatomic) NSTimeInterval date;
+@property (nonatomic) uint32_t tokenCount;
+@property (nonatomic, getter=isDeleted) BOOL deleted;
+
+@end
+
+@implementation ATLMSearchBufferDocument
+
+@end
+
+/**
+ @abstract Collects new documents in memory until they are written to a segment.
+ @discussion Once frozen for writing, a buffer is only read, from the main
+   thread by queries and from the index queue by the writer; deletions then
+   go through tombstones.
+ */
+@interface ATLMSearchBuffer : NSObject <ATLMSearchSource>
+
+@property (nonatomic, readwrite) uint64_t generation;
+@property (nonatomic, readwrite) uint64_t totalTokenCount;
+@property (nonatomic) NSMutableArray *documents;
+@property (nonatomic) NSMutableDictionary *postingsByTerm;
+@property (nonatomic) NSMutableDictionary *documentIndexesByMessageIdentifier;
+
+@end
+
+@implementation ATLMSearchBuffer
+
+- (id)initWithGeneration:(uint64_t)generation
+{
+    self = [super init];
+    if (self) {
+        _generation = generation;
+        _documents = [NSMutableArray new];
+        _postingsByTerm = [NSMutableDictionary new];
+        _documentIndexesByMessageIdentifier = [NSMutableDictionary new];
+    }
+    return self;
+}
+
+- (uint32_t)documentCount
+{
+    return (uint32_t)self.documents.count;
+}
+
+- (void)addDocumentWithMessageIdentifier:(NSString *)messageIdentifier conversationIdentifier:(NSString *)conversationIdentifier date:(NSTimeInterval)date tokens:(NSArray *)tokens
+{
+    uint32_t documentIndex = (uint32_t)self.documents.count;
+    ATLMSearchBufferDocument *document = [ATLMSearchBufferDocument new];
+    document.messageIdentifier = messageIdentifier;
+    document.conversationIdentifier = conversationIdentifier;
+    document.date = date;
+    document.tokenCount = (uint32_t)tokens.count;
+    [self.documents addObject:document];
+    self.documentIndexesByMessageIdentifier[messageIdentifier] = @(documentIndex);
+    self.totalTokenCount += tokens.count;
+
+    NSCountedSet *terms = [[NSCountedSet alloc] initWithArray:tokens];
+    for (NSString *term in terms) {
+        NSMutableData *postings = self.postingsByTerm[term];
+        if (!postings) {
+            postings = [NSMutableData new];
+            self.postingsByTerm[term] = postings;
+        }
+        ATLMSearchPosting posting = { documentIndex, (uint32_t)[terms countForObject:term] };
+        [postings appendBytes:&posting length:sizeof(posting)];
+    }
+}
+
+- (void)removeDocumentWithMessageIdentifier:(NSString *)messageIdentifier
+{
+    NSNumber *documentIndex = self.documentIndexesByMessageIdentifier[messageIdentifier];
+    if (documentIndex) {
+        [self.documents[documentIndex.unsignedIntegerValue] setDeleted:YES];
+        [self.documentIndexesByMessageIdentifier removeObjectForKey:messageIdentifier];
+    }
+}
+
+- (void)removeDocumentsInConversationWithIdentifier:(NSString *)conversationIdentifier
+{
+    for (ATLMSearchBufferDocument *document in self.documents) {
+        if (!document.isDeleted && [document.conversationIdentifier isEqualToString:conversationIdentifier]) {
+            document.deleted = YES;
+            [self.documentIndexesByMessageIdentifier removeObjectForKey:document.messageIdentifier];
+        }
+    }
+}
+
+- (NSString *)messageIdentifierOfDocument:(uint32_t)document
+{
+    return [self.documents[document] messageIdentifier];
+}
+
+- (NSString *)conversationIdentifierOfDocument:(uint32_t)document
+{
+    return [self.documents[document] conversationIdentifier];
+}
+
+- (NSTimeInterval)dateOfDocument:(uint32_t)document
+{
+    return [self.documents[document] date];
+}
+
+- (uint32_t)tokenCountOfDocument:(uint32_t)document
+{
+    return [self.documents[document] tokenCount];
+}
+
+- (BOOL)isDocumentDeleted:(uint32_t)document
+{
+    return [self.documents[document] isDeleted];
+}
+
+- (NSData *)postingsForToken:(NSString *)token prefix:(BOOL)prefix
+{
+    if (!prefix) {
+        return self.postingsByTerm[token] ?: [NSData data];
+    }
+    NSMutableData *postings = [NSMutableData new];
+    NSUInteger matchingTermCount = 0;
+    for (NSString *term in self.postingsByTerm) {
+        if ([term hasPrefix:token]) {
+            [postings appendData:self.postingsByTerm[term]];
+            matchingTermCount += 1;
+        }
+    }
+    if (matchingTermCount > 1) {
+        ATLMSearchFoldPostings(postings);
+    }
+    return postings;
+}
+
+- (NSData *)segmentData
+{
+    ATLMSearchSegmentBuilder *builder = [ATLMSearchSegmentBuilder builder];
+    uint32_t *remappedIndexes = malloc(MAX(self.documents.count, 1) * sizeof(uint32_t));
+    [self.documents enumerateObjectsUsingBlock:^(ATLMSearchBufferDocument *document, NSUInteger index, BOOL *stop) {
+        remappedIndexes[index] = document.isDeleted ? UINT32_MAX : [builder addDocumentWithMessageIdentifier:document.messageIdentifier conversationIdentifier:document.conversationIdentifier date:document.date tokenCount:document.tokenCount];
+    }];
+
+    // Segment dictionaries are ordered by UTF-8 bytes, which differs from NSString's UTF-16 order.
+    NSMutableArray *termBytes = [NSMutableArray arrayWithCapacity:self.postingsByTerm.count];
+    for (NSString *term in self.postingsByTerm) {
+        [termBytes addObject:[term dataUsingEncoding:NSUTF8StringEncoding]];
+    }
+    [termBytes sortUsingComparator:^NSComparisonResult(NSData *bytes, NSData *otherBytes) {
+        return (NSComparisonResult)ATLMSearchCompareTermBytes(bytes.bytes, bytes.length, otherBytes.bytes, otherBytes.length);
+    }];
+    for (NSData *bytes in termBytes) {
+        NSString *term = [[NSString alloc] initWithData:bytes encoding:NSUTF8StringEncoding];
+        NSData *postings = self.postingsByTerm[term];
+        const ATLMSearchPosting *values = postings.bytes;
+        [builder beginTermWithBytes:bytes.bytes length:bytes.length];
+        for (NSUInteger index = 0; index < postings.length / sizeof(ATLMSearchPosting); index++) {
+            uint32_t document = remappedIndexes[values[index].document];
+            if (document != UINT32_MAX) {
+                [builder addPosting:(ATLMSearchPosting){ document, values[index].frequency }];
+            }
+        }
+        [builder endTerm];
+    }
+    free(remappedIndexes);
+    return [builder dataWithGeneration:self.generation];
+}
+
+@end
+
+#pragma mark - Index
+
+typedef struct {
+    double score;
+    double date;
+    uint32_t source;
+    uint32_t document;
+} ATLMSearchCandidate;
+
+static int ATLMSearchCompareCandidates(const void *candidate, const void *otherCandidate)
+{
+    const ATLMSearchCandidate *first = candidate;
+    const ATLMSearchCandidate *second = otherCandidate;
+    if (first->score != second->score) {
+        return first->score > second->score ? -1 : 1;
+    }
+    if (first->date != second->date) {
+        return first->date > second->date ? -1 : 1;
+    }
+    return 0;
+}
+
+@interface ATLMMessageSearchIndex ()
+
+@property (nonnull, nonatomic, readwrite) NSString *directory;
+@property (nonnull, nonatomic) NSMutableArray *segments;
+@property (nonnull, nonatomic) NSMutableArray *frozenBuffers;
+@property (nonnull, nonatomic) ATLMSearchBuffer *buffer;
+@property (nonnull, nonatomic) NSMutableDictionary *messageTombstones;
+@property (nonnull, nonatomic) NSMutableDictionary *conversationTombstones;
+@property (nonatomic, getter=isMerging) BOOL merging;
+@property (nonatomic) NSUInteger removalCount;
+@property (nonatomic) BOOL fullMergeRequested;
+@property (nonnull, nonatomic) NSMutableArray *mergeCompletions;
+@property (nonnull, nonatomic) NSMutableArray *idleCompletions;
+
+@end
+
+@implementation ATLMMessageSearchIndex
+
++ (instancetype)indexWithDirectory:(NSString *)directory
+{
+    return [[self alloc] initWithDirectory:directory];
+}
+
++ (NSString *)defaultDirectory
+{
+    NSString *cachesDirectory = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES).firstObject;
+    return [cachesDirectory stringByAppendingPathComponent:@"MessageSearch"];
+}
+
+- (id)initWithDirectory:(NSString *)directory
+{
+    NSParameterAssert(directory);
+    self = [super init];
+    if (self) {
+        _directory = [directory copy];
+        _flushThreshold = ATLMMessageSearchIndexDefaultFlushThreshold;
+        _mergeFactor = ATLMMessageSearchIndexDefaultMergeFactor;
+        _segments = [NSMutableArray new];
+        _frozenBuffers = [NSMutableArray new];
+        _messageTombstones = [NSMutableDictionary new];
+        _conversationTombstones = [NSMutableDictionary new];
+        _mergeCompletions = [NSMutableArray new];
+        _idleCompletions = [NSMutableArray new];
+        [[NSFileManager defaultManager] createDirectoryAtPath:_directory withIntermediateDirectories:YES attributes:nil error:nil];
+        [self loadManifest];
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(applicationDidEnterBackground:) name:UIApplicationDidEnterBackgroundNotification object:nil];
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use indexWithDirectory:" userInfo:nil];
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+#pragma mark - Indexing
+
+- (void)indexMessageWithIdentifier:(NSURL *)messageIdentifier conversationIdentifier:(NSURL *)conversationIdentifier text:(NSString *)text date:(NSDate *)date
+{
+    // Only the buffer is checked; tombstoning every new message would bloat the manifest.
+    [self.buffer removeDocumentWithMessageIdentifier:messageIdentifier.absoluteString];
+    NSArray *tokens = ATLMSearchTokensForText(text);
+    if (!tokens.count) {
+        return;
+    }
+    [self.buffer addDocumentWithMessageIdentifier:messageIdentifier.absoluteString conversationIdentifier:conversationIdentifier.absoluteString date:date.timeIntervalSinceReferenceDate tokens:tokens];
+    if (self.buffer.documents.count >= self.flushThreshold) {
+        [self flush];
+    }
+}
+
+- (void)indexMessage:(LYRMessage *)message
+{
+    NSMutableArray *texts = [NSMutableArray new];
+    for (LYRMessagePart *part in message.parts) {
+        if (![part.MIMEType isEqualToString:ATLMIMETypeTextPlain] || !part.data) {
+            continue;
+        }
+        NSString *text = [[NSString alloc] initWithData:part.data encoding:NSUTF8StringEncoding];
+        if (text) {
+            [texts addObject:text];
+        }
+    }
+    if (!texts.count || !message.identifier || !message.conversation.identifier) {
+        return;
+    }
+    NSDate *date = message.sentAt ?: message.receivedAt ?: [NSDate date];
+    [self indexMessageWithIdentifier:message.identifier conversationIdentifier:message.conversation.identifier text:[texts componentsJoinedByString:@"\n"] date:date];
+}
+
+- (void)removeMessageWithIdentifier:(NSURL *)messageIdentifier
+{
+    NSString *identifier = messageIdentifier.absoluteString;
+    [self.buffer removeDocumentWithMessageIdentifier:identifier];
+    if (self.segments.count || self.frozenBuffers.count) {
+        // Hides copies in every source older than the current buffer.
+        self.messageTombstones[identifier] = @(self.buffer.generation);
+    }
+}
+
+- (void)removeMessagesInConversationWithIdentifier:(NSURL *)conversationIdentifier
+{
+    NSString *identifier = conversationIdentifier.absoluteString;
+    [self.buffer removeDocumentsInConversationWithIdentifier:identifier];
+    if (self.segments.count || self.frozenBuffers.count) {
+        self.conversationTombstones[identifier] = @(self.buffer.generation);
+        [self saveManifest];
+    }
+}
+
+- (void)applyChanges:(NSArray *)changes
+{
+    for (LYRObjectChange *change in changes) {
+        if ([change.object isKindOfClass:[LYRMessage class]]) {
+            LYRMessage *message = change.object;
+            if (change.type == LYRObjectChangeTypeCreate) {
+                [self indexMessage:message];
+            } else if (change.type == LYRObjectChangeTypeDelete) {
+                [self removeMessageWithIdentifier:message.identifier];
+            }
+        } else if ([change.object isKindOfClass:[LYRConversation class]] && change.type == LYRObjectChangeTypeDelete) {
+            [self removeMessagesInConversationWithIdentifier:[change.object identifier]];
+        }
+    }
+}
+
+- (void)removeAll
+{
+    NSArray *segments = [self.segments copy];
+    [self.segments removeAllObjects];
+    [self.frozenBuffers removeAllObjects];
+    [self.messageTombstones removeAllObjects];
+    [self.conversationTombstones removeAllObjects];
+    self.buffer = [[ATLMSearchBuffer alloc] initWithGeneration:self.buffer.generation + 1];
+    // Segments written by flushes and merges still running are dropped once they finish.
+    self.removalCount += 1;
+    [self saveManifest];
+    dispatch_async(ATLMMessageSearchIndexQueue(), ^{
+        for (ATLMSearchSegment *segment in segments) {
+            [[NSFileManager defaultManager] removeItemAtPath:segment.path error:nil];
+        }
+    });
+}
+
+#pragma mark - Flushing and Merging
+
+- (void)applicationDidEnterBackground:(NSNotification *)notification
+{
+    [self flush];
+    // Message tombstones are only saved along with segments otherwise.
+    [self saveManifest];
+}
+
+- (void)flush
+{
+    if (!self.buffer.documents.count) {
+        return;
+    }
+    ATLMSearchBuffer *frozenBuffer = self.buffer;
+    [self.frozenBuffers addObject:frozenBuffer];
+    self.buffer = [[ATLMSearchBuffer alloc] initWithGeneration:frozenBuffer.generation + 1];
+    NSString *path = [self newSegmentPath];
+    NSUInteger removalCount = self.removalCount;
+    dispatch_async(ATLMMessageSearchIndexQueue(), ^{
+        NSError *error;
+        ATLMSearchSegment *segment;
+        if ([[frozenBuffer segmentData] writeToFile:path options:NSDataWritingAtomic error:&error]) {
+            segment = [ATLMSearchSegment segmentWithContentsOfFile:path error:&error];
+        }
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (self.removalCount != removalCount) {
+                // Everything was removed while the segment was written.
+                [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+            } else if (segment) {
+                [self.segments addObject:segment];
+                [self.frozenBuffers removeObjectIdenticalTo:frozenBuffer];
+                [self saveManifest];
+            } else {
+                // Keep serving the buffer from memory; it is lost on termination.
+                NSLog(@"Failed to write search segment with %@", error);
+            }
+            [self scheduleMerge];
+            [self notifyIfIdle];
+        });
+    });
+}
+
+- (void)mergeAllSegmentsWithCompletion:(void (^)(void))completion
+{
+    [self flush];
+    self.fullMergeRequested = YES;
+    if (completion) {
+        [self.mergeCompletions addObject:[completion copy]];
+    }
+    [self scheduleMerge];
+}
+
+- (void)waitForBackgroundWorkWithCompletion:(void (^)(void))completion
+{
+    [self.idleCompletions addObject:[completion copy]];
+    // Lets manifest writes already queued finish first.
+    dispatch_async(ATLMMessageSearchIndexQueue(), ^{
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self notifyIfIdle];
+        });
+    });
+}
+
+- (void)notifyIfIdle
+{
+    if (self.isMerging || self.frozenBuffers.count || !self.idleCompletions.count) {
+        return;
+    }
+    NSArray *completions = [self.idleCompletions copy];
+    [self.idleCompletions removeAllObjects];
+    for (void (^completion)(void) in completions) {
+        completion();
+    }
+}
+
+- (NSArray *)segmentsToMerge
+{
+    if (self.fullMergeRequested) {
+        BOOL hasTombstones = self.messageTombstones.count || self.conversationTombstones.count;
+        return (self.segments.count > 1 || (self.segments.count == 1 && hasTombstones)) ? [self.segments copy] : @[];
+    }
+    // Segments are tiered by size so each document is rewritten a logarithmic number of times.
+    NSMutableDictionary *segmentsByTier = [NSMutableDictionary new];
+    for (ATLMSearchSegment *segment in self.segments) {
+        double ratio = (double)segment.documentCount / MAX(self.flushThreshold, 1);
+        NSInteger tier = ratio <= 1 ? 0 : (NSInteger)floor(log(ratio) / log(MAX(self.mergeFactor, 2)));
+        NSMutableArray *tierSegments = segmentsByTier[@(tier)];
+        if (!tierSegments) {
+            tierSegments = [NSMutableArray new];
+            segmentsByTier[@(tier)] = tierSegments;
+        }
+        [tierSegments addObject:segment];
+    }
+    for (NSNumber *tier in [segmentsByTier.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+        NSArray *tierSegments = segmentsByTier[tier];
+        if (tierSegments.count >= MAX(self.mergeFactor, 2)) {
+            return [tierSegments subarrayWithRange:NSMakeRange(0, MAX(self.mergeFactor, 2))];
+        }
+    }
+    return @[];
+}
+
+- (void)scheduleMerge
+{
+    if (self.isMerging || (self.fullMergeRequested && self.frozenBuffers.count)) {
+        return;
+    }
+    NSArray *inputs = [self segmentsToMerge];
+    if (!inputs.count) {
+        [self finishFullMerge];
+        return;
+    }
+    BOOL fullMerge = self.fullMergeRequested;
+    self.merging = YES;
+    NSDictionary *messageTombstones = [self.messageTombstones copy];
+    NSDictionary *conversationTombstones = [self.conversationTombstones copy];
+    NSString *path = [self newSegmentPath];
+    NSUInteger removalCount = self.removalCount;
+    dispatch_async(ATLMMessageSearchIndexQueue(), ^{
+        NSError *error;
+        ATLMSearchSegment *segment;
+        NSData *data = [[self class] dataByMergingSegments:inputs messageTombstones:messageTombstones conversationTombstones:conversationTombstones];
+        if ([data writeToFile:path options:NSDataWritingAtomic error:&error]) {
+            segment = [ATLMSearchSegment segmentWithContentsOfFile:path error:&error];
+        }
+        dispatch_async(dispatch_get_main_queue(), ^{
+            self.merging = NO;
+            if (self.removalCount != removalCount) {
+                [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+            } else if (segment) {
+                NSUInteger index = [self.segments indexOfObjectIdenticalTo:inputs.firstObject];
+                [self.segments removeObjectsInArray:inputs];
+                [self.segments insertObject:segment atIndex:MIN(index, self.segments.count)];
+                [self pruneTombstones];
+                [self saveManifest];
+                for (ATLMSearchSegment *input in inputs) {
+                    [[NSFileManager defaultManager] removeItemAtPath:input.path error:nil];
+                }
+            } else {
+                NSLog(@"Failed to merge search segments with %@", error);
+            }
+            if (fullMerge) {
+                [self finishFullMerge];
+            } else {
+                [self scheduleMerge];
+            }
+            [self notifyIfIdle];
+        });
+    });
+}
+
+- (void)finishFullMerge
+{
+    if (!self.fullMergeRequested) {
+        return;
+    }
+    self.fullMergeRequested = NO;
+    NSArray *completions = [self.mergeCompletions copy];
+    [self.mergeCompletions removeAllObjects];
+    for (void (^completion)(void) in completions) {
+        completion();
+    }
+    [self scheduleMerge];
+}
+
++ (NSData *)dataByMergingSegments:(NSArray *)segments messageTombstones:(NSDictionary *)messageTombstones conversationTombstones:(NSDictionary *)conversationTombstones
+{
+    ATLMSearchSegmentBuilder *builder = [ATLMSearchSegmentBuilder builder];
+    uint64_t generation = 0;
+    NSMutableArray *remappedIndexes = [NSMutableArray arrayWithCapacity:segments.count];
+    for (ATLMSearchSegment *segment in segments) {
+        generation = MAX(generation, segment.generation);
+        NSMutableData *remapping = [NSMutableData dataWithLength:MAX(segment.documentCount, 1) * sizeof(uint32_t)];
+        uint32_t *indexes = remapping.mutableBytes;
+        for (uint32_t document = 0; document < segment.documentCount; document++) {
+            if ([self isDocument:document ofSource:segment deletedWithMessageTombstones:messageTombstones conversationTombstones:conversationTombstones]) {
+                indexes[document] = UINT32_MAX;
+                continue;
+            }
+            indexes[document] = [builder addDocumentWithMessageIdentifier:[segment messageIdentifierOfDocument:document] conversationIdentifier:[segment conversationIdentifierOfDocument:document] date:[segment dateOfDocument:document] tokenCount:[segment tokenCountOfDocument:document]];
+        }
+        [remappedIndexes addObject:remapping];
+    }
+
+    // Walks the sorted dictionaries side by side. Documents of earlier segments
+    // were added first, so postings stay in ascending document order.
+    NSUInteger segmentCount = segments.count;
+    uint32_t *cursors = calloc(segmentCount, sizeof(uint32_t));
+    while (YES) {
+        const uint8_t *smallestBytes = NULL;
+        NSUInteger smallestLength = 0;
+        for (NSUInteger index = 0; index < segmentCount; index++) {
+            ATLMSearchSegment *segment = segments[index];
+            if (cursors[index] >= segment.termCount) {
+                continue;
+            }
+            NSUInteger length;
+            const uint8_t *bytes = [segment bytesOfTermAtIndex:cursors[index] length:&length];
+            if (!smallestBytes || ATLMSearchCompareTermBytes(bytes, length, smallestBytes, smallestLength) < 0) {
+                smallestBytes = bytes;
+                smallestLength = length;
+            }
+        }
+        if (!smallestBytes) {
+            break;
+        }
+        NSData *term = [NSData dataWithBytes:smallestBytes length:smallestLength];
+        [builder beginTermWithBytes:term.bytes length:term.length];
+        for (NSUInteger index = 0; index < segmentCount; index++) {
+            ATLMSearchSegment *segment = segments[index];
+            if (cursors[index] >= segment.termCount) {
+                continue;
+            }
+            NSUInteger length;
+            const uint8_t *bytes = [segment bytesOfTermAtIndex:cursors[index] length:&length];
+            if (ATLMSearchCompareTermBytes(bytes, length, term.bytes, term.length) != 0) {
+                continue;
+            }
+            const uint32_t *indexes = [remappedIndexes[index] bytes];
+            [segment enumeratePostingsOfTermAtIndex:cursors[index] usingBlock:^(ATLMSearchPosting posting) {
+                uint32_t document = indexes[posting.document];
+                if (document != UINT32_MAX) {
+                    [builder addPosting:(ATLMSearchPosting){ document, posting.frequency }];
+                }
+            }];
+            cursors[index] += 1;
+        }
+        [builder endTerm];
+    }
+    free(cursors);
+    return [builder dataWithGeneration:generation];
+}
+
++ (BOOL)isDocument:(uint32_t)document ofSource:(id<ATLMSearchSource>)source deletedWithMessageTombstones:(NSDictionary *)messageTombstones conversationTombstones:(NSDictionary *)conversationTombstones
+{
+    if ([source isDocumentDeleted:document]) {
+        return YES;
+    }
+    if (messageTombstones.count) {
+        NSNumber *generation = messageTombstones[[source messageIdentifierOfDocument:document]];
+        if (generation && generation.unsignedLongLongValue > source.generation) {
+            return YES;
+        }
+    }
+    if (conversationTombstones.count) {
+        NSNumber *generation = conversationTombstones[[source conversationIdentifierOfDocument:document]];
+        if (generation && generation.unsignedLongLongValue > source.generation) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+- (void)pruneTombstones
+{
+    // Tombstones only hide sources older than themselves.
+    uint64_t oldestGeneration = self.buffer.generation;
+    for (id<ATLMSearchSource> source in [self.segments arrayByAddingObjectsFromArray:self.frozenBuffers]) {
+        oldestGeneration = MIN(oldestGeneration, source.generation);
+    }
+    for (NSMutableDictionary *tombstones in @[ self.messageTombstones, self.conversationTombstones ]) {
+        NSSet *stale = [tombstones keysOfEntriesPassingTest:^BOOL(NSString *identifier, NSNumber *generation, BOOL *stop) {
+            return generation.unsignedLongLongValue <= oldestGeneration;
+        }];
+        [tombstones removeObjectsForKeys:stale.allObjects];
+    }
+}
+
+#pragma mark - Persistence
+
+- (NSString *)newSegmentPath
+{
+    NSString *fileName = [[NSUUID UUID].UUIDString stringByAppendingPathExtension:ATLMMessageSearchSegmentExtension];
+    return [self.directory stringByAppendingPathComponent:fileName];
+}
+
+- (void)loadManifest
+{
+    NSDictionary *manifest = [NSDictionary dictionaryWithContentsOfFile:[self.directory stringByAppendingPathComponent:ATLMMessageSearchManifestFileName]];
+    uint64_t generation = [manifest[ATLMMessageSearchManifestGenerationKey] unsignedLongLongValue];
+    NSMutableSet *referencedFileNames = [NSMutableSet new];
+    for (NSDictionary *segmentEntry in manifest[ATLMMessageSearchManifestSegmentsKey]) {
+        NSString *fileName = segmentEntry[ATLMMessageSearchManifestFileKey];
+        NSError *error;
+        ATLMSearchSegment *segment = [ATLMSearchSegment segmentWithContentsOfFile:[self.directory stringByAppendingPathComponent:fileName] error:&error];
+        if (!segment) {
+            NSLog(@"Dropping unreadable search segment %@ with %@", fileName, error);
+            continue;
+        }
+        [referencedFileNames addObject:fileName];
+        [self.segments addObject:segment];
+        generation = MAX(generation, segment.generation + 1);
+    }
+    [self.messageTombstones addEntriesFromDictionary:manifest[ATLMMessageSearchManifestMessageTombstonesKey] ?: @{}];
+    [self.conversationTombstones addEntriesFromDictionary:manifest[ATLMMessageSearchManifestConversationTombstonesKey] ?: @{}];
+    self.buffer = [[ATLMSearchBuffer alloc] initWithGeneration:generation];
+
+    // Segments written by a flush or merge interrupted before the manifest was saved.
+    for (NSString *fileName in [[NSFileManager defaultManager] contentsOfDirectoryAtPath:self.directory error:nil]) {
+        if ([fileName.pathExtension isEqualToString:ATLMMessageSearchSegmentExtension] && ![referencedFileNames containsObject:fileName]) {
+            [[NSFileManager defaultManager] removeItemAtPath:[self.directory stringByAppendingPathComponent:fileName] error:nil];
+        }
+    }
+}
+
+- (void)saveManifest
+{
+    NSMutableArray *segmentEntries = [NSMutableArray arrayWithCapacity:self.segments.count];
+    for (ATLMSearchSegment *segment in self.segments) {
+        [segmentEntries addObject:@{ ATLMMessageSearchManifestFileKey: segment.path.lastPathComponent }];
+    }
+    NSDictionary *manifest = @{ ATLMMessageSearchManifestGenerationKey: @(self.buffer.generation),
+                                ATLMMessageSearchManifestSegmentsKey: segmentEntries,
+                                ATLMMessageSearchManifestMessageTombstonesKey: [self.messageTombstones copy],
+                                ATLMMessageSearchManifestConversationTombstonesKey: [self.conversationTombstones copy] };
+    NSString *path = [self.directory stringByAppendingPathComponent:ATLMMessageSearchManifestFileName];
+    dispatch_async(ATLMMessageSearchIndexQueue(), ^{
+        if (![manifest writeToFile:path atomically:YES]) {
+            NSLog(@"Failed to save search index manifest to %@", path);
+        }
+    });
+}
+
+#pragma mark - Searching
+
+- (NSArray *)messageHitsForQuery:(NSString *)query limit:(NSUInteger)limit
+{
+    NSArray *tokens = ATLMSearchTokensForText(query);
+    if (!tokens.count || !limit) {
+        return @[];
+    }
+    // The last token is still being typed unless the query ends with a separator.
+    unichar lastCharacter = [query characterAtIndex:query.length - 1];
+    BOOL prefixLastToken = [[NSCharacterSet alphanumericCharacterSet] characterIsMember:lastCharacter] && [tokens.lastObject length] >= ATLMMessageSearchMinimumPrefixLength;
+    NSOrderedSet *uniqueTokens = [NSOrderedSet orderedSetWithArray:tokens];
+
+    NSMutableArray *sources = [NSMutableArray arrayWithArray:self.segments];
+    [sources addObjectsFromArray:self.frozenBuffers];
+    [sources addObject:self.buffer];
+    double documentCount = 0;
+    double tokenCount = 0;
+    for (id<ATLMSearchSource> source in sources) {
+        documentCount += source.documentCount;
+        tokenCount += source.totalTokenCount;
+    }
+    if (!documentCount) {
+        return @[];
+    }
+    double averageDocumentLength = tokenCount / documentCount;
+
+    // Postings per token and source; document frequencies span all sources.
+    NSMutableArray *postingsByToken = [NSMutableArray arrayWithCapacity:uniqueTokens.count];
+    double *inverseDocumentFrequencies = malloc(uniqueTokens.count * sizeof(double));
+    [uniqueTokens enumerateObjectsUsingBlock:^(NSString *token, NSUInteger tokenIndex, BOOL *stop) {
+        BOOL prefix = prefixLastToken && [token isEqualToString:tokens.lastObject];
+        NSMutableArray *postingsBySource = [NSMutableArray arrayWithCapacity:sources.count];
+        double documentFrequency = 0;
+        for (id<ATLMSearchSource> source in sources) {
+            NSData *postings = [source postingsForToken:token prefix:prefix];
+            documentFrequency += postings.length / sizeof(ATLMSearchPosting);
+            [postingsBySource addObject:postings];
+        }
+        [postingsByToken addObject:postingsBySource];
+        inverseDocumentFrequencies[tokenIndex] = log(1 + (documentCount - documentFrequency + 0.5) / (documentFrequency + 0.5));
+    }];
+
+    NSMutableData *candidates = [NSMutableData new];
+    for (uint32_t sourceIndex = 0; sourceIndex < sources.count; sourceIndex++) {
+        id<ATLMSearchSource> source = sources[sourceIndex];
+        [self appendCandidatesOfSource:source sourceIndex:sourceIndex postingsByToken:postingsByToken inverseDocumentFrequencies:inverseDocumentFrequencies averageDocumentLength:averageDocumentLength toData:candidates];
+    }
+    free(inverseDocumentFrequencies);
+
+    ATLMSearchCandidate *values = candidates.mutableBytes;
+    NSUInteger candidateCount = candidates.length / sizeof(ATLMSearchCandidate);
+    qsort(values, candidateCount, sizeof(ATLMSearchCandidate), ATLMSearchCompareCandidates);
+    NSMutableArray *hits = [NSMutableArray arrayWithCapacity:MIN(limit, candidateCount)];
+    for (NSUInteger index = 0; index < candidateCount && hits.count < limit; index++) {
+        ATLMSearchCandidate candidate = values[index];
+        id<ATLMSearchSource> source = sources[candidate.source];
+        if ([[self class] isDocument:candidate.document ofSource:source deletedWithMessageTombstones:self.messageTombstones conversationTombstones:self.conversationTombstones]) {
+            continue;
+        }
+        ATLMMessageSearchHit *hit = [ATLMMessageSearchHit new];
+        hit.messageIdentifier = [NSURL URLWithString:[source messageIdentifierOfDocument:candidate.document]];
+        hit.conversationIdentifier = [NSURL URLWithString:[source conversationIdentifierOfDocument:candidate.document]];
+        hit.date = [NSDate dateWithTimeIntervalSinceReferenceDate:candidate.date];
+        hit.score = candidate.score;
+        if (hit.messageIdentifier && hit.conversationIdentifier) {
+            [hits addObject:hit];
+        }
+    }
+    return hits;
+}
+
+- (void)appendCandidatesOfSource:(id<ATLMSearchSource>)source sourceIndex:(uint32_t)sourceIndex postingsByToken:(NSArray *)postingsByToken inverseDocumentFrequencies:(const double *)inverseDocumentFrequencies averageDocumentLength:(double)averageDocumentLength toData:(NSMutableData *)candidates
+{
+    // Intersects starting from the rarest token to keep the working set small.
+    NSMutableArray *tokenIndexes = [NSMutableArray arrayWithCapacity:postingsByToken.count];
+    for (NSUInteger tokenIndex = 0; tokenIndex < postingsByToken.count; tokenIndex++) {
+        NSData *postings = postingsByToken[tokenIndex][sourceIndex];
+        if (!postings.length) {
+            return;
+        }
+        [tokenIndexes addObject:@(tokenIndex)];
+    }
+    [tokenIndexes sortUsingComparator:^NSComparisonResult(NSNumber *tokenIndex, NSNumber *otherTokenIndex) {
+        NSUInteger length = [postingsByToken[tokenIndex.unsignedIntegerValue][sourceIndex] length];
+        NSUInteger otherLength = [postingsByToken[otherTokenIndex.unsignedIntegerValue][sourceIndex] length];
+        return length < otherLength ? NSOrderedAscending : (length > otherLength ? NSOrderedDescending : NSOrderedSame);
+    }];
+
+    NSMutableData *matches = nil;
+    for (NSNumber *tokenIndex in tokenIndexes) {
+        NSData *postings = postingsByToken[tokenIndex.unsignedIntegerValue][sourceIndex];
+        const ATLMSearchPosting *values = postings.bytes;
+        NSUInteger count = postings.length / sizeof(ATLMSearchPosting);
+        double inverseDocumentFrequency = inverseDocumentFrequencies[tokenIndex.unsignedIntegerValue];
+        double (^scoreOfPosting)(ATLMSearchPosting) = ^double(ATLMSearchPosting posting) {
+            double documentLength = [source tokenCountOfDocument:posting.document];
+            double frequency = posting.frequency;
+            double normalization = ATLMMessageSearchBM25K1 * (1 - ATLMMessageSearchBM25B + ATLMMessageSearchBM25B * documentLength / averageDocumentLength);
+            return inverseDocumentFrequency * frequency * (ATLMMessageSearchBM25K1 + 1) / (frequency + normalization);
+        };
+        if (!matches) {
+            matches = [NSMutableData dataWithLength:count * sizeof(ATLMSearchCandidate)];
+            ATLMSearchCandidate *candidateValues = matches.mutableBytes;
+            for (NSUInteger index = 0; index < count; index++) {
+                candidateValues[index] = (ATLMSearchCandidate){ scoreOfPosting(values[index]), 0, sourceIndex, values[index].document };
+            }
+            continue;
+        }
+        ATLMSearchCandidate *candidateValues = matches.mutableBytes;
+        NSUInteger candidateCount = matches.length / sizeof(ATLMSearchCandidate);
+        NSUInteger matchCount = 0;
+        NSUInteger postingIndex = 0;
+        for (NSUInteger candidateIndex = 0; candidateIndex < candidateCount && postingIndex < count; candidateIndex++) {
+            uint32_t document = candidateValues[candidateIndex].document;
+            while (postingIndex < count && values[postingIndex].document < document) {
+                postingIndex++;
+            }
+            if (postingIndex < count && values[postingIndex].document == document) {
+                candidateValues[matchCount] = candidateValues[candidateIndex];
+                candidateValues[matchCount].score += scoreOfPosting(values[postingIndex]);
+                matchCount++;
+            }
+        }
+        matches.length = matchCount * sizeof(ATLMSearchCandidate);
+        if (!matchCount) {
+            return;
+        }
+    }
+    ATLMSearchCandidate *candidateValues = matches.mutableBytes;
+    NSUInteger candidateCount = matches.length / sizeof(ATLMSearchCandidate);
+    for (NSUInteger index = 0; index < candidateCount; index++) {
+        candidateValues[index].date = [source dateOfDocument:candidateValues[index].document];
+    }
+    [candidates appendData:matches];
+}
+
+- (NSArray *)conversationHitsForQuery:(NSString *)query limit:(NSUInteger)limit
+{
+    NSArray *messageHits = [self messageHitsForQuery:query limit:limit * ATLMMessageSearchConversationHitFanOut];
+    NSMutableDictionary *messageHitsByConversation = [NSMutableDictionary new];
+    NSMutableArray *conversationIdentifiers = [NSMutableArray new];
+    for (ATLMMessageSearchHit *messageHit in messageHits) {
+        NSMutableArray *conversationMessageHits = messageHitsByConversation[messageHit.conversationIdentifier];
+        if (!conversationMessageHits) {
+            conversationMessageHits = [NSMutableArray new];
+            messageHitsByConversation[messageHit.conversationIdentifier] = conversationMessageHits;
+            [conversationIdentifiers addObject:messageHit.conversationIdentifier];
+        }
+        [conversationMessageHits addObject:messageHit];
+    }
+    NSMutableArray *conversationHits = [NSMutableArray arrayWithCapacity:conversationIdentifiers.count];
+    for (NSURL *conversationIdentifier in conversationIdentifiers) {
+        NSArray *conversationMessageHits = messageHitsByConversation[conversationIdentifier];
+        ATLMConversationSearchHit *conversationHit = [ATLMConversationSearchHit new];
+        conversationHit.conversationIdentifier = conversationIdentifier;
+        conversationHit.messageHits = conversationMessageHits;
+        // Message hits are sorted, so the first one is the best.
+        conversationHit.score = [conversationMessageHits.firstObject score] * (1 + 0.1 * log2(conversationMessageHits.count));
+        [conversationHits addObject:conversationHit];
+    }
+    [conversationHits sortUsingDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:@"score" ascending:NO] ]];
+    return conversationHits.count > limit ? [conversationHits subarrayWithRange:NSMakeRange(0, limit)] : conversationHits;
+}
+
+#pragma mark - Metrics
+
+- (NSUInteger)countOfDocuments
+{
+    NSUInteger count = self.buffer.documentCount;
+    for (id<ATLMSearchSource> source in [self.segments arrayByAddingObjectsFromArray:self.frozenBuffers]) {
+        count += source.documentCount;
+    }
+    return count;
+}
+
+- (NSUInteger)countOfSegments
+{
+    return self.segments.count;
+}
+
+- (NSUInteger)byteCount
+{
+    return [[self.segments valueForKeyPath:@"@sum.byteCount"] unsignedIntegerValue];
+}
+
+@end
@@ -0,0 +1,237 @@
+//
+//  ATLMOutbox.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+@class ATLMOutbox;
+
+/**
+ @abstract A message waiting in the `ATLMOutbox`.
+ */
+@interface ATLMOutboxEntry : NSObject
+
+/**
+ @abstract A unique identifier assigned to the entry on enqueue.
+ */
+@property (nonnull, nonatomic, readonly) NSString *identifier;
+
+/**
+ @abstract The identifier of the conversation the message is sent to.
+ */
+@property (nonnull, nonatomic, readonly) NSURL *conversationIdentifier;
+
+/**
+ @abstract The MIME types of the message parts.
+ */
+@property (nonnull, nonatomic, readonly) NSArray<NSString *> *MIMETypes;
+
+/**
+ @abstract The contents of the message parts, in the order of `MIMETypes`.
+ @discussion Entries restored from the journal map their parts from disk on first access.
+ */
+@property (nonnull, nonatomic, readonly) NSArray<NSData *> *partData;
+
+/**
+ @abstract The text of the push notification sent along with the message.
+ */
+@property (nullable, nonatomic, readonly) NSString *pushText;
+
+/**
+ @abstract The time the entry was enqueued.
+ */
+@property (nonnull, nonatomic, readonly) NSDate *enqueuedAt;
+
+/**
+ @abstract The number of failed attempts to send the entry since the outbox was created.
+ */
+@property (nonatomic, readonly) NSUInteger attemptCount;
+
+@end
+
+/**
+ @abstract The `ATLMOutboxTransport` protocol is adopted by the object
+   actually sending the messages, usually the layer controller.
+ */
+@protocol ATLMOutboxTransport <NSObject>
+
+/**
+ @abstract Sends an entry.
+ @param outbox The `ATLMOutbox` instance performing the invocation.
+ @param entry The entry to send.
+ @param error A reference to an error object describing the failure.
+ @return `YES` if the message has been handed over to the client; `NO` keeps
+   the entry queued and retries it later.
+ */
+- (BOOL)outbox:(nonnull ATLMOutbox *)outbox sendEntry:(nonnull ATLMOutboxEntry *)entry error:(NSError *_Nullable *_Nullable)error;
+
+@optional
+
+/**
+ @abstract Notifies the receiver an entry was dropped after `maximumAttemptCount` failed attempts.
+ @param outbox The `ATLMOutbox` instance performing the invocation.
+ @param entry The dropped entry.
+ @param error The error of the last attempt.
+ */
+- (void)outbox:(nonnull ATLMOutbox *)outbox didDiscardEntry:(nonnull ATLMOutboxEntry *)entry error:(nullable NSError *)error;
+
+/**
+ @abstract Asks the receiver whether entries can be sent at all, such as while no user is authenticated.
+ @discussion While it returns `NO`, entries stay queued without counting
+   attempts; the receiver calls `flush` once they can be sent again.
+   Defaults to `YES` when not implemented.
+ @param outbox The `ATLMOutbox` instance performing the invocation.
+ */
+- (BOOL)outboxCanSendEntries:(nonnull ATLMOutbox *)outbox;
+
+@end
+
+/**
+ @abstract The `ATLMOutbox` hands outgoing messages to the client and keeps
+   the ones the client refused until they can be retried.
+ @discussion Messages are handed over as soon as they are enqueued; the client
+   queues them itself while offline. Only refused entries are kept, and they
+   are journaled for crash recovery: the part contents are written to files next
+   to the journal and the journal records reference them. All journal I/O runs
+   on a background queue, and the journal is compacted once most of its records
+   are completed. A failed write, such as on a full disk, is logged and the
+   journal is rewritten from memory on the next record.
+
+   Messages to the same conversation are sent in the order they were enqueued:
+   a failed entry holds back the entries behind it, and the conversation is
+   retried with an exponential backoff. Other conversations are not affected.
+   Retries go out in batches of `batchSize`, yielding to the main queue in
+   between. All methods must be called on the main thread.
+ */
+@interface ATLMOutbox : NSObject
+
+/**
+ @abstract Creates an outbox restoring the entries journaled at `path`.
+ @param path The path of the journal file.
+ @param transport The object sending the entries.
+ @return A new `ATLMOutbox` instance.
+ */
++ (nonnull instancetype)outboxWithJournalPath:(nonnull NSString *)path transport:(nonnull id<ATLMOutboxTransport>)transport;
+
+/**
+ @abstract The object sending the entries.
+ */
+@property (nullable, nonatomic, weak, readonly) id<ATLMOutboxTransport> transport;
+
+/**
+ @abstract Whether the client is connected. Setting it to `YES` retries the pending entries right away.
+ */
+@property (nonatomic, getter=isConnected) BOOL connected;
+
+/**
+ @abstract The number of entries sent before yielding to the main queue. Defaults to 50.
+ */
+@property (nonatomic) NSUInteger batchSize;
+
+/**
+ @abstract The delay before the first retry of a conversation. Defaults to 1 second.
+ */
+@property (nonatomic) NSTimeInterval initialRetryInterval;
+
+/**
+ @abstract The longest delay between retries. Defaults to 60 seconds.
+ */
+@property (nonatomic) NSTimeInterval maximumRetryInterval;
+
+/**
+ @abstract The number of attempts after which an entry is dropped. Defaults to 10.
+ */
+@property (nonatomic) NSUInteger maximumAttemptCount;
+
+/**
+ @abstract Sends a message, journaling it if the client refuses it.
+ @param MIMETypes The MIME types of the message parts.
+ @param partData The contents of the message parts.
+ @param pushText The push notification text or `nil`.
+ @param conversationIdentifier The identifier of the conversation to send to.
+ @return The identifier of the new entry.
+ */
+- (nonnull NSString *)enqueueMessageWithMIMETypes:(nonnull NSArray<NSString *> *)MIMETypes partData:(nonnull NSArray<NSData *> *)partData pushText:(nullable NSString *)pushText conversationIdentifier:(nonnull NSURL *)conversationIdentifier;
+
+/**
+ @abstract Queues a message whose parts are read from streams, such as media
+   parts backed by files.
+ @discussion The streams are copied to part files on the journal queue first,
+   so the message survives a restart and can be retried; it's sent once they
+   are copied. A stream failing to copy discards the entry.
+ @param MIMETypes The MIME types of the message parts.
+ @param partStreams Unopened streams providing the contents of the message parts.
+ @param pushText The push notification text or `nil`.
+ @param conversationIdentifier The identifier of the conversation to send to.
+ @return The identifier of the new entry.
+ */
+- (nonnull NSString *)enqueueMessageWithMIMETypes:(nonnull NSArray<NSString *> *)MIMETypes partStreams:(nonnull NSArray<NSInputStream *> *)partStreams pushText:(nullable NSString *)pushText conversationIdentifier:(nonnull NSURL *)conversationIdentifier;
+
+/**
+ @abstract Starts sending the pending entries.
+ */
+- (void)flush;
+
+/**
+ @abstract Drops the pending entries along with their journal records and part files.
+ @discussion Called when the user logs out, so their messages aren't sent on behalf of the next user.
+ */
+- (void)removeAllEntries;
+
+/**
+ @abstract Returns `YES` if the entry with the supplied identifier has not been sent yet.
+ */
+- (BOOL)containsEntryWithIdentifier:(nonnull NSString *)identifier;
+
+///-----------------
+/// @name Metrics
+///-----------------
+
+/**
+ @abstract The number of entries waiting to be sent.
+ */
+@property (nonatomic, readonly) NSUInteger countOfPendingEntries;
+
+/**
+ @abstract The largest number of entries waiting at the same time.
+ */
+@property (nonatomic, readonly) NSUInteger maximumCountOfPendingEntries;
+
+/**
+ @abstract The number of entries sent.
+ */
+@property (nonatomic, readonly) NSUInteger countOfSentEntries;
+
+/**
+ @abstract The number of failed attempts.
+ */
+@property (nonatomic, readonly) NSUInteger countOfFailedAttempts;
+
+/**
+ @abstract The number of entries dropped after `maximumAttemptCount` attempts.
+ */
+@property (nonatomic, readonly) NSUInteger countOfDiscardedEntries;
+
+/**
+ @abstract The number of entries sent per second by the most recent flush,
+   measured from its first to its last batch.
+ */
+@property (nonatomic, readonly) double throughput;
+
+@end
@@ -0,0 +1,690 @@
+//
+//  ATLMOutbox.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMOutbox.h"
+
+static const NSUInteger ATLMOutboxDefaultBatchSize = 50;
+static const NSTimeInterval ATLMOutboxDefaultInitialRetryInterval = 1;
+static const NSTimeInterval ATLMOutboxDefaultMaximumRetryInterval = 60;
+static const NSUInteger ATLMOutboxDefaultMaximumAttemptCount = 10;
+static const NSUInteger ATLMOutboxMinimumCompactionRecordCount = 1000;
+
+static NSString *const ATLMOutboxRecordOperationKey = @"op";
+static NSString *const ATLMOutboxRecordOperationEnqueue = @"enqueue";
+static NSString *const ATLMOutboxRecordOperationComplete = @"complete";
+static NSString *const ATLMOutboxRecordIdentifierKey = @"identifier";
+static NSString *const ATLMOutboxRecordConversationIdentifierKey = @"conversation_identifier";
+static NSString *const ATLMOutboxRecordMIMETypesKey = @"mime_types";
+static NSString *const ATLMOutboxRecordPartFileNamesKey = @"part_files";
+static NSString *const ATLMOutboxRecordPushTextKey = @"push_text";
+static NSString *const ATLMOutboxRecordEnqueuedAtKey = @"enqueued_at";
+
+/**
+ @abstract Frames a journal record: a big endian length followed by the record
+   as a binary property list.
+ */
+static NSData *ATLMOutboxJournalFrame(NSDictionary *record)
+{
+    NSData *data = [NSPropertyListSerialization dataWithPropertyList:record format:NSPropertyListBinaryFormat_v1_0 options:0 error:nil];
+    uint32_t length = CFSwapInt32HostToBig((uint32_t)data.length);
+    NSMutableData *frame = [NSMutableData dataWithCapacity:sizeof(length) + data.length];
+    [frame appendBytes:&length length:sizeof(length)];
+    [frame appendData:data];
+    return frame;
+}
+
+/**
+ @abstract Copies the contents of an unopened stream to a file.
+ */
+static BOOL ATLMOutboxCopyStreamToFile(NSInputStream *inputStream, NSString *path)
+{
+    NSOutputStream *outputStream = [NSOutputStream outputStreamToFileAtPath:path append:NO];
+    [inputStream open];
+    [outputStream open];
+    BOOL success = YES;
+    uint8_t buffer[64 * 1024];
+    NSInteger length;
+    while (success && (length = [inputStream read:buffer maxLength:sizeof(buffer)]) > 0) {
+        NSInteger offset = 0;
+        while (offset < length) {
+            NSInteger written = [outputStream write:buffer + offset maxLength:length - offset];
+            if (written <= 0) {
+                success = NO;
+                break;
+            }
+            offset += written;
+        }
+    }
+    if (length < 0) {
+        success = NO;
+    }
+    [inputStream close];
+    [outputStream close];
+    return success;
+}
+
+static dispatch_queue_t ATLMOutboxJournalQueue()
+{
+    static dispatch_queue_t queue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        queue = dispatch_queue_create("com.layer.Atlas-Messenger.outbox-journal", DISPATCH_QUEUE_SERIAL);
+    });
+    return queue;
+}
+
+@interface ATLMOutboxEntry ()
+
+@property (nonnull, nonatomic, readwrite) NSString *identifier;
+@property (nonnull, nonatomic, readwrite) NSURL *conversationIdentifier;
+@property (nonnull, nonatomic, readwrite) NSArray<NSString *> *MIMETypes;
+@property (nullable, nonatomic, readwrite) NSString *pushText;
+@property (nonnull, nonatomic, readwrite) NSDate *enqueuedAt;
+@property (nonatomic, readwrite) NSUInteger attemptCount;
+@property (nullable, nonatomic) NSArray<NSData *> *loadedPartData;
+@property (nullable, nonatomic) NSArray<NSString *> *partPaths;
+@property (nonatomic, getter=isJournaled) BOOL journaled;
+@property (nonatomic, getter=isCopyingParts) BOOL copyingParts;  // Not sendable until its part streams are on disk.
+
+@end
+
+@implementation ATLMOutboxEntry
+
+- (NSArray *)partData
+{
+    if (!self.loadedPartData) {
+        // Restored entries map their parts from the files written when they were journaled.
+        NSMutableArray *partData = [NSMutableArray arrayWithCapacity:self.partPaths.count];
+        for (NSString *path in self.partPaths) {
+            [partData addObject:[NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nil] ?: [NSData data]];
+        }
+        self.loadedPartData = partData;
+    }
+    return self.loadedPartData;
+}
+
+- (NSDictionary *)journalRecordWithPartFileNames:(NSArray *)partFileNames
+{
+    NSMutableDictionary *record = [NSMutableDictionary dictionaryWithCapacity:7];
+    record[ATLMOutboxRecordOperationKey] = ATLMOutboxRecordOperationEnqueue;
+    record[ATLMOutboxRecordIdentifierKey] = self.identifier;
+    record[ATLMOutboxRecordConversationIdentifierKey] = self.conversationIdentifier.absoluteString;
+    record[ATLMOutboxRecordMIMETypesKey] = self.MIMETypes;
+    record[ATLMOutboxRecordPartFileNamesKey] = partFileNames;
+    record[ATLMOutboxRecordPushTextKey] = self.pushText;
+    record[ATLMOutboxRecordEnqueuedAtKey] = self.enqueuedAt;
+    return record;
+}
+
++ (instancetype)entryWithJournalRecord:(NSDictionary *)record partsDirectory:(NSString *)partsDirectory
+{
+    NSURL *conversationIdentifier = [NSURL URLWithString:record[ATLMOutboxRecordConversationIdentifierKey]];
+    NSArray *partFileNames = record[ATLMOutboxRecordPartFileNamesKey] ?: @[];
+    NSArray *MIMETypes = record[ATLMOutboxRecordMIMETypesKey] ?: @[];
+    if (!record[ATLMOutboxRecordIdentifierKey] || !conversationIdentifier || MIMETypes.count != partFileNames.count) {
+        return nil;
+    }
+    NSMutableArray *partPaths = [NSMutableArray arrayWithCapacity:partFileNames.count];
+    for (NSString *partFileName in partFileNames) {
+        [partPaths addObject:[partsDirectory stringByAppendingPathComponent:partFileName]];
+    }
+    ATLMOutboxEntry *entry = [self new];
+    entry.identifier = record[ATLMOutboxRecordIdentifierKey];
+    entry.conversationIdentifier = conversationIdentifier;
+    entry.MIMETypes = MIMETypes;
+    entry.partPaths = partPaths;
+    entry.pushText = record[ATLMOutboxRecordPushTextKey];
+    entry.enqueuedAt = record[ATLMOutboxRecordEnqueuedAtKey] ?: [NSDate date];
+    entry.journaled = YES;
+    return entry;
+}
+
+@end
+
+@interface ATLMOutbox ()
+
+@property (nonnull, nonatomic, copy) NSString *journalPath;
+@property (nonnull, nonatomic, copy) NSString *partsDirectory;
+@property (nullable, nonatomic, weak, readwrite) id<ATLMOutboxTransport> transport;
+@property (nonnull, nonatomic) NSMutableArray *pendingEntries;
+@property (nonnull, nonatomic) NSCountedSet *pendingConversationIdentifiers;
+@property (nonnull, nonatomic) NSMutableDictionary *failureCountsByConversationIdentifier;
+@property (nonnull, nonatomic) NSMutableDictionary *retryDatesByConversationIdentifier;
+@property (nonatomic, getter=isBatchScheduled) BOOL batchScheduled;
+@property (nonatomic) NSUInteger retryGeneration;
+@property (nullable, nonatomic) NSDate *flushStartedAt;
+@property (nonatomic) NSUInteger countOfSentEntriesBeforeFlush;
+@property (nonatomic, readwrite) NSUInteger maximumCountOfPendingEntries;
+@property (nonatomic, readwrite) NSUInteger countOfSentEntries;
+@property (nonatomic, readwrite) NSUInteger countOfFailedAttempts;
+@property (nonatomic, readwrite) NSUInteger countOfDiscardedEntries;
+@property (nonatomic, readwrite) double throughput;
+
+// Only accessed on the journal queue.
+@property (nullable, nonatomic) NSFileHandle *journalHandle;
+@property (nonnull, nonatomic) NSMutableOrderedSet *journaledIdentifiers;
+@property (nonnull, nonatomic) NSMutableDictionary *journalRecordsByIdentifier;
+@property (nonatomic) NSUInteger journalRecordCount;
+@property (nonatomic, getter=isJournalSynchronizationScheduled) BOOL journalSynchronizationScheduled;
+@property (nonatomic, getter=isJournalDamaged) BOOL journalDamaged;
+
+@end
+
+@implementation ATLMOutbox
+
++ (instancetype)outboxWithJournalPath:(NSString *)path transport:(id<ATLMOutboxTransport>)transport
+{
+    return [[self alloc] initWithJournalPath:path transport:transport];
+}
+
+- (id)initWithJournalPath:(NSString *)path transport:(id<ATLMOutboxTransport>)transport
+{
+    NSParameterAssert(path);
+    NSParameterAssert(transport);
+    self = [super init];
+    if (self) {
+        _journalPath = [path copy];
+        _partsDirectory = [[path stringByAppendingString:@"-parts"] copy];
+        _transport = transport;
+        _batchSize = ATLMOutboxDefaultBatchSize;
+        _initialRetryInterval = ATLMOutboxDefaultInitialRetryInterval;
+        _maximumRetryInterval = ATLMOutboxDefaultMaximumRetryInterval;
+        _maximumAttemptCount = ATLMOutboxDefaultMaximumAttemptCount;
+        _pendingEntries = [NSMutableArray new];
+        _pendingConversationIdentifiers = [NSCountedSet new];
+        _failureCountsByConversationIdentifier = [NSMutableDictionary new];
+        _retryDatesByConversationIdentifier = [NSMutableDictionary new];
+        _journaledIdentifiers = [NSMutableOrderedSet new];
+        _journalRecordsByIdentifier = [NSMutableDictionary new];
+
+        // The journal only holds metadata, so restoring it is quick; waiting
+        // on the queue also lets a previous outbox on the same path finish writing.
+        __block NSArray *entries;
+        dispatch_sync(ATLMOutboxJournalQueue(), ^{
+            entries = [self restoreJournal];
+        });
+        for (ATLMOutboxEntry *entry in entries) {
+            [self addPendingEntry:entry];
+        }
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use outboxWithJournalPath:transport:" userInfo:nil];
+}
+
+- (void)dealloc
+{
+    [_journalHandle closeFile];
+}
+
+#pragma mark - Public API
+
+- (void)setConnected:(BOOL)connected
+{
+    if (_connected == connected) {
+        return;
+    }
+    _connected = connected;
+    if (connected) {
+        // The lost connection is the likely cause of the recent failures.
+        [self.retryDatesByConversationIdentifier removeAllObjects];
+        [self.failureCountsByConversationIdentifier removeAllObjects];
+        [self flush];
+    }
+}
+
+- (NSString *)enqueueMessageWithMIMETypes:(NSArray *)MIMETypes partData:(NSArray *)partData pushText:(NSString *)pushText conversationIdentifier:(NSURL *)conversationIdentifier
+{
+    NSParameterAssert(MIMETypes.count == partData.count);
+    NSParameterAssert(conversationIdentifier);
+    ATLMOutboxEntry *entry = [ATLMOutboxEntry new];
+    entry.identifier = [NSUUID UUID].UUIDString;
+    entry.conversationIdentifier = conversationIdentifier;
+    entry.MIMETypes = [MIMETypes copy];
+    entry.loadedPartData = [partData copy];
+    entry.pushText = [pushText copy];
+    entry.enqueuedAt = [NSDate date];
+
+    // The client queues messages itself while offline, so hand the message
+    // over right away unless earlier messages to the conversation are held.
+    if (![self.pendingConversationIdentifiers containsObject:conversationIdentifier] && [self sendEntry:entry]) {
+        return entry.identifier;
+    }
+    // Only messages the client didn't take are journaled, for crash recovery.
+    [self addPendingEntry:entry];
+    [self journalEntry:entry];
+    [self scheduleRetryTimer];
+    return entry.identifier;
+}
+
+- (NSString *)enqueueMessageWithMIMETypes:(NSArray *)MIMETypes partStreams:(NSArray *)partStreams pushText:(NSString *)pushText conversationIdentifier:(NSURL *)conversationIdentifier
+{
+    NSParameterAssert(MIMETypes.count == partStreams.count);
+    NSParameterAssert(conversationIdentifier);
+    ATLMOutboxEntry *entry = [ATLMOutboxEntry new];
+    entry.identifier = [NSUUID UUID].UUIDString;
+    entry.conversationIdentifier = conversationIdentifier;
+    entry.MIMETypes = [MIMETypes copy];
+    entry.pushText = [pushText copy];
+    entry.enqueuedAt = [NSDate date];
+    entry.journaled = YES;
+    entry.copyingParts = YES;
+    // Queued right away, so later messages to the conversation wait for it.
+    [self addPendingEntry:entry];
+
+    dispatch_async(ATLMOutboxJournalQueue(), ^{
+        [[NSFileManager defaultManager] createDirectoryAtPath:self.partsDirectory withIntermediateDirectories:YES attributes:nil error:nil];
+        NSMutableArray *partFileNames = [NSMutableArray arrayWithCapacity:partStreams.count];
+        NSMutableArray *partPaths = [NSMutableArray arrayWithCapacity:partStreams.count];
+        for (NSUInteger index = 0; index < partStreams.count; index++) {
+            NSString *partFileName = [NSString stringWithFormat:@"%@.%lu", entry.identifier, (unsigned long)index];
+            NSString *partPath = [self.partsDirectory stringByAppendingPathComponent:partFileName];
+            if (!ATLMOutboxCopyStreamToFile(partStreams[index], partPath)) {
+                [self removePartFilesOfEntryWithIdentifier:entry.identifier count:index + 1];
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    [self removePendingEntry:entry];
+                    NSError *error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileWriteUnknownError userInfo:@{ NSLocalizedDescriptionKey: @"Failed to copy a message part to the outbox." }];
+                    [self discardEntry:entry error:error];
+                    // Release the messages queued behind it.
+                    [self flush];
+                });
+                return;
+            }
+            [partFileNames addObject:partFileName];
+            [partPaths addObject:partPath];
+        }
+        NSDictionary *record = [entry journalRecordWithPartFileNames:partFileNames];
+        [self.journaledIdentifiers addObject:entry.identifier];
+        self.journalRecordsByIdentifier[entry.identifier] = record;
+        [self appendJournalRecord:record];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            entry.partPaths = partPaths;
+            entry.copyingParts = NO;
+            if (![self.pendingEntries containsObject:entry]) {
+                // Removed while its parts were copied.
+                [self completeJournalEntry:entry];
+                return;
+            }
+            [self flush];
+        });
+    });
+    return entry.identifier;
+}
+
+- (void)flush
+{
+    if (self.isBatchScheduled || self.pendingEntries.count == 0) {
+        return;
+    }
+    if (!self.flushStartedAt) {
+        self.flushStartedAt = [NSDate date];
+        self.countOfSentEntriesBeforeFlush = self.countOfSentEntries;
+    }
+    self.batchScheduled = YES;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [self sendBatch];
+    });
+}
+
+- (void)removeAllEntries
+{
+    [self.pendingEntries removeAllObjects];
+    [self.pendingConversationIdentifiers removeAllObjects];
+    [self.failureCountsByConversationIdentifier removeAllObjects];
+    [self.retryDatesByConversationIdentifier removeAllObjects];
+    self.retryGeneration += 1;
+    dispatch_async(ATLMOutboxJournalQueue(), ^{
+        [self.journaledIdentifiers removeAllObjects];
+        [self.journalRecordsByIdentifier removeAllObjects];
+        [[NSFileManager defaultManager] removeItemAtPath:self.partsDirectory error:nil];
+        [self compactJournal];
+    });
+}
+
+- (void)synchronizeJournal
+{
+    dispatch_sync(ATLMOutboxJournalQueue(), ^{
+        [self.journalHandle synchronizeFile];
+    });
+}
+
+- (BOOL)containsEntryWithIdentifier:(NSString *)identifier
+{
+    for (ATLMOutboxEntry *entry in self.pendingEntries) {
+        if ([entry.identifier isEqualToString:identifier]) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+- (NSUInteger)countOfPendingEntries
+{
+    return self.pendingEntries.count;
+}
+
+#pragma mark - Sending
+
+- (void)addPendingEntry:(ATLMOutboxEntry *)entry
+{
+    [self.pendingEntries addObject:entry];
+    [self.pendingConversationIdentifiers addObject:entry.conversationIdentifier];
+    self.maximumCountOfPendingEntries = MAX(self.maximumCountOfPendingEntries, self.pendingEntries.count);
+}
+
+- (void)removePendingEntry:(ATLMOutboxEntry *)entry
+{
+    if (![self.pendingEntries containsObject:entry]) {
+        return;
+    }
+    [self.pendingEntries removeObject:entry];
+    [self.pendingConversationIdentifiers removeObject:entry.conversationIdentifier];
+}
+
+/**
+ @abstract Attempts to send the entry once.
+ @return `YES` if the entry is done with, either sent or discarded; `NO` if it has to be retried.
+ */
+- (BOOL)sendEntry:(ATLMOutboxEntry *)entry
+{
+    id<ATLMOutboxTransport> transport = self.transport;
+    if ([transport respondsToSelector:@selector(outboxCanSendEntries:)] && ![transport outboxCanSendEntries:self]) {
+        // Not an attempt; the transport flushes once it can send again.
+        return NO;
+    }
+    NSError *error;
+    if ([transport outbox:self sendEntry:entry error:&error]) {
+        self.countOfSentEntries += 1;
+        [self.failureCountsByConversationIdentifier removeObjectForKey:entry.conversationIdentifier];
+        [self.retryDatesByConversationIdentifier removeObjectForKey:entry.conversationIdentifier];
+        [self completeJournalEntry:entry];
+        return YES;
+    }
+    entry.attemptCount += 1;
+    self.countOfFailedAttempts += 1;
+    if (entry.attemptCount >= self.maximumAttemptCount) {
+        [self discardEntry:entry error:error];
+        return YES;
+    }
+    [self scheduleRetryOfConversationIdentifier:entry.conversationIdentifier];
+    return NO;
+}
+
+- (void)sendBatch
+{
+    self.batchScheduled = NO;
+    NSDate *now = [NSDate date];
+    NSMutableSet *heldConversationIdentifiers = [NSMutableSet new];
+    [self.retryDatesByConversationIdentifier enumerateKeysAndObjectsUsingBlock:^(NSURL *conversationIdentifier, NSDate *retryDate, BOOL *stop) {
+        if ([retryDate compare:now] == NSOrderedDescending) {
+            [heldConversationIdentifiers addObject:conversationIdentifier];
+        }
+    }];
+
+    NSMutableIndexSet *completedIndexes = [NSMutableIndexSet new];
+    NSUInteger attemptCount = 0;
+    BOOL batchFull = NO;
+    for (NSUInteger index = 0; index < self.pendingEntries.count; index++) {
+        if (attemptCount == self.batchSize) {
+            batchFull = YES;
+            break;
+        }
+        ATLMOutboxEntry *entry = self.pendingEntries[index];
+        // Keep the messages to the same conversation in order.
+        if ([heldConversationIdentifiers containsObject:entry.conversationIdentifier]) {
+            continue;
+        }
+        if (entry.isCopyingParts) {
+            [heldConversationIdentifiers addObject:entry.conversationIdentifier];
+            continue;
+        }
+        attemptCount += 1;
+        if ([self sendEntry:entry]) {
+            [completedIndexes addIndex:index];
+            [self.pendingConversationIdentifiers removeObject:entry.conversationIdentifier];
+        } else {
+            [heldConversationIdentifiers addObject:entry.conversationIdentifier];
+        }
+    }
+    [self.pendingEntries removeObjectsAtIndexes:completedIndexes];
+
+    if (batchFull) {
+        // Yield to the main queue before the next batch.
+        [self flush];
+        return;
+    }
+    NSUInteger sentCount = self.countOfSentEntries - self.countOfSentEntriesBeforeFlush;
+    NSTimeInterval duration = -[self.flushStartedAt timeIntervalSinceNow];
+    if (sentCount > 0 && duration > 0) {
+        self.throughput = sentCount / duration;
+    }
+    self.flushStartedAt = nil;
+    [self scheduleRetryTimer];
+}
+
+- (void)discardEntry:(ATLMOutboxEntry *)entry error:(NSError *)error
+{
+    NSLog(@"Discarding outbox entry %@ after %lu attempts: %@", entry.identifier, (unsigned long)entry.attemptCount, error);
+    self.countOfDiscardedEntries += 1;
+    [self completeJournalEntry:entry];
+    if ([self.transport respondsToSelector:@selector(outbox:didDiscardEntry:error:)]) {
+        [self.transport outbox:self didDiscardEntry:entry error:error];
+    }
+}
+
+- (void)scheduleRetryOfConversationIdentifier:(NSURL *)conversationIdentifier
+{
+    NSUInteger failureCount = [self.failureCountsByConversationIdentifier[conversationIdentifier] unsignedIntegerValue] + 1;
+    self.failureCountsByConversationIdentifier[conversationIdentifier] = @(failureCount);
+    NSTimeInterval interval = MIN(self.maximumRetryInterval, self.initialRetryInterval * pow(2, failureCount - 1));
+    // Jitter keeps the conversations from retrying in lockstep.
+    interval *= 0.8 + 0.4 * ((double)arc4random_uniform(1000) / 1000);
+    self.retryDatesByConversationIdentifier[conversationIdentifier] = [NSDate dateWithTimeIntervalSinceNow:interval];
+}
+
+- (void)scheduleRetryTimer
+{
+    NSDate *earliestRetryDate;
+    for (NSDate *retryDate in self.retryDatesByConversationIdentifier.allValues) {
+        earliestRetryDate = earliestRetryDate ? [earliestRetryDate earlierDate:retryDate] : retryDate;
+    }
+    if (!earliestRetryDate || self.pendingEntries.count == 0) {
+        return;
+    }
+    NSUInteger generation = ++self.retryGeneration;
+    NSTimeInterval delay = MAX(0, [earliestRetryDate timeIntervalSinceNow]);
+    __weak typeof(self) weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        if (weakSelf.retryGeneration == generation) {
+            [weakSelf flush];
+        }
+    });
+}
+
+#pragma mark - Journal
+
+- (void)journalEntry:(ATLMOutboxEntry *)entry
+{
+    entry.journaled = YES;
+    NSArray *partData = entry.partData;
+    dispatch_async(ATLMOutboxJournalQueue(), ^{
+        // Part contents go to files of their own, the journal only references them.
+        [[NSFileManager defaultManager] createDirectoryAtPath:self.partsDirectory withIntermediateDirectories:YES attributes:nil error:nil];
+        NSMutableArray *partFileNames = [NSMutableArray arrayWithCapacity:partData.count];
+        for (NSUInteger index = 0; index < partData.count; index++) {
+            NSString *partFileName = [NSString stringWithFormat:@"%@.%lu", entry.identifier, (unsigned long)index];
+            NSError *error;
+            if (![partData[index] writeToFile:[self.partsDirectory stringByAppendingPathComponent:partFileName] options:NSDataWritingAtomic error:&error]) {
+                NSLog(@"Failed to journal outbox entry %@, it won't survive a restart: %@", entry.identifier, error);
+                [self removePartFilesOfEntryWithIdentifier:entry.identifier count:index];
+                return;
+            }
+            [partFileNames addObject:partFileName];
+        }
+        NSDictionary *record = [entry journalRecordWithPartFileNames:partFileNames];
+        [self.journaledIdentifiers addObject:entry.identifier];
+        self.journalRecordsByIdentifier[entry.identifier] = record;
+        [self appendJournalRecord:record];
+    });
+}
+
+- (void)completeJournalEntry:(ATLMOutboxEntry *)entry
+{
+    if (!entry.isJournaled) {
+        return;
+    }
+    NSString *identifier = entry.identifier;
+    NSUInteger partCount = entry.MIMETypes.count;
+    dispatch_async(ATLMOutboxJournalQueue(), ^{
+        if (!self.journalRecordsByIdentifier[identifier]) {
+            // It never made it into the journal.
+            return;
+        }
+        [self.journaledIdentifiers removeObject:identifier];
+        [self.journalRecordsByIdentifier removeObjectForKey:identifier];
+        [self appendJournalRecord:@{ ATLMOutboxRecordOperationKey: ATLMOutboxRecordOperationComplete, ATLMOutboxRecordIdentifierKey: identifier }];
+        [self removePartFilesOfEntryWithIdentifier:identifier count:partCount];
+        if (self.journalRecordCount > MAX(ATLMOutboxMinimumCompactionRecordCount, 4 * self.journaledIdentifiers.count)) {
+            [self compactJournal];
+        }
+    });
+}
+
+- (void)removePartFilesOfEntryWithIdentifier:(NSString *)identifier count:(NSUInteger)count
+{
+    for (NSUInteger index = 0; index < count; index++) {
+        NSString *partFileName = [NSString stringWithFormat:@"%@.%lu", identifier, (unsigned long)index];
+        [[NSFileManager defaultManager] removeItemAtPath:[self.partsDirectory stringByAppendingPathComponent:partFileName] error:nil];
+    }
+}
+
+- (NSArray *)restoreJournal
+{
+    NSData *journal = [NSData dataWithContentsOfFile:self.journalPath options:NSDataReadingMappedIfSafe error:nil];
+    const uint8_t *bytes = journal.bytes;
+    NSUInteger offset = 0;
+    while (offset + sizeof(uint32_t) <= journal.length) {
+        uint32_t length;
+        memcpy(&length, bytes + offset, sizeof(length));
+        length = CFSwapInt32BigToHost(length);
+        if (offset + sizeof(uint32_t) + length > journal.length) {
+            // A record torn by termination during the write; it was never acknowledged.
+            break;
+        }
+        NSData *data = [journal subdataWithRange:NSMakeRange(offset + sizeof(uint32_t), length)];
+        offset += sizeof(uint32_t) + length;
+        NSDictionary *record = [NSPropertyListSerialization propertyListWithData:data options:NSPropertyListImmutable format:NULL error:nil];
+        NSString *identifier = record[ATLMOutboxRecordIdentifierKey];
+        if (!identifier) {
+            continue;
+        }
+        if ([record[ATLMOutboxRecordOperationKey] isEqualToString:ATLMOutboxRecordOperationEnqueue]) {
+            [self.journaledIdentifiers addObject:identifier];
+            self.journalRecordsByIdentifier[identifier] = record;
+        } else if ([record[ATLMOutboxRecordOperationKey] isEqualToString:ATLMOutboxRecordOperationComplete]) {
+            [self.journaledIdentifiers removeObject:identifier];
+            [self.journalRecordsByIdentifier removeObjectForKey:identifier];
+        }
+    }
+
+    NSMutableArray *entries = [NSMutableArray arrayWithCapacity:self.journaledIdentifiers.count];
+    NSMutableSet *partFileNames = [NSMutableSet new];
+    for (NSString *identifier in [self.journaledIdentifiers copy]) {
+        NSDictionary *record = self.journalRecordsByIdentifier[identifier];
+        ATLMOutboxEntry *entry = [ATLMOutboxEntry entryWithJournalRecord:record partsDirectory:self.partsDirectory];
+        if (!entry) {
+            [self.journaledIdentifiers removeObject:identifier];
+            [self.journalRecordsByIdentifier removeObjectForKey:identifier];
+            continue;
+        }
+        [entries addObject:entry];
+        [partFileNames addObjectsFromArray:record[ATLMOutboxRecordPartFileNamesKey]];
+    }
+    // Parts of entries whose record never made it to disk.
+    for (NSString *fileName in [[NSFileManager defaultManager] contentsOfDirectoryAtPath:self.partsDirectory error:nil]) {
+        if (![partFileNames containsObject:fileName]) {
+            [[NSFileManager defaultManager] removeItemAtPath:[self.partsDirectory stringByAppendingPathComponent:fileName] error:nil];
+        }
+    }
+    // Start over with a journal of only the pending entries, which also drops a torn tail.
+    [self compactJournal];
+    return entries;
+}
+
+- (void)appendJournalRecord:(NSDictionary *)record
+{
+    if (!self.journalHandle) {
+        self.journalDamaged = YES;
+    }
+    if (!self.isJournalDamaged) {
+        @try {
+            [self.journalHandle writeData:ATLMOutboxJournalFrame(record)];
+            self.journalRecordCount += 1;
+        } @catch (NSException *exception) {
+            // Raised when the disk is full; the journal may now end in a torn record.
+            NSLog(@"Failed to append to the outbox journal at %@: %@", self.journalPath, exception.reason);
+            self.journalDamaged = YES;
+        }
+    }
+    if (self.isJournalDamaged) {
+        // Rewriting the journal from the records drops the torn tail, once there is space again.
+        [self compactJournal];
+        return;
+    }
+    if (self.isJournalSynchronizationScheduled) {
+        return;
+    }
+    // Flush the journal to disk once per burst of records rather than per record.
+    self.journalSynchronizationScheduled = YES;
+    dispatch_async(ATLMOutboxJournalQueue(), ^{
+        self.journalSynchronizationScheduled = NO;
+        @try {
+            [self.journalHandle synchronizeFile];
+        } @catch (NSException *exception) {
+            NSLog(@"Failed to synchronize the outbox journal at %@: %@", self.journalPath, exception.reason);
+        }
+    });
+}
+
+- (void)compactJournal
+{
+    NSMutableData *journal = [NSMutableData new];
+    for (NSString *identifier in self.journaledIdentifiers) {
+        [journal appendData:ATLMOutboxJournalFrame(self.journalRecordsByIdentifier[identifier])];
+    }
+    [self.journalHandle closeFile];
+    self.journalHandle = nil;
+    [[NSFileManager defaultManager] createDirectoryAtPath:[self.journalPath stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:nil];
+    NSError *error;
+    if (![journal writeToFile:self.journalPath options:NSDataWritingAtomic error:&error]) {
+        NSLog(@"Failed to compact the outbox journal at %@: %@", self.journalPath, error);
+        self.journalDamaged = YES;
+        return;
+    }
+    self.journalDamaged = NO;
+    self.journalHandle = [NSFileHandle fileHandleForWritingAtPath:self.journalPath];
+    [self.journalHandle seekToEndOfFile];
+    self.journalRecordCount = self.journaledIdentifiers.count;
+}
+
+@end
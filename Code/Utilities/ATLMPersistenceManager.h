@@ -0,0 +1,112 @@
+//
+//  ATLMPersistenceManager.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import "ATLMSession.h"
+
+/**
+ @abstract The `ATLMPersistenceManager` stores the authenticated session and
+   the known users.
+ @discussion Objects are archived into binary property lists. The on-disk
+   manager answers reads from the archives waiting to be written, or else
+   from the file, so the caller sees its own writes right away. Writes are
+   performed behind the caller on a serial queue: the writes arriving within
+   `writeBehindInterval` are flushed as one batch, each archive written to a
+   temporary file, synchronized and renamed over the previous one, and the
+   directory synchronized once for the whole batch. Pending writes are also
+   flushed when the application enters the background.
+
+   The in-memory manager keeps the archives in a dictionary and is meant for
+   tests. The managers are safe to use from any thread.
+ */
+@interface ATLMPersistenceManager : NSObject
+
+///-------------------------------------
+/// @name Creating a Persistence Manager
+///-------------------------------------
+
+/**
+ @abstract Returns the persistence manager the application uses.
+ @discussion The manager is on-disk, in the application data directory,
+   except while running tests, where it is a new in-memory manager.
+ */
++ (nonnull instancetype)defaultManager;
+
+/**
+ @abstract Creates a manager storing its archives in the directory, which is created if needed.
+ */
++ (nonnull instancetype)persistenceManagerWithDirectory:(nonnull NSString *)directory;
+
++ (nonnull instancetype)inMemoryPersistenceManager;
+
+/**
+ @abstract The time writes are held back to be flushed together. Defaults to 0.5 seconds.
+ */
+@property (nonatomic) NSTimeInterval writeBehindInterval;
+
+///--------------------
+/// @name Users
+///--------------------
+
+/**
+ @abstract Replaces the persisted users.
+ @return `NO` with an error if the users couldn't be archived.
+ */
+- (BOOL)persistUsers:(nonnull NSSet<ATLMUser *> *)users error:(NSError *_Nullable *_Nullable)error;
+
+/**
+ @abstract Returns the persisted users or `nil` without an error if none were.
+ */
+- (nullable NSSet<ATLMUser *> *)persistedUsersWithError:(NSError *_Nullable *_Nullable)error;
+
+///--------------------
+/// @name Session
+///--------------------
+
+/**
+ @abstract Replaces the persisted session or removes it if `session` is `nil`.
+ */
+- (BOOL)persistSession:(nullable ATLMSession *)session error:(NSError *_Nullable *_Nullable)error;
+
+/**
+ @abstract Returns the persisted session or `nil` without an error if none was.
+ */
+- (nullable ATLMSession *)persistedSessionWithError:(NSError *_Nullable *_Nullable)error;
+
+/**
+ @abstract Removes the persisted session and users.
+ */
+- (BOOL)deleteAllObjects:(NSError *_Nullable *_Nullable)error;
+
+///--------------------
+/// @name Writing
+///--------------------
+
+/**
+ @abstract Writes the pending archives to disk and returns once they are synchronized.
+ */
+- (void)flush;
+
+/**
+ @abstract The number of batches written to disk.
+ */
+@property (nonatomic, readonly) NSUInteger countOfFlushedBatches;
+
+@end
@@ -0,0 +1,296 @@
+//
+//  ATLMPersistenceManager.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMPersistenceManager.h"
+#import <UIKit/UIKit.h>
+#import <pthread.h>
+#import <fcntl.h>
+#import <unistd.h>
+#import "ATLMErrors.h"
+#import "ATLMUtilities.h"
+
+static NSString *const ATLMPersistenceSessionFileName = @"Session.plist";
+static NSString *const ATLMPersistenceUsersFileName = @"Users.plist";
+static NSString *const ATLMPersistenceTemporaryFileExtension = @"tmp";
+static const NSTimeInterval ATLMPersistenceManagerDefaultWriteBehindInterval = 0.5;
+
+static BOOL ATLMSynchronizeFileDescriptor(int fileDescriptor)
+{
+    // On Darwin fsync() leaves the data in the drive's cache; F_FULLFSYNC doesn't.
+    return fcntl(fileDescriptor, F_FULLFSYNC) == 0 || fsync(fileDescriptor) == 0;
+}
+
+static BOOL ATLMWriteFileSynchronized(NSString *path, NSData *data)
+{
+    NSString *temporaryPath = [path stringByAppendingPathExtension:ATLMPersistenceTemporaryFileExtension];
+    int fileDescriptor = open(temporaryPath.fileSystemRepresentation, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fileDescriptor < 0) {
+        return NO;
+    }
+    const uint8_t *bytes = data.bytes;
+    size_t remaining = data.length;
+    while (remaining > 0) {
+        ssize_t written = write(fileDescriptor, bytes, remaining);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0) {
+            close(fileDescriptor);
+            unlink(temporaryPath.fileSystemRepresentation);
+            return NO;
+        }
+        bytes += written;
+        remaining -= written;
+    }
+    BOOL synchronized = ATLMSynchronizeFileDescriptor(fileDescriptor);
+    close(fileDescriptor);
+    // The rename replaces the previous archive atomically; readers see either one in full.
+    if (!synchronized || rename(temporaryPath.fileSystemRepresentation, path.fileSystemRepresentation) != 0) {
+        unlink(temporaryPath.fileSystemRepresentation);
+        return NO;
+    }
+    return YES;
+}
+
+@interface ATLMPersistenceManager () {
+    pthread_mutex_t _lock;
+}
+
+@property (nullable, nonatomic, copy) NSString *directory;
+@property (nonnull, nonatomic) dispatch_queue_t writeQueue;
+
+/**
+ @abstract The archives waiting to be written by file name, `NSNull` for a
+   removal. Holds all of the archives of an in-memory manager.
+ */
+@property (nonnull, nonatomic) NSMutableDictionary<NSString *, id> *pendingArchives;
+
+/**
+ @abstract The archives of the batch being written, still served to readers.
+ */
+@property (nullable, nonatomic) NSDictionary<NSString *, id> *flushingArchives;
+@property (nonatomic) BOOL flushScheduled;
+@property (nonatomic, readwrite) NSUInteger countOfFlushedBatches;
+
+@end
+
+@implementation ATLMPersistenceManager
+
++ (instancetype)defaultManager
+{
+    if (ATLMIsRunningTests()) {
+        return [self inMemoryPersistenceManager];
+    }
+    static ATLMPersistenceManager *defaultManager;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        defaultManager = [[self alloc] initWithDirectory:ATLMApplicationDataDirectory()];
+    });
+    return defaultManager;
+}
+
++ (instancetype)persistenceManagerWithDirectory:(NSString *)directory
+{
+    NSParameterAssert(directory);
+    return [[self alloc] initWithDirectory:directory];
+}
+
++ (instancetype)inMemoryPersistenceManager
+{
+    return [[self alloc] initWithDirectory:nil];
+}
+
+- (id)initWithDirectory:(NSString *)directory
+{
+    self = [super init];
+    if (self) {
+        pthread_mutex_init(&_lock, NULL);
+        _directory = [directory copy];
+        _writeBehindInterval = ATLMPersistenceManagerDefaultWriteBehindInterval;
+        _pendingArchives = [NSMutableDictionary new];
+        if (directory) {
+            [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil];
+            _writeQueue = dispatch_queue_create("com.layer.Atlas-Messenger.persistence-manager", DISPATCH_QUEUE_SERIAL);
+            [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(flush) name:UIApplicationDidEnterBackgroundNotification object:nil];
+            [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(flush) name:UIApplicationWillTerminateNotification object:nil];
+        }
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use defaultManager, persistenceManagerWithDirectory: or inMemoryPersistenceManager" userInfo:nil];
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    pthread_mutex_destroy(&_lock);
+}
+
+#pragma mark - Users
+
+- (BOOL)persistUsers:(NSSet<ATLMUser *> *)users error:(NSError **)error
+{
+    NSParameterAssert(users);
+    return [self persistObject:users fileName:ATLMPersistenceUsersFileName error:error];
+}
+
+- (NSSet<ATLMUser *> *)persistedUsersWithError:(NSError **)error
+{
+    return [self persistedObjectOfClasses:[NSSet setWithObjects:[NSSet class], [ATLMUser class], nil] fileName:ATLMPersistenceUsersFileName error:error];
+}
+
+#pragma mark - Session
+
+- (BOOL)persistSession:(ATLMSession *)session error:(NSError **)error
+{
+    return [self persistObject:session fileName:ATLMPersistenceSessionFileName error:error];
+}
+
+- (ATLMSession *)persistedSessionWithError:(NSError **)error
+{
+    return [self persistedObjectOfClasses:[NSSet setWithObject:[ATLMSession class]] fileName:ATLMPersistenceSessionFileName error:error];
+}
+
+- (BOOL)deleteAllObjects:(NSError **)error
+{
+    return [self persistObject:nil fileName:ATLMPersistenceSessionFileName error:error] && [self persistObject:nil fileName:ATLMPersistenceUsersFileName error:error];
+}
+
+#pragma mark - Archives
+
+- (BOOL)persistObject:(id<NSSecureCoding>)object fileName:(NSString *)fileName error:(NSError **)error
+{
+    id archive = [NSNull null];
+    if (object) {
+        NSMutableData *data = [NSMutableData data];
+        @try {
+            NSKeyedArchiver *archiver = [[NSKeyedArchiver alloc] initForWritingWithMutableData:data];
+            archiver.outputFormat = NSPropertyListBinaryFormat_v1_0;
+            archiver.requiresSecureCoding = YES;
+            [archiver encodeObject:object forKey:NSKeyedArchiveRootObjectKey];
+            [archiver finishEncoding];
+        } @catch (NSException *exception) {
+            if (error) {
+                *error = [NSError errorWithDomain:ATLMErrorDomain code:ATLMPersistenceEncodingFailed userInfo:@{ NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Failed to archive %@: %@", fileName, exception.reason] }];
+            }
+            return NO;
+        }
+        archive = data;
+    }
+
+    pthread_mutex_lock(&_lock);
+    if (!self.directory && archive == [NSNull null]) {
+        [self.pendingArchives removeObjectForKey:fileName];
+    } else {
+        self.pendingArchives[fileName] = archive;
+    }
+    BOOL shouldScheduleFlush = self.directory && !self.flushScheduled;
+    if (shouldScheduleFlush) {
+        self.flushScheduled = YES;
+    }
+    pthread_mutex_unlock(&_lock);
+
+    if (shouldScheduleFlush) {
+        // Holds on to the manager until its writes are on disk.
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.writeBehindInterval * NSEC_PER_SEC)), self.writeQueue, ^{
+            [self flushPendingArchives];
+        });
+    }
+    return YES;
+}
+
+- (id)persistedObjectOfClasses:(NSSet<Class> *)classes fileName:(NSString *)fileName error:(NSError **)error
+{
+    pthread_mutex_lock(&_lock);
+    id archive = self.pendingArchives[fileName] ?: self.flushingArchives[fileName];
+    pthread_mutex_unlock(&_lock);
+    if (!archive && self.directory) {
+        archive = [NSData dataWithContentsOfFile:[self.directory stringByAppendingPathComponent:fileName] options:NSDataReadingMappedIfSafe error:nil];
+    }
+    if (!archive || archive == [NSNull null]) {
+        return nil;
+    }
+
+    id object;
+    @try {
+        NSKeyedUnarchiver *unarchiver = [[NSKeyedUnarchiver alloc] initForReadingWithData:archive];
+        unarchiver.requiresSecureCoding = YES;
+        object = [unarchiver decodeObjectOfClasses:classes forKey:NSKeyedArchiveRootObjectKey];
+        [unarchiver finishDecoding];
+    } @catch (NSException *exception) {
+        object = nil;
+    }
+    if (!object && error) {
+        *error = [NSError errorWithDomain:ATLMErrorDomain code:ATLMPersistenceDecodingFailed userInfo:@{ NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Failed to unarchive %@", fileName] }];
+    }
+    return object;
+}
+
+#pragma mark - Writing
+
+- (void)flush
+{
+    if (!self.directory) {
+        return;
+    }
+    dispatch_sync(self.writeQueue, ^{
+        [self flushPendingArchives];
+    });
+}
+
+- (void)flushPendingArchives
+{
+    pthread_mutex_lock(&_lock);
+    NSDictionary *archives = [self.pendingArchives copy];
+    [self.pendingArchives removeAllObjects];
+    self.flushingArchives = archives;
+    self.flushScheduled = NO;
+    pthread_mutex_unlock(&_lock);
+    if (archives.count == 0) {
+        return;
+    }
+
+    [archives enumerateKeysAndObjectsUsingBlock:^(NSString *fileName, id archive, BOOL *stop) {
+        NSString *path = [self.directory stringByAppendingPathComponent:fileName];
+        if (archive == [NSNull null]) {
+            if (unlink(path.fileSystemRepresentation) != 0 && errno != ENOENT) {
+                NSLog(@"Failed to remove %@ with errno %d", path, errno);
+            }
+        } else if (!ATLMWriteFileSynchronized(path, archive)) {
+            NSLog(@"Failed to write %@ with errno %d", path, errno);
+        }
+    }];
+    // One synchronization of the directory makes the renames of the whole batch durable.
+    int directoryDescriptor = open(self.directory.fileSystemRepresentation, O_RDONLY);
+    if (directoryDescriptor >= 0) {
+        ATLMSynchronizeFileDescriptor(directoryDescriptor);
+        close(directoryDescriptor);
+    }
+
+    pthread_mutex_lock(&_lock);
+    self.flushingArchives = nil;
+    self.countOfFlushedBatches += 1;
+    pthread_mutex_unlock(&_lock);
+}
+
+@end
@@ -0,0 +1,101 @@
+//
+//  ATLMProgressChannel.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import <LayerKit/LayerKit.h>
+
+/**
+ @abstract Called on the main thread with the latest fraction of a transfer.
+ @param finished `YES` the last time the handler is called for the transfer.
+ */
+typedef void (^ATLMProgressHandler)(double fractionCompleted, BOOL finished);
+
+/**
+ @abstract The progress of a single transfer, written from any thread.
+ @discussion Writes only store into atomic slots and never block or
+   enqueue work; the channel picks up the latest values on its next frame.
+   As an `LYRProgressDelegate`, the slot can be the delegate of the progress
+   returned by `downloadContent:`.
+ */
+@interface ATLMProgressSlot : NSObject <LYRProgressDelegate>
+
+/**
+ @abstract Stores the fraction; earlier values not yet delivered are dropped.
+ */
+- (void)updateFractionCompleted:(double)fractionCompleted;
+
+/**
+ @abstract Marks the transfer as finished; its handler is called one last time.
+ */
+- (void)finish;
+
+@end
+
+/**
+ @abstract The `ATLMProgressChannel` delivers transfer progress to the main
+   thread at most once per frame, however often the transfers report it.
+ @discussion `LYRProgress` calls its delegate from a background thread for
+   every tick and KVO notifications of a part's `transferStatus` arrive on
+   background threads too; hopping to the main queue for each of them floods
+   it when several downloads run at once. The channel instead samples its
+   slots from a display link while any slot is active and calls the handlers
+   of those which changed, so main thread work is bounded by the frame rate.
+   Slots are created and removed on the main thread.
+ */
+@interface ATLMProgressChannel : NSObject
+
+/**
+ @abstract The channel shared by the application's screens.
+ */
++ (nonnull instancetype)sharedChannel;
+
++ (nonnull instancetype)channel;
+
+/**
+ @abstract Creates a slot whose changes are delivered to `handler`.
+ */
+- (nonnull ATLMProgressSlot *)slotWithHandler:(nonnull ATLMProgressHandler)handler;
+
+/**
+ @abstract Creates a slot and makes it the delegate of `progress`.
+ */
+- (nonnull ATLMProgressSlot *)slotObservingProgress:(nonnull LYRProgress *)progress handler:(nonnull ATLMProgressHandler)handler;
+
+/**
+ @abstract Stops delivering the slot's changes. Finished slots are removed automatically.
+ */
+- (void)removeSlot:(nonnull ATLMProgressSlot *)slot;
+
+/**
+ @abstract The number of slots which have not finished or been removed.
+ */
+@property (nonatomic, readonly) NSUInteger countOfActiveSlots;
+
+/**
+ @abstract The number of frames the channel sampled its slots on.
+ */
+@property (nonatomic, readonly) NSUInteger countOfFrames;
+
+/**
+ @abstract The number of times a handler was called.
+ */
+@property (nonatomic, readonly) NSUInteger countOfDeliveries;
+
+@end
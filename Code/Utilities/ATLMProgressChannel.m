@@ -0,0 +1,182 @@
+//
+//  ATLMProgressChannel.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMProgressChannel.h"
+#import <QuartzCore/QuartzCore.h>
+#import <stdatomic.h>
+
+@interface ATLMProgressSlot ()
+
+@property (nonatomic, copy) ATLMProgressHandler handler;
+
+@end
+
+@implementation ATLMProgressSlot {
+    // The fraction's bit pattern, since doubles can't be atomic on every architecture.
+    _Atomic(uint64_t) _fractionBits;
+    atomic_bool _pending;
+    atomic_bool _finished;
+}
+
+- (void)updateFractionCompleted:(double)fractionCompleted
+{
+    uint64_t fractionBits;
+    memcpy(&fractionBits, &fractionCompleted, sizeof(fractionBits));
+    atomic_store_explicit(&_fractionBits, fractionBits, memory_order_relaxed);
+    atomic_store_explicit(&_pending, true, memory_order_release);
+}
+
+- (void)finish
+{
+    atomic_store_explicit(&_finished, true, memory_order_relaxed);
+    atomic_store_explicit(&_pending, true, memory_order_release);
+}
+
+/**
+ @abstract Reads the latest values if they changed since the last call. Main thread only.
+ */
+- (BOOL)takeFractionCompleted:(double *)fractionCompleted finished:(BOOL *)finished
+{
+    if (!atomic_exchange_explicit(&_pending, false, memory_order_acquire)) {
+        return NO;
+    }
+    uint64_t fractionBits = atomic_load_explicit(&_fractionBits, memory_order_relaxed);
+    memcpy(fractionCompleted, &fractionBits, sizeof(fractionBits));
+    *finished = atomic_load_explicit(&_finished, memory_order_relaxed);
+    return YES;
+}
+
+#pragma mark - LYRProgressDelegate
+
+- (void)progressDidChange:(LYRProgress *)progress
+{
+    [self updateFractionCompleted:progress.fractionCompleted];
+}
+
+@end
+
+@interface ATLMProgressChannel ()
+
+@property (nonnull, nonatomic) NSMutableArray *slots;
+@property (nullable, nonatomic) CADisplayLink *displayLink;
+@property (nonatomic, readwrite) NSUInteger countOfFrames;
+@property (nonatomic, readwrite) NSUInteger countOfDeliveries;
+
+@end
+
+@implementation ATLMProgressChannel
+
++ (instancetype)sharedChannel
+{
+    static ATLMProgressChannel *sharedChannel;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedChannel = [self channel];
+    });
+    return sharedChannel;
+}
+
++ (instancetype)channel
+{
+    return [[self alloc] init];
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self) {
+        _slots = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [_displayLink invalidate];
+}
+
+#pragma mark - Slots
+
+- (ATLMProgressSlot *)slotWithHandler:(ATLMProgressHandler)handler
+{
+    NSParameterAssert(handler);
+    ATLMProgressSlot *slot = [ATLMProgressSlot new];
+    slot.handler = handler;
+    [self.slots addObject:slot];
+    if (!self.displayLink) {
+        // The display link retains the channel; it only runs while slots are active.
+        self.displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(displayLinkDidFire:)];
+        [self.displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+    }
+    return slot;
+}
+
+- (ATLMProgressSlot *)slotObservingProgress:(LYRProgress *)progress handler:(ATLMProgressHandler)handler
+{
+    ATLMProgressSlot *slot = [self slotWithHandler:handler];
+    progress.delegate = slot;
+    return slot;
+}
+
+- (void)removeSlot:(ATLMProgressSlot *)slot
+{
+    [self.slots removeObjectIdenticalTo:slot];
+    [self stopIfIdle];
+}
+
+- (NSUInteger)countOfActiveSlots
+{
+    return self.slots.count;
+}
+
+#pragma mark - Delivery
+
+- (void)displayLinkDidFire:(CADisplayLink *)displayLink
+{
+    self.countOfFrames += 1;
+    // Handlers may add or remove slots.
+    for (ATLMProgressSlot *slot in [self.slots copy]) {
+        if ([self.slots indexOfObjectIdenticalTo:slot] == NSNotFound) {
+            continue;
+        }
+        double fractionCompleted;
+        BOOL finished;
+        if (![slot takeFractionCompleted:&fractionCompleted finished:&finished]) {
+            continue;
+        }
+        if (finished) {
+            [self.slots removeObjectIdenticalTo:slot];
+        }
+        self.countOfDeliveries += 1;
+        slot.handler(fractionCompleted, finished);
+    }
+    [self stopIfIdle];
+}
+
+- (void)stopIfIdle
+{
+    if (self.slots.count || !self.displayLink) {
+        return;
+    }
+    [self.displayLink invalidate];
+    self.displayLink = nil;
+}
+
+@end
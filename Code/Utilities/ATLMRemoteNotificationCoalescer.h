@@ -0,0 +1,113 @@
+//
+//  ATLMRemoteNotificationCoalescer.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+@class LYRConversation;
+@class LYRMessage;
+
+/**
+ @abstract The amount of time iOS grants the application to call the fetch
+   completion handler of a remote notification.
+ */
+extern const NSTimeInterval ATLMRemoteNotificationBackgroundFetchTimeLimit;
+
+/**
+ @abstract Extracts the Layer conversation identifier from a remote notification payload.
+ @param userInfo The remote notification dictionary.
+ @return The conversation identifier or `nil` if the payload does not carry one.
+ */
+extern NSURL *_Nullable ATLMConversationIdentifierFromRemoteNotification(NSDictionary *_Nonnull userInfo);
+
+typedef void (^ATLMRemoteNotificationCompletion)(LYRConversation *_Nullable conversation, LYRMessage *_Nullable message, NSError *_Nullable error);
+
+/**
+ @abstract A block performing a single synchronization for a remote notification payload.
+ @return `YES` if the payload was meant for the synchronizing client (in which
+   case `completion` must eventually be called), `NO` otherwise.
+ */
+typedef BOOL (^ATLMRemoteNotificationSynchronizationBlock)(NSDictionary *_Nonnull userInfo, ATLMRemoteNotificationCompletion _Nonnull completion);
+
+/**
+ @abstract The `ATLMRemoteNotificationCoalescer` groups remote notifications
+   arriving within a short window into a single synchronization per conversation
+   and completes all of the pending fetch handlers together.
+ @discussion A burst of pushes from a busy conversation would otherwise wake
+   the application once per push and run a synchronization for each of them.
+   The coalescer keeps the latest payload for each conversation and passes it
+   to the synchronization block once the window elapses. Every handler is
+   accounted against the background fetch time limit and is completed with an
+   `ATLMRemoteNotificationBackgroundTimeExpired` error if the synchronization
+   does not finish in time. All methods must be called on the main thread.
+ */
+@interface ATLMRemoteNotificationCoalescer : NSObject
+
+/**
+ @abstract Creates a coalescer which performs the synchronizations with the supplied block.
+ @param synchronizationBlock The block performing the synchronization for a payload.
+ @return A new `ATLMRemoteNotificationCoalescer` instance.
+ */
++ (nonnull instancetype)coalescerWithSynchronizationBlock:(nonnull ATLMRemoteNotificationSynchronizationBlock)synchronizationBlock;
+
+/**
+ @abstract The time the coalescer waits after the first remote notification of a
+   batch before it starts the synchronization. Defaults to 0.5 seconds.
+ */
+@property (nonatomic) NSTimeInterval coalescingWindow;
+
+/**
+ @abstract The time, measured from the arrival of a remote notification, after
+   which its completion handler is called regardless of the synchronization
+   state. Defaults to `ATLMRemoteNotificationBackgroundFetchTimeLimit` minus a
+   safety margin.
+ */
+@property (nonatomic) NSTimeInterval backgroundTimeBudget;
+
+/**
+ @abstract Enqueues a remote notification for the next synchronization batch.
+ @param userInfo The remote notification dictionary.
+ @param completion A block called once the synchronization covering the payload
+   completes or the background time budget runs out.
+ */
+- (void)enqueueRemoteNotification:(nonnull NSDictionary *)userInfo completion:(nonnull ATLMRemoteNotificationCompletion)completion;
+
+/**
+ @abstract The number of remote notifications whose handlers have not been called yet.
+ */
+@property (nonatomic, readonly) NSUInteger countOfPendingRemoteNotifications;
+
+/**
+ @abstract The number of synchronizations performed by the coalescer.
+ */
+@property (nonatomic, readonly) NSUInteger countOfSynchronizations;
+
+/**
+ @abstract The number of remote notifications which were merged into the
+   pending payload of the same conversation instead of getting a
+   synchronization of their own.
+ */
+@property (nonatomic, readonly) NSUInteger countOfCoalescedRemoteNotifications;
+
+/**
+ @abstract The number of handlers completed because the background time budget ran out.
+ */
+@property (nonatomic, readonly) NSUInteger countOfExpiredRemoteNotifications;
+
+@end
@@ -0,0 +1,259 @@
+//
+//  ATLMRemoteNotificationCoalescer.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMRemoteNotificationCoalescer.h"
+#import "ATLMErrors.h"
+
+const NSTimeInterval ATLMRemoteNotificationBackgroundFetchTimeLimit = 30.0;
+static const NSTimeInterval ATLMRemoteNotificationBackgroundTimeSafetyMargin = 5.0;
+static const NSTimeInterval ATLMRemoteNotificationDefaultCoalescingWindow = 0.5;
+
+NSURL *ATLMConversationIdentifierFromRemoteNotification(NSDictionary *userInfo)
+{
+    NSDictionary *layer = userInfo[@"layer"];
+    if (![layer isKindOfClass:[NSDictionary class]]) {
+        return nil;
+    }
+    NSString *identifier = layer[@"conversation_identifier"];
+    if (![identifier isKindOfClass:[NSString class]]) {
+        return nil;
+    }
+    return [NSURL URLWithString:identifier];
+}
+
+@interface ATLMRemoteNotificationEntry : NSObject
+
+@property (nonatomic) id conversationKey;
+@property (nonatomic, copy) ATLMRemoteNotificationCompletion completion;
+@property (nonatomic) CFAbsoluteTime arrivalTime;
+@property (nonatomic, getter=isCompleted) BOOL completed;
+
+@end
+
+@implementation ATLMRemoteNotificationEntry
+
+@end
+
+@interface ATLMRemoteNotificationCoalescer ()
+
+@property (nonatomic, copy) ATLMRemoteNotificationSynchronizationBlock synchronizationBlock;
+@property (nonatomic) NSMutableArray *pendingEntries;
+@property (nonatomic) NSMutableDictionary *pendingPayloads;
+@property (nonatomic) NSMutableArray *synchronizingEntries;
+@property (nonatomic) NSUInteger countOfOutstandingSynchronizations;
+@property (nonatomic) NSUInteger generation;
+@property (nonatomic) CFAbsoluteTime batchStartTime;
+@property (nonatomic, getter=isFlushScheduled) BOOL flushScheduled;
+@property (nonatomic, readwrite) NSUInteger countOfSynchronizations;
+@property (nonatomic, readwrite) NSUInteger countOfCoalescedRemoteNotifications;
+@property (nonatomic, readwrite) NSUInteger countOfExpiredRemoteNotifications;
+
+@end
+
+@implementation ATLMRemoteNotificationCoalescer
+
++ (instancetype)coalescerWithSynchronizationBlock:(ATLMRemoteNotificationSynchronizationBlock)synchronizationBlock
+{
+    return [[self alloc] initWithSynchronizationBlock:synchronizationBlock];
+}
+
+- (id)initWithSynchronizationBlock:(ATLMRemoteNotificationSynchronizationBlock)synchronizationBlock
+{
+    NSParameterAssert(synchronizationBlock);
+    self = [super init];
+    if (self) {
+        _synchronizationBlock = [synchronizationBlock copy];
+        _coalescingWindow = ATLMRemoteNotificationDefaultCoalescingWindow;
+        _backgroundTimeBudget = ATLMRemoteNotificationBackgroundFetchTimeLimit - ATLMRemoteNotificationBackgroundTimeSafetyMargin;
+        _pendingEntries = [NSMutableArray new];
+        _pendingPayloads = [NSMutableDictionary new];
+        _synchronizingEntries = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use coalescerWithSynchronizationBlock:" userInfo:nil];
+}
+
+#pragma mark - Public API
+
+- (void)enqueueRemoteNotification:(NSDictionary *)userInfo completion:(ATLMRemoteNotificationCompletion)completion
+{
+    NSParameterAssert(userInfo);
+    NSParameterAssert(completion);
+    NSAssert([NSThread isMainThread], @"%@ must be used from the main thread", [self class]);
+
+    ATLMRemoteNotificationEntry *entry = [ATLMRemoteNotificationEntry new];
+    entry.conversationKey = ATLMConversationIdentifierFromRemoteNotification(userInfo) ?: [NSNull null];
+    entry.completion = completion;
+    entry.arrivalTime = CFAbsoluteTimeGetCurrent();
+
+    if (self.pendingEntries.count == 0) {
+        self.batchStartTime = entry.arrivalTime;
+    }
+    if (self.pendingPayloads[entry.conversationKey]) {
+        self.countOfCoalescedRemoteNotifications += 1;
+    }
+    // Only the latest payload for each conversation gets synchronized.
+    self.pendingPayloads[entry.conversationKey] = userInfo;
+    [self.pendingEntries addObject:entry];
+
+    __weak typeof(self) weakSelf = self;
+    __weak ATLMRemoteNotificationEntry *weakEntry = entry;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.backgroundTimeBudget * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [weakSelf expireEntry:weakEntry];
+    });
+    [self scheduleFlushIfNeeded];
+}
+
+- (NSUInteger)countOfPendingRemoteNotifications
+{
+    NSUInteger count = 0;
+    for (ATLMRemoteNotificationEntry *entry in [self.pendingEntries arrayByAddingObjectsFromArray:self.synchronizingEntries]) {
+        if (!entry.isCompleted) {
+            count += 1;
+        }
+    }
+    return count;
+}
+
+#pragma mark - Batching
+
+- (void)scheduleFlushIfNeeded
+{
+    if (self.isFlushScheduled || self.pendingEntries.count == 0 || self.countOfOutstandingSynchronizations > 0) {
+        return;
+    }
+    self.flushScheduled = YES;
+    NSTimeInterval elapsed = CFAbsoluteTimeGetCurrent() - self.batchStartTime;
+    NSTimeInterval delay = MAX(0, self.coalescingWindow - elapsed);
+    __weak typeof(self) weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        weakSelf.flushScheduled = NO;
+        [weakSelf flush];
+    });
+}
+
+- (void)flush
+{
+    if (self.countOfOutstandingSynchronizations > 0 || self.pendingEntries.count == 0) {
+        return;
+    }
+    NSDictionary *payloads = [self.pendingPayloads copy];
+    [self.synchronizingEntries addObjectsFromArray:self.pendingEntries];
+    [self.pendingEntries removeAllObjects];
+    [self.pendingPayloads removeAllObjects];
+
+    self.countOfOutstandingSynchronizations = payloads.count;
+    NSUInteger generation = self.generation;
+    for (id conversationKey in payloads) {
+        self.countOfSynchronizations += 1;
+        __block BOOL finished = NO;
+        __weak typeof(self) weakSelf = self;
+        BOOL handled = self.synchronizationBlock(payloads[conversationKey], ^(LYRConversation *conversation, LYRMessage *message, NSError *error) {
+            dispatch_block_t completion = ^{
+                if (finished) {
+                    return;
+                }
+                finished = YES;
+                [weakSelf synchronizationForConversationKey:conversationKey generation:generation didCompleteWithConversation:conversation message:message error:error];
+            };
+            if ([NSThread isMainThread]) {
+                completion();
+            } else {
+                dispatch_async(dispatch_get_main_queue(), completion);
+            }
+        });
+        if (!handled && !finished) {
+            // The payload wasn't meant for the client, there's nothing to wait for.
+            finished = YES;
+            [self synchronizationForConversationKey:conversationKey generation:generation didCompleteWithConversation:nil message:nil error:nil];
+        }
+    }
+}
+
+- (void)synchronizationForConversationKey:(id)conversationKey generation:(NSUInteger)generation didCompleteWithConversation:(LYRConversation *)conversation message:(LYRMessage *)message error:(NSError *)error
+{
+    // A synchronization abandoned on expiry still counts as outstanding until
+    // it completes, but its handlers have already been called.
+    if (generation == self.generation) {
+        for (ATLMRemoteNotificationEntry *entry in [self.synchronizingEntries copy]) {
+            if (![entry.conversationKey isEqual:conversationKey]) {
+                continue;
+            }
+            [self.synchronizingEntries removeObject:entry];
+            [self completeEntry:entry withConversation:conversation message:message error:error];
+        }
+    }
+    self.countOfOutstandingSynchronizations -= 1;
+    if (self.countOfOutstandingSynchronizations == 0) {
+        [self scheduleFlushIfNeeded];
+    }
+}
+
+#pragma mark - Budget accounting
+
+- (void)expireEntry:(ATLMRemoteNotificationEntry *)entry
+{
+    if (!entry || entry.isCompleted) {
+        return;
+    }
+    // Handlers which arrived within the same coalescing window are about to
+    // run out of time too; complete them together instead of one by one.
+    CFAbsoluteTime cutoff = entry.arrivalTime + self.coalescingWindow;
+    NSArray *entries = [self.synchronizingEntries arrayByAddingObjectsFromArray:self.pendingEntries];
+    for (ATLMRemoteNotificationEntry *candidate in entries) {
+        if (candidate.isCompleted || candidate.arrivalTime > cutoff) {
+            continue;
+        }
+        self.countOfExpiredRemoteNotifications += 1;
+        NSString *description = [NSString stringWithFormat:@"Remote notification synchronization did not complete within %.1f seconds.", self.backgroundTimeBudget];
+        NSError *error = [NSError errorWithDomain:ATLMErrorDomain code:ATLMRemoteNotificationBackgroundTimeExpired userInfo:@{ NSLocalizedDescriptionKey: description }];
+        [self completeEntry:candidate withConversation:nil message:nil error:error];
+    }
+
+    // Nobody is waiting for the running synchronizations anymore; bumping the
+    // generation makes their late completions skip the handler bookkeeping.
+    // The next batch still waits for them so that synchronizations never overlap.
+    for (ATLMRemoteNotificationEntry *candidate in self.synchronizingEntries) {
+        if (!candidate.isCompleted) {
+            return;
+        }
+    }
+    if (self.countOfOutstandingSynchronizations > 0) {
+        [self.synchronizingEntries removeAllObjects];
+        self.generation += 1;
+    }
+}
+
+- (void)completeEntry:(ATLMRemoteNotificationEntry *)entry withConversation:(LYRConversation *)conversation message:(LYRMessage *)message error:(NSError *)error
+{
+    if (entry.isCompleted) {
+        return;
+    }
+    entry.completed = YES;
+    ATLMRemoteNotificationCompletion completion = entry.completion;
+    entry.completion = nil;
+    completion(conversation, message, error);
+}
+
+@end
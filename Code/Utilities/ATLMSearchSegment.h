@@ -0,0 +1,125 @@
+//
+//  ATLMSearchSegment.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ @abstract A posting: a document and the number of times a term occurs in it.
+ */
+typedef struct {
+    uint32_t document;
+    uint32_t frequency;
+} ATLMSearchPosting;
+
+/**
+ @abstract Writes an immutable search segment.
+ @discussion Documents are added first, then terms in ascending order of
+   their UTF-8 bytes, each followed by its postings in ascending document
+   order. The segment layout, in native byte order, is:
+
+   - a header with the magic `ATLS`, the format version, the counts and the
+     offsets of the sections below;
+   - the document table: per document the offset and length of its message
+     identifier, the index of its conversation, its token count and its date;
+   - the conversation table: offset and length of each conversation identifier;
+   - the term dictionary: per term the offset and length of its bytes, the
+     offset and length of its postings and its document frequency;
+   - the postings: document deltas and frequencies as variable-length integers;
+   - the string pool holding identifiers and terms as UTF-8.
+
+   Terms are found by binary search over the dictionary, directly in the
+   memory-mapped file, so opening a segment costs nothing but the mapping.
+ */
+@interface ATLMSearchSegmentBuilder : NSObject
+
++ (nonnull instancetype)builder;
+
+/**
+ @return The index of the document within the segment.
+ */
+- (uint32_t)addDocumentWithMessageIdentifier:(nonnull NSString *)messageIdentifier conversationIdentifier:(nonnull NSString *)conversationIdentifier date:(NSTimeInterval)date tokenCount:(uint32_t)tokenCount;
+
+- (void)beginTermWithBytes:(nonnull const void *)bytes length:(NSUInteger)length;
+- (void)addPosting:(ATLMSearchPosting)posting;
+
+/**
+ @abstract Finishes the current term; terms without postings are dropped.
+ */
+- (void)endTerm;
+
+@property (nonatomic, readonly) uint32_t documentCount;
+
+- (nonnull NSData *)dataWithGeneration:(uint64_t)generation;
+
+@end
+
+/**
+ @abstract A memory-mapped search segment written by `ATLMSearchSegmentBuilder`.
+ @discussion Segments are immutable and can be read from any thread.
+ */
+@interface ATLMSearchSegment : NSObject
+
+/**
+ @return The segment or `nil` if the file is missing or malformed.
+ */
++ (nullable instancetype)segmentWithContentsOfFile:(nonnull NSString *)path error:(NSError *_Nullable *_Nullable)error;
+
+@property (nonnull, nonatomic, readonly) NSString *path;
+@property (nonatomic, readonly) uint64_t generation;
+@property (nonatomic, readonly) uint32_t documentCount;
+@property (nonatomic, readonly) uint64_t totalTokenCount;
+@property (nonatomic, readonly) uint32_t termCount;
+@property (nonatomic, readonly) NSUInteger byteCount;
+
+- (nonnull NSString *)messageIdentifierOfDocument:(uint32_t)document;
+- (nonnull NSString *)conversationIdentifierOfDocument:(uint32_t)document;
+- (NSTimeInterval)dateOfDocument:(uint32_t)document;
+- (uint32_t)tokenCountOfDocument:(uint32_t)document;
+
+/**
+ @abstract Returns the postings of a term, or of every term starting with
+   the bytes if `prefix` is `YES`, as `ATLMSearchPosting`s in document order
+   with the frequencies of matching terms summed up.
+ */
+- (nonnull NSData *)postingsForTermBytes:(nonnull const void *)bytes length:(NSUInteger)length prefix:(BOOL)prefix;
+
+///------------------
+/// @name Term Cursor
+///------------------
+
+/**
+ @abstract The bytes of the term at `index` in dictionary order.
+ */
+- (nonnull const uint8_t *)bytesOfTermAtIndex:(uint32_t)index length:(nonnull NSUInteger *)length;
+
+- (void)enumeratePostingsOfTermAtIndex:(uint32_t)index usingBlock:(nonnull void (^)(ATLMSearchPosting posting))block;
+
+@end
+
+/**
+ @abstract Compares two byte strings the way segment dictionaries are ordered.
+ */
+extern int ATLMSearchCompareTermBytes(const void *_Nonnull bytes, NSUInteger length, const void *_Nonnull otherBytes, NSUInteger otherLength);
+
+/**
+ @abstract Sorts postings into document order and sums up the frequencies of
+   postings for the same document.
+ */
+extern void ATLMSearchFoldPostings(NSMutableData *_Nonnull postings);
@@ -0,0 +1,477 @@
+//
+//  ATLMSearchSegment.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMSearchSegment.h"
+#import "ATLMErrors.h"
+
+static const uint32_t ATLMSearchSegmentMagic = 'ATLS';
+static const uint32_t ATLMSearchSegmentVersion = 1;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t documentCount;
+    uint32_t conversationCount;
+    uint32_t termCount;
+    uint32_t reserved;
+    uint64_t generation;
+    uint64_t totalTokenCount;
+    uint32_t documentsOffset;
+    uint32_t conversationsOffset;
+    uint32_t termsOffset;
+    uint32_t postingsOffset;
+    uint32_t postingsLength;
+    uint32_t stringsOffset;
+    uint32_t stringsLength;
+    uint32_t padding;
+} ATLMSearchSegmentHeader;
+
+typedef struct {
+    uint32_t identifierOffset;
+    uint32_t identifierLength;
+    uint32_t conversation;
+    uint32_t tokenCount;
+    double date;
+} ATLMSearchDocumentEntry;
+
+typedef struct {
+    uint32_t identifierOffset;
+    uint32_t identifierLength;
+} ATLMSearchConversationEntry;
+
+typedef struct {
+    uint32_t bytesOffset;
+    uint32_t bytesLength;
+    uint32_t postingsOffset;
+    uint32_t postingsLength;
+    uint32_t documentFrequency;
+} ATLMSearchTermEntry;
+
+int ATLMSearchCompareTermBytes(const void *bytes, NSUInteger length, const void *otherBytes, NSUInteger otherLength)
+{
+    int result = memcmp(bytes, otherBytes, MIN(length, otherLength));
+    if (result != 0) {
+        return result;
+    }
+    return length < otherLength ? -1 : (length > otherLength ? 1 : 0);
+}
+
+static void ATLMSearchAppendVarint(NSMutableData *data, uint32_t value)
+{
+    uint8_t buffer[5];
+    NSUInteger length = 0;
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        buffer[length++] = value ? (byte | 0x80) : byte;
+    } while (value);
+    [data appendBytes:buffer length:length];
+}
+
+static uint32_t ATLMSearchReadVarint(const uint8_t **cursor, const uint8_t *end)
+{
+    uint32_t value = 0;
+    uint32_t shift = 0;
+    while (*cursor < end && shift < 35) {
+        uint8_t byte = *(*cursor)++;
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+        shift += 7;
+    }
+    return value;
+}
+
+static void ATLMSearchPadData(NSMutableData *data)
+{
+    NSUInteger padding = (8 - data.length % 8) % 8;
+    [data increaseLengthBy:padding];
+}
+
+static int ATLMSearchComparePostings(const void *posting, const void *otherPosting)
+{
+    uint32_t document = ((const ATLMSearchPosting *)posting)->document;
+    uint32_t otherDocument = ((const ATLMSearchPosting *)otherPosting)->document;
+    return document < otherDocument ? -1 : (document > otherDocument ? 1 : 0);
+}
+
+void ATLMSearchFoldPostings(NSMutableData *postings)
+{
+    ATLMSearchPosting *values = postings.mutableBytes;
+    NSUInteger count = postings.length / sizeof(ATLMSearchPosting);
+    qsort(values, count, sizeof(ATLMSearchPosting), ATLMSearchComparePostings);
+    NSUInteger foldedCount = 0;
+    for (NSUInteger index = 0; index < count; index++) {
+        if (foldedCount && values[foldedCount - 1].document == values[index].document) {
+            values[foldedCount - 1].frequency += values[index].frequency;
+        } else {
+            values[foldedCount++] = values[index];
+        }
+    }
+    postings.length = foldedCount * sizeof(ATLMSearchPosting);
+}
+
+#pragma mark - Builder
+
+@interface ATLMSearchSegmentBuilder ()
+
+@property (nonatomic) NSMutableData *documents;
+@property (nonatomic) NSMutableData *conversations;
+@property (nonatomic) NSMutableData *terms;
+@property (nonatomic) NSMutableData *postings;
+@property (nonatomic) NSMutableData *strings;
+@property (nonatomic) NSMutableDictionary *conversationIndexesByIdentifier;
+@property (nonatomic, readwrite) uint32_t documentCount;
+@property (nonatomic) uint64_t totalTokenCount;
+@property (nonatomic) ATLMSearchTermEntry currentTerm;
+@property (nonatomic) int64_t lastDocument;
+
+@end
+
+@implementation ATLMSearchSegmentBuilder
+
++ (instancetype)builder
+{
+    return [[self alloc] init];
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self) {
+        _documents = [NSMutableData new];
+        _conversations = [NSMutableData new];
+        _terms = [NSMutableData new];
+        _postings = [NSMutableData new];
+        _strings = [NSMutableData new];
+        _conversationIndexesByIdentifier = [NSMutableDictionary new];
+    }
+    return self;
+}
+
+- (uint32_t)appendString:(NSString *)string length:(uint32_t *)length
+{
+    uint32_t offset = (uint32_t)self.strings.length;
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    [self.strings appendData:data];
+    *length = (uint32_t)data.length;
+    return offset;
+}
+
+- (uint32_t)addDocumentWithMessageIdentifier:(NSString *)messageIdentifier conversationIdentifier:(NSString *)conversationIdentifier date:(NSTimeInterval)date tokenCount:(uint32_t)tokenCount
+{
+    NSNumber *conversationIndex = self.conversationIndexesByIdentifier[conversationIdentifier];
+    if (!conversationIndex) {
+        ATLMSearchConversationEntry conversation;
+        conversation.identifierOffset = [self appendString:conversationIdentifier length:&conversation.identifierLength];
+        conversationIndex = @(self.conversationIndexesByIdentifier.count);
+        self.conversationIndexesByIdentifier[conversationIdentifier] = conversationIndex;
+        [self.conversations appendBytes:&conversation length:sizeof(conversation)];
+    }
+    ATLMSearchDocumentEntry document;
+    document.identifierOffset = [self appendString:messageIdentifier length:&document.identifierLength];
+    document.conversation = conversationIndex.unsignedIntValue;
+    document.tokenCount = tokenCount;
+    document.date = date;
+    [self.documents appendBytes:&document length:sizeof(document)];
+    self.totalTokenCount += tokenCount;
+    return self.documentCount++;
+}
+
+- (void)beginTermWithBytes:(const void *)bytes length:(NSUInteger)length
+{
+    ATLMSearchTermEntry term;
+    term.bytesOffset = (uint32_t)self.strings.length;
+    term.bytesLength = (uint32_t)length;
+    term.postingsOffset = (uint32_t)self.postings.length;
+    term.postingsLength = 0;
+    term.documentFrequency = 0;
+    [self.strings appendBytes:bytes length:length];
+    self.currentTerm = term;
+    self.lastDocument = -1;
+}
+
+- (void)addPosting:(ATLMSearchPosting)posting
+{
+    NSAssert((int64_t)posting.document > self.lastDocument, @"Postings must be added in ascending document order");
+    uint32_t delta = self.lastDocument < 0 ? posting.document : posting.document - (uint32_t)self.lastDocument;
+    ATLMSearchAppendVarint(self.postings, delta);
+    ATLMSearchAppendVarint(self.postings, posting.frequency);
+    self.lastDocument = posting.document;
+    ATLMSearchTermEntry term = self.currentTerm;
+    term.documentFrequency += 1;
+    self.currentTerm = term;
+}
+
+- (void)endTerm
+{
+    ATLMSearchTermEntry term = self.currentTerm;
+    if (!term.documentFrequency) {
+        self.strings.length = term.bytesOffset;
+        return;
+    }
+    term.postingsLength = (uint32_t)self.postings.length - term.postingsOffset;
+    [self.terms appendBytes:&term length:sizeof(term)];
+}
+
+- (NSData *)dataWithGeneration:(uint64_t)generation
+{
+    ATLMSearchSegmentHeader header = { 0 };
+    header.magic = ATLMSearchSegmentMagic;
+    header.version = ATLMSearchSegmentVersion;
+    header.documentCount = self.documentCount;
+    header.conversationCount = (uint32_t)self.conversationIndexesByIdentifier.count;
+    header.termCount = (uint32_t)(self.terms.length / sizeof(ATLMSearchTermEntry));
+    header.generation = generation;
+    header.totalTokenCount = self.totalTokenCount;
+
+    NSMutableData *data = [NSMutableData dataWithLength:sizeof(header)];
+    header.documentsOffset = (uint32_t)data.length;
+    [data appendData:self.documents];
+    ATLMSearchPadData(data);
+    header.conversationsOffset = (uint32_t)data.length;
+    [data appendData:self.conversations];
+    ATLMSearchPadData(data);
+    header.termsOffset = (uint32_t)data.length;
+    [data appendData:self.terms];
+    ATLMSearchPadData(data);
+    header.postingsOffset = (uint32_t)data.length;
+    header.postingsLength = (uint32_t)self.postings.length;
+    [data appendData:self.postings];
+    header.stringsOffset = (uint32_t)data.length;
+    header.stringsLength = (uint32_t)self.strings.length;
+    [data appendData:self.strings];
+    [data replaceBytesInRange:NSMakeRange(0, sizeof(header)) withBytes:&header];
+    return data;
+}
+
+@end
+
+#pragma mark - Segment
+
+@interface ATLMSearchSegment ()
+
+@property (nonnull, nonatomic, readwrite) NSString *path;
+@property (nonnull, nonatomic) NSData *data;
+@property (nonatomic) const ATLMSearchSegmentHeader *header;
+@property (nonatomic) const ATLMSearchDocumentEntry *documents;
+@property (nonatomic) const ATLMSearchConversationEntry *conversations;
+@property (nonatomic) const ATLMSearchTermEntry *terms;
+@property (nonatomic) const uint8_t *postings;
+@property (nonatomic) const uint8_t *strings;
+
+@end
+
+@implementation ATLMSearchSegment
+
++ (instancetype)segmentWithContentsOfFile:(NSString *)path error:(NSError **)error
+{
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedAlways error:error];
+    if (!data) {
+        return nil;
+    }
+    ATLMSearchSegment *segment = [[self alloc] initWithPath:path data:data];
+    if (!segment) {
+        if (error) {
+            *error = [NSError errorWithDomain:ATLMErrorDomain code:ATLMInvalidSearchSegment userInfo:@{ NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Malformed search segment at %@", path] }];
+        }
+        return nil;
+    }
+    return segment;
+}
+
+- (id)initWithPath:(NSString *)path data:(NSData *)data
+{
+    self = [super init];
+    if (self) {
+        if (data.length < sizeof(ATLMSearchSegmentHeader)) {
+            return nil;
+        }
+        const uint8_t *bytes = data.bytes;
+        const ATLMSearchSegmentHeader *header = (const ATLMSearchSegmentHeader *)bytes;
+        if (header->magic != ATLMSearchSegmentMagic || header->version != ATLMSearchSegmentVersion) {
+            return nil;
+        }
+        uint64_t length = data.length;
+        if ((uint64_t)header->documentsOffset + (uint64_t)header->documentCount * sizeof(ATLMSearchDocumentEntry) > length ||
+            (uint64_t)header->conversationsOffset + (uint64_t)header->conversationCount * sizeof(ATLMSearchConversationEntry) > length ||
+            (uint64_t)header->termsOffset + (uint64_t)header->termCount * sizeof(ATLMSearchTermEntry) > length ||
+            (uint64_t)header->postingsOffset + header->postingsLength > length ||
+            (uint64_t)header->stringsOffset + header->stringsLength > length) {
+            return nil;
+        }
+        _path = [path copy];
+        _data = data;
+        _header = header;
+        _documents = (const ATLMSearchDocumentEntry *)(bytes + header->documentsOffset);
+        _conversations = (const ATLMSearchConversationEntry *)(bytes + header->conversationsOffset);
+        _terms = (const ATLMSearchTermEntry *)(bytes + header->termsOffset);
+        _postings = bytes + header->postingsOffset;
+        _strings = bytes + header->stringsOffset;
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use segmentWithContentsOfFile:error:" userInfo:nil];
+}
+
+- (uint64_t)generation
+{
+    return self.header->generation;
+}
+
+- (uint32_t)documentCount
+{
+    return self.header->documentCount;
+}
+
+- (uint64_t)totalTokenCount
+{
+    return self.header->totalTokenCount;
+}
+
+- (uint32_t)termCount
+{
+    return self.header->termCount;
+}
+
+- (NSUInteger)byteCount
+{
+    return self.data.length;
+}
+
+#pragma mark - Documents
+
+- (NSString *)stringAtOffset:(uint32_t)offset length:(uint32_t)length
+{
+    if ((uint64_t)offset + length > self.header->stringsLength) {
+        return @"";
+    }
+    return [[NSString alloc] initWithBytes:self.strings + offset length:length encoding:NSUTF8StringEncoding] ?: @"";
+}
+
+- (NSString *)messageIdentifierOfDocument:(uint32_t)document
+{
+    const ATLMSearchDocumentEntry *entry = &self.documents[document];
+    return [self stringAtOffset:entry->identifierOffset length:entry->identifierLength];
+}
+
+- (NSString *)conversationIdentifierOfDocument:(uint32_t)document
+{
+    uint32_t conversation = self.documents[document].conversation;
+    if (conversation >= self.header->conversationCount) {
+        return @"";
+    }
+    const ATLMSearchConversationEntry *entry = &self.conversations[conversation];
+    return [self stringAtOffset:entry->identifierOffset length:entry->identifierLength];
+}
+
+- (NSTimeInterval)dateOfDocument:(uint32_t)document
+{
+    return self.documents[document].date;
+}
+
+- (uint32_t)tokenCountOfDocument:(uint32_t)document
+{
+    return self.documents[document].tokenCount;
+}
+
+#pragma mark - Terms
+
+- (uint32_t)lowerBoundForTermBytes:(const void *)bytes length:(NSUInteger)length
+{
+    uint32_t low = 0;
+    uint32_t high = self.header->termCount;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        NSUInteger termLength;
+        const uint8_t *termBytes = [self bytesOfTermAtIndex:middle length:&termLength];
+        if (ATLMSearchCompareTermBytes(termBytes, termLength, bytes, length) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+- (const uint8_t *)bytesOfTermAtIndex:(uint32_t)index length:(NSUInteger *)length
+{
+    const ATLMSearchTermEntry *term = &self.terms[index];
+    if ((uint64_t)term->bytesOffset + term->bytesLength > self.header->stringsLength) {
+        *length = 0;
+        return self.strings;
+    }
+    *length = term->bytesLength;
+    return self.strings + term->bytesOffset;
+}
+
+- (void)enumeratePostingsOfTermAtIndex:(uint32_t)index usingBlock:(void (^)(ATLMSearchPosting))block
+{
+    const ATLMSearchTermEntry *term = &self.terms[index];
+    if ((uint64_t)term->postingsOffset + term->postingsLength > self.header->postingsLength) {
+        return;
+    }
+    const uint8_t *cursor = self.postings + term->postingsOffset;
+    const uint8_t *end = cursor + term->postingsLength;
+    uint32_t document = 0;
+    for (uint32_t count = 0; count < term->documentFrequency && cursor < end; count++) {
+        document += ATLMSearchReadVarint(&cursor, end);
+        ATLMSearchPosting posting = { document, ATLMSearchReadVarint(&cursor, end) };
+        if (posting.document >= self.header->documentCount) {
+            return;
+        }
+        block(posting);
+    }
+}
+
+- (NSData *)postingsForTermBytes:(const void *)bytes length:(NSUInteger)length prefix:(BOOL)prefix
+{
+    NSMutableData *postings = [NSMutableData new];
+    void (^appendPosting)(ATLMSearchPosting) = ^(ATLMSearchPosting posting) {
+        [postings appendBytes:&posting length:sizeof(posting)];
+    };
+    uint32_t termCount = self.header->termCount;
+    uint32_t index = [self lowerBoundForTermBytes:bytes length:length];
+    NSUInteger matchingTermCount = 0;
+    for (; index < termCount; index++) {
+        NSUInteger termLength;
+        const uint8_t *termBytes = [self bytesOfTermAtIndex:index length:&termLength];
+        BOOL matches = prefix ? (termLength >= length && memcmp(termBytes, bytes, length) == 0) : ATLMSearchCompareTermBytes(termBytes, termLength, bytes, length) == 0;
+        if (!matches) {
+            break;
+        }
+        [self enumeratePostingsOfTermAtIndex:index usingBlock:appendPosting];
+        matchingTermCount += 1;
+        if (!prefix) {
+            break;
+        }
+    }
+    if (matchingTermCount > 1) {
+        // Several terms share the prefix.
+        ATLMSearchFoldPostings(postings);
+    }
+    return postings;
+}
+
+@end
@@ -0,0 +1,35 @@
+//
+//  ATLMSession.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import "ATLMUser.h"
+
+/**
+ @abstract The `ATLMSession` pairs the token the identity provider handed out
+   with the user it was handed out for.
+ */
+@interface ATLMSession : NSObject <NSSecureCoding>
+
++ (nonnull instancetype)sessionWithAuthenticationToken:(nonnull NSString *)authenticationToken user:(nonnull ATLMUser *)user;
+
+@property (nonnull, nonatomic, readonly) NSString *authenticationToken;
+@property (nonnull, nonatomic, readonly) ATLMUser *user;
+
+@end
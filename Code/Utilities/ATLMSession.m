@@ -0,0 +1,71 @@
+//
+//  ATLMSession.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMSession.h"
+
+static NSString *const ATLMSessionAuthenticationTokenKey = @"authenticationToken";
+static NSString *const ATLMSessionUserKey = @"user";
+
+@interface ATLMSession ()
+
+@property (nonnull, nonatomic, readwrite) NSString *authenticationToken;
+@property (nonnull, nonatomic, readwrite) ATLMUser *user;
+
+@end
+
+@implementation ATLMSession
+
++ (instancetype)sessionWithAuthenticationToken:(NSString *)authenticationToken user:(ATLMUser *)user
+{
+    NSParameterAssert(authenticationToken);
+    NSParameterAssert(user);
+    ATLMSession *session = [self new];
+    session.authenticationToken = [authenticationToken copy];
+    session.user = [user copy];
+    return session;
+}
+
++ (BOOL)supportsSecureCoding
+{
+    return YES;
+}
+
+- (id)initWithCoder:(NSCoder *)decoder
+{
+    NSString *authenticationToken = [decoder decodeObjectOfClass:[NSString class] forKey:ATLMSessionAuthenticationTokenKey];
+    ATLMUser *user = [decoder decodeObjectOfClass:[ATLMUser class] forKey:ATLMSessionUserKey];
+    if (!authenticationToken || !user) {
+        return nil;
+    }
+    self = [super init];
+    if (self) {
+        _authenticationToken = authenticationToken;
+        _user = user;
+    }
+    return self;
+}
+
+- (void)encodeWithCoder:(NSCoder *)coder
+{
+    [coder encodeObject:self.authenticationToken forKey:ATLMSessionAuthenticationTokenKey];
+    [coder encodeObject:self.user forKey:ATLMSessionUserKey];
+}
+
+@end
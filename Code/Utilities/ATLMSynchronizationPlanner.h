@@ -0,0 +1,190 @@
+//
+//  ATLMSynchronizationPlanner.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ @abstract The default `minimumDepth` of planners, for clients synchronizing
+   less than that by their partial history policy.
+ */
+extern const NSUInteger ATLMSynchronizationPlannerMinimumDepth;
+
+/**
+ @abstract The `ATLMSynchronizationPlanner` decides how much message history
+   to synchronize for each conversation.
+ @discussion Instead of a fixed window for every conversation, the planner picks
+   a depth between `minimumDepth` and `maximumDepth` from how recently the
+   conversation was active, how often the user opens it (an exponentially
+   decaying count), how deep the user usually scrolls and how many messages are
+   unread. While the user scrolls up the planner asks for deeper history in
+   pages, just before the synchronized history runs out.
+
+   The planner doesn't talk to the `LYRClient` itself: callers feed it the
+   activity and act on the depths it returns, which keeps it testable against a
+   simulated corpus. It reports the messages and bytes synchronized and how
+   many of those messages have never been scrolled to. All methods must be
+   called on the main thread.
+ */
+@interface ATLMSynchronizationPlanner : NSObject
+
+/**
+ @abstract Creates a planner restoring the open statistics persisted at `path`.
+ @param path The path of the file the statistics are persisted to or `nil` to keep them in memory only.
+ @return A new `ATLMSynchronizationPlanner` instance.
+ */
++ (nonnull instancetype)plannerWithPersistencePath:(nullable NSString *)path;
+
+///---------------------
+/// @name Configuration
+///---------------------
+
+/**
+ @abstract The depth of conversations the user never opens. Defaults to `ATLMSynchronizationPlannerMinimumDepth`.
+ */
+@property (nonatomic) NSUInteger minimumDepth;
+
+/**
+ @abstract The depth of conversations the user has opened recently. Defaults to 35.
+ */
+@property (nonatomic) NSUInteger minimumOpenedDepth;
+
+/**
+ @abstract The deepest history synchronized ahead of time. Defaults to 100.
+ */
+@property (nonatomic) NSUInteger maximumDepth;
+
+/**
+ @abstract The number of older messages requested by a backfill. Defaults to 25.
+ */
+@property (nonatomic) NSUInteger backfillPageSize;
+
+/**
+ @abstract The number of synchronized messages left above the top of the
+   screen which triggers a backfill. Defaults to 10.
+ */
+@property (nonatomic) NSUInteger backfillThreshold;
+
+/**
+ @abstract The time it takes for an open to count half as much. Defaults to 7 days.
+ */
+@property (nonatomic) NSTimeInterval openFrequencyHalfLife;
+
+///-----------------
+/// @name Planning
+///-----------------
+
+/**
+ @abstract Records that the user opened a conversation.
+ @param conversationIdentifier The identifier of the conversation.
+ @param date The time of the open.
+ */
+- (void)recordOpenOfConversationWithIdentifier:(nonnull NSURL *)conversationIdentifier date:(nonnull NSDate *)date;
+
+/**
+ @abstract Records how far back the user has scrolled in a conversation.
+ @param viewedDepth The number of messages from the newest one up to the oldest one on screen.
+ @param conversationIdentifier The identifier of the conversation.
+ */
+- (void)recordViewedDepth:(NSUInteger)viewedDepth forConversationWithIdentifier:(nonnull NSURL *)conversationIdentifier;
+
+/**
+ @abstract Returns the number of messages which should be synchronized ahead of time.
+ @param conversationIdentifier The identifier of the conversation.
+ @param lastMessageDate The time of the last message in the conversation or `nil` if it has none.
+ @param unreadCount The number of unread messages in the conversation.
+ @param date The current time.
+ */
+- (NSUInteger)depthForConversationWithIdentifier:(nonnull NSURL *)conversationIdentifier lastMessageDate:(nullable NSDate *)lastMessageDate unreadCount:(NSUInteger)unreadCount date:(nonnull NSDate *)date;
+
+/**
+ @abstract Returns the number of messages to request ahead of time, or zero.
+ @param conversationIdentifier The identifier of the conversation.
+ @param lastMessageDate The time of the last message in the conversation or `nil` if it has none.
+ @param unreadCount The number of unread messages in the conversation.
+ @param synchronizedDepth The number of messages available locally.
+ @param date The current time.
+ @discussion Messages already requested are subtracted, so calling this again
+   before the synchronization completes returns zero.
+ */
+- (NSUInteger)messageCountToSynchronizeForConversationWithIdentifier:(nonnull NSURL *)conversationIdentifier lastMessageDate:(nullable NSDate *)lastMessageDate unreadCount:(NSUInteger)unreadCount synchronizedDepth:(NSUInteger)synchronizedDepth date:(nonnull NSDate *)date;
+
+/**
+ @abstract Returns the number of older messages to request as the user scrolls up, or zero.
+ @param conversationIdentifier The identifier of the conversation.
+ @param viewedDepth The number of messages from the newest one up to the oldest one on screen.
+ @param synchronizedDepth The number of messages available locally.
+ @discussion A non-zero result is returned once per page; the caller is
+   expected to request that many messages from the client.
+ */
+- (NSUInteger)backfillCountForConversationWithIdentifier:(nonnull NSURL *)conversationIdentifier viewedDepth:(NSUInteger)viewedDepth synchronizedDepth:(NSUInteger)synchronizedDepth;
+
+/**
+ @abstract Forgets the messages requested for a conversation whose
+   synchronization request failed, so that the next plan or backfill asks
+   for them again.
+ @param conversationIdentifier The identifier of the conversation.
+ */
+- (void)recordFailedSynchronizationForConversationWithIdentifier:(nonnull NSURL *)conversationIdentifier;
+
+/**
+ @abstract Records messages which arrived through synchronization.
+ @param messageCount The number of messages synchronized.
+ @param byteCount The size of the synchronized message parts.
+ @param conversationIdentifier The identifier of the conversation the messages belong to.
+ */
+- (void)recordSynchronizedMessageCount:(NSUInteger)messageCount byteCount:(unsigned long long)byteCount forConversationWithIdentifier:(nonnull NSURL *)conversationIdentifier;
+
+/**
+ @abstract Forgets everything about a conversation, e.g. once it is deleted.
+ */
+- (void)removeConversationWithIdentifier:(nonnull NSURL *)conversationIdentifier;
+
+/**
+ @abstract Writes the open statistics to the persistence path.
+ @discussion The statistics are captured right away and written on a
+   background queue; planners created afterwards read them back after the write.
+ */
+- (void)persist;
+
+///------------------
+/// @name Reporting
+///------------------
+
+/**
+ @abstract The number of messages recorded as synchronized.
+ */
+@property (nonatomic, readonly) NSUInteger countOfSynchronizedMessages;
+
+/**
+ @abstract The size of the message parts recorded as synchronized.
+ */
+@property (nonatomic, readonly) unsigned long long countOfSynchronizedBytes;
+
+/**
+ @abstract The number of synchronized messages the user has not scrolled to.
+ */
+@property (nonatomic, readonly) NSUInteger countOfNeverViewedMessages;
+
+/**
+ @abstract The number of backfills handed out by `backfillCountForConversationWithIdentifier:viewedDepth:synchronizedDepth:`.
+ */
+@property (nonatomic, readonly) NSUInteger countOfBackfills;
+
+@end
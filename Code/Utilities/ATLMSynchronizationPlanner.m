@@ -0,0 +1,279 @@
+//
+//  ATLMSynchronizationPlanner.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMSynchronizationPlanner.h"
+
+const NSUInteger ATLMSynchronizationPlannerMinimumDepth = 5;
+
+static const NSUInteger ATLMSynchronizationPlannerDefaultMinimumOpenedDepth = 35;
+static const NSUInteger ATLMSynchronizationPlannerDefaultMaximumDepth = 100;
+static const NSUInteger ATLMSynchronizationPlannerDefaultBackfillPageSize = 25;
+static const NSUInteger ATLMSynchronizationPlannerDefaultBackfillThreshold = 10;
+static const NSTimeInterval ATLMSynchronizationPlannerDefaultOpenFrequencyHalfLife = 7 * 24 * 60 * 60;
+
+// Activity older than this counts for roughly a third.
+static const NSTimeInterval ATLMSynchronizationPlannerRecencyTimescale = 3 * 24 * 60 * 60;
+// A decayed open score at which a conversation counts as opened all the time.
+static const double ATLMSynchronizationPlannerFrequentOpenScore = 5.0;
+// Headroom kept above the depth the user usually scrolls to.
+static const double ATLMSynchronizationPlannerViewedDepthHeadroom = 1.25;
+
+static NSString *const ATLMSynchronizationPlannerOpenScoreKey = @"open_score";
+static NSString *const ATLMSynchronizationPlannerLastOpenedAtKey = @"last_opened_at";
+static NSString *const ATLMSynchronizationPlannerTypicalViewedDepthKey = @"typical_viewed_depth";
+
+static dispatch_queue_t ATLMSynchronizationPlannerPersistenceQueue()
+{
+    static dispatch_queue_t queue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        queue = dispatch_queue_create("com.layer.Atlas-Messenger.synchronization-planner", DISPATCH_QUEUE_SERIAL);
+    });
+    return queue;
+}
+
+@interface ATLMConversationSynchronizationState : NSObject
+
+@property (nonatomic) double openScore;
+@property (nonatomic) NSDate *lastOpenedAt;
+@property (nonatomic) double typicalViewedDepth;
+@property (nonatomic) NSUInteger sessionViewedDepth;
+@property (nonatomic) NSUInteger maximumViewedDepth;
+@property (nonatomic) NSUInteger requestedDepth;
+@property (nonatomic) NSUInteger synchronizedMessageCount;
+
+@end
+
+@implementation ATLMConversationSynchronizationState
+
+@end
+
+@interface ATLMSynchronizationPlanner ()
+
+@property (nullable, nonatomic, copy) NSString *persistencePath;
+@property (nonatomic) NSMutableDictionary *statesByConversationIdentifier;
+@property (nonatomic, readwrite) NSUInteger countOfSynchronizedMessages;
+@property (nonatomic, readwrite) unsigned long long countOfSynchronizedBytes;
+@property (nonatomic, readwrite) NSUInteger countOfBackfills;
+
+@end
+
+@implementation ATLMSynchronizationPlanner
+
++ (instancetype)plannerWithPersistencePath:(NSString *)path
+{
+    return [[self alloc] initWithPersistencePath:path];
+}
+
+- (id)initWithPersistencePath:(NSString *)path
+{
+    self = [super init];
+    if (self) {
+        _persistencePath = [path copy];
+        _minimumDepth = ATLMSynchronizationPlannerMinimumDepth;
+        _minimumOpenedDepth = ATLMSynchronizationPlannerDefaultMinimumOpenedDepth;
+        _maximumDepth = ATLMSynchronizationPlannerDefaultMaximumDepth;
+        _backfillPageSize = ATLMSynchronizationPlannerDefaultBackfillPageSize;
+        _backfillThreshold = ATLMSynchronizationPlannerDefaultBackfillThreshold;
+        _openFrequencyHalfLife = ATLMSynchronizationPlannerDefaultOpenFrequencyHalfLife;
+        _statesByConversationIdentifier = [NSMutableDictionary new];
+        if (path) {
+            // Read behind any pending write of the same path.
+            __block NSDictionary *snapshot;
+            dispatch_sync(ATLMSynchronizationPlannerPersistenceQueue(), ^{
+                snapshot = [NSDictionary dictionaryWithContentsOfFile:path];
+            });
+            [self restoreStates:snapshot];
+        }
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use plannerWithPersistencePath:" userInfo:nil];
+}
+
+#pragma mark - Planning
+
+- (void)recordOpenOfConversationWithIdentifier:(NSURL *)conversationIdentifier date:(NSDate *)date
+{
+    NSParameterAssert(conversationIdentifier);
+    NSParameterAssert(date);
+    ATLMConversationSynchronizationState *state = [self stateForConversationIdentifier:conversationIdentifier create:YES];
+    state.openScore = [self openScoreOfState:state atDate:date] + 1;
+    state.lastOpenedAt = date;
+
+    // Fold the previous visit into the typical scroll depth.
+    if (state.sessionViewedDepth > 0) {
+        state.typicalViewedDepth = state.typicalViewedDepth > 0 ? (state.typicalViewedDepth + state.sessionViewedDepth) / 2 : state.sessionViewedDepth;
+    }
+    state.sessionViewedDepth = 0;
+}
+
+- (void)recordViewedDepth:(NSUInteger)viewedDepth forConversationWithIdentifier:(NSURL *)conversationIdentifier
+{
+    ATLMConversationSynchronizationState *state = [self stateForConversationIdentifier:conversationIdentifier create:YES];
+    state.sessionViewedDepth = MAX(state.sessionViewedDepth, viewedDepth);
+    state.maximumViewedDepth = MAX(state.maximumViewedDepth, viewedDepth);
+}
+
+- (NSUInteger)depthForConversationWithIdentifier:(NSURL *)conversationIdentifier lastMessageDate:(NSDate *)lastMessageDate unreadCount:(NSUInteger)unreadCount date:(NSDate *)date
+{
+    NSParameterAssert(conversationIdentifier);
+    NSParameterAssert(date);
+    ATLMConversationSynchronizationState *state = [self stateForConversationIdentifier:conversationIdentifier create:NO];
+    double frequency = MIN(1.0, [self openScoreOfState:state atDate:date] / ATLMSynchronizationPlannerFrequentOpenScore);
+    double recency = 0;
+    if (lastMessageDate) {
+        recency = exp(-MAX(0, [date timeIntervalSinceDate:lastMessageDate]) / ATLMSynchronizationPlannerRecencyTimescale);
+    }
+    // A conversation the user never opens stays at the minimum depth however busy it is.
+    double interest = frequency * (0.5 + 0.5 * recency);
+    double depth = self.minimumDepth + (self.maximumDepth - self.minimumDepth) * interest;
+    if (frequency > 0) {
+        // Stay clear of the backfill threshold at the depth the user usually reads to.
+        double readingDepth = state.typicalViewedDepth * ATLMSynchronizationPlannerViewedDepthHeadroom + self.backfillThreshold;
+        depth = MAX(depth, MAX(readingDepth, self.minimumOpenedDepth));
+    }
+    depth = MAX(depth, unreadCount + self.minimumDepth);
+    depth = MIN(MAX(depth, self.minimumDepth), self.maximumDepth);
+    return (NSUInteger)ceil(depth);
+}
+
+- (NSUInteger)messageCountToSynchronizeForConversationWithIdentifier:(NSURL *)conversationIdentifier lastMessageDate:(NSDate *)lastMessageDate unreadCount:(NSUInteger)unreadCount synchronizedDepth:(NSUInteger)synchronizedDepth date:(NSDate *)date
+{
+    NSUInteger depth = [self depthForConversationWithIdentifier:conversationIdentifier lastMessageDate:lastMessageDate unreadCount:unreadCount date:date];
+    ATLMConversationSynchronizationState *state = [self stateForConversationIdentifier:conversationIdentifier create:YES];
+    NSUInteger plannedDepth = MAX(synchronizedDepth, state.requestedDepth);
+    if (depth <= plannedDepth) {
+        return 0;
+    }
+    state.requestedDepth = depth;
+    return depth - plannedDepth;
+}
+
+- (NSUInteger)backfillCountForConversationWithIdentifier:(NSURL *)conversationIdentifier viewedDepth:(NSUInteger)viewedDepth synchronizedDepth:(NSUInteger)synchronizedDepth
+{
+    [self recordViewedDepth:viewedDepth forConversationWithIdentifier:conversationIdentifier];
+    if (viewedDepth + self.backfillThreshold < synchronizedDepth) {
+        return 0;
+    }
+    ATLMConversationSynchronizationState *state = [self stateForConversationIdentifier:conversationIdentifier create:YES];
+    if (state.requestedDepth >= synchronizedDepth + self.backfillPageSize) {
+        // The previous page is still on its way.
+        return 0;
+    }
+    state.requestedDepth = synchronizedDepth + self.backfillPageSize;
+    self.countOfBackfills += 1;
+    return self.backfillPageSize;
+}
+
+- (void)recordFailedSynchronizationForConversationWithIdentifier:(NSURL *)conversationIdentifier
+{
+    ATLMConversationSynchronizationState *state = [self stateForConversationIdentifier:conversationIdentifier create:NO];
+    state.requestedDepth = 0;
+}
+
+- (void)recordSynchronizedMessageCount:(NSUInteger)messageCount byteCount:(unsigned long long)byteCount forConversationWithIdentifier:(NSURL *)conversationIdentifier
+{
+    ATLMConversationSynchronizationState *state = [self stateForConversationIdentifier:conversationIdentifier create:YES];
+    state.synchronizedMessageCount += messageCount;
+    self.countOfSynchronizedMessages += messageCount;
+    self.countOfSynchronizedBytes += byteCount;
+}
+
+- (void)removeConversationWithIdentifier:(NSURL *)conversationIdentifier
+{
+    [self.statesByConversationIdentifier removeObjectForKey:conversationIdentifier.absoluteString];
+}
+
+- (NSUInteger)countOfNeverViewedMessages
+{
+    NSUInteger count = 0;
+    for (ATLMConversationSynchronizationState *state in self.statesByConversationIdentifier.allValues) {
+        if (state.synchronizedMessageCount > state.maximumViewedDepth) {
+            count += state.synchronizedMessageCount - state.maximumViewedDepth;
+        }
+    }
+    return count;
+}
+
+#pragma mark - Persistence
+
+- (void)persist
+{
+    if (!self.persistencePath) {
+        return;
+    }
+    NSMutableDictionary *snapshot = [NSMutableDictionary dictionaryWithCapacity:self.statesByConversationIdentifier.count];
+    [self.statesByConversationIdentifier enumerateKeysAndObjectsUsingBlock:^(NSString *conversationIdentifier, ATLMConversationSynchronizationState *state, BOOL *stop) {
+        if (!state.lastOpenedAt) {
+            return;
+        }
+        double typicalViewedDepth = state.typicalViewedDepth;
+        if (state.sessionViewedDepth > 0) {
+            typicalViewedDepth = typicalViewedDepth > 0 ? (typicalViewedDepth + state.sessionViewedDepth) / 2 : state.sessionViewedDepth;
+        }
+        snapshot[conversationIdentifier] = @{ ATLMSynchronizationPlannerOpenScoreKey: @(state.openScore),
+                                              ATLMSynchronizationPlannerLastOpenedAtKey: state.lastOpenedAt,
+                                              ATLMSynchronizationPlannerTypicalViewedDepthKey: @(typicalViewedDepth) };
+    }];
+    NSString *persistencePath = self.persistencePath;
+    dispatch_async(ATLMSynchronizationPlannerPersistenceQueue(), ^{
+        if (![snapshot writeToFile:persistencePath atomically:YES]) {
+            NSLog(@"Failed to persist synchronization plan to %@", persistencePath);
+        }
+    });
+}
+
+- (void)restoreStates:(NSDictionary *)snapshot
+{
+    [snapshot enumerateKeysAndObjectsUsingBlock:^(NSString *conversationIdentifier, NSDictionary *persistedState, BOOL *stop) {
+        ATLMConversationSynchronizationState *state = [ATLMConversationSynchronizationState new];
+        state.openScore = [persistedState[ATLMSynchronizationPlannerOpenScoreKey] doubleValue];
+        state.lastOpenedAt = persistedState[ATLMSynchronizationPlannerLastOpenedAtKey];
+        state.typicalViewedDepth = [persistedState[ATLMSynchronizationPlannerTypicalViewedDepthKey] doubleValue];
+        self.statesByConversationIdentifier[conversationIdentifier] = state;
+    }];
+}
+
+#pragma mark - Helpers
+
+- (ATLMConversationSynchronizationState *)stateForConversationIdentifier:(NSURL *)conversationIdentifier create:(BOOL)create
+{
+    ATLMConversationSynchronizationState *state = self.statesByConversationIdentifier[conversationIdentifier.absoluteString];
+    if (!state && create) {
+        state = [ATLMConversationSynchronizationState new];
+        self.statesByConversationIdentifier[conversationIdentifier.absoluteString] = state;
+    }
+    return state;
+}
+
+- (double)openScoreOfState:(ATLMConversationSynchronizationState *)state atDate:(NSDate *)date
+{
+    if (!state.lastOpenedAt) {
+        return 0;
+    }
+    NSTimeInterval elapsed = MAX(0, [date timeIntervalSinceDate:state.lastOpenedAt]);
+    return state.openScore * exp2(-elapsed / self.openFrequencyHalfLife);
+}
+
+@end
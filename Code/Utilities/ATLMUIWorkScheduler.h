@@ -0,0 +1,128 @@
+//
+//  ATLMUIWorkScheduler.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ @abstract The order queued work runs in; work of the same priority runs first in, first out.
+ */
+typedef NS_ENUM(NSUInteger, ATLMUIWorkPriority) {
+    ATLMUIWorkPriorityHigh      = 0, // Work the user is waiting for, such as leaving a deleted conversation.
+    ATLMUIWorkPriorityDefault   = 1, // Refreshes of visible content.
+    ATLMUIWorkPriorityLow       = 2, // Work nobody is waiting for, such as prefetching.
+};
+
+/**
+ @abstract The deferral reason of navigation controller push and pop animations.
+ */
+extern NSString *_Nonnull const ATLMUIWorkDeferralReasonNavigationTransition;
+
+/**
+ @abstract The `ATLMUIWorkScheduler` runs work on the main thread once
+   animations and scrolling have settled, a few milliseconds per frame.
+ @discussion Work is deferred while any deferral reason is active and while
+   a scroll view is tracking or decelerating, which UIKit does with the main
+   run loop in `UITrackingRunLoopMode`. Otherwise a display link drains the
+   queue in priority order until `frameBudget` is used up and continues on
+   the next frame, so a burst of queued work doesn't cost a hitch. At least
+   one item runs per frame.
+
+   Work scheduled with a coalescing key replaces the queued work with the
+   same key, keeping the higher of the two priorities, so repeated refreshes
+   of the same object run once. All methods must be called on the main thread.
+ */
+@interface ATLMUIWorkScheduler : NSObject
+
+/**
+ @abstract The scheduler shared by the application.
+ */
++ (nonnull instancetype)sharedScheduler;
+
+/**
+ @abstract Creates a scheduler of its own, for tests.
+ */
++ (nonnull instancetype)scheduler;
+
+/**
+ @abstract The time spent running work per frame. Defaults to 4ms.
+ */
+@property (nonatomic) NSTimeInterval frameBudget;
+
+///------------------------
+/// @name Scheduling Work
+///------------------------
+
+/**
+ @abstract Queues work to run once the UI is idle.
+ @param priority The priority of the work.
+ @param coalescingKey A key identifying the work or `nil` to never coalesce it.
+ @param block The work.
+ */
+- (void)scheduleWorkWithPriority:(ATLMUIWorkPriority)priority coalescingKey:(nullable id<NSCopying>)coalescingKey block:(nonnull void (^)(void))block;
+
+/**
+ @abstract Removes the queued work scheduled with the supplied coalescing key.
+ @discussion Does nothing if no such work is queued or it already ran.
+ @param coalescingKey The key the work was scheduled with.
+ */
+- (void)cancelWorkWithCoalescingKey:(nonnull id<NSCopying>)coalescingKey;
+
+///---------------------
+/// @name Deferring Work
+///---------------------
+
+/**
+ @abstract Defers work until `endDeferringForReason:` is called for the reason as many times.
+ @discussion Calls nest, so every call must be balanced by one to
+   `endDeferringForReason:`, including by objects deallocated while deferring.
+ @param reason A string identifying the cause, such as `ATLMUIWorkDeferralReasonNavigationTransition`.
+ */
+- (void)beginDeferringForReason:(nonnull NSString *)reason;
+
+/**
+ @abstract Ends one deferral begun with `beginDeferringForReason:`.
+ @discussion Queued work resumes once no reason is left. Unbalanced calls
+   assert.
+ @param reason The string passed to `beginDeferringForReason:`.
+ */
+- (void)endDeferringForReason:(nonnull NSString *)reason;
+
+/**
+ @abstract `YES` while a deferral reason is active or a scroll view is tracking or decelerating.
+ */
+@property (nonatomic, readonly, getter=isDeferring) BOOL deferring;
+
+///--------------
+/// @name Metrics
+///--------------
+
+@property (nonatomic, readonly) NSUInteger countOfPendingWork;
+
+/**
+ @abstract The number of work items replaced by newer work with the same coalescing key.
+ */
+@property (nonatomic, readonly) NSUInteger countOfCoalescedWork;
+
+/**
+ @abstract The number of frames which ran work.
+ */
+@property (nonatomic, readonly) NSUInteger countOfDrainingFrames;
+
+@end
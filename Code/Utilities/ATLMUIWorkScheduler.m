@@ -0,0 +1,202 @@
+//
+//  ATLMUIWorkScheduler.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMUIWorkScheduler.h"
+#import <UIKit/UIKit.h>
+#import <QuartzCore/QuartzCore.h>
+
+NSString *const ATLMUIWorkDeferralReasonNavigationTransition = @"navigation-transition";
+
+static const NSTimeInterval ATLMUIWorkSchedulerDefaultFrameBudget = 0.004;
+static const NSUInteger ATLMUIWorkPriorityCount = ATLMUIWorkPriorityLow + 1;
+
+@interface ATLMUIWorkItem : NSObject
+
+@property (nonatomic) ATLMUIWorkPriority priority;
+@property (nonatomic, copy) id<NSCopying> coalescingKey;
+@property (nonatomic, copy) void (^block)(void);
+
+@end
+
+@implementation ATLMUIWorkItem
+
+@end
+
+@interface ATLMUIWorkScheduler ()
+
+@property (nonnull, nonatomic) NSArray *queues;
+@property (nonnull, nonatomic) NSMutableDictionary *itemsByCoalescingKey;
+@property (nonnull, nonatomic) NSCountedSet *deferralReasons;
+@property (nullable, nonatomic) CADisplayLink *displayLink;
+@property (nonatomic, readwrite) NSUInteger countOfCoalescedWork;
+@property (nonatomic, readwrite) NSUInteger countOfDrainingFrames;
+
+@end
+
+@implementation ATLMUIWorkScheduler
+
++ (instancetype)sharedScheduler
+{
+    static ATLMUIWorkScheduler *sharedScheduler;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedScheduler = [self scheduler];
+    });
+    return sharedScheduler;
+}
+
++ (instancetype)scheduler
+{
+    return [[self alloc] init];
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self) {
+        NSMutableArray *queues = [NSMutableArray arrayWithCapacity:ATLMUIWorkPriorityCount];
+        for (NSUInteger priority = 0; priority < ATLMUIWorkPriorityCount; priority++) {
+            [queues addObject:[NSMutableArray new]];
+        }
+        _queues = queues;
+        _itemsByCoalescingKey = [NSMutableDictionary new];
+        _deferralReasons = [NSCountedSet new];
+        _frameBudget = ATLMUIWorkSchedulerDefaultFrameBudget;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [_displayLink invalidate];
+}
+
+#pragma mark - Scheduling Work
+
+- (void)scheduleWorkWithPriority:(ATLMUIWorkPriority)priority coalescingKey:(id<NSCopying>)coalescingKey block:(void (^)(void))block
+{
+    NSParameterAssert(block);
+    NSParameterAssert(priority < ATLMUIWorkPriorityCount);
+    ATLMUIWorkItem *item = coalescingKey ? self.itemsByCoalescingKey[coalescingKey] : nil;
+    if (item) {
+        self.countOfCoalescedWork += 1;
+        if (priority < item.priority) {
+            [self.queues[item.priority] removeObjectIdenticalTo:item];
+            item.priority = priority;
+            [self.queues[priority] addObject:item];
+        }
+        item.block = block;
+        return;
+    }
+    item = [ATLMUIWorkItem new];
+    item.priority = priority;
+    item.coalescingKey = coalescingKey;
+    item.block = block;
+    [self.queues[priority] addObject:item];
+    if (coalescingKey) {
+        self.itemsByCoalescingKey[coalescingKey] = item;
+    }
+    if (!self.displayLink) {
+        // The display link retains the scheduler; it only runs while work is queued.
+        self.displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(displayLinkDidFire:)];
+        [self.displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+    }
+}
+
+- (void)cancelWorkWithCoalescingKey:(id<NSCopying>)coalescingKey
+{
+    ATLMUIWorkItem *item = self.itemsByCoalescingKey[coalescingKey];
+    if (!item) {
+        return;
+    }
+    [self.queues[item.priority] removeObjectIdenticalTo:item];
+    [self.itemsByCoalescingKey removeObjectForKey:coalescingKey];
+    [self stopDisplayLinkIfIdle];
+}
+
+#pragma mark - Deferring Work
+
+- (void)beginDeferringForReason:(NSString *)reason
+{
+    [self.deferralReasons addObject:reason];
+}
+
+- (void)endDeferringForReason:(NSString *)reason
+{
+    NSAssert([self.deferralReasons containsObject:reason], @"Unbalanced call to endDeferringForReason: with %@", reason);
+    [self.deferralReasons removeObject:reason];
+}
+
+- (BOOL)isDeferring
+{
+    return self.deferralReasons.count > 0 || [[NSRunLoop mainRunLoop].currentMode isEqualToString:UITrackingRunLoopMode];
+}
+
+- (NSUInteger)countOfPendingWork
+{
+    return [[self.queues valueForKeyPath:@"@sum.count"] unsignedIntegerValue];
+}
+
+#pragma mark - Draining
+
+- (void)displayLinkDidFire:(CADisplayLink *)displayLink
+{
+    if (self.isDeferring) {
+        return;
+    }
+    self.countOfDrainingFrames += 1;
+    CFTimeInterval deadline = CACurrentMediaTime() + self.frameBudget;
+    do {
+        ATLMUIWorkItem *item = [self dequeueItem];
+        if (!item) {
+            break;
+        }
+        item.block();
+        // Work may start a transition, which defers whatever is left.
+    } while (CACurrentMediaTime() < deadline && !self.isDeferring);
+    [self stopDisplayLinkIfIdle];
+}
+
+- (ATLMUIWorkItem *)dequeueItem
+{
+    for (NSMutableArray *queue in self.queues) {
+        ATLMUIWorkItem *item = queue.firstObject;
+        if (!item) {
+            continue;
+        }
+        [queue removeObjectAtIndex:0];
+        if (item.coalescingKey) {
+            [self.itemsByCoalescingKey removeObjectForKey:item.coalescingKey];
+        }
+        return item;
+    }
+    return nil;
+}
+
+- (void)stopDisplayLinkIfIdle
+{
+    if (self.countOfPendingWork || !self.displayLink) {
+        return;
+    }
+    [self.displayLink invalidate];
+    self.displayLink = nil;
+}
+
+@end
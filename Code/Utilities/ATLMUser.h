@@ -0,0 +1,46 @@
+//
+//  ATLMUser.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ @abstract The `ATLMUser` describes the user the application authenticates as.
+ @discussion Users are equal when their user IDs are.
+ */
+@interface ATLMUser : NSObject <NSSecureCoding, NSCopying>
+
+@property (nullable, nonatomic, copy) NSString *userID;
+@property (nullable, nonatomic, copy) NSString *firstName;
+@property (nullable, nonatomic, copy) NSString *lastName;
+@property (nullable, nonatomic, copy) NSString *email;
+
+/**
+ @abstract The password and its confirmation entered at registration.
+ @discussion They are never persisted.
+ */
+@property (nullable, nonatomic, copy) NSString *password;
+@property (nullable, nonatomic, copy) NSString *passwordConfirmation;
+
+/**
+ @abstract The first and last names separated by a space.
+ */
+@property (nonnull, nonatomic, readonly) NSString *fullName;
+
+@end
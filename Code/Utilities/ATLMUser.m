@@ -0,0 +1,101 @@
+//
+//  ATLMUser.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMUser.h"
+
+static NSString *const ATLMUserIDKey = @"userID";
+static NSString *const ATLMUserFirstNameKey = @"firstName";
+static NSString *const ATLMUserLastNameKey = @"lastName";
+static NSString *const ATLMUserEmailKey = @"email";
+
+@implementation ATLMUser
+
++ (BOOL)supportsSecureCoding
+{
+    return YES;
+}
+
+- (id)initWithCoder:(NSCoder *)decoder
+{
+    self = [super init];
+    if (self) {
+        _userID = [decoder decodeObjectOfClass:[NSString class] forKey:ATLMUserIDKey];
+        _firstName = [decoder decodeObjectOfClass:[NSString class] forKey:ATLMUserFirstNameKey];
+        _lastName = [decoder decodeObjectOfClass:[NSString class] forKey:ATLMUserLastNameKey];
+        _email = [decoder decodeObjectOfClass:[NSString class] forKey:ATLMUserEmailKey];
+    }
+    return self;
+}
+
+- (void)encodeWithCoder:(NSCoder *)coder
+{
+    [coder encodeObject:self.userID forKey:ATLMUserIDKey];
+    [coder encodeObject:self.firstName forKey:ATLMUserFirstNameKey];
+    [coder encodeObject:self.lastName forKey:ATLMUserLastNameKey];
+    [coder encodeObject:self.email forKey:ATLMUserEmailKey];
+}
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    ATLMUser *user = [[[self class] allocWithZone:zone] init];
+    user.userID = self.userID;
+    user.firstName = self.firstName;
+    user.lastName = self.lastName;
+    user.email = self.email;
+    user.password = self.password;
+    user.passwordConfirmation = self.passwordConfirmation;
+    return user;
+}
+
+- (NSString *)fullName
+{
+    NSMutableArray *names = [NSMutableArray arrayWithCapacity:2];
+    if (self.firstName.length) {
+        [names addObject:self.firstName];
+    }
+    if (self.lastName.length) {
+        [names addObject:self.lastName];
+    }
+    return [names componentsJoinedByString:@" "];
+}
+
+- (BOOL)isEqual:(id)object
+{
+    if (object == self) {
+        return YES;
+    }
+    if (![object isKindOfClass:[ATLMUser class]]) {
+        return NO;
+    }
+    NSString *userID = [object userID];
+    return self.userID == userID || [self.userID isEqualToString:userID];
+}
+
+- (NSUInteger)hash
+{
+    return self.userID.hash;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@:%p userID=%@ fullName=%@>", [self class], self, self.userID, self.fullName];
+}
+
+@end
@@ -32,4 +32,11 @@ NSURL *ATLMRailsBaseURL(ATLMEnvironment environment);
 
 NSString *ATLMApplicationDataDirectory();
 
+/**
+ @abstract Returns the data directory of an account, creating it if needed.
+ @param accountIdentifier The identifier of the account or `nil` for the
+   application data directory.
+ */
+NSString *ATLMAccountDataDirectory(NSString *accountIdentifier);
+
 UIAlertView *ATLMAlertWithError(NSError *error);
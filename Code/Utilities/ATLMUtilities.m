@@ -49,6 +49,19 @@ NSString *ATLMApplicationDataDirectory(void)
     return paths.firstObject;
 }
 
+NSString *ATLMAccountDataDirectory(NSString *accountIdentifier)
+{
+    if (!accountIdentifier) {
+        return ATLMApplicationDataDirectory();
+    }
+    NSString *directory = [[ATLMApplicationDataDirectory() stringByAppendingPathComponent:@"Accounts"] stringByAppendingPathComponent:accountIdentifier];
+    NSError *error;
+    if (![[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:&error]) {
+        NSLog(@"Failed to create the data directory of account %@ with error: %@", accountIdentifier, error);
+    }
+    return directory;
+}
+
 UIAlertView *ATLMAlertWithError(NSError *error)
 {
     UIAlertView *alertView = [[UIAlertView alloc] initWithTitle:@"Unexpected Error"
@@ -0,0 +1,193 @@
+//
+//  ATLMAccountManagerTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMAccountManager.h"
+#import "ATLMLayerController.h"
+#import "ATLMFakeLayerStore.h"
+
+@interface ATLMAccountManagerTest : XCTestCase <ATLMAccountManagerDelegate>
+
+@property (nonatomic) ATLMFakeLayerStore *store;
+@property (nonatomic) ATLMFakeLayerStore *addedAccountStore;  // Backs the accounts added in a test, if set.
+@property (nonatomic) NSString *persistencePath;
+@property (nonatomic) NSMutableArray *requestedAccountIdentifiers;
+@property (nonatomic) NSMutableArray *switchedLayerControllers;
+@property (nonatomic) NSTimeInterval interfaceRebuildDuration;
+
+@end
+
+@implementation ATLMAccountManagerTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.store = [ATLMFakeLayerStore storeWithCorpus:ATLMFakeLayerStoreDefaultCorpus];
+    self.persistencePath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    self.requestedAccountIdentifiers = [NSMutableArray new];
+    self.switchedLayerControllers = [NSMutableArray new];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:self.persistencePath error:nil];
+    [self.store removeAccountData];
+    [self.addedAccountStore removeAccountData];
+    [super tearDown];
+}
+
+- (ATLMAccountManager *)newAccountManager
+{
+    __weak typeof(self) weakSelf = self;
+    ATLMAccountManager *accountManager = [ATLMAccountManager managerWithPersistencePath:self.persistencePath layerControllerFactory:^ATLMLayerController *(NSString *accountIdentifier) {
+        [weakSelf.requestedAccountIdentifiers addObject:accountIdentifier ?: [NSNull null]];
+        ATLMFakeLayerStore *store = (accountIdentifier && weakSelf.addedAccountStore) ? weakSelf.addedAccountStore : weakSelf.store;
+        return [store newLayerController];
+    }];
+    accountManager.delegate = self;
+    return accountManager;
+}
+
+- (void)accountManager:(ATLMAccountManager *)accountManager switchToLayerController:(ATLMLayerController *)layerController completion:(void (^)(void))completion
+{
+    [self.switchedLayerControllers addObject:layerController];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.interfaceRebuildDuration * NSEC_PER_SEC)), dispatch_get_main_queue(), completion);
+}
+
+- (void)waitUntilSwitchedWithAccountManager:(ATLMAccountManager *)accountManager
+{
+    [self expectationForPredicate:[NSPredicate predicateWithFormat:@"switching == NO"] evaluatedWithObject:accountManager handler:nil];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+- (void)testStartsWithTheDefaultAccount
+{
+    ATLMAccountManager *accountManager = [self newAccountManager];
+    expect(accountManager.accounts.count).to.equal(1);
+    expect(accountManager.activeAccount.identifier).to.equal(ATLMDefaultAccountIdentifier);
+    expect(accountManager.activeLayerController).toNot.beNil();
+    expect(self.requestedAccountIdentifiers).to.equal(@[ [NSNull null] ]);
+    expect(accountManager.activeAccount.userID).to.equal(self.store.authenticatedUser.userID);
+}
+
+- (void)testSwitchingBackIsWarm
+{
+    ATLMAccountManager *accountManager = [self newAccountManager];
+    ATLMLayerController *defaultLayerController = accountManager.activeLayerController;
+    ATLMAccount *defaultAccount = accountManager.activeAccount;
+
+    [accountManager switchToNewAccount];
+    [self waitUntilSwitchedWithAccountManager:accountManager];
+    expect(accountManager.countOfColdSwitches).to.equal(1);
+    expect(accountManager.activeAccount).toNot.equal(defaultAccount);
+    expect(self.requestedAccountIdentifiers.lastObject).to.equal(accountManager.activeAccount.identifier);
+
+    [accountManager switchToAccount:defaultAccount];
+    [self waitUntilSwitchedWithAccountManager:accountManager];
+    expect(accountManager.countOfWarmSwitches).to.equal(1);
+    expect(self.switchedLayerControllers.lastObject).to.beIdenticalTo(defaultLayerController);
+    expect(self.requestedAccountIdentifiers.count).to.equal(2);
+    expect(accountManager.accounts.firstObject).to.beIdenticalTo(defaultAccount);
+}
+
+- (void)testReleasesTheLeastRecentlyUsedLayerControllerBeyondCapacity
+{
+    ATLMAccountManager *accountManager = [self newAccountManager];
+    accountManager.capacity = 2;
+    ATLMAccount *defaultAccount = accountManager.activeAccount;
+    [accountManager activeLayerController];
+    for (NSUInteger index = 0; index < 2; index++) {
+        [accountManager switchToNewAccount];
+        [self waitUntilSwitchedWithAccountManager:accountManager];
+    }
+    expect(accountManager.accounts.count).to.equal(3);
+    expect([accountManager hasWarmLayerControllerForAccount:defaultAccount]).to.beFalsy();
+    expect([accountManager hasWarmLayerControllerForAccount:accountManager.accounts[1]]).to.beTruthy();
+
+    [accountManager switchToAccount:defaultAccount];
+    [self waitUntilSwitchedWithAccountManager:accountManager];
+    expect(accountManager.countOfColdSwitches).to.equal(3);
+    expect(accountManager.countOfWarmSwitches).to.equal(0);
+}
+
+- (void)testListsANewAccountOnceSwitchedTo
+{
+    ATLMAccountManager *accountManager = [self newAccountManager];
+    [accountManager activeLayerController];
+    [accountManager switchToNewAccount];
+    expect(accountManager.accounts.count).to.equal(2);
+    expect(accountManager.accounts.firstObject).to.beIdenticalTo(accountManager.activeAccount);
+    [self waitUntilSwitchedWithAccountManager:accountManager];
+    expect([self newAccountManager].accounts.count).to.equal(2);
+}
+
+- (void)testRoutesPushesToTheAccountHavingTheConversation
+{
+    ATLMFakeLayerStoreCorpus corpus = ATLMFakeLayerStoreDefaultCorpus;
+    corpus.conversationCount = 10;
+    self.addedAccountStore = [ATLMFakeLayerStore storeWithCorpus:corpus];
+    ATLMAccountManager *accountManager = [self newAccountManager];
+    ATLMLayerController *defaultLayerController = accountManager.activeLayerController;
+    [accountManager switchToNewAccount];
+    [self waitUntilSwitchedWithAccountManager:accountManager];
+
+    // Only the inactive default account has the conversation.
+    LYRConversation *conversation = self.store.conversations.lastObject;
+    NSDictionary *userInfo = [self.store remoteNotificationForMessage:conversation.lastMessage];
+    expect([accountManager layerControllerForRemoteNotification:userInfo]).to.beIdenticalTo(defaultLayerController);
+
+    // Both have the first one; the active account goes first.
+    conversation = self.store.conversations.firstObject;
+    userInfo = [self.store remoteNotificationForMessage:conversation.lastMessage];
+    expect([accountManager layerControllerForRemoteNotification:userInfo]).to.beIdenticalTo(accountManager.activeLayerController);
+}
+
+- (void)testMeasuresTheSwitchUntilTheInterfaceIsRebuilt
+{
+    ATLMAccountManager *accountManager = [self newAccountManager];
+    self.interfaceRebuildDuration = 0.1;
+    [accountManager switchToNewAccount];
+    expect(accountManager.isSwitching).to.beTruthy();
+    // Switching again while a switch is in progress is ignored.
+    [accountManager switchToNewAccount];
+    [self waitUntilSwitchedWithAccountManager:accountManager];
+    expect(accountManager.accounts.count).to.equal(2);
+    expect(accountManager.lastSwitchDuration).to.beGreaterThanOrEqualTo(0.1);
+    expect(accountManager.lastSwitchDuration).to.beLessThan(1);
+}
+
+- (void)testRestoresTheAccountsAndTheActiveOne
+{
+    ATLMAccountManager *accountManager = [self newAccountManager];
+    [accountManager activeLayerController];
+    [accountManager switchToNewAccount];
+    [self waitUntilSwitchedWithAccountManager:accountManager];
+    NSString *activeAccountIdentifier = accountManager.activeAccount.identifier;
+
+    ATLMAccountManager *restoredAccountManager = [self newAccountManager];
+    expect(restoredAccountManager.accounts.count).to.equal(2);
+    expect(restoredAccountManager.activeAccount.identifier).to.equal(activeAccountIdentifier);
+    expect(restoredAccountManager.accounts.lastObject.identifier).to.equal(ATLMDefaultAccountIdentifier);
+    expect(restoredAccountManager.accounts.lastObject.userID).to.equal(self.store.authenticatedUser.userID);
+}
+
+@end
@@ -0,0 +1,217 @@
+//
+//  ATLMAvatarImagePipelineTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMAvatarImagePipeline.h"
+#import "ATLMAvatarImageServer.h"
+#import "ATLMDiskLRUCache.h"
+#import "ATLMErrors.h"
+
+/**
+ @abstract Returns the alpha of a pixel of an image, from 0 to 255.
+ */
+static uint8_t ATLMTestAlphaOfPixel(UIImage *image, size_t x, size_t y)
+{
+    uint8_t pixel[4] = { 0 };
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(pixel, 1, 1, 8, 4, colorSpace, (CGBitmapInfo)kCGImageAlphaPremultipliedLast);
+    CGColorSpaceRelease(colorSpace);
+    CGContextSetBlendMode(context, kCGBlendModeCopy);
+    CGContextDrawImage(context, CGRectMake(-(CGFloat)x, -(CGFloat)(CGImageGetHeight(image.CGImage) - 1 - y), CGImageGetWidth(image.CGImage), CGImageGetHeight(image.CGImage)), image.CGImage);
+    CGContextRelease(context);
+    return pixel[3];
+}
+
+@interface ATLMAvatarImagePipelineTest : XCTestCase
+
+@property (nonatomic) NSString *directory;
+@property (nonatomic) NSURLSession *session;
+@property (nonatomic) ATLMAvatarImagePipeline *pipeline;
+
+@end
+
+@implementation ATLMAvatarImagePipelineTest
+
+- (void)setUp
+{
+    [super setUp];
+    [ATLMAvatarImageServer reset];
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    self.session = [NSURLSession sessionWithConfiguration:[ATLMAvatarImageServer sessionConfiguration]];
+    self.pipeline = [self newPipeline];
+}
+
+- (void)tearDown
+{
+    [self.session invalidateAndCancel];
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+    [super tearDown];
+}
+
+- (ATLMAvatarImagePipeline *)newPipeline
+{
+    ATLMDiskLRUCache *diskCache = [ATLMDiskLRUCache cacheWithDirectory:self.directory byteLimit:1024 * 1024];
+    ATLMAvatarImagePipeline *pipeline = [ATLMAvatarImagePipeline pipelineWithSession:self.session diskCache:diskCache];
+    pipeline.scale = 2;
+    return pipeline;
+}
+
+- (UIImage *)fetchImageForIdentifier:(NSString *)identifier diameter:(CGFloat)diameter
+{
+    __block UIImage *fetchedImage;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"image fetched"];
+    [self.pipeline fetchImageForURL:[ATLMAvatarImageServer imageURLForIdentifier:identifier] diameter:diameter completion:^(UIImage *image, NSError *error) {
+        fetchedImage = image;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    return fetchedImage;
+}
+
+- (void)testRaisesOnAttemptToInit
+{
+    expect(^{ [ATLMAvatarImagePipeline new]; }).to.raise(NSInternalInconsistencyException);
+}
+
+- (void)testRoundsAtTheDisplaySize
+{
+    [ATLMAvatarImageServer setImagePixelSize:CGSizeMake(600, 400)];
+    UIImage *image = ATLMAvatarImageRoundedFromData([ATLMAvatarImageServer imageDataForIdentifier:@"user-1"], 24, 2);
+    expect(image.size).to.equal(CGSizeMake(24, 24));
+    expect(image.scale).to.equal(2);
+    expect(CGImageGetWidth(image.CGImage)).to.equal(48);
+    expect(ATLMTestAlphaOfPixel(image, 0, 0)).to.equal(0);
+    expect(ATLMTestAlphaOfPixel(image, 47, 47)).to.equal(0);
+    expect(ATLMTestAlphaOfPixel(image, 24, 24)).to.equal(255);
+    // The circle is filled edge to edge along the shorter side of the source.
+    expect(ATLMTestAlphaOfPixel(image, 24, 1)).to.equal(255);
+
+    expect(ATLMAvatarImageRoundedFromData([@"not an image" dataUsingEncoding:NSUTF8StringEncoding], 24, 2)).to.beNil();
+}
+
+- (void)testCoalescesConcurrentFetchesOfAURL
+{
+    NSURL *URL = [ATLMAvatarImageServer imageURLForIdentifier:@"user-1"];
+    NSMutableArray *images = [NSMutableArray new];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"images fetched"];
+    void (^completion)(UIImage *, NSError *) = ^(UIImage *image, NSError *error) {
+        [images addObject:image ?: [NSNull null]];
+        if (images.count == 3) {
+            [expectation fulfill];
+        }
+    };
+    [self.pipeline fetchImageForURL:URL diameter:24 completion:completion];
+    [self.pipeline fetchImageForURL:URL diameter:24 completion:completion];
+    [self.pipeline fetchImageForURL:URL diameter:40 completion:completion];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+
+    expect([images[0] size]).to.equal(CGSizeMake(24, 24));
+    expect(images[1]).to.beIdenticalTo(images[0]);
+    expect([images[2] size]).to.equal(CGSizeMake(40, 40));
+    expect([ATLMAvatarImageServer countOfRequests]).to.equal(1);
+    expect(self.pipeline.countOfDownloads).to.equal(1);
+    expect(self.pipeline.countOfDecodes).to.equal(2);
+    expect(self.pipeline.countOfCoalescedRequests).to.equal(2);
+}
+
+- (void)testServesRepeatFetchesFromMemoryAndDisk
+{
+    NSURL *URL = [ATLMAvatarImageServer imageURLForIdentifier:@"user-1"];
+    expect([self.pipeline cachedImageForURL:URL diameter:32]).to.beNil();
+    UIImage *image = [self fetchImageForIdentifier:@"user-1" diameter:32];
+    expect(image).toNot.beNil();
+    // The fetch following a lookup doesn't count as another miss.
+    expect(self.pipeline.countOfMemoryMisses).to.equal(1);
+
+    expect([self.pipeline cachedImageForURL:URL diameter:32]).to.beIdenticalTo(image);
+    __block UIImage *cachedImage;
+    [self.pipeline fetchImageForURL:URL diameter:32 completion:^(UIImage *image, NSError *error) {
+        cachedImage = image;
+    }];
+    expect(cachedImage).to.beIdenticalTo(image);
+    expect(self.pipeline.countOfMemoryHits).to.equal(1);
+    expect(self.pipeline.memoryHitRate).to.equal(0.5);
+
+    // The rounded image was written to the disk tier, so a new pipeline doesn't download it again.
+    self.pipeline = [self newPipeline];
+    UIImage *diskImage = [self fetchImageForIdentifier:@"user-1" diameter:32];
+    expect(diskImage.size).to.equal(CGSizeMake(32, 32));
+    expect(diskImage.scale).to.equal(2);
+    expect(self.pipeline.countOfDiskHits).to.equal(1);
+    expect(self.pipeline.countOfDownloads).to.equal(0);
+    expect([ATLMAvatarImageServer countOfRequests]).to.equal(1);
+}
+
+- (void)testPrefetchesAreJoinedByFetchesOrCancelled
+{
+    [ATLMAvatarImageServer setLatency:0.3];
+    NSURL *URL = [ATLMAvatarImageServer imageURLForIdentifier:@"user-1"];
+    NSURL *otherURL = [ATLMAvatarImageServer imageURLForIdentifier:@"user-2"];
+    [self.pipeline prefetchImagesForURLs:@[ URL, otherURL ] diameter:24];
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"countOfDownloads == 2"];
+    [self expectationForPredicate:predicate evaluatedWithObject:self.pipeline handler:nil];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+
+    __block UIImage *fetchedImage;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"image fetched"];
+    [self.pipeline fetchImageForURL:URL diameter:24 completion:^(UIImage *image, NSError *error) {
+        fetchedImage = image;
+        [expectation fulfill];
+    }];
+    [self.pipeline cancelPrefetchingImagesForURLs:@[ URL, otherURL ] diameter:24];
+    expect(self.pipeline.countOfCancelledDownloads).to.equal(1);
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+
+    expect(fetchedImage).toNot.beNil();
+    expect(self.pipeline.countOfCoalescedRequests).to.equal(1);
+    expect([self.pipeline cachedImageForURL:otherURL diameter:24]).to.beNil();
+}
+
+- (void)testMemoryTierEvictsTheLeastRecentlyUsed
+{
+    UIImage *image = [self fetchImageForIdentifier:@"user-1" diameter:24];
+    self.pipeline.memoryByteLimit = 2 * ATLMMemoryFootprintOfImage(image);
+    [self fetchImageForIdentifier:@"user-2" diameter:24];
+    expect([self.pipeline cachedImageForURL:[ATLMAvatarImageServer imageURLForIdentifier:@"user-1"] diameter:24]).toNot.beNil();
+    [self fetchImageForIdentifier:@"user-3" diameter:24];
+
+    expect([self.pipeline cachedImageForURL:[ATLMAvatarImageServer imageURLForIdentifier:@"user-1"] diameter:24]).toNot.beNil();
+    expect([self.pipeline cachedImageForURL:[ATLMAvatarImageServer imageURLForIdentifier:@"user-2"] diameter:24]).to.beNil();
+    expect(self.pipeline.memoryFootprint).to.equal(2 * ATLMMemoryFootprintOfImage(image));
+
+    expect([self.pipeline releaseMemory]).to.equal(2 * ATLMMemoryFootprintOfImage(image));
+    expect([self.pipeline cachedImageForURL:[ATLMAvatarImageServer imageURLForIdentifier:@"user-3"] diameter:24]).to.beNil();
+}
+
+- (void)testFailedDownloadsAreReported
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"fetch failed"];
+    [self.pipeline fetchImageForURL:[ATLMAvatarImageServer imageURLForIdentifier:@"missing"] diameter:24 completion:^(UIImage *image, NSError *error) {
+        expect(image).to.beNil();
+        expect(error.code).to.equal(NSURLErrorBadServerResponse);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    expect([self.pipeline cachedImageForURL:[ATLMAvatarImageServer imageURLForIdentifier:@"missing"] diameter:24]).to.beNil();
+}
+
+@end
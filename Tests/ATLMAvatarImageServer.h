@@ -0,0 +1,61 @@
+//
+//  ATLMAvatarImageServer.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <UIKit/UIKit.h>
+
+/**
+ @abstract Stands in for the server hosting avatar images.
+ @discussion An `NSURLProtocol` answering requests to `avatars.atlm.test` with
+   a PNG generated from the last path component, after `latency`. The
+   identifier `missing` is answered with a 404. Sessions use it when created
+   with `sessionConfiguration`; the class methods are thread safe.
+ */
+@interface ATLMAvatarImageServer : NSURLProtocol
+
++ (nonnull NSURLSessionConfiguration *)sessionConfiguration;
+
++ (nonnull NSURL *)imageURLForIdentifier:(nonnull NSString *)identifier;
+
+/**
+ @abstract Returns the PNG served for an identifier.
+ */
++ (nonnull NSData *)imageDataForIdentifier:(nonnull NSString *)identifier;
+
+/**
+ @abstract The time before a response is sent. Defaults to 0.02 seconds.
+ */
++ (void)setLatency:(NSTimeInterval)latency;
+
+/**
+ @abstract The pixel size of the images served. Defaults to 256 by 256.
+ */
++ (void)setImagePixelSize:(CGSize)imagePixelSize;
+
+/**
+ @abstract The number of requests started since the last `reset`.
+ */
++ (NSUInteger)countOfRequests;
+
+/**
+ @abstract Restores the defaults and resets the count of requests.
+ */
++ (void)reset;
+
+@end
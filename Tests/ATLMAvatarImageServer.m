@@ -0,0 +1,147 @@
+//
+//  ATLMAvatarImageServer.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMAvatarImageServer.h"
+#import <ImageIO/ImageIO.h>
+#import <MobileCoreServices/MobileCoreServices.h>
+#import <pthread.h>
+
+static NSString *const ATLMAvatarImageServerHost = @"avatars.atlm.test";
+static NSString *const ATLMAvatarImageServerMissingIdentifier = @"missing";
+static const NSTimeInterval ATLMAvatarImageServerDefaultLatency = 0.02;
+static const CGSize ATLMAvatarImageServerDefaultImagePixelSize = { 256, 256 };
+
+static pthread_mutex_t ATLMAvatarImageServerLock = PTHREAD_MUTEX_INITIALIZER;
+static NSTimeInterval ATLMAvatarImageServerLatency = ATLMAvatarImageServerDefaultLatency;
+static CGSize ATLMAvatarImageServerImagePixelSize = { 256, 256 };
+static NSUInteger ATLMAvatarImageServerCountOfRequests = 0;
+
+@implementation ATLMAvatarImageServer
+
++ (NSURLSessionConfiguration *)sessionConfiguration
+{
+    NSURLSessionConfiguration *configuration = [NSURLSessionConfiguration ephemeralSessionConfiguration];
+    configuration.protocolClasses = @[ self ];
+    return configuration;
+}
+
++ (NSURL *)imageURLForIdentifier:(NSString *)identifier
+{
+    return [NSURL URLWithString:[NSString stringWithFormat:@"http://%@/%@.png", ATLMAvatarImageServerHost, identifier]];
+}
+
++ (NSData *)imageDataForIdentifier:(NSString *)identifier
+{
+    pthread_mutex_lock(&ATLMAvatarImageServerLock);
+    CGSize pixelSize = ATLMAvatarImageServerImagePixelSize;
+    pthread_mutex_unlock(&ATLMAvatarImageServerLock);
+
+    // A gradient in a color of its own per identifier, so every avatar decodes differently.
+    NSUInteger hash = identifier.hash;
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(NULL, (size_t)pixelSize.width, (size_t)pixelSize.height, 8, 0, colorSpace, (CGBitmapInfo)kCGImageAlphaNoneSkipLast);
+    CGFloat colors[] = { (hash & 0xFF) / 255.0, ((hash >> 8) & 0xFF) / 255.0, ((hash >> 16) & 0xFF) / 255.0, 1.0,
+                         1.0, 1.0, 1.0, 1.0 };
+    CGGradientRef gradient = CGGradientCreateWithColorComponents(colorSpace, colors, NULL, 2);
+    CGContextDrawLinearGradient(context, gradient, CGPointZero, CGPointMake(pixelSize.width, pixelSize.height), 0);
+    CGGradientRelease(gradient);
+    CGColorSpaceRelease(colorSpace);
+    CGImageRef image = CGBitmapContextCreateImage(context);
+    CGContextRelease(context);
+
+    NSMutableData *data = [NSMutableData data];
+    CGImageDestinationRef destination = CGImageDestinationCreateWithData((__bridge CFMutableDataRef)data, kUTTypePNG, 1, NULL);
+    CGImageDestinationAddImage(destination, image, NULL);
+    CGImageDestinationFinalize(destination);
+    CFRelease(destination);
+    CGImageRelease(image);
+    return data;
+}
+
++ (void)setLatency:(NSTimeInterval)latency
+{
+    pthread_mutex_lock(&ATLMAvatarImageServerLock);
+    ATLMAvatarImageServerLatency = latency;
+    pthread_mutex_unlock(&ATLMAvatarImageServerLock);
+}
+
++ (void)setImagePixelSize:(CGSize)imagePixelSize
+{
+    pthread_mutex_lock(&ATLMAvatarImageServerLock);
+    ATLMAvatarImageServerImagePixelSize = imagePixelSize;
+    pthread_mutex_unlock(&ATLMAvatarImageServerLock);
+}
+
++ (NSUInteger)countOfRequests
+{
+    pthread_mutex_lock(&ATLMAvatarImageServerLock);
+    NSUInteger countOfRequests = ATLMAvatarImageServerCountOfRequests;
+    pthread_mutex_unlock(&ATLMAvatarImageServerLock);
+    return countOfRequests;
+}
+
++ (void)reset
+{
+    pthread_mutex_lock(&ATLMAvatarImageServerLock);
+    ATLMAvatarImageServerLatency = ATLMAvatarImageServerDefaultLatency;
+    ATLMAvatarImageServerImagePixelSize = ATLMAvatarImageServerDefaultImagePixelSize;
+    ATLMAvatarImageServerCountOfRequests = 0;
+    pthread_mutex_unlock(&ATLMAvatarImageServerLock);
+}
+
+#pragma mark - NSURLProtocol
+
++ (BOOL)canInitWithRequest:(NSURLRequest *)request
+{
+    return [request.URL.host isEqualToString:ATLMAvatarImageServerHost];
+}
+
++ (NSURLRequest *)canonicalRequestForRequest:(NSURLRequest *)request
+{
+    return request;
+}
+
+- (void)startLoading
+{
+    pthread_mutex_lock(&ATLMAvatarImageServerLock);
+    ATLMAvatarImageServerCountOfRequests += 1;
+    NSTimeInterval latency = ATLMAvatarImageServerLatency;
+    pthread_mutex_unlock(&ATLMAvatarImageServerLock);
+    // The client has to be called on the thread loading started on.
+    [self performSelector:@selector(respond) withObject:nil afterDelay:latency];
+}
+
+- (void)stopLoading
+{
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(respond) object:nil];
+}
+
+- (void)respond
+{
+    NSString *identifier = self.request.URL.lastPathComponent.stringByDeletingPathExtension;
+    BOOL missing = [identifier isEqualToString:ATLMAvatarImageServerMissingIdentifier];
+    NSData *data = missing ? [NSData data] : [[self class] imageDataForIdentifier:identifier];
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:self.request.URL statusCode:missing ? 404 : 200 HTTPVersion:@"HTTP/1.1" headerFields:@{ @"Content-Type": @"image/png", @"Content-Length": @(data.length).stringValue }];
+    [self.client URLProtocol:self didReceiveResponse:response cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+    [self.client URLProtocol:self didLoadData:data];
+    [self.client URLProtocolDidFinishLoading:self];
+}
+
+@end
@@ -0,0 +1,388 @@
+//
+//  ATLMBenchmarkSuiteTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import <Atlas/Atlas.h>
+#import "ATLMFakeLayerStore.h"
+#import "ATLMInstrumentation.h"
+#import "ATLMLayerController.h"
+#import "ATLMConversationListViewController.h"
+#import "ATLMConversationViewController.h"
+#import "ATLMAvatarImagePipeline.h"
+#import "ATLMAvatarImageServer.h"
+#import "ATLMDiskLRUCache.h"
+
+/**
+ @abstract The environment variables configuring the suite.
+ @discussion `ATLM_BENCHMARK_RESULTS` is the path the JSON results are written
+   to, `NSTemporaryDirectory()/ATLMBenchmarkResults.json` by default.
+   `ATLM_BENCHMARK_BASELINE` is the path of earlier results to compare with;
+   a benchmark fails when its median is more than `ATLM_BENCHMARK_TOLERANCE`
+   (0.25 by default) slower than the baseline's.
+ */
+static NSString *const ATLMBenchmarkResultsPathVariable = @"ATLM_BENCHMARK_RESULTS";
+static NSString *const ATLMBenchmarkBaselinePathVariable = @"ATLM_BENCHMARK_BASELINE";
+static NSString *const ATLMBenchmarkToleranceVariable = @"ATLM_BENCHMARK_TOLERANCE";
+static const double ATLMBenchmarkDefaultTolerance = 0.25;
+
+static NSMutableDictionary *ATLMBenchmarkResults;
+static ATLMFakeLayerStore *ATLMBenchmarkStore;
+
+@interface ATLMConversationListViewController (Benchmarking)
+
+- (void)prefetchAvatarsForConversations:(NSArray<LYRConversation *> *)conversations;
+
+@end
+
+@interface ATLMBenchmarkSuiteTest : XCTestCase
+
+@property (nonatomic) ATLMFakeLayerStore *store;
+@property (nonatomic) ATLMLayerController *layerController;
+@property (nonatomic) ATLMConversationListViewController *conversationListViewController;
+@property (nonatomic) ATLMConversationViewController *conversationViewController;
+
+@end
+
+@implementation ATLMBenchmarkSuiteTest
+
++ (void)setUp
+{
+    [super setUp];
+    ATLMBenchmarkResults = [NSMutableDictionary new];
+    ATLMBenchmarkStore = [ATLMFakeLayerStore storeWithCorpus:ATLMFakeLayerStoreDefaultCorpus];
+}
+
++ (void)tearDown
+{
+    NSDictionary *environment = [NSProcessInfo processInfo].environment;
+    NSString *path = environment[ATLMBenchmarkResultsPathVariable] ?: [NSTemporaryDirectory() stringByAppendingPathComponent:@"ATLMBenchmarkResults.json"];
+    NSDictionary *report = @{ @"corpus": ATLMFakeLayerStoreCorpusDictionary(ATLMBenchmarkStore.corpus),
+                              @"device": [UIDevice currentDevice].model,
+                              @"system": [UIDevice currentDevice].systemVersion,
+                              @"timestamp": @([NSDate date].timeIntervalSince1970),
+                              @"benchmarks": ATLMBenchmarkResults };
+    NSData *data = [NSJSONSerialization dataWithJSONObject:report options:NSJSONWritingPrettyPrinted error:nil];
+    [data writeToFile:path atomically:YES];
+    NSLog(@"Benchmark results written to %@", path);
+    [ATLMBenchmarkStore removeAccountData];
+    ATLMBenchmarkStore = nil;
+    [super tearDown];
+}
+
+- (void)setUp
+{
+    [super setUp];
+    self.store = ATLMBenchmarkStore;
+    self.layerController = [self.store newLayerController];
+
+    self.conversationListViewController = [ATLMConversationListViewController conversationListViewControllerWithLayerController:self.layerController];
+    self.conversationViewController = [ATLMConversationViewController conversationViewControllerWithLayerController:self.layerController];
+}
+
+- (void)tearDown
+{
+    self.conversationViewController = nil;
+    self.conversationListViewController = nil;
+    self.layerController = nil;
+    [super tearDown];
+}
+
+#pragma mark - Store
+
+- (void)testStoreIsDeterministic
+{
+    ATLMFakeLayerStoreCorpus corpus = { .conversationCount = 20, .messagesPerConversation = 10, .identityCount = 30, .participantsPerConversation = 3, .unreadRatio = 0.5, .seed = 42 };
+    ATLMFakeLayerStore *store = [ATLMFakeLayerStore storeWithCorpus:corpus];
+    ATLMFakeLayerStore *otherStore = [ATLMFakeLayerStore storeWithCorpus:corpus];
+    expect([store.identities valueForKey:@"displayName"]).to.equal([otherStore.identities valueForKey:@"displayName"]);
+    expect([store.conversations valueForKeyPath:@"lastMessage.sender.userID"]).to.equal([otherStore.conversations valueForKeyPath:@"lastMessage.sender.userID"]);
+    expect([store.conversations valueForKey:@"totalNumberOfUnreadMessages"]).to.equal([otherStore.conversations valueForKey:@"totalNumberOfUnreadMessages"]);
+}
+
+- (void)testStoreAnswersQueries
+{
+    LYRConversation *conversation = self.store.conversations[3];
+    expect([self.layerController existingConversationForIdentifier:conversation.identifier]).to.beIdenticalTo(conversation);
+    expect(self.layerController.countOfConversations).to.equal(self.store.corpus.conversationCount);
+    expect(self.layerController.countOfMessages).to.equal(self.store.corpus.conversationCount * self.store.corpus.messagesPerConversation);
+
+    NSUInteger unreadCount = 0;
+    for (LYRConversation *storedConversation in self.store.conversations) {
+        unreadCount += storedConversation.totalNumberOfUnreadMessages;
+    }
+    expect(self.layerController.countOfUnreadMessages).to.equal(unreadCount);
+
+    LYRQuery *query = [LYRQuery queryWithQueryableClass:[LYRConversation class]];
+    query.sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"lastMessage.receivedAt" ascending:NO] ];
+    query.limit = 5;
+    expect([self.store executeQuery:query error:nil].array).to.equal([self.store.conversations subarrayWithRange:NSMakeRange(0, 5)]);
+}
+
+- (void)testStoreChangesAreDispatchedByTheController
+{
+    __block NSUInteger notificationCount = 0;
+    id observer = [[NSNotificationCenter defaultCenter] addObserverForName:ATLMConversationMetadataDidChangeNotification object:nil queue:nil usingBlock:^(NSNotification *notification) {
+        notificationCount += 1;
+    }];
+    [self.layerController layerClient:(LYRClient *)self.store objectsDidChange:[self.store changesForSynchronizationOfConversationCount:10 metadataStride:5]];
+    [[NSNotificationCenter defaultCenter] removeObserver:observer];
+    expect(notificationCount).to.equal(2);
+}
+
+#pragma mark - Micro Benchmarks
+
+- (void)testConversationTitleBenchmark
+{
+    NSArray *conversations = self.store.conversations;
+    id<ATLConversationListViewControllerDataSource> dataSource = (id)self.conversationListViewController;
+    [self measureBenchmark:@"micro.conversation.title" iterations:20000 block:^(NSUInteger iteration) {
+        [dataSource conversationListViewController:self.conversationListViewController titleForConversation:conversations[iteration % conversations.count]];
+    }];
+}
+
+- (void)testUnreadCountBenchmark
+{
+    [self measureBenchmark:@"micro.count.unread" iterations:200 block:^(NSUInteger iteration) {
+        (void)self.layerController.countOfUnreadMessages;
+    }];
+}
+
+- (void)testConversationLookupBenchmark
+{
+    NSArray *conversations = self.store.conversations;
+    [self measureBenchmark:@"micro.conversation.lookup" iterations:20000 block:^(NSUInteger iteration) {
+        [self.layerController existingConversationForIdentifier:[conversations[iteration % conversations.count] identifier]];
+    }];
+}
+
+- (void)testParticipantSearchBenchmark
+{
+    NSArray *identities = self.store.identities;
+    id<ATLConversationListViewControllerDelegate> delegate = (id)self.conversationListViewController;
+    [self measureBenchmark:@"micro.search.participants" iterations:500 block:^(NSUInteger iteration) {
+        LYRIdentity *identity = identities[iteration % identities.count];
+        [delegate conversationListViewController:self.conversationListViewController didSearchForText:identity.lastName completion:^(NSSet *participants) {}];
+    }];
+}
+
+- (void)testRecipientStatusBenchmark
+{
+    NSArray *messages = [self.store messagesInConversation:self.store.conversations.firstObject];
+    [self measureBenchmark:@"micro.recipient.status" iterations:20000 block:^(NSUInteger iteration) {
+        LYRMessage *message = messages[iteration % messages.count];
+        [self.conversationViewController conversationViewController:self.conversationViewController attributedStringForDisplayOfRecipientStatus:message.recipientStatusByUserID];
+    }];
+}
+
+- (void)testChangeDispatchBenchmark
+{
+    NSArray *changes = [self.store changesForSynchronizationOfConversationCount:1 metadataStride:1];
+    [self measureBenchmark:@"micro.changes.dispatch" iterations:20000 block:^(NSUInteger iteration) {
+        [self.layerController layerClient:(LYRClient *)self.store objectsDidChange:changes];
+    }];
+}
+
+#pragma mark - Macro Benchmarks
+
+/**
+ @abstract Everything the conversation list asks for when it is first shown.
+ */
+- (void)testConversationListBenchmark
+{
+    NSArray *conversations = self.store.conversations;
+    id<ATLConversationListViewControllerDataSource> dataSource = (id)self.conversationListViewController;
+    [self measureBenchmark:@"macro.conversation.list" iterations:20 block:^(NSUInteger iteration) {
+        for (LYRConversation *conversation in conversations) {
+            [dataSource conversationListViewController:self.conversationListViewController titleForConversation:conversation];
+        }
+        (void)self.layerController.countOfUnreadMessages;
+    }];
+}
+
+/**
+ @abstract Opening a conversation and laying out the status of every message.
+ */
+- (void)testConversationOpenBenchmark
+{
+    NSArray *conversations = self.store.conversations;
+    [self measureBenchmark:@"macro.conversation.open" iterations:50 block:^(NSUInteger iteration) {
+        LYRConversation *conversation = [self.layerController existingConversationForIdentifier:[conversations[iteration % conversations.count] identifier]];
+        for (LYRMessage *message in [self.store messagesInConversation:conversation]) {
+            [self.conversationViewController conversationViewController:self.conversationViewController attributedStringForDisplayOfRecipientStatus:message.recipientStatusByUserID];
+        }
+    }];
+}
+
+/**
+ @abstract Typing a name into the search bar, one query per keystroke.
+ */
+- (void)testSearchAsYouTypeBenchmark
+{
+    NSString *name = [self.store.identities[7] displayName];
+    id<ATLConversationListViewControllerDelegate> delegate = (id)self.conversationListViewController;
+    [self measureBenchmark:@"macro.search.typing" iterations:20 block:^(NSUInteger iteration) {
+        for (NSUInteger length = 1; length <= name.length; length++) {
+            [delegate conversationListViewController:self.conversationListViewController didSearchForText:[name substringToIndex:length] completion:^(NSSet *participants) {}];
+        }
+    }];
+}
+
+/**
+ @abstract A synchronization touching half of the conversations while a
+   screen per conversation observes the controller's notifications.
+ */
+- (void)testSynchronizationFanOutBenchmark
+{
+    NSMutableArray *observers = [NSMutableArray new];
+    for (LYRConversation *conversation in self.store.conversations) {
+        [observers addObject:[[NSNotificationCenter defaultCenter] addObserverForName:ATLMConversationMetadataDidChangeNotification object:conversation queue:nil usingBlock:^(NSNotification *notification) {}]];
+    }
+    NSArray *changes = [self.store changesForSynchronizationOfConversationCount:self.store.conversations.count / 2 metadataStride:4];
+    [self measureBenchmark:@"macro.synchronization.fanout" iterations:200 block:^(NSUInteger iteration) {
+        [self.layerController layerClient:(LYRClient *)self.store objectsDidChange:changes];
+    }];
+    for (id observer in observers) {
+        [[NSNotificationCenter defaultCenter] removeObserver:observer];
+    }
+}
+
+/**
+ @abstract Scrolling the conversation list down through every conversation
+   and back up, a row per frame, with avatars served by the image server
+   stand-in.
+ @discussion Each frame asks for the avatars of the visible rows and
+   prefetches those of the upcoming ones, like the table view would, then
+   leaves the rest of the frame to the run loop delivering the images. Records
+   the main thread time per frame, the frames over budget and the hit rate of
+   the memory tier.
+ */
+- (void)testAvatarScrollBenchmark
+{
+    static const NSUInteger visibleRowCount = 8;
+    static const NSUInteger prefetchRowCount = 10;
+    static const NSTimeInterval frameDuration = 1.0 / 60;
+    for (LYRIdentity *identity in self.store.identities) {
+        [(id)identity setValue:[ATLMAvatarImageServer imageURLForIdentifier:identity.userID] forKey:@"avatarImageURL"];
+    }
+    [ATLMAvatarImageServer reset];
+    NSURLSession *session = [NSURLSession sessionWithConfiguration:[ATLMAvatarImageServer sessionConfiguration]];
+    NSString *directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    ATLMAvatarImagePipeline *pipeline = [ATLMAvatarImagePipeline pipelineWithSession:session diskCache:[ATLMDiskLRUCache cacheWithDirectory:directory byteLimit:20 * 1024 * 1024]];
+    self.conversationListViewController.avatarImagePipeline = pipeline;
+
+    NSArray *conversations = self.store.conversations;
+    id<ATLConversationListViewControllerDelegate> delegate = (id)self.conversationListViewController;
+    NSString *name = @"macro.avatars.scroll";
+    ATLMInstrumentation *instrumentation = [ATLMInstrumentation instrumentation];
+    NSUInteger lastFirstRow = conversations.count - visibleRowCount;
+    NSUInteger countOfDroppedFrames = 0;
+    for (NSUInteger frame = 0; frame <= 2 * lastFirstRow; frame++) {
+        @autoreleasepool {
+            BOOL scrollingDown = frame <= lastFirstRow;
+            NSUInteger firstRow = scrollingDown ? frame : 2 * lastFirstRow - frame;
+            CFAbsoluteTime frameStart = CFAbsoluteTimeGetCurrent();
+            uint64_t start = [instrumentation beginInterval:name];
+            for (NSUInteger row = firstRow; row < firstRow + visibleRowCount; row++) {
+                [delegate conversationListViewController:self.conversationListViewController avatarItemForConversation:conversations[row]];
+            }
+            NSRange upcomingRows = scrollingDown ? NSMakeRange(firstRow + visibleRowCount, MIN(prefetchRowCount, conversations.count - firstRow - visibleRowCount)) : NSMakeRange(firstRow - MIN(prefetchRowCount, firstRow), MIN(prefetchRowCount, firstRow));
+            [self.conversationListViewController prefetchAvatarsForConversations:[conversations subarrayWithRange:upcomingRows]];
+            [instrumentation endInterval:name start:start];
+            [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceReferenceDate:frameStart + frameDuration]];
+            if (CFAbsoluteTimeGetCurrent() - frameStart > 1.5 * frameDuration) {
+                countOfDroppedFrames += 1;
+            }
+        }
+    }
+
+    NSMutableDictionary *result = [[instrumentation snapshot][@"histograms"][name] mutableCopy];
+    result[@"hitRate"] = @(pipeline.memoryHitRate);
+    result[@"droppedFrames"] = @(countOfDroppedFrames);
+    result[@"downloads"] = @(pipeline.countOfDownloads);
+    result[@"diskHits"] = @(pipeline.countOfDiskHits);
+    [self recordBenchmark:name result:result];
+    NSLog(@"Benchmark %@: hit rate %.2f, %lu dropped frames, %lu downloads", name, pipeline.memoryHitRate, (unsigned long)countOfDroppedFrames, (unsigned long)pipeline.countOfDownloads);
+
+    // Every avatar is downloaded at most once, however often it scrolls by.
+    NSSet *avatarImageURLs = [NSSet setWithArray:[self.store.identities valueForKey:@"avatarImageURL"]];
+    expect(pipeline.countOfDownloads).to.beLessThanOrEqualTo(avatarImageURLs.count);
+    expect([ATLMAvatarImageServer countOfRequests]).to.equal(pipeline.countOfDownloads);
+
+    [session invalidateAndCancel];
+    [[NSFileManager defaultManager] removeItemAtPath:directory error:nil];
+    for (LYRIdentity *identity in self.store.identities) {
+        [(id)identity setValue:nil forKey:@"avatarImageURL"];
+    }
+}
+
+#pragma mark - Helpers
+
+/**
+ @abstract Runs the block `iterations` times after a warm-up, records the
+   durations and compares their median against the baseline.
+ */
+- (void)measureBenchmark:(NSString *)name iterations:(NSUInteger)iterations block:(void (^)(NSUInteger iteration))block
+{
+    for (NSUInteger iteration = 0; iteration < MAX(iterations / 10, 1); iteration++) {
+        block(iteration);
+    }
+    ATLMInstrumentation *instrumentation = [ATLMInstrumentation instrumentation];
+    for (NSUInteger iteration = 0; iteration < iterations; iteration++) {
+        @autoreleasepool {
+            uint64_t start = [instrumentation beginInterval:name];
+            block(iteration);
+            [instrumentation endInterval:name start:start];
+        }
+    }
+    [self recordBenchmark:name result:[instrumentation snapshot][@"histograms"][name]];
+}
+
+/**
+ @abstract Adds a histogram to the results and compares its median against the baseline.
+ */
+- (void)recordBenchmark:(NSString *)name result:(NSDictionary *)result
+{
+    ATLMBenchmarkResults[name] = result;
+    NSLog(@"Benchmark %@: p50 %.1f us, p95 %.1f us, max %.1f us (n=%@)", name, [result[ATLMMetricP50Key] doubleValue], [result[ATLMMetricP95Key] doubleValue], [result[ATLMMetricMaxKey] doubleValue], result[ATLMMetricCountKey]);
+
+    NSDictionary *baselineResult = [self baseline][name];
+    if (baselineResult) {
+        double tolerance = [NSProcessInfo processInfo].environment[ATLMBenchmarkToleranceVariable].doubleValue ?: ATLMBenchmarkDefaultTolerance;
+        double limit = [baselineResult[ATLMMetricP50Key] doubleValue] * (1 + tolerance);
+        XCTAssertLessThanOrEqual([result[ATLMMetricP50Key] doubleValue], limit, @"%@ regressed against the baseline", name);
+    }
+}
+
+- (NSDictionary *)baseline
+{
+    static NSDictionary *baseline;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSString *path = [NSProcessInfo processInfo].environment[ATLMBenchmarkBaselinePathVariable];
+        NSData *data = path ? [NSData dataWithContentsOfFile:path] : nil;
+        NSDictionary *report = data ? [NSJSONSerialization JSONObjectWithData:data options:0 error:nil] : nil;
+        baseline = [report isKindOfClass:[NSDictionary class]] ? report[@"benchmarks"] : @{};
+    });
+    return baseline;
+}
+
+@end
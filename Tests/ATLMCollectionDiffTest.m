@@ -0,0 +1,241 @@
+//
+//  ATLMCollectionDiffTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMCollectionDiff.h"
+
+static ATLMCollectionDiffKeyBlock ATLMTestKeyBlock = ^id<NSCopying>(NSString *object) {
+    return object;
+};
+
+/**
+ @abstract Replays the diff the way `UITableView` applies a batch update and
+   returns the resulting collection.
+ */
+static NSArray *ATLMApplyDiff(ATLMCollectionDiff *diff, NSArray *oldObjects, NSArray *newObjects)
+{
+    NSUInteger newCount = oldObjects.count - diff.deletedIndexes.count + diff.insertedIndexes.count;
+    NSMutableArray *result = [NSMutableArray arrayWithCapacity:newCount];
+    for (NSUInteger index = 0; index < newCount; index++) {
+        [result addObject:[NSNull null]];
+    }
+    NSMutableIndexSet *removedIndexes = [diff.deletedIndexes mutableCopy];
+    [diff.insertedIndexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        result[index] = newObjects[index];
+    }];
+    for (ATLMCollectionMove *move in diff.moves) {
+        result[move.toIndex] = oldObjects[move.fromIndex];
+        [removedIndexes addIndex:move.fromIndex];
+    }
+    // The rows neither deleted nor moved keep their relative order.
+    NSUInteger slot = 0;
+    for (NSUInteger index = 0; index < oldObjects.count; index++) {
+        if ([removedIndexes containsIndex:index]) {
+            continue;
+        }
+        while (result[slot] != [NSNull null]) {
+            slot++;
+        }
+        result[slot] = oldObjects[index];
+    }
+    return result;
+}
+
+static NSMutableArray *ATLMTestParticipants(NSUInteger count)
+{
+    NSMutableArray *participants = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger index = 0; index < count; index++) {
+        [participants addObject:[NSString stringWithFormat:@"user-%05lu", (unsigned long)index]];
+    }
+    return participants;
+}
+
+/**
+ @abstract Simulates churn in a large conversation: removes and adds `fraction`
+   of the participants and renames a few, which moves them in the sorted list.
+ */
+static NSArray *ATLMChurnedParticipants(NSArray *participants, double fraction, NSUInteger seed)
+{
+    srand48(seed);
+    NSMutableArray *churned = [participants mutableCopy];
+    NSUInteger changes = (NSUInteger)(participants.count * fraction);
+    for (NSUInteger index = 0; index < changes; index++) {
+        [churned removeObjectAtIndex:(NSUInteger)(drand48() * churned.count)];
+    }
+    for (NSUInteger index = 0; index < changes; index++) {
+        [churned insertObject:[NSString stringWithFormat:@"new-%05lu", (unsigned long)index] atIndex:(NSUInteger)(drand48() * churned.count)];
+    }
+    for (NSUInteger index = 0; index < changes / 10; index++) {
+        NSUInteger from = (NSUInteger)(drand48() * churned.count);
+        id object = churned[from];
+        [churned removeObjectAtIndex:from];
+        [churned insertObject:object atIndex:(NSUInteger)(drand48() * churned.count)];
+    }
+    return churned;
+}
+
+/**
+ @abstract Minimal single section data source backed by whatever the rows block returns.
+ */
+@interface ATLMCollectionDiffTestDataSource : NSObject <UITableViewDataSource>
+
+@property (nonatomic, copy) NSArray *(^rowsBlock)(void);
+
+- (id)initWithRowsBlock:(NSArray *(^)(void))rowsBlock;
+
+@end
+
+@implementation ATLMCollectionDiffTestDataSource
+
+- (id)initWithRowsBlock:(NSArray *(^)(void))rowsBlock
+{
+    self = [super init];
+    if (self) {
+        _rowsBlock = [rowsBlock copy];
+    }
+    return self;
+}
+
+- (NSInteger)tableView:(UITableView *)tableView numberOfRowsInSection:(NSInteger)section
+{
+    return self.rowsBlock().count;
+}
+
+- (UITableViewCell *)tableView:(UITableView *)tableView cellForRowAtIndexPath:(NSIndexPath *)indexPath
+{
+    UITableViewCell *cell = [tableView dequeueReusableCellWithIdentifier:@"Cell"] ?: [[UITableViewCell alloc] initWithStyle:UITableViewCellStyleDefault reuseIdentifier:@"Cell"];
+    cell.textLabel.text = self.rowsBlock()[indexPath.row];
+    return cell;
+}
+
+@end
+
+@interface ATLMCollectionDiffTest : XCTestCase
+
+@end
+
+@implementation ATLMCollectionDiffTest
+
+- (void)testRaisesOnAttemptToInit
+{
+    expect(^{ [ATLMCollectionDiff new]; }).to.raise(NSInternalInconsistencyException);
+}
+
+- (void)testIdenticalCollectionsHaveNoChanges
+{
+    NSArray *participants = ATLMTestParticipants(100);
+    ATLMCollectionDiff *diff = [ATLMCollectionDiff diffFromObjects:participants toObjects:[participants copy] keyBlock:ATLMTestKeyBlock];
+    expect(diff.hasChanges).to.beFalsy();
+}
+
+- (void)testInsertionsAndDeletions
+{
+    ATLMCollectionDiff *diff = [ATLMCollectionDiff diffFromObjects:@[ @"a", @"b", @"c", @"d" ] toObjects:@[ @"a", @"x", @"c", @"d", @"y" ] keyBlock:ATLMTestKeyBlock];
+    expect(diff.deletedIndexes).to.equal([NSIndexSet indexSetWithIndex:1]);
+    NSMutableIndexSet *inserted = [NSMutableIndexSet indexSetWithIndex:1];
+    [inserted addIndex:4];
+    expect(diff.insertedIndexes).to.equal(inserted);
+    expect(diff.moves).to.beEmpty();
+}
+
+- (void)testMovesAreMinimal
+{
+    // Moving the last object to the front is a single move, not n - 1.
+    NSArray *oldObjects = @[ @"a", @"b", @"c", @"d", @"e" ];
+    NSArray *newObjects = @[ @"e", @"a", @"b", @"c", @"d" ];
+    ATLMCollectionDiff *diff = [ATLMCollectionDiff diffFromObjects:oldObjects toObjects:newObjects keyBlock:ATLMTestKeyBlock];
+    expect(diff.moves).to.haveCountOf(1);
+    expect(diff.moves.firstObject.fromIndex).to.equal(4);
+    expect(diff.moves.firstObject.toIndex).to.equal(0);
+    expect(diff.deletedIndexes).to.haveCountOf(0);
+    expect(diff.insertedIndexes).to.haveCountOf(0);
+    expect(ATLMApplyDiff(diff, oldObjects, newObjects)).to.equal(newObjects);
+}
+
+- (void)testChangedObjectsAreReportedAsUpdates
+{
+    NSArray *oldObjects = @[ @{ @"id": @"a", @"name": @"Alice" }, @{ @"id": @"b", @"name": @"Bob" } ];
+    NSArray *newObjects = @[ @{ @"id": @"a", @"name": @"Alicia" }, @{ @"id": @"b", @"name": @"Bob" } ];
+    ATLMCollectionDiff *diff = [ATLMCollectionDiff diffFromObjects:oldObjects toObjects:newObjects keyBlock:^id<NSCopying>(NSDictionary *object) {
+        return object[@"id"];
+    }];
+    expect(diff.updatedIndexes).to.equal([NSIndexSet indexSetWithIndex:0]);
+    expect(diff.moves).to.beEmpty();
+}
+
+- (void)testDuplicateKeysAreMatchedInOrder
+{
+    NSArray *oldObjects = @[ @"a", @"b", @"a" ];
+    NSArray *newObjects = @[ @"b", @"a", @"a", @"a" ];
+    ATLMCollectionDiff *diff = [ATLMCollectionDiff diffFromObjects:oldObjects toObjects:newObjects keyBlock:ATLMTestKeyBlock];
+    expect(diff.insertedIndexes).to.haveCountOf(1);
+    expect(ATLMApplyDiff(diff, oldObjects, newObjects)).to.equal(newObjects);
+}
+
+- (void)testReplayingRandomChurnProducesTheNewCollection
+{
+    NSArray *participants = ATLMTestParticipants(1000);
+    for (NSUInteger seed = 1; seed <= 20; seed++) {
+        NSArray *churned = ATLMChurnedParticipants(participants, 0.1, seed);
+        ATLMCollectionDiff *diff = [ATLMCollectionDiff diffFromObjects:participants toObjects:churned keyBlock:ATLMTestKeyBlock];
+        expect(ATLMApplyDiff(diff, participants, churned)).to.equal(churned);
+        expect(diff.moves.count).to.beLessThanOrEqualTo(10);
+    }
+}
+
+#pragma mark - Benchmarks
+
+- (void)testPerformanceOfDiffingLargeParticipantChurn
+{
+    NSArray *participants = ATLMTestParticipants(5000);
+    NSArray *churned = ATLMChurnedParticipants(participants, 0.2, 42);
+    [self measureBlock:^{
+        ATLMCollectionDiff *diff = [ATLMCollectionDiff diffFromObjects:participants toObjects:churned keyBlock:ATLMTestKeyBlock];
+        expect(diff.hasChanges).to.beTruthy();
+    }];
+}
+
+- (void)testPerformanceOfApplyingLargeParticipantChurnToTableView
+{
+    NSArray *participants = ATLMTestParticipants(5000);
+    NSArray *churned = ATLMChurnedParticipants(participants, 0.2, 42);
+    UITableView *tableView = [[UITableView alloc] initWithFrame:CGRectMake(0, 0, 320, 568) style:UITableViewStylePlain];
+    [self measureMetrics:[[self class] defaultPerformanceMetrics] automaticallyStartMeasuring:NO forBlock:^{
+        __block NSArray *rows = participants;
+        id dataSource = [[ATLMCollectionDiffTestDataSource alloc] initWithRowsBlock:^NSArray *{ return rows; }];
+        tableView.dataSource = dataSource;
+        [tableView reloadData];
+        [tableView layoutIfNeeded];
+
+        [self startMeasuring];
+        ATLMCollectionDiff *diff = [ATLMCollectionDiff diffFromObjects:participants toObjects:churned keyBlock:ATLMTestKeyBlock];
+        rows = churned;
+        [diff applyToTableView:tableView section:0 withRowAnimation:UITableViewRowAnimationNone];
+        [tableView layoutIfNeeded];
+        [self stopMeasuring];
+
+        expect([tableView numberOfRowsInSection:0]).to.equal(churned.count);
+        tableView.dataSource = nil;
+    }];
+}
+
+@end
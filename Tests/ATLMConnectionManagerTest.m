@@ -0,0 +1,247 @@
+//
+//  ATLMConnectionManagerTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <UIKit/UIKit.h>
+#import <SystemConfiguration/SystemConfiguration.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMConnectionManager.h"
+
+@interface ATLMConnectionManager (Testing)
+
+- (void)networkReachabilityDidChangeWithFlags:(SCNetworkReachabilityFlags)flags;
+
+@end
+
+/**
+ @abstract Stands in for the connection of `LYRClient` over a network that drops.
+ @discussion Like the client, each call to `connectWithCompletion:` makes up
+   to `attemptLimit` attempts and posts a notification before each of them.
+ */
+@interface ATLMFakeConnectingClient : NSObject <ATLMConnecting>
+
+@property (nonatomic, readwrite) BOOL isConnected;
+@property (nonatomic, readwrite) BOOL isConnecting;
+@property (nonatomic) NSTimeInterval attemptLatency;
+@property (nonatomic) NSUInteger attemptLimit;
+@property (nonatomic) NSUInteger countOfFailingAttempts;
+
+- (void)dropConnection;
+- (void)finishSynchronization;
+
+@end
+
+@implementation ATLMFakeConnectingClient
+
+- (id)init
+{
+    self = [super init];
+    if (self) {
+        _attemptLatency = 0.01;
+        _attemptLimit = 3;
+    }
+    return self;
+}
+
+- (void)connectWithCompletion:(void (^)(BOOL, NSError *))completion
+{
+    self.isConnecting = YES;
+    [self attemptConnection:1 completion:completion];
+}
+
+- (void)attemptConnection:(NSUInteger)attemptNumber completion:(void (^)(BOOL, NSError *))completion
+{
+    [[NSNotificationCenter defaultCenter] postNotificationName:LYRClientWillAttemptToConnectNotification object:self userInfo:@{ @"attemptNumber": @(attemptNumber), @"attemptLimit": @(self.attemptLimit) }];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.attemptLatency * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        if (self.countOfFailingAttempts > 0) {
+            self.countOfFailingAttempts -= 1;
+            if (attemptNumber < self.attemptLimit) {
+                [self attemptConnection:attemptNumber + 1 completion:completion];
+                return;
+            }
+            self.isConnecting = NO;
+            if (completion) completion(NO, [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNotConnectedToInternet userInfo:nil]);
+            return;
+        }
+        self.isConnecting = NO;
+        self.isConnected = YES;
+        [[NSNotificationCenter defaultCenter] postNotificationName:LYRClientDidConnectNotification object:self];
+        if (completion) completion(YES, nil);
+    });
+}
+
+- (void)dropConnection
+{
+    self.isConnected = NO;
+    [[NSNotificationCenter defaultCenter] postNotificationName:LYRClientDidLoseConnectionNotification object:self];
+}
+
+- (void)finishSynchronization
+{
+    [[NSNotificationCenter defaultCenter] postNotificationName:LYRClientDidFinishSynchronizationNotification object:self];
+}
+
+@end
+
+@interface ATLMConnectionManagerTest : XCTestCase <ATLMConnectionManagerDelegate>
+
+@property (nonatomic) ATLMFakeConnectingClient *client;
+@property (nonatomic) ATLMConnectionManager *connectionManager;
+@property (nonatomic) NSMutableArray *presentedStatuses;
+
+@end
+
+@implementation ATLMConnectionManagerTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.client = [ATLMFakeConnectingClient new];
+    self.connectionManager = [ATLMConnectionManager managerWithClient:self.client];
+    self.connectionManager.delegate = self;
+    self.connectionManager.initialRetryInterval = 0.05;
+    self.connectionManager.statusPresentationDelay = 0.2;
+    // Whatever the network of the machine running the tests.
+    [self.connectionManager networkReachabilityDidChangeWithFlags:kSCNetworkReachabilityFlagsReachable];
+    self.presentedStatuses = [NSMutableArray new];
+}
+
+- (void)tearDown
+{
+    self.connectionManager = nil;
+    self.client = nil;
+    [super tearDown];
+}
+
+- (void)connectionManager:(ATLMConnectionManager *)connectionManager didChangePresentedStatus:(ATLMConnectionStatus)status
+{
+    [self.presentedStatuses addObject:@(status)];
+}
+
+- (void)waitForConnectionCount:(NSUInteger)connectionCount
+{
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"countOfConnections == %lu", (unsigned long)connectionCount];
+    [self expectationForPredicate:predicate evaluatedWithObject:self.connectionManager handler:nil];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+}
+
+- (void)testTimeToConnectAndAttemptsAreMeasured
+{
+    self.client.attemptLatency = 0.05;
+    self.client.countOfFailingAttempts = 2;
+    [self.connectionManager connect];
+    expect(self.connectionManager.status).to.equal(ATLMConnectionStatusConnecting);
+    [self waitForConnectionCount:1];
+    expect(self.connectionManager.status).to.equal(ATLMConnectionStatusConnected);
+    expect(self.connectionManager.countOfConnectionAttempts).to.equal(3);
+    expect(self.connectionManager.lastConnectionAttemptCount).to.equal(3);
+    expect(self.connectionManager.lastTimeToConnect).to.beGreaterThanOrEqualTo(0.15);
+    expect(self.connectionManager.countOfScheduledReconnects).to.equal(0);
+
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+    [self.client finishSynchronization];
+    [self.client finishSynchronization];
+    NSTimeInterval timeToFirstSynchronization = self.connectionManager.lastTimeToFirstSynchronization;
+    expect(timeToFirstSynchronization).to.beGreaterThanOrEqualTo(0.05);
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+    [self.client finishSynchronization];
+    expect(self.connectionManager.lastTimeToFirstSynchronization).to.equal(timeToFirstSynchronization);
+}
+
+- (void)testReconnectsWithBackoffOnceTheClientGivesUp
+{
+    self.client.attemptLimit = 2;
+    self.client.countOfFailingAttempts = 4;
+    [self.connectionManager connect];
+    [self waitForConnectionCount:1];
+    expect(self.connectionManager.countOfScheduledReconnects).to.equal(2);
+    expect(self.connectionManager.countOfConnectionAttempts).to.equal(5);
+    expect(self.connectionManager.lastConnectionAttemptCount).to.equal(5);
+    // The second reconnect waits twice as long as the first, give or take the jitter.
+    expect(self.connectionManager.lastTimeToConnect).to.beGreaterThanOrEqualTo(0.05 * 0.8 + 0.1 * 0.8);
+}
+
+- (void)testLostConnectionsAreReconnectedAndMeasured
+{
+    [self.connectionManager connect];
+    [self waitForConnectionCount:1];
+    [self.client dropConnection];
+    expect(self.connectionManager.status).to.equal(ATLMConnectionStatusDisconnected);
+    [self waitForConnectionCount:2];
+    expect(self.connectionManager.countOfConnectionLosses).to.equal(1);
+    expect(self.connectionManager.totalTimeDisconnected).to.beGreaterThanOrEqualTo(0.05 * 0.8);
+    expect(self.connectionManager.totalTimeDisconnected).to.beLessThan(1);
+}
+
+- (void)testForegroundSkipsTheBackoff
+{
+    self.connectionManager.initialRetryInterval = 60;
+    self.client.attemptLimit = 1;
+    self.client.countOfFailingAttempts = 1;
+    [self.connectionManager connect];
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"countOfScheduledReconnects == 1"];
+    [self expectationForPredicate:predicate evaluatedWithObject:self.connectionManager handler:nil];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    [[NSNotificationCenter defaultCenter] postNotificationName:UIApplicationWillEnterForegroundNotification object:nil];
+    [self waitForConnectionCount:1];
+    expect(self.connectionManager.lastTimeToConnect).to.beLessThan(1);
+}
+
+- (void)testNetworkReachabilitySkipsTheBackoff
+{
+    self.connectionManager.initialRetryInterval = 60;
+    self.client.attemptLimit = 1;
+    self.client.countOfFailingAttempts = 1;
+    [self.connectionManager networkReachabilityDidChangeWithFlags:0];
+    [self.connectionManager connect];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    // Nothing is scheduled while the network is unreachable.
+    expect(self.connectionManager.countOfScheduledReconnects).to.equal(0);
+    expect(self.connectionManager.status).to.equal(ATLMConnectionStatusDisconnected);
+
+    [self.connectionManager networkReachabilityDidChangeWithFlags:kSCNetworkReachabilityFlagsReachable];
+    [self waitForConnectionCount:1];
+    expect(self.connectionManager.isNetworkReachable).to.beTruthy();
+}
+
+- (void)testShortOutagesAreNotPresented
+{
+    [self.connectionManager connect];
+    [self waitForConnectionCount:1];
+    for (NSUInteger connectionCount = 2; connectionCount <= 4; connectionCount++) {
+        [self.client dropConnection];
+        [self waitForConnectionCount:connectionCount];
+    }
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.3]];
+    expect(self.presentedStatuses).to.equal(@[]);
+
+    // Retries past the delay show the outage once and then its end.
+    self.client.attemptLimit = 1;
+    self.client.countOfFailingAttempts = 4;
+    [self.client dropConnection];
+    [self waitForConnectionCount:5];
+    expect(self.presentedStatuses.count).to.equal(2);
+    expect(self.presentedStatuses.lastObject).to.equal(@(ATLMConnectionStatusConnected));
+    expect(self.connectionManager.countOfPresentedStatusChanges).to.equal(2);
+}
+
+@end
@@ -0,0 +1,240 @@
+//
+//  ATLMConversationEventBusTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMConversationEventBus.h"
+#import "ATLMFakeLayerStore.h"
+#import "ATLMLayerController.h"
+
+static const NSUInteger ATLMEventBusBenchmarkControllerCount = 20;
+static const NSUInteger ATLMEventBusBenchmarkEventCount = 100000;
+
+/**
+ @abstract Stands in for a view controller showing a single conversation.
+ */
+@interface ATLMEventBusTestController : NSObject
+
+@property (nonatomic) LYRConversation *conversation;
+@property (nonatomic) NSUInteger countOfWakeups;
+@property (nonatomic) NSUInteger countOfWastedWakeups;
+
+@end
+
+@implementation ATLMEventBusTestController
+
+- (void)conversationDidChange:(LYRConversation *)conversation
+{
+    self.countOfWakeups += 1;
+    if (![conversation isEqual:self.conversation]) {
+        self.countOfWastedWakeups += 1;
+    }
+}
+
+- (void)conversationMetadataDidChange:(NSNotification *)notification
+{
+    [self conversationDidChange:notification.object];
+}
+
+@end
+
+@interface ATLMConversationEventBusTest : XCTestCase
+
+@property (nonatomic) ATLMFakeLayerStore *store;
+@property (nonatomic) ATLMConversationEventBus *bus;
+
+@end
+
+@implementation ATLMConversationEventBusTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.store = [ATLMFakeLayerStore storeWithCorpus:ATLMFakeLayerStoreDefaultCorpus];
+    self.bus = [ATLMConversationEventBus bus];
+}
+
+- (void)tearDown
+{
+    self.bus = nil;
+    [self.store removeAccountData];
+    self.store = nil;
+    [super tearDown];
+}
+
+- (ATLMEventBusTestController *)subscribedControllerForConversation:(LYRConversation *)conversation kind:(ATLMConversationEventKind)kind
+{
+    ATLMEventBusTestController *controller = [ATLMEventBusTestController new];
+    controller.conversation = conversation;
+    [self.bus subscribeObserver:controller toEventKind:kind conversationIdentifier:conversation.identifier queue:nil handler:^(ATLMEventBusTestController *observer, ATLMConversationEvent *event) {
+        [observer conversationDidChange:event.conversation];
+    }];
+    return controller;
+}
+
+- (void)testEventsAreDeliveredToSubscribersOfTheConversationAndKind
+{
+    LYRConversation *conversation = self.store.conversations[0];
+    LYRConversation *otherConversation = self.store.conversations[1];
+    ATLMEventBusTestController *controller = [self subscribedControllerForConversation:conversation kind:ATLMConversationEventKindMetadataDidChange];
+    ATLMEventBusTestController *otherController = [self subscribedControllerForConversation:otherConversation kind:ATLMConversationEventKindMetadataDidChange];
+
+    [self.bus postEventOfKind:ATLMConversationEventKindMetadataDidChange conversation:conversation];
+    [self.bus postEventOfKind:ATLMConversationEventKindParticipantsDidChange conversation:conversation];
+    expect(controller.countOfWakeups).to.equal(1);
+    expect(otherController.countOfWakeups).to.equal(0);
+    expect(self.bus.countOfPostedEvents).to.equal(2);
+    expect(self.bus.countOfDeliveries).to.equal(1);
+}
+
+- (void)testSubscribersOfAnyConversationReceiveEveryEventOfTheirKind
+{
+    NSMutableArray *conversations = [NSMutableArray new];
+    [self.bus subscribeObserver:self toEventKind:ATLMConversationEventKindDeleted conversationIdentifier:nil queue:nil handler:^(id observer, ATLMConversationEvent *event) {
+        expect(event.kind).to.equal(ATLMConversationEventKindDeleted);
+        [conversations addObject:event.conversation];
+    }];
+    NSArray *deletedConversations = [self.store.conversations subarrayWithRange:NSMakeRange(0, 3)];
+    for (LYRConversation *conversation in deletedConversations) {
+        [self.bus postEventOfKind:ATLMConversationEventKindDeleted conversation:conversation];
+        [self.bus postEventOfKind:ATLMConversationEventKindMetadataDidChange conversation:conversation];
+    }
+    expect(conversations).to.equal(deletedConversations);
+}
+
+- (void)testSubscriptionsAreRemovedWithTheirObserver
+{
+    LYRConversation *conversation = self.store.conversations[0];
+    @autoreleasepool {
+        [self subscribedControllerForConversation:conversation kind:ATLMConversationEventKindMetadataDidChange];
+        [self.bus subscribeObserver:[NSObject new] toEventKind:ATLMConversationEventKindDeleted conversationIdentifier:nil queue:nil handler:^(id observer, ATLMConversationEvent *event) {
+            XCTFail(@"The observer is gone");
+        }];
+    }
+    expect(self.bus.countOfSubscriptions).to.equal(0);
+    [self.bus postEventOfKind:ATLMConversationEventKindDeleted conversation:conversation];
+    expect(self.bus.countOfDeliveries).to.equal(0);
+}
+
+- (void)testUnsubscribingDropsQueuedEvents
+{
+    LYRConversation *conversation = self.store.conversations[0];
+    dispatch_queue_t queue = dispatch_queue_create("com.layer.Atlas-Messenger.test", DISPATCH_QUEUE_SERIAL);
+    dispatch_suspend(queue);
+    __block NSUInteger deliveries = 0;
+    id subscription = [self.bus subscribeObserver:self toEventKind:ATLMConversationEventKindMetadataDidChange conversationIdentifier:conversation.identifier queue:queue handler:^(id observer, ATLMConversationEvent *event) {
+        deliveries += 1;
+    }];
+    [self.bus postEventOfKind:ATLMConversationEventKindMetadataDidChange conversation:conversation];
+    [self.bus unsubscribe:subscription];
+    expect(self.bus.countOfSubscriptions).to.equal(0);
+    dispatch_resume(queue);
+    dispatch_sync(queue, ^{});
+    expect(deliveries).to.equal(0);
+}
+
+- (void)testEventsAreDeliveredOnTheQueueOfTheSubscription
+{
+    LYRConversation *conversation = self.store.conversations[0];
+    static void *ATLMTestQueueKey = &ATLMTestQueueKey;
+    dispatch_queue_t queue = dispatch_queue_create("com.layer.Atlas-Messenger.test", DISPATCH_QUEUE_SERIAL);
+    dispatch_queue_set_specific(queue, ATLMTestQueueKey, ATLMTestQueueKey, NULL);
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Event delivered"];
+    [self.bus subscribeObserver:self toEventKind:ATLMConversationEventKindParticipantsDidChange conversationIdentifier:conversation.identifier queue:queue handler:^(id observer, ATLMConversationEvent *event) {
+        expect(dispatch_get_specific(ATLMTestQueueKey) == ATLMTestQueueKey).to.beTruthy();
+        [expectation fulfill];
+    }];
+    [self.bus postEventOfKind:ATLMConversationEventKindParticipantsDidChange conversation:conversation];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+- (void)testLayerControllerPostsConversationChangesToItsBus
+{
+    ATLMLayerController *layerController = [self.store newLayerController];
+    self.bus = layerController.conversationEventBus;
+    LYRConversation *conversation = self.store.conversations[0];
+    ATLMEventBusTestController *controller = [self subscribedControllerForConversation:conversation kind:ATLMConversationEventKindMetadataDidChange];
+    ATLMEventBusTestController *otherController = [self subscribedControllerForConversation:self.store.conversations[1] kind:ATLMConversationEventKindMetadataDidChange];
+    [layerController layerClient:(LYRClient *)self.store objectsDidChange:@[ [self.store changeWithType:LYRObjectChangeTypeUpdate object:conversation property:@"metadata"] ]];
+    expect(controller.countOfWakeups).to.equal(1);
+    expect(otherController.countOfWakeups).to.equal(0);
+}
+
+#pragma mark - Benchmark
+
+/**
+ @abstract Delivers metadata changes of every conversation of the store to
+   20 controllers following a conversation each, once through the bus and
+   once as notifications observed for any object, the way the controllers
+   observed them before.
+ */
+- (void)testBenchmarkWastedWakeups
+{
+    NSArray *conversations = self.store.conversations;
+    NSUInteger stride = conversations.count / ATLMEventBusBenchmarkControllerCount;
+    NSNotificationCenter *notificationCenter = [NSNotificationCenter new];
+    NSMutableArray *busControllers = [NSMutableArray new];
+    NSMutableArray *notificationControllers = [NSMutableArray new];
+    for (NSUInteger index = 0; index < ATLMEventBusBenchmarkControllerCount; index++) {
+        LYRConversation *conversation = conversations[index * stride];
+        [busControllers addObject:[self subscribedControllerForConversation:conversation kind:ATLMConversationEventKindMetadataDidChange]];
+        ATLMEventBusTestController *controller = [ATLMEventBusTestController new];
+        controller.conversation = conversation;
+        [notificationCenter addObserver:controller selector:@selector(conversationMetadataDidChange:) name:ATLMConversationMetadataDidChangeNotification object:nil];
+        [notificationControllers addObject:controller];
+    }
+
+    srand48(ATLMFakeLayerStoreDefaultCorpus.seed);
+    NSMutableArray *changedConversations = [NSMutableArray arrayWithCapacity:ATLMEventBusBenchmarkEventCount];
+    for (NSUInteger index = 0; index < ATLMEventBusBenchmarkEventCount; index++) {
+        [changedConversations addObject:conversations[lrand48() % conversations.count]];
+    }
+
+    NSDate *start = [NSDate date];
+    for (LYRConversation *conversation in changedConversations) {
+        [self.bus postEventOfKind:ATLMConversationEventKindMetadataDidChange conversation:conversation];
+    }
+    NSTimeInterval busDuration = -[start timeIntervalSinceNow];
+    start = [NSDate date];
+    for (LYRConversation *conversation in changedConversations) {
+        [notificationCenter postNotificationName:ATLMConversationMetadataDidChangeNotification object:conversation];
+    }
+    NSTimeInterval notificationDuration = -[start timeIntervalSinceNow];
+    for (id controller in notificationControllers) {
+        [notificationCenter removeObserver:controller];
+    }
+
+    NSUInteger busWakeups = [[busControllers valueForKeyPath:@"@sum.countOfWakeups"] unsignedIntegerValue];
+    NSUInteger busWastedWakeups = [[busControllers valueForKeyPath:@"@sum.countOfWastedWakeups"] unsignedIntegerValue];
+    NSUInteger notificationWakeups = [[notificationControllers valueForKeyPath:@"@sum.countOfWakeups"] unsignedIntegerValue];
+    NSUInteger notificationWastedWakeups = [[notificationControllers valueForKeyPath:@"@sum.countOfWastedWakeups"] unsignedIntegerValue];
+    NSLog(@"%lu events for %lu controllers: the bus woke them %lu times (%lu wasted) in %.0fms; notifications woke them %lu times (%lu wasted) in %.0fms",
+          (unsigned long)ATLMEventBusBenchmarkEventCount, (unsigned long)ATLMEventBusBenchmarkControllerCount,
+          (unsigned long)busWakeups, (unsigned long)busWastedWakeups, busDuration * 1000,
+          (unsigned long)notificationWakeups, (unsigned long)notificationWastedWakeups, notificationDuration * 1000);
+
+    expect(busWastedWakeups).to.equal(0);
+    expect(busWakeups).to.equal(notificationWakeups - notificationWastedWakeups);
+    expect(notificationWakeups).to.equal(ATLMEventBusBenchmarkEventCount * ATLMEventBusBenchmarkControllerCount);
+    expect(busDuration).to.beLessThan(notificationDuration);
+}
+
+@end
@@ -0,0 +1,259 @@
+//
+//  ATLMConversationRollupIndexTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import <QuartzCore/QuartzCore.h>
+#import "ATLMConversationRollupIndex.h"
+#import "ATLMFakeLayerStore.h"
+#import "ATLMLayerController.h"
+
+static const NSUInteger ATLMRollupBenchmarkConversationCount = 50000;
+static const NSUInteger ATLMRollupBenchmarkUpdateCount = 20000;
+static const NSUInteger ATLMRollupBenchmarkPageSize = 30;
+
+@interface ATLMConversationRollupIndexTest : XCTestCase
+
+@property (nonatomic) NSString *persistencePath;
+@property (nonatomic) ATLMConversationRollupIndex *index;
+
+@end
+
+@implementation ATLMConversationRollupIndexTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.persistencePath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"ConversationPreferences-%@.plist", [NSUUID UUID].UUIDString]];
+    self.index = [ATLMConversationRollupIndex indexWithPersistencePath:self.persistencePath];
+}
+
+- (void)tearDown
+{
+    self.index = nil;
+    [[NSFileManager defaultManager] removeItemAtPath:self.persistencePath error:nil];
+    [super tearDown];
+}
+
+- (NSURL *)conversationIdentifier:(NSUInteger)index
+{
+    return [NSURL URLWithString:[NSString stringWithFormat:@"layer:///conversations/%lu", (unsigned long)index]];
+}
+
+- (void)updateConversation:(NSUInteger)index activity:(NSTimeInterval)activity unreadCount:(NSUInteger)unreadCount title:(NSString *)title
+{
+    [self.index updateConversationWithIdentifier:[self conversationIdentifier:index] lastActivityDate:[NSDate dateWithTimeIntervalSinceReferenceDate:activity] unreadCount:unreadCount title:title];
+}
+
+- (NSArray *)conversationIdentifiersInOrder:(ATLMConversationSortOrder)sortOrder
+{
+    return [self.index conversationIdentifiersInRange:NSMakeRange(0, self.index.count) sortOrder:sortOrder];
+}
+
+- (NSArray *)conversationIdentifiers:(NSArray *)indexes
+{
+    NSMutableArray *conversationIdentifiers = [NSMutableArray new];
+    for (NSNumber *index in indexes) {
+        [conversationIdentifiers addObject:[self conversationIdentifier:index.unsignedIntegerValue]];
+    }
+    return conversationIdentifiers;
+}
+
+#pragma mark - Orders
+
+- (void)testSortOrders
+{
+    [self updateConversation:1 activity:100 unreadCount:0 title:@"Zoe"];
+    [self updateConversation:2 activity:300 unreadCount:0 title:@"Émile"];
+    [self updateConversation:3 activity:200 unreadCount:2 title:@"adam"];
+    [self updateConversation:4 activity:50 unreadCount:1 title:@"Bob"];
+    [self.index setPinned:YES forConversationWithIdentifier:[self conversationIdentifier:1]];
+
+    expect([self conversationIdentifiersInOrder:ATLMConversationSortOrderRecent]).to.equal([self conversationIdentifiers:@[ @2, @3, @1, @4 ]]);
+    expect([self conversationIdentifiersInOrder:ATLMConversationSortOrderPinnedFirst]).to.equal([self conversationIdentifiers:@[ @1, @2, @3, @4 ]]);
+    expect([self conversationIdentifiersInOrder:ATLMConversationSortOrderUnreadFirst]).to.equal([self conversationIdentifiers:@[ @1, @3, @4, @2 ]]);
+    expect([self conversationIdentifiersInOrder:ATLMConversationSortOrderTitle]).to.equal([self conversationIdentifiers:@[ @3, @4, @2, @1 ]]);
+}
+
+- (void)testUpdatesMoveConversations
+{
+    for (NSUInteger index = 0; index < 10; index++) {
+        [self updateConversation:index activity:index unreadCount:0 title:@"Title"];
+    }
+    expect([self.index conversationIdentifierAtIndex:0 sortOrder:ATLMConversationSortOrderRecent]).to.equal([self conversationIdentifier:9]);
+    expect([self.index indexOfConversationWithIdentifier:[self conversationIdentifier:2] sortOrder:ATLMConversationSortOrderRecent]).to.equal(7);
+
+    [self updateConversation:2 activity:100 unreadCount:1 title:@"Title"];
+    expect([self.index conversationIdentifierAtIndex:0 sortOrder:ATLMConversationSortOrderRecent]).to.equal([self conversationIdentifier:2]);
+    expect([self.index indexOfConversationWithIdentifier:[self conversationIdentifier:9] sortOrder:ATLMConversationSortOrderRecent]).to.equal(1);
+    expect(self.index.count).to.equal(10);
+
+    [self.index removeConversationWithIdentifier:[self conversationIdentifier:2]];
+    expect(self.index.count).to.equal(9);
+    expect([self.index indexOfConversationWithIdentifier:[self conversationIdentifier:2] sortOrder:ATLMConversationSortOrderTitle]).to.equal(NSNotFound);
+    expect([self.index conversationIdentifierAtIndex:0 sortOrder:ATLMConversationSortOrderRecent]).to.equal([self conversationIdentifier:9]);
+    expect([self.index conversationIdentifiersInRange:NSMakeRange(7, 5) sortOrder:ATLMConversationSortOrderRecent]).to.equal([self conversationIdentifiers:@[ @1, @0 ]]);
+}
+
+- (void)testUnreadCountSkipsMutedConversations
+{
+    [self updateConversation:1 activity:1 unreadCount:3 title:@"A"];
+    [self updateConversation:2 activity:2 unreadCount:4 title:@"B"];
+    expect(self.index.unreadCount).to.equal(7);
+    [self.index setMuted:YES forConversationWithIdentifier:[self conversationIdentifier:2]];
+    expect(self.index.unreadCount).to.equal(3);
+    expect(self.index.totalUnreadCount).to.equal(7);
+    expect([self conversationIdentifiersInOrder:ATLMConversationSortOrderUnreadFirst]).to.equal([self conversationIdentifiers:@[ @1, @2 ]]);
+    [self updateConversation:1 activity:1 unreadCount:0 title:@"A"];
+    expect(self.index.unreadCount).to.equal(0);
+    [self.index removeConversationWithIdentifier:[self conversationIdentifier:2]];
+    expect(self.index.unreadCount).to.equal(0);
+    expect(self.index.totalUnreadCount).to.equal(0);
+}
+
+- (void)testPreferencesArePersisted
+{
+    [self.index setPinned:YES forConversationWithIdentifier:[self conversationIdentifier:1]];
+    [self.index setMuted:YES forConversationWithIdentifier:[self conversationIdentifier:2]];
+    self.index = [ATLMConversationRollupIndex indexWithPersistencePath:self.persistencePath];
+    [self updateConversation:1 activity:1 unreadCount:0 title:@"A"];
+    [self updateConversation:2 activity:2 unreadCount:5 title:@"B"];
+    expect([self.index rollupForConversationWithIdentifier:[self conversationIdentifier:1]].isPinned).to.beTruthy();
+    expect([self.index rollupForConversationWithIdentifier:[self conversationIdentifier:2]].isMuted).to.beTruthy();
+    expect(self.index.unreadCount).to.equal(0);
+}
+
+#pragma mark - Changes
+
+- (void)testChangesFromTheStoreMoveConversationsToTheTop
+{
+    ATLMFakeLayerStoreCorpus corpus = ATLMFakeLayerStoreDefaultCorpus;
+    corpus.messagesPerConversation = 5;
+    ATLMFakeLayerStore *store = [ATLMFakeLayerStore storeWithCorpus:corpus];
+    self.index.authenticatedUserID = store.authenticatedUser.userID;
+    [self.index reloadWithConversations:store.conversations];
+    expect(self.index.count).to.equal(store.conversations.count);
+    expect([self.index conversationIdentifierAtIndex:0 sortOrder:ATLMConversationSortOrderRecent]).to.equal([store.conversations.firstObject identifier]);
+
+    LYRConversation *conversation = store.conversations.lastObject;
+    LYRMessage *message = [store newMessageInConversation:store.conversations.firstObject];
+    [message setValue:conversation forKey:@"conversation"];
+    [(id)conversation setValue:message forKey:@"lastMessage"];
+    __block NSUInteger notificationCount = 0;
+    id observer = [[NSNotificationCenter defaultCenter] addObserverForName:ATLMConversationRollupIndexDidChangeNotification object:self.index queue:nil usingBlock:^(NSNotification *notification) {
+        notificationCount += 1;
+    }];
+    [self.index applyChanges:@[ [store changeWithType:LYRObjectChangeTypeCreate object:message property:nil],
+                                [store changeWithType:LYRObjectChangeTypeUpdate object:conversation property:@"lastMessage"] ]];
+    [[NSNotificationCenter defaultCenter] removeObserver:observer];
+    expect(notificationCount).to.equal(1);
+    expect([self.index conversationIdentifierAtIndex:0 sortOrder:ATLMConversationSortOrderRecent]).to.equal(conversation.identifier);
+
+    [self.index applyChanges:@[ [store changeWithType:LYRObjectChangeTypeDelete object:conversation property:nil] ]];
+    expect(self.index.count).to.equal(store.conversations.count - 1);
+}
+
+#pragma mark - Benchmark
+
+/**
+ @abstract Applies random activity to 50k conversations and reads the first
+   page after every update, checking the orders against a full sort at the end.
+ */
+- (void)testLayerControllerPublishesTheRollupsInPages
+{
+    ATLMFakeLayerStore *store = [ATLMFakeLayerStore storeWithCorpus:ATLMFakeLayerStoreDefaultCorpus];
+    ATLMLayerController *layerController = [store newLayerController];
+    __block NSUInteger notificationCount = 0;
+    id observer = [[NSNotificationCenter defaultCenter] addObserverForName:ATLMConversationRollupIndexDidChangeNotification object:layerController.conversationRollupIndex queue:nil usingBlock:^(NSNotification *notification) {
+        notificationCount += 1;
+    }];
+    [layerController reloadConversationRollups];
+    [[NSNotificationCenter defaultCenter] removeObserver:observer];
+
+    expect(layerController.conversationRollupIndex.count).to.equal(store.conversations.count);
+    expect(notificationCount).to.equal(2);
+    expect([layerController.conversationRollupIndex conversationIdentifierAtIndex:0 sortOrder:ATLMConversationSortOrderRecent]).to.equal([store.conversations.firstObject identifier]);
+    [store removeAccountData];
+}
+
+- (void)testPagingKeepsConversationsCreatedAtTheSameTime
+{
+    ATLMFakeLayerStoreCorpus corpus = ATLMFakeLayerStoreDefaultCorpus;
+    corpus.conversationCount = 250;
+    ATLMFakeLayerStore *store = [ATLMFakeLayerStore storeWithCorpus:corpus];
+    NSDate *createdAt = [NSDate dateWithTimeIntervalSinceReferenceDate:0];
+    for (LYRConversation *conversation in store.conversations) {
+        [(id)conversation setValue:createdAt forKey:@"createdAt"];
+    }
+    ATLMLayerController *layerController = [store newLayerController];
+    [layerController reloadConversationRollups];
+    expect(layerController.conversationRollupIndex.count).to.equal(250);
+    [store removeAccountData];
+}
+
+- (void)testBenchmarkFiftyThousandConversations
+{
+    srand48(42);
+    NSMutableArray *titles = [NSMutableArray arrayWithCapacity:ATLMRollupBenchmarkConversationCount];
+    CFTimeInterval start = CACurrentMediaTime();
+    for (NSUInteger index = 0; index < ATLMRollupBenchmarkConversationCount; index++) {
+        NSString *title = [NSString stringWithFormat:@"Conversation %06lu", (unsigned long)(lrand48() % 1000000)];
+        [titles addObject:title];
+        [self updateConversation:index activity:drand48() * 1e6 unreadCount:(lrand48() % 4 == 0) ? 1 : 0 title:title];
+        if (index % 50 == 0) {
+            [self.index setPinned:YES forConversationWithIdentifier:[self conversationIdentifier:index]];
+        }
+    }
+    CFTimeInterval loadDuration = CACurrentMediaTime() - start;
+
+    start = CACurrentMediaTime();
+    NSTimeInterval activity = 1e6;
+    for (NSUInteger update = 0; update < ATLMRollupBenchmarkUpdateCount; update++) {
+        @autoreleasepool {
+            NSUInteger index = lrand48() % ATLMRollupBenchmarkConversationCount;
+            [self updateConversation:index activity:++activity unreadCount:lrand48() % 3 title:titles[index]];
+            [self.index conversationIdentifiersInRange:NSMakeRange(0, ATLMRollupBenchmarkPageSize) sortOrder:update % 4];
+        }
+    }
+    CFTimeInterval updateDuration = CACurrentMediaTime() - start;
+
+    NSMutableArray *rollups = [NSMutableArray arrayWithCapacity:ATLMRollupBenchmarkConversationCount];
+    for (NSUInteger index = 0; index < ATLMRollupBenchmarkConversationCount; index++) {
+        [rollups addObject:[self.index rollupForConversationWithIdentifier:[self conversationIdentifier:index]]];
+    }
+    start = CACurrentMediaTime();
+    NSArray *sortedRollups = [rollups sortedArrayUsingDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:@"pinned" ascending:NO],
+                                                                      [NSSortDescriptor sortDescriptorWithKey:@"lastActivityDate" ascending:NO] ]];
+    CFTimeInterval fullSortDuration = CACurrentMediaTime() - start;
+
+    NSLog(@"%lu conversations loaded in %.0fms; %lu updates with a page read each in %.0fms (%.1fus per update); a full sort takes %.1fms",
+          (unsigned long)ATLMRollupBenchmarkConversationCount, loadDuration * 1000, (unsigned long)ATLMRollupBenchmarkUpdateCount, updateDuration * 1000,
+          updateDuration * 1e6 / ATLMRollupBenchmarkUpdateCount, fullSortDuration * 1000);
+
+    NSArray *expectedPage = [[sortedRollups subarrayWithRange:NSMakeRange(0, 100)] valueForKey:@"conversationIdentifier"];
+    expect([self.index conversationIdentifiersInRange:NSMakeRange(0, 100) sortOrder:ATLMConversationSortOrderPinnedFirst]).to.equal(expectedPage);
+    ATLMConversationRollup *rollup = sortedRollups[12345];
+    expect([self.index indexOfConversationWithIdentifier:rollup.conversationIdentifier sortOrder:ATLMConversationSortOrderPinnedFirst]).to.equal(12345);
+    expect(self.index.count).to.equal(ATLMRollupBenchmarkConversationCount);
+    expect(updateDuration / ATLMRollupBenchmarkUpdateCount).to.beLessThan(fullSortDuration);
+}
+
+@end
@@ -0,0 +1,116 @@
+//
+//  ATLMDiskLRUCacheTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMDiskLRUCache.h"
+
+static NSData *ATLMTestData(NSUInteger length)
+{
+    return [NSMutableData dataWithLength:length];
+}
+
+@interface ATLMDiskLRUCacheTest : XCTestCase
+
+@property (nonatomic) NSString *directory;
+
+@end
+
+@implementation ATLMDiskLRUCacheTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+    [super tearDown];
+}
+
+- (void)testRaisesOnAttemptToInit
+{
+    expect(^{ [ATLMDiskLRUCache new]; }).to.raise(NSInternalInconsistencyException);
+}
+
+- (void)testStoresAndReplacesData
+{
+    ATLMDiskLRUCache *cache = [ATLMDiskLRUCache cacheWithDirectory:self.directory byteLimit:1000];
+    expect([cache dataForKey:@"http://example.com/a.png#96"]).to.beNil();
+    [cache setData:ATLMTestData(100) forKey:@"http://example.com/a.png#96"];
+    [cache setData:ATLMTestData(300) forKey:@"http://example.com/a.png#96"];
+    expect([cache dataForKey:@"http://example.com/a.png#96"].length).to.equal(300);
+    expect(cache.count).to.equal(1);
+    expect(cache.totalBytes).to.equal(300);
+    expect(cache.countOfHits).to.equal(1);
+    expect(cache.countOfMisses).to.equal(1);
+
+    [cache removeDataForKey:@"http://example.com/a.png#96"];
+    expect([cache dataForKey:@"http://example.com/a.png#96"]).to.beNil();
+    expect(cache.totalBytes).to.equal(0);
+}
+
+- (void)testEvictsTheLeastRecentlyUsedBeyondTheByteLimit
+{
+    ATLMDiskLRUCache *cache = [ATLMDiskLRUCache cacheWithDirectory:self.directory byteLimit:300];
+    [cache setData:ATLMTestData(100) forKey:@"a"];
+    [cache setData:ATLMTestData(100) forKey:@"b"];
+    [cache setData:ATLMTestData(100) forKey:@"c"];
+    [cache dataForKey:@"a"];
+    [cache setData:ATLMTestData(100) forKey:@"d"];
+    expect([cache dataForKey:@"b"]).to.beNil();
+    expect([cache dataForKey:@"a"]).toNot.beNil();
+    expect(cache.countOfEvictions).to.equal(1);
+    expect(cache.totalBytes).to.equal(300);
+
+    // Data which would evict everything else isn't stored.
+    [cache setData:ATLMTestData(400) forKey:@"e"];
+    expect([cache dataForKey:@"e"]).to.beNil();
+    expect(cache.count).to.equal(3);
+
+    cache.byteLimit = 100;
+    expect(cache.count).to.equal(1);
+    expect([cache dataForKey:@"a"]).toNot.beNil();
+}
+
+- (void)testRestoresTheEntriesInTheirOrderOfUse
+{
+    ATLMDiskLRUCache *cache = [ATLMDiskLRUCache cacheWithDirectory:self.directory byteLimit:1000];
+    [cache setData:ATLMTestData(100) forKey:@"a"];
+    [cache setData:ATLMTestData(100) forKey:@"b"];
+    // Modification dates have a resolution of a second on some file systems.
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:1.1]];
+    [cache dataForKey:@"a"];
+
+    ATLMDiskLRUCache *restoredCache = [ATLMDiskLRUCache cacheWithDirectory:self.directory byteLimit:1000];
+    expect(restoredCache.count).to.equal(2);
+    expect(restoredCache.totalBytes).to.equal(200);
+    restoredCache.byteLimit = 100;
+    expect([restoredCache dataForKey:@"a"]).toNot.beNil();
+    expect([restoredCache dataForKey:@"b"]).to.beNil();
+
+    [restoredCache removeAllData];
+    expect([[NSFileManager defaultManager] contentsOfDirectoryAtPath:self.directory error:nil].count).to.equal(0);
+}
+
+@end
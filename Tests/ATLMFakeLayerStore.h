@@ -0,0 +1,173 @@
+//
+//  ATLMFakeLayerStore.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import <LayerKit/LayerKit.h>
+
+@class ATLMLayerController;
+
+/**
+ @abstract Describes the corpus an `ATLMFakeLayerStore` generates.
+ */
+typedef struct {
+    NSUInteger conversationCount;
+    NSUInteger messagesPerConversation;
+    NSUInteger identityCount;
+    NSUInteger participantsPerConversation; // Including the authenticated user.
+    double unreadRatio;                     // Fraction of the received messages that are unread.
+    uint64_t seed;
+} ATLMFakeLayerStoreCorpus;
+
+/**
+ @abstract A corpus of 200 conversations of 50 messages between 500 identities.
+ */
+extern ATLMFakeLayerStoreCorpus const ATLMFakeLayerStoreDefaultCorpus;
+
+/**
+ @abstract Returns the corpus as a dictionary, for benchmark reports.
+ */
+extern NSDictionary *_Nonnull ATLMFakeLayerStoreCorpusDictionary(ATLMFakeLayerStoreCorpus corpus);
+
+/**
+ @abstract The `ATLMFakeLayerStore` is a deterministic, in-memory stand-in for
+   the query, change and identity surface of an authenticated `LYRClient`.
+ @discussion The store generates its conversations, messages and identities
+   from a seeded generator, so that the same corpus yields the same objects on
+   every run. The objects are not LayerKit's but answer `isKindOfClass:` and
+   the properties the application reads like LayerKit's, so the store can be
+   handed to the application's controllers in place of a client.
+
+   Queries are evaluated by walking the objects of the queried class, except
+   for `identifier` equality which is looked up in an index, like the client's
+   database does.
+ */
+@interface ATLMFakeLayerStore : NSObject
+
+/**
+ @abstract Generates a store with the supplied corpus.
+ */
++ (nonnull instancetype)storeWithCorpus:(ATLMFakeLayerStoreCorpus)corpus;
+
+/**
+ @abstract The corpus the store was generated with.
+ */
+@property (nonatomic, readonly) ATLMFakeLayerStoreCorpus corpus;
+
+///------------------------
+/// @name The Client Surface
+///------------------------
+
+@property (nonnull, nonatomic, readonly) LYRIdentity *authenticatedUser;
+@property (nonnull, nonatomic, readonly) NSOrderedSet<LYRPolicy *> *policies;
+
+- (nullable NSOrderedSet *)executeQuery:(nonnull LYRQuery *)query error:(NSError *_Nullable *_Nullable)error;
+- (NSUInteger)countForQuery:(nonnull LYRQuery *)query error:(NSError *_Nullable *_Nullable)error;
+- (BOOL)addPolicies:(nonnull NSSet<LYRPolicy *> *)policies error:(NSError *_Nullable *_Nullable)error;
+- (BOOL)removePolicies:(nonnull NSSet<LYRPolicy *> *)policies error:(NSError *_Nullable *_Nullable)error;
+
+/**
+ @abstract The number of times `policies` has been read.
+ */
+@property (nonatomic, readonly) NSUInteger countOfPolicyReads;
+
+/**
+ @abstract Completes with the conversation and message referenced by the
+   payload after `remoteNotificationSynchronizationLatency`, on the main thread.
+ */
+- (BOOL)synchronizeWithRemoteNotification:(nonnull NSDictionary *)userInfo completion:(nonnull void (^)(LYRConversation *_Nullable conversation, LYRMessage *_Nullable message, NSError *_Nullable error))completion;
+
+/**
+ @abstract The time a synchronization for a remote notification takes. Defaults to 50ms.
+ */
+@property (nonatomic) NSTimeInterval remoteNotificationSynchronizationLatency;
+
+/**
+ @abstract Creates a layer controller whose client is the receiver.
+ @discussion The controller still creates a client of its own for an app
+   nobody connects to, which is replaced by the receiver right away. It keeps
+   its data in the directory of `accountIdentifier`, away from the
+   application's own.
+ */
+- (nonnull ATLMLayerController *)newLayerController;
+
+/**
+ @abstract The temporary account the layer controllers of the receiver keep their data for.
+ */
+@property (nonnull, nonatomic, readonly) NSString *accountIdentifier;
+
+/**
+ @abstract Removes the data kept by the layer controllers of the receiver; called in test teardown.
+ */
+- (void)removeAccountData;
+
+///-------------------
+/// @name Corpus Access
+///-------------------
+
+@property (nonnull, nonatomic, readonly) NSArray<LYRIdentity *> *identities;
+
+/**
+ @abstract The conversations, most recently active first.
+ */
+@property (nonnull, nonatomic, readonly) NSArray<LYRConversation *> *conversations;
+
+/**
+ @abstract The messages of the conversation, oldest first.
+ */
+- (nonnull NSArray<LYRMessage *> *)messagesInConversation:(nonnull LYRConversation *)conversation;
+
+///-------------
+/// @name Changes
+///-------------
+
+/**
+ @abstract Returns a new message from another participant of the
+   conversation, as if it had just been synchronized. The message is not
+   added to the store.
+ */
+- (nonnull LYRMessage *)newMessageInConversation:(nonnull LYRConversation *)conversation;
+
+/**
+ @abstract Returns a new image message from another participant of the
+   conversation, with the full resolution, preview and size parts Atlas sends.
+   The message is not added to the store.
+ */
+- (nonnull LYRMessage *)newImageMessageInConversation:(nonnull LYRConversation *)conversation imageData:(nonnull NSData *)imageData previewData:(nonnull NSData *)previewData pixelSize:(CGSize)pixelSize;
+
+/**
+ @abstract Returns a change of the object, as the client reports them.
+ */
+- (nonnull LYRObjectChange *)changeWithType:(LYRObjectChangeType)type object:(nonnull id)object property:(nullable NSString *)property;
+
+/**
+ @abstract Returns a remote notification payload announcing the message.
+ */
+- (nonnull NSDictionary *)remoteNotificationForMessage:(nonnull LYRMessage *)message;
+
+/**
+ @abstract Returns a batch of changes resembling a synchronization: a
+   message is created in each of `conversationCount` conversations, whose
+   `lastMessage` is updated, and every `metadataStride`th of them also has
+   its metadata updated.
+ @discussion The objects are not mutated, so the same batch can be dispatched repeatedly.
+ */
+- (nonnull NSArray<LYRObjectChange *> *)changesForSynchronizationOfConversationCount:(NSUInteger)conversationCount metadataStride:(NSUInteger)metadataStride;
+
+@end
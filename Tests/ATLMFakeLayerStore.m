@@ -0,0 +1,648 @@
+//
+//  ATLMFakeLayerStore.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMFakeLayerStore.h"
+#import "ATLMConversationDetailViewController.h"
+#import "ATLMLayerController.h"
+#import "ATLMMessageSearchIndex.h"
+#import "ATLMUtilities.h"
+#import "ATLMRemoteNotificationCoalescer.h"
+#import <Atlas/Atlas.h>
+
+ATLMFakeLayerStoreCorpus const ATLMFakeLayerStoreDefaultCorpus = {
+    .conversationCount = 200,
+    .messagesPerConversation = 50,
+    .identityCount = 500,
+    .participantsPerConversation = 4,
+    .unreadRatio = 0.1,
+    .seed = 0x4C61796572,
+};
+
+NSDictionary *ATLMFakeLayerStoreCorpusDictionary(ATLMFakeLayerStoreCorpus corpus)
+{
+    return @{ @"conversationCount": @(corpus.conversationCount),
+              @"messagesPerConversation": @(corpus.messagesPerConversation),
+              @"identityCount": @(corpus.identityCount),
+              @"participantsPerConversation": @(corpus.participantsPerConversation),
+              @"unreadRatio": @(corpus.unreadRatio),
+              @"seed": @(corpus.seed) };
+}
+
+static NSString *const ATLMFakeLayerStoreFirstNames[] = { @"Ada", @"Blake", @"Casey", @"Dana", @"Eli", @"Frances", @"Gale", @"Harper", @"Ira", @"Jules", @"Kai", @"Lee", @"Morgan", @"Noor", @"Oakley", @"Parker", @"Quinn", @"Riley", @"Sage", @"Taylor", @"Uma", @"Val", @"Wren", @"Yael" };
+static NSString *const ATLMFakeLayerStoreLastNames[] = { @"Abbott", @"Baker", @"Chen", @"Diaz", @"Evans", @"Fischer", @"Garcia", @"Hughes", @"Ito", @"Jensen", @"Kowalski", @"Lopez", @"Moreau", @"Nakamura", @"Okafor", @"Patel", @"Quist", @"Rossi", @"Silva", @"Tanaka", @"Ulloa", @"Varga", @"Weber", @"Young" };
+static const NSUInteger ATLMFakeLayerStoreNameCount = sizeof(ATLMFakeLayerStoreFirstNames) / sizeof(ATLMFakeLayerStoreFirstNames[0]);
+
+/**
+ @abstract A xorshift64* generator; the corpus must not depend on the platform's `random()`.
+ */
+static uint64_t ATLMFakeLayerStoreNextRandom(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static NSUInteger ATLMFakeLayerStoreRandomIndex(uint64_t *state, NSUInteger bound)
+{
+    return bound ? (NSUInteger)(ATLMFakeLayerStoreNextRandom(state) % bound) : 0;
+}
+
+static double ATLMFakeLayerStoreRandomFraction(uint64_t *state)
+{
+    return (ATLMFakeLayerStoreNextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+#pragma mark - Objects
+
+/**
+ @abstract The objects of the store answer `isKindOfClass:` for the LayerKit
+   class they stand in for, as the application checks the class of changed objects.
+ */
+@interface ATLMFakeLayerStoreObject : NSObject
+
++ (Class)impersonatedClass;
+
+@end
+
+@implementation ATLMFakeLayerStoreObject
+
++ (Class)impersonatedClass
+{
+    return Nil;
+}
+
+- (BOOL)isKindOfClass:(Class)aClass
+{
+    return [super isKindOfClass:aClass] || aClass == [[self class] impersonatedClass];
+}
+
+@end
+
+@interface ATLMFakeLayerStoreIdentity : ATLMFakeLayerStoreObject <ATLParticipant>
+
+@property (nonatomic) NSURL *identifier;
+@property (nonatomic) NSString *userID;
+@property (nonatomic) NSString *firstName;
+@property (nonatomic) NSString *lastName;
+@property (nonatomic) NSString *displayName;
+@property (nonatomic) NSString *emailAddress;
+@property (nonatomic) NSURL *avatarImageURL;
+@property (nonatomic) UIImage *avatarImage;
+@property (nonatomic) NSString *avatarInitials;
+
+@end
+
+@implementation ATLMFakeLayerStoreIdentity
+
++ (Class)impersonatedClass
+{
+    return [LYRIdentity class];
+}
+
+@end
+
+@interface ATLMFakeLayerStoreConversation : ATLMFakeLayerStoreObject
+
+@property (nonatomic) NSURL *identifier;
+@property (nonatomic) NSSet *participants;
+@property (nonatomic) NSDictionary *metadata;
+@property (nonatomic) NSDate *createdAt;
+@property (nonatomic) LYRMessage *lastMessage;
+@property (nonatomic) NSUInteger totalNumberOfMessages;
+@property (nonatomic) NSUInteger totalNumberOfUnreadMessages;
+@property (nonatomic) BOOL hasUnreadMessages;
+@property (nonatomic) BOOL isDeleted;
+@property (nonatomic) BOOL deliveryReceiptsEnabled;
+
+@end
+
+@implementation ATLMFakeLayerStoreConversation
+
++ (Class)impersonatedClass
+{
+    return [LYRConversation class];
+}
+
+@end
+
+@interface ATLMFakeLayerStoreMessage : ATLMFakeLayerStoreObject
+
+@property (nonatomic) NSURL *identifier;
+@property (nonatomic, weak) LYRConversation *conversation;
+@property (nonatomic) LYRIdentity *sender;
+@property (nonatomic) NSArray *parts;
+@property (nonatomic) NSDate *sentAt;
+@property (nonatomic) NSDate *receivedAt;
+@property (nonatomic) LYRPosition position;
+@property (nonatomic) BOOL isSent;
+@property (nonatomic) BOOL isUnread;
+@property (nonatomic) BOOL isDeleted;
+@property (nonatomic) NSDictionary *recipientStatusByUserID;
+
+@end
+
+@implementation ATLMFakeLayerStoreMessage
+
++ (Class)impersonatedClass
+{
+    return [LYRMessage class];
+}
+
+@end
+
+@interface ATLMFakeLayerStoreObjectChange : ATLMFakeLayerStoreObject
+
+@property (nonatomic) LYRObjectChangeType type;
+@property (nonatomic) id object;
+@property (nonatomic) NSString *property;
+@property (nonatomic) id beforeValue;
+@property (nonatomic) id afterValue;
+
+@end
+
+@implementation ATLMFakeLayerStoreObjectChange
+
++ (Class)impersonatedClass
+{
+    return [LYRObjectChange class];
+}
+
++ (instancetype)changeWithType:(LYRObjectChangeType)type object:(id)object property:(NSString *)property beforeValue:(id)beforeValue afterValue:(id)afterValue
+{
+    ATLMFakeLayerStoreObjectChange *change = [self new];
+    change.type = type;
+    change.object = object;
+    change.property = property;
+    change.beforeValue = beforeValue;
+    change.afterValue = afterValue;
+    return change;
+}
+
+@end
+
+#pragma mark - Predicates
+
+typedef BOOL (^ATLMFakeLayerStoreMatcher)(id object);
+
+/**
+ @abstract Reduces values to what LayerKit compares: identities by user
+   identifier, so that sets of participants match sets of user identifiers.
+ */
+static id ATLMFakeLayerStoreComparableValue(id value)
+{
+    if ([value isKindOfClass:[NSSet class]]) {
+        NSMutableSet *values = [NSMutableSet setWithCapacity:[value count]];
+        for (id element in value) {
+            [values addObject:ATLMFakeLayerStoreComparableValue(element)];
+        }
+        return values;
+    }
+    if ([value isKindOfClass:[ATLMFakeLayerStoreIdentity class]]) {
+        return [value userID];
+    }
+    return value ?: [NSNull null];
+}
+
+static NSPredicate *ATLMFakeLayerStoreLikePredicate(NSString *pattern)
+{
+    // LayerKit takes SQL patterns; `NSPredicate` takes shell-style wildcards.
+    NSMutableString *wildcardPattern = [NSMutableString stringWithCapacity:pattern.length];
+    for (NSUInteger index = 0; index < pattern.length; index++) {
+        unichar character = [pattern characterAtIndex:index];
+        switch (character) {
+            case '%': [wildcardPattern appendString:@"*"]; break;
+            case '_': [wildcardPattern appendString:@"?"]; break;
+            case '*': [wildcardPattern appendString:@"\\*"]; break;
+            case '?': [wildcardPattern appendString:@"\\?"]; break;
+            case '\\': [wildcardPattern appendString:@"\\\\"]; break;
+            default: [wildcardPattern appendFormat:@"%C", character]; break;
+        }
+    }
+    return [NSPredicate predicateWithFormat:@"SELF LIKE[c] %@", wildcardPattern];
+}
+
+static ATLMFakeLayerStoreMatcher ATLMFakeLayerStoreMatcherForPredicate(LYRPredicate *predicate)
+{
+    if (!predicate) {
+        return ^BOOL(id object) { return YES; };
+    }
+    if ([predicate isKindOfClass:[LYRCompoundPredicate class]]) {
+        LYRCompoundPredicate *compoundPredicate = (LYRCompoundPredicate *)predicate;
+        NSMutableArray *matchers = [NSMutableArray new];
+        for (LYRPredicate *subpredicate in compoundPredicate.subpredicates) {
+            [matchers addObject:ATLMFakeLayerStoreMatcherForPredicate(subpredicate)];
+        }
+        LYRCompoundPredicateType type = compoundPredicate.type;
+        return ^BOOL(id object) {
+            for (ATLMFakeLayerStoreMatcher matcher in matchers) {
+                BOOL matches = matcher(object);
+                if (type == LYRCompoundPredicateTypeAnd && !matches) return NO;
+                if (type == LYRCompoundPredicateTypeOr && matches) return YES;
+                if (type == LYRCompoundPredicateTypeNot && matches) return NO;
+            }
+            return type != LYRCompoundPredicateTypeOr;
+        };
+    }
+
+    NSString *property = predicate.property;
+    id operand = ATLMFakeLayerStoreComparableValue(predicate.value);
+    switch (predicate.predicateOperator) {
+        case LYRPredicateOperatorIsEqualTo:
+            return ^BOOL(id object) { return [ATLMFakeLayerStoreComparableValue([object valueForKeyPath:property]) isEqual:operand]; };
+        case LYRPredicateOperatorIsNotEqualTo:
+            return ^BOOL(id object) { return ![ATLMFakeLayerStoreComparableValue([object valueForKeyPath:property]) isEqual:operand]; };
+        case LYRPredicateOperatorIsIn:
+            return ^BOOL(id object) { return [operand containsObject:ATLMFakeLayerStoreComparableValue([object valueForKeyPath:property])]; };
+        case LYRPredicateOperatorIsNotIn:
+            return ^BOOL(id object) { return ![operand containsObject:ATLMFakeLayerStoreComparableValue([object valueForKeyPath:property])]; };
+        case LYRPredicateOperatorLike: {
+            NSPredicate *likePredicate = ATLMFakeLayerStoreLikePredicate(operand);
+            return ^BOOL(id object) {
+                id value = [object valueForKeyPath:property];
+                return [value isKindOfClass:[NSString class]] && [likePredicate evaluateWithObject:value];
+            };
+        }
+        case LYRPredicateOperatorIsLessThan:
+        case LYRPredicateOperatorIsLessThanOrEqualTo:
+        case LYRPredicateOperatorIsGreaterThan:
+        case LYRPredicateOperatorIsGreaterThanOrEqualTo: {
+            LYRPredicateOperator predicateOperator = predicate.predicateOperator;
+            return ^BOOL(id object) {
+                id value = [object valueForKeyPath:property];
+                if (!value || ![value respondsToSelector:@selector(compare:)]) {
+                    return NO;
+                }
+                NSComparisonResult result = [value compare:operand];
+                switch (predicateOperator) {
+                    case LYRPredicateOperatorIsLessThan: return result == NSOrderedAscending;
+                    case LYRPredicateOperatorIsLessThanOrEqualTo: return result != NSOrderedDescending;
+                    case LYRPredicateOperatorIsGreaterThan: return result == NSOrderedDescending;
+                    default: return result != NSOrderedAscending;
+                }
+            };
+        }
+    }
+    [NSException raise:NSInvalidArgumentException format:@"Unsupported predicate operator in %@", predicate];
+    return nil;
+}
+
+#pragma mark - Store
+
+@interface ATLMLayerController (ATLMFakeLayerStore)
+
+- (void)setLayerClient:(LYRClient *)layerClient;
+
+@end
+
+@interface ATLMFakeLayerStore ()
+
+@property (nonatomic, readwrite) ATLMFakeLayerStoreCorpus corpus;
+@property (nonnull, nonatomic, readwrite) NSString *accountIdentifier;
+@property (nonnull, nonatomic, readwrite) LYRIdentity *authenticatedUser;
+@property (nonnull, nonatomic, readwrite) NSArray *identities;
+@property (nonnull, nonatomic, readwrite) NSArray *conversations;
+@property (nonnull, nonatomic) NSArray *messages;
+@property (nonnull, nonatomic) NSDictionary *messagesByConversationIdentifier;
+@property (nonnull, nonatomic) NSDictionary *objectsByIdentifier;
+@property (nonnull, nonatomic) NSMutableOrderedSet *mutablePolicies;
+@property (nonatomic, readwrite) NSUInteger countOfPolicyReads;
+@property (nonatomic) uint64_t changeSequence;
+
+@end
+
+@implementation ATLMFakeLayerStore
+
++ (instancetype)storeWithCorpus:(ATLMFakeLayerStoreCorpus)corpus
+{
+    return [[self alloc] initWithCorpus:corpus];
+}
+
+- (id)initWithCorpus:(ATLMFakeLayerStoreCorpus)corpus
+{
+    self = [super init];
+    if (self) {
+        _corpus = corpus;
+        _accountIdentifier = [@"ATLMFakeLayerStore-" stringByAppendingString:[NSUUID UUID].UUIDString];
+        _remoteNotificationSynchronizationLatency = 0.05;
+        _mutablePolicies = [NSMutableOrderedSet new];
+        [self generateCorpus];
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use storeWithCorpus:" userInfo:nil];
+}
+
+- (BOOL)isKindOfClass:(Class)aClass
+{
+    // Stands in for the client wherever the application checks for it.
+    return [super isKindOfClass:aClass] || aClass == [LYRClient class];
+}
+
+#pragma mark - Generation
+
+- (void)generateCorpus
+{
+    ATLMFakeLayerStoreCorpus corpus = self.corpus;
+    uint64_t state = corpus.seed ?: 1;
+    NSMutableDictionary *objectsByIdentifier = [NSMutableDictionary new];
+
+    NSUInteger identityCount = MAX(corpus.identityCount, 1);
+    NSMutableArray *identities = [NSMutableArray arrayWithCapacity:identityCount];
+    for (NSUInteger index = 0; index < identityCount; index++) {
+        ATLMFakeLayerStoreIdentity *identity = [ATLMFakeLayerStoreIdentity new];
+        identity.userID = [NSString stringWithFormat:@"user-%05lu", (unsigned long)index];
+        identity.identifier = [NSURL URLWithString:[@"layer:///identities/" stringByAppendingString:identity.userID]];
+        identity.firstName = ATLMFakeLayerStoreFirstNames[ATLMFakeLayerStoreRandomIndex(&state, ATLMFakeLayerStoreNameCount)];
+        identity.lastName = ATLMFakeLayerStoreLastNames[ATLMFakeLayerStoreRandomIndex(&state, ATLMFakeLayerStoreNameCount)];
+        identity.displayName = [NSString stringWithFormat:@"%@ %@", identity.firstName, identity.lastName];
+        identity.emailAddress = [NSString stringWithFormat:@"%@@example.com", identity.userID];
+        identity.avatarInitials = [NSString stringWithFormat:@"%@%@", [identity.firstName substringToIndex:1], [identity.lastName substringToIndex:1]];
+        [identities addObject:identity];
+        objectsByIdentifier[identity.identifier] = identity;
+    }
+    self.identities = identities;
+    self.authenticatedUser = (LYRIdentity *)identities.firstObject;
+
+    // Conversations are generated most recently active first, an hour apart.
+    NSDate *now = [NSDate dateWithTimeIntervalSinceReferenceDate:800000000];
+    NSUInteger participantCount = MAX(MIN(corpus.participantsPerConversation, identityCount), 1);
+    NSMutableArray *conversations = [NSMutableArray arrayWithCapacity:corpus.conversationCount];
+    NSMutableArray *messages = [NSMutableArray arrayWithCapacity:corpus.conversationCount * corpus.messagesPerConversation];
+    NSMutableDictionary *messagesByConversationIdentifier = [NSMutableDictionary dictionaryWithCapacity:corpus.conversationCount];
+    for (NSUInteger conversationIndex = 0; conversationIndex < corpus.conversationCount; conversationIndex++) {
+        ATLMFakeLayerStoreConversation *conversation = [ATLMFakeLayerStoreConversation new];
+        conversation.identifier = [NSURL URLWithString:[NSString stringWithFormat:@"layer:///conversations/%08lu", (unsigned long)conversationIndex]];
+        NSMutableOrderedSet *participants = [NSMutableOrderedSet orderedSetWithObject:self.authenticatedUser];
+        while (participants.count < participantCount) {
+            [participants addObject:identities[ATLMFakeLayerStoreRandomIndex(&state, identityCount)]];
+        }
+        conversation.participants = participants.set;
+        conversation.metadata = (conversationIndex % 8 == 0) ? @{ ATLMConversationMetadataNameKey: [NSString stringWithFormat:@"Team %lu", (unsigned long)conversationIndex] } : @{};
+        NSDate *lastActivity = [now dateByAddingTimeInterval:-3600.0 * conversationIndex];
+        conversation.createdAt = [lastActivity dateByAddingTimeInterval:-60.0 * (corpus.messagesPerConversation + 1)];
+
+        NSMutableArray *conversationMessages = [NSMutableArray arrayWithCapacity:corpus.messagesPerConversation];
+        NSUInteger unreadCount = 0;
+        for (NSUInteger messageIndex = 0; messageIndex < corpus.messagesPerConversation; messageIndex++) {
+            NSDate *date = [lastActivity dateByAddingTimeInterval:-60.0 * (corpus.messagesPerConversation - messageIndex - 1)];
+            ATLMFakeLayerStoreMessage *message = [self messageInConversation:(LYRConversation *)conversation participants:participants.array position:messageIndex date:date state:&state];
+            if (message.isUnread) {
+                unreadCount += 1;
+            }
+            [conversationMessages addObject:message];
+            objectsByIdentifier[message.identifier] = message;
+        }
+        conversation.lastMessage = conversationMessages.lastObject;
+        conversation.totalNumberOfMessages = conversationMessages.count;
+        conversation.totalNumberOfUnreadMessages = unreadCount;
+        conversation.hasUnreadMessages = unreadCount > 0;
+        conversation.deliveryReceiptsEnabled = YES;
+
+        [conversations addObject:conversation];
+        [messages addObjectsFromArray:conversationMessages];
+        messagesByConversationIdentifier[conversation.identifier] = conversationMessages;
+        objectsByIdentifier[conversation.identifier] = conversation;
+    }
+    self.conversations = conversations;
+    self.messages = messages;
+    self.messagesByConversationIdentifier = messagesByConversationIdentifier;
+    self.objectsByIdentifier = objectsByIdentifier;
+}
+
+- (ATLMFakeLayerStoreMessage *)messageInConversation:(LYRConversation *)conversation participants:(NSArray *)participants position:(NSUInteger)position date:(NSDate *)date state:(uint64_t *)state
+{
+    ATLMFakeLayerStoreMessage *message = [ATLMFakeLayerStoreMessage new];
+    message.identifier = [NSURL URLWithString:[NSString stringWithFormat:@"%@/messages/%06lu", conversation.identifier.absoluteString, (unsigned long)position]];
+    message.conversation = conversation;
+    message.sender = participants[ATLMFakeLayerStoreRandomIndex(state, participants.count)];
+    message.position = position;
+    message.sentAt = date;
+    message.receivedAt = date;
+    message.isSent = YES;
+
+    BOOL outgoing = message.sender == self.authenticatedUser;
+    message.isUnread = !outgoing && ATLMFakeLayerStoreRandomFraction(state) < self.corpus.unreadRatio;
+
+    NSMutableDictionary *recipientStatus = [NSMutableDictionary dictionaryWithCapacity:participants.count];
+    for (LYRIdentity *participant in participants) {
+        if (participant == message.sender) {
+            recipientStatus[participant.userID] = @(LYRRecipientStatusRead);
+        } else if (participant == self.authenticatedUser) {
+            recipientStatus[participant.userID] = @(message.isUnread ? LYRRecipientStatusDelivered : LYRRecipientStatusRead);
+        } else {
+            recipientStatus[participant.userID] = @(LYRRecipientStatusSent + ATLMFakeLayerStoreRandomIndex(state, 3));
+        }
+    }
+    message.recipientStatusByUserID = recipientStatus;
+
+    NSString *text = [NSString stringWithFormat:@"Message %lu from %@", (unsigned long)position, message.sender.displayName];
+    message.parts = @[ [LYRMessagePart messagePartWithMIMEType:ATLMIMETypeTextPlain data:[text dataUsingEncoding:NSUTF8StringEncoding]] ];
+    return message;
+}
+
+#pragma mark - Client Surface
+
+- (NSOrderedSet *)policies
+{
+    self.countOfPolicyReads += 1;
+    return [self.mutablePolicies copy];
+}
+
+- (BOOL)addPolicies:(NSSet *)policies error:(NSError **)error
+{
+    [self.mutablePolicies addObjectsFromArray:policies.allObjects];
+    return YES;
+}
+
+- (BOOL)removePolicies:(NSSet *)policies error:(NSError **)error
+{
+    [self.mutablePolicies minusSet:policies];
+    return YES;
+}
+
+- (NSOrderedSet *)executeQuery:(LYRQuery *)query error:(NSError **)error
+{
+    NSArray *objects = [self objectsMatchingQuery:query];
+    if (query.sortDescriptors.count) {
+        objects = [objects sortedArrayUsingDescriptors:query.sortDescriptors];
+    }
+    NSUInteger offset = MIN(query.offset, objects.count);
+    NSUInteger length = objects.count - offset;
+    if (query.limit) {
+        length = MIN(length, query.limit);
+    }
+    objects = [objects subarrayWithRange:NSMakeRange(offset, length)];
+    if (query.resultType == LYRQueryResultTypeIdentifiers) {
+        objects = [objects valueForKey:@"identifier"];
+    }
+    return [NSOrderedSet orderedSetWithArray:objects];
+}
+
+- (void)executeQuery:(LYRQuery *)query completion:(void (^)(NSOrderedSet *resultSet, NSError *error))completion
+{
+    // The client completes on the main thread; completing synchronously
+    // keeps the measurements free of run loop latency.
+    NSError *error;
+    NSOrderedSet *resultSet = [self executeQuery:query error:&error];
+    completion(resultSet, error);
+}
+
+- (BOOL)synchronizeWithRemoteNotification:(NSDictionary *)userInfo completion:(void (^)(LYRConversation *conversation, LYRMessage *message, NSError *error))completion
+{
+    NSURL *conversationIdentifier = ATLMConversationIdentifierFromRemoteNotification(userInfo);
+    if (!conversationIdentifier) {
+        return NO;
+    }
+    LYRConversation *conversation = self.objectsByIdentifier[conversationIdentifier];
+    NSString *messageIdentifier = userInfo[@"layer"][@"message_identifier"];
+    LYRMessage *message = messageIdentifier ? self.objectsByIdentifier[[NSURL URLWithString:messageIdentifier]] : nil;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.remoteNotificationSynchronizationLatency * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        completion(conversation, message ?: conversation.lastMessage, nil);
+    });
+    return YES;
+}
+
+- (ATLMLayerController *)newLayerController
+{
+    NSURL *appID = [NSURL URLWithString:[@"layer:///apps/staging/" stringByAppendingString:[NSUUID UUID].UUIDString.lowercaseString]];
+    id<ATLMAuthenticating> authenticationProvider = [ATLMAuthenticationProvider providerWithBaseURL:[NSURL URLWithString:@"https://localhost"] layerAppID:appID];
+    ATLMLayerController *layerController = [ATLMLayerController applicationControllerWithLayerAppID:appID clientOptions:nil authenticationProvider:authenticationProvider accountIdentifier:self.accountIdentifier];
+    [layerController setLayerClient:(LYRClient *)self];
+    return layerController;
+}
+
+- (void)removeAccountData
+{
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    [fileManager removeItemAtPath:ATLMAccountDataDirectory(self.accountIdentifier) error:nil];
+    [fileManager removeItemAtPath:[[ATLMMessageSearchIndex defaultDirectory] stringByAppendingPathComponent:self.accountIdentifier] error:nil];
+}
+
+- (NSUInteger)countForQuery:(LYRQuery *)query error:(NSError **)error
+{
+    NSUInteger count = [self objectsMatchingQuery:query].count;
+    if (query.offset) {
+        count -= MIN(query.offset, count);
+    }
+    return query.limit ? MIN(count, query.limit) : count;
+}
+
+- (NSArray *)objectsMatchingQuery:(LYRQuery *)query
+{
+    LYRPredicate *predicate = query.predicate;
+    if (![predicate isKindOfClass:[LYRCompoundPredicate class]] && predicate.predicateOperator == LYRPredicateOperatorIsEqualTo && [predicate.property isEqualToString:@"identifier"]) {
+        id object = self.objectsByIdentifier[predicate.value];
+        return [object isKindOfClass:query.queryableClass] ? @[ object ] : @[];
+    }
+
+    NSArray *objects;
+    if (query.queryableClass == [LYRConversation class]) {
+        objects = self.conversations;
+    } else if (query.queryableClass == [LYRMessage class]) {
+        objects = self.messages;
+        // Messages are stored by conversation, like the client's index.
+        if (![predicate isKindOfClass:[LYRCompoundPredicate class]] && predicate.predicateOperator == LYRPredicateOperatorIsEqualTo && [predicate.property isEqualToString:@"conversation"]) {
+            return self.messagesByConversationIdentifier[[predicate.value identifier]] ?: @[];
+        }
+    } else if (query.queryableClass == [LYRIdentity class]) {
+        objects = self.identities;
+    } else {
+        return @[];
+    }
+    if (!predicate) {
+        return objects;
+    }
+    ATLMFakeLayerStoreMatcher matcher = ATLMFakeLayerStoreMatcherForPredicate(predicate);
+    NSMutableArray *matchingObjects = [NSMutableArray new];
+    for (id object in objects) {
+        if (matcher(object)) {
+            [matchingObjects addObject:object];
+        }
+    }
+    return matchingObjects;
+}
+
+#pragma mark - Corpus Access
+
+- (NSArray *)messagesInConversation:(LYRConversation *)conversation
+{
+    return self.messagesByConversationIdentifier[conversation.identifier] ?: @[];
+}
+
+#pragma mark - Changes
+
+- (LYRMessage *)newMessageInConversation:(LYRConversation *)conversation
+{
+    uint64_t state = self.corpus.seed ^ ++self.changeSequence;
+    NSMutableArray *senders = [conversation.participants.allObjects mutableCopy];
+    if (senders.count > 1) {
+        [senders removeObject:self.authenticatedUser];
+    }
+    [senders sortUsingDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:@"userID" ascending:YES] ]];
+    NSDate *date = [conversation.lastMessage.receivedAt dateByAddingTimeInterval:60];
+    return (LYRMessage *)[self messageInConversation:conversation participants:senders position:conversation.totalNumberOfMessages + self.changeSequence date:date state:&state];
+}
+
+- (LYRMessage *)newImageMessageInConversation:(LYRConversation *)conversation imageData:(NSData *)imageData previewData:(NSData *)previewData pixelSize:(CGSize)pixelSize
+{
+    ATLMFakeLayerStoreMessage *message = (ATLMFakeLayerStoreMessage *)[self newMessageInConversation:conversation];
+    NSString *size = [NSString stringWithFormat:@"{\"width\": %.0f, \"height\": %.0f, \"orientation\": 0}", pixelSize.width, pixelSize.height];
+    message.parts = @[ [LYRMessagePart messagePartWithMIMEType:ATLMIMETypeImageJPEG data:imageData],
+                       [LYRMessagePart messagePartWithMIMEType:ATLMIMETypeImageJPEGPreview data:previewData],
+                       [LYRMessagePart messagePartWithMIMEType:ATLMIMETypeImageSize data:[size dataUsingEncoding:NSUTF8StringEncoding]] ];
+    return (LYRMessage *)message;
+}
+
+- (LYRObjectChange *)changeWithType:(LYRObjectChangeType)type object:(id)object property:(NSString *)property
+{
+    id value = property ? [object valueForKey:property] : nil;
+    return (LYRObjectChange *)[ATLMFakeLayerStoreObjectChange changeWithType:type object:object property:property beforeValue:value afterValue:value];
+}
+
+- (NSDictionary *)remoteNotificationForMessage:(LYRMessage *)message
+{
+    NSString *alert = [NSString stringWithFormat:@"%@: New message", message.sender.displayName];
+    return @{ @"aps": @{ @"alert": alert, @"sound": @"layerbell.caf", @"content-available": @1 },
+              @"layer": @{ @"conversation_identifier": message.conversation.identifier.absoluteString,
+                           @"message_identifier": message.identifier.absoluteString } };
+}
+
+- (NSArray *)changesForSynchronizationOfConversationCount:(NSUInteger)conversationCount metadataStride:(NSUInteger)metadataStride
+{
+    NSMutableArray *changes = [NSMutableArray arrayWithCapacity:conversationCount * 3];
+    for (NSUInteger index = 0; index < conversationCount && self.conversations.count; index++) {
+        LYRConversation *conversation = self.conversations[index % self.conversations.count];
+        LYRMessage *message = [self newMessageInConversation:conversation];
+        [changes addObject:[self changeWithType:LYRObjectChangeTypeCreate object:message property:nil]];
+        [changes addObject:[ATLMFakeLayerStoreObjectChange changeWithType:LYRObjectChangeTypeUpdate object:conversation property:@"lastMessage" beforeValue:conversation.lastMessage afterValue:message]];
+        if (metadataStride && index % metadataStride == 0) {
+            [changes addObject:[self changeWithType:LYRObjectChangeTypeUpdate object:conversation property:@"metadata"]];
+        }
+    }
+    return changes;
+}
+
+@end
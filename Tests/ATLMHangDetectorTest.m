@@ -0,0 +1,132 @@
+//
+//  ATLMHangDetectorTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMHangDetector.h"
+
+@interface ATLMHangDetectorTest : XCTestCase
+
+@property (nonatomic) ATLMHangDetector *detector;
+
+@end
+
+@implementation ATLMHangDetectorTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.detector = [ATLMHangDetector detector];
+    self.detector.threshold = 0.1;
+    self.detector.sampleInterval = 0.02;
+    self.detector.activeControllerProvider = ^NSString *{
+        return @"ATLMStalledViewController";
+    };
+    [self.detector start];
+    // Lets the main thread answer the first ping, so the controller is known.
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+}
+
+- (void)tearDown
+{
+    [self.detector stop];
+    self.detector = nil;
+    [super tearDown];
+}
+
+/**
+ @abstract Keeps the main thread busy, the way a synchronous query or decode would.
+ */
+- (void)stallMainThreadForTimeInterval:(NSTimeInterval)interval
+{
+    CFAbsoluteTime end = CFAbsoluteTimeGetCurrent() + interval;
+    while (CFAbsoluteTimeGetCurrent() < end) {
+    }
+}
+
+- (void)waitForHangCount:(NSUInteger)hangCount
+{
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"countOfHangs == %lu", (unsigned long)hangCount];
+    [self expectationForPredicate:predicate evaluatedWithObject:self.detector handler:nil];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+- (void)testDetectsAndAttributesStalls
+{
+    [self.detector beginOperation:@"test.stall"];
+    [self stallMainThreadForTimeInterval:0.3];
+    [self.detector endOperation:@"test.stall"];
+    [self waitForHangCount:1];
+
+    ATLMHang *hang = self.detector.hangs.firstObject;
+    expect(hang.duration).to.beGreaterThanOrEqualTo(0.2);
+    expect(hang.duration).to.beLessThan(1);
+    expect(hang.operationTag).to.equal(@"test.stall");
+    expect(hang.controllerName).to.equal(@"ATLMStalledViewController");
+    expect(hang.stackSamples.count).to.beGreaterThan(0);
+    NSString *stack = [hang.stackSamples.firstObject componentsJoinedByString:@"\n"];
+    expect(stack).to.contain(@"stallMainThreadForTimeInterval");
+}
+
+- (void)testShortStallsAreNotRecorded
+{
+    for (NSUInteger index = 0; index < 5; index++) {
+        [self stallMainThreadForTimeInterval:0.03];
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.03]];
+    }
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    expect(self.detector.countOfHangs).to.equal(0);
+}
+
+- (void)testOperationTagsNest
+{
+    [self.detector beginOperation:@"test.outer"];
+    [self.detector beginOperation:@"test.inner"];
+    [self.detector endOperation:@"test.inner"];
+    [self stallMainThreadForTimeInterval:0.2];
+    [self.detector endOperation:@"test.outer"];
+    [self waitForHangCount:1];
+    expect(self.detector.hangs.firstObject.operationTag).to.equal(@"test.outer");
+
+    [self stallMainThreadForTimeInterval:0.2];
+    [self waitForHangCount:2];
+    expect(self.detector.hangs.lastObject.operationTag).to.beNil();
+}
+
+- (void)testRingBufferKeepsTheMostRecentHangs
+{
+    self.detector.capacity = 2;
+    NSArray *tags = @[ @"test.first", @"test.second", @"test.third" ];
+    for (NSUInteger index = 0; index < tags.count; index++) {
+        [self.detector beginOperation:tags[index]];
+        [self stallMainThreadForTimeInterval:0.2];
+        [self.detector endOperation:tags[index]];
+        [self waitForHangCount:index + 1];
+    }
+    expect([self.detector.hangs valueForKey:@"operationTag"]).to.equal(@[ @"test.second", @"test.third" ]);
+
+    NSDictionary *snapshot = [NSJSONSerialization JSONObjectWithData:[self.detector JSONSnapshot] options:0 error:nil];
+    expect(snapshot[@"count"]).to.equal(3);
+    expect([snapshot[@"hangs"] valueForKey:@"operation"]).to.equal(@[ @"test.second", @"test.third" ]);
+    expect([snapshot[@"hangs"] firstObject][@"stacks"]).toNot.beEmpty();
+}
+
+@end
@@ -0,0 +1,185 @@
+//
+//  ATLMInlineReplyQueueTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMInlineReplyQueue.h"
+
+/**
+ @abstract Stand-in for the Layer client: only knows about the conversations
+   it has been told about, and records what it sends.
+ */
+@interface ATLMFakeReplyClient : NSObject <ATLMInlineReplyQueueDelegate>
+
+@property (nonatomic) NSMutableSet *knownConversationIdentifiers;
+@property (nonatomic) NSMutableArray *sentReplies;
+@property (nonatomic) NSMutableArray *reportedLatencies;
+
+@end
+
+@implementation ATLMFakeReplyClient
+
+- (id)init
+{
+    self = [super init];
+    if (self) {
+        _knownConversationIdentifiers = [NSMutableSet new];
+        _sentReplies = [NSMutableArray new];
+        _reportedLatencies = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (BOOL)inlineReplyQueue:(ATLMInlineReplyQueue *)inlineReplyQueue sendReplyText:(NSString *)text toConversationWithIdentifier:(NSURL *)conversationIdentifier error:(NSError **)error
+{
+    if (![self.knownConversationIdentifiers containsObject:conversationIdentifier]) {
+        if (error) {
+            *error = [NSError errorWithDomain:@"ATLMFakeReplyClient" code:1 userInfo:nil];
+        }
+        return NO;
+    }
+    [self.sentReplies addObject:@[ conversationIdentifier, text ]];
+    return YES;
+}
+
+- (void)inlineReplyQueue:(ATLMInlineReplyQueue *)inlineReplyQueue didHandOffReplyWithIdentifier:(NSString *)replyIdentifier handOffLatency:(NSTimeInterval)latency
+{
+    [self.reportedLatencies addObject:@(latency)];
+}
+
+@end
+
+@interface ATLMInlineReplyQueueTest : XCTestCase
+
+@property (nonatomic) NSString *persistencePath;
+@property (nonatomic) ATLMFakeReplyClient *client;
+@property (nonatomic) NSURL *conversationIdentifier;
+
+@end
+
+@implementation ATLMInlineReplyQueueTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.persistencePath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"InlineReplies-%@.plist", [NSUUID UUID].UUIDString]];
+    self.client = [ATLMFakeReplyClient new];
+    self.conversationIdentifier = [NSURL URLWithString:@"layer:///conversations/e3ac9ff8-5b1c-4b4c-a4a5-6a3d4d44b001"];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:self.persistencePath error:nil];
+    [super tearDown];
+}
+
+- (void)testRaisesOnAttemptToInit
+{
+    expect(^{ [ATLMInlineReplyQueue new]; }).to.raise(NSInternalInconsistencyException);
+}
+
+- (void)testReplyToKnownConversationIsSentWithoutSynchronization
+{
+    [self.client.knownConversationIdentifiers addObject:self.conversationIdentifier];
+    ATLMInlineReplyQueue *queue = [ATLMInlineReplyQueue queueWithPersistencePath:self.persistencePath delegate:self.client];
+    NSString *replyIdentifier = [queue enqueueReplyText:@"On my way" conversationIdentifier:self.conversationIdentifier];
+
+    expect([queue containsReplyWithIdentifier:replyIdentifier]).to.beFalsy();
+    expect(self.client.sentReplies).to.equal(@[ @[ self.conversationIdentifier, @"On my way" ] ]);
+    expect(self.client.reportedLatencies).to.haveCountOf(1);
+    expect([self.client.reportedLatencies.firstObject doubleValue]).to.beLessThan(0.1);
+    expect(queue.countOfSentReplies).to.equal(1);
+    expect([[NSFileManager defaultManager] fileExistsAtPath:self.persistencePath]).to.beFalsy();
+}
+
+- (void)testReplyToUnknownConversationIsSentAfterSynchronization
+{
+    ATLMInlineReplyQueue *queue = [ATLMInlineReplyQueue queueWithPersistencePath:self.persistencePath delegate:self.client];
+    NSString *replyIdentifier = [queue enqueueReplyText:@"Sounds good" conversationIdentifier:self.conversationIdentifier];
+    expect([queue containsReplyWithIdentifier:replyIdentifier]).to.beTruthy();
+    expect(self.client.sentReplies).to.beEmpty();
+
+    // Simulates the synchronization bringing in the conversation.
+    [self.client.knownConversationIdentifiers addObject:self.conversationIdentifier];
+    expect([queue sendPendingReplies]).to.equal(0);
+    expect([queue containsReplyWithIdentifier:replyIdentifier]).to.beFalsy();
+    expect(self.client.sentReplies).to.haveCountOf(1);
+}
+
+- (void)testPendingRepliesSurviveSuspension
+{
+    ATLMInlineReplyQueue *queue = [ATLMInlineReplyQueue queueWithPersistencePath:self.persistencePath delegate:self.client];
+    [queue enqueueReplyText:@"First" conversationIdentifier:self.conversationIdentifier];
+    [queue enqueueReplyText:@"Second" conversationIdentifier:self.conversationIdentifier];
+    queue = nil;
+
+    // A fresh queue, as if the app got terminated while suspended and relaunched.
+    ATLMFakeReplyClient *relaunchedClient = [ATLMFakeReplyClient new];
+    [relaunchedClient.knownConversationIdentifiers addObject:self.conversationIdentifier];
+    ATLMInlineReplyQueue *relaunchedQueue = [ATLMInlineReplyQueue queueWithPersistencePath:self.persistencePath delegate:relaunchedClient];
+    expect(relaunchedQueue.countOfPendingReplies).to.equal(2);
+    expect([relaunchedQueue sendPendingReplies]).to.equal(0);
+    expect(relaunchedClient.sentReplies).to.equal((@[ @[ self.conversationIdentifier, @"First" ], @[ self.conversationIdentifier, @"Second" ] ]));
+    expect(relaunchedQueue.lastReplyHandOffLatency).to.beGreaterThan(0);
+}
+
+- (void)testRepliesToSameConversationKeepTheirOrder
+{
+    NSURL *otherConversationIdentifier = [NSURL URLWithString:@"layer:///conversations/other"];
+    [self.client.knownConversationIdentifiers addObject:otherConversationIdentifier];
+    ATLMInlineReplyQueue *queue = [ATLMInlineReplyQueue queueWithPersistencePath:self.persistencePath delegate:self.client];
+    [queue enqueueReplyText:@"1" conversationIdentifier:self.conversationIdentifier];
+    [queue enqueueReplyText:@"2" conversationIdentifier:otherConversationIdentifier];
+    [queue enqueueReplyText:@"3" conversationIdentifier:self.conversationIdentifier];
+    expect(self.client.sentReplies).to.equal(@[ @[ otherConversationIdentifier, @"2" ] ]);
+
+    [self.client.knownConversationIdentifiers addObject:self.conversationIdentifier];
+    [queue sendPendingReplies];
+    expect(self.client.sentReplies).to.haveCountOf(3);
+    expect([[self.client.sentReplies objectAtIndex:1] lastObject]).to.equal(@"1");
+    expect([[self.client.sentReplies objectAtIndex:2] lastObject]).to.equal(@"3");
+}
+
+- (void)testStaleRepliesAreDiscarded
+{
+    ATLMInlineReplyQueue *queue = [ATLMInlineReplyQueue queueWithPersistencePath:self.persistencePath delegate:self.client];
+    queue.maximumReplyAge = 0;
+    [queue enqueueReplyText:@"Too late" conversationIdentifier:self.conversationIdentifier];
+    [self.client.knownConversationIdentifiers addObject:self.conversationIdentifier];
+    expect([queue sendPendingReplies]).to.equal(0);
+    expect(self.client.sentReplies).to.beEmpty();
+}
+
+- (void)testRemovingAllRepliesDropsPersistedReplies
+{
+    ATLMInlineReplyQueue *queue = [ATLMInlineReplyQueue queueWithPersistencePath:self.persistencePath delegate:self.client];
+    [queue enqueueReplyText:@"Not for the next user" conversationIdentifier:self.conversationIdentifier];
+    [queue removeAllReplies];
+    expect(queue.countOfPendingReplies).to.equal(0);
+    expect([[NSFileManager defaultManager] fileExistsAtPath:self.persistencePath]).to.beFalsy();
+
+    [self.client.knownConversationIdentifiers addObject:self.conversationIdentifier];
+    ATLMInlineReplyQueue *relaunchedQueue = [ATLMInlineReplyQueue queueWithPersistencePath:self.persistencePath delegate:self.client];
+    expect([relaunchedQueue sendPendingReplies]).to.equal(0);
+    expect(self.client.sentReplies).to.beEmpty();
+}
+
+@end
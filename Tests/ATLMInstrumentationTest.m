@@ -0,0 +1,129 @@
+//
+//  ATLMInstrumentationTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMInstrumentation.h"
+
+@interface ATLMInstrumentationTest : XCTestCase
+
+@property (nonatomic) ATLMInstrumentation *instrumentation;
+
+@end
+
+@implementation ATLMInstrumentationTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.instrumentation = [ATLMInstrumentation instrumentation];
+}
+
+- (void)testCountersAccumulate
+{
+    [self.instrumentation incrementCounter:@"test.counter" by:1];
+    [self.instrumentation incrementCounter:@"test.counter" by:4];
+    expect([self.instrumentation valueOfCounter:@"test.counter"]).to.equal(5);
+    expect([self.instrumentation valueOfCounter:@"test.missing"]).to.equal(0);
+}
+
+- (void)testPercentilesAreWithinBucketPrecision
+{
+    for (NSUInteger value = 1; value <= 1000; value++) {
+        [self.instrumentation recordValue:value forHistogram:@"test.histogram"];
+    }
+    NSDictionary *histogram = [self.instrumentation snapshot][@"histograms"][@"test.histogram"];
+    expect(histogram[ATLMMetricCountKey]).to.equal(1000);
+    expect([histogram[ATLMMetricMeanKey] doubleValue]).to.beCloseToWithin(500.5, 0.001);
+    expect([histogram[ATLMMetricP50Key] doubleValue]).to.beCloseToWithin(500, 500 * 0.07);
+    expect([histogram[ATLMMetricP95Key] doubleValue]).to.beCloseToWithin(950, 950 * 0.07);
+    expect([histogram[ATLMMetricP99Key] doubleValue]).to.beCloseToWithin(990, 990 * 0.07);
+    expect([histogram[ATLMMetricMaxKey] doubleValue]).to.equal(1000);
+}
+
+- (void)testIntervalsAreRecordedInMicroseconds
+{
+    uint64_t start = [self.instrumentation beginInterval:@"test.interval"];
+    [NSThread sleepForTimeInterval:0.01];
+    [self.instrumentation endInterval:@"test.interval" start:start];
+    [self.instrumentation recordDuration:0.002 forInterval:@"test.interval"];
+
+    NSDictionary *histogram = [self.instrumentation snapshot][@"histograms"][@"test.interval"];
+    expect(histogram[ATLMMetricUnitKey]).to.equal(@"us");
+    expect(histogram[ATLMMetricCountKey]).to.equal(2);
+    expect([histogram[ATLMMetricMaxKey] doubleValue]).to.beGreaterThanOrEqualTo(10000);
+}
+
+- (void)testNothingIsRecordedWhileDisabled
+{
+    self.instrumentation.enabled = NO;
+    [self.instrumentation incrementCounter:@"test.counter" by:1];
+    [self.instrumentation recordValue:1 forHistogram:@"test.histogram"];
+    [self.instrumentation endInterval:@"test.interval" start:[self.instrumentation beginInterval:@"test.interval"]];
+    expect([self.instrumentation snapshot][@"counters"]).to.beEmpty();
+    expect([self.instrumentation snapshot][@"histograms"]).to.beEmpty();
+}
+
+- (void)testJSONSnapshotRoundTrips
+{
+    [self.instrumentation incrementCounter:@"test.counter" by:2];
+    [self.instrumentation recordDuration:0.001 forInterval:@"test.interval"];
+    NSDictionary *snapshot = [NSJSONSerialization JSONObjectWithData:[self.instrumentation JSONSnapshot] options:0 error:nil];
+    expect(snapshot[@"counters"][@"test.counter"]).to.equal(2);
+    expect(snapshot[@"histograms"][@"test.interval"][ATLMMetricCountKey]).to.equal(1);
+    expect(snapshot[@"timestamp"]).notTo.beNil();
+}
+
+- (void)testResetClearsMetrics
+{
+    [self.instrumentation incrementCounter:@"test.counter" by:1];
+    [self.instrumentation reset];
+    expect([self.instrumentation valueOfCounter:@"test.counter"]).to.equal(0);
+}
+
+#pragma mark - Overhead
+
+/**
+ @abstract The instrumented hot paths take a hundred microseconds or more, so
+   an interval costing under a microsecond keeps the overhead below 1%.
+ */
+- (void)testIntervalOverheadBenchmark
+{
+    static const NSUInteger iterations = 200000;
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger iteration = 0; iteration < iterations; iteration++) {
+        uint64_t start = [self.instrumentation beginInterval:@"test.overhead"];
+        [self.instrumentation endInterval:@"test.overhead" start:start];
+    }
+    NSTimeInterval intervalCost = (CFAbsoluteTimeGetCurrent() - startTime) / iterations;
+
+    startTime = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger iteration = 0; iteration < iterations; iteration++) {
+        [self.instrumentation incrementCounter:@"test.overhead" by:1];
+    }
+    NSTimeInterval counterCost = (CFAbsoluteTimeGetCurrent() - startTime) / iterations;
+
+    NSLog(@"Instrumentation overhead: %.0f ns per interval, %.0f ns per counter increment", intervalCost * 1e9, counterCost * 1e9);
+    expect(intervalCost).to.beLessThan(1e-6);
+    expect(counterCost).to.beLessThan(1e-6);
+}
+
+@end
@@ -0,0 +1,114 @@
+//
+//  ATLMLayerControllerBlockingTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMFakeLayerStore.h"
+#import "ATLMLayerController.h"
+
+static LYRPolicy *ATLMTestBlockPolicy(NSString *userID)
+{
+    LYRPolicy *policy = [LYRPolicy policyWithType:LYRPolicyTypeBlock];
+    policy.sentByUserID = userID;
+    return policy;
+}
+
+@interface ATLMLayerControllerBlockingTest : XCTestCase
+
+@property (nonatomic) ATLMFakeLayerStore *store;
+@property (nonatomic) ATLMLayerController *layerController;
+
+@end
+
+@implementation ATLMLayerControllerBlockingTest
+
+- (void)setUp
+{
+    [super setUp];
+    ATLMFakeLayerStoreCorpus corpus = ATLMFakeLayerStoreDefaultCorpus;
+    corpus.conversationCount = 1;
+    self.store = [ATLMFakeLayerStore storeWithCorpus:corpus];
+    self.layerController = [self.store newLayerController];
+}
+
+- (void)tearDown
+{
+    self.layerController = nil;
+    [self.store removeAccountData];
+    self.store = nil;
+    [super tearDown];
+}
+
+/**
+ @abstract Simulates a policy change made on another device, as the client reports it.
+ */
+- (void)reportPolicyChangeOfType:(LYRObjectChangeType)type policy:(LYRPolicy *)policy
+{
+    [self.layerController layerClient:(LYRClient *)self.store objectsDidChange:@[ [self.store changeWithType:type object:policy property:nil] ]];
+}
+
+- (void)testBlockingAndUnblockingUpdateTheIndex
+{
+    NSError *error;
+    expect([self.layerController blockUserWithID:@"user-00001" error:&error]).to.beTruthy();
+    expect([self.layerController isUserBlocked:@"user-00001"]).to.beTruthy();
+    expect([self.layerController blockPolicyForUserID:@"user-00001"]).to.equal(self.store.policies.firstObject);
+    expect(self.layerController.blockedUserIDs).to.equal([NSSet setWithObject:@"user-00001"]);
+
+    expect([self.layerController unblockUserWithID:@"user-00001" error:&error]).to.beTruthy();
+    expect([self.layerController isUserBlocked:@"user-00001"]).to.beFalsy();
+    expect(self.store.policies).to.haveCountOf(0);
+    expect(self.layerController.blockedUserIDs).to.beEmpty();
+}
+
+- (void)testLookupsDoNotReadThePoliciesUntilTheyChange
+{
+    for (NSUInteger index = 0; index < 100; index++) {
+        [self.store addPolicies:[NSSet setWithObject:ATLMTestBlockPolicy([NSString stringWithFormat:@"user-%05lu", (unsigned long)index])] error:nil];
+    }
+    expect([self.layerController isUserBlocked:@"user-00042"]).to.beTruthy();
+    NSUInteger countOfPolicyReads = self.store.countOfPolicyReads;
+    for (NSUInteger index = 0; index < 1000; index++) {
+        [self.layerController isUserBlocked:[NSString stringWithFormat:@"user-%05lu", (unsigned long)(index % 200)]];
+    }
+    expect(self.store.countOfPolicyReads).to.equal(countOfPolicyReads);
+}
+
+- (void)testPolicyChangesFromOtherDevicesAreIndexed
+{
+    LYRPolicy *policy = ATLMTestBlockPolicy(@"user-00001");
+    [self.store addPolicies:[NSSet setWithObject:policy] error:nil];
+    expect([self.layerController isUserBlocked:@"user-00001"]).to.beTruthy();
+
+    // Same count and the policies are replaced in place, which comparing
+    // the count and last policy would not notice.
+    LYRPolicy *replacement = ATLMTestBlockPolicy(@"user-00002");
+    [self.store removePolicies:[NSSet setWithObject:policy] error:nil];
+    [self.store addPolicies:[NSSet setWithObject:replacement] error:nil];
+    [self reportPolicyChangeOfType:LYRObjectChangeTypeDelete policy:policy];
+    [self reportPolicyChangeOfType:LYRObjectChangeTypeCreate policy:replacement];
+
+    expect([self.layerController isUserBlocked:@"user-00001"]).to.beFalsy();
+    expect([self.layerController blockPolicyForUserID:@"user-00002"]).to.equal(replacement);
+    expect(self.layerController.blockedUserIDs).to.equal([NSSet setWithObject:@"user-00002"]);
+}
+
+@end
@@ -0,0 +1,173 @@
+//
+//  ATLMLocationSnapshotRendererTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMLocationSnapshotRenderer.h"
+#import "ATLMDiskLRUCache.h"
+
+@interface ATLMLocationSnapshotRendererTest : XCTestCase
+
+@property (nonatomic) NSString *directory;
+@property (nonatomic) NSMutableArray<MKMapSnapshotOptions *> *renderedOptions;
+@property (nonatomic) NSError *renderingError;
+@property (nonatomic) BOOL renderedOnMainThread;
+
+@end
+
+@implementation ATLMLocationSnapshotRendererTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    self.renderedOptions = [NSMutableArray new];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+    [super tearDown];
+}
+
+/**
+ @abstract Creates a renderer whose maps are plain gray images, rendered after a short delay like the snapshotter's.
+ */
+- (ATLMLocationSnapshotRenderer *)newRenderer
+{
+    __weak typeof(self) weakSelf = self;
+    ATLMDiskLRUCache *diskCache = [ATLMDiskLRUCache cacheWithDirectory:self.directory byteLimit:1024 * 1024];
+    ATLMLocationSnapshotRenderer *renderer = [ATLMLocationSnapshotRenderer rendererWithDiskCache:diskCache snapshotBlock:^(MKMapSnapshotOptions *options, void (^completion)(UIImage *, NSError *)) {
+        weakSelf.renderedOnMainThread = weakSelf.renderedOnMainThread || [NSThread isMainThread];
+        NSError *error = weakSelf.renderingError;
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [weakSelf.renderedOptions addObject:options];
+        });
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.05 * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            if (error) {
+                completion(nil, error);
+                return;
+            }
+            UIGraphicsBeginImageContextWithOptions(options.size, YES, options.scale);
+            [[UIColor grayColor] setFill];
+            UIRectFill(CGRectMake(0, 0, options.size.width, options.size.height));
+            UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
+            UIGraphicsEndImageContext();
+            completion(image, nil);
+        });
+    }];
+    renderer.scale = 2;
+    return renderer;
+}
+
+- (UIImage *)renderSnapshotWithRenderer:(ATLMLocationSnapshotRenderer *)renderer coordinate:(CLLocationCoordinate2D)coordinate
+{
+    __block UIImage *renderedImage;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"snapshot rendered"];
+    [renderer renderSnapshotForCoordinate:coordinate zoomLevel:16 size:CGSizeMake(320, 480) completion:^(UIImage *image, NSError *error) {
+        renderedImage = image;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    return renderedImage;
+}
+
+- (void)testRaisesOnAttemptToInit
+{
+    expect(^{ [ATLMLocationSnapshotRenderer new]; }).to.raise(NSInternalInconsistencyException);
+}
+
+- (void)testKeysRoundCoordinatesToAPixelAtTheZoomLevel
+{
+    CLLocationCoordinate2D coordinate = CLLocationCoordinate2DMake(37.7749295, -122.4194155);
+    // A pixel at zoom level 16 and scale 2 is about 0.00001 degrees of longitude.
+    CLLocationCoordinate2D nearbyCoordinate = CLLocationCoordinate2DMake(37.7749297, -122.4194157);
+    CLLocationCoordinate2D distantCoordinate = CLLocationCoordinate2DMake(37.7750295, -122.4194155);
+    NSString *key = ATLMLocationSnapshotKey(coordinate, 16, CGSizeMake(320, 480), 2);
+    expect(ATLMLocationSnapshotKey(nearbyCoordinate, 16, CGSizeMake(320, 480), 2)).to.equal(key);
+    expect(ATLMLocationSnapshotKey(distantCoordinate, 16, CGSizeMake(320, 480), 2)).toNot.equal(key);
+    // Coordinates pixels apart at zoom level 16 fall into the same pixel at 10.
+    expect(ATLMLocationSnapshotKey(CLLocationCoordinate2DMake(37.7746, -122.4193), 16, CGSizeMake(320, 480), 2)).toNot.equal(ATLMLocationSnapshotKey(CLLocationCoordinate2DMake(37.7747, -122.4193), 16, CGSizeMake(320, 480), 2));
+    expect(ATLMLocationSnapshotKey(CLLocationCoordinate2DMake(37.7746, -122.4193), 10, CGSizeMake(320, 480), 2)).to.equal(ATLMLocationSnapshotKey(CLLocationCoordinate2DMake(37.7747, -122.4193), 10, CGSizeMake(320, 480), 2));
+    expect(ATLMLocationSnapshotKey(coordinate, 16, CGSizeMake(320.4, 479.6), 2)).to.equal(ATLMLocationSnapshotKey(coordinate, 16, CGSizeMake(321, 480), 2));
+    expect(ATLMLocationSnapshotKey(coordinate, 16, CGSizeMake(480, 320), 2)).toNot.equal(key);
+
+    MKCoordinateRegion region = ATLMLocationSnapshotRegion(CLLocationCoordinate2DMake(0, 0), 0, CGSizeMake(256, 256));
+    expect(region.span.longitudeDelta).to.equal(360);
+    expect(region.span.latitudeDelta).to.equal(180);
+}
+
+- (void)testRendersOffTheMainThreadWithAPin
+{
+    ATLMLocationSnapshotRenderer *renderer = [self newRenderer];
+    UIImage *image = [self renderSnapshotWithRenderer:renderer coordinate:CLLocationCoordinate2DMake(37.7749295, -122.4194155)];
+    expect(image.size).to.equal(CGSizeMake(320, 480));
+    expect(image.scale).to.equal(2);
+    expect(self.renderedOnMainThread).to.beFalsy();
+    expect(self.renderedOptions.firstObject.region.center.latitude).to.beCloseToWithin(37.7749295, 0.00001);
+
+    // The center is covered by the pin rather than the gray map.
+    uint8_t pixel[4] = { 0 };
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(pixel, 1, 1, 8, 4, colorSpace, (CGBitmapInfo)kCGImageAlphaNoneSkipLast);
+    CGColorSpaceRelease(colorSpace);
+    CGContextDrawImage(context, CGRectMake(-320, -480, 640, 960), image.CGImage);
+    CGContextRelease(context);
+    expect(pixel[0]).to.beGreaterThan(pixel[2] + 100);
+}
+
+- (void)testCoalescesRequestsAndReadsBackFromDisk
+{
+    CLLocationCoordinate2D coordinate = CLLocationCoordinate2DMake(48.8583701, 2.2944813);
+    ATLMLocationSnapshotRenderer *renderer = [self newRenderer];
+    __block NSUInteger completionCount = 0;
+    [renderer renderSnapshotForCoordinate:coordinate zoomLevel:16 size:CGSizeMake(320, 480) completion:^(UIImage *image, NSError *error) {
+        completionCount += 1;
+    }];
+    UIImage *image = [self renderSnapshotWithRenderer:renderer coordinate:coordinate];
+    expect(image).toNot.beNil();
+    expect(completionCount).to.equal(1);
+    expect(renderer.countOfRenders).to.equal(1);
+    expect(renderer.countOfCoalescedRequests).to.equal(1);
+
+    ATLMLocationSnapshotRenderer *restoredRenderer = [self newRenderer];
+    UIImage *diskImage = [self renderSnapshotWithRenderer:restoredRenderer coordinate:coordinate];
+    expect(diskImage.size).to.equal(CGSizeMake(320, 480));
+    expect(restoredRenderer.countOfDiskHits).to.equal(1);
+    expect(restoredRenderer.countOfRenders).to.equal(0);
+    expect(self.renderedOptions.count).to.equal(1);
+}
+
+- (void)testRenderingErrorsAreReported
+{
+    self.renderingError = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNotConnectedToInternet userInfo:nil];
+    ATLMLocationSnapshotRenderer *renderer = [self newRenderer];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"snapshot failed"];
+    [renderer renderSnapshotForCoordinate:CLLocationCoordinate2DMake(0, 0) zoomLevel:16 size:CGSizeMake(320, 480) completion:^(UIImage *image, NSError *error) {
+        expect(image).to.beNil();
+        expect(error.code).to.equal(NSURLErrorNotConnectedToInternet);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    expect(renderer.diskCache.count).to.equal(0);
+}
+
+@end
@@ -0,0 +1,233 @@
+//
+//  ATLMMediaTranscoderTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import <AVFoundation/AVFoundation.h>
+#import "ATLMMediaTranscoder.h"
+#import "ATLMErrors.h"
+#import "ATLMessagingUtilities.h"
+
+/**
+ @abstract Renders a noisy camera sized image, which compresses about as badly as a photo.
+ */
+static UIImage *ATLMTestPhoto(CGSize size, NSUInteger seed)
+{
+    UIGraphicsBeginImageContextWithOptions(size, YES, 1.0);
+    CGContextRef context = UIGraphicsGetCurrentContext();
+    srand48(seed);
+    for (CGFloat y = 0; y < size.height; y += 24) {
+        for (CGFloat x = 0; x < size.width; x += 24) {
+            CGContextSetRGBFillColor(context, drand48(), drand48(), drand48(), 1.0);
+            CGContextFillRect(context, CGRectMake(x, y, 24, 24));
+        }
+    }
+    UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+    return image;
+}
+
+@interface ATLMMediaTranscoderTest : XCTestCase
+
+@property (nonatomic) ATLMMediaTranscoder *transcoder;
+
+@end
+
+@implementation ATLMMediaTranscoderTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.transcoder = [ATLMMediaTranscoder transcoder];
+}
+
+- (void)testCanTranscodeMIMETypes
+{
+    expect([ATLMMediaTranscoder canTranscodeMIMEType:ATLMIMETypeImageJPEG]).to.beTruthy();
+    expect([ATLMMediaTranscoder canTranscodeMIMEType:ATLMIMETypeImagePNG]).to.beTruthy();
+    expect([ATLMMediaTranscoder canTranscodeMIMEType:ATLMIMETypeVideoMP4]).to.beTruthy();
+    expect([ATLMMediaTranscoder canTranscodeMIMEType:ATLMIMETypeTextPlain]).to.beFalsy();
+}
+
+- (void)testUnsupportedMIMETypeFails
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"transcoding failed"];
+    NSInputStream *inputStream = [NSInputStream inputStreamWithData:[@"Hello" dataUsingEncoding:NSUTF8StringEncoding]];
+    [self.transcoder transcodeMediaWithMIMEType:ATLMIMETypeTextPlain inputStream:inputStream completion:^(ATLMTranscodedMedia *media, NSError *error) {
+        expect(media).to.beNil();
+        expect(error.code).to.equal(ATLMMediaTypeNotSupported);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
+- (void)testImageIsDownscaledWithPreviewAndSizeParts
+{
+    NSData *imageData = UIImageJPEGRepresentation(ATLMTestPhoto(CGSizeMake(4032, 3024), 1), 1.0);
+    XCTestExpectation *expectation = [self expectationWithDescription:@"image transcoded"];
+    [self.transcoder transcodeMediaWithMIMEType:ATLMIMETypeImageJPEG inputStream:[NSInputStream inputStreamWithData:imageData] completion:^(ATLMTranscodedMedia *media, NSError *error) {
+        expect(error).to.beNil();
+        expect(media.MIMETypes).to.equal(@[ ATLMIMETypeImageJPEG, ATLMIMETypeImageJPEGPreview, ATLMIMETypeImageSize ]);
+        expect(media.pixelSize).to.equal(CGSizeMake(2048, 1536));
+        expect(media.byteCount).to.beLessThan(imageData.length);
+
+        UIImage *preview = [UIImage imageWithData:media.partData[1]];
+        expect(MAX(preview.size.width, preview.size.height)).to.equal(512);
+        expect(ATLImageSizeForJSONData(media.partData[2])).to.equal(CGSizeMake(2048, 1536));
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:30.0 handler:nil];
+}
+
+- (void)testSmallJPEGIsNotReencoded
+{
+    NSData *imageData = UIImageJPEGRepresentation(ATLMTestPhoto(CGSizeMake(320, 240), 2), 0.3);
+    XCTestExpectation *expectation = [self expectationWithDescription:@"image transcoded"];
+    [self.transcoder transcodeImageData:imageData completion:^(ATLMTranscodedMedia *media, NSError *error) {
+        expect(media.partData.firstObject).to.equal(imageData);
+        expect(self.transcoder.countOfBytesSaved).to.equal(0);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+}
+
+- (void)testVideoIsReencodedBelowBitRateCeiling
+{
+    NSURL *inputURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID].UUIDString stringByAppendingPathExtension:@"mp4"]]];
+    [self writeTestVideoToURL:inputURL size:CGSizeMake(1920, 1080) frameCount:60 bitRate:12000000];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"video transcoded"];
+    [self.transcoder transcodeVideoAtURL:inputURL completion:^(ATLMTranscodedMedia *media, NSError *error) {
+        expect(error).to.beNil();
+        expect(media.MIMETypes).to.equal(@[ ATLMIMETypeVideoMP4, ATLMIMETypeImageJPEGPreview, ATLMIMETypeImageSize ]);
+        expect(media.pixelSize).to.equal(CGSizeMake(1280, 720));
+        expect(media.byteCount).to.beLessThan(media.originalByteCount);
+
+        NSURL *outputURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID].UUIDString stringByAppendingPathExtension:@"mp4"]]];
+        [media.partData.firstObject writeToURL:outputURL atomically:YES];
+        AVAssetTrack *videoTrack = [[AVURLAsset assetWithURL:outputURL] tracksWithMediaType:AVMediaTypeVideo].firstObject;
+        expect(videoTrack.estimatedDataRate).to.beLessThan(self.transcoder.videoBitRateCeiling * 1.2);
+        [[NSFileManager defaultManager] removeItemAtURL:outputURL error:nil];
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:60.0 handler:nil];
+    [[NSFileManager defaultManager] removeItemAtURL:inputURL error:nil];
+}
+
+- (void)testFallsBackToTheOriginalMediaWhenTranscodingFails
+{
+    NSData *imageData = [@"not an image" dataUsingEncoding:NSUTF8StringEncoding];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"media prepared"];
+    [self.transcoder transcodeMediaWithMIMEType:ATLMIMETypeImageJPEG inputStream:[NSInputStream inputStreamWithData:imageData] fallingBackToOriginalWithCompletion:^(ATLMTranscodedMedia *media, NSError *error) {
+        expect(error).notTo.beNil();
+        expect(media.isTranscoded).to.beFalsy();
+        expect(media.MIMETypes).to.equal(@[ ATLMIMETypeImageJPEG ]);
+        expect(media.partData).to.equal(@[ imageData ]);
+        expect(self.transcoder.countOfTranscodedItems).to.equal(0);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+}
+
+- (void)testTranscodedMediaCarriesPreviewAndSizeParts
+{
+    NSData *imageData = UIImageJPEGRepresentation(ATLMTestPhoto(CGSizeMake(4032, 3024), 3), 1.0);
+    XCTestExpectation *expectation = [self expectationWithDescription:@"media prepared"];
+    [self.transcoder transcodeMediaWithMIMEType:ATLMIMETypeImageJPEG inputStream:[NSInputStream inputStreamWithData:imageData] fallingBackToOriginalWithCompletion:^(ATLMTranscodedMedia *media, NSError *error) {
+        expect(media.isTranscoded).to.beTruthy();
+        expect(media.MIMETypes).to.equal(@[ ATLMIMETypeImageJPEG, ATLMIMETypeImageJPEGPreview, ATLMIMETypeImageSize ]);
+        expect(media.partData).to.haveCountOf(3);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:30.0 handler:nil];
+}
+
+#pragma mark - Benchmark
+
+- (void)testImageTranscodingBenchmark
+{
+    static const NSUInteger imageCount = 12;
+    NSMutableArray *images = [NSMutableArray new];
+    for (NSUInteger index = 0; index < imageCount; index++) {
+        [images addObject:UIImageJPEGRepresentation(ATLMTestPhoto(CGSizeMake(4032, 3024), index), 1.0)];
+    }
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"images transcoded"];
+    __block NSUInteger completedCount = 0;
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    for (NSData *imageData in images) {
+        [self.transcoder transcodeImageData:imageData completion:^(ATLMTranscodedMedia *media, NSError *error) {
+            expect(media).notTo.beNil();
+            expect(media.byteCount).to.beLessThan(media.originalByteCount);
+            NSLog(@"Transcoded %llu bytes to %llu bytes (%.0f%% saved) in %.0f ms", media.originalByteCount, media.byteCount, 100.0 * (media.originalByteCount - media.byteCount) / media.originalByteCount, media.encodeDuration * 1000);
+            completedCount += 1;
+            if (completedCount == imageCount) {
+                [expectation fulfill];
+            }
+        }];
+    }
+    [self waitForExpectationsWithTimeout:120.0 handler:nil];
+
+    NSTimeInterval wallTime = CFAbsoluteTimeGetCurrent() - startTime;
+    NSLog(@"Transcoded %lu images on %lu cores: %lld bytes saved, %.0f ms encode time per item, %.0f ms wall time per item", (unsigned long)self.transcoder.countOfTranscodedItems, (unsigned long)self.transcoder.maximumConcurrentTranscodeCount, self.transcoder.countOfBytesSaved, self.transcoder.totalEncodeDuration * 1000 / imageCount, wallTime * 1000 / imageCount);
+    expect(self.transcoder.countOfTranscodedItems).to.equal(imageCount);
+    expect(self.transcoder.countOfBytesSaved).to.beGreaterThan(0);
+}
+
+#pragma mark - Helpers
+
+- (void)writeTestVideoToURL:(NSURL *)fileURL size:(CGSize)size frameCount:(NSUInteger)frameCount bitRate:(NSUInteger)bitRate
+{
+    AVAssetWriter *writer = [AVAssetWriter assetWriterWithURL:fileURL fileType:AVFileTypeMPEG4 error:nil];
+    NSDictionary *settings = @{ AVVideoCodecKey: AVVideoCodecH264,
+                                AVVideoWidthKey: @(size.width),
+                                AVVideoHeightKey: @(size.height),
+                                AVVideoCompressionPropertiesKey: @{ AVVideoAverageBitRateKey: @(bitRate) } };
+    AVAssetWriterInput *input = [AVAssetWriterInput assetWriterInputWithMediaType:AVMediaTypeVideo outputSettings:settings];
+    AVAssetWriterInputPixelBufferAdaptor *adaptor = [AVAssetWriterInputPixelBufferAdaptor assetWriterInputPixelBufferAdaptorWithAssetWriterInput:input sourcePixelBufferAttributes:@{ (__bridge NSString *)kCVPixelBufferPixelFormatTypeKey: @(kCVPixelFormatType_32BGRA), (__bridge NSString *)kCVPixelBufferWidthKey: @(size.width), (__bridge NSString *)kCVPixelBufferHeightKey: @(size.height) }];
+    [writer addInput:input];
+    [writer startWriting];
+    [writer startSessionAtSourceTime:kCMTimeZero];
+
+    for (NSUInteger frame = 0; frame < frameCount; frame++) {
+        while (!input.isReadyForMoreMediaData) {
+            [NSThread sleepForTimeInterval:0.005];
+        }
+        CVPixelBufferRef pixelBuffer = NULL;
+        CVPixelBufferPoolCreatePixelBuffer(NULL, adaptor.pixelBufferPool, &pixelBuffer);
+        CVPixelBufferLockBaseAddress(pixelBuffer, 0);
+        uint8_t *bytes = CVPixelBufferGetBaseAddress(pixelBuffer);
+        size_t length = CVPixelBufferGetBytesPerRow(pixelBuffer) * CVPixelBufferGetHeight(pixelBuffer);
+        // Fresh noise every frame so the encoder actually spends the bit rate.
+        arc4random_buf(bytes, length);
+        CVPixelBufferUnlockBaseAddress(pixelBuffer, 0);
+        [adaptor appendPixelBuffer:pixelBuffer withPresentationTime:CMTimeMake(frame, 30)];
+        CVPixelBufferRelease(pixelBuffer);
+    }
+    [input markAsFinished];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"test video written"];
+    [writer finishWritingWithCompletionHandler:^{
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:60.0 handler:nil];
+}
+
+@end
@@ -0,0 +1,281 @@
+//
+//  ATLMMemoryAccountantTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import <LayerKit/LayerKit.h>
+#import <mach/mach.h>
+#import "ATLMMemoryAccountant.h"
+#import "ATLMMediaViewController.h"
+#import "ATLMessagingUtilities.h"
+#import "ATLMFakeLayerStore.h"
+
+static const NSUInteger ATLMMegabyte = 1024 * 1024;
+static const NSUInteger ATLMMediaScreenCount = 50;
+static const CGSize ATLMMediaImageSize = { 2048, 1536 };
+static const CGSize ATLMMediaPreviewSize = { 512, 384 };
+
+static uint64_t ATLMResidentMemory()
+{
+    struct mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size;
+}
+
+@interface ATLMFakeMemoryConsumer : NSObject <ATLMMemoryConsumer>
+
+@property (nonatomic) NSUInteger memoryFootprint;
+@property (nonatomic) NSString *memoryCategory;
+@property (nonatomic) ATLMMemoryPriority memoryPriority;
+@property (nonatomic) NSString *name;
+@property (nonatomic) NSMutableArray *releaseLog;
+
+@end
+
+@implementation ATLMFakeMemoryConsumer
+
++ (instancetype)consumerNamed:(NSString *)name footprint:(NSUInteger)footprint priority:(ATLMMemoryPriority)priority releaseLog:(NSMutableArray *)releaseLog
+{
+    ATLMFakeMemoryConsumer *consumer = [self new];
+    consumer.name = name;
+    consumer.memoryFootprint = footprint;
+    consumer.memoryCategory = ATLMMemoryCategoryImages;
+    consumer.memoryPriority = priority;
+    consumer.releaseLog = releaseLog;
+    return consumer;
+}
+
+- (NSUInteger)releaseMemory
+{
+    [self.releaseLog addObject:self.name];
+    NSUInteger footprint = self.memoryFootprint;
+    self.memoryFootprint = 0;
+    return footprint;
+}
+
+@end
+
+@interface ATLMMemoryAccountantTest : XCTestCase
+
+@property (nonatomic) ATLMMemoryAccountant *accountant;
+@property (nonatomic) NSMutableArray *releaseLog;
+@property (nonatomic) NSMutableArray *consumers;
+
+@end
+
+@implementation ATLMMemoryAccountantTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.accountant = [ATLMMemoryAccountant accountant];
+    [self.accountant setBudget:10 * ATLMMegabyte forCategory:ATLMMemoryCategoryImages];
+    self.accountant.totalBudget = 0;
+    self.releaseLog = [NSMutableArray new];
+    self.consumers = [NSMutableArray new];
+}
+
+- (void)tearDown
+{
+    self.accountant = nil;
+    self.consumers = nil;
+    [super tearDown];
+}
+
+- (ATLMFakeMemoryConsumer *)registeredConsumerNamed:(NSString *)name megabytes:(NSUInteger)megabytes priority:(ATLMMemoryPriority)priority
+{
+    // The accountant references consumers weakly.
+    ATLMFakeMemoryConsumer *consumer = [ATLMFakeMemoryConsumer consumerNamed:name footprint:megabytes * ATLMMegabyte priority:priority releaseLog:self.releaseLog];
+    [self.consumers addObject:consumer];
+    [self.accountant registerConsumer:consumer];
+    return consumer;
+}
+
+#pragma mark - Accounting
+
+- (void)testFootprintIsAccountedPerCategory
+{
+    ATLMFakeMemoryConsumer *image = [self registeredConsumerNamed:@"image" megabytes:3 priority:ATLMMemoryPriorityVisible];
+    ATLMFakeMemoryConsumer *cache = [ATLMFakeMemoryConsumer consumerNamed:@"cache" footprint:ATLMMegabyte priority:ATLMMemoryPriorityDiscardable releaseLog:self.releaseLog];
+    cache.memoryCategory = ATLMMemoryCategoryCaches;
+    [self.accountant registerConsumer:cache];
+    expect([self.accountant footprintForCategory:ATLMMemoryCategoryImages]).to.equal(3 * ATLMMegabyte);
+    expect([self.accountant footprintForCategory:ATLMMemoryCategoryCaches]).to.equal(ATLMMegabyte);
+    expect(self.accountant.footprint).to.equal(4 * ATLMMegabyte);
+
+    image.memoryFootprint = 5 * ATLMMegabyte;
+    [self.accountant consumerDidChangeFootprint:image];
+    expect(self.accountant.footprint).to.equal(6 * ATLMMegabyte);
+
+    [self.accountant unregisterConsumer:cache];
+    expect(self.accountant.footprint).to.equal(5 * ATLMMegabyte);
+}
+
+- (void)testUnregisteredConsumersAreIgnored
+{
+    ATLMFakeMemoryConsumer *consumer = [ATLMFakeMemoryConsumer consumerNamed:@"stray" footprint:ATLMMegabyte priority:ATLMMemoryPriorityOffscreen releaseLog:self.releaseLog];
+    [self.accountant consumerDidChangeFootprint:consumer];
+    expect(self.accountant.footprint).to.equal(0);
+}
+
+- (void)testConsumersAreReferencedWeakly
+{
+    @autoreleasepool {
+        ATLMFakeMemoryConsumer *consumer = [ATLMFakeMemoryConsumer consumerNamed:@"transient" footprint:2 * ATLMMegabyte priority:ATLMMemoryPriorityOffscreen releaseLog:self.releaseLog];
+        [self.accountant registerConsumer:consumer];
+        expect(self.accountant.footprint).to.equal(2 * ATLMMegabyte);
+    }
+    expect(self.accountant.footprint).to.equal(0);
+}
+
+#pragma mark - Budgets
+
+- (void)testExceedingTheBudgetEvictsLowestPriorityAndOldestFirst
+{
+    [self registeredConsumerNamed:@"offscreen-old" megabytes:3 priority:ATLMMemoryPriorityOffscreen];
+    [self registeredConsumerNamed:@"offscreen-new" megabytes:3 priority:ATLMMemoryPriorityOffscreen];
+    [self registeredConsumerNamed:@"discardable" megabytes:1 priority:ATLMMemoryPriorityDiscardable];
+    expect(self.releaseLog).to.beEmpty();
+
+    [self registeredConsumerNamed:@"visible" megabytes:5 priority:ATLMMemoryPriorityVisible];
+    expect(self.releaseLog).to.equal((@[ @"discardable", @"offscreen-old" ]));
+    expect([self.accountant footprintForCategory:ATLMMemoryCategoryImages]).to.equal(8 * ATLMMegabyte);
+    expect(self.accountant.countOfEvictions).to.equal(2);
+}
+
+- (void)testVisibleConsumersAreNotEvictedByBudgets
+{
+    [self registeredConsumerNamed:@"visible" megabytes:12 priority:ATLMMemoryPriorityVisible];
+    expect(self.releaseLog).to.beEmpty();
+    expect(self.accountant.footprint).to.equal(12 * ATLMMegabyte);
+}
+
+- (void)testTotalBudgetSpansCategories
+{
+    ATLMFakeMemoryConsumer *cache = [ATLMFakeMemoryConsumer consumerNamed:@"cache" footprint:4 * ATLMMegabyte priority:ATLMMemoryPriorityDiscardable releaseLog:self.releaseLog];
+    cache.memoryCategory = ATLMMemoryCategoryCaches;
+    [self.accountant setBudget:0 forCategory:ATLMMemoryCategoryCaches];
+    [self.accountant registerConsumer:cache];
+    [self registeredConsumerNamed:@"visible" megabytes:8 priority:ATLMMemoryPriorityVisible];
+    expect(self.releaseLog).to.beEmpty();
+
+    self.accountant.totalBudget = 10 * ATLMMegabyte;
+    expect(self.releaseLog).to.equal(@[ @"cache" ]);
+}
+
+- (void)testMemoryWarningReleasesVisibleConsumersLast
+{
+    [self registeredConsumerNamed:@"visible" megabytes:2 priority:ATLMMemoryPriorityVisible];
+    [self registeredConsumerNamed:@"offscreen" megabytes:2 priority:ATLMMemoryPriorityOffscreen];
+    [self registeredConsumerNamed:@"discardable" megabytes:2 priority:ATLMMemoryPriorityDiscardable];
+    [self.accountant handleMemoryWarning];
+    expect(self.releaseLog).to.equal((@[ @"discardable", @"offscreen", @"visible" ]));
+    expect(self.accountant.footprint).to.equal(0);
+}
+
+#pragma mark - Reporting
+
+- (void)testHighWaterMarksTrackThePeak
+{
+    ATLMFakeMemoryConsumer *consumer = [self registeredConsumerNamed:@"offscreen" megabytes:6 priority:ATLMMemoryPriorityOffscreen];
+    [self registeredConsumerNamed:@"visible" megabytes:2 priority:ATLMMemoryPriorityVisible];
+    consumer.memoryFootprint = 1 * ATLMMegabyte;
+    [self.accountant consumerDidChangeFootprint:consumer];
+    expect(self.accountant.highWaterMark).to.equal(8 * ATLMMegabyte);
+    expect([self.accountant highWaterMarkForCategory:ATLMMemoryCategoryImages]).to.equal(8 * ATLMMegabyte);
+
+    [self.accountant resetHighWaterMarks];
+    expect(self.accountant.highWaterMark).to.equal(3 * ATLMMegabyte);
+
+    NSDictionary *report = [self.accountant report];
+    expect(report[@"footprint"]).to.equal(3 * ATLMMegabyte);
+    expect(report[@"categories"][ATLMMemoryCategoryImages][@"budget"]).to.equal(10 * ATLMMegabyte);
+}
+
+#pragma mark - Scenario
+
+/**
+ @abstract Opens 50 large images one after the other, the way a user pages
+   through the media of a conversation, and checks the decoded images never
+   exceed the budget by more than the screen being opened.
+ */
+- (void)testOpeningManyLargeImagesStaysWithinTheImageBudget
+{
+    ATLMMemoryAccountant *accountant = [ATLMMemoryAccountant sharedAccountant];
+    NSUInteger budget = [accountant budgetForCategory:ATLMMemoryCategoryImages];
+    [accountant resetHighWaterMarks];
+    NSUInteger evictions = accountant.countOfEvictions;
+
+    NSData *imageData = UIImageJPEGRepresentation([self patternImageWithSize:ATLMMediaImageSize], 0.8);
+    NSData *previewData = UIImageJPEGRepresentation([self patternImageWithSize:ATLMMediaPreviewSize], 0.8);
+    ATLMFakeLayerStore *store = [ATLMFakeLayerStore storeWithCorpus:ATLMFakeLayerStoreDefaultCorpus];
+    LYRConversation *conversation = store.conversations.firstObject;
+    NSUInteger screenFootprint = (NSUInteger)(ATLMMediaImageSize.width * ATLMMediaImageSize.height + ATLMMediaPreviewSize.width * ATLMMediaPreviewSize.height) * 4;
+
+    UIWindow *window = [[UIWindow alloc] initWithFrame:[UIScreen mainScreen].bounds];
+    UINavigationController *navigationController = [[UINavigationController alloc] initWithRootViewController:[UIViewController new]];
+    window.rootViewController = navigationController;
+    [window makeKeyAndVisible];
+
+    uint64_t residentMemoryBefore = ATLMResidentMemory();
+    for (NSUInteger index = 0; index < ATLMMediaScreenCount; index++) {
+        @autoreleasepool {
+            LYRMessage *message = [store newImageMessageInConversation:conversation imageData:imageData previewData:previewData pixelSize:ATLMMediaImageSize];
+            ATLMMediaViewController *controller = [[ATLMMediaViewController alloc] initWithMessage:message];
+            [navigationController pushViewController:controller animated:NO];
+            // Let the images decode and render.
+            [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+        }
+    }
+    uint64_t residentMemoryAfter = ATLMResidentMemory();
+    uint64_t residentMemoryGrowth = residentMemoryAfter > residentMemoryBefore ? residentMemoryAfter - residentMemoryBefore : 0;
+    NSLog(@"Opened %lu images: image high-water mark %.1f MB, budget %.1f MB, %lu evictions, resident memory grew %.1f MB",
+          (unsigned long)ATLMMediaScreenCount, [accountant highWaterMarkForCategory:ATLMMemoryCategoryImages] / (double)ATLMMegabyte,
+          budget / (double)ATLMMegabyte, (unsigned long)(accountant.countOfEvictions - evictions), residentMemoryGrowth / (double)ATLMMegabyte);
+
+    expect([accountant highWaterMarkForCategory:ATLMMemoryCategoryImages]).to.beLessThanOrEqualTo(budget + screenFootprint);
+    expect(accountant.countOfEvictions).to.beGreaterThan(evictions);
+    // Without eviction the decoded images alone would take 50 times the screen footprint.
+    expect(residentMemoryGrowth).to.beLessThan(budget + 4 * screenFootprint);
+
+    [navigationController popToRootViewControllerAnimated:NO];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+    expect([accountant footprintForCategory:ATLMMemoryCategoryImages]).to.equal(0);
+    window.hidden = YES;
+}
+
+- (UIImage *)patternImageWithSize:(CGSize)size
+{
+    UIGraphicsBeginImageContextWithOptions(size, YES, 1);
+    srand48(11);
+    for (NSUInteger index = 0; index < 200; index++) {
+        [[UIColor colorWithHue:drand48() saturation:0.8 brightness:0.9 alpha:1] setFill];
+        UIRectFill(CGRectMake(drand48() * size.width, drand48() * size.height, drand48() * size.width / 4, drand48() * size.height / 4));
+    }
+    UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+    return image;
+}
+
+@end
@@ -0,0 +1,277 @@
+//
+//  ATLMMessageLayoutCacheTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMMessageLayoutCache.h"
+
+static const NSUInteger ATLMBenchmarkMessageCount = 10000;
+static const NSTimeInterval ATLMFrameBudget = 1.0 / 60.0;
+
+/**
+ @abstract Lays out a conversation of text messages the way the Atlas flow layout
+   does: the size of every item is requested on every layout invalidation.
+ */
+@interface ATLMLayoutBenchmarkController : NSObject <UICollectionViewDataSource, UICollectionViewDelegateFlowLayout>
+
+@property (nonatomic) NSArray *messageTexts;
+@property (nonatomic) ATLMMessageLayoutCache *layoutCache;
+@property (nonatomic) UICollectionView *collectionView;
+
+@end
+
+@implementation ATLMLayoutBenchmarkController
+
+- (id)initWithMessageCount:(NSUInteger)count layoutCache:(ATLMMessageLayoutCache *)layoutCache
+{
+    self = [super init];
+    if (self) {
+        NSMutableArray *messageTexts = [NSMutableArray arrayWithCapacity:count];
+        NSString *words = @"Lorem ipsum dolor sit amet consectetur adipiscing elit sed do eiusmod tempor incididunt ut labore";
+        srand48(7);
+        for (NSUInteger index = 0; index < count; index++) {
+            NSUInteger length = 10 + (NSUInteger)(drand48() * (words.length - 10));
+            [messageTexts addObject:[NSString stringWithFormat:@"%lu %@", (unsigned long)index, [words substringToIndex:length]]];
+        }
+        _messageTexts = messageTexts;
+        _layoutCache = layoutCache;
+        UICollectionViewFlowLayout *layout = [UICollectionViewFlowLayout new];
+        layout.minimumLineSpacing = 4;
+        _collectionView = [[UICollectionView alloc] initWithFrame:CGRectMake(0, 0, 320, 568) collectionViewLayout:layout];
+        _collectionView.dataSource = self;
+        _collectionView.delegate = self;
+        [_collectionView registerClass:[UICollectionViewCell class] forCellWithReuseIdentifier:@"Cell"];
+    }
+    return self;
+}
+
+- (NSInteger)collectionView:(UICollectionView *)collectionView numberOfItemsInSection:(NSInteger)section
+{
+    return self.messageTexts.count;
+}
+
+- (UICollectionViewCell *)collectionView:(UICollectionView *)collectionView cellForItemAtIndexPath:(NSIndexPath *)indexPath
+{
+    return [collectionView dequeueReusableCellWithReuseIdentifier:@"Cell" forIndexPath:indexPath];
+}
+
+- (CGSize)collectionView:(UICollectionView *)collectionView layout:(UICollectionViewLayout *)collectionViewLayout sizeForItemAtIndexPath:(NSIndexPath *)indexPath
+{
+    CGFloat width = CGRectGetWidth(collectionView.bounds);
+    NSString *text = self.messageTexts[indexPath.item];
+    CGFloat (^calculation)(void) = ^CGFloat{
+        // Stand-in for the text measurement done by `ATLMessageCollectionViewCell`.
+        CGRect rect = [text boundingRectWithSize:CGSizeMake(width * 0.7, CGFLOAT_MAX) options:NSStringDrawingUsesLineFragmentOrigin attributes:@{ NSFontAttributeName: [UIFont systemFontOfSize:17] } context:nil];
+        return ceil(CGRectGetHeight(rect)) + 16;
+    };
+    CGFloat height = self.layoutCache ? [self.layoutCache heightForMessageIdentifier:[NSString stringWithFormat:@"layer:///messages/%ld", (long)indexPath.item] contentHash:text.length width:width calculation:calculation] : calculation();
+    return CGSizeMake(width, height);
+}
+
+/**
+ @abstract Rotates the collection view to `width` and returns the time the relayout took.
+ */
+- (NSTimeInterval)relayoutToWidth:(CGFloat)width
+{
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    CGRect frame = self.collectionView.frame;
+    frame.size = CGSizeMake(width, width == 320 ? 568 : 320);
+    self.collectionView.frame = frame;
+    [self.collectionView.collectionViewLayout invalidateLayout];
+    [self.collectionView layoutIfNeeded];
+    return CFAbsoluteTimeGetCurrent() - startTime;
+}
+
+@end
+
+@interface ATLMMessageLayoutCacheTest : XCTestCase
+
+@property (nonatomic) NSString *directory;
+
+@end
+
+@implementation ATLMMessageLayoutCacheTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+    [super tearDown];
+}
+
+- (void)testRaisesOnAttemptToInit
+{
+    expect(^{ [ATLMMessageLayoutCache new]; }).to.raise(NSInternalInconsistencyException);
+}
+
+- (void)testHeightIsCalculatedOncePerWidthClass
+{
+    ATLMMessageLayoutCache *cache = [ATLMMessageLayoutCache layoutCacheWithIdentifier:@"layer:///conversations/1" directory:nil];
+    __block NSUInteger calculations = 0;
+    CGFloat (^calculation)(void) = ^CGFloat{
+        calculations += 1;
+        return 42;
+    };
+    expect([cache heightForMessageIdentifier:@"m1" contentHash:1 width:320 calculation:calculation]).to.equal(42);
+    expect([cache heightForMessageIdentifier:@"m1" contentHash:1 width:320.4 calculation:calculation]).to.equal(42);
+    expect(calculations).to.equal(1);
+    [cache heightForMessageIdentifier:@"m1" contentHash:1 width:568 calculation:calculation];
+    [cache heightForMessageIdentifier:@"m1" contentHash:1 width:320 calculation:calculation];
+    expect(calculations).to.equal(2);
+    expect(cache.countOfHits).to.equal(2);
+    expect(cache.countOfMisses).to.equal(2);
+}
+
+- (void)testContentChangeInvalidatesAllWidths
+{
+    ATLMMessageLayoutCache *cache = [ATLMMessageLayoutCache layoutCacheWithIdentifier:@"layer:///conversations/1" directory:nil];
+    [cache heightForMessageIdentifier:@"m1" contentHash:1 width:320 calculation:^CGFloat{ return 40; }];
+    [cache heightForMessageIdentifier:@"m1" contentHash:1 width:568 calculation:^CGFloat{ return 30; }];
+    expect([cache heightForMessageIdentifier:@"m1" contentHash:2 width:320 calculation:^CGFloat{ return 80; }]).to.equal(80);
+    expect([cache heightForMessageIdentifier:@"m1" contentHash:2 width:568 calculation:^CGFloat{ return 60; }]).to.equal(60);
+}
+
+- (void)testInvalidatingMessageOnlyAffectsThatMessage
+{
+    ATLMMessageLayoutCache *cache = [ATLMMessageLayoutCache layoutCacheWithIdentifier:@"layer:///conversations/1" directory:nil];
+    [cache heightForMessageIdentifier:@"m1" contentHash:1 width:320 calculation:^CGFloat{ return 40; }];
+    [cache heightForMessageIdentifier:@"m2" contentHash:1 width:320 calculation:^CGFloat{ return 50; }];
+    [cache invalidateMessageIdentifier:@"m1"];
+    expect([cache heightForMessageIdentifier:@"m1" contentHash:1 width:320 calculation:^CGFloat{ return 41; }]).to.equal(41);
+    expect([cache heightForMessageIdentifier:@"m2" contentHash:1 width:320 calculation:^CGFloat{ return 51; }]).to.equal(50);
+}
+
+- (void)testAttributedStringsAreGeneratedOnce
+{
+    ATLMMessageLayoutCache *cache = [ATLMMessageLayoutCache layoutCacheWithIdentifier:@"layer:///conversations/1" directory:nil];
+    __block NSUInteger generations = 0;
+    NSAttributedString *(^generator)(void) = ^NSAttributedString *{
+        generations += 1;
+        return [[NSAttributedString alloc] initWithString:@"Read by 2 Participants"];
+    };
+    [cache attributedStringForKey:@"status:Read by 2 Participants" generator:generator];
+    [cache attributedStringForKey:@"status:Read by 2 Participants" generator:generator];
+    expect(generations).to.equal(1);
+}
+
+- (void)testHeightsArePersistedAcrossInstances
+{
+    ATLMMessageLayoutCache *cache = [ATLMMessageLayoutCache layoutCacheWithIdentifier:@"layer:///conversations/1" directory:self.directory];
+    [cache heightForMessageIdentifier:@"m1" contentHash:7 width:320 calculation:^CGFloat{ return 44; }];
+    [cache persist];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"loaded"];
+    ATLMMessageLayoutCache *reloadedCache = [ATLMMessageLayoutCache layoutCacheWithIdentifier:@"layer:///conversations/1" directory:self.directory];
+    [reloadedCache loadWithCompletion:^{
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2.0 handler:nil];
+    expect([reloadedCache heightForMessageIdentifier:@"m1" contentHash:7 width:320 calculation:^CGFloat{ return 0; }]).to.equal(44);
+    expect(reloadedCache.countOfHits).to.equal(1);
+}
+
+- (void)testContentSizeCategoryChangeDropsHeights
+{
+    ATLMMessageLayoutCache *cache = [ATLMMessageLayoutCache layoutCacheWithIdentifier:@"layer:///conversations/1" directory:nil];
+    [cache heightForMessageIdentifier:@"m1" contentHash:7 width:320 calculation:^CGFloat{ return 44; }];
+    [cache setValue:@"ATLMPreviousContentSizeCategory" forKey:@"contentSizeCategory"];
+    [[NSNotificationCenter defaultCenter] postNotificationName:UIContentSizeCategoryDidChangeNotification object:[UIApplication sharedApplication]];
+    expect([cache heightForMessageIdentifier:@"m1" contentHash:7 width:320 calculation:^CGFloat{ return 52; }]).to.equal(52);
+    expect(cache.countOfMisses).to.equal(2);
+}
+
+- (void)testOnlyRecentConversationsArePersisted
+{
+    for (NSUInteger index = 0; index < 5; index++) {
+        ATLMMessageLayoutCache *cache = [ATLMMessageLayoutCache layoutCacheWithIdentifier:[NSString stringWithFormat:@"layer:///conversations/%lu", (unsigned long)index] directory:self.directory];
+        cache.maximumPersistedCacheCount = 3;
+        [cache heightForMessageIdentifier:@"m1" contentHash:1 width:320 calculation:^CGFloat{ return 44; }];
+        [cache persist];
+    }
+    // Loading goes through the same serial queue, so all writes have finished once it completes.
+    XCTestExpectation *expectation = [self expectationWithDescription:@"flushed"];
+    [[ATLMMessageLayoutCache layoutCacheWithIdentifier:@"flush" directory:self.directory] loadWithCompletion:^{
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2.0 handler:nil];
+    expect([[NSFileManager defaultManager] contentsOfDirectoryAtPath:self.directory error:nil]).to.haveCountOf(3);
+}
+
+#pragma mark - Benchmarks
+
+- (void)testCachedRotationRelayoutOfLargeConversationIsFasterThanUncached
+{
+    ATLMLayoutBenchmarkController *uncached = [[ATLMLayoutBenchmarkController alloc] initWithMessageCount:ATLMBenchmarkMessageCount layoutCache:nil];
+    [uncached relayoutToWidth:320];
+    NSTimeInterval uncachedFrameTime = [uncached relayoutToWidth:568];
+
+    ATLMMessageLayoutCache *cache = [ATLMMessageLayoutCache layoutCacheWithIdentifier:@"layer:///conversations/benchmark" directory:nil];
+    ATLMLayoutBenchmarkController *cached = [[ATLMLayoutBenchmarkController alloc] initWithMessageCount:ATLMBenchmarkMessageCount layoutCache:cache];
+    // Warm both width classes, as after the first rotation.
+    [cached relayoutToWidth:320];
+    [cached relayoutToWidth:568];
+    [cached relayoutToWidth:320];
+    NSTimeInterval cachedFrameTime = [cached relayoutToWidth:568];
+
+    NSLog(@"Relayout of %lu messages: uncached %.1fms, cached %.1fms (frame budget %.1fms)", (unsigned long)ATLMBenchmarkMessageCount, uncachedFrameTime * 1000, cachedFrameTime * 1000, ATLMFrameBudget * 1000);
+    expect(cachedFrameTime).to.beLessThan(uncachedFrameTime);
+    expect(cachedFrameTime).to.beLessThan(ATLMFrameBudget);
+    expect(cache.countOfMisses).to.equal(ATLMBenchmarkMessageCount * 2);
+}
+
+- (void)testPerformanceOfCachedRotation
+{
+    ATLMMessageLayoutCache *cache = [ATLMMessageLayoutCache layoutCacheWithIdentifier:@"layer:///conversations/benchmark" directory:nil];
+    ATLMLayoutBenchmarkController *cached = [[ATLMLayoutBenchmarkController alloc] initWithMessageCount:ATLMBenchmarkMessageCount layoutCache:cache];
+    [cached relayoutToWidth:320];
+    [cached relayoutToWidth:568];
+    __block CGFloat width = 320;
+    [self measureBlock:^{
+        [cached relayoutToWidth:width];
+        width = width == 320 ? 568 : 320;
+    }];
+}
+
+- (void)testPerformanceOfScrollingLargeConversation
+{
+    ATLMMessageLayoutCache *cache = [ATLMMessageLayoutCache layoutCacheWithIdentifier:@"layer:///conversations/benchmark" directory:nil];
+    ATLMLayoutBenchmarkController *cached = [[ATLMLayoutBenchmarkController alloc] initWithMessageCount:ATLMBenchmarkMessageCount layoutCache:cache];
+    [cached relayoutToWidth:320];
+    UICollectionView *collectionView = cached.collectionView;
+    [self measureBlock:^{
+        // One screen per frame from the bottom to the top of the history.
+        NSTimeInterval slowestFrame = 0;
+        for (CGFloat offset = collectionView.contentSize.height - 568; offset > 0; offset -= 568) {
+            CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+            collectionView.contentOffset = CGPointMake(0, offset);
+            [collectionView layoutIfNeeded];
+            slowestFrame = MAX(slowestFrame, CFAbsoluteTimeGetCurrent() - startTime);
+        }
+        expect(slowestFrame).to.beLessThan(ATLMFrameBudget * 4);
+    }];
+}
+
+@end
@@ -0,0 +1,181 @@
+//
+//  ATLMMessagePartDecoderTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import <LayerKit/LayerKit.h>
+#import "ATLMMessagePartDecoder.h"
+#import "ATLMessagingUtilities.h"
+
+static const NSUInteger ATLMDecodeBenchmarkIterations = 100000;
+
+/**
+ @abstract Stands in for a downloaded message part, which can't be created outside of a client.
+ */
+@interface ATLMFakeMessagePart : NSObject
+
+@property (nonatomic) NSURL *identifier;
+@property (nonatomic) NSString *MIMEType;
+@property (nonatomic) NSData *data;
+
+@end
+
+@implementation ATLMFakeMessagePart
+
++ (LYRMessagePart *)partWithMIMEType:(NSString *)MIMEType JSON:(NSString *)JSON
+{
+    ATLMFakeMessagePart *part = [self new];
+    part.identifier = [NSURL URLWithString:[NSString stringWithFormat:@"layer:///messages/%@/parts/0", [NSUUID UUID].UUIDString]];
+    part.MIMEType = MIMEType;
+    part.data = [JSON dataUsingEncoding:NSUTF8StringEncoding];
+    return (LYRMessagePart *)part;
+}
+
+@end
+
+@interface ATLMMessagePartDecoderTest : XCTestCase
+
+@property (nonatomic) ATLMMessagePartDecoder *decoder;
+
+@end
+
+@implementation ATLMMessagePartDecoderTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.decoder = [ATLMMessagePartDecoder decoder];
+}
+
+- (void)testLocationIsDecoded
+{
+    LYRMessagePart *part = [ATLMFakeMessagePart partWithMIMEType:ATLMIMETypeLocation JSON:@"{\"lat\":37.7749295,\"lon\":-122.4194155}"];
+    ATLMLocationPayload location;
+    expect([self.decoder getLocation:&location forMessagePart:part]).to.beTruthy();
+    expect(location.latitude).to.equal(37.7749295);
+    expect(location.longitude).to.equal(-122.4194155);
+}
+
+- (void)testImageSizeIsDecoded
+{
+    LYRMessagePart *part = [ATLMFakeMessagePart partWithMIMEType:ATLMIMETypeImageSize JSON:@" { \"width\" : 2048, \"height\" : 1.536e3, \"orientation\" : 0 } "];
+    ATLMImageSizePayload imageSize;
+    expect([self.decoder getImageSize:&imageSize forMessagePart:part]).to.beTruthy();
+    expect(imageSize.size).to.equal(CGSizeMake(2048, 1536));
+    expect(imageSize.orientation).to.equal(0);
+}
+
+- (void)testValuesAreMemoized
+{
+    LYRMessagePart *part = [ATLMFakeMessagePart partWithMIMEType:ATLMIMETypeLocation JSON:@"{\"lat\":1,\"lon\":2}"];
+    ATLMLocationPayload location;
+    for (NSUInteger index = 0; index < 10; index++) {
+        [self.decoder getLocation:&location forMessagePart:part];
+    }
+    expect(self.decoder.countOfDecodes).to.equal(1);
+    expect(self.decoder.countOfHits).to.equal(9);
+}
+
+- (void)testWrongMIMETypeIsRejected
+{
+    LYRMessagePart *part = [ATLMFakeMessagePart partWithMIMEType:ATLMIMETypeImageSize JSON:@"{\"width\":1,\"height\":2}"];
+    ATLMLocationPayload location;
+    expect([self.decoder getLocation:&location forMessagePart:part]).to.beFalsy();
+}
+
+- (void)testUnusualPayloadsFallBackToJSONSerialization
+{
+    // An escaped key and a string value are left to NSJSONSerialization.
+    LYRMessagePart *part = [ATLMFakeMessagePart partWithMIMEType:ATLMIMETypeLocation JSON:@"{\"l\\u0061t\":10,\"lon\":\"20\"}"];
+    ATLMLocationPayload location;
+    expect([self.decoder getLocation:&location forMessagePart:part]).to.beTruthy();
+    expect(location.latitude).to.equal(10);
+    expect(location.longitude).to.equal(20);
+}
+
+- (void)testMalformedPayloadIsRejected
+{
+    LYRMessagePart *part = [ATLMFakeMessagePart partWithMIMEType:ATLMIMETypeLocation JSON:@"{\"lat\":10,"];
+    ATLMLocationPayload location;
+    expect([self.decoder getLocation:&location forMessagePart:part]).to.beFalsy();
+    expect([self.decoder getLocation:&location forMessagePart:part]).to.beFalsy();
+    expect(self.decoder.countOfDecodes).to.equal(1);
+}
+
+- (void)testFlatParserSkipsOtherValues
+{
+    NSData *data = [@"{\"name\":\"a \\\"quoted\\\" name\",\"flag\":true,\"none\":null,\"lat\":-0.5}" dataUsingEncoding:NSUTF8StringEncoding];
+    const char *const keys[] = { "lat" };
+    double values[] = { 0 };
+    expect(ATLMParseFlatJSONNumbers(data, keys, values, 1)).to.beTruthy();
+    expect(values[0]).to.equal(-0.5);
+
+    NSData *nestedData = [@"{\"lat\":{\"value\":1}}" dataUsingEncoding:NSUTF8StringEncoding];
+    expect(ATLMParseFlatJSONNumbers(nestedData, keys, values, 1)).to.beFalsy();
+}
+
+- (void)testRegisteredDecoderIsUsed
+{
+    [self.decoder registerDecoderForMIMEType:ATLMIMETypeTextPlain block:^id(NSData *data) {
+        return [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding].uppercaseString;
+    }];
+    LYRMessagePart *part = [ATLMFakeMessagePart partWithMIMEType:ATLMIMETypeTextPlain JSON:@"hello"];
+    expect([self.decoder decodedValueForMessagePart:part]).to.equal(@"HELLO");
+}
+
+#pragma mark - Benchmark
+
+- (void)testDecodingBenchmark
+{
+    NSData *data = [@"{\"width\":3024,\"height\":4032,\"orientation\":0}" dataUsingEncoding:NSUTF8StringEncoding];
+    const char *const keys[] = { "width", "height", "orientation" };
+    double values[] = { 0, 0, 0 };
+
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger index = 0; index < ATLMDecodeBenchmarkIterations; index++) {
+        @autoreleasepool {
+            NSDictionary *dictionary = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+            values[0] = [dictionary[@"width"] doubleValue];
+        }
+    }
+    NSTimeInterval JSONSerializationDuration = CFAbsoluteTimeGetCurrent() - startTime;
+
+    startTime = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger index = 0; index < ATLMDecodeBenchmarkIterations; index++) {
+        ATLMParseFlatJSONNumbers(data, keys, values, 3);
+    }
+    NSTimeInterval flatParserDuration = CFAbsoluteTimeGetCurrent() - startTime;
+
+    LYRMessagePart *part = [ATLMFakeMessagePart partWithMIMEType:ATLMIMETypeImageSize JSON:@"{\"width\":3024,\"height\":4032,\"orientation\":0}"];
+    ATLMImageSizePayload imageSize;
+    startTime = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger index = 0; index < ATLMDecodeBenchmarkIterations; index++) {
+        [self.decoder getImageSize:&imageSize forMessagePart:part];
+    }
+    NSTimeInterval memoizedDuration = CFAbsoluteTimeGetCurrent() - startTime;
+
+    NSLog(@"Decoding an image size part: NSJSONSerialization %.0f ns, flat parser %.0f ns, memoized %.0f ns", JSONSerializationDuration * 1e9 / ATLMDecodeBenchmarkIterations, flatParserDuration * 1e9 / ATLMDecodeBenchmarkIterations, memoizedDuration * 1e9 / ATLMDecodeBenchmarkIterations);
+    expect(values[1]).to.equal(4032);
+    expect(imageSize.size).to.equal(CGSizeMake(3024, 4032));
+    expect(flatParserDuration).to.beLessThan(JSONSerializationDuration);
+}
+
+@end
@@ -0,0 +1,136 @@
+//
+//  ATLMMessagePartIndexTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import <LayerKit/LayerKit.h>
+#import "ATLMMessagePartIndex.h"
+#import "ATLMessagingUtilities.h"
+
+/**
+ @abstract Stands in for a synchronized message, which can't be created outside of a client.
+ */
+@interface ATLMIndexedFakeMessage : NSObject
+
+@property (nonatomic) NSURL *identifier;
+@property (nonatomic) NSArray *parts;
+
+@end
+
+@implementation ATLMIndexedFakeMessage
+
++ (LYRMessage *)messageWithMIMETypes:(NSArray *)MIMETypes
+{
+    ATLMIndexedFakeMessage *message = [self new];
+    message.identifier = [NSURL URLWithString:[NSString stringWithFormat:@"layer:///messages/%@", [NSUUID UUID].UUIDString]];
+    NSMutableArray *parts = [NSMutableArray new];
+    for (NSString *MIMEType in MIMETypes) {
+        // Copies, as strings coming from the client aren't Atlas' constants.
+        [parts addObject:[LYRMessagePart messagePartWithMIMEType:[MIMEType mutableCopy] data:[NSData data]]];
+    }
+    message.parts = parts;
+    return (LYRMessage *)message;
+}
+
+@end
+
+@interface ATLMMessagePartIndexTest : XCTestCase
+
+@end
+
+@implementation ATLMMessagePartIndexTest
+
+- (void)tearDown
+{
+    [ATLMMessagePartIndex removeAllIndexes];
+    [super tearDown];
+}
+
+- (void)testRaisesOnAttemptToInit
+{
+    expect(^{ [ATLMMessagePartIndex new]; }).to.raise(NSInternalInconsistencyException);
+}
+
+- (void)testPartsAreFoundByMIMEType
+{
+    LYRMessage *message = [ATLMIndexedFakeMessage messageWithMIMETypes:@[ ATLMIMETypeImageJPEG, ATLMIMETypeImageJPEGPreview, ATLMIMETypeImageSize, @"application/x-custom" ]];
+    ATLMMessagePartIndex *index = [ATLMMessagePartIndex indexForMessage:message];
+    expect(index.partCount).to.equal(4);
+    expect([index partForMIMEType:ATLMIMETypeImageJPEG]).to.beIdenticalTo(message.parts[0]);
+    expect([index partForMIMEType:ATLMIMETypeImageSize]).to.beIdenticalTo(message.parts[2]);
+    expect([index partForMIMEType:@"application/x-custom"]).to.beIdenticalTo(message.parts[3]);
+    expect([index containsMIMEType:ATLMIMETypeLocation]).to.beFalsy();
+}
+
+- (void)testFirstPartOfATypeWins
+{
+    LYRMessage *message = [ATLMIndexedFakeMessage messageWithMIMETypes:@[ ATLMIMETypeTextPlain, ATLMIMETypeTextPlain ]];
+    expect([[ATLMMessagePartIndex indexForMessage:message] partForMIMEType:ATLMIMETypeTextPlain]).to.beIdenticalTo(message.parts[0]);
+}
+
+- (void)testRenderableMediaPartPriority
+{
+    LYRMessage *video = [ATLMIndexedFakeMessage messageWithMIMETypes:@[ ATLMIMETypeImageJPEGPreview, ATLMIMETypeImageSize, ATLMIMETypeVideoMP4 ]];
+    expect([ATLMMessagePartIndex indexForMessage:video].renderableMediaPart).to.beIdenticalTo(video.parts[2]);
+
+    LYRMessage *GIF = [ATLMIndexedFakeMessage messageWithMIMETypes:@[ ATLMIMETypeImageJPEG, ATLMIMETypeImageGIF ]];
+    expect([ATLMMessagePartIndex indexForMessage:GIF].renderableMediaPart).to.beIdenticalTo(GIF.parts[1]);
+
+    LYRMessage *location = [ATLMIndexedFakeMessage messageWithMIMETypes:@[ ATLMIMETypeLocation ]];
+    expect([ATLMMessagePartIndex indexForMessage:location].renderableMediaPart).to.beNil();
+}
+
+- (void)testIndexIsCachedPerMessage
+{
+    LYRMessage *message = [ATLMIndexedFakeMessage messageWithMIMETypes:@[ ATLMIMETypeLocation ]];
+    expect([ATLMMessagePartIndex indexForMessage:message]).to.beIdenticalTo([ATLMMessagePartIndex indexForMessage:message]);
+}
+
+#pragma mark - Benchmark
+
+- (void)testLookupBenchmark
+{
+    static const NSUInteger iterations = 100000;
+    LYRMessage *message = [ATLMIndexedFakeMessage messageWithMIMETypes:@[ ATLMIMETypeImageJPEG, ATLMIMETypeImageJPEGPreview, ATLMIMETypeImageSize, ATLMIMETypeVideoMP4 ]];
+    NSArray *MIMETypes = @[ ATLMIMETypeImageGIF, ATLMIMETypeImagePNG, ATLMIMETypeVideoMP4, ATLMIMETypeImageJPEG, ATLMIMETypeLocation ];
+
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger iteration = 0; iteration < iterations; iteration++) {
+        for (NSString *MIMEType in MIMETypes) {
+            ATLMessagePartForMIMEType(message, MIMEType);
+        }
+    }
+    NSTimeInterval scanDuration = CFAbsoluteTimeGetCurrent() - startTime;
+
+    startTime = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger iteration = 0; iteration < iterations; iteration++) {
+        ATLMMessagePartIndex *index = [ATLMMessagePartIndex indexForMessage:message];
+        for (NSString *MIMEType in MIMETypes) {
+            [index partForMIMEType:MIMEType];
+        }
+    }
+    NSTimeInterval indexDuration = CFAbsoluteTimeGetCurrent() - startTime;
+
+    NSLog(@"Resolving %lu MIME types: linear scans %.0f ns, part index %.0f ns", (unsigned long)MIMETypes.count, scanDuration * 1e9 / iterations, indexDuration * 1e9 / iterations);
+    expect(indexDuration).to.beLessThan(scanDuration);
+}
+
+@end
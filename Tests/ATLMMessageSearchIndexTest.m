@@ -0,0 +1,371 @@
+//
+//  ATLMMessageSearchIndexTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import <QuartzCore/QuartzCore.h>
+#import "ATLMMessageSearchIndex.h"
+#import "ATLMSearchSegment.h"
+
+/**
+ @abstract The number of messages indexed by the benchmark, one million by default.
+ */
+static NSString *const ATLMSearchBenchmarkMessageCountVariable = @"ATLM_SEARCH_BENCHMARK_MESSAGE_COUNT";
+static const NSUInteger ATLMSearchBenchmarkDefaultMessageCount = 1000000;
+static const NSUInteger ATLMSearchBenchmarkVocabularySize = 50000;
+static const NSUInteger ATLMSearchBenchmarkConversationCount = 2000;
+static const NSUInteger ATLMSearchBenchmarkQueryCount = 200;
+
+@interface ATLMMessageSearchIndexTest : XCTestCase
+
+@property (nonatomic) NSString *directory;
+@property (nonatomic) ATLMMessageSearchIndex *index;
+
+@end
+
+@implementation ATLMMessageSearchIndexTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"MessageSearch-%@", [NSUUID UUID].UUIDString]];
+    self.index = [ATLMMessageSearchIndex indexWithDirectory:self.directory];
+}
+
+- (void)tearDown
+{
+    [self waitForBackgroundWork];
+    self.index = nil;
+    [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+    [super tearDown];
+}
+
+- (NSURL *)messageIdentifier:(NSUInteger)index
+{
+    return [NSURL URLWithString:[NSString stringWithFormat:@"layer:///messages/%lu", (unsigned long)index]];
+}
+
+- (NSURL *)conversationIdentifier:(NSUInteger)index
+{
+    return [NSURL URLWithString:[NSString stringWithFormat:@"layer:///conversations/%lu", (unsigned long)index]];
+}
+
+- (void)indexMessage:(NSUInteger)index conversation:(NSUInteger)conversation text:(NSString *)text
+{
+    [self.index indexMessageWithIdentifier:[self messageIdentifier:index] conversationIdentifier:[self conversationIdentifier:conversation] text:text date:[NSDate dateWithTimeIntervalSinceReferenceDate:index]];
+}
+
+- (NSArray *)messageIdentifiersForQuery:(NSString *)query
+{
+    return [[self.index messageHitsForQuery:query limit:100] valueForKey:@"messageIdentifier"];
+}
+
+- (void)waitForBackgroundWork
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Background work finished"];
+    [self.index waitForBackgroundWorkWithCompletion:^{
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:600 handler:nil];
+}
+
+- (void)mergeAllSegments
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Segments merged"];
+    [self.index mergeAllSegmentsWithCompletion:^{
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:600 handler:nil];
+}
+
+#pragma mark - Tokenizing
+
+- (void)testTokensAreNormalizedAndFolded
+{
+    expect(ATLMSearchTokensForText(@"Café CAFÉ ｃａｆｅ!")).to.equal(@[ @"cafe", @"cafe", @"cafe" ]);
+    expect(ATLMSearchTokensForText(@"Hello, -- world ...")).to.equal(@[ @"hello", @"world" ]);
+    expect(ATLMSearchTokensForText(@"  ")).to.equal(@[]);
+}
+
+#pragma mark - Querying
+
+- (void)testQueriesMatchEveryToken
+{
+    [self indexMessage:1 conversation:1 text:@"Lunch at noon tomorrow"];
+    [self indexMessage:2 conversation:1 text:@"Dinner tomorrow?"];
+    [self indexMessage:3 conversation:2 text:@"Lunch is canceled"];
+    expect([self messageIdentifiersForQuery:@"lunch tomorrow "]).to.equal(@[ [self messageIdentifier:1] ]);
+    expect([self messageIdentifiersForQuery:@"LUNCH "]).to.equal(@[ [self messageIdentifier:3], [self messageIdentifier:1] ]);
+    expect([self messageIdentifiersForQuery:@"breakfast"]).to.equal(@[]);
+}
+
+- (void)testLastTokenMatchesAsPrefixWhileTyping
+{
+    [self indexMessage:1 conversation:1 text:@"See you at the restaurant"];
+    [self indexMessage:2 conversation:1 text:@"Rest well"];
+    expect([self messageIdentifiersForQuery:@"resta"]).to.equal(@[ [self messageIdentifier:1] ]);
+    expect([self messageIdentifiersForQuery:@"rest"].count).to.equal(2);
+    expect([self messageIdentifiersForQuery:@"rest "]).to.equal(@[ [self messageIdentifier:2] ]);
+    expect([self messageIdentifiersForQuery:@"r"]).to.equal(@[]);
+}
+
+- (void)testRanksRareTermsAndShortMessagesHigher
+{
+    [self indexMessage:1 conversation:1 text:@"the meeting is about the budget and the plan and the rest of the quarter"];
+    [self indexMessage:2 conversation:1 text:@"budget approved"];
+    [self indexMessage:3 conversation:2 text:@"the the the"];
+    NSArray *hits = [self.index messageHitsForQuery:@"budget " limit:10];
+    expect([hits valueForKey:@"messageIdentifier"]).to.equal(@[ [self messageIdentifier:2], [self messageIdentifier:1] ]);
+    expect([hits[0] score]).to.beGreaterThan([hits[1] score]);
+}
+
+- (void)testConversationHitsGroupMessages
+{
+    [self indexMessage:1 conversation:1 text:@"ski trip in january"];
+    [self indexMessage:2 conversation:1 text:@"ski rental prices"];
+    [self indexMessage:3 conversation:2 text:@"ski"];
+    [self indexMessage:4 conversation:3 text:@"beach trip"];
+    NSArray *hits = [self.index conversationHitsForQuery:@"ski " limit:10];
+    NSArray *conversationIdentifiers = [hits valueForKey:@"conversationIdentifier"];
+    expect(conversationIdentifiers.count).to.equal(2);
+    expect(conversationIdentifiers).to.contain([self conversationIdentifier:1]);
+    expect(conversationIdentifiers).to.contain([self conversationIdentifier:2]);
+    ATLMConversationSearchHit *conversationHit = hits[[conversationIdentifiers indexOfObject:[self conversationIdentifier:1]]];
+    expect([conversationHit.messageHits valueForKey:@"messageIdentifier"]).to.contain([self messageIdentifier:2]);
+    expect(conversationHit.messageHits.count).to.equal(2);
+    expect([self.index conversationHitsForQuery:@"ski " limit:1].count).to.equal(1);
+}
+
+#pragma mark - Updating
+
+- (void)testRemovedMessagesAreNotReturned
+{
+    [self indexMessage:1 conversation:1 text:@"secret plan"];
+    [self indexMessage:2 conversation:2 text:@"secret recipe"];
+    [self.index flush];
+    [self waitForBackgroundWork];
+    [self indexMessage:3 conversation:2 text:@"secret handshake"];
+
+    [self.index removeMessageWithIdentifier:[self messageIdentifier:1]];
+    expect([self messageIdentifiersForQuery:@"secret "]).notTo.contain([self messageIdentifier:1]);
+    [self.index removeMessagesInConversationWithIdentifier:[self conversationIdentifier:2]];
+    expect([self messageIdentifiersForQuery:@"secret "]).to.equal(@[]);
+}
+
+- (void)testReindexedMessagesMatchTheirNewText
+{
+    [self indexMessage:1 conversation:1 text:@"original wording"];
+    [self.index flush];
+    [self waitForBackgroundWork];
+    [self.index removeMessageWithIdentifier:[self messageIdentifier:1]];
+    [self indexMessage:1 conversation:1 text:@"edited wording"];
+    expect([self messageIdentifiersForQuery:@"original "]).to.equal(@[]);
+    expect([self messageIdentifiersForQuery:@"wording "]).to.equal(@[ [self messageIdentifier:1] ]);
+
+    [self.index flush];
+    [self mergeAllSegments];
+    expect(self.index.countOfSegments).to.equal(1);
+    expect(self.index.countOfDocuments).to.equal(1);
+    expect([self messageIdentifiersForQuery:@"edited "]).to.equal(@[ [self messageIdentifier:1] ]);
+}
+
+- (void)testBuffersAreFlushedAndMergedInTheBackground
+{
+    self.index.flushThreshold = 10;
+    self.index.mergeFactor = 4;
+    for (NSUInteger index = 0; index < 100; index++) {
+        [self indexMessage:index conversation:index % 7 text:[NSString stringWithFormat:@"message number %lu %@", (unsigned long)index, index % 2 ? @"odd" : @"even"]];
+    }
+    [self waitForBackgroundWork];
+    expect(self.index.countOfSegments).to.beLessThan(10);
+    expect(self.index.countOfDocuments).to.equal(100);
+    expect([self.index messageHitsForQuery:@"odd " limit:1000].count).to.equal(50);
+    expect([self messageIdentifiersForQuery:@"number 42 "]).to.equal(@[ [self messageIdentifier:42] ]);
+
+    [self.index removeMessageWithIdentifier:[self messageIdentifier:43]];
+    [self mergeAllSegments];
+    expect(self.index.countOfSegments).to.equal(1);
+    expect(self.index.countOfDocuments).to.equal(99);
+    expect([self.index messageHitsForQuery:@"odd " limit:1000].count).to.equal(49);
+}
+
+- (void)testSegmentsAndTombstonesArePersisted
+{
+    [self indexMessage:1 conversation:1 text:@"persisted message"];
+    [self indexMessage:2 conversation:1 text:@"persisted too"];
+    [self.index flush];
+    [self waitForBackgroundWork];
+    [self.index removeMessageWithIdentifier:[self messageIdentifier:2]];
+    [[NSNotificationCenter defaultCenter] postNotificationName:UIApplicationDidEnterBackgroundNotification object:nil];
+    [self waitForBackgroundWork];
+
+    self.index = [ATLMMessageSearchIndex indexWithDirectory:self.directory];
+    expect(self.index.countOfSegments).to.equal(1);
+    expect([self messageIdentifiersForQuery:@"persisted "]).to.equal(@[ [self messageIdentifier:1] ]);
+}
+
+- (void)testRemovingAllDropsMessagesAndSegments
+{
+    [self indexMessage:1 conversation:1 text:@"private message"];
+    [self.index flush];
+    [self waitForBackgroundWork];
+    [self indexMessage:2 conversation:1 text:@"private note"];
+    [self.index flush];
+
+    // The second flush is still running and must not bring its segment back.
+    [self.index removeAll];
+    expect([self messageIdentifiersForQuery:@"private "]).to.equal(@[]);
+    [self waitForBackgroundWork];
+    expect(self.index.countOfSegments).to.equal(0);
+    expect([self messageIdentifiersForQuery:@"private "]).to.equal(@[]);
+
+    self.index = [ATLMMessageSearchIndex indexWithDirectory:self.directory];
+    expect(self.index.countOfDocuments).to.equal(0);
+    NSArray *segmentFileNames = [[[NSFileManager defaultManager] contentsOfDirectoryAtPath:self.directory error:nil] pathsMatchingExtensions:@[ @"atls" ]];
+    expect(segmentFileNames).to.haveCountOf(0);
+}
+
+#pragma mark - Segments
+
+- (void)testSegmentRoundTrip
+{
+    ATLMSearchSegmentBuilder *builder = [ATLMSearchSegmentBuilder builder];
+    uint32_t first = [builder addDocumentWithMessageIdentifier:@"m1" conversationIdentifier:@"c1" date:10 tokenCount:3];
+    uint32_t second = [builder addDocumentWithMessageIdentifier:@"m2" conversationIdentifier:@"c1" date:20 tokenCount:5];
+    for (NSString *term in @[ @"apple", @"apricot", @"banana" ]) {
+        [builder beginTermWithBytes:term.UTF8String length:strlen(term.UTF8String)];
+        [builder addPosting:(ATLMSearchPosting){ first, 1 }];
+        if (![term isEqualToString:@"banana"]) {
+            [builder addPosting:(ATLMSearchPosting){ second, 2 }];
+        }
+        [builder endTerm];
+    }
+    NSString *path = [self.directory stringByAppendingPathComponent:@"test.atls"];
+    expect([[builder dataWithGeneration:7] writeToFile:path atomically:YES]).to.beTruthy();
+
+    NSError *error;
+    ATLMSearchSegment *segment = [ATLMSearchSegment segmentWithContentsOfFile:path error:&error];
+    expect(error).to.beNil();
+    expect(segment.generation).to.equal(7);
+    expect(segment.documentCount).to.equal(2);
+    expect(segment.termCount).to.equal(3);
+    expect([segment messageIdentifierOfDocument:second]).to.equal(@"m2");
+    expect([segment conversationIdentifierOfDocument:second]).to.equal(@"c1");
+    expect([segment dateOfDocument:second]).to.equal(20);
+    expect([segment tokenCountOfDocument:second]).to.equal(5);
+
+    NSData *postings = [segment postingsForTermBytes:"ap" length:2 prefix:YES];
+    const ATLMSearchPosting *values = postings.bytes;
+    expect(postings.length).to.equal(2 * sizeof(ATLMSearchPosting));
+    expect(values[0].frequency).to.equal(2);
+    expect(values[1].frequency).to.equal(4);
+    expect([segment postingsForTermBytes:"ap" length:2 prefix:NO].length).to.equal(0);
+    expect([segment postingsForTermBytes:"banana" length:6 prefix:NO].length).to.equal(sizeof(ATLMSearchPosting));
+}
+
+- (void)testMalformedSegmentsAreRejected
+{
+    NSString *path = [self.directory stringByAppendingPathComponent:@"malformed.atls"];
+    [[@"not a segment" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:path atomically:YES];
+    NSError *error;
+    expect([ATLMSearchSegment segmentWithContentsOfFile:path error:&error]).to.beNil();
+    expect(error).notTo.beNil();
+}
+
+#pragma mark - Benchmark
+
+/**
+ @abstract Indexes synthetic messages drawn from a Zipf-distributed vocabulary,
+   merges them into a single segment and runs two-token queries, logging the
+   indexing throughput, the index size per message and the query latencies.
+ */
+- (void)testBenchmarkIndexingAndQuerying
+{
+    NSUInteger messageCount = [[NSProcessInfo processInfo].environment[ATLMSearchBenchmarkMessageCountVariable] integerValue] ?: ATLMSearchBenchmarkDefaultMessageCount;
+    NSMutableArray *vocabulary = [NSMutableArray arrayWithCapacity:ATLMSearchBenchmarkVocabularySize];
+    double *cumulativeWeights = malloc(ATLMSearchBenchmarkVocabularySize * sizeof(double));
+    double totalWeight = 0;
+    srand48(41);
+    for (NSUInteger rank = 0; rank < ATLMSearchBenchmarkVocabularySize; rank++) {
+        NSUInteger length = 3 + (NSUInteger)(drand48() * 7);
+        NSMutableString *word = [NSMutableString stringWithCapacity:length];
+        for (NSUInteger index = 0; index < length; index++) {
+            [word appendFormat:@"%c", 'a' + (char)(drand48() * 26)];
+        }
+        [vocabulary addObject:word];
+        totalWeight += 1.0 / (rank + 1);
+        cumulativeWeights[rank] = totalWeight;
+    }
+    NSUInteger (^randomRank)(void) = ^NSUInteger {
+        double target = drand48() * totalWeight;
+        NSUInteger low = 0, high = ATLMSearchBenchmarkVocabularySize - 1;
+        while (low < high) {
+            NSUInteger middle = (low + high) / 2;
+            if (cumulativeWeights[middle] < target) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    };
+
+    CFTimeInterval start = CACurrentMediaTime();
+    for (NSUInteger index = 0; index < messageCount; index++) {
+        @autoreleasepool {
+            NSUInteger wordCount = 4 + (NSUInteger)(drand48() * 12);
+            NSMutableArray *words = [NSMutableArray arrayWithCapacity:wordCount];
+            for (NSUInteger word = 0; word < wordCount; word++) {
+                [words addObject:vocabulary[randomRank()]];
+            }
+            [self indexMessage:index conversation:index % ATLMSearchBenchmarkConversationCount text:[words componentsJoinedByString:@" "]];
+        }
+    }
+    [self mergeAllSegments];
+    CFTimeInterval indexingDuration = CACurrentMediaTime() - start;
+
+    NSMutableArray *latencies = [NSMutableArray arrayWithCapacity:ATLMSearchBenchmarkQueryCount];
+    NSUInteger hitCount = 0;
+    for (NSUInteger query = 0; query < ATLMSearchBenchmarkQueryCount; query++) {
+        @autoreleasepool {
+            // Mixes frequent and rare terms, with the last one typed halfway.
+            NSString *first = vocabulary[(NSUInteger)(drand48() * 100)];
+            NSString *second = vocabulary[randomRank()];
+            NSString *text = [NSString stringWithFormat:@"%@ %@", first, [second substringToIndex:MAX(2, second.length / 2 + 1)]];
+            CFTimeInterval queryStart = CACurrentMediaTime();
+            hitCount += [self.index conversationHitsForQuery:text limit:20].count;
+            [latencies addObject:@(CACurrentMediaTime() - queryStart)];
+        }
+    }
+    free(cumulativeWeights);
+    [latencies sortUsingSelector:@selector(compare:)];
+    double p50 = [latencies[latencies.count / 2] doubleValue];
+    double p99 = [latencies[MIN(latencies.count - 1, latencies.count * 99 / 100)] doubleValue];
+
+    NSLog(@"Indexed %lu messages in %.1fs (%.0f messages/s) into %lu bytes (%.1f bytes/message); %lu queries returned %lu conversations, p50 %.2fms, p99 %.2fms",
+          (unsigned long)messageCount, indexingDuration, messageCount / indexingDuration,
+          (unsigned long)self.index.byteCount, (double)self.index.byteCount / messageCount,
+          (unsigned long)ATLMSearchBenchmarkQueryCount, (unsigned long)hitCount, p50 * 1000, p99 * 1000);
+    expect(self.index.countOfDocuments).to.equal(messageCount);
+    expect(self.index.countOfSegments).to.equal(1);
+}
+
+@end
@@ -0,0 +1,89 @@
+//
+//  ATLMNavigationControllerTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMNavigationController.h"
+#import "ATLMUIWorkScheduler.h"
+
+@interface ATLMNavigationControllerTest : XCTestCase
+
+@property (nonatomic) UIWindow *window;
+@property (nonatomic) ATLMNavigationController *navigationController;
+
+@end
+
+@implementation ATLMNavigationControllerTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.navigationController = [[ATLMNavigationController alloc] initWithRootViewController:[UIViewController new]];
+    self.window = [[UIWindow alloc] initWithFrame:[UIScreen mainScreen].bounds];
+    self.window.rootViewController = self.navigationController;
+    [self.window makeKeyAndVisible];
+}
+
+- (void)tearDown
+{
+    self.window.hidden = YES;
+    self.window = nil;
+    self.navigationController = nil;
+    [super tearDown];
+}
+
+- (void)testDeferredWorkWaitsForThePushTransition
+{
+    UIViewController *viewController = [UIViewController new];
+    [self.navigationController pushViewController:viewController animated:YES];
+    expect(self.navigationController.isAnimating).to.beTruthy();
+    expect([ATLMUIWorkScheduler sharedScheduler].isDeferring).to.beTruthy();
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"deferred work ran"];
+    __block BOOL ranDuringTransition = YES;
+    __weak ATLMNavigationController *navigationController = self.navigationController;
+    [[ATLMUIWorkScheduler sharedScheduler] scheduleWorkWithPriority:ATLMUIWorkPriorityDefault coalescingKey:nil block:^{
+        ranDuringTransition = navigationController.isAnimating || navigationController.topViewController != viewController;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    expect(ranDuringTransition).to.beFalsy();
+    expect([ATLMUIWorkScheduler sharedScheduler].isDeferring).to.beFalsy();
+}
+
+- (void)testCompletionHandlersRunOnceThePushHasFinished
+{
+    UIViewController *viewController = [UIViewController new];
+    [self.navigationController pushViewController:viewController animated:YES];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"handler ran"];
+    __block BOOL ranDuringTransition = YES;
+    __weak ATLMNavigationController *navigationController = self.navigationController;
+    [self.navigationController notifyWhenCompletionEndsUsingBlock:^{
+        ranDuringTransition = navigationController.isAnimating;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    expect(ranDuringTransition).to.beFalsy();
+    expect(viewController.ATLM_navigationController).to.equal(self.navigationController);
+}
+
+@end
@@ -0,0 +1,389 @@
+//
+//  ATLMOutboxTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMOutbox.h"
+
+@interface ATLMOutbox (Test)
+
+- (void)synchronizeJournal;
+
+@end
+
+/**
+ @abstract Stands in for the layer client: records what it was sent, refuses
+   everything while `offline`, holds everything back while `signedOut` and
+   drops the connection every `dropInterval` sends, reconnecting shortly after.
+ */
+@interface ATLMFakeOutboxClient : NSObject <ATLMOutboxTransport>
+
+@property (nonatomic, weak) ATLMOutbox *outbox;
+@property (nonatomic) NSMutableDictionary *sentSequencesByConversation;
+@property (nonatomic) NSMutableSet *failingConversationIdentifiers;
+@property (nonatomic, getter=isOffline) BOOL offline;
+@property (nonatomic, getter=isSignedOut) BOOL signedOut;
+@property (nonatomic) NSUInteger dropInterval;
+@property (nonatomic) NSUInteger countOfSends;
+@property (nonatomic) NSUInteger countOfDrops;
+@property (nonatomic) NSUInteger expectedSendCount;
+@property (nonatomic) XCTestExpectation *expectation;
+@property (nonatomic) NSMutableArray *discardedEntries;
+
+@end
+
+@implementation ATLMFakeOutboxClient
+
+- (id)init
+{
+    self = [super init];
+    if (self) {
+        _sentSequencesByConversation = [NSMutableDictionary new];
+        _failingConversationIdentifiers = [NSMutableSet new];
+        _discardedEntries = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (BOOL)outbox:(ATLMOutbox *)outbox sendEntry:(ATLMOutboxEntry *)entry error:(NSError **)error
+{
+    if (self.isOffline || [self.failingConversationIdentifiers containsObject:entry.conversationIdentifier]) {
+        if (error) {
+            *error = [NSError errorWithDomain:@"ATLMFakeOutboxClient" code:1 userInfo:nil];
+        }
+        return NO;
+    }
+    if (self.dropInterval && self.countOfSends > 0 && self.countOfSends % self.dropInterval == 0 && outbox.isConnected) {
+        // The connection goes away mid batch and comes back a moment later.
+        self.countOfSends += 1;
+        self.countOfDrops += 1;
+        outbox.connected = NO;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.01 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+            outbox.connected = YES;
+        });
+        if (error) {
+            *error = [NSError errorWithDomain:@"ATLMFakeOutboxClient" code:2 userInfo:nil];
+        }
+        return NO;
+    }
+    self.countOfSends += 1;
+    NSString *payload = [[NSString alloc] initWithData:entry.partData.firstObject encoding:NSUTF8StringEncoding];
+    NSMutableArray *sequences = self.sentSequencesByConversation[entry.conversationIdentifier];
+    if (!sequences) {
+        sequences = [NSMutableArray new];
+        self.sentSequencesByConversation[entry.conversationIdentifier] = sequences;
+    }
+    [sequences addObject:@(payload.integerValue)];
+    if (self.expectedSendCount && [self countOfSentEntries] == self.expectedSendCount) {
+        [self.expectation fulfill];
+    }
+    return YES;
+}
+
+- (void)outbox:(ATLMOutbox *)outbox didDiscardEntry:(ATLMOutboxEntry *)entry error:(NSError *)error
+{
+    [self.discardedEntries addObject:entry];
+}
+
+- (BOOL)outboxCanSendEntries:(ATLMOutbox *)outbox
+{
+    return !self.isSignedOut;
+}
+
+- (NSUInteger)countOfSentEntries
+{
+    NSUInteger count = 0;
+    for (NSArray *sequences in self.sentSequencesByConversation.allValues) {
+        count += sequences.count;
+    }
+    return count;
+}
+
+@end
+
+@interface ATLMOutboxTest : XCTestCase
+
+@property (nonatomic) NSString *journalPath;
+@property (nonatomic) ATLMFakeOutboxClient *client;
+
+@end
+
+@implementation ATLMOutboxTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.journalPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    self.client = [ATLMFakeOutboxClient new];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:self.journalPath error:nil];
+    [[NSFileManager defaultManager] removeItemAtPath:[self.journalPath stringByAppendingString:@"-parts"] error:nil];
+    [super tearDown];
+}
+
+- (ATLMOutbox *)outbox
+{
+    ATLMOutbox *outbox = [ATLMOutbox outboxWithJournalPath:self.journalPath transport:self.client];
+    outbox.initialRetryInterval = 0.001;
+    outbox.maximumRetryInterval = 0.01;
+    self.client.outbox = outbox;
+    return outbox;
+}
+
+- (NSString *)enqueueSequence:(NSUInteger)sequence conversation:(NSUInteger)conversation outbox:(ATLMOutbox *)outbox
+{
+    NSData *data = [[NSString stringWithFormat:@"%lu", (unsigned long)sequence] dataUsingEncoding:NSUTF8StringEncoding];
+    NSURL *conversationIdentifier = [NSURL URLWithString:[NSString stringWithFormat:@"layer:///conversations/%lu", (unsigned long)conversation]];
+    return [outbox enqueueMessageWithMIMETypes:@[ @"text/plain" ] partData:@[ data ] pushText:nil conversationIdentifier:conversationIdentifier];
+}
+
+- (void)waitForMainQueue
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"main queue drained"];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.1 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [expectation fulfill];
+    });
+    [self waitForExpectationsWithTimeout:2.0 handler:nil];
+}
+
+- (void)testRaisesOnAttemptToInit
+{
+    expect(^{ [ATLMOutbox new]; }).to.raise(NSInternalInconsistencyException);
+}
+
+- (void)testMessagesAreHandedToTheClientRightAway
+{
+    ATLMOutbox *outbox = [self outbox];
+    NSString *identifier = [self enqueueSequence:0 conversation:0 outbox:outbox];
+    expect([outbox containsEntryWithIdentifier:identifier]).to.beFalsy();
+    expect(self.client.countOfSentEntries).to.equal(1);
+    expect(outbox.countOfSentEntries).to.equal(1);
+
+    // Messages the client took are never journaled.
+    [outbox synchronizeJournal];
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:self.journalPath error:nil];
+    expect(attributes.fileSize).to.equal(0);
+}
+
+- (void)testPendingEntriesSurviveRestart
+{
+    ATLMOutbox *outbox = [self outbox];
+    self.client.offline = YES;
+    for (NSUInteger sequence = 0; sequence < 3; sequence++) {
+        [self enqueueSequence:sequence conversation:0 outbox:outbox];
+    }
+    outbox = nil;
+
+    self.client.offline = NO;
+    ATLMOutbox *restoredOutbox = [self outbox];
+    expect(restoredOutbox.countOfPendingEntries).to.equal(3);
+    restoredOutbox.connected = YES;
+    [self waitForMainQueue];
+    NSURL *conversationIdentifier = [NSURL URLWithString:@"layer:///conversations/0"];
+    expect(self.client.sentSequencesByConversation[conversationIdentifier]).to.equal(@[ @0, @1, @2 ]);
+    expect([self outbox].countOfPendingEntries).to.equal(0);
+}
+
+- (void)testPartContentsAreKeptOutOfTheJournal
+{
+    ATLMOutbox *outbox = [self outbox];
+    self.client.offline = YES;
+    NSMutableData *video = [NSMutableData dataWithLength:1024 * 1024];
+    NSURL *conversationIdentifier = [NSURL URLWithString:@"layer:///conversations/0"];
+    [outbox enqueueMessageWithMIMETypes:@[ @"video/mp4" ] partData:@[ video ] pushText:nil conversationIdentifier:conversationIdentifier];
+    [outbox synchronizeJournal];
+    outbox = nil;
+
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:self.journalPath error:nil];
+    expect(attributes.fileSize).to.beLessThan(1024);
+    NSArray *partFileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:[self.journalPath stringByAppendingString:@"-parts"] error:nil];
+    expect(partFileNames).to.haveCountOf(1);
+
+    // The restored entry reads its part back from the file.
+    ATLMOutbox *restoredOutbox = [self outbox];
+    self.client.offline = NO;
+    restoredOutbox.connected = YES;
+    [self waitForMainQueue];
+    expect(restoredOutbox.countOfSentEntries).to.equal(1);
+    [restoredOutbox synchronizeJournal];
+    partFileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:[self.journalPath stringByAppendingString:@"-parts"] error:nil];
+    expect(partFileNames).to.haveCountOf(0);
+}
+
+- (void)testRemovingAllEntriesClearsTheJournal
+{
+    ATLMOutbox *outbox = [self outbox];
+    self.client.offline = YES;
+    [self enqueueSequence:0 conversation:0 outbox:outbox];
+    [self enqueueSequence:1 conversation:1 outbox:outbox];
+    [outbox removeAllEntries];
+    expect(outbox.countOfPendingEntries).to.equal(0);
+    [outbox synchronizeJournal];
+    outbox = nil;
+
+    expect([self outbox].countOfPendingEntries).to.equal(0);
+    NSArray *partFileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:[self.journalPath stringByAppendingString:@"-parts"] error:nil];
+    expect(partFileNames).to.haveCountOf(0);
+}
+
+- (void)testTornJournalTailIsIgnored
+{
+    ATLMOutbox *outbox = [self outbox];
+    self.client.offline = YES;
+    [self enqueueSequence:0 conversation:0 outbox:outbox];
+    [outbox synchronizeJournal];
+    outbox = nil;
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:self.journalPath];
+    [fileHandle seekToEndOfFile];
+    uint8_t tornRecord[] = { 0x00, 0x00, 0x10, 0x00, 0x62, 0x70 };
+    [fileHandle writeData:[NSData dataWithBytes:tornRecord length:sizeof(tornRecord)]];
+    [fileHandle closeFile];
+
+    expect([self outbox].countOfPendingEntries).to.equal(1);
+}
+
+- (void)testFailingConversationDoesNotHoldBackOthers
+{
+    ATLMOutbox *outbox = [self outbox];
+    outbox.maximumAttemptCount = 1000;
+    NSURL *failingConversation = [NSURL URLWithString:@"layer:///conversations/0"];
+    [self.client.failingConversationIdentifiers addObject:failingConversation];
+    [self enqueueSequence:0 conversation:0 outbox:outbox];
+    [self enqueueSequence:1 conversation:0 outbox:outbox];
+    [self enqueueSequence:2 conversation:1 outbox:outbox];
+    [self waitForMainQueue];
+    expect(self.client.sentSequencesByConversation[failingConversation]).to.beNil();
+    expect(outbox.countOfSentEntries).to.equal(1);
+
+    // Once the conversation recovers its messages go out in order.
+    [self.client.failingConversationIdentifiers removeAllObjects];
+    [self waitForMainQueue];
+    expect(self.client.sentSequencesByConversation[failingConversation]).to.equal(@[ @0, @1 ]);
+    expect(outbox.countOfFailedAttempts).to.beGreaterThan(0);
+}
+
+- (void)testEntryIsDiscardedAfterMaximumAttempts
+{
+    ATLMOutbox *outbox = [self outbox];
+    outbox.maximumAttemptCount = 3;
+    [self.client.failingConversationIdentifiers addObject:[NSURL URLWithString:@"layer:///conversations/0"]];
+    [self enqueueSequence:0 conversation:0 outbox:outbox];
+    [self waitForMainQueue];
+    expect(outbox.countOfPendingEntries).to.equal(0);
+    expect(outbox.countOfDiscardedEntries).to.equal(1);
+    expect(outbox.countOfFailedAttempts).to.equal(3);
+    expect(self.client.discardedEntries).to.haveCountOf(1);
+}
+
+- (void)testAttemptsAreNotCountedWhileSignedOut
+{
+    ATLMOutbox *outbox = [self outbox];
+    outbox.maximumAttemptCount = 3;
+    self.client.signedOut = YES;
+    [self enqueueSequence:0 conversation:0 outbox:outbox];
+    [outbox flush];
+    [self waitForMainQueue];
+    expect(outbox.countOfPendingEntries).to.equal(1);
+    expect(outbox.countOfFailedAttempts).to.equal(0);
+
+    self.client.signedOut = NO;
+    [outbox flush];
+    [self waitForMainQueue];
+    expect(outbox.countOfPendingEntries).to.equal(0);
+    expect(self.client.countOfSentEntries).to.equal(1);
+}
+
+- (void)testStreamPartsAreCopiedBeforeSending
+{
+    ATLMOutbox *outbox = [self outbox];
+    NSURL *conversationIdentifier = [NSURL URLWithString:@"layer:///conversations/0"];
+    NSInputStream *partStream = [NSInputStream inputStreamWithData:[@"0" dataUsingEncoding:NSUTF8StringEncoding]];
+    [outbox enqueueMessageWithMIMETypes:@[ @"text/plain" ] partStreams:@[ partStream ] pushText:nil conversationIdentifier:conversationIdentifier];
+    // Queued behind the stream backed message until its part is copied.
+    [self enqueueSequence:1 conversation:0 outbox:outbox];
+    expect(self.client.countOfSentEntries).to.equal(0);
+
+    [self waitForMainQueue];
+    expect(self.client.sentSequencesByConversation[conversationIdentifier]).to.equal(@[ @0, @1 ]);
+    [outbox synchronizeJournal];
+    NSArray *partFileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:[self.journalPath stringByAppendingString:@"-parts"] error:nil];
+    expect(partFileNames).to.haveCountOf(0);
+}
+
+- (void)testUnreadableStreamPartDiscardsTheEntry
+{
+    ATLMOutbox *outbox = [self outbox];
+    NSURL *conversationIdentifier = [NSURL URLWithString:@"layer:///conversations/0"];
+    NSInputStream *partStream = [NSInputStream inputStreamWithFileAtPath:[self.journalPath stringByAppendingString:@"-missing"]];
+    [outbox enqueueMessageWithMIMETypes:@[ @"video/mp4" ] partStreams:@[ partStream ] pushText:nil conversationIdentifier:conversationIdentifier];
+    [self enqueueSequence:1 conversation:0 outbox:outbox];
+    [self waitForMainQueue];
+    expect(self.client.discardedEntries).to.haveCountOf(1);
+    expect(self.client.sentSequencesByConversation[conversationIdentifier]).to.equal(@[ @1 ]);
+    expect(outbox.countOfPendingEntries).to.equal(0);
+}
+
+#pragma mark - Stress
+
+- (void)testTenThousandQueuedSendsThroughDroppingConnection
+{
+    static const NSUInteger entryCount = 10000;
+    static const NSUInteger conversationCount = 50;
+    ATLMOutbox *outbox = [self outbox];
+    outbox.maximumAttemptCount = 100;
+    self.client.offline = YES;
+    for (NSUInteger sequence = 0; sequence < entryCount; sequence++) {
+        [self enqueueSequence:sequence conversation:sequence % conversationCount outbox:outbox];
+    }
+    expect(outbox.countOfPendingEntries).to.equal(entryCount);
+    expect(outbox.maximumCountOfPendingEntries).to.equal(entryCount);
+
+    self.client.offline = NO;
+    self.client.dropInterval = 997;
+    self.client.expectedSendCount = entryCount;
+    self.client.expectation = [self expectationWithDescription:@"all entries sent"];
+    outbox.connected = YES;
+    [self waitForExpectationsWithTimeout:60.0 handler:nil];
+
+    NSLog(@"Sent %lu entries through %lu connection drops at %.0f entries/s", (unsigned long)outbox.countOfSentEntries, (unsigned long)self.client.countOfDrops, outbox.throughput);
+    expect(self.client.countOfDrops).to.beGreaterThan(5);
+    expect(outbox.countOfPendingEntries).to.equal(0);
+    expect(outbox.countOfDiscardedEntries).to.equal(0);
+    expect(outbox.countOfSentEntries).to.equal(entryCount);
+
+    // Every message arrived exactly once and in order within its conversation.
+    for (NSArray *sequences in self.client.sentSequencesByConversation.allValues) {
+        expect(sequences).to.haveCountOf(entryCount / conversationCount);
+        for (NSUInteger index = 1; index < sequences.count; index++) {
+            expect([sequences[index] unsignedIntegerValue]).to.equal([sequences[index - 1] unsignedIntegerValue] + conversationCount);
+        }
+    }
+
+    // Let the last batch finish before checking the journal.
+    [self waitForMainQueue];
+    expect(outbox.throughput).to.beGreaterThan(0);
+    expect([self outbox].countOfPendingEntries).to.equal(0);
+}
+
+@end
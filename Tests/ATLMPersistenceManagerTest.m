@@ -22,6 +22,7 @@
 #define EXP_SHORTHAND
 #import <Expecta/Expecta.h>
 #import "ATLMPersistenceManager.h"
+#import "ATLMErrors.h"
 
 @interface ATLMPersistenceManagerTest : XCTestCase
 
@@ -42,6 +43,35 @@
 
 @implementation ATLMInMemoryPersistenceManagerTest
 
+- (void)testSessionPersistence
+{
+    ATLMPersistenceManager *manager = [ATLMPersistenceManager inMemoryPersistenceManager];
+    ATLMUser *user = [ATLMUser new];
+    user.userID = [[NSUUID UUID] UUIDString];
+    user.firstName = @"Layer";
+    user.password = @"password";
+    NSError *error = nil;
+    BOOL success = [manager persistSession:[ATLMSession sessionWithAuthenticationToken:@"12345" user:user] error:&error];
+    expect(success).to.beTruthy();
+    expect(error).to.beNil();
+
+    ATLMSession *loadedSession = [manager persistedSessionWithError:&error];
+    expect(loadedSession.user).to.equal(user);
+    expect(loadedSession.user.firstName).to.equal(@"Layer");
+    expect(loadedSession.user.password).to.beNil();
+    expect(manager.countOfFlushedBatches).to.equal(0);
+}
+
+- (void)testPersistingNilSessionRemovesIt
+{
+    ATLMPersistenceManager *manager = [ATLMPersistenceManager inMemoryPersistenceManager];
+    ATLMUser *user = [ATLMUser new];
+    user.userID = @"12345";
+    [manager persistSession:[ATLMSession sessionWithAuthenticationToken:@"12345" user:user] error:nil];
+    expect([manager persistSession:nil error:nil]).to.beTruthy();
+    expect([manager persistedSessionWithError:nil]).to.beNil();
+}
+
 @end
 
 @interface ATLMOnDiskPersistenceManagerTest : XCTestCase
@@ -112,6 +142,44 @@
     expect(error).to.beNil();
 }
 
+- (void)testWritesAreBatchedBehindTheCaller
+{
+    NSString *directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    ATLMPersistenceManager *manager = [ATLMPersistenceManager persistenceManagerWithDirectory:directory];
+    ATLMUser *user = [ATLMUser new];
+    user.userID = @"12345";
+    [manager persistSession:[ATLMSession sessionWithAuthenticationToken:@"12345" user:user] error:nil];
+    [manager persistUsers:[NSSet setWithObject:user] error:nil];
+    // Served from the pending writes.
+    expect([manager persistedSessionWithError:nil].authenticationToken).to.equal(@"12345");
+
+    [manager flush];
+    expect(manager.countOfFlushedBatches).to.equal(1);
+    NSArray *fileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:directory error:nil];
+    expect(fileNames.count).to.equal(2);
+    expect([fileNames filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"pathExtension == 'tmp'"]]).to.beEmpty();
+
+    ATLMPersistenceManager *reopenedManager = [ATLMPersistenceManager persistenceManagerWithDirectory:directory];
+    expect([reopenedManager persistedSessionWithError:nil].user).to.equal(user);
+    expect([reopenedManager persistedUsersWithError:nil]).to.equal([NSSet setWithObject:user]);
+
+    [reopenedManager deleteAllObjects:nil];
+    [reopenedManager flush];
+    expect([[NSFileManager defaultManager] contentsOfDirectoryAtPath:directory error:nil]).to.beEmpty();
+    [[NSFileManager defaultManager] removeItemAtPath:directory error:nil];
+}
+
+- (void)testCorruptArchiveFailsWithError
+{
+    NSString *directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    ATLMPersistenceManager *manager = [ATLMPersistenceManager persistenceManagerWithDirectory:directory];
+    [[@"corrupt" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:[directory stringByAppendingPathComponent:@"Session.plist"] atomically:YES];
+    NSError *error = nil;
+    expect([manager persistedSessionWithError:&error]).to.beNil();
+    expect(error.code).to.equal(ATLMPersistenceDecodingFailed);
+    [[NSFileManager defaultManager] removeItemAtPath:directory error:nil];
+}
+
 - (void)testRemovingAllObjects
 {
     ATLMPersistenceManager *manager = [ATLMPersistenceManager defaultManager];
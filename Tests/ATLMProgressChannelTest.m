@@ -0,0 +1,134 @@
+//
+//  ATLMProgressChannelTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import <QuartzCore/QuartzCore.h>
+#import "ATLMProgressChannel.h"
+
+static const NSUInteger ATLMTransferCount = 20;
+static const NSUInteger ATLMTicksPerTransfer = 500;
+
+// Generous for displays refreshing faster than 60 Hz.
+static const double ATLMMaximumFramesPerSecond = 120;
+
+@interface ATLMProgressChannelTest : XCTestCase
+
+@property (nonatomic) ATLMProgressChannel *channel;
+
+@end
+
+@implementation ATLMProgressChannelTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.channel = [ATLMProgressChannel channel];
+}
+
+- (void)tearDown
+{
+    self.channel = nil;
+    [super tearDown];
+}
+
+- (void)testUpdatesAreCoalescedToTheLatestFraction
+{
+    NSMutableArray *fractions = [NSMutableArray new];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Progress delivered"];
+    ATLMProgressSlot *slot = [self.channel slotWithHandler:^(double fractionCompleted, BOOL finished) {
+        [fractions addObject:@(fractionCompleted)];
+        [expectation fulfill];
+    }];
+    dispatch_sync(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        [slot updateFractionCompleted:0.1];
+        [slot updateFractionCompleted:0.5];
+        [slot updateFractionCompleted:0.7];
+    });
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    expect(fractions).to.equal(@[ @0.7 ]);
+    expect(self.channel.countOfActiveSlots).to.equal(1);
+    [self.channel removeSlot:slot];
+    expect(self.channel.countOfActiveSlots).to.equal(0);
+}
+
+- (void)testFinishedSlotsAreDeliveredOnceAndRemoved
+{
+    __block NSUInteger finishedCount = 0;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Transfer finished"];
+    ATLMProgressSlot *slot = [self.channel slotWithHandler:^(double fractionCompleted, BOOL finished) {
+        if (finished) {
+            finishedCount += 1;
+            [expectation fulfill];
+        }
+    }];
+    [slot updateFractionCompleted:1];
+    [slot finish];
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+    [slot finish];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    expect(finishedCount).to.equal(1);
+    expect(self.channel.countOfActiveSlots).to.equal(0);
+}
+
+/**
+ @abstract Runs 20 downloads ticking every millisecond on background queues
+   and checks the main thread only does work once per frame, instead of once
+   per tick as with a hop to the main queue for every callback.
+ */
+- (void)testConcurrentTransfersAreBoundedByTheFrameRate
+{
+    NSMutableArray *slots = [NSMutableArray new];
+    __block NSUInteger finishedCount = 0;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Transfers finished"];
+    for (NSUInteger index = 0; index < ATLMTransferCount; index++) {
+        [slots addObject:[self.channel slotWithHandler:^(double fractionCompleted, BOOL finished) {
+            if (finished && ++finishedCount == ATLMTransferCount) {
+                [expectation fulfill];
+            }
+        }]];
+    }
+
+    CFTimeInterval start = CACurrentMediaTime();
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    for (ATLMProgressSlot *slot in slots) {
+        dispatch_async(queue, ^{
+            for (NSUInteger tick = 1; tick <= ATLMTicksPerTransfer; tick++) {
+                [slot updateFractionCompleted:(double)tick / ATLMTicksPerTransfer];
+                usleep(1000);
+            }
+            [slot finish];
+        });
+    }
+    [self waitForExpectationsWithTimeout:30 handler:nil];
+    CFTimeInterval elapsed = CACurrentMediaTime() - start;
+
+    NSUInteger tickCount = ATLMTransferCount * ATLMTicksPerTransfer;
+    NSLog(@"%lu progress ticks in %.2fs: %lu frames sampled, %lu handler calls", (unsigned long)tickCount, elapsed,
+          (unsigned long)self.channel.countOfFrames, (unsigned long)self.channel.countOfDeliveries);
+
+    expect(self.channel.countOfFrames).to.beLessThanOrEqualTo((NSUInteger)ceil(elapsed * ATLMMaximumFramesPerSecond) + 1);
+    expect(self.channel.countOfDeliveries).to.beLessThanOrEqualTo(self.channel.countOfFrames * ATLMTransferCount);
+    expect(self.channel.countOfDeliveries).to.beLessThan(tickCount / 4);
+    expect(self.channel.countOfActiveSlots).to.equal(0);
+}
+
+@end
@@ -0,0 +1,236 @@
+//
+//  ATLMRemoteNotificationCoalescerTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMRemoteNotificationCoalescer.h"
+#import "ATLMErrors.h"
+
+static NSDictionary *ATLMTestRemoteNotification(NSUInteger conversationIndex, NSUInteger messageIndex)
+{
+    NSString *conversationIdentifier = [NSString stringWithFormat:@"layer:///conversations/%lu", (unsigned long)conversationIndex];
+    NSString *messageIdentifier = [NSString stringWithFormat:@"layer:///messages/%lu-%lu", (unsigned long)conversationIndex, (unsigned long)messageIndex];
+    return @{ @"aps": @{ @"content-available": @1 },
+              @"layer": @{ @"conversation_identifier": conversationIdentifier, @"message_identifier": messageIdentifier } };
+}
+
+@interface ATLMRemoteNotificationCoalescerTest : XCTestCase
+
+@property (nonatomic) NSMutableArray *synchronizedPayloads;
+@property (nonatomic) NSMutableArray *pendingSynchronizationCompletions;
+@property (nonatomic) NSTimeInterval synchronizationDuration;
+@property (nonatomic) BOOL holdsSynchronizations;
+@property (nonatomic) ATLMRemoteNotificationCoalescer *coalescer;
+
+@end
+
+@implementation ATLMRemoteNotificationCoalescerTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.synchronizedPayloads = [NSMutableArray new];
+    self.pendingSynchronizationCompletions = [NSMutableArray new];
+    self.synchronizationDuration = 0.05;
+    self.holdsSynchronizations = NO;
+
+    __weak typeof(self) weakSelf = self;
+    self.coalescer = [ATLMRemoteNotificationCoalescer coalescerWithSynchronizationBlock:^BOOL(NSDictionary *userInfo, ATLMRemoteNotificationCompletion completion) {
+        [weakSelf.synchronizedPayloads addObject:userInfo];
+        if (weakSelf.holdsSynchronizations) {
+            [weakSelf.pendingSynchronizationCompletions addObject:completion];
+            return YES;
+        }
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(weakSelf.synchronizationDuration * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            completion(nil, nil, nil);
+        });
+        return YES;
+    }];
+    self.coalescer.coalescingWindow = 0.2;
+}
+
+- (void)tearDown
+{
+    self.coalescer = nil;
+    [super tearDown];
+}
+
+#pragma mark - Harness
+
+/**
+ @abstract Delivers `count` remote notifications to the coalescer, spaced by
+   `interval`, round-robin across `conversationCount` conversations.
+ @return The expectations fulfilled once each of the push handlers gets called.
+ */
+- (NSArray *)simulateBurstOfRemoteNotifications:(NSUInteger)count interval:(NSTimeInterval)interval conversationCount:(NSUInteger)conversationCount errors:(NSMutableArray *)errors
+{
+    NSMutableArray *expectations = [NSMutableArray new];
+    for (NSUInteger index = 0; index < count; index++) {
+        XCTestExpectation *expectation = [self expectationWithDescription:[NSString stringWithFormat:@"push %lu handled", (unsigned long)index]];
+        [expectations addObject:expectation];
+        NSDictionary *userInfo = ATLMTestRemoteNotification(index % conversationCount, index);
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(interval * index * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+            [self.coalescer enqueueRemoteNotification:userInfo completion:^(LYRConversation *conversation, LYRMessage *message, NSError *error) {
+                expect([NSThread isMainThread]).to.beTruthy();
+                if (error) {
+                    [errors addObject:error];
+                }
+                [expectation fulfill];
+            }];
+        });
+    }
+    return expectations;
+}
+
+#pragma mark - Tests
+
+- (void)testRaisesOnAttemptToInit
+{
+    expect(^{ [ATLMRemoteNotificationCoalescer new]; }).to.raise(NSInternalInconsistencyException);
+}
+
+- (void)testExtractingConversationIdentifierFromPayload
+{
+    expect(ATLMConversationIdentifierFromRemoteNotification(ATLMTestRemoteNotification(3, 1))).to.equal([NSURL URLWithString:@"layer:///conversations/3"]);
+    expect(ATLMConversationIdentifierFromRemoteNotification(@{ @"aps": @{} })).to.beNil();
+    expect(ATLMConversationIdentifierFromRemoteNotification(@{ @"layer": @"garbage" })).to.beNil();
+}
+
+- (void)testBurstFromSingleConversationIsSynchronizedOnce
+{
+    NSMutableArray *errors = [NSMutableArray new];
+    [self simulateBurstOfRemoteNotifications:50 interval:0.002 conversationCount:1 errors:errors];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    expect(self.synchronizedPayloads).to.haveCountOf(1);
+    expect(errors).to.beEmpty();
+    expect(self.coalescer.countOfSynchronizations).to.equal(1);
+    expect(self.coalescer.countOfCoalescedRemoteNotifications).to.equal(49);
+    expect(self.coalescer.countOfPendingRemoteNotifications).to.equal(0);
+
+    // The latest payload is the one that gets synchronized.
+    expect(self.synchronizedPayloads.lastObject).to.equal(ATLMTestRemoteNotification(0, 49));
+}
+
+- (void)testBurstAcrossConversationsIsSynchronizedOncePerConversation
+{
+    NSMutableArray *errors = [NSMutableArray new];
+    [self simulateBurstOfRemoteNotifications:60 interval:0.001 conversationCount:3 errors:errors];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    expect(self.synchronizedPayloads).to.haveCountOf(3);
+    expect(errors).to.beEmpty();
+}
+
+- (void)testPushesArrivingDuringSynchronizationFormTheNextBatch
+{
+    self.synchronizationDuration = 0.3;
+    NSMutableArray *errors = [NSMutableArray new];
+    // Two waves: the second one arrives while the first synchronization is still in flight.
+    [self simulateBurstOfRemoteNotifications:40 interval:0.0075 conversationCount:1 errors:errors];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    expect(self.synchronizedPayloads).to.haveCountOf(2);
+    expect(errors).to.beEmpty();
+}
+
+- (void)testAllPendingHandlersCompleteTogetherWhenBudgetRunsOut
+{
+    self.holdsSynchronizations = YES;
+    self.coalescer.backgroundTimeBudget = 0.5;
+    NSMutableArray *errors = [NSMutableArray new];
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    [self simulateBurstOfRemoteNotifications:20 interval:0.005 conversationCount:2 errors:errors];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    NSTimeInterval elapsed = CFAbsoluteTimeGetCurrent() - startTime;
+
+    expect(elapsed).to.beLessThan(1.0);
+    expect(errors).to.haveCountOf(20);
+    expect([errors.firstObject domain]).to.equal(ATLMErrorDomain);
+    expect([errors.firstObject code]).to.equal(ATLMRemoteNotificationBackgroundTimeExpired);
+    expect(self.coalescer.countOfExpiredRemoteNotifications).to.equal(20);
+    expect(self.coalescer.countOfPendingRemoteNotifications).to.equal(0);
+
+    // Late synchronization completions are ignored and don't wedge the coalescer.
+    for (ATLMRemoteNotificationCompletion completion in self.pendingSynchronizationCompletions) {
+        completion(nil, nil, nil);
+    }
+    self.holdsSynchronizations = NO;
+    [self simulateBurstOfRemoteNotifications:5 interval:0.001 conversationCount:1 errors:errors];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    expect(errors).to.haveCountOf(20);
+}
+
+- (void)testPushesForOtherConversationsDuringSynchronizationAreNotCoalesced
+{
+    self.synchronizationDuration = 0.3;
+    NSMutableArray *errors = [NSMutableArray new];
+    // Every push goes to a conversation of its own; the later ones arrive
+    // while the first synchronization is in flight.
+    [self simulateBurstOfRemoteNotifications:4 interval:0.25 conversationCount:4 errors:errors];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    expect(errors).to.beEmpty();
+    expect(self.coalescer.countOfCoalescedRemoteNotifications).to.equal(0);
+}
+
+- (void)testNextBatchWaitsForSynchronizationsAbandonedOnExpiry
+{
+    self.holdsSynchronizations = YES;
+    self.coalescer.coalescingWindow = 0.05;
+    self.coalescer.backgroundTimeBudget = 0.4;
+    NSMutableArray *errors = [NSMutableArray new];
+    [self simulateBurstOfRemoteNotifications:1 interval:0 conversationCount:1 errors:errors];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    expect(errors).to.haveCountOf(1);
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"next batch handled"];
+    [self.coalescer enqueueRemoteNotification:ATLMTestRemoteNotification(1, 0) completion:^(LYRConversation *conversation, LYRMessage *message, NSError *error) {
+        expect(error).to.beNil();
+        [expectation fulfill];
+    }];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    expect(self.synchronizedPayloads).to.haveCountOf(1);
+
+    // Once the abandoned synchronization finishes, the next batch starts.
+    self.holdsSynchronizations = NO;
+    ATLMRemoteNotificationCompletion lateCompletion = self.pendingSynchronizationCompletions.firstObject;
+    lateCompletion(nil, nil, nil);
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    expect(self.synchronizedPayloads).to.haveCountOf(2);
+    expect(self.coalescer.countOfExpiredRemoteNotifications).to.equal(1);
+}
+
+- (void)testUnhandledPayloadCompletesWithoutError
+{
+    ATLMRemoteNotificationCoalescer *coalescer = [ATLMRemoteNotificationCoalescer coalescerWithSynchronizationBlock:^BOOL(NSDictionary *userInfo, ATLMRemoteNotificationCompletion completion) {
+        return NO;
+    }];
+    coalescer.coalescingWindow = 0.01;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"handled"];
+    [coalescer enqueueRemoteNotification:@{ @"aps": @{ @"alert": @"Not for Layer" } } completion:^(LYRConversation *conversation, LYRMessage *message, NSError *error) {
+        expect(error).to.beNil();
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+}
+
+@end
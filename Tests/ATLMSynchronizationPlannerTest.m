@@ -0,0 +1,298 @@
+//
+//  ATLMSynchronizationPlannerTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMSynchronizationPlanner.h"
+
+static const NSUInteger ATLMFixedPartialHistoryMessageCount = 20;
+static const NSUInteger ATLMSimulatedMessageSize = 200;
+static const NSTimeInterval ATLMSimulatedDay = 24 * 60 * 60;
+
+/**
+ @abstract A conversation of the simulated corpus: how busy it is, how often
+   the user opens it and how far back the user reads.
+ */
+@interface ATLMSimulatedConversation : NSObject
+
+@property (nonatomic) NSURL *identifier;
+@property (nonatomic) double messagesPerDay;
+@property (nonatomic) double opensPerDay;
+@property (nonatomic) NSUInteger readingDepth;
+
+@property (nonatomic) NSUInteger totalMessageCount;
+@property (nonatomic) NSUInteger synchronizedDepth;
+@property (nonatomic) NSUInteger unreadCount;
+@property (nonatomic) NSDate *lastMessageDate;
+@property (nonatomic) NSUInteger maximumViewedDepth;
+
+@end
+
+@implementation ATLMSimulatedConversation
+
+@end
+
+/**
+ @abstract The outcome of replaying the corpus against a policy.
+ */
+typedef struct {
+    NSUInteger synchronizedMessages;
+    NSUInteger neverViewedMessages;
+    NSUInteger backfills;
+} ATLMSimulationResult;
+
+/**
+ @abstract Builds a corpus of a few busy conversations the user lives in, some
+   occasional ones and a long tail of dormant ones the user never opens.
+ */
+static NSArray *ATLMSimulatedCorpus(void)
+{
+    NSMutableArray *corpus = [NSMutableArray new];
+    for (NSUInteger index = 0; index < 200; index++) {
+        ATLMSimulatedConversation *conversation = [ATLMSimulatedConversation new];
+        conversation.identifier = [NSURL URLWithString:[NSString stringWithFormat:@"layer:///conversations/%lu", (unsigned long)index]];
+        if (index < 10) {
+            conversation.messagesPerDay = 15;
+            conversation.opensPerDay = 3;
+            conversation.readingDepth = 80;
+        } else if (index < 50) {
+            conversation.messagesPerDay = 5;
+            conversation.opensPerDay = 0.3;
+            conversation.readingDepth = 12;
+        } else {
+            conversation.messagesPerDay = 0.5;
+            conversation.opensPerDay = 0;
+            conversation.readingDepth = 0;
+        }
+        conversation.totalMessageCount = 1000;
+        [corpus addObject:conversation];
+    }
+    return corpus;
+}
+
+/**
+ @abstract Replays four weeks of traffic. With a `planner` the client starts at
+   the planner's minimum depth and follows its plan; without one every
+   conversation gets the fixed partial history window.
+ */
+static ATLMSimulationResult ATLMSimulate(NSArray *corpus, ATLMSynchronizationPlanner *planner)
+{
+    __block ATLMSimulationResult result = { 0, 0, 0 };
+    NSUInteger pageSize = planner ? planner.backfillPageSize : 25;
+    NSUInteger threshold = planner ? planner.backfillThreshold : 10;
+    NSDate *startDate = [NSDate dateWithTimeIntervalSinceReferenceDate:0];
+    void (^synchronize)(ATLMSimulatedConversation *, NSUInteger) = ^(ATLMSimulatedConversation *conversation, NSUInteger count) {
+        count = MIN(count, conversation.totalMessageCount - conversation.synchronizedDepth);
+        conversation.synchronizedDepth += count;
+        result.synchronizedMessages += count;
+        [planner recordSynchronizedMessageCount:count byteCount:count * ATLMSimulatedMessageSize forConversationWithIdentifier:conversation.identifier];
+    };
+
+    srand48(11);
+    for (ATLMSimulatedConversation *conversation in corpus) {
+        conversation.synchronizedDepth = 0;
+        conversation.maximumViewedDepth = 0;
+        conversation.unreadCount = 0;
+        conversation.lastMessageDate = [startDate dateByAddingTimeInterval:-drand48() * 30 * ATLMSimulatedDay];
+        synchronize(conversation, planner ? planner.minimumDepth : ATLMFixedPartialHistoryMessageCount);
+    }
+
+    for (NSUInteger day = 0; day < 28; day++) {
+        NSDate *date = [startDate dateByAddingTimeInterval:day * ATLMSimulatedDay];
+        for (ATLMSimulatedConversation *conversation in corpus) {
+            NSUInteger arrivals = (NSUInteger)round(conversation.messagesPerDay * 2 * drand48());
+            if (arrivals) {
+                // New messages are always synchronized, whatever the history depth.
+                conversation.totalMessageCount += arrivals;
+                conversation.unreadCount += arrivals;
+                conversation.lastMessageDate = date;
+                synchronize(conversation, arrivals);
+            }
+        }
+        // The plan is applied after each synchronization.
+        for (ATLMSimulatedConversation *conversation in corpus) {
+            NSUInteger count = [planner messageCountToSynchronizeForConversationWithIdentifier:conversation.identifier lastMessageDate:conversation.lastMessageDate unreadCount:conversation.unreadCount synchronizedDepth:conversation.synchronizedDepth date:date];
+            synchronize(conversation, count);
+        }
+        for (ATLMSimulatedConversation *conversation in corpus) {
+            NSUInteger opens = conversation.opensPerDay >= 1 ? (NSUInteger)conversation.opensPerDay : (drand48() < conversation.opensPerDay ? 1 : 0);
+            for (NSUInteger open = 0; open < opens; open++) {
+                // Opening a conversation applies its plan right away.
+                [planner recordOpenOfConversationWithIdentifier:conversation.identifier date:date];
+                synchronize(conversation, [planner messageCountToSynchronizeForConversationWithIdentifier:conversation.identifier lastMessageDate:conversation.lastMessageDate unreadCount:conversation.unreadCount synchronizedDepth:conversation.synchronizedDepth date:date]);
+                conversation.unreadCount = 0;
+                NSUInteger readingDepth = MIN(conversation.totalMessageCount, conversation.readingDepth + (NSUInteger)(drand48() * 10));
+                // Scroll up one message at a time.
+                for (NSUInteger viewedDepth = 1; viewedDepth <= readingDepth; viewedDepth++) {
+                    NSUInteger backfillCount = 0;
+                    if (planner) {
+                        backfillCount = [planner backfillCountForConversationWithIdentifier:conversation.identifier viewedDepth:viewedDepth synchronizedDepth:conversation.synchronizedDepth];
+                    } else if (viewedDepth + threshold >= conversation.synchronizedDepth && conversation.synchronizedDepth < conversation.totalMessageCount) {
+                        backfillCount = pageSize;
+                    }
+                    if (backfillCount && conversation.synchronizedDepth < conversation.totalMessageCount) {
+                        result.backfills += 1;
+                        synchronize(conversation, backfillCount);
+                    }
+                }
+                conversation.maximumViewedDepth = MAX(conversation.maximumViewedDepth, readingDepth);
+            }
+        }
+    }
+    for (ATLMSimulatedConversation *conversation in corpus) {
+        if (conversation.synchronizedDepth > conversation.maximumViewedDepth) {
+            result.neverViewedMessages += conversation.synchronizedDepth - conversation.maximumViewedDepth;
+        }
+    }
+    return result;
+}
+
+@interface ATLMSynchronizationPlannerTest : XCTestCase
+
+@property (nonatomic) ATLMSynchronizationPlanner *planner;
+@property (nonatomic) NSURL *conversationIdentifier;
+@property (nonatomic) NSDate *date;
+
+@end
+
+@implementation ATLMSynchronizationPlannerTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.planner = [ATLMSynchronizationPlanner plannerWithPersistencePath:nil];
+    self.conversationIdentifier = [NSURL URLWithString:@"layer:///conversations/1"];
+    self.date = [NSDate dateWithTimeIntervalSinceReferenceDate:0];
+}
+
+- (void)testRaisesOnAttemptToInit
+{
+    expect(^{ [ATLMSynchronizationPlanner new]; }).to.raise(NSInternalInconsistencyException);
+}
+
+- (void)testUnopenedConversationStaysAtMinimumDepth
+{
+    NSUInteger depth = [self.planner depthForConversationWithIdentifier:self.conversationIdentifier lastMessageDate:self.date unreadCount:0 date:self.date];
+    expect(depth).to.equal(ATLMSynchronizationPlannerMinimumDepth);
+}
+
+- (void)testUnreadMessagesAreAlwaysCovered
+{
+    NSUInteger depth = [self.planner depthForConversationWithIdentifier:self.conversationIdentifier lastMessageDate:self.date unreadCount:30 date:self.date];
+    expect(depth).to.equal(30 + ATLMSynchronizationPlannerMinimumDepth);
+    depth = [self.planner depthForConversationWithIdentifier:self.conversationIdentifier lastMessageDate:self.date unreadCount:1000 date:self.date];
+    expect(depth).to.equal(self.planner.maximumDepth);
+}
+
+- (void)testFrequentlyOpenedConversationGetsDeeperHistory
+{
+    for (NSUInteger open = 0; open < 10; open++) {
+        [self.planner recordOpenOfConversationWithIdentifier:self.conversationIdentifier date:self.date];
+    }
+    NSUInteger recentDepth = [self.planner depthForConversationWithIdentifier:self.conversationIdentifier lastMessageDate:self.date unreadCount:0 date:self.date];
+    expect(recentDepth).to.equal(self.planner.maximumDepth);
+
+    // A month without opens or messages lets the conversation fall back.
+    NSDate *later = [self.date dateByAddingTimeInterval:30 * ATLMSimulatedDay];
+    NSUInteger laterDepth = [self.planner depthForConversationWithIdentifier:self.conversationIdentifier lastMessageDate:self.date unreadCount:0 date:later];
+    expect(laterDepth).to.beLessThan(recentDepth / 4);
+}
+
+- (void)testTypicalReadingDepthIsLearned
+{
+    self.planner.maximumDepth = 500;
+    [self.planner recordOpenOfConversationWithIdentifier:self.conversationIdentifier date:self.date];
+    [self.planner recordViewedDepth:200 forConversationWithIdentifier:self.conversationIdentifier];
+    [self.planner recordOpenOfConversationWithIdentifier:self.conversationIdentifier date:self.date];
+    NSUInteger depth = [self.planner depthForConversationWithIdentifier:self.conversationIdentifier lastMessageDate:self.date unreadCount:0 date:self.date];
+    expect(depth).to.equal(200 * 1.25 + self.planner.backfillThreshold);
+}
+
+- (void)testMessagesAlreadyRequestedAreNotRequestedAgain
+{
+    NSUInteger count = [self.planner messageCountToSynchronizeForConversationWithIdentifier:self.conversationIdentifier lastMessageDate:self.date unreadCount:20 synchronizedDepth:5 date:self.date];
+    expect(count).to.equal(20);
+    count = [self.planner messageCountToSynchronizeForConversationWithIdentifier:self.conversationIdentifier lastMessageDate:self.date unreadCount:20 synchronizedDepth:5 date:self.date];
+    expect(count).to.equal(0);
+}
+
+- (void)testBackfillIsRequestedOncePerPageNearTheTop
+{
+    expect([self.planner backfillCountForConversationWithIdentifier:self.conversationIdentifier viewedDepth:5 synchronizedDepth:20]).to.equal(0);
+    expect([self.planner backfillCountForConversationWithIdentifier:self.conversationIdentifier viewedDepth:10 synchronizedDepth:20]).to.equal(self.planner.backfillPageSize);
+    expect([self.planner backfillCountForConversationWithIdentifier:self.conversationIdentifier viewedDepth:11 synchronizedDepth:20]).to.equal(0);
+    expect([self.planner backfillCountForConversationWithIdentifier:self.conversationIdentifier viewedDepth:36 synchronizedDepth:45]).to.equal(self.planner.backfillPageSize);
+    expect(self.planner.countOfBackfills).to.equal(2);
+}
+
+- (void)testFailedSynchronizationIsRequestedAgain
+{
+    expect([self.planner backfillCountForConversationWithIdentifier:self.conversationIdentifier viewedDepth:10 synchronizedDepth:20]).to.equal(self.planner.backfillPageSize);
+    expect([self.planner backfillCountForConversationWithIdentifier:self.conversationIdentifier viewedDepth:11 synchronizedDepth:20]).to.equal(0);
+    [self.planner recordFailedSynchronizationForConversationWithIdentifier:self.conversationIdentifier];
+    expect([self.planner backfillCountForConversationWithIdentifier:self.conversationIdentifier viewedDepth:11 synchronizedDepth:20]).to.equal(self.planner.backfillPageSize);
+}
+
+- (void)testReportsSynchronizedAndNeverViewedMessages
+{
+    [self.planner recordSynchronizedMessageCount:30 byteCount:3000 forConversationWithIdentifier:self.conversationIdentifier];
+    [self.planner recordViewedDepth:12 forConversationWithIdentifier:self.conversationIdentifier];
+    expect(self.planner.countOfSynchronizedMessages).to.equal(30);
+    expect(self.planner.countOfSynchronizedBytes).to.equal(3000);
+    expect(self.planner.countOfNeverViewedMessages).to.equal(18);
+    [self.planner removeConversationWithIdentifier:self.conversationIdentifier];
+    expect(self.planner.countOfNeverViewedMessages).to.equal(0);
+}
+
+- (void)testOpenStatisticsArePersisted
+{
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    ATLMSynchronizationPlanner *planner = [ATLMSynchronizationPlanner plannerWithPersistencePath:path];
+    for (NSUInteger open = 0; open < 10; open++) {
+        [planner recordOpenOfConversationWithIdentifier:self.conversationIdentifier date:self.date];
+    }
+    [planner persist];
+    ATLMSynchronizationPlanner *restoredPlanner = [ATLMSynchronizationPlanner plannerWithPersistencePath:path];
+    NSUInteger depth = [restoredPlanner depthForConversationWithIdentifier:self.conversationIdentifier lastMessageDate:self.date unreadCount:0 date:self.date];
+    expect(depth).to.equal(restoredPlanner.maximumDepth);
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+#pragma mark - Simulated Corpus
+
+- (void)testAdaptivePolicyOutperformsFixedWindowOnSimulatedCorpus
+{
+    ATLMSimulationResult fixed = ATLMSimulate(ATLMSimulatedCorpus(), nil);
+    ATLMSimulationResult adaptive = ATLMSimulate(ATLMSimulatedCorpus(), self.planner);
+    NSLog(@"Fixed window: %lu messages synchronized, %lu never viewed, %lu backfills", (unsigned long)fixed.synchronizedMessages, (unsigned long)fixed.neverViewedMessages, (unsigned long)fixed.backfills);
+    NSLog(@"Adaptive: %lu messages synchronized (%llu bytes), %lu never viewed, %lu backfills", (unsigned long)adaptive.synchronizedMessages, self.planner.countOfSynchronizedBytes, (unsigned long)adaptive.neverViewedMessages, (unsigned long)adaptive.backfills);
+
+    expect(adaptive.synchronizedMessages).to.beLessThan(fixed.synchronizedMessages);
+    expect(adaptive.neverViewedMessages).to.beLessThan(fixed.neverViewedMessages);
+    expect(adaptive.backfills).to.beLessThan(fixed.backfills);
+
+    // The planner's own counters agree with the simulation.
+    expect(self.planner.countOfSynchronizedMessages).to.equal(adaptive.synchronizedMessages);
+    expect(self.planner.countOfSynchronizedBytes).to.equal(adaptive.synchronizedMessages * ATLMSimulatedMessageSize);
+    expect(self.planner.countOfNeverViewedMessages).to.equal(adaptive.neverViewedMessages);
+}
+
+@end
@@ -0,0 +1,142 @@
+//
+//  ATLMTrafficGenerator.h
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+@class ATLMFakeLayerStore;
+@class ATLMLayerController;
+
+typedef NS_ENUM(NSUInteger, ATLMTrafficEventType) {
+    ATLMTrafficEventTypeInsert,             // A message is synchronized into a conversation.
+    ATLMTrafficEventTypeMetadataUpdate,     // The metadata of a conversation changes.
+    ATLMTrafficEventTypeParticipantUpdate,  // The participants of a conversation change.
+    ATLMTrafficEventTypeDelete,             // A conversation is deleted.
+    ATLMTrafficEventTypeRemoteNotification, // A push for a new message arrives.
+};
+
+typedef NS_ENUM(NSUInteger, ATLMTrafficShape) {
+    ATLMTrafficShapeSteady, // Events are evenly spaced.
+    ATLMTrafficShapeBurst,  // Events arrive `burstSize` at a time.
+    ATLMTrafficShapeRamp,   // The rate grows linearly from zero to twice `rate`.
+    ATLMTrafficShapePoisson, // Events arrive at random, `rate` per second on average.
+};
+
+/**
+ @abstract A stretch of traffic with a single rate, shape and mix of events.
+ @discussion Phases can be written as JSON dictionaries with the keys
+   `duration`, `rate`, `shape` (`steady`, `burst`, `ramp` or `poisson`),
+   `burstSize`, `batchSize` and `mix`, a dictionary of weights keyed by
+   `insert`, `metadata`, `participants`, `delete` and `push`.
+ */
+@interface ATLMTrafficPhase : NSObject
+
++ (nonnull instancetype)phaseWithDuration:(NSTimeInterval)duration rate:(double)rate shape:(ATLMTrafficShape)shape;
+
+/**
+ @abstract Creates a phase from its JSON representation.
+ @return The phase or `nil` if the dictionary is malformed.
+ */
++ (nullable instancetype)phaseWithDictionary:(nonnull NSDictionary *)dictionary;
+
+@property (nonatomic) NSTimeInterval duration;
+
+/**
+ @abstract The average number of events per second.
+ */
+@property (nonatomic) double rate;
+
+@property (nonatomic) ATLMTrafficShape shape;
+
+/**
+ @abstract The number of events arriving together in `ATLMTrafficShapeBurst`. Defaults to 50.
+ */
+@property (nonatomic) NSUInteger burstSize;
+
+/**
+ @abstract The maximum number of changes the client reports in a single
+   `layerClient:objectsDidChange:` call. Defaults to 100.
+ */
+@property (nonatomic) NSUInteger batchSize;
+
+/**
+ @abstract The relative weights of the event types, keyed by `ATLMTrafficEventType`.
+   Defaults to mostly inserts with some pushes and few of the other types.
+ */
+@property (nonnull, nonatomic, copy) NSDictionary<NSNumber *, NSNumber *> *mix;
+
+@end
+
+/**
+ @abstract A single event of a traffic timeline.
+ */
+@interface ATLMTrafficEvent : NSObject
+
+@property (nonatomic, readonly) NSTimeInterval time;
+@property (nonatomic, readonly) ATLMTrafficEventType type;
+@property (nonatomic, readonly) NSUInteger conversationIndex;
+@property (nonatomic, readonly) NSUInteger batchSize;
+
+@end
+
+/**
+ @abstract The `ATLMTrafficGenerator` synthesizes change and push traffic
+   and replays it into an `ATLMLayerController` backed by an `ATLMFakeLayerStore`.
+ @discussion Replay runs on the main run loop and is paced by a display link:
+   on every frame the events that are due are delivered, changes through
+   `layerClient:objectsDidChange:` in batches and pushes through
+   `handleRemoteNotification:responseInfo:completion:`. The report measures
+   what the user would notice: how long each frame's delivery blocked the main
+   thread, how many frames were dropped, how many due events were waiting on
+   each frame and how many pushes were waiting for their completion.
+ */
+@interface ATLMTrafficGenerator : NSObject
+
++ (nonnull instancetype)generatorWithStore:(nonnull ATLMFakeLayerStore *)store layerController:(nonnull ATLMLayerController *)layerController;
+
+/**
+ @abstract Parses a traffic script: a JSON array of phase dictionaries.
+ @return The phases or `nil` if the script is malformed.
+ */
++ (nullable NSArray<ATLMTrafficPhase *> *)phasesWithScript:(nonnull NSData *)script error:(NSError *_Nullable *_Nullable)error;
+
+/**
+ @abstract Returns the timeline of the phases, ordered by time.
+ @discussion The timeline only depends on the phases, the seed and the
+   number of conversations in the store, so it can be stored and replayed.
+ */
+- (nonnull NSArray<ATLMTrafficEvent *> *)eventsForPhases:(nonnull NSArray<ATLMTrafficPhase *> *)phases seed:(uint64_t)seed;
+
+/**
+ @abstract Replays the timeline in real time.
+ @param completion Called on the main thread with the report once all events
+   have been delivered and all pushes completed.
+ @discussion The report has the `events`, `changes` and `pushes` counters,
+   `frames` and `droppedFrames`, and the `blocking` (per frame, in
+   microseconds), `queueDepth` and `pendingPushes` histograms in the format
+   of `ATLMInstrumentation`.
+ */
+- (void)replayEvents:(nonnull NSArray<ATLMTrafficEvent *> *)events completion:(nonnull void (^)(NSDictionary *_Nonnull report))completion;
+
+/**
+ @abstract `YES` while a replay is running.
+ */
+@property (nonatomic, readonly, getter=isReplaying) BOOL replaying;
+
+@end
@@ -0,0 +1,417 @@
+//
+//  ATLMTrafficGenerator.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "ATLMTrafficGenerator.h"
+#import "ATLMFakeLayerStore.h"
+#import "ATLMInstrumentation.h"
+#import "ATLMLayerController.h"
+#import <QuartzCore/QuartzCore.h>
+
+static NSString *const ATLMTrafficErrorDomain = @"com.layer.Atlas-Messenger.Traffic";
+
+static NSString *const ATLMTrafficBlockingMetric = @"blocking";
+static NSString *const ATLMTrafficQueueDepthMetric = @"queueDepth";
+static NSString *const ATLMTrafficPendingPushesMetric = @"pendingPushes";
+static NSString *const ATLMTrafficEventsCounter = @"events";
+static NSString *const ATLMTrafficChangesCounter = @"changes";
+static NSString *const ATLMTrafficPushesCounter = @"pushes";
+static NSString *const ATLMTrafficFramesCounter = @"frames";
+static NSString *const ATLMTrafficDroppedFramesCounter = @"droppedFrames";
+
+static NSDictionary *ATLMTrafficEventTypesByName(void)
+{
+    return @{ @"insert": @(ATLMTrafficEventTypeInsert),
+              @"metadata": @(ATLMTrafficEventTypeMetadataUpdate),
+              @"participants": @(ATLMTrafficEventTypeParticipantUpdate),
+              @"delete": @(ATLMTrafficEventTypeDelete),
+              @"push": @(ATLMTrafficEventTypeRemoteNotification) };
+}
+
+static NSDictionary *ATLMTrafficShapesByName(void)
+{
+    return @{ @"steady": @(ATLMTrafficShapeSteady),
+              @"burst": @(ATLMTrafficShapeBurst),
+              @"ramp": @(ATLMTrafficShapeRamp),
+              @"poisson": @(ATLMTrafficShapePoisson) };
+}
+
+/**
+ @abstract A splitmix64 generator, so that timelines are the same on every platform.
+ */
+static uint64_t ATLMTrafficNextRandom(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double ATLMTrafficRandomFraction(uint64_t *state)
+{
+    return (ATLMTrafficNextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+#pragma mark - Phases
+
+@implementation ATLMTrafficPhase
+
++ (instancetype)phaseWithDuration:(NSTimeInterval)duration rate:(double)rate shape:(ATLMTrafficShape)shape
+{
+    ATLMTrafficPhase *phase = [self new];
+    phase.duration = duration;
+    phase.rate = rate;
+    phase.shape = shape;
+    return phase;
+}
+
++ (instancetype)phaseWithDictionary:(NSDictionary *)dictionary
+{
+    NSNumber *duration = dictionary[@"duration"];
+    NSNumber *rate = dictionary[@"rate"];
+    if (![duration isKindOfClass:[NSNumber class]] || ![rate isKindOfClass:[NSNumber class]] || duration.doubleValue <= 0 || rate.doubleValue < 0) {
+        return nil;
+    }
+    NSNumber *shape = dictionary[@"shape"] ? ATLMTrafficShapesByName()[dictionary[@"shape"]] : @(ATLMTrafficShapeSteady);
+    if (!shape) {
+        return nil;
+    }
+    ATLMTrafficPhase *phase = [self phaseWithDuration:duration.doubleValue rate:rate.doubleValue shape:shape.unsignedIntegerValue];
+    if ([dictionary[@"burstSize"] isKindOfClass:[NSNumber class]]) {
+        phase.burstSize = MAX([dictionary[@"burstSize"] unsignedIntegerValue], 1);
+    }
+    if ([dictionary[@"batchSize"] isKindOfClass:[NSNumber class]]) {
+        phase.batchSize = MAX([dictionary[@"batchSize"] unsignedIntegerValue], 1);
+    }
+    NSDictionary *mixByName = dictionary[@"mix"];
+    if (mixByName) {
+        if (![mixByName isKindOfClass:[NSDictionary class]]) {
+            return nil;
+        }
+        NSMutableDictionary *mix = [NSMutableDictionary new];
+        for (NSString *name in mixByName) {
+            NSNumber *type = ATLMTrafficEventTypesByName()[name];
+            if (!type || ![mixByName[name] isKindOfClass:[NSNumber class]]) {
+                return nil;
+            }
+            mix[type] = mixByName[name];
+        }
+        phase.mix = mix;
+    }
+    return phase;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self) {
+        _burstSize = 50;
+        _batchSize = 100;
+        _mix = @{ @(ATLMTrafficEventTypeInsert): @70,
+                  @(ATLMTrafficEventTypeRemoteNotification): @20,
+                  @(ATLMTrafficEventTypeMetadataUpdate): @6,
+                  @(ATLMTrafficEventTypeParticipantUpdate): @3,
+                  @(ATLMTrafficEventTypeDelete): @1 };
+    }
+    return self;
+}
+
+/**
+ @abstract Returns the offsets of the phase's events from its start.
+ */
+- (NSArray *)eventTimesWithState:(uint64_t *)state
+{
+    NSMutableArray *times = [NSMutableArray new];
+    NSUInteger count = (NSUInteger)llround(self.duration * self.rate);
+    if (count == 0) {
+        return times;
+    }
+    switch (self.shape) {
+        case ATLMTrafficShapeSteady:
+            for (NSUInteger index = 0; index < count; index++) {
+                [times addObject:@(index / self.rate)];
+            }
+            break;
+        case ATLMTrafficShapeBurst: {
+            NSTimeInterval burstInterval = self.burstSize / self.rate;
+            for (NSUInteger index = 0; index < count; index++) {
+                [times addObject:@((index / self.burstSize) * burstInterval)];
+            }
+            break;
+        }
+        case ATLMTrafficShapeRamp:
+            // The rate grows as 2 * rate * t / duration, so the k-th event
+            // arrives when rate * t^2 / duration reaches k.
+            for (NSUInteger index = 0; index < count; index++) {
+                [times addObject:@(sqrt(index * self.duration / self.rate))];
+            }
+            break;
+        case ATLMTrafficShapePoisson: {
+            NSTimeInterval time = 0;
+            while (YES) {
+                time += -log(1 - ATLMTrafficRandomFraction(state)) / self.rate;
+                if (time >= self.duration) {
+                    break;
+                }
+                [times addObject:@(time)];
+            }
+            break;
+        }
+    }
+    return times;
+}
+
+- (ATLMTrafficEventType)eventTypeWithState:(uint64_t *)state
+{
+    double totalWeight = 0;
+    for (NSNumber *type in self.mix) {
+        totalWeight += [self.mix[type] doubleValue];
+    }
+    double draw = ATLMTrafficRandomFraction(state) * totalWeight;
+    NSArray *types = [self.mix.allKeys sortedArrayUsingSelector:@selector(compare:)];
+    for (NSNumber *type in types) {
+        draw -= [self.mix[type] doubleValue];
+        if (draw < 0) {
+            return type.unsignedIntegerValue;
+        }
+    }
+    return [types.lastObject unsignedIntegerValue];
+}
+
+@end
+
+#pragma mark - Events
+
+@interface ATLMTrafficEvent ()
+
+@property (nonatomic, readwrite) NSTimeInterval time;
+@property (nonatomic, readwrite) ATLMTrafficEventType type;
+@property (nonatomic, readwrite) NSUInteger conversationIndex;
+@property (nonatomic, readwrite) NSUInteger batchSize;
+
+@end
+
+@implementation ATLMTrafficEvent
+
+@end
+
+#pragma mark - Generator
+
+@interface ATLMTrafficGenerator ()
+
+@property (nonnull, nonatomic) ATLMFakeLayerStore *store;
+@property (nonnull, nonatomic) ATLMLayerController *layerController;
+@property (nonatomic, readwrite, getter=isReplaying) BOOL replaying;
+@property (nonatomic) NSArray *events;
+@property (nonatomic) NSUInteger nextEventIndex;
+@property (nonatomic) NSUInteger pendingPushCount;
+@property (nonatomic) CFTimeInterval startTime;
+@property (nonatomic) CFTimeInterval lastFrameTimestamp;
+@property (nonatomic) CADisplayLink *displayLink;
+@property (nonatomic) ATLMInstrumentation *instrumentation;
+@property (nonatomic, copy) void (^completion)(NSDictionary *report);
+
+@end
+
+@implementation ATLMTrafficGenerator
+
++ (instancetype)generatorWithStore:(ATLMFakeLayerStore *)store layerController:(ATLMLayerController *)layerController
+{
+    return [[self alloc] initWithStore:store layerController:layerController];
+}
+
+- (id)initWithStore:(ATLMFakeLayerStore *)store layerController:(ATLMLayerController *)layerController
+{
+    self = [super init];
+    if (self) {
+        _store = store;
+        _layerController = layerController;
+    }
+    return self;
+}
+
+- (id)init
+{
+    @throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Failed to call the designated initializer. Use generatorWithStore:layerController:" userInfo:nil];
+}
+
++ (NSArray *)phasesWithScript:(NSData *)script error:(NSError **)error
+{
+    NSArray *phaseDictionaries = [NSJSONSerialization JSONObjectWithData:script options:0 error:error];
+    if (!phaseDictionaries) {
+        return nil;
+    }
+    NSMutableArray *phases = [NSMutableArray new];
+    if ([phaseDictionaries isKindOfClass:[NSArray class]]) {
+        for (NSDictionary *phaseDictionary in phaseDictionaries) {
+            ATLMTrafficPhase *phase = [phaseDictionary isKindOfClass:[NSDictionary class]] ? [ATLMTrafficPhase phaseWithDictionary:phaseDictionary] : nil;
+            if (!phase) {
+                break;
+            }
+            [phases addObject:phase];
+        }
+    }
+    if (![phaseDictionaries isKindOfClass:[NSArray class]] || phases.count != phaseDictionaries.count) {
+        if (error) {
+            *error = [NSError errorWithDomain:ATLMTrafficErrorDomain code:1 userInfo:@{ NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Malformed traffic phase %lu.", (unsigned long)phases.count] }];
+        }
+        return nil;
+    }
+    return phases;
+}
+
+#pragma mark - Synthesis
+
+- (NSArray *)eventsForPhases:(NSArray *)phases seed:(uint64_t)seed
+{
+    uint64_t state = seed;
+    NSUInteger conversationCount = self.store.conversations.count;
+    NSMutableArray *events = [NSMutableArray new];
+    NSTimeInterval phaseStart = 0;
+    for (ATLMTrafficPhase *phase in phases) {
+        for (NSNumber *time in [phase eventTimesWithState:&state]) {
+            ATLMTrafficEvent *event = [ATLMTrafficEvent new];
+            event.time = phaseStart + time.doubleValue;
+            event.type = [phase eventTypeWithState:&state];
+            // Traffic concentrates on the most active conversations.
+            event.conversationIndex = (NSUInteger)(conversationCount * pow(ATLMTrafficRandomFraction(&state), 3));
+            event.batchSize = phase.batchSize;
+            [events addObject:event];
+        }
+        phaseStart += phase.duration;
+    }
+    [events sortWithOptions:NSSortStable usingComparator:^NSComparisonResult(ATLMTrafficEvent *event, ATLMTrafficEvent *otherEvent) {
+        return event.time < otherEvent.time ? NSOrderedAscending : (event.time > otherEvent.time ? NSOrderedDescending : NSOrderedSame);
+    }];
+    return events;
+}
+
+#pragma mark - Replay
+
+- (void)replayEvents:(NSArray *)events completion:(void (^)(NSDictionary *report))completion
+{
+    NSAssert([NSThread isMainThread], @"Traffic must be replayed on the main thread");
+    NSAssert(!self.replaying, @"A replay is already running");
+    self.replaying = YES;
+    self.events = events;
+    self.nextEventIndex = 0;
+    self.pendingPushCount = 0;
+    self.completion = completion;
+    self.instrumentation = [ATLMInstrumentation instrumentation];
+    self.startTime = CACurrentMediaTime();
+    self.lastFrameTimestamp = 0;
+    self.displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(displayLinkDidFire:)];
+    [self.displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+}
+
+- (void)displayLinkDidFire:(CADisplayLink *)displayLink
+{
+    [self.instrumentation incrementCounter:ATLMTrafficFramesCounter by:1];
+    if (self.lastFrameTimestamp) {
+        CFTimeInterval frameDuration = displayLink.duration;
+        CFTimeInterval elapsed = displayLink.timestamp - self.lastFrameTimestamp;
+        if (frameDuration > 0 && elapsed > 1.5 * frameDuration) {
+            [self.instrumentation incrementCounter:ATLMTrafficDroppedFramesCounter by:lround(elapsed / frameDuration) - 1];
+        }
+    }
+    self.lastFrameTimestamp = displayLink.timestamp;
+
+    NSTimeInterval now = CACurrentMediaTime() - self.startTime;
+    NSUInteger firstEventIndex = self.nextEventIndex;
+    while (self.nextEventIndex < self.events.count && [self.events[self.nextEventIndex] time] <= now) {
+        self.nextEventIndex += 1;
+    }
+    NSRange dueRange = NSMakeRange(firstEventIndex, self.nextEventIndex - firstEventIndex);
+    [self.instrumentation recordValue:dueRange.length forHistogram:ATLMTrafficQueueDepthMetric];
+
+    uint64_t start = [self.instrumentation beginInterval:ATLMTrafficBlockingMetric];
+    [self deliverEvents:[self.events subarrayWithRange:dueRange]];
+    [self.instrumentation endInterval:ATLMTrafficBlockingMetric start:start];
+    [self.instrumentation recordValue:self.pendingPushCount forHistogram:ATLMTrafficPendingPushesMetric];
+
+    if (self.nextEventIndex == self.events.count) {
+        [self.displayLink invalidate];
+        self.displayLink = nil;
+        [self finishIfNeeded];
+    }
+}
+
+- (void)deliverEvents:(NSArray *)events
+{
+    LYRClient *client = (LYRClient *)self.store;
+    NSArray *conversations = self.store.conversations;
+    NSMutableArray *changes = [NSMutableArray new];
+    for (ATLMTrafficEvent *event in events) {
+        [self.instrumentation incrementCounter:ATLMTrafficEventsCounter by:1];
+        LYRConversation *conversation = conversations[MIN(event.conversationIndex, conversations.count - 1)];
+        switch (event.type) {
+            case ATLMTrafficEventTypeInsert: {
+                LYRMessage *message = [self.store newMessageInConversation:conversation];
+                [changes addObject:[self.store changeWithType:LYRObjectChangeTypeCreate object:message property:nil]];
+                [changes addObject:[self.store changeWithType:LYRObjectChangeTypeUpdate object:conversation property:@"lastMessage"]];
+                break;
+            }
+            case ATLMTrafficEventTypeMetadataUpdate:
+                [changes addObject:[self.store changeWithType:LYRObjectChangeTypeUpdate object:conversation property:@"metadata"]];
+                break;
+            case ATLMTrafficEventTypeParticipantUpdate:
+                [changes addObject:[self.store changeWithType:LYRObjectChangeTypeUpdate object:conversation property:@"participants"]];
+                break;
+            case ATLMTrafficEventTypeDelete:
+                [changes addObject:[self.store changeWithType:LYRObjectChangeTypeDelete object:conversation property:nil]];
+                break;
+            case ATLMTrafficEventTypeRemoteNotification: {
+                NSDictionary *userInfo = [self.store remoteNotificationForMessage:[self.store newMessageInConversation:conversation]];
+                [self.instrumentation incrementCounter:ATLMTrafficPushesCounter by:1];
+                self.pendingPushCount += 1;
+                __weak typeof(self) weakSelf = self;
+                [self.layerController handleRemoteNotification:userInfo responseInfo:nil completion:^(BOOL success, NSError *error) {
+                    weakSelf.pendingPushCount -= 1;
+                    [weakSelf finishIfNeeded];
+                }];
+                break;
+            }
+        }
+        if (changes.count >= event.batchSize) {
+            [self.instrumentation incrementCounter:ATLMTrafficChangesCounter by:changes.count];
+            [self.layerController layerClient:client objectsDidChange:changes];
+            changes = [NSMutableArray new];
+        }
+    }
+    if (changes.count) {
+        [self.instrumentation incrementCounter:ATLMTrafficChangesCounter by:changes.count];
+        [self.layerController layerClient:client objectsDidChange:changes];
+    }
+}
+
+- (void)finishIfNeeded
+{
+    if (!self.replaying || self.displayLink || self.pendingPushCount) {
+        return;
+    }
+    self.replaying = NO;
+    NSMutableDictionary *report = [[self.instrumentation snapshot] mutableCopy];
+    report[@"duration"] = @(CACurrentMediaTime() - self.startTime);
+    void (^completion)(NSDictionary *) = self.completion;
+    self.completion = nil;
+    self.events = nil;
+    completion(report);
+}
+
+@end
@@ -0,0 +1,174 @@
+//
+//  ATLMTrafficGeneratorTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMTrafficGenerator.h"
+#import "ATLMFakeLayerStore.h"
+#import "ATLMInstrumentation.h"
+#import "ATLMLayerController.h"
+
+/**
+ @abstract `ATLM_TRAFFIC_SCRIPT` is the path of a traffic script to replay
+   instead of the built-in one, `ATLM_TRAFFIC_REPORT` the path the report is
+   written to, `NSTemporaryDirectory()/ATLMTrafficReport.json` by default.
+ */
+static NSString *const ATLMTrafficScriptPathVariable = @"ATLM_TRAFFIC_SCRIPT";
+static NSString *const ATLMTrafficReportPathVariable = @"ATLM_TRAFFIC_REPORT";
+
+@interface ATLMTrafficGeneratorTest : XCTestCase
+
+@property (nonatomic) ATLMFakeLayerStore *store;
+@property (nonatomic) ATLMLayerController *layerController;
+@property (nonatomic) ATLMTrafficGenerator *generator;
+
+@end
+
+@implementation ATLMTrafficGeneratorTest
+
+- (void)setUp
+{
+    [super setUp];
+    ATLMFakeLayerStoreCorpus corpus = ATLMFakeLayerStoreDefaultCorpus;
+    corpus.conversationCount = 1000;
+    corpus.messagesPerConversation = 5;
+    corpus.identityCount = 2000;
+    self.store = [ATLMFakeLayerStore storeWithCorpus:corpus];
+    self.layerController = [self.store newLayerController];
+    self.generator = [ATLMTrafficGenerator generatorWithStore:self.store layerController:self.layerController];
+}
+
+- (void)tearDown
+{
+    self.generator = nil;
+    self.layerController = nil;
+    [self.store removeAccountData];
+    self.store = nil;
+    [super tearDown];
+}
+
+#pragma mark - Synthesis
+
+- (void)testTimelineIsDeterministic
+{
+    NSArray *phases = @[ [ATLMTrafficPhase phaseWithDuration:2 rate:100 shape:ATLMTrafficShapePoisson] ];
+    NSArray *events = [self.generator eventsForPhases:phases seed:7];
+    NSArray *otherEvents = [self.generator eventsForPhases:phases seed:7];
+    expect([events valueForKey:@"time"]).to.equal([otherEvents valueForKey:@"time"]);
+    expect([events valueForKey:@"type"]).to.equal([otherEvents valueForKey:@"type"]);
+    expect([events valueForKey:@"conversationIndex"]).to.equal([otherEvents valueForKey:@"conversationIndex"]);
+}
+
+- (void)testShapesSpreadTheEvents
+{
+    NSArray *steady = [self.generator eventsForPhases:@[ [ATLMTrafficPhase phaseWithDuration:10 rate:100 shape:ATLMTrafficShapeSteady] ] seed:1];
+    expect(steady.count).to.equal(1000);
+    expect([steady[1] time] - [steady[0] time]).to.beCloseToWithin(0.01, 0.0001);
+
+    ATLMTrafficPhase *burstPhase = [ATLMTrafficPhase phaseWithDuration:10 rate:100 shape:ATLMTrafficShapeBurst];
+    burstPhase.burstSize = 200;
+    NSArray *bursts = [self.generator eventsForPhases:@[ burstPhase ] seed:1];
+    expect([[NSSet setWithArray:[bursts valueForKey:@"time"]] count]).to.equal(5);
+
+    NSArray *ramp = [self.generator eventsForPhases:@[ [ATLMTrafficPhase phaseWithDuration:10 rate:100 shape:ATLMTrafficShapeRamp] ] seed:1];
+    NSUInteger firstHalfCount = [[ramp filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"time < 5"]] count];
+    expect(firstHalfCount).to.equal(250);
+}
+
+- (void)testPhasesFollowEachOther
+{
+    NSArray *phases = @[ [ATLMTrafficPhase phaseWithDuration:1 rate:10 shape:ATLMTrafficShapeSteady], [ATLMTrafficPhase phaseWithDuration:1 rate:10 shape:ATLMTrafficShapeSteady] ];
+    NSArray *events = [self.generator eventsForPhases:phases seed:1];
+    expect(events.count).to.equal(20);
+    expect([events[10] time]).to.beCloseToWithin(1, 0.0001);
+}
+
+- (void)testMixIsHonored
+{
+    ATLMTrafficPhase *phase = [ATLMTrafficPhase phaseWithDuration:1 rate:100 shape:ATLMTrafficShapeSteady];
+    phase.mix = @{ @(ATLMTrafficEventTypeDelete): @1 };
+    NSArray *events = [self.generator eventsForPhases:@[ phase ] seed:1];
+    expect([[NSSet setWithArray:[events valueForKey:@"type"]] allObjects]).to.equal(@[ @(ATLMTrafficEventTypeDelete) ]);
+}
+
+- (void)testScriptsAreParsed
+{
+    NSData *script = [@"[{\"duration\": 2, \"rate\": 50, \"shape\": \"burst\", \"burstSize\": 10, \"batchSize\": 20, \"mix\": {\"insert\": 3, \"push\": 1}}]" dataUsingEncoding:NSUTF8StringEncoding];
+    NSError *error;
+    NSArray *phases = [ATLMTrafficGenerator phasesWithScript:script error:&error];
+    expect(error).to.beNil();
+    expect(phases).to.haveCountOf(1);
+    ATLMTrafficPhase *phase = phases.firstObject;
+    expect(phase.shape).to.equal(ATLMTrafficShapeBurst);
+    expect(phase.burstSize).to.equal(10);
+    expect(phase.batchSize).to.equal(20);
+    expect(phase.mix).to.equal((@{ @(ATLMTrafficEventTypeInsert): @3, @(ATLMTrafficEventTypeRemoteNotification): @1 }));
+
+    NSData *malformedScript = [@"[{\"duration\": 2, \"rate\": 50, \"shape\": \"sawtooth\"}]" dataUsingEncoding:NSUTF8StringEncoding];
+    expect([ATLMTrafficGenerator phasesWithScript:malformedScript error:&error]).to.beNil();
+    expect(error).notTo.beNil();
+}
+
+#pragma mark - Replay
+
+/**
+ @abstract Replays the traffic of a large tenant: steady traffic, a burst of
+   pushes and changes after a reconnect, then traffic ramping up to twice the
+   steady rate.
+ */
+- (void)testLargeTenantTrafficReplay
+{
+    NSArray *phases;
+    NSString *scriptPath = [NSProcessInfo processInfo].environment[ATLMTrafficScriptPathVariable];
+    if (scriptPath) {
+        NSError *error;
+        phases = [ATLMTrafficGenerator phasesWithScript:[NSData dataWithContentsOfFile:scriptPath] error:&error];
+        expect(error).to.beNil();
+    } else {
+        ATLMTrafficPhase *burstPhase = [ATLMTrafficPhase phaseWithDuration:1 rate:2000 shape:ATLMTrafficShapeBurst];
+        burstPhase.burstSize = 500;
+        phases = @[ [ATLMTrafficPhase phaseWithDuration:2 rate:200 shape:ATLMTrafficShapePoisson],
+                    burstPhase,
+                    [ATLMTrafficPhase phaseWithDuration:2 rate:500 shape:ATLMTrafficShapeRamp] ];
+    }
+    NSArray *events = [self.generator eventsForPhases:phases seed:ATLMFakeLayerStoreDefaultCorpus.seed];
+    NSTimeInterval timelineDuration = [[phases valueForKeyPath:@"@sum.duration"] doubleValue];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Traffic replayed"];
+    __block NSDictionary *report;
+    [self.generator replayEvents:events completion:^(NSDictionary *replayReport) {
+        report = replayReport;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:timelineDuration + 30 handler:nil];
+
+    NSString *path = [NSProcessInfo processInfo].environment[ATLMTrafficReportPathVariable] ?: [NSTemporaryDirectory() stringByAppendingPathComponent:@"ATLMTrafficReport.json"];
+    [[NSJSONSerialization dataWithJSONObject:report options:NSJSONWritingPrettyPrinted error:nil] writeToFile:path atomically:YES];
+    NSDictionary *blocking = report[@"histograms"][@"blocking"];
+    NSLog(@"Replayed %@ events in %.1fs: %@ of %@ frames dropped, main thread blocked p50 %.0f us, p99 %.0f us, max %.0f us; report written to %@",
+          report[@"counters"][@"events"], [report[@"duration"] doubleValue], report[@"counters"][@"droppedFrames"] ?: @0, report[@"counters"][@"frames"],
+          [blocking[ATLMMetricP50Key] doubleValue], [blocking[ATLMMetricP99Key] doubleValue], [blocking[ATLMMetricMaxKey] doubleValue], path);
+
+    expect(report[@"counters"][@"events"]).to.equal(events.count);
+    expect(self.generator.replaying).to.beFalsy();
+}
+
+@end
@@ -0,0 +1,129 @@
+//
+//  ATLMUIWorkSchedulerTest.m
+//  Atlas Messenger
+//
+//  Created by Layer, Inc. on 10/19/26.
+//  Copyright (c) 2026 Layer, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#define EXP_SHORTHAND
+#import <Expecta/Expecta.h>
+#import "ATLMUIWorkScheduler.h"
+
+static NSString *const ATLMTestDeferralReason = @"test";
+
+@interface ATLMUIWorkSchedulerTest : XCTestCase
+
+@property (nonatomic) ATLMUIWorkScheduler *scheduler;
+@property (nonatomic) NSMutableArray *log;
+
+@end
+
+@implementation ATLMUIWorkSchedulerTest
+
+- (void)setUp
+{
+    [super setUp];
+    self.scheduler = [ATLMUIWorkScheduler scheduler];
+    self.log = [NSMutableArray new];
+}
+
+- (void)tearDown
+{
+    self.scheduler = nil;
+    [super tearDown];
+}
+
+- (void)scheduleLogEntry:(NSString *)entry priority:(ATLMUIWorkPriority)priority coalescingKey:(id<NSCopying>)coalescingKey
+{
+    NSMutableArray *log = self.log;
+    [self.scheduler scheduleWorkWithPriority:priority coalescingKey:coalescingKey block:^{
+        [log addObject:entry];
+    }];
+}
+
+- (void)waitForPendingWork
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Work drained"];
+    [self.scheduler scheduleWorkWithPriority:ATLMUIWorkPriorityLow coalescingKey:nil block:^{
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+- (void)testWorkRunsByPriorityThenInOrder
+{
+    [self scheduleLogEntry:@"low" priority:ATLMUIWorkPriorityLow coalescingKey:nil];
+    [self scheduleLogEntry:@"default 1" priority:ATLMUIWorkPriorityDefault coalescingKey:nil];
+    [self scheduleLogEntry:@"high" priority:ATLMUIWorkPriorityHigh coalescingKey:nil];
+    [self scheduleLogEntry:@"default 2" priority:ATLMUIWorkPriorityDefault coalescingKey:nil];
+    expect(self.log).to.equal(@[]);
+    [self waitForPendingWork];
+    expect(self.log).to.equal(@[ @"high", @"default 1", @"default 2", @"low" ]);
+    expect(self.scheduler.countOfPendingWork).to.equal(0);
+}
+
+- (void)testWorkWithTheSameKeyIsCoalesced
+{
+    [self scheduleLogEntry:@"refresh 1" priority:ATLMUIWorkPriorityLow coalescingKey:@"conversation"];
+    [self scheduleLogEntry:@"other" priority:ATLMUIWorkPriorityDefault coalescingKey:@"other"];
+    [self scheduleLogEntry:@"refresh 2" priority:ATLMUIWorkPriorityLow coalescingKey:@"conversation"];
+    [self scheduleLogEntry:@"refresh 3" priority:ATLMUIWorkPriorityHigh coalescingKey:@"conversation"];
+    expect(self.scheduler.countOfPendingWork).to.equal(2);
+    expect(self.scheduler.countOfCoalescedWork).to.equal(2);
+    [self waitForPendingWork];
+    expect(self.log).to.equal(@[ @"refresh 3", @"other" ]);
+
+    [self scheduleLogEntry:@"canceled" priority:ATLMUIWorkPriorityDefault coalescingKey:@"conversation"];
+    [self.scheduler cancelWorkWithCoalescingKey:@"conversation"];
+    [self waitForPendingWork];
+    expect(self.log).notTo.contain(@"canceled");
+}
+
+- (void)testWorkIsDeferredUntilDeferralEnds
+{
+    [self.scheduler beginDeferringForReason:ATLMTestDeferralReason];
+    [self.scheduler beginDeferringForReason:ATLMTestDeferralReason];
+    [self scheduleLogEntry:@"deferred" priority:ATLMUIWorkPriorityHigh coalescingKey:nil];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    expect(self.scheduler.isDeferring).to.beTruthy();
+    expect(self.log).to.equal(@[]);
+
+    [self.scheduler endDeferringForReason:ATLMTestDeferralReason];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    expect(self.log).to.equal(@[]);
+
+    [self.scheduler endDeferringForReason:ATLMTestDeferralReason];
+    expect(self.scheduler.isDeferring).to.beFalsy();
+    [self waitForPendingWork];
+    expect(self.log).to.equal(@[ @"deferred" ]);
+}
+
+- (void)testWorkIsSpreadOverFrames
+{
+    NSUInteger itemCount = 40;
+    self.scheduler.frameBudget = 0.004;
+    for (NSUInteger index = 0; index < itemCount; index++) {
+        [self.scheduler scheduleWorkWithPriority:ATLMUIWorkPriorityDefault coalescingKey:nil block:^{
+            usleep(2000);
+        }];
+    }
+    [self waitForPendingWork];
+    // Each frame runs work until the 4ms budget is used up, two or three 2ms items.
+    expect(self.scheduler.countOfDrainingFrames).to.beGreaterThanOrEqualTo(itemCount / 3);
+}
+
+@end